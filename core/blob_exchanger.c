@@ -330,9 +330,9 @@ int blob_exchanger_start_exchange(blob_exchanger_t* ex,
     }
     else // local copy
     {
-      size_t p1 = int_lsearch(ex->send_proc_offsets->data,
-                              ex->send_proc_offsets->size, ex->rank) -
-                  ex->send_proc_offsets->data;
+      size_t p1 = int_lsearch(ex->send_procs->data,
+                              ex->send_procs->size, ex->rank) -
+                  ex->send_procs->data;
       size_t send_size = size_factor *
                          (ex->send_proc_offsets->data[p1+1] -
                           ex->send_proc_offsets->data[p1]);
@@ -706,6 +706,36 @@ bool blob_exchanger_copy_out(blob_exchanger_t* ex,
     return false;
 }
 
+void* blob_exchanger_send_blob_storage(blob_exchanger_t* ex,
+                                       int blob_index,
+                                       blob_buffer_t* buffer)
+{
+  ASSERT(buffer->ex == ex);
+  int* offset_p = int_int_unordered_map_get(ex->send_blob_offsets, blob_index);
+  if (offset_p != NULL)
+  {
+    size_t offset = buffer->size_factor * (*offset_p);
+    return &(((char*)buffer->storage)[offset]);
+  }
+  else
+    return NULL;
+}
+
+void* blob_exchanger_receive_blob_storage(blob_exchanger_t* ex,
+                                          blob_buffer_t* buffer,
+                                          int blob_index)
+{
+  ASSERT(buffer->ex == ex);
+  int* offset_p = int_int_unordered_map_get(ex->recv_blob_offsets, blob_index);
+  if (offset_p != NULL)
+  {
+    size_t offset = buffer->size_factor * (*offset_p);
+    return &(((char*)buffer->storage)[offset]);
+  }
+  else
+    return NULL;
+}
+
 bool blob_exchanger_is_valid(blob_exchanger_t* ex, char** reason)
 {
 #if POLYMEC_HAVE_MPI
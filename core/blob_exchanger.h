@@ -198,6 +198,32 @@ bool blob_exchanger_copy_out(blob_exchanger_t* ex,
                              int blob_index,
                              void* blob);
 
+/// Returns a pointer to the storage within the given blob buffer for the
+/// blob with the given index to be sent to other processes. Use this to
+/// write blob data directly into the buffer instead of copying it in with
+/// \ref blob_exchanger_copy_in.
+/// \param [in] blob_index The index of the blob to be sent.
+/// \param [in] buffer The blob buffer that stores the data.
+/// \returns a pointer to the blob's storage, or NULL if the exchanger sends
+///          no blob with the given index.
+/// \memberof blob_exchanger
+void* blob_exchanger_send_blob_storage(blob_exchanger_t* ex,
+                                       int blob_index,
+                                       blob_buffer_t* buffer);
+
+/// Returns a pointer to the storage within the given blob buffer for the
+/// blob with the given index received from other processes. Use this to
+/// read blob data directly from the buffer instead of copying it out with
+/// \ref blob_exchanger_copy_out.
+/// \param [in] buffer The blob buffer holding the blob data.
+/// \param [in] blob_index The index of the received blob.
+/// \returns a pointer to the blob's storage, or NULL if the exchanger
+///          receives no blob with the given index.
+/// \memberof blob_exchanger
+void* blob_exchanger_receive_blob_storage(blob_exchanger_t* ex,
+                                          blob_buffer_t* buffer,
+                                          int blob_index);
+
 /// Returns true if the blob exchanger is internally consist, false if not.
 /// This function is expensive and involves parallel communication. It must be
 /// called by all processes on the communicator for the exchanger.
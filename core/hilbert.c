@@ -29,16 +29,9 @@ hilbert_t* hilbert_new(bbox_t* bbox)
   return curve;
 }
 
-index_t hilbert_index(hilbert_t* curve, point_t* x)
+// Computes the Hilbert index for the given discrete coordinates.
+static index_t discrete_hilbert_index(uint16_t X[3])
 {
-  ASSERT(bbox_contains(&curve->bbox, x));
-
-  // Create integer coordinates corresponding to x.
-  uint16_t X[3];
-  X[0] = (!reals_equal(curve->dx, 0.0)) ? (uint16_t)((x->x - curve->bbox.x1)/curve->dx) : 0;
-  X[1] = (!reals_equal(curve->dy, 0.0)) ? (uint16_t)((x->y - curve->bbox.y1)/curve->dy) : 0;
-  X[2] = (!reals_equal(curve->dz, 0.0)) ? (uint16_t)((x->z - curve->bbox.z1)/curve->dz) : 0;
-
   // Compute the Hilbert "transpose" (X[0], X[1], X[2]) corresponding to these
   // discrete coordinates.
 
@@ -86,6 +79,27 @@ index_t hilbert_index(hilbert_t* curve, point_t* x)
   return index;
 }
 
+index_t hilbert_index(hilbert_t* curve, point_t* x)
+{
+  ASSERT(bbox_contains(&curve->bbox, x));
+
+  // Create integer coordinates corresponding to x.
+  uint16_t X[3];
+  X[0] = (!reals_equal(curve->dx, 0.0)) ? (uint16_t)((x->x - curve->bbox.x1)/curve->dx) : 0;
+  X[1] = (!reals_equal(curve->dy, 0.0)) ? (uint16_t)((x->y - curve->bbox.y1)/curve->dy) : 0;
+  X[2] = (!reals_equal(curve->dz, 0.0)) ? (uint16_t)((x->z - curve->bbox.z1)/curve->dz) : 0;
+  return discrete_hilbert_index(X);
+}
+
+index_t hilbert_lattice_index(int i, int j, int k)
+{
+  ASSERT((i >= 0) && (i < (1 << num_bits)));
+  ASSERT((j >= 0) && (j < (1 << num_bits)));
+  ASSERT((k >= 0) && (k < (1 << num_bits)));
+  uint16_t X[3] = {(uint16_t)i, (uint16_t)j, (uint16_t)k};
+  return discrete_hilbert_index(X);
+}
+
 void hilbert_create_point(hilbert_t* curve, index_t index, point_t* x)
 {
   // Extract Hilbert indices X[0], X[1], X[2] from the given single index.
@@ -30,6 +30,12 @@ hilbert_t* hilbert_new(bbox_t* bbox);
 /// \memberof hilbert
 index_t hilbert_index(hilbert_t* curve, point_t* x);
 
+/// Returns the Hilbert index of the point (i, j, k) on a lattice of
+/// 65536 x 65536 x 65536 points. This is useful for ordering the cells or
+/// patches of a logically-Cartesian mesh.
+/// \relates hilbert
+index_t hilbert_lattice_index(int i, int j, int k);
+
 /// Recreates a 3D point from the given Hilbert index, storing it in x.
 /// \memberof hilbert
 void hilbert_create_point(hilbert_t* curve, index_t index, point_t* x);
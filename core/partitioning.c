@@ -5,6 +5,7 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 #include "core/partitioning.h"
+#include "core/array_utils.h"
 #include "core/hilbert.h"
 #include "core/parallel_sort.h"
 #include "core/timer.h"
@@ -67,8 +68,371 @@ static void extract_graph_info(adj_graph_t* graph,
       (*vtx_weights)[i] = (SCOTCH_Num)weights[i];
   }
 }
+
+// This type records the number of graph edges between two parts.
+typedef struct
+{
+  int64_t p, q, volume;
+} part_volume_t;
+
+static int part_volume_comp(const void* l, const void* r)
+{
+  const part_volume_t* lv = l;
+  const part_volume_t* rv = r;
+  if (lv->p != rv->p)
+    return (lv->p < rv->p) ? -1 : 1;
+  else if (lv->q != rv->q)
+    return (lv->q < rv->q) ? -1 : 1;
+  else
+    return 0;
+}
+
+// This sorts the given part volumes and merges those for the same pairs of
+// parts, updating num_volumes.
+static void merge_part_volumes(part_volume_t* volumes, size_t* num_volumes)
+{
+  qsort(volumes, *num_volumes, sizeof(part_volume_t), part_volume_comp);
+  size_t n = 0;
+  for (size_t i = 0; i < *num_volumes; ++i)
+  {
+    if ((n > 0) && (volumes[n-1].p == volumes[i].p) && (volumes[n-1].q == volumes[i].q))
+      volumes[n-1].volume += volumes[i].volume;
+    else
+      volumes[n++] = volumes[i];
+  }
+  *num_volumes = n;
+}
+
+// This counts the edges between different parts in the given graph, whose
+// vertices (and any ghost vertices) are assigned to parts by partition.
+static part_volume_t* part_volumes(adj_graph_t* graph,
+                                   int64_t* partition,
+                                   size_t* num_volumes)
+{
+  size_t num_vertices = adj_graph_num_vertices(graph);
+  int* edge_offsets = adj_graph_edge_offsets(graph);
+  int* edges = adj_graph_adjacency(graph);
+  part_volume_t* volumes = polymec_malloc(sizeof(part_volume_t) * MAX(edge_offsets[num_vertices], 1));
+  size_t n = 0;
+  for (size_t v = 0; v < num_vertices; ++v)
+  {
+    for (int e = edge_offsets[v]; e < edge_offsets[v+1]; ++e)
+    {
+      int64_t p = partition[v], q = partition[edges[e]];
+      if (p != q)
+      {
+        volumes[n].p = p;
+        volumes[n].q = q;
+        volumes[n].volume = 1;
+        ++n;
+      }
+    }
+  }
+  *num_volumes = n;
+  merge_part_volumes(volumes, num_volumes);
+  return volumes;
+}
+
+// This returns the number of edges in the given (merged) volumes that join
+// parts on different nodes, with parts mapped to ranks by part_ranks.
+static int64_t inter_node_volume(part_volume_t* volumes, size_t num_volumes,
+                                 int* nodes, int64_t* part_ranks)
+{
+  int64_t volume = 0;
+  for (size_t i = 0; i < num_volumes; ++i)
+  {
+    if (nodes[part_ranks[volumes[i].p]] != nodes[part_ranks[volumes[i].q]])
+      volume += volumes[i].volume;
+  }
+  return volume;
+}
+
+// Given the volumes of communication between nparts parts (one per rank),
+// this returns a newly-allocated array mapping each part to a rank such
+// that parts that share many edges land on the same node. Nodes are filled
+// one at a time, greedily, starting with the part with the most edges and
+// adding the part most connected to those already on the node. Parts stay
+// on their own ranks where possible. The volumes array is sorted and merged
+// in place.
+static int64_t* map_parts_to_nodes(int nparts, int* nodes, int num_nodes,
+                                   part_volume_t* volumes, size_t* num_volumes)
+{
+  // Merge the volumes, building a CSR list of neighboring parts.
+  merge_part_volumes(volumes, num_volumes);
+  size_t n = *num_volumes;
+  size_t offsets[nparts+1];
+  memset(offsets, 0, sizeof(size_t) * (nparts+1));
+  int64_t totals[nparts];
+  memset(totals, 0, sizeof(int64_t) * nparts);
+  for (size_t i = 0; i < n; ++i)
+  {
+    ++offsets[volumes[i].p+1];
+    totals[volumes[i].p] += volumes[i].volume;
+  }
+  for (int p = 0; p < nparts; ++p)
+    offsets[p+1] += offsets[p];
+
+  // Count the ranks on each node.
+  int node_sizes[num_nodes];
+  memset(node_sizes, 0, sizeof(int) * num_nodes);
+  for (int p = 0; p < nparts; ++p)
+    ++node_sizes[nodes[p]];
+
+  int64_t* part_ranks = polymec_malloc(sizeof(int64_t) * nparts);
+  bool assigned[nparts];
+  memset(assigned, 0, sizeof(bool) * nparts);
+  int64_t gains[nparts];
+  int bin[nparts];
+  for (int node = 0; node < num_nodes; ++node)
+  {
+    // Fill this node with parts.
+    memset(gains, 0, sizeof(int64_t) * nparts);
+    int bin_size = 0;
+    while (bin_size < node_sizes[node])
+    {
+      // Pick the unassigned part with the most edges to the node's parts,
+      // breaking ties in favor of parts whose own ranks are on the node.
+      // If there aren't any, pick the one with the most edges overall.
+      int best = -1;
+      for (int p = 0; p < nparts; ++p)
+      {
+        if (assigned[p]) continue;
+        if ((best == -1) || (gains[p] > gains[best]) ||
+            ((gains[p] == gains[best]) &&
+             (((nodes[p] == node) && (nodes[best] != node)) ||
+              ((nodes[p] == node) == (nodes[best] == node) && (totals[p] > totals[best])))))
+          best = p;
+      }
+      ASSERT(best != -1);
+      assigned[best] = true;
+      bin[bin_size++] = best;
+      for (size_t i = offsets[best]; i < offsets[best+1]; ++i)
+        gains[volumes[i].q] += volumes[i].volume;
+    }
+
+    // Parts whose own ranks are on this node keep them, and the others
+    // get the remaining ranks.
+    bool rank_taken[nparts];
+    memset(rank_taken, 0, sizeof(bool) * nparts);
+    for (int b = 0; b < bin_size; ++b)
+    {
+      if (nodes[bin[b]] == node)
+      {
+        part_ranks[bin[b]] = bin[b];
+        rank_taken[bin[b]] = true;
+      }
+    }
+    int r = 0;
+    for (int b = 0; b < bin_size; ++b)
+    {
+      if (nodes[bin[b]] != node)
+      {
+        while ((nodes[r] != node) || rank_taken[r]) ++r;
+        part_ranks[bin[b]] = r;
+        rank_taken[r] = true;
+      }
+    }
+  }
+  return part_ranks;
+}
+
+// This assigns the parts in the given partition vector to ranks in comm,
+// keeping heavily-connected parts on the same node, given the volumes of
+// communication between parts. The partition vector (of length n) is only
+// needed on rank 0, and volumes are gathered to rank 0 from all processes.
+static void map_partition_to_nodes(MPI_Comm comm, const char* caller,
+                                   part_volume_t* volumes, size_t num_volumes,
+                                   int64_t* partition, size_t n)
+{
+  int nprocs, rank;
+  MPI_Comm_size(comm, &nprocs);
+  MPI_Comm_rank(comm, &rank);
+  int num_nodes;
+  int* nodes = rank_nodes(comm, &num_nodes);
+  if ((num_nodes == 1) || (num_nodes == nprocs))
+  {
+    // Any mapping is as good as any other.
+    polymec_free(nodes);
+    return;
+  }
+
+  // Gather the volumes to rank 0.
+  int my_count = 3 * (int)num_volumes;
+  int counts[nprocs], displs[nprocs+1];
+  MPI_Gather(&my_count, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+  part_volume_t* all_volumes = NULL;
+  size_t num_all_volumes = 0;
+  if (rank == 0)
+  {
+    displs[0] = 0;
+    for (int p = 0; p < nprocs; ++p)
+      displs[p+1] = displs[p] + counts[p];
+    num_all_volumes = (size_t)(displs[nprocs] / 3);
+    all_volumes = polymec_malloc(sizeof(part_volume_t) * MAX(num_all_volumes, 1));
+  }
+  MPI_Gatherv(volumes, my_count, MPI_INT64_T, all_volumes, counts, displs,
+              MPI_INT64_T, 0, comm);
+
+  // Map the parts on rank 0, keeping the mapping only if it reduces the
+  // volume of communication between nodes.
+  int64_t part_ranks[nprocs];
+  if (rank == 0)
+  {
+    int64_t* mapped = map_parts_to_nodes(nprocs, nodes, num_nodes,
+                                         all_volumes, &num_all_volumes);
+    for (int p = 0; p < nprocs; ++p)
+      part_ranks[p] = p;
+    int64_t old_volume = inter_node_volume(all_volumes, num_all_volumes, nodes, part_ranks);
+    int64_t new_volume = inter_node_volume(all_volumes, num_all_volumes, nodes, mapped);
+    if (new_volume < old_volume)
+    {
+      log_debug("%s: Mapped parts to %d nodes (inter-node edges: %" PRIi64 " -> %" PRIi64 ").",
+                caller, num_nodes, old_volume, new_volume);
+      memcpy(part_ranks, mapped, sizeof(int64_t) * nprocs);
+    }
+    polymec_free(mapped);
+    polymec_free(all_volumes);
+  }
+  MPI_Bcast(part_ranks, nprocs, MPI_INT64_T, 0, comm);
+  if (partition != NULL)
+  {
+    for (size_t i = 0; i < n; ++i)
+      partition[i] = part_ranks[partition[i]];
+  }
+  polymec_free(nodes);
+}
 #endif
 
+// The number of consecutive ranks placed on each node by override_rank_nodes,
+// or 0 if nodes are detected.
+static int _ranks_per_node = 0;
+
+void override_rank_nodes(int ranks_per_node)
+{
+  ASSERT(ranks_per_node >= 0);
+  _ranks_per_node = ranks_per_node;
+}
+
+#if POLYMEC_HAVE_MPI
+
+// Detected node maps are cached on their communicators under this key.
+static int _rank_nodes_key = MPI_KEYVAL_INVALID;
+
+typedef struct
+{
+  int num_nodes;
+  int nodes[]; // one per rank
+} node_map_t;
+
+static int delete_node_map(MPI_Comm comm, int key, void* attr, void* extra)
+{
+  polymec_free(attr);
+  return MPI_SUCCESS;
+}
+
+static void free_rank_nodes_key(void)
+{
+  // Attributes on the world communicator outlive it, so we remove ours here.
+  MPI_Comm_delete_attr(MPI_COMM_WORLD, _rank_nodes_key);
+  MPI_Comm_free_keyval(&_rank_nodes_key);
+}
+
+// Returns the node map for the given communicator, detecting it (collectively)
+// the first time it's requested.
+static node_map_t* detected_node_map(MPI_Comm comm)
+{
+  if (_rank_nodes_key == MPI_KEYVAL_INVALID)
+  {
+    MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, delete_node_map,
+                           &_rank_nodes_key, NULL);
+    polymec_atexit(free_rank_nodes_key);
+  }
+
+  node_map_t* map;
+  int found;
+  MPI_Comm_get_attr(comm, _rank_nodes_key, &map, &found);
+  if (found)
+    return map;
+
+  int nprocs, rank;
+  MPI_Comm_size(comm, &nprocs);
+  MPI_Comm_rank(comm, &rank);
+  map = polymec_malloc(sizeof(node_map_t) + sizeof(int) * nprocs);
+
+  // Identify each node by the lowest rank on it.
+  MPI_Comm node_comm;
+  MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+  int leader;
+  MPI_Allreduce(&rank, &leader, 1, MPI_INT, MPI_MIN, node_comm);
+  MPI_Comm_free(&node_comm);
+  MPI_Allgather(&leader, 1, MPI_INT, map->nodes, 1, MPI_INT, comm);
+
+  // Number the nodes consecutively. Each leader precedes the other ranks on
+  // its node.
+  map->num_nodes = 0;
+  for (int p = 0; p < nprocs; ++p)
+  {
+    if (map->nodes[p] == p)
+      map->nodes[p] = map->num_nodes++;
+    else
+      map->nodes[p] = map->nodes[map->nodes[p]];
+  }
+
+  MPI_Comm_set_attr(comm, _rank_nodes_key, map);
+  return map;
+}
+
+#endif
+
+int* rank_nodes(MPI_Comm comm, int* num_nodes)
+{
+  int nprocs;
+  MPI_Comm_size(comm, &nprocs);
+  int* nodes = polymec_malloc(sizeof(int) * nprocs);
+  if (_ranks_per_node > 0)
+  {
+    int N = _ranks_per_node;
+    for (int p = 0; p < nprocs; ++p)
+      nodes[p] = p / N;
+    *num_nodes = (nprocs + N - 1) / N;
+    return nodes;
+  }
+
+#if POLYMEC_HAVE_MPI
+  node_map_t* map = detected_node_map(comm);
+  memcpy(nodes, map->nodes, sizeof(int) * nprocs);
+  *num_nodes = map->num_nodes;
+#else
+  nodes[0] = 0;
+  *num_nodes = 1;
+#endif
+  return nodes;
+}
+
+halo_volume_t exchanger_halo_volume(exchanger_t* ex)
+{
+  MPI_Comm comm = exchanger_comm(ex);
+  int num_nodes, rank;
+  MPI_Comm_rank(comm, &rank);
+  int* nodes = rank_nodes(comm, &num_nodes);
+  size_t volumes[2] = {0, 0};
+  int pos = 0, proc;
+  int *indices, num_indices;
+  while (exchanger_next_receive(ex, &pos, &proc, &indices, &num_indices))
+  {
+    if (nodes[proc] == nodes[rank])
+      volumes[0] += (size_t)num_indices;
+    else
+      volumes[1] += (size_t)num_indices;
+  }
+  polymec_free(nodes);
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, volumes, 2, MPI_SIZE_T, MPI_SUM, comm);
+#endif
+  halo_volume_t volume = {.intra_node = volumes[0], .inter_node = volumes[1]};
+  return volume;
+}
+
 int64_t* partition_graph(adj_graph_t* global_graph,
                          MPI_Comm comm,
                          int* weights,
@@ -129,9 +493,19 @@ int64_t* partition_graph(adj_graph_t* global_graph,
     polymec_free(adj);
   }
 
-  // Now broadcast the partition vector if we're asked to.
+  // Now broadcast the partition vector if we're asked to, keeping heavily
+  // connected parts on the same node.
   if (broadcast)
   {
+    part_volume_t* volumes = NULL;
+    size_t num_volumes = 0;
+    if (rank == 0)
+      volumes = part_volumes(global_graph, global_partition, &num_volumes);
+    map_partition_to_nodes(comm, "partition_graph", volumes, num_volumes,
+                           global_partition, num_global_vertices);
+    if (volumes != NULL)
+      polymec_free(volumes);
+
     MPI_Bcast(&num_global_vertices, 1, MPI_SIZE_T, 0, comm);
     if (rank != 0)
       global_partition = polymec_malloc(sizeof(int64_t) * num_global_vertices);
@@ -446,6 +820,15 @@ int64_t* repartition_graph(adj_graph_t* local_graph,
   // preserve the ordering of the ghost vertices, too.
   exchanger_exchange(local_graph_ex, local_partition, 1, 0, MPI_UINT64_T);
 
+  // Keep heavily connected parts on the same node.
+  {
+    size_t num_volumes;
+    part_volume_t* volumes = part_volumes(local_graph, local_partition, &num_volumes);
+    map_partition_to_nodes(comm, "repartition_graph", volumes, num_volumes,
+                           local_partition, num_vertices + num_ghost_vertices);
+    polymec_free(volumes);
+  }
+
   // Return the local partition vector.
   STOP_FUNCTION_TIMER();
   return local_partition;
@@ -946,6 +1329,526 @@ int64_t* repartition_points(point_t* local_points,
 #endif
 }
 
+// Interleaves the lowest 16 bits of x with zeros, placing bit b at bit 3*b.
+static uint64_t spread_bits(uint64_t x)
+{
+  x &= 0xffff;
+  x = (x | (x << 16)) & 0x0000ff0000ffULL;
+  x = (x | (x << 8))  & 0x00f00f00f00fULL;
+  x = (x | (x << 4))  & 0x0c30c30c30c3ULL;
+  x = (x | (x << 2))  & 0x249249249249ULL;
+  return x;
+}
+
+index_t lattice_curve_index(partitioner_t partitioner, int i, int j, int k)
+{
+  ASSERT((partitioner == MORTON_CURVE_PARTITIONER) ||
+         (partitioner == HILBERT_CURVE_PARTITIONER));
+  ASSERT((i >= 0) && (i < 65536));
+  ASSERT((j >= 0) && (j < 65536));
+  ASSERT((k >= 0) && (k < 65536));
+  if (partitioner == MORTON_CURVE_PARTITIONER)
+  {
+    return (index_t)((spread_bits((uint64_t)i) << 2) |
+                     (spread_bits((uint64_t)j) << 1) |
+                      spread_bits((uint64_t)k));
+  }
+  else
+    return hilbert_lattice_index(i, j, k);
+}
+
+#if POLYMEC_HAVE_MPI
+
+// This helper compares (index, weight, position) tuples by index.
+static int index_comp(const void* l, const void* r)
+{
+  const index_t* li = l;
+  const index_t* ri = r;
+  return (li[0] < ri[0]) ? -1
+                         : (li[0] > ri[0]) ? 1
+                                           : 0;
+}
+
+// Returns the total weight of the (sorted) tuples whose indices lie below x,
+// given the prefix sums of their weights.
+static uint64_t weight_below(index_t* tuples,
+                             uint64_t* prefix_sums,
+                             size_t num_tuples,
+                             index_t x)
+{
+  size_t lo = 0, hi = num_tuples;
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    if (tuples[3*mid] < x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return prefix_sums[lo];
+}
+
+#endif
+
+int64_t* partition_curve_indices(index_t* local_indices,
+                                 size_t num_local_indices,
+                                 MPI_Comm comm,
+                                 int* weights)
+{
+#if POLYMEC_HAVE_MPI
+  START_FUNCTION_TIMER();
+  int nprocs, rank;
+  MPI_Comm_size(comm, &nprocs);
+  MPI_Comm_rank(comm, &rank);
+  size_t n = num_local_indices;
+
+  // On a single process, partitioning has no meaning.
+  if (nprocs == 1)
+  {
+    int64_t* P = polymec_calloc(MAX(n, 1), sizeof(int64_t));
+    STOP_FUNCTION_TIMER();
+    return P;
+  }
+
+  // Sort our (index, weight, position) tuples along the curve and compute
+  // prefix sums of their weights.
+  index_t* tuples = polymec_malloc(sizeof(index_t) * 3 * MAX(n, 1));
+  for (size_t i = 0; i < n; ++i)
+  {
+    ASSERT((weights == NULL) || (weights[i] >= 0));
+    tuples[3*i]   = local_indices[i];
+    tuples[3*i+1] = (weights != NULL) ? (index_t)weights[i] : 1;
+    tuples[3*i+2] = (index_t)i;
+  }
+  qsort(tuples, n, 3*sizeof(index_t), index_comp);
+  uint64_t* prefix_sums = polymec_malloc(sizeof(uint64_t) * (n+1));
+  prefix_sums[0] = 0;
+  for (size_t i = 0; i < n; ++i)
+    prefix_sums[i+1] = prefix_sums[i] + tuples[3*i+1];
+
+  // Find the range of indices and the total weight.
+  index_t min_index = (n > 0) ? tuples[0] : UINT64_MAX;
+  index_t max_index = (n > 0) ? tuples[3*(n-1)] : 0;
+  MPI_Allreduce(MPI_IN_PLACE, &min_index, 1, MPI_INDEX_T, MPI_MIN, comm);
+  MPI_Allreduce(MPI_IN_PLACE, &max_index, 1, MPI_INDEX_T, MPI_MAX, comm);
+  uint64_t total_weight = prefix_sums[n];
+  MPI_Allreduce(MPI_IN_PLACE, &total_weight, 1, MPI_UINT64_T, MPI_SUM, comm);
+
+  int64_t* P = polymec_calloc(MAX(n, 1), sizeof(int64_t));
+  if (total_weight == 0)
+  {
+    polymec_free(prefix_sums);
+    polymec_free(tuples);
+    STOP_FUNCTION_TIMER();
+    return P;
+  }
+
+  // The rth cut separates the indices assigned to processes 0, ..., r from
+  // the rest. Let W(x) be the total weight of all indices below x. We
+  // bracket the rth cut with [lo, hi) such that W(lo) <= T < W(hi), where T
+  // is the target weight for processes 0, ..., r, and narrow the brackets by
+  // splitting each into pieces and summing W across processes at the split
+  // points. Each bracket closes around the unique index that straddles its
+  // target.
+  //
+  // Only brackets that are still open are refined. Brackets are always
+  // pieces of brackets from the previous iteration, so any two open brackets
+  // are identical or disjoint, and identical ones are adjacent. Cuts that
+  // share a bracket share its split points, so the work and communication
+  // in each iteration scale with the number of distinct open brackets and
+  // not with the number of processes.
+  static const int num_pieces = 16;
+  int num_cuts = nprocs - 1;
+  index_t* lo = polymec_malloc(sizeof(index_t) * num_cuts);
+  index_t* hi = polymec_malloc(sizeof(index_t) * num_cuts);
+  uint64_t* W_lo = polymec_malloc(sizeof(uint64_t) * num_cuts);
+  uint64_t* W_hi = polymec_malloc(sizeof(uint64_t) * num_cuts);
+  uint64_t* targets = polymec_malloc(sizeof(uint64_t) * num_cuts);
+  int* open_cuts = polymec_malloc(sizeof(int) * num_cuts);
+  for (int r = 0; r < num_cuts; ++r)
+  {
+    lo[r] = min_index;
+    hi[r] = max_index + 1;
+    W_lo[r] = 0;
+    W_hi[r] = total_weight;
+    targets[r] = (total_weight / nprocs) * (r+1) +
+                 ((total_weight % nprocs) * (r+1)) / nprocs;
+    open_cuts[r] = r;
+  }
+  int num_open = (max_index + 1 - min_index > 1) ? num_cuts : 0;
+
+  // group_offsets[g] is the position in open_cuts of the first cut with the
+  // gth distinct open bracket.
+  int* group_offsets = polymec_malloc(sizeof(int) * (num_cuts+1));
+  index_t* splits = polymec_malloc(sizeof(index_t) * num_cuts * (num_pieces-1));
+  uint64_t* W = polymec_malloc(sizeof(uint64_t) * num_cuts * (num_pieces-1));
+  int num_iters = 0;
+  while (num_open > 0)
+  {
+    int num_groups = 0;
+    for (int a = 0; a < num_open; ++a)
+    {
+      int r = open_cuts[a];
+      if ((a == 0) || (lo[r] != lo[open_cuts[a-1]]) || (hi[r] != hi[open_cuts[a-1]]))
+        group_offsets[num_groups++] = a;
+    }
+    group_offsets[num_groups] = num_open;
+
+    for (int g = 0; g < num_groups; ++g)
+    {
+      int r = open_cuts[group_offsets[g]];
+      index_t width = hi[r] - lo[r];
+      for (int m = 1; m < num_pieces; ++m)
+      {
+        index_t s = lo[r] + (width / num_pieces) * m +
+                    ((width % num_pieces) * m) / num_pieces;
+        splits[(num_pieces-1)*g+m-1] = s;
+        W[(num_pieces-1)*g+m-1] = weight_below(tuples, prefix_sums, n, s);
+      }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, W, num_groups*(num_pieces-1), MPI_UINT64_T,
+                  MPI_SUM, comm);
+
+    // Narrow the brackets of the open cuts, and keep the ones that remain
+    // open (in order).
+    int num_still_open = 0;
+    for (int g = 0; g < num_groups; ++g)
+    {
+      for (int a = group_offsets[g]; a < group_offsets[g+1]; ++a)
+      {
+        int r = open_cuts[a];
+        for (int m = 0; m < num_pieces-1; ++m)
+        {
+          index_t s = splits[(num_pieces-1)*g+m];
+          uint64_t Ws = W[(num_pieces-1)*g+m];
+          if (Ws <= targets[r])
+          {
+            lo[r] = s;
+            W_lo[r] = Ws;
+          }
+          else
+          {
+            hi[r] = s;
+            W_hi[r] = Ws;
+            break;
+          }
+        }
+        if (hi[r] - lo[r] > 1)
+          open_cuts[num_still_open++] = r;
+      }
+    }
+    num_open = num_still_open;
+    ++num_iters;
+  }
+  polymec_free(W);
+  polymec_free(splits);
+  polymec_free(group_offsets);
+  polymec_free(open_cuts);
+
+  // Place each cut on whichever side of its straddling index leaves the
+  // loads closest to their targets.
+  index_t* cuts = polymec_malloc(sizeof(index_t) * num_cuts);
+  uint64_t* cut_weights = polymec_malloc(sizeof(uint64_t) * (num_cuts+1));
+  for (int r = 0; r < num_cuts; ++r)
+  {
+    if ((targets[r] - W_lo[r]) <= (W_hi[r] - targets[r]))
+    {
+      cuts[r] = lo[r];
+      cut_weights[r] = W_lo[r];
+    }
+    else
+    {
+      cuts[r] = hi[r];
+      cut_weights[r] = W_hi[r];
+    }
+  }
+  cut_weights[num_cuts] = total_weight;
+
+  // Assign each local index to the process whose segment contains it.
+  for (size_t i = 0; i < n; ++i)
+  {
+    index_t index = tuples[3*i];
+    int p = 0, q = num_cuts;
+    while (p < q)
+    {
+      int mid = (p + q) / 2;
+      if (cuts[mid] <= index)
+        p = mid + 1;
+      else
+        q = mid;
+    }
+    P[tuples[3*i+2]] = (int64_t)p;
+  }
+
+  if (rank == 0)
+  {
+    uint64_t max_load = cut_weights[0];
+    for (int r = 1; r <= num_cuts; ++r)
+      max_load = MAX(max_load, cut_weights[r] - cut_weights[r-1]);
+    log_debug("partition_curve_indices: Found %d cuts in %d iterations "
+              "(maximum imbalance: %g%%).", num_cuts, num_iters,
+              100.0 * ((1.0 * max_load * nprocs) / (1.0 * total_weight) - 1.0));
+  }
+
+  // Clean up.
+  polymec_free(cut_weights);
+  polymec_free(cuts);
+  polymec_free(targets);
+  polymec_free(W_hi);
+  polymec_free(W_lo);
+  polymec_free(hi);
+  polymec_free(lo);
+  polymec_free(prefix_sums);
+  polymec_free(tuples);
+
+  STOP_FUNCTION_TIMER();
+  return P;
+#else
+  int64_t* P = polymec_calloc(MAX(num_local_indices, 1), sizeof(int64_t));
+  return P;
+#endif
+}
+
+#if POLYMEC_HAVE_MPI
+
+// This helper compares (count, vertex) pairs, placing larger counts first.
+static int boundary_vertex_comp(const void* l, const void* r)
+{
+  const int* li = l;
+  const int* ri = r;
+  return (li[0] > ri[0]) ? -1
+                         : (li[0] < ri[0]) ? 1
+                                           : (li[1] - ri[1]);
+}
+
+// Sends my_value to each of the given neighboring processes, and stores the
+// values they send us in values.
+static void exchange_with_neighbors(MPI_Comm comm,
+                                    int_array_t* neighbors,
+                                    real_t my_value,
+                                    real_t* values)
+{
+  size_t num_neighbors = neighbors->size;
+  MPI_Request requests[2*num_neighbors+1];
+  for (size_t n = 0; n < num_neighbors; ++n)
+  {
+    MPI_Irecv(&values[n], 1, MPI_REAL_T, neighbors->data[n], 0, comm,
+              &requests[n]);
+  }
+  for (size_t n = 0; n < num_neighbors; ++n)
+  {
+    MPI_Isend(&my_value, 1, MPI_REAL_T, neighbors->data[n], 0, comm,
+              &requests[num_neighbors+n]);
+  }
+  MPI_Waitall((int)(2*num_neighbors), requests, MPI_STATUSES_IGNORE);
+}
+
+#endif
+
+int64_t* rebalance_graph(adj_graph_t* local_graph,
+                         int* ghost_owners,
+                         int* weights,
+                         size_t* migration_costs,
+                         real_t imbalance_tol,
+                         size_t* predicted_migration)
+{
+  ASSERT(imbalance_tol > 0.0);
+  ASSERT(imbalance_tol <= 1.0);
+  int num_vertices = (int)adj_graph_num_vertices(local_graph);
+  int64_t* P = polymec_calloc(MAX(num_vertices, 1), sizeof(int64_t));
+  if (predicted_migration != NULL)
+    *predicted_migration = 0;
+#if POLYMEC_HAVE_MPI
+  START_FUNCTION_TIMER();
+  MPI_Comm comm = adj_graph_comm(local_graph);
+  int nprocs, rank;
+  MPI_Comm_size(comm, &nprocs);
+  MPI_Comm_rank(comm, &rank);
+  for (int v = 0; v < num_vertices; ++v)
+    P[v] = (int64_t)rank;
+
+  // On a single process, rebalancing has no meaning.
+  if (nprocs == 1)
+  {
+    STOP_FUNCTION_TIMER();
+    return P;
+  }
+
+  // Find our neighboring processes.
+  int_array_t* neighbors = int_array_new();
+  for (int v = 0; v < num_vertices; ++v)
+  {
+    int* edges = adj_graph_edges(local_graph, v);
+    size_t num_edges = adj_graph_num_edges(local_graph, v);
+    for (size_t e = 0; e < num_edges; ++e)
+    {
+      if (edges[e] >= num_vertices)
+      {
+        int owner = ghost_owners[edges[e] - num_vertices];
+        if (owner != rank)
+          int_array_append(neighbors, owner);
+      }
+    }
+  }
+  int_qsort(neighbors->data, neighbors->size);
+  size_t num_neighbors = 0;
+  for (size_t n = 0; n < neighbors->size; ++n)
+  {
+    if ((n == 0) || (neighbors->data[n] != neighbors->data[n-1]))
+      neighbors->data[num_neighbors++] = neighbors->data[n];
+  }
+  int_array_resize(neighbors, num_neighbors);
+
+  // Compute the ideal load and the current imbalance.
+  real_t my_load = 0.0;
+  for (int v = 0; v < num_vertices; ++v)
+    my_load += (weights != NULL) ? 1.0 * weights[v] : 1.0;
+  real_t total_load;
+  MPI_Allreduce(&my_load, &total_load, 1, MPI_REAL_T, MPI_SUM, comm);
+  real_t ideal_load = total_load / nprocs;
+  real_t imbalance = ABS(my_load - ideal_load);
+  MPI_Allreduce(MPI_IN_PLACE, &imbalance, 1, MPI_REAL_T, MPI_MAX, comm);
+  log_debug("rebalance_graph: Current maximum imbalance is %g%%.",
+            (ideal_load > 0.0) ? 100.0 * imbalance / ideal_load : 0.0);
+
+  // Are we balanced already?
+  if (imbalance <= imbalance_tol * ideal_load)
+  {
+    int_array_free(neighbors);
+    STOP_FUNCTION_TIMER();
+    return P;
+  }
+
+  // Diffuse the loads between neighboring processes until they balance,
+  // accumulating the flow of load to each of our neighbors. The flow from
+  // process p to process q is the negative of the flow from q to p, so the
+  // total load is conserved. Each step exchanges loads only with our
+  // neighbors, and then sums the squared deviations from the ideal load,
+  // which diffusion decreases at every step until the loads are balanced
+  // (or, if the processes form disconnected groups, until each group is).
+  // We stop when this sum bounds the imbalance within half the tolerance
+  // (leaving the rest for realizing the flows with whole vertices), or when
+  // it stops decreasing.
+  real_t my_degree = 1.0 * num_neighbors, degrees[MAX(num_neighbors, 1)];
+  exchange_with_neighbors(comm, neighbors, my_degree, degrees);
+  real_t alphas[MAX(num_neighbors, 1)], flows[MAX(num_neighbors, 1)],
+         x[MAX(num_neighbors, 1)];
+  for (size_t n = 0; n < num_neighbors; ++n)
+  {
+    alphas[n] = 1.0 / (1.0 + MAX(my_degree, degrees[n]));
+    flows[n] = 0.0;
+  }
+  real_t my_x = my_load;
+  real_t target = 0.5 * imbalance_tol * ideal_load;
+  real_t deviation = REAL_MAX;
+  int num_iters = 0;
+  while (true)
+  {
+    exchange_with_neighbors(comm, neighbors, my_x, x);
+    real_t new_x = my_x;
+    for (size_t n = 0; n < num_neighbors; ++n)
+    {
+      real_t flow = alphas[n] * (my_x - x[n]);
+      flows[n] += flow;
+      new_x -= flow;
+    }
+    my_x = new_x;
+    ++num_iters;
+
+    real_t new_deviation = (my_x - ideal_load) * (my_x - ideal_load);
+    MPI_Allreduce(MPI_IN_PLACE, &new_deviation, 1, MPI_REAL_T, MPI_SUM, comm);
+    if ((new_deviation <= target * target) || (new_deviation >= deviation))
+      break;
+    deviation = new_deviation;
+  }
+  log_debug("rebalance_graph: Computed load flows in %d iterations.", num_iters);
+
+  // Realize the flow to each neighbor by moving vertices, starting with
+  // those most connected to the neighbor and working inward.
+  int* visited = polymec_malloc(sizeof(int) * MAX(num_vertices, 1));
+  int* queue = polymec_malloc(sizeof(int) * 2 * MAX(num_vertices, 1));
+  for (int v = 0; v < num_vertices; ++v)
+    visited[v] = -1;
+  size_t my_migration = 0;
+  int num_moved = 0;
+  for (size_t n = 0; n < num_neighbors; ++n)
+  {
+    real_t remaining = flows[n];
+    if (remaining <= 0.0) continue;
+    int q = neighbors->data[n];
+
+    // Seed the queue with (count, vertex) pairs for the vertices that share
+    // edges with the neighbor, most connected first.
+    int num_seeds = 0;
+    for (int v = 0; v < num_vertices; ++v)
+    {
+      if (P[v] != rank) continue;
+      int* edges = adj_graph_edges(local_graph, v);
+      size_t num_edges = adj_graph_num_edges(local_graph, v);
+      int count = 0;
+      for (size_t e = 0; e < num_edges; ++e)
+      {
+        if ((edges[e] >= num_vertices) &&
+            (ghost_owners[edges[e] - num_vertices] == q))
+          ++count;
+      }
+      if (count > 0)
+      {
+        queue[2*num_seeds] = count;
+        queue[2*num_seeds+1] = v;
+        visited[v] = (int)n;
+        ++num_seeds;
+      }
+    }
+    qsort(queue, num_seeds, 2*sizeof(int), boundary_vertex_comp);
+    for (int i = 0; i < num_seeds; ++i)
+      queue[i] = queue[2*i+1];
+
+    // Move vertices in breadth-first order until the flow is realized.
+    int head = 0, tail = num_seeds;
+    while ((head < tail) && (remaining > 0.0))
+    {
+      int v = queue[head++];
+      if (P[v] != rank) continue;
+      real_t w = (weights != NULL) ? 1.0 * weights[v] : 1.0;
+      if (w > 2.0 * remaining) continue;
+      P[v] = (int64_t)q;
+      remaining -= w;
+      my_migration += (migration_costs != NULL) ? migration_costs[v] : 1;
+      ++num_moved;
+
+      int* edges = adj_graph_edges(local_graph, v);
+      size_t num_edges = adj_graph_num_edges(local_graph, v);
+      for (size_t e = 0; e < num_edges; ++e)
+      {
+        int u = edges[e];
+        if ((u < num_vertices) && (P[u] == rank) && (visited[u] != (int)n))
+        {
+          visited[u] = (int)n;
+          queue[tail++] = u;
+        }
+      }
+    }
+  }
+  log_debug("rebalance_graph: Moving %d of %d vertices to neighboring processes.",
+            num_moved, num_vertices);
+
+  if (predicted_migration != NULL)
+  {
+    MPI_Allreduce(&my_migration, predicted_migration, 1, MPI_SIZE_T,
+                  MPI_SUM, comm);
+  }
+
+  // Clean up.
+  polymec_free(queue);
+  polymec_free(visited);
+  int_array_free(neighbors);
+
+  STOP_FUNCTION_TIMER();
+#endif
+  return P;
+}
+
 redistribution_t* redistribution_from_partition(MPI_Comm comm,
                                                 int64_t* local_partition,
                                                 size_t num_local_vertices)
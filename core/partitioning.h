@@ -31,6 +31,9 @@
 ///                       receive NULL.
 /// \returns A global partition vector, or NULL if the graph couldn't be
 ///          partitioned successfully.
+/// \note If broadcast is true and comm spans several (compute) nodes, the
+///       parts are assigned to ranks so that parts sharing many edges land
+///       on the same node (see \ref rank_nodes).
 /// \collective Collective on comm.
 int64_t* partition_graph(adj_graph_t* global_graph,
                          MPI_Comm comm,
@@ -79,7 +82,8 @@ int64_t* partition_points_n_ways(point_t* points,
                                  real_t imbalance_tol);
 
 /// Repartitions a local graph, creating and returning a local partition
-/// vector with destination ranks included for ghost vertices.
+/// vector with destination ranks included for ghost vertices. As in
+/// \ref partition_graph, parts sharing many edges are kept on the same node.
 /// \collective Collective on local_graph's communicator.
 int64_t* repartition_graph(adj_graph_t* local_graph,
                            exchanger_t* local_graph_ex,
@@ -96,6 +100,126 @@ int64_t* repartition_points(point_t* local_points,
                             int* weights,
                             real_t imbalance_tol);
 
+/// \enum partitioner_t
+/// Algorithms for partitioning the patches of block-structured meshes (see
+/// \ref repartition_unimesh and \ref repartition_blockmesh).
+typedef enum
+{
+  /// Partitions a global adjacency graph of all patches on a single
+  /// process using a graph partitioner (SCOTCH), and broadcasts the result.
+  GRAPH_PARTITIONER,
+  /// Orders patches along a Morton (Z-order) space-filling curve and splits
+  /// the curve into pieces of equal weight, in parallel.
+  MORTON_CURVE_PARTITIONER,
+  /// Orders patches along a Hilbert space-filling curve and splits the curve
+  /// into pieces of equal weight, in parallel. Hilbert curves have better
+  /// locality than Morton curves, so this usually produces smaller
+  /// subdomain boundaries.
+  HILBERT_CURVE_PARTITIONER
+} partitioner_t;
+
+/// Returns the index of the lattice point (i, j, k) along the space-filling
+/// curve used by the given partitioner, which must be
+/// \ref MORTON_CURVE_PARTITIONER or \ref HILBERT_CURVE_PARTITIONER. Each of
+/// i, j, and k must lie in [0, 65536), so the index fits within 48 bits.
+index_t lattice_curve_index(partitioner_t partitioner, int i, int j, int k);
+
+/// Partitions a distributed set of indices along a space-filling curve,
+/// assigning each process a contiguous segment of the curve such that the
+/// segments have nearly equal weights. Entries that share an index are
+/// assigned to the same process. The segments are found with a
+/// parallel search on weighted prefix sums, so each process only works with
+/// its own indices (no global data is gathered or sorted).
+/// \param local_indices [in] An array of indices stored on this process.
+/// \param num_local_indices [in] The length of local_indices.
+/// \param comm [in] The communicator across which the indices are partitioned.
+/// \param weights [in] An array of non-negative weights for the local
+///                     indices, or NULL for unit weights.
+/// \returns A local partition vector whose ith component is the rank of the
+///          process to which the ith local index is assigned.
+/// \collective Collective on comm.
+int64_t* partition_curve_indices(index_t* local_indices,
+                                 size_t num_local_indices,
+                                 MPI_Comm comm,
+                                 int* weights);
+
+/// \struct migration
+/// This struct reports the amount of data moved between processes when a
+/// distributed object is rebalanced, summed over all processes.
+typedef struct
+{
+  /// The number of bytes the rebalancing was expected to move.
+  size_t predicted_bytes;
+  /// The number of bytes actually sent between processes.
+  size_t actual_bytes;
+} migration_t;
+
+/// Incrementally rebalances a distributed graph whose vertices are owned by
+/// the processes that store them, moving as little data as possible. Rather
+/// than partitioning the graph from scratch, this function computes the
+/// flow of load between neighboring processes that balances the workload
+/// using first-order diffusion on the graph of processes, and realizes each
+/// flow by moving vertices across the boundary between the two processes,
+/// from the boundary inward. Vertices never move between processes that
+/// don't already share a boundary. Each diffusion step exchanges loads only
+/// between neighboring processes, so the graph's edges must be symmetric:
+/// a process that owns a ghost vertex of another process must in turn have
+/// a ghost vertex owned by that process.
+/// \param local_graph [in] The local portion of a distributed graph, whose
+///                         edges refer to ghost vertices by indices at and
+///                         beyond the number of local vertices.
+/// \param ghost_owners [in] An array containing the rank of the process that
+///                          owns each ghost vertex.
+/// \param weights [in] An array of weights for the local vertices, or NULL.
+/// \param migration_costs [in] An array containing the number of bytes that
+///                             would move along with each local vertex, or
+///                             NULL if each vertex moves one byte.
+/// \param imbalance_tol [in] A number between 0 and 1 representing the maximum
+///                           acceptable load imbalance.
+/// \param predicted_migration [out] If non-NULL, stores the total number of
+///                                  bytes moved by the rebalancing on all
+///                                  processes, as predicted by migration_costs.
+/// \returns A local partition vector whose ith component is the rank of the
+///          process to which the ith local vertex is assigned.
+/// \collective Collective on local_graph's communicator.
+int64_t* rebalance_graph(adj_graph_t* local_graph,
+                         int* ghost_owners,
+                         int* weights,
+                         size_t* migration_costs,
+                         real_t imbalance_tol,
+                         size_t* predicted_migration);
+
+/// Returns a newly-allocated array whose pth entry is the index of the
+/// shared-memory (compute) node hosting rank p in the given communicator.
+/// Nodes are numbered in the order of their lowest ranks. The node layout is
+/// detected the first time it's requested for a communicator and cached on
+/// that communicator, so later calls don't communicate. The layout can be 
+/// replaced with \ref override_rank_nodes.
+/// \param [out] num_nodes Stores the number of distinct nodes.
+/// \collective Collective on comm.
+int* rank_nodes(MPI_Comm comm, int* num_nodes);
+
+/// Overrides the node layout reported by \ref rank_nodes for all 
+/// communicators, placing every ranks_per_node consecutive ranks on their 
+/// own node. This is useful for testing topology-aware mappings on a single 
+/// machine. Call with ranks_per_node == 0 to restore the detected layout.
+void override_rank_nodes(int ranks_per_node);
+
+/// \struct halo_volume_t
+/// This type records the number of values a decomposition exchanges between
+/// processes on the same (compute) node and on different nodes.
+typedef struct
+{
+  size_t intra_node; ///< Number of halo values exchanged within nodes.
+  size_t inter_node; ///< Number of halo values exchanged between nodes.
+} halo_volume_t;
+
+/// Returns the total numbers of values received by the given exchanger from
+/// processes on the same node and on other nodes (see \ref rank_nodes),
+/// summed over all processes.
+/// \collective Collective on the exchanger's communicator.
+halo_volume_t exchanger_halo_volume(exchanger_t* ex);
+
 /// \struct redistribution
 /// This struct contains information needed to redistribute data from the
 /// local process to each of its neighbors.
@@ -134,6 +134,12 @@ static void test_blob_exchanger_exchange(void** state)
   big_widget_t bigw1;
   assert_true(blob_exchanger_copy_out(ex, buffer, big_blob, &bigw1));
 
+  // We can also read the received blobs in place.
+  small_widget_t* smallw2 = blob_exchanger_receive_blob_storage(ex, buffer, small_blob);
+  assert_non_null(smallw2);
+  assert_int_equal(0, memcmp(smallw2, &smallw1, sizeof(small_widget_t)));
+  assert_null(blob_exchanger_receive_blob_storage(ex, buffer, 2));
+
   // Did we get what we expected?
   assert_int_equal(0, strcmp(smallw1.name, smallw.name));
   assert_int_equal(smallw.age, smallw1.age);
@@ -46,6 +46,11 @@ struct blockmesh_t
   // no new blocks may be added.
   bool started_connecting_blocks;
 
+  // Block connections, stored as (block1, block1_nodes[4], block2,
+  // block2_nodes[4]) tuples so they can be reestablished when the mesh is
+  // repartitioned.
+  int_array_t* connections;
+
   // This flag is set by blockmesh_finalize() after a mesh has been assembled.
   bool finalized;
 };
@@ -69,6 +74,7 @@ blockmesh_t* blockmesh_new(MPI_Comm comm,
   mesh->blocks = unimesh_array_new();
   mesh->interblock_bc = blockmesh_interblock_bc_new(mesh);
   mesh->started_connecting_blocks = false;
+  mesh->connections = int_array_new();
   mesh->finalized = false;
 
   return mesh;
@@ -106,27 +112,59 @@ static int _valid_block_face_nodes[6][4] = {{0, 4, 7, 3},  // -x
                                             {0, 1, 2, 3},  // -z
                                             {7, 6, 5, 4}}; // +z
 
+// Corners of a block (in units of the block's extents) for each node.
+static int _block_node_corners[8][3] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+                                        {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
+
 static int determine_rotation(int block1_boundary, int block1_nodes[4],
                               int block2_boundary, int block2_nodes[4])
 {
-  // We calculate "twists" for each pair of nodes, consisting of an integer number of
-  // counter-clockwise turns from 0 to 3. If all the twists are the same, that's the
-  // valid twist. Otherwise, the twist is invalid.
-  int twists[4];
-  for (int i = 0; i < 4; ++i)
+  // We locate each pair of nodes on their respective block boundaries, along
+  // the transverse axes that find_patch2_indices uses to match up patches.
+  // The rotation is the number of counterclockwise turns that takes each
+  // node in the first block to its partner in the second. If no rotation
+  // does this for all 4 pairs, the connection is invalid.
+  int d1 = block1_boundary/2, d2 = block2_boundary/2;
+  for (int rotation = 0; rotation < 4; ++rotation)
   {
-    int n1 = block1_nodes[i];
-    int* valid_nodes1 = _valid_block_face_nodes[block1_boundary];
-    int offset1 = (int)(int_lsearch(valid_nodes1, 4, n1) - valid_nodes1);
-    int n2 = block2_nodes[i];
-    int* valid_nodes2 = _valid_block_face_nodes[block2_boundary];
-    int offset2 = (int)(int_lsearch(valid_nodes2, 4, n2) - valid_nodes2);
-    int twist = (offset2 - offset1 + 4) % 4;
-    twists[i] = twist;
-    if ((i > 0) && (twists[i] != twists[0]))
-      return -1;
+    bool matches = true;
+    for (int i = 0; i < 4; ++i)
+    {
+      int* c1 = _block_node_corners[block1_nodes[i]];
+      int* c2 = _block_node_corners[block2_nodes[i]];
+      int u1 = c1[(d1+1)%3], v1 = c1[(d1+2)%3];
+      int u2 = c2[(d2+1)%3], v2 = c2[(d2+2)%3];
+      int u, v;
+      if (rotation == 0)
+      {
+        u = u1;
+        v = v1;
+      }
+      else if (rotation == 1)
+      {
+        u = 1 - v1;
+        v = u1;
+      }
+      else if (rotation == 2)
+      {
+        u = 1 - u1;
+        v = 1 - v1;
+      }
+      else
+      {
+        u = v1;
+        v = 1 - u1;
+      }
+      if ((u != u2) || (v != v2))
+      {
+        matches = false;
+        break;
+      }
+    }
+    if (matches)
+      return rotation;
   }
-  return twists[0];
+  return -1;
 }
 
 static int block_boundary_for_nodes(int block_nodes[4])
@@ -218,13 +256,6 @@ bool blockmesh_can_connect_blocks(blockmesh_t* mesh,
   // Now make sure the two blocks are compatible on the shared boundary.
   int rotation = determine_rotation(b1, block1_nodes, b2, block2_nodes);
   if (rotation == -1)
-  {
-    // Try again with block2_nodes reversed.
-    int rev_block2_nodes[4] = {block2_nodes[3], block2_nodes[2],
-                               block2_nodes[1], block2_nodes[0]};
-    rotation = determine_rotation(b1, block1_nodes, b2, rev_block2_nodes);
-  }
-  if (rotation == -1)
   {
     if (reason != NULL)
     {
@@ -325,6 +356,56 @@ bool blockmesh_can_connect_blocks(blockmesh_t* mesh,
   return true;
 }
 
+#if POLYMEC_HAVE_MPI
+extern void unimesh_set_owner_proc(unimesh_t* mesh,
+                                   int i, int j, int k,
+                                   unimesh_boundary_t boundary,
+                                   int proc);
+
+// Tells each block which processes own the neighbors of its local patches,
+// given the owning process of every patch in the mesh. Patches are numbered
+// block by block, and in (i, j, k) order within each block. Blocks need this
+// to exchange values between patches within a block on different processes.
+static void set_patch_owners(blockmesh_t* mesh, int64_t* owners)
+{
+  int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                       {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+  int block_offset = 0;
+  for (size_t b = 0; b < mesh->blocks->size; ++b)
+  {
+    unimesh_t* block = mesh->blocks->data[b];
+    int npx, npy, npz;
+    unimesh_get_extents(block, &npx, &npy, &npz);
+    for (int i = 0; i < npx; ++i)
+    {
+      for (int j = 0; j < npy; ++j)
+      {
+        for (int k = 0; k < npz; ++k)
+        {
+          if (!unimesh_has_patch(block, i, j, k))
+            continue;
+          for (int n = 0; n < 6; ++n)
+          {
+            int i1 = i + offsets[n][0],
+                j1 = j + offsets[n][1],
+                k1 = k + offsets[n][2];
+            if ((i1 >= 0) && (i1 < npx) &&
+                (j1 >= 0) && (j1 < npy) &&
+                (k1 >= 0) && (k1 < npz))
+            {
+              int owner = (int)owners[block_offset + npy*npz*i1 + npz*j1 + k1];
+              if (owner != mesh->rank)
+                unimesh_set_owner_proc(block, i, j, k, (unimesh_boundary_t)n, owner);
+            }
+          }
+        }
+      }
+    }
+    block_offset += npx * npy * npz;
+  }
+}
+#endif
+
 static void assign_patches(blockmesh_t* mesh)
 {
   // Count up all the patches in the global mesh.
@@ -334,17 +415,17 @@ static void assign_patches(blockmesh_t* mesh)
     unimesh_t* block = mesh->blocks->data[b];
     int npx, npy, npz;
     unimesh_get_extents(block, &npx, &npy, &npz);
-    num_patches += mesh->patch_nx * mesh->patch_ny * mesh->patch_nz * npx * npy * npz;
+    num_patches += npx * npy * npz;
   }
 
-  int_array_t* patch_list = int_array_new();
-  int start_patch = 0, num_local_patches = num_patches;
+  // Divide the patches up amongst our processes, giving each process a
+  // contiguous range of them.
+  int start_patch = 0, end_patch = num_patches;
 #if POLYMEC_HAVE_MPI
   if (mesh->nproc > 1)
   {
-    // Divide the total number of patches up amongst our processes.
-    num_local_patches = num_patches / mesh->nproc;
-    start_patch = mesh->rank * num_local_patches;
+    start_patch = mesh->rank * num_patches / mesh->nproc;
+    end_patch = (mesh->rank + 1) * num_patches / mesh->nproc;
   }
 #endif
   int patch = 0;
@@ -359,32 +440,30 @@ static void assign_patches(blockmesh_t* mesh)
       {
         for (int k = 0; k < npz; ++k)
         {
-          if (patch >= start_patch)
-          {
-            int_array_append(patch_list, (int)b);
-            int_array_append(patch_list, i);
-            int_array_append(patch_list, j);
-            int_array_append(patch_list, k);
-            if ((int)(patch_list->size) == num_local_patches)
-              goto done_selecting_patches;
-          }
+          if ((patch >= start_patch) && (patch < end_patch))
+            unimesh_insert_patch(block, i, j, k);
           ++patch;
         }
       }
     }
   }
 
-done_selecting_patches:
-  for (size_t p = 0; p < patch_list->size/4; ++p)
+#if POLYMEC_HAVE_MPI
+  // Record the owners of neighboring patches on other processes.
+  if (mesh->nproc > 1)
   {
-    int block_index = patch_list->data[4*p];
-    unimesh_t* block = mesh->blocks->data[block_index];
-    int i = patch_list->data[4*p+1];
-    int j = patch_list->data[4*p+2];
-    int k = patch_list->data[4*p+3];
-    unimesh_insert_patch(block, i, j, k);
+    int64_t* owners = polymec_malloc(sizeof(int64_t) * num_patches);
+    for (int p = 0; p < mesh->nproc; ++p)
+    {
+      int start = p * num_patches / mesh->nproc;
+      int end = (p + 1) * num_patches / mesh->nproc;
+      for (int q = start; q < end; ++q)
+        owners[q] = (int64_t)p;
+    }
+    set_patch_owners(mesh, owners);
+    polymec_free(owners);
   }
-  int_array_free(patch_list);
+#endif
 }
 
 static void find_patch2_indices(int boundary1,
@@ -504,16 +583,16 @@ void blockmesh_connect_blocks(blockmesh_t* mesh,
 
   int rotation = determine_rotation(b1, block1_nodes,
                                     b2, block2_nodes);
-  if (rotation == -1)
-  {
-    // Try again with block2_nodes reversed.
-    int rev_block2_nodes[4] = {block2_nodes[3], block2_nodes[2],
-                               block2_nodes[1], block2_nodes[0]};
-    rotation = determine_rotation(b1, block1_nodes,
-                                  b2, rev_block2_nodes);
-  }
   ASSERT(rotation != -1);
 
+  // Record the connection.
+  int_array_append(mesh->connections, block1_index);
+  for (int n = 0; n < 4; ++n)
+    int_array_append(mesh->connections, block1_nodes[n]);
+  int_array_append(mesh->connections, block2_index);
+  for (int n = 0; n < 4; ++n)
+    int_array_append(mesh->connections, block2_nodes[n]);
+
   // If this is our first connection, assign all the patches within the
   // existing blocks in the mesh. This prevents new blocks from being added
   // afterwards
@@ -609,6 +688,7 @@ void blockmesh_free(blockmesh_t* mesh)
 {
   blockmesh_interblock_bc_free(mesh->interblock_bc);
   unimesh_array_free(mesh->blocks);
+  int_array_free(mesh->connections);
   polymec_free(mesh);
 }
 
@@ -908,6 +988,86 @@ static int64_t* source_vector(blockmesh_t* mesh)
   return sources;
 }
 
+// Partitions the mesh's patches along a space-filling curve that traverses
+// the blocks in order, in parallel, returning a global partition vector.
+static int64_t* curve_partition(blockmesh_t* mesh,
+                                partitioner_t partitioner,
+                                int* weights)
+{
+  START_FUNCTION_TIMER();
+
+  // Map our local patches to the curve, placing the patches in each block
+  // on a separate segment.
+  int num_blocks = (int)(mesh->blocks->size);
+  int block_offsets[num_blocks+1];
+  block_offsets[0] = 0;
+  int num_local_patches = 0;
+  for (int b = 0; b < num_blocks; ++b)
+  {
+    unimesh_t* block = mesh->blocks->data[b];
+    int npx, npy, npz;
+    unimesh_get_extents(block, &npx, &npy, &npz);
+    block_offsets[b+1] = block_offsets[b] + npx*npy*npz;
+    num_local_patches += unimesh_num_patches(block);
+  }
+  int* local_patches = polymec_malloc(sizeof(int) * MAX(num_local_patches, 1));
+  index_t* indices = polymec_malloc(sizeof(index_t) * MAX(num_local_patches, 1));
+  int l = 0;
+  for (int b = 0; b < num_blocks; ++b)
+  {
+    unimesh_t* block = mesh->blocks->data[b];
+    int npx, npy, npz;
+    unimesh_get_extents(block, &npx, &npy, &npz);
+    int pos = 0, i, j, k;
+    while (unimesh_next_patch(block, &pos, &i, &j, &k, NULL))
+    {
+      local_patches[l] = block_offsets[b] + npy*npz*i + npz*j + k;
+      indices[l] = ((index_t)b << 48) | lattice_curve_index(partitioner, i, j, k);
+      ++l;
+    }
+  }
+  ASSERT(l == num_local_patches);
+
+  // Split the curve.
+  int64_t* local_partition = partition_curve_indices(indices, num_local_patches,
+                                                     mesh->comm, weights);
+
+  // Share the (patch, rank) pairs to build a global partition vector.
+  int64_t* local_pairs = polymec_malloc(sizeof(int64_t) * 2 * MAX(num_local_patches, 1));
+  for (l = 0; l < num_local_patches; ++l)
+  {
+    local_pairs[2*l] = (int64_t)local_patches[l];
+    local_pairs[2*l+1] = local_partition[l];
+  }
+  int num_pair_values = 2 * num_local_patches;
+  int num_pair_values_for_proc[mesh->nproc];
+  MPI_Allgather(&num_pair_values, 1, MPI_INT,
+                num_pair_values_for_proc, 1, MPI_INT, mesh->comm);
+  int proc_offsets[mesh->nproc+1];
+  proc_offsets[0] = 0;
+  for (int p = 0; p < mesh->nproc; ++p)
+    proc_offsets[p+1] = proc_offsets[p] + num_pair_values_for_proc[p];
+  int num_patches = block_offsets[num_blocks];
+  ASSERT(proc_offsets[mesh->nproc] == 2 * num_patches);
+  int64_t* all_pairs = polymec_malloc(sizeof(int64_t) * 2 * num_patches);
+  MPI_Allgatherv(local_pairs, num_pair_values, MPI_INT64_T,
+                 all_pairs, num_pair_values_for_proc, proc_offsets,
+                 MPI_INT64_T, mesh->comm);
+  int64_t* partition = polymec_malloc(sizeof(int64_t) * num_patches);
+  for (int p = 0; p < num_patches; ++p)
+    partition[all_pairs[2*p]] = all_pairs[2*p+1];
+
+  // Clean up.
+  polymec_free(all_pairs);
+  polymec_free(local_pairs);
+  polymec_free(local_partition);
+  polymec_free(indices);
+  polymec_free(local_patches);
+
+  STOP_FUNCTION_TIMER();
+  return partition;
+}
+
 static void redistribute_blockmesh(blockmesh_t** mesh,
                                    int64_t* partition)
 {
@@ -941,8 +1101,7 @@ static void redistribute_blockmesh(blockmesh_t** mesh,
     {
       // Obtain the block index.
       int b = 0;
-      while (block_offsets[b] < p) ++b;
-      --b;
+      while (block_offsets[b+1] <= p) ++b;
 
       unimesh_t* block = blockmesh_block(new_mesh, b);
       int npx, npy, npz;
@@ -957,6 +1116,17 @@ static void redistribute_blockmesh(blockmesh_t** mesh,
       unimesh_insert_patch(block, i, j, k);
     }
   }
+  set_patch_owners(new_mesh, partition);
+
+  // Connect the blocks as they were connected in the old mesh. The patches
+  // are already assigned, so we skip the initial assignment.
+  new_mesh->started_connecting_blocks = true;
+  int* connections = old_mesh->connections->data;
+  for (size_t c = 0; c < old_mesh->connections->size/10; ++c)
+  {
+    blockmesh_connect_blocks(new_mesh, connections[10*c], &connections[10*c+1],
+                             connections[10*c+5], &connections[10*c+6]);
+  }
 
   // Replace the old mesh with the new one.
   *mesh = new_mesh;
@@ -1069,6 +1239,7 @@ static void redistribute_blockmesh_field(blockmesh_field_t** field,
 #endif
 
 void repartition_blockmesh(blockmesh_t** mesh,
+                           partitioner_t partitioner,
                            int* weights,
                            real_t imbalance_tol,
                            blockmesh_field_t** fields,
@@ -1090,16 +1261,22 @@ void repartition_blockmesh(blockmesh_t** mesh,
     return;
   }
 
-  // Generate a global adjacency graph for the mesh.
-  adj_graph_t* graph = graph_from_blocks(old_mesh);
-
-  // Map the graph to the different domains, producing a partition vector.
-  // We need the partition vector on all processes, so we scatter it
-  // from rank 0.
+  // Produce a partition vector for the mesh. We need the partition vector
+  // on all processes.
   log_debug("repartition_blockmesh: Repartitioning mesh on %d subdomains.",
             old_mesh->nproc);
-  int64_t* partition = partition_graph(graph, old_mesh->comm, weights,
-                                       imbalance_tol, true);
+  int64_t* partition;
+  if (partitioner == GRAPH_PARTITIONER)
+  {
+    // Generate a global adjacency graph for the mesh and map it to the
+    // different domains on rank 0, which scatters the result.
+    adj_graph_t* graph = graph_from_blocks(old_mesh);
+    partition = partition_graph(graph, old_mesh->comm, weights,
+                                imbalance_tol, true);
+    adj_graph_free(graph);
+  }
+  else
+    partition = curve_partition(old_mesh, partitioner, weights);
 
   // Redistribute the mesh.
   log_debug("repartition_blockmesh: Redistributing mesh.");
@@ -1125,7 +1302,6 @@ void repartition_blockmesh(blockmesh_t** mesh,
 
   // Clean up.
   blockmesh_free(old_mesh);
-  adj_graph_free(graph);
   polymec_free(sources);
   polymec_free(partition);
 
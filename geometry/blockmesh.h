@@ -212,6 +212,9 @@ typedef struct blockmesh_field_t blockmesh_field_t;
 /// given fields.
 /// \param [inout] mesh A pointer that stores the old mesh, which is consumed
 ///                     and replaced with the repartitioned mesh.
+/// \param [in] partitioner The algorithm used to partition the patches (see
+///                         \ref repartition_unimesh). The space-filling curve
+///                         partitioners order the patches block by block.
 /// \param [in] weights If non-NULL, this is an array containing an integer
 ///                     weight for each locally-stored patch within the
 ///                     blockmesh. The weights can be assigned with a nested
@@ -229,6 +232,7 @@ typedef struct blockmesh_field_t blockmesh_field_t;
 /// \relates blockmesh
 /// \collective Collective on mesh's communicator.
 void repartition_blockmesh(blockmesh_t** mesh,
+                           partitioner_t partitioner,
                            int* weights,
                            real_t imbalance_tol,
                            blockmesh_field_t** fields,
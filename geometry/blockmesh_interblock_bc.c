@@ -31,8 +31,282 @@ static inline int boundary_index(blockmesh_t* mesh,
   return 6*(npx*npy*npz*block_index + npy*npz*i + npz*j + k) + (int)boundary;
 }
 
-// Mapping of boundary update tokens -> blob buffers
-DEFINE_UNORDERED_MAP(blob_buffer_map, int, blob_buffer_t*, int_hash, int_equals)
+// An inter-block update exchanges the boundary values of a field across all
+// of the blocks in which this process has connections. Every block gathers
+// its values into the update's buffer, and the exchange starts once all of
+// them have done so.
+typedef struct
+{
+  blob_buffer_t* buffer;
+  int num_started, num_gathered, num_finished;
+  int token; // exchanger token, or -1 if the exchange hasn't started
+} ibc_update_t;
+
+// Mapping of update IDs -> updates
+DEFINE_UNORDERED_MAP(ibc_update_map, int, ibc_update_t*, int_hash, int_equals)
+
+// This table indicates whether values of each centering sit on nodes along
+// each axis.
+static const int on_nodes[8][3] = {{0, 0, 0},  // cells
+                                   {1, 0, 0},  // x faces
+                                   {0, 1, 0},  // y faces
+                                   {0, 0, 1},  // z faces
+                                   {0, 1, 1},  // x edges
+                                   {1, 0, 1},  // y edges
+                                   {1, 1, 0},  // z edges
+                                   {1, 1, 1}}; // nodes
+
+// A transfer plan lists the (component-free) indices within patch storage
+// of the values that are gathered into a blob or scattered out of one, in
+// the order in which they appear in the blob. A plan depends only on the
+// patch size, the centering of the data, the boundaries on either side of
+// a connection, and the rotation between them, so connections with the
+// same geometry share plans. A plan is inexact (and empty) if the values on
+// the near boundary don't correspond one-to-one with those of the same
+// centering on the far boundary.
+typedef struct
+{
+  int size;
+  int* indices;
+  bool exact;
+} transfer_plan_t;
+
+// This describes the values on a patch boundary that take part in a
+// transfer: the storage index of the first value, the numbers of values
+// along the two transverse axes, and the storage strides along those axes.
+typedef struct
+{
+  int origin;
+  int n1, n2;
+  int stride1, stride2;
+} boundary_layout_t;
+
+// Returns the transverse axes for a boundary with the given normal axis,
+// which form a right-handed coordinate system with the normal axis. These
+// are the axes along which blockmesh matches up patches on either side of a
+// connection.
+static inline void get_transverse_axes(int normal, int* t1, int* t2)
+{
+  *t1 = (normal + 1) % 3;
+  *t2 = (normal + 2) % 3;
+}
+
+// Computes the layout of the values of the given centering on the given
+// boundary of a patch with the given size. For cells, these are the interior
+// cells next to the boundary, or the ghost cells just outside it if ghosts is
+// true. For other centerings, these are the values on the boundary itself,
+// and there are none if the centering has no values there.
+static void get_boundary_layout(int nx, int ny, int nz,
+                                unimesh_centering_t centering,
+                                unimesh_boundary_t boundary,
+                                bool ghosts,
+                                boundary_layout_t* layout)
+{
+  int cent = (int)centering;
+  int n[3] = {nx, ny, nz}, N[3];
+  for (int d = 0; d < 3; ++d)
+    N[d] = (centering == UNIMESH_CELL) ? n[d] + 2 : n[d] + on_nodes[cent][d];
+  int strides[3] = {N[1]*N[2], N[2], 1};
+
+  // Figure out the normal and transverse axes for the boundary.
+  int d = (int)boundary / 2, t1, t2;
+  get_transverse_axes(d, &t1, &t2);
+  bool lower = (((int)boundary % 2) == 0);
+  layout->stride1 = strides[t1];
+  layout->stride2 = strides[t2];
+  if (centering == UNIMESH_CELL)
+  {
+    int layer = lower ? 1 : n[d];
+    if (ghosts)
+      layer += lower ? -1 : 1;
+    layout->origin = layer * strides[d] + strides[t1] + strides[t2];
+    layout->n1 = n[t1];
+    layout->n2 = n[t2];
+  }
+  else if (on_nodes[cent][d])
+  {
+    int layer = lower ? 0 : n[d];
+    layout->origin = layer * strides[d];
+    layout->n1 = N[t1];
+    layout->n2 = N[t2];
+  }
+  else
+  {
+    layout->origin = 0;
+    layout->n1 = layout->n2 = 0;
+  }
+}
+
+// Returns true if values of the given centering on boundary1 of a near
+// patch map one-to-one onto values of the same centering on boundary2 of a
+// far patch under the given rotation, false if not. This is the case when
+// the values sit on nodes along exactly the same axes on both sides of the
+// connection. Under quarter turns, for example, edges that lie within the
+// boundary become edges of the other orientation, which are stored in a
+// different field, so they can't be transferred.
+static bool transfer_is_exact(unimesh_centering_t centering,
+                              unimesh_boundary_t boundary1,
+                              int rotation,
+                              unimesh_boundary_t boundary2)
+{
+  int cent = (int)centering;
+  int d1 = (int)boundary1 / 2, d2 = (int)boundary2 / 2;
+
+  // If neither boundary has values of this centering, there's nothing to
+  // transfer.
+  if ((centering != UNIMESH_CELL) && !on_nodes[cent][d1] && !on_nodes[cent][d2])
+    return true;
+
+  int a1, b1, a2, b2;
+  get_transverse_axes(d1, &a1, &b1);
+  get_transverse_axes(d2, &a2, &b2);
+
+  // Quarter turns exchange the transverse axes.
+  if ((rotation % 2) == 1)
+  {
+    int tmp = a2;
+    a2 = b2;
+    b2 = tmp;
+  }
+  return ((on_nodes[cent][d1] == on_nodes[cent][d2]) &&
+          (on_nodes[cent][a1] == on_nodes[cent][a2]) &&
+          (on_nodes[cent][b1] == on_nodes[cent][b2]));
+}
+
+// Creates a transfer plan for values of the given centering across a
+// connection between boundary1 of a near patch and boundary2 of a far patch,
+// with the given number of counterclockwise rotations between them. A send
+// plan gathers the near patch's boundary values in the order in which the
+// far patch expects them, and a receive plan scatters the values received
+// from the far patch into the near patch. The plan is empty if either
+// boundary has no values of this centering, or if the transfer isn't exact.
+static transfer_plan_t* transfer_plan_new(int nx, int ny, int nz,
+                                          unimesh_centering_t centering,
+                                          unimesh_boundary_t boundary1,
+                                          int rotation,
+                                          unimesh_boundary_t boundary2,
+                                          bool send)
+{
+  boundary_layout_t L1, L2;
+  get_boundary_layout(nx, ny, nz, centering, boundary1, !send, &L1);
+  get_boundary_layout(nx, ny, nz, centering, boundary2, false, &L2);
+
+  transfer_plan_t* plan = polymec_malloc(sizeof(transfer_plan_t));
+  plan->exact = transfer_is_exact(centering, boundary1, rotation, boundary2);
+  if (!plan->exact || (L1.n1 == 0))
+  {
+    plan->size = 0;
+    plan->indices = NULL;
+  }
+  else if (send)
+  {
+    // Each value (a, b) on the near boundary lands in position (p, q) on
+    // the far boundary. We invert this rotation so we can traverse the far
+    // boundary in order. These rotations match the ones blockmesh uses to
+    // match up patches.
+    int n1 = L1.n1, n2 = L1.n2;
+    ASSERT(((rotation % 2) == 0) ? ((L2.n1 == n1) && (L2.n2 == n2))
+                                 : ((L2.n1 == n2) && (L2.n2 == n1)));
+    plan->size = L2.n1 * L2.n2;
+    plan->indices = polymec_malloc(sizeof(int) * plan->size);
+    for (int p = 0; p < L2.n1; ++p)
+    {
+      for (int q = 0; q < L2.n2; ++q)
+      {
+        int a, b;
+        if (rotation == 0) // no rotation
+        {
+          a = p;
+          b = q;
+        }
+        else if (rotation == 1) // quarter turn
+        {
+          a = q;
+          b = n2-1-p;
+        }
+        else if (rotation == 2) // half turn
+        {
+          a = n1-1-p;
+          b = n2-1-q;
+        }
+        else // three-quarters turn
+        {
+          a = n1-1-q;
+          b = p;
+        }
+        plan->indices[L2.n2*p+q] = L1.origin + a*L1.stride1 + b*L1.stride2;
+      }
+    }
+  }
+  else
+  {
+    // Received values are already in our frame.
+    plan->size = L1.n1 * L1.n2;
+    plan->indices = polymec_malloc(sizeof(int) * plan->size);
+    for (int a = 0; a < L1.n1; ++a)
+      for (int b = 0; b < L1.n2; ++b)
+        plan->indices[L1.n2*a+b] = L1.origin + a*L1.stride1 + b*L1.stride2;
+  }
+  return plan;
+}
+
+static void transfer_plan_free(transfer_plan_t* plan)
+{
+  if (plan->indices != NULL)
+    polymec_free(plan->indices);
+  polymec_free(plan);
+}
+
+// Gathers values from the given patch directly into a blob using the plan.
+static inline void transfer_plan_gather(transfer_plan_t* plan,
+                                        unimesh_patch_t* patch,
+                                        real_t* blob)
+{
+  int nc = patch->nc;
+  real_t* data = patch->data;
+  int* indices = plan->indices;
+  if (nc == 1)
+  {
+    for (int l = 0; l < plan->size; ++l)
+      blob[l] = data[indices[l]];
+  }
+  else
+  {
+    for (int l = 0; l < plan->size; ++l)
+    {
+      real_t* values = &data[nc*indices[l]];
+      for (int c = 0; c < nc; ++c)
+        blob[nc*l+c] = values[c];
+    }
+  }
+}
+
+// Scatters values from a blob directly into the given patch using the plan.
+static inline void transfer_plan_scatter(transfer_plan_t* plan,
+                                         real_t* blob,
+                                         unimesh_patch_t* patch)
+{
+  int nc = patch->nc;
+  real_t* data = patch->data;
+  int* indices = plan->indices;
+  if (nc == 1)
+  {
+    for (int l = 0; l < plan->size; ++l)
+      data[indices[l]] = blob[l];
+  }
+  else
+  {
+    for (int l = 0; l < plan->size; ++l)
+    {
+      real_t* values = &data[nc*indices[l]];
+      for (int c = 0; c < nc; ++c)
+        values[c] = blob[nc*l+c];
+    }
+  }
+}
+
+// Mapping of plan keys -> transfer plans
+DEFINE_UNORDERED_MAP(transfer_plan_map, int, transfer_plan_t*, int_hash, int_equals)
 
 // A connection (cxn) is just a set of metadata for two patches connected
 // across a block boundary.
@@ -53,16 +327,18 @@ typedef struct
   unimesh_boundary_t boundary2;
   int proc2;
 
-  // Canonically ordered boundary endpoints for all centerings.
-  int lo1[8], hi1[8], lo2[8], hi2[8];
+  // Transfer plans for all centerings (borrowed from the BC). A send plan
+  // gathers values from the near patch into a blob in the far patch's
+  // frame, and a receive plan scatters a received blob into the near patch.
+  transfer_plan_t* send_plans[8];
+  transfer_plan_t* recv_plans[8];
 } cxn_t;
 
 // Mapping of boundary indices -> connections
 DEFINE_UNORDERED_MAP(cxn_map, int, cxn_t*, int_hash, int_equals)
 
 // Constructor and destructor.
-static cxn_t* cxn_new(blockmesh_interblock_bc_t* bc,
-                      unimesh_t* block1, unimesh_boundary_t block1_boundary,
+static cxn_t* cxn_new(unimesh_t* block1, unimesh_boundary_t block1_boundary,
                       int i1, int j1, int k1, int rotation,
                       unimesh_t* block2, unimesh_boundary_t block2_boundary,
                       int i2, int j2, int k2);
@@ -82,17 +358,66 @@ struct blockmesh_interblock_bc_t
   // Neighbors of each block.
   int_array_t* block_neighbors;
 
+  // Transfer plans shared by connections, compiled on finalization.
+  transfer_plan_map_t* plans;
+
   // Blob exchangers for all centerings
   blob_exchanger_t* ex[8];
 
-  // Mapping of exchange tokens to buffers (segregated by centering).
-  blob_buffer_map_t* ex_buffers[8];
+  // The number of blocks in which this process has connections.
+  int num_blocks;
+
+  // Updates in progress, keyed by ID (segregated by centering), the ID of
+  // the update gathering boundary values (or -1), and the next update ID.
+  ibc_update_map_t* updates[8];
+  int gathering_update[8];
+  int next_update[8];
+
+  // Buffers left over from finished updates, which we reuse.
+  ptr_array_t* free_buffers[8];
 
-  // This is a token bank mapping unimesh tokens to blockmesh tokens.
+  // This is a token bank mapping unimesh tokens to update IDs.
   // In a perfect world, we wouldn't need this.
   int_int_unordered_map_t* ex_tokens[8];
 };
 
+// Fetches the update associated with the given unimesh token on a block.
+static ibc_update_t* ibc_update(blockmesh_interblock_bc_t* ibc,
+                                unimesh_t* block, int token,
+                                unimesh_centering_t centering)
+{
+  int c = (int)centering;
+  int block_index = blockmesh_block_index(ibc->mesh, block);
+  int bm_token = block_index * 100 + token;
+  int* id_p = int_int_unordered_map_get(ibc->ex_tokens[c], bm_token);
+  if (id_p == NULL)
+    return NULL;
+  return *ibc_update_map_get(ibc->updates[c], *id_p);
+}
+
+// Retrieves (compiling if necessary) the transfer plan for the given
+// centering, boundaries, and rotation.
+static transfer_plan_t* get_transfer_plan(blockmesh_interblock_bc_t* bc,
+                                          unimesh_centering_t centering,
+                                          unimesh_boundary_t boundary1,
+                                          int rotation,
+                                          unimesh_boundary_t boundary2,
+                                          bool send)
+{
+  int key = 2 * (6 * (4 * (6 * (int)centering + (int)boundary1) + rotation) +
+                 (int)boundary2) + (send ? 1 : 0);
+  transfer_plan_t** plan_p = transfer_plan_map_get(bc->plans, key);
+  if (plan_p != NULL)
+    return *plan_p;
+
+  int nx, ny, nz;
+  blockmesh_get_patch_size(bc->mesh, &nx, &ny, &nz);
+  transfer_plan_t* plan = transfer_plan_new(nx, ny, nz, centering, boundary1,
+                                            rotation, boundary2, send);
+  transfer_plan_map_insert_with_v_dtor(bc->plans, key, plan, transfer_plan_free);
+  return plan;
+}
+
 static void ibc_start_update(void* context, unimesh_t* block,
                              int i, int j, int k, real_t t,
                              unimesh_boundary_t boundary,
@@ -113,8 +438,8 @@ static void ibc_finish_update(void* context, unimesh_t* block,
 }
 
 // This observer method is called when a field starts a set of boundary
-// updates on a block. We use it to initialize a blob buffer to store
-// the exchanged data.
+// updates on a block. The first block to do so creates a new update with a
+// blob buffer that stores the exchanged data for all blocks.
 static void ibc_started_boundary_updates(void* context,
                                          unimesh_t* block, int token,
                                          unimesh_centering_t centering,
@@ -123,74 +448,47 @@ static void ibc_started_boundary_updates(void* context,
   blockmesh_interblock_bc_t* ibc = context;
   int c = (int)centering;
 
-  // Create the buffer for this token if it doesn't yet exist.
-  int block_index = blockmesh_block_index(ibc->mesh, block);
-  int bm_token = block_index * 100 + token;
-  blob_buffer_t** buffer_p = blob_buffer_map_get(ibc->ex_buffers[c], bm_token);
-  blob_buffer_t* buffer;
-  if (buffer_p == NULL)
+  // Start a new update if we're not already gathering values for one.
+  int id = ibc->gathering_update[c];
+  ibc_update_t* update;
+  if (id == -1)
   {
-    buffer = blob_exchanger_create_buffer(ibc->ex[c], num_components);
-    blob_buffer_map_insert_with_v_dtor(ibc->ex_buffers[c], bm_token, buffer,
-                                       blob_buffer_free);
-  }
-  else
-    buffer = *buffer_p;
-}
-
-// This helper performs the given number of counterclockwise rotations
-// on the given boundary values, placing the results in rotated_boundary_values.
-static void rotate_boundary_values(cxn_t* cxn,
-                                   field_metadata_t* md,
-                                   unimesh_centering_t centering,
-                                   void* boundary_values,
-                                   void* rotated_boundary_values)
-{
-  int cent = (int)centering;
-  int lo1 = cxn->lo1[cent], hi1 = cxn->hi1[cent];
-  int n1 = hi1 - lo1 + 1;
-  int lo2 = cxn->lo2[cent], hi2 = cxn->hi2[cent];
-  int n2 = hi2 - lo2 + 1;
-  int nc = field_metadata_num_components(md);
-  int rotation = cxn->rotation;
-  if (rotation == 0) // no rotation
-    memcpy(rotated_boundary_values, boundary_values, sizeof(real_t)*n1*n2*nc);
-  else
-  {
-    DECLARE_3D_ARRAY(real_t, bv, boundary_values, n1, n2, nc);
-    DECLARE_3D_ARRAY(real_t, rbv, rotated_boundary_values, n1, n2, nc);
-    if (rotation == 1) // quarter turn
-    {
-      for (int i = lo1; i <= hi1; ++i)
-        for (int j = lo2; j <= hi2; ++j)
-          for (int c = 0; c < nc; ++c)
-            rbv[j][hi1-i][c] = bv[i][j][c];
-    }
-    else if (rotation == 2) // half turn
+    id = ibc->next_update[c];
+    ibc->next_update[c] = (id + 1) % 4096;
+    ibc->gathering_update[c] = id;
+    ASSERT(!ibc_update_map_contains(ibc->updates[c], id));
+
+    update = polymec_malloc(sizeof(ibc_update_t));
+    update->buffer = NULL;
+    for (size_t b = 0; b < ibc->free_buffers[c]->size; ++b)
     {
-      for (int i = lo1; i <= hi1; ++i)
-        for (int j = lo2; j <= hi2; ++j)
-          for (int c = 0; c < nc; ++c)
-            rbv[hi1-i][hi2-j][c] = bv[i][j][c];
-    }
-    else // three-quarters turn
-    {
-      for (int i = lo1; i <= hi1; ++i)
-        for (int j = lo2; j <= hi2; ++j)
-          for (int c = 0; c < nc; ++c)
-            rbv[hi2-j][i][c] = bv[i][j][c];
+      blob_buffer_t* buffer = ibc->free_buffers[c]->data[b];
+      if (blob_buffer_size_factor(buffer) == num_components)
+      {
+        update->buffer = buffer;
+        ptr_array_remove(ibc->free_buffers[c], b);
+        break;
+      }
     }
+    if (update->buffer == NULL)
+      update->buffer = blob_exchanger_create_buffer(ibc->ex[c], num_components);
+    update->num_started = update->num_gathered = update->num_finished = 0;
+    update->token = -1;
+    ibc_update_map_insert(ibc->updates[c], id, update);
   }
-}
+  else
+    update = *ibc_update_map_get(ibc->updates[c], id);
+  ASSERT(blob_buffer_size_factor(update->buffer) == num_components);
+  ++update->num_started;
 
-// This helper copies boundary values out of a patch and into a buffer.
-extern void unimesh_patch_copy_bvalues_to_buffer(unimesh_patch_t* patch,
-                                                 unimesh_boundary_t boundary,
-                                                 void* buffer);
+  int block_index = blockmesh_block_index(ibc->mesh, block);
+  int bm_token = block_index * 100 + token;
+  int_int_unordered_map_insert(ibc->ex_tokens[c], bm_token, id);
+}
 
 // This observer method is called after the boundary update has been started
-// for each patch on a block boundary. We use it to copy boundary values from
-// the patch to our blob buffer.
+// for each patch on a block boundary. We use it to gather boundary values
+// from the patch directly into our blob buffer, in the far patch's frame.
 static void ibc_started_boundary_update(void* context,
                                         unimesh_t* block, int token,
                                         int i, int j, int k,
@@ -209,27 +507,39 @@ static void ibc_started_boundary_update(void* context,
   if (cxn_p == NULL)
     return;
 
+  // If there are no values to send for this centering, we're done.
   cxn_t* cxn = *cxn_p;
-
-  // Extract the boundary values from the patch.
   int c = (int)patch->centering;
-  size_t boundary_size = patch->nc * blob_exchanger_blob_size(ibc->ex[c], b_index);
-  char bvalues[boundary_size];
-  unimesh_patch_copy_bvalues_to_buffer(patch, boundary, bvalues);
-
-  // Now rotate the boundary values.
-  char rot_bvalues[boundary_size];
-  rotate_boundary_values(cxn, md, patch->centering, bvalues, rot_bvalues);
+  transfer_plan_t* plan = cxn->send_plans[c];
+  if (!plan->exact)
+  {
+    static const char* centering_names[8] = {"cell", "x-face", "y-face",
+                                             "z-face", "x-edge", "y-edge",
+                                             "z-edge", "node"};
+    static const char* boundary_names[6] = {"-x", "+x", "-y", "+y", "-z", "+z"};
+    polymec_error("blockmesh_interblock_bc: %s values can't be transferred "
+                  "from the %s boundary of block %d to the %s boundary of "
+                  "block %d with %d quarter turn(s).", centering_names[c],
+                  boundary_names[cxn->boundary1],
+                  blockmesh_block_index(ibc->mesh, cxn->block1),
+                  boundary_names[cxn->boundary2],
+                  blockmesh_block_index(ibc->mesh, cxn->block2),
+                  cxn->rotation);
+  }
+  if (plan->size == 0)
+    return;
 
-  // Copy the rotated boundary values to our blob buffer.
-  int block_index = blockmesh_block_index(ibc->mesh, block);
-  int bm_token = block_index * 100 + token;
-  blob_buffer_t* buffer = *blob_buffer_map_get(ibc->ex_buffers[c], bm_token);
-  blob_exchanger_copy_in(ibc->ex[c], b_index, rot_bvalues, buffer);
+  // Gather the boundary values into our blob buffer.
+  ibc_update_t* update = ibc_update(ibc, block, token, patch->centering);
+  real_t* blob = blob_exchanger_send_blob_storage(ibc->ex[c], b_index,
+                                                  update->buffer);
+  ASSERT(blob != NULL);
+  transfer_plan_gather(plan, patch, blob);
 }
 
 // This observer method is called when a field finishes starting a set of
-// boundary updates on the mesh. We use it to begin an exchange.
+// boundary updates on a block. Once every block has gathered its boundary
+// values, we begin the exchange.
 static void ibc_finished_starting_boundary_updates(void* context,
                                                    unimesh_t* block, int token,
                                                    unimesh_centering_t centering,
@@ -238,16 +548,20 @@ static void ibc_finished_starting_boundary_updates(void* context,
   blockmesh_interblock_bc_t* ibc = context;
   int c = (int)centering;
 
-  int block_index = blockmesh_block_index(ibc->mesh, block);
-  int bm_token = block_index * 100 + token;
-  blob_buffer_t* buffer = *blob_buffer_map_get(ibc->ex_buffers[c], bm_token);
-  int token1 = blob_exchanger_start_exchange(ibc->ex[c], bm_token, buffer);
-  int_int_unordered_map_insert(ibc->ex_tokens[c], bm_token, token1);
+  ibc_update_t* update = ibc_update(ibc, block, token, centering);
+  ++update->num_gathered;
+  if (update->num_gathered == ibc->num_blocks)
+  {
+    int id = ibc->gathering_update[c];
+    update->token = blob_exchanger_start_exchange(ibc->ex[c], 8*id + c,
+                                                  update->buffer);
+    ibc->gathering_update[c] = -1;
+  }
 }
 
 // This observer method is called right before a intermesh boundary update is
-// finished for a particular patch. We use it to wait for messages to be
-// received for a given process.
+// finished for a particular block. We use it to wait for messages to be
+// received for the update.
 static void ibc_about_to_finish_boundary_updates(void* context,
                                                  unimesh_t* block,
                                                  int token,
@@ -257,28 +571,24 @@ static void ibc_about_to_finish_boundary_updates(void* context,
   blockmesh_interblock_bc_t* ibc = context;
   int c = (int)centering;
 
-  // Fetch the token and finish the exchange.
-  int block_index = blockmesh_block_index(ibc->mesh, block);
-  int bm_token = block_index * 100 + token;
-  int* token1_p = int_int_unordered_map_get(ibc->ex_tokens[c], bm_token);
-  if (token1_p == NULL)
+  // Finish the exchange if we haven't already.
+  ibc_update_t* update = ibc_update(ibc, block, token, centering);
+  if ((update == NULL) || (update->num_gathered < ibc->num_blocks))
   {
     polymec_error("Block boundary exchange failed with invalid token. "
                   "Are you calling unimesh_field_exchange on an individual "
                   "mesh block?");
   }
-  int token1 = *token1_p;
-  blob_exchanger_finish_exchange(ibc->ex[c], token1);
+  if (update->token != -1)
+  {
+    blob_exchanger_finish_exchange(ibc->ex[c], update->token);
+    update->token = -1;
+  }
 }
 
-// This helper copies boundary values into a patch from a buffer.
-extern void unimesh_patch_copy_bvalues_from_buffer(unimesh_patch_t* patch,
-                                                   unimesh_boundary_t boundary,
-                                                   void* buffer);
-
 // This observer function gets called right before the boundary updates
-// for all patches finish. We use it to extract the boundary values from
-// the blob buffer and place them back into the patch.
+// for all patches finish. We use it to scatter the boundary values in the
+// blob buffer directly into the patch.
 static void ibc_about_to_finish_boundary_update(void* context,
                                                 unimesh_t* block,
                                                 int token,
@@ -298,20 +608,48 @@ static void ibc_about_to_finish_boundary_update(void* context,
   if (cxn_p == NULL)
     return;
 
-  // Extract the boundary values from the blob buffer.
+  // If there are no values to receive for this centering, we're done.
+  cxn_t* cxn = *cxn_p;
   int c = (int)patch->centering;
-  size_t boundary_size = patch->nc * blob_exchanger_blob_size(ibc->ex[c], b_index);
-  char bvalues[boundary_size];
+  transfer_plan_t* plan = cxn->recv_plans[c];
+  if (plan->size > 0)
+  {
+    // Scatter the boundary values from the blob buffer into the patch.
+    ibc_update_t* update = ibc_update(ibc, block, token, patch->centering);
+    int b2_index = boundary_index(ibc->mesh, cxn->block2,
+                                  cxn->i2, cxn->j2, cxn->k2, cxn->boundary2);
+    real_t* blob = blob_exchanger_receive_blob_storage(ibc->ex[c],
+                                                       update->buffer,
+                                                       b2_index);
+    ASSERT(blob != NULL);
+    transfer_plan_scatter(plan, blob, patch);
+  }
+}
+
+// This observer function gets called when the boundary updates for a block
+// have finished. Once every block has finished, we retire the update and
+// keep its buffer for later.
+static void ibc_finished_boundary_updates(void* context,
+                                          unimesh_t* block,
+                                          int token,
+                                          unimesh_centering_t centering,
+                                          int num_components)
+{
+  blockmesh_interblock_bc_t* ibc = context;
+  int c = (int)centering;
+
   int block_index = blockmesh_block_index(ibc->mesh, block);
   int bm_token = block_index * 100 + token;
-  blob_buffer_t* buffer = *blob_buffer_map_get(ibc->ex_buffers[c], bm_token);
-  blob_exchanger_copy_out(ibc->ex[c], buffer, b_index, bvalues);
-
-  // Destroy the buffer associated with this exchange.
+  int id = *int_int_unordered_map_get(ibc->ex_tokens[c], bm_token);
   int_int_unordered_map_delete(ibc->ex_tokens[c], bm_token);
-
-  // Copy the boundary values back into the patch.
-  unimesh_patch_copy_bvalues_from_buffer(patch, boundary, bvalues);
+  ibc_update_t* update = *ibc_update_map_get(ibc->updates[c], id);
+  ++update->num_finished;
+  if (update->num_finished == ibc->num_blocks)
+  {
+    ptr_array_append(ibc->free_buffers[c], update->buffer);
+    ibc_update_map_delete(ibc->updates[c], id);
+    polymec_free(update);
+  }
 }
 
 //------------------------------------------------------------------------
@@ -323,10 +661,13 @@ blockmesh_interblock_bc_t* blockmesh_interblock_bc_new(blockmesh_t* mesh)
   blockmesh_interblock_bc_t* bc = polymec_malloc(sizeof(blockmesh_interblock_bc_t));
   bc->mesh = mesh;
   memset(bc->ex, 0, sizeof(blob_exchanger_t*)*8);
-  memset(bc->ex_buffers, 0, sizeof(ptr_array_t*)*8);
+  memset(bc->updates, 0, sizeof(ibc_update_map_t*)*8);
+  memset(bc->free_buffers, 0, sizeof(ptr_array_t*)*8);
   memset(bc->ex_tokens, 0, sizeof(int_int_unordered_map_t*)*8);
+  bc->num_blocks = 0;
   bc->cxns = cxn_map_new();
   bc->block_neighbors = int_array_new();
+  bc->plans = transfer_plan_map_new();
   return bc;
 }
 
@@ -334,12 +675,28 @@ void blockmesh_interblock_bc_free(blockmesh_interblock_bc_t* bc)
 {
   int_array_free(bc->block_neighbors);
   cxn_map_free(bc->cxns);
+  transfer_plan_map_free(bc->plans);
   for (int c = 0; c < 8; ++c)
   {
     if (bc->ex[c] != NULL)
       release_ref(bc->ex[c]);
-    if (bc->ex_buffers[c] != NULL)
-      blob_buffer_map_free(bc->ex_buffers[c]);
+    if (bc->updates[c] != NULL)
+    {
+      int pos = 0, id;
+      ibc_update_t* update;
+      while (ibc_update_map_next(bc->updates[c], &pos, &id, &update))
+      {
+        blob_buffer_free(update->buffer);
+        polymec_free(update);
+      }
+      ibc_update_map_free(bc->updates[c]);
+    }
+    if (bc->free_buffers[c] != NULL)
+    {
+      for (size_t b = 0; b < bc->free_buffers[c]->size; ++b)
+        blob_buffer_free(bc->free_buffers[c]->data[b]);
+      ptr_array_free(bc->free_buffers[c]);
+    }
     if (bc->ex_tokens[c] != NULL)
       int_int_unordered_map_free(bc->ex_tokens[c]);
   }
@@ -374,8 +731,8 @@ void blockmesh_interblock_bc_connect(blockmesh_interblock_bc_t* bc,
 
   // Create a new connection and map it.
   int b_index = boundary_index(bc->mesh, block1, i1, j1, k1, block1_boundary);
-  cxn_t* cxn = cxn_new(bc, block1, block1_boundary, i1, j1, k1, rotation,
-                           block2, block2_boundary, i2, j2, k2);
+  cxn_t* cxn = cxn_new(block1, block1_boundary, i1, j1, k1, rotation,
+                       block2, block2_boundary, i2, j2, k2);
   cxn_map_insert_with_v_dtor(bc->cxns, b_index, cxn, cxn_free);
 }
 
@@ -387,48 +744,17 @@ static blob_exchanger_t* interblock_exchanger_new(blockmesh_t* mesh,
   blob_exchanger_proc_map_t* recv_map = blob_exchanger_proc_map_new();
   blob_exchanger_size_map_t* blob_sizes = blob_exchanger_size_map_new();
 
-  // Get the dimensions of the patch boundaries. These are our blob sizes.
-  int nx, ny, nz;
-  blockmesh_get_patch_size(mesh, &nx, &ny, &nz);
-  size_t boundary_sizes[8][6] =  { // cells (including ghosts for simplicity)
-                                  {(ny+2)*(nz+2), (ny+2)*(nz+2),
-                                   (nx+2)*(nz+2), (nx+2)*(nz+2),
-                                   (nx+2)*(ny+2), (nx+2)*(ny+2)},
-                                   // x faces
-                                  {ny*nz, ny*nz,
-                                   (nx+1)*nz, (nx+1)*nz,
-                                   (nx+1)*ny, (nx+1)*ny},
-                                   // y faces
-                                  {(ny+1)*nz, (ny+1)*nz,
-                                   nx*nz, nx*nz,
-                                   nx*(ny+1), nx*(ny+1)},
-                                   // z faces
-                                  {ny*(nz+1), ny*(nz+1),
-                                   nx*(nz+1), nx*(nz+1),
-                                   nx*ny, nx*ny},
-                                   // x edges
-                                  {(ny+1)*(nz+1), (ny+1)*(nz+1),
-                                   nx*(nz+1), nx*(nz+1),
-                                   nx*(ny+1), nx*(ny+1)},
-                                   // y edges
-                                  {ny*(nz+1), ny*(nz+1),
-                                   (nx+1)*(nz+1), (nx+1)*(nz+1),
-                                   (nx+1)*ny, (nx+1)*ny},
-                                   // z edges
-                                  {(ny+1)*nz, (ny+1)*nz,
-                                   (nx+1)*nz, (nx+1)*nz,
-                                   (nx+1)*(ny+1), (nx+1)*(ny+1)},
-                                   // nodes
-                                  {(ny+1)*(nz+1), (ny+1)*(nz+1),
-                                   (nx+1)*(nz+1), (nx+1)*(nz+1),
-                                   (nx+1)*(ny+1), (nx+1)*(ny+1)}};
-
   int pos = 0, b1_index;
   cxn_t* cxn;
   while (cxn_map_next(cxns, &pos, &b1_index, &cxn))
   {
     ASSERT(cxn->proc2 >= 0);
 
+    // Skip connections that don't transfer values of this centering.
+    int c = (int)centering;
+    if (cxn->send_plans[c]->size == 0)
+      continue;
+
     // b1_index is the patch boundary index for the near boundary in the
     // connection. Let's map it to a send blob.
     blob_exchanger_proc_map_add_index(send_map, cxn->proc2, b1_index);
@@ -439,13 +765,23 @@ static blob_exchanger_t* interblock_exchanger_new(blockmesh_t* mesh,
                                   cxn->boundary2);
     blob_exchanger_proc_map_add_index(recv_map, cxn->proc2, b2_index);
 
-    // Compute boundary sizes and map them too.
-    size_t b1_size = sizeof(real_t) * boundary_sizes[(int)centering][(int)cxn->boundary1];
+    // Our blob sizes are given by our transfer plans.
+    size_t b1_size = sizeof(real_t) * cxn->send_plans[c]->size;
     blob_exchanger_size_map_insert(blob_sizes, b1_index, b1_size);
-    size_t b2_size = sizeof(real_t) * boundary_sizes[(int)centering][(int)cxn->boundary2];
+    size_t b2_size = sizeof(real_t) * cxn->recv_plans[c]->size;
     blob_exchanger_size_map_insert(blob_sizes, b2_index, b2_size);
   }
 
+  // A blob's index is the index of the boundary that sends it, so sorting
+  // the blobs for each process puts them in the same order on both ends.
+  int pos1 = 0, proc;
+  int_array_t* indices;
+  while (blob_exchanger_proc_map_next(send_map, &pos1, &proc, &indices))
+    int_qsort(indices->data, indices->size);
+  pos1 = 0;
+  while (blob_exchanger_proc_map_next(recv_map, &pos1, &proc, &indices))
+    int_qsort(indices->data, indices->size);
+
   MPI_Comm comm = blockmesh_comm(mesh);
   return blob_exchanger_new(comm, send_map, recv_map, blob_sizes);
 }
@@ -480,7 +816,8 @@ void blockmesh_interblock_bc_finalize(blockmesh_interblock_bc_t* bc)
     .started_boundary_update = ibc_started_boundary_update,
     .finished_starting_boundary_updates = ibc_finished_starting_boundary_updates,
     .about_to_finish_boundary_updates = ibc_about_to_finish_boundary_updates,
-    .about_to_finish_boundary_update = ibc_about_to_finish_boundary_update
+    .about_to_finish_boundary_update = ibc_about_to_finish_boundary_update,
+    .finished_boundary_updates = ibc_finished_boundary_updates
   };
 
   int pos = 0, index;
@@ -501,6 +838,7 @@ void blockmesh_interblock_bc_finalize(blockmesh_interblock_bc_t* bc)
       // Register an observer on the block.
       unimesh_observer_t* obs = unimesh_observer_new(bc, obs_vtable);
       unimesh_add_observer(cxn->block1, obs);
+      ++bc->num_blocks;
     }
     else
       patch_bc = patch_bcs[block1_index];
@@ -628,16 +966,37 @@ void blockmesh_interblock_bc_finalize(blockmesh_interblock_bc_t* bc)
     }
   }
 
+  // Compile transfer plans for our connections, which move boundary values
+  // straight between patches and blob buffers.
+  pos = 0;
+  while (cxn_map_next(bc->cxns, &pos, &index, &cxn))
+  {
+    for (int c = 0; c < 8; ++c)
+    {
+      unimesh_centering_t centering = (unimesh_centering_t)c;
+      cxn->send_plans[c] = get_transfer_plan(bc, centering, cxn->boundary1,
+                                             cxn->rotation, cxn->boundary2,
+                                             true);
+      cxn->recv_plans[c] = get_transfer_plan(bc, centering, cxn->boundary1,
+                                             cxn->rotation, cxn->boundary2,
+                                             false);
+    }
+  }
+  log_debug("blockmesh_interblock_bc: Compiled %d transfer plans for %d "
+            "connections.", bc->plans->size, bc->cxns->size);
+
   // Create the exchanger for our connections for each of our centerings,
   // plus a list of buffers.
   for (int c = 0; c < 8; ++c)
   {
     unimesh_centering_t centering = (unimesh_centering_t)c;
     bc->ex[c] = interblock_exchanger_new(bc->mesh, bc->cxns, centering);
-    bc->ex_buffers[c] = blob_buffer_map_new();
+    bc->updates[c] = ibc_update_map_new();
+    bc->gathering_update[c] = -1;
+    bc->next_update[c] = 0;
+    bc->free_buffers[c] = ptr_array_new();
     bc->ex_tokens[c] = int_int_unordered_map_new();
   }
-
 }
 
 // This non-public function is used by the blockmesh class to answer queries
@@ -698,8 +1057,7 @@ bool blockmesh_interblock_bc_next_connection(blockmesh_interblock_bc_t* bc,
 //                   Connection class implementation
 //------------------------------------------------------------------------
 
-cxn_t* cxn_new(blockmesh_interblock_bc_t* bc,
-               unimesh_t* block1, unimesh_boundary_t block1_boundary,
+cxn_t* cxn_new(unimesh_t* block1, unimesh_boundary_t block1_boundary,
                int i1, int j1, int k1, int rotation,
                unimesh_t* block2, unimesh_boundary_t block2_boundary,
                int i2, int j2, int k2)
@@ -729,140 +1087,9 @@ cxn_t* cxn_new(blockmesh_interblock_bc_t* bc,
   cxn->k2 = k2;
   cxn->proc2 = -1;
 
-  // Figure out canonical boundary face patch dimensions.
-  int nx, ny, nz;
-  blockmesh_get_patch_size(bc->mesh, &nx, &ny, &nz);
-  switch (block1_boundary)
-  {
-    case UNIMESH_X1_BOUNDARY:
-    case UNIMESH_X2_BOUNDARY:
-      // cells
-      cxn->lo1[0] = 1;
-      cxn->hi1[0] = ny;
-      cxn->lo2[0] = 1;
-      cxn->hi2[0] = nz;
-      // x faces
-      cxn->lo1[1] = 0;
-      cxn->hi1[1] = ny-1;
-      cxn->lo2[1] = 0;
-      cxn->hi2[1] = nz-1;
-      // y faces
-      cxn->lo1[2] = 0;
-      cxn->hi1[2] = ny;
-      cxn->lo2[2] = 0;
-      cxn->hi2[2] = nz-1;
-      // z faces
-      cxn->lo1[3] = 0;
-      cxn->hi1[3] = ny-1;
-      cxn->lo2[3] = 0;
-      cxn->hi2[3] = nz;
-      // x edges
-      cxn->lo1[4] = 0;
-      cxn->hi1[4] = ny;
-      cxn->lo2[4] = 0;
-      cxn->hi2[4] = nz;
-      // y edges
-      cxn->lo1[5] = 0;
-      cxn->hi1[5] = ny-1;
-      cxn->lo2[5] = 0;
-      cxn->hi2[5] = nz;
-      // z edges
-      cxn->lo1[6] = 0;
-      cxn->hi1[6] = ny;
-      cxn->lo2[6] = 0;
-      cxn->hi2[6] = nz-1;
-      // nodes
-      cxn->lo1[7] = 0;
-      cxn->hi1[7] = ny;
-      cxn->lo2[7] = 0;
-      cxn->hi2[7] = nz;
-      break;
-    case UNIMESH_Y1_BOUNDARY:
-    case UNIMESH_Y2_BOUNDARY:
-      // cells
-      cxn->lo1[0] = 1;
-      cxn->hi1[0] = nx;
-      cxn->lo2[0] = 1;
-      cxn->hi2[0] = nz;
-      // x faces
-      cxn->lo1[1] = 0;
-      cxn->hi1[1] = nx;
-      cxn->lo2[1] = 0;
-      cxn->hi2[1] = nz-1;
-      // y faces
-      cxn->lo1[2] = 0;
-      cxn->hi1[2] = nx-1;
-      cxn->lo2[2] = 0;
-      cxn->hi2[2] = nz-1;
-      // z faces
-      cxn->lo1[3] = 0;
-      cxn->hi1[3] = nx-1;
-      cxn->lo2[3] = 0;
-      cxn->hi2[3] = nz;
-      // x edges
-      cxn->lo1[4] = 0;
-      cxn->hi1[4] = nx-1;
-      cxn->lo2[4] = 0;
-      cxn->hi2[4] = nz;
-      // y edges
-      cxn->lo1[5] = 0;
-      cxn->hi1[5] = ny;
-      cxn->lo2[5] = 0;
-      cxn->hi2[5] = nz;
-      // z edges
-      cxn->lo1[6] = 0;
-      cxn->hi1[6] = ny;
-      cxn->lo2[6] = 0;
-      cxn->hi2[6] = nz-1;
-      // nodes
-      cxn->lo1[7] = 0;
-      cxn->hi1[7] = ny;
-      cxn->lo2[7] = 0;
-      cxn->hi2[7] = nz;
-      break;
-    case UNIMESH_Z1_BOUNDARY:
-    case UNIMESH_Z2_BOUNDARY:
-      // cells
-      cxn->lo1[0] = 1;
-      cxn->hi1[0] = nx;
-      cxn->lo2[0] = 1;
-      cxn->hi2[0] = ny;
-      // x faces
-      cxn->lo1[1] = 0;
-      cxn->hi1[1] = nx;
-      cxn->lo2[1] = 0;
-      cxn->hi2[1] = ny-1;
-      // y faces
-      cxn->lo1[2] = 0;
-      cxn->hi1[2] = nx-1;
-      cxn->lo2[2] = 0;
-      cxn->hi2[2] = ny;
-      // z faces
-      cxn->lo1[3] = 0;
-      cxn->hi1[3] = nx-1;
-      cxn->lo2[3] = 0;
-      cxn->hi2[3] = ny-1;
-      // x edges
-      cxn->lo1[4] = 0;
-      cxn->hi1[4] = nx-1;
-      cxn->lo2[4] = 0;
-      cxn->hi2[4] = ny;
-      // y edges
-      cxn->lo1[5] = 0;
-      cxn->hi1[5] = nx;
-      cxn->lo2[5] = 0;
-      cxn->hi2[5] = ny-1;
-      // z edges
-      cxn->lo1[6] = 0;
-      cxn->hi1[6] = nx;
-      cxn->lo2[6] = 0;
-      cxn->hi2[6] = ny;
-      // nodes
-      cxn->lo1[7] = 0;
-      cxn->hi1[7] = nx;
-      cxn->lo2[7] = 0;
-      cxn->hi2[7] = ny;
-  }
+  // Transfer plans are compiled when the BC is finalized.
+  memset(cxn->send_plans, 0, 8*sizeof(transfer_plan_t*));
+  memset(cxn->recv_plans, 0, 8*sizeof(transfer_plan_t*));
 
   return cxn;
 }
@@ -15,6 +15,10 @@
 #include "geometry/colmesh_field.h"
 #include "geometry/polymesh.h"
 
+#if POLYMEC_HAVE_OPENMP
+#include <omp.h>
+#endif
+
 struct colmesh_fragment_t
 {
   planar_polymesh_t* mesh;
@@ -62,6 +66,11 @@ typedef struct
   // Exchanger process maps--used to construct exchangers.
   exchanger_proc_map_t* send_map;       // proc -> (send cell, edge) pairs
   exchanger_proc_map_t* receive_map;    // proc -> (receive cell, edge) pairs
+
+  // Columns (computed on demand), with those that don't neighbor ghost
+  // columns listed first.
+  int* column_partition;
+  int num_interior_columns;
 } chunk_xy_data_t;
 
 DEFINE_ARRAY(chunk_xy_data_array, chunk_xy_data_t*)
@@ -81,6 +90,8 @@ static chunk_xy_data_t* chunk_xy_data_from_partition(MPI_Comm comm,
   xy_data->num_xy_nodes = 0;
   xy_data->send_map = exchanger_proc_map_new();
   xy_data->receive_map = exchanger_proc_map_new();
+  xy_data->column_partition = NULL;
+  xy_data->num_interior_columns = 0;
 
   int rank;
   MPI_Comm_rank(comm, &rank);
@@ -267,6 +278,8 @@ static chunk_xy_data_t* chunk_xy_data_from_fragment(colmesh_fragment_t* fragment
   fragment->send_map = NULL;
   xy_data->receive_map = fragment->receive_map;
   fragment->receive_map = NULL;
+  xy_data->column_partition = NULL;
+  xy_data->num_interior_columns = 0;
 
   // Count up ghost cells.
   int pos = 0, proc;
@@ -307,6 +320,8 @@ static chunk_xy_data_t* chunk_xy_data_clone(chunk_xy_data_t* xy_data)
   memcpy(clone->xy_nodes, xy_data->xy_nodes, xy_data->num_xy_nodes * sizeof(point2_t));
   clone->send_map = exchanger_proc_map_clone(xy_data->send_map, NULL, clone_int_array, NULL, int_array_free);
   clone->receive_map = exchanger_proc_map_clone(xy_data->send_map, NULL, clone_int_array, NULL, int_array_free);
+  clone->column_partition = NULL;
+  clone->num_interior_columns = 0;
   return clone;
 }
 #endif
@@ -320,6 +335,8 @@ static void chunk_xy_data_free(chunk_xy_data_t* xy_data)
   polymec_free(xy_data->column_xy_face_offsets);
   exchanger_proc_map_free(xy_data->send_map);
   exchanger_proc_map_free(xy_data->receive_map);
+  if (xy_data->column_partition != NULL)
+    polymec_free(xy_data->column_partition);
   polymec_free(xy_data);
 }
 
@@ -356,6 +373,12 @@ struct colmesh_t
   // True if the mesh is periodic along the z axis, false if not.
   bool periodic_in_z;
 
+  // Measured compute costs of chunks (NULL unless enabled), and the index
+  // of the chunk being timed (-1 if none).
+  real_t* chunk_costs;
+  int timed_chunk;
+  real_t timed_chunk_start;
+
   // This flag is set by colmesh_finalize() after a mesh has been assembled.
   bool finalized;
 };
@@ -443,6 +466,9 @@ colmesh_t* create_empty_colmesh(MPI_Comm comm,
   mesh->xy_edge_ex = NULL;
   mesh->z_edge_ex = NULL;
   mesh->node_ex = NULL;
+  mesh->chunk_costs = NULL;
+  mesh->timed_chunk = -1;
+  mesh->timed_chunk_start = 0.0;
   mesh->finalized = false;
 
   // Partition the planar polymesh.
@@ -518,6 +544,9 @@ colmesh_t* create_empty_colmesh_from_fragments(MPI_Comm comm,
   mesh->xy_edge_ex = NULL;
   mesh->z_edge_ex = NULL;
   mesh->node_ex = NULL;
+  mesh->chunk_costs = NULL;
+  mesh->timed_chunk = -1;
+  mesh->timed_chunk_start = 0.0;
   mesh->finalized = false;
 
   // Create xy data from the distributed fragments.
@@ -762,7 +791,7 @@ static void create_cell_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int xy1 = indices->data[2*j];
         int edge = indices->data[2*j+1];
 
@@ -811,7 +840,7 @@ static void create_cell_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int edge = indices->data[2*j+1];
 
         // Get the x and y coordinates for the receive cell's face.
@@ -839,7 +868,15 @@ static void create_cell_ex(colmesh_t* mesh)
   sort_indices(point_map, receive_map);
   proc_point_map_free(point_map);
 
-  // Now hook up the z sends/receives.
+  // Now hook up the z sends/receives. Each interface between vertically
+  // adjacent chunks carries an upward message (the lower chunk's top cells
+  // to the upper chunk's lower ghost cells) and a downward one. Sends and
+  // receives involving a given process must appear in the same order on
+  // both sides, so we key each index by its interface and direction and
+  // sort by these keys before adding them to the exchanger. (Indices
+  // increase with column indices, which orders columns consistently.)
+  exchanger_proc_map_t* z_send_map = exchanger_proc_map_new();
+  exchanger_proc_map_t* z_receive_map = exchanger_proc_map_new();
   for (size_t i = 0; i < mesh->chunks->size; ++i)
   {
     int xy = mesh->chunk_indices[2*i];
@@ -848,38 +885,59 @@ static void create_cell_ex(colmesh_t* mesh)
     colmesh_chunk_t* chunk = *chunk_map_get(mesh->chunks, ch_index);
     int chunk_offset = chunk_offsets[i];
 
-    // Upper neighbor.
+    // Lower neighbor.
     if ((z > 0) || (mesh->periodic_in_z))
     {
+      int z_lower = (z == 0) ? mesh->num_z_chunks-1 : z-1;
+      int ch1_index = chunk_index(mesh, xy, z_lower);
+      int proc = (int)(owners[ch1_index]);
+      int up_key = 2*ch1_index, down_key = 2*ch1_index + 1;
       for (int xy1 = 0; xy1 < chunk->num_columns; ++xy1)
       {
-        int ch1_index = ((z == 0) && mesh->periodic_in_z) ?
-                        chunk_index(mesh, xy, mesh->num_z_chunks-1) : chunk_index(mesh, xy, z-1);
-        int proc = (int)(owners[ch1_index]);
         int z1 = 1;
         int send_index = (int)(chunk_offset + (chunk->num_z_cells+2) * xy1 + z1);
         int receive_index = (int)(chunk_offset + (chunk->num_z_cells+2) * xy1 + z1 - 1);
-        exchanger_proc_map_add_index(send_map, proc, send_index);
-        exchanger_proc_map_add_index(receive_map, proc, receive_index);
+        exchanger_proc_map_add_index(z_send_map, proc, down_key);
+        exchanger_proc_map_add_index(z_send_map, proc, send_index);
+        exchanger_proc_map_add_index(z_receive_map, proc, up_key);
+        exchanger_proc_map_add_index(z_receive_map, proc, receive_index);
       }
     }
 
-    // Lower neighbor.
+    // Upper neighbor.
     if ((z < (mesh->num_z_chunks-1)) || (mesh->periodic_in_z))
     {
+      int z_upper = (z == (mesh->num_z_chunks-1)) ? 0 : z+1;
+      int ch1_index = chunk_index(mesh, xy, z_upper);
+      int proc = (int)(owners[ch1_index]);
+      int up_key = 2*ch_index, down_key = 2*ch_index + 1;
       for (int xy1 = 0; xy1 < chunk->num_columns; ++xy1)
       {
-        int ch1_index = ((z == (mesh->num_z_chunks-1)) && mesh->periodic_in_z) ?
-                        chunk_index(mesh, xy, 0) : chunk_index(mesh, xy, z+1);
-        int proc = (int)(owners[ch1_index]);
         int z1 = chunk->num_z_cells;
         int send_index = (int)(chunk_offset + (chunk->num_z_cells+2) * xy1 + z1);
         int receive_index = (int)(chunk_offset + (chunk->num_z_cells+2) * xy1 + z1 + 1);
-        exchanger_proc_map_add_index(send_map, proc, send_index);
-        exchanger_proc_map_add_index(receive_map, proc, receive_index);
+        exchanger_proc_map_add_index(z_send_map, proc, up_key);
+        exchanger_proc_map_add_index(z_send_map, proc, send_index);
+        exchanger_proc_map_add_index(z_receive_map, proc, down_key);
+        exchanger_proc_map_add_index(z_receive_map, proc, receive_index);
       }
     }
   }
+  exchanger_proc_map_t* z_maps[2] = {z_send_map, z_receive_map};
+  exchanger_proc_map_t* maps[2] = {send_map, receive_map};
+  for (int m = 0; m < 2; ++m)
+  {
+    int pos = 0, proc;
+    int_array_t* keyed_indices;
+    while (exchanger_proc_map_next(z_maps[m], &pos, &proc, &keyed_indices))
+    {
+      size_t num_indices = keyed_indices->size/2;
+      int_pair_qsort(keyed_indices->data, num_indices);
+      for (size_t j = 0; j < num_indices; ++j)
+        exchanger_proc_map_add_index(maps[m], proc, keyed_indices->data[2*j+1]);
+    }
+    exchanger_proc_map_free(z_maps[m]);
+  }
   polymec_free(owners);
 
   // Now construct the exchanger.
@@ -935,7 +993,7 @@ static void create_xy_face_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int face = indices->data[2*j+1], edge = face;
 
         // Get the x and y coordinates for the send face.
@@ -997,7 +1055,7 @@ static void create_xy_face_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int face = indices->data[2*j+1], edge = face;
 
         // Get the x and y coordinates for the receive face.
@@ -1177,7 +1235,7 @@ static void create_xy_edge_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int edge = indices->data[2*j+1];
 
         // Get the x and y coordinates for the send edge.
@@ -1238,7 +1296,7 @@ static void create_xy_edge_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int edge = indices->data[2*j+1];
 
         // Get the x and y coordinates for the receive cell's face.
@@ -1333,7 +1391,7 @@ static void create_z_edge_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int xy_edge = indices->data[2*j+1];
 
         // Process each one of the nodes attached to this edge, if we haven't
@@ -1405,7 +1463,7 @@ static void create_z_edge_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int xy_edge = indices->data[2*j+1];
 
         // Process each one of the nodes attached to this edge, if we haven't
@@ -1514,7 +1572,7 @@ static void create_node_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int edge = indices->data[2*j+1];
 
         // Process each one of the nodes attached to this edge, if we haven't
@@ -1586,7 +1644,7 @@ static void create_node_ex(colmesh_t* mesh)
       size_t num_indices = indices->size/2;
       for (size_t j = 0; j < num_indices; ++j)
       {
-        int proc = (int)(owners[neighbor_xy_index]);
+        int proc = (int)(owners[chunk_index(mesh, neighbor_xy_index, z)]);
         int edge = indices->data[2*j+1];
 
         // Process each one of the nodes attached to this edge, if we haven't
@@ -1795,6 +1853,8 @@ void colmesh_free(colmesh_t* mesh)
     release_ref(mesh->z_edge_ex);
   if (mesh->node_ex != NULL)
     release_ref(mesh->node_ex);
+  if (mesh->chunk_costs != NULL)
+    polymec_free(mesh->chunk_costs);
   polymec_free(mesh);
 }
 
@@ -1962,6 +2022,121 @@ int colmesh_num_chunks(colmesh_t* mesh)
   return (int)(mesh->chunks->size);
 }
 
+void colmesh_measure_chunk_costs(colmesh_t* mesh, bool flag)
+{
+  if (flag && (mesh->chunk_costs == NULL))
+  {
+    int num_chunks = mesh->num_xy_chunks * mesh->num_z_chunks;
+    mesh->chunk_costs = polymec_calloc(num_chunks, sizeof(real_t));
+  }
+  else if (!flag && (mesh->chunk_costs != NULL))
+  {
+    polymec_free(mesh->chunk_costs);
+    mesh->chunk_costs = NULL;
+  }
+  mesh->timed_chunk = -1;
+}
+
+bool colmesh_measures_chunk_costs(colmesh_t* mesh)
+{
+  return (mesh->chunk_costs != NULL);
+}
+
+void colmesh_add_chunk_cost(colmesh_t* mesh, int xy_index, int z_index, real_t cost)
+{
+  ASSERT(colmesh_has_chunk(mesh, xy_index, z_index));
+  if (mesh->chunk_costs != NULL)
+    mesh->chunk_costs[chunk_index(mesh, xy_index, z_index)] += cost;
+}
+
+void colmesh_get_chunk_costs(colmesh_t* mesh, real_t* costs)
+{
+  int num_chunks = mesh->num_xy_chunks * mesh->num_z_chunks;
+  if (mesh->chunk_costs != NULL)
+    memcpy(costs, mesh->chunk_costs, sizeof(real_t) * num_chunks);
+  else
+    memset(costs, 0, sizeof(real_t) * num_chunks);
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, costs, num_chunks, MPI_REAL_T, MPI_SUM, mesh->comm);
+#endif
+}
+
+void colmesh_reset_chunk_costs(colmesh_t* mesh)
+{
+  if (mesh->chunk_costs != NULL)
+  {
+    int num_chunks = mesh->num_xy_chunks * mesh->num_z_chunks;
+    memset(mesh->chunk_costs, 0, sizeof(real_t) * num_chunks);
+  }
+  mesh->timed_chunk = -1;
+}
+
+// This is called by colmesh_field_next_chunk to charge the time spent
+// since the last step of a traversal to the chunk visited in that step, and
+// to start timing the given chunk (or nothing, if xy_index is -1).
+void colmesh_time_chunk(colmesh_t* mesh, bool new_traversal, int xy_index, int z_index);
+void colmesh_time_chunk(colmesh_t* mesh, bool new_traversal, int xy_index, int z_index)
+{
+  if (mesh->chunk_costs == NULL)
+    return;
+#if POLYMEC_HAVE_OPENMP
+  // We can't tell threads' work apart, so we don't measure it.
+  if (omp_in_parallel())
+    return;
+#endif
+  real_t now = MPI_Wtime();
+  if ((mesh->timed_chunk != -1) && !new_traversal)
+    mesh->chunk_costs[mesh->timed_chunk] += now - mesh->timed_chunk_start;
+  mesh->timed_chunk = (xy_index != -1) ? chunk_index(mesh, xy_index, z_index) : -1;
+  mesh->timed_chunk_start = now;
+}
+
+void colmesh_get_column_partition(colmesh_t* mesh,
+                                  int xy_index,
+                                  int** interior_columns,
+                                  int* num_interior_columns,
+                                  int** boundary_columns,
+                                  int* num_boundary_columns)
+{
+  ASSERT(xy_index >= 0);
+  ASSERT(xy_index < mesh->chunk_xy_data->size);
+  chunk_xy_data_t* xy_data = mesh->chunk_xy_data->data[xy_index];
+  ASSERT(xy_data != NULL);
+  int num_columns = xy_data->num_columns;
+  if (xy_data->column_partition == NULL)
+  {
+    // A column is on the boundary if any of its xy faces connects it to a
+    // ghost column.
+    bool* boundary = polymec_calloc(MAX(num_columns, 1), sizeof(bool));
+    int num_interior = num_columns;
+    for (int f = 0; f < xy_data->num_xy_faces; ++f)
+    {
+      int col1 = xy_data->xy_face_columns[2*f];
+      int col2 = xy_data->xy_face_columns[2*f+1];
+      if ((col2 >= num_columns) && !boundary[col1])
+      {
+        boundary[col1] = true;
+        --num_interior;
+      }
+    }
+    xy_data->column_partition = polymec_malloc(sizeof(int) * MAX(num_columns, 1));
+    int i = 0, b = num_interior;
+    for (int col = 0; col < num_columns; ++col)
+    {
+      if (boundary[col])
+        xy_data->column_partition[b++] = col;
+      else
+        xy_data->column_partition[i++] = col;
+    }
+    xy_data->num_interior_columns = num_interior;
+    polymec_free(boundary);
+  }
+  *interior_columns = xy_data->column_partition;
+  *num_interior_columns = xy_data->num_interior_columns;
+  *boundary_columns = &xy_data->column_partition[xy_data->num_interior_columns];
+  *num_boundary_columns = num_columns - xy_data->num_interior_columns;
+}
+
 colmesh_chunk_t* colmesh_chunk(colmesh_t* mesh, int xy_index, int z_index)
 {
   int index = chunk_index(mesh, xy_index, z_index);
@@ -2062,6 +2237,8 @@ static void* xy_data_byte_read(byte_array_t* bytes, size_t* offset)
   serializer_t* ser = exchanger_proc_map_serializer();
   xy_data->send_map = serializer_read(ser, bytes, offset);
   xy_data->receive_map = serializer_read(ser, bytes, offset);
+  xy_data->column_partition = NULL;
+  xy_data->num_interior_columns = 0;
   return xy_data;
 }
 
@@ -2245,6 +2422,9 @@ static void redistribute_colmesh(colmesh_t** mesh,
   MPI_Comm_size(new_mesh->comm, &new_mesh->nproc);
   MPI_Comm_rank(new_mesh->comm, &new_mesh->rank);
   new_mesh->chunk_graph = adj_graph_clone(old_mesh->chunk_graph);
+  new_mesh->chunk_costs = NULL;
+  new_mesh->timed_chunk = -1;
+  new_mesh->timed_chunk_start = 0.0;
   new_mesh->finalized = false;
   new_mesh->cell_ex = NULL;
   new_mesh->xy_face_ex = NULL;
@@ -2396,49 +2576,71 @@ void repartition_colmesh(colmesh_t** mesh,
   polymec_free(sources);
   polymec_free(P);
 
+  if (log_level() >= LOG_DETAIL)
+  {
+    halo_volume_t volume = colmesh_halo_volume(*mesh);
+    log_detail("repartition_colmesh: Halo volume: %zu cells within nodes, %zu between nodes.",
+               volume.intra_node, volume.inter_node);
+  }
+
   STOP_FUNCTION_TIMER();
 #endif
 }
 
-// These functions provide access to exchangers for colmesh_fields.
+// These functions provide access to exchangers for colmesh_fields. Each
+// exchanger is built the first time it's needed, and cached.
 exchanger_t* colmesh_exchanger(colmesh_t* mesh, colmesh_centering_t centering);
 exchanger_t* colmesh_exchanger(colmesh_t* mesh, colmesh_centering_t centering)
 {
-  exchanger_t* ex = NULL;
+  static const char* centering_names[] =
+    {"cell", "xy-face", "z-face", "xy-edge", "z-edge", "node"};
+  exchanger_t** ex_p = NULL;
+  void (*create_ex)(colmesh_t* mesh) = NULL;
   switch (centering)
   {
     case COLMESH_CELL:
-      if (mesh->cell_ex == NULL)
-        create_cell_ex(mesh);
-      ex = mesh->cell_ex;
+      ex_p = &mesh->cell_ex;
+      create_ex = create_cell_ex;
       break;
     case COLMESH_XYFACE:
-      if (mesh->xy_face_ex == NULL)
-        create_xy_face_ex(mesh);
-      ex = mesh->xy_face_ex;
+      ex_p = &mesh->xy_face_ex;
+      create_ex = create_xy_face_ex;
       break;
     case COLMESH_ZFACE:
-      if (mesh->z_face_ex == NULL)
-        create_z_face_ex(mesh);
-      ex = mesh->z_face_ex;
+      ex_p = &mesh->z_face_ex;
+      create_ex = create_z_face_ex;
       break;
     case COLMESH_XYEDGE:
-      if (mesh->xy_edge_ex == NULL)
-        create_xy_edge_ex(mesh);
-      ex = mesh->xy_edge_ex;
+      ex_p = &mesh->xy_edge_ex;
+      create_ex = create_xy_edge_ex;
       break;
     case COLMESH_ZEDGE:
-      if (mesh->z_edge_ex == NULL)
-        create_z_edge_ex(mesh);
-      ex = mesh->z_edge_ex;
+      ex_p = &mesh->z_edge_ex;
+      create_ex = create_z_edge_ex;
       break;
     case COLMESH_NODE:
-      if (mesh->node_ex == NULL)
-        create_node_ex(mesh);
-      ex = mesh->node_ex;
+      ex_p = &mesh->node_ex;
+      create_ex = create_node_ex;
       break;
   }
-  return ex;
+
+  if (*ex_p == NULL)
+  {
+    double t1 = MPI_Wtime();
+    create_ex(mesh);
+    if (log_level() == LOG_DEBUG)
+    {
+      size_t bytes = serializer_size(exchanger_serializer(), *ex_p);
+      log_debug("colmesh: Built %s exchanger in %g s (%zu bytes).",
+                centering_names[centering], MPI_Wtime() - t1, bytes);
+    }
+  }
+  return *ex_p;
+}
+
+halo_volume_t colmesh_halo_volume(colmesh_t* mesh)
+{
+  return exchanger_halo_volume(colmesh_exchanger(mesh, COLMESH_CELL));
 }
 
 void colmesh_chunk_z_face_get_nodes(colmesh_chunk_t* chunk,
@@ -10,6 +10,7 @@
 
 #include "core/point.h"
 #include "core/exchanger.h"
+#include "core/partitioning.h"
 #include "geometry/planar_polymesh.h"
 #include "geometry/polygon.h"
 
@@ -281,6 +282,37 @@ bool colmesh_has_chunk(colmesh_t* mesh, int xy_index, int z_index);
 /// \param [in] z_index The z index of the chunk in question.
 colmesh_chunk_t* colmesh_chunk(colmesh_t* mesh, int xy_index, int z_index);
 
+/// Enables or disables the measurement of the compute cost of each
+/// locally-stored chunk. When enabled, the wall time spent between successive
+/// steps of a traversal with \ref colmesh_field_next_chunk is charged to
+/// the chunk visited in the earlier step. Traversals within OpenMP parallel
+/// regions are not measured. Disabling measurement discards measured costs.
+/// \memberof colmesh
+void colmesh_measure_chunk_costs(colmesh_t* mesh, bool flag);
+
+/// Returns true if the mesh is measuring chunk costs, false if not.
+/// \memberof colmesh
+bool colmesh_measures_chunk_costs(colmesh_t* mesh);
+
+/// Adds the given cost to the measured cost of the locally-stored chunk
+/// with the given xy and z indices, for work not timed by chunk traversals.
+/// Has no effect if the mesh isn't measuring chunk costs.
+/// \memberof colmesh
+void colmesh_add_chunk_cost(colmesh_t* mesh, int xy_index, int z_index, real_t cost);
+
+/// Fills costs with the measured costs of all chunks in the mesh (zero for
+/// chunks that haven't been measured). The cost of the chunk with indices
+/// (xy_index, z_index) is stored in costs[num_z_chunks*xy_index + z_index],
+/// which is also how \ref repartition_colmesh indexes its weights.
+/// \param [out] costs An array of length num_xy_chunks*num_z_chunks.
+/// \memberof colmesh
+/// \collective Collective on the mesh's communicator.
+void colmesh_get_chunk_costs(colmesh_t* mesh, real_t* costs);
+
+/// Resets the measured costs of all locally-stored chunks to zero.
+/// \memberof colmesh
+void colmesh_reset_chunk_costs(colmesh_t* mesh);
+
 /// Traverses the locally-stored chunks in the mesh.
 /// \param [in,out] pos Controls the traversal. Set to 0 to reset traversal.
 /// \param [out] xy_index Stores the xy index of the next chunk.
@@ -292,6 +324,24 @@ bool colmesh_next_chunk(colmesh_t* mesh, int* pos,
                         int* xy_index, int* z_index,
                         colmesh_chunk_t** chunk);
 
+/// Retrieves internal arrays that partition the columns of the chunks with
+/// the given xy index into interior columns, none of whose neighbors are
+/// ghost columns, and boundary columns, which neighbor at least one ghost
+/// column. The partition is computed the first time it's needed and cached
+/// within the mesh.
+/// \param [in] xy_index The xy index of a locally-stored chunk.
+/// \param [out] interior_columns Stores an array of interior columns.
+/// \param [out] num_interior_columns Stores the number of interior columns.
+/// \param [out] boundary_columns Stores an array of boundary columns.
+/// \param [out] num_boundary_columns Stores the number of boundary columns.
+/// \memberof colmesh
+void colmesh_get_column_partition(colmesh_t* mesh,
+                                  int xy_index,
+                                  int** interior_columns,
+                                  int* num_interior_columns,
+                                  int** boundary_columns,
+                                  int* num_boundary_columns);
+
 /// Returns true if the given colmesh chunk is topologically correct, false if
 /// not.
 /// \param [out] reason If non-NULL, stores the reason that the colmesh chunk
@@ -488,6 +538,13 @@ void repartition_colmesh(colmesh_t** mesh,
                          colmesh_field_t** fields,
                          size_t num_fields);
 
+/// Returns the numbers of ghost cell values exchanged between processes on
+/// the same (compute) node and on different nodes, summed over all processes
+/// (see \ref rank_nodes).
+/// \memberof colmesh
+/// \collective Collective on the mesh's communicator.
+halo_volume_t colmesh_halo_volume(colmesh_t* mesh);
+
 typedef struct polymesh_t polymesh_t;
 
 ///@}
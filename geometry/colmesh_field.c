@@ -127,10 +127,9 @@ colmesh_field_t* colmesh_field_with_buffer(colmesh_t* mesh,
   field->bytes = 0;
   field->owns_buffer = false;
 
-  // Set up exchangers and tokens.
-  field->ex = colmesh_exchanger(mesh, centering);
-  if (field->ex != NULL) // FIXME: Remove this test when all exchangers are complete!
-    retain_ref(field->ex);
+  // The field's exchanger is fetched from the mesh at its first exchange,
+  // so that the mesh only builds exchangers for centerings that are used.
+  field->ex = NULL;
   field->ex_token = -1;
 
   // Now populate the chunks (with NULL buffers).
@@ -270,17 +269,23 @@ colmesh_chunk_data_t* colmesh_field_chunk_data(colmesh_field_t* field,
     return NULL;
 }
 
+extern void colmesh_time_chunk(colmesh_t* mesh, bool new_traversal, int xy_index, int z_index);
+
 bool colmesh_field_next_chunk(colmesh_field_t* field, int* pos,
                               int* xy_index, int* z_index,
                               colmesh_chunk_data_t** chunk_data)
 {
+  bool new_traversal = (*pos == 0);
   colmesh_chunk_t* chunk;
   bool result = colmesh_next_chunk(field->mesh, pos, xy_index, z_index, &chunk);
   if (result)
   {
     *chunk_data = colmesh_field_chunk_data(field, *xy_index, *z_index);
     ASSERT((*chunk_data)->chunk == chunk);
+    colmesh_time_chunk(field->mesh, new_traversal, *xy_index, *z_index);
   }
+  else
+    colmesh_time_chunk(field->mesh, new_traversal, -1, -1);
   return result;
 }
 
@@ -323,6 +328,53 @@ bool colmesh_field_is_exchanging(colmesh_field_t* field)
   return (field->ex_token != -1);
 }
 
+void colmesh_field_exchange_and_compute(colmesh_field_t* field,
+                                        void (*kernel)(void* context,
+                                                       colmesh_chunk_data_t* chunk_data,
+                                                       int xy_index, int z_index,
+                                                       int* columns, int num_columns,
+                                                       int z1, int z2),
+                                        void* context)
+{
+  ASSERT(field->centering == COLMESH_CELL);
+  START_FUNCTION_TIMER();
+
+  // Cells in the interior columns of a chunk, away from its top and bottom,
+  // don't depend on ghost cells.
+  colmesh_field_start_exchange(field);
+  int pos = 0, xy_index, z_index;
+  colmesh_chunk_data_t* chunk_data;
+  while (colmesh_field_next_chunk(field, &pos, &xy_index, &z_index, &chunk_data))
+  {
+    int nz = chunk_data->chunk->num_z_cells;
+    int *interior, num_interior, *boundary, num_boundary;
+    colmesh_get_column_partition(field->mesh, xy_index, &interior, &num_interior,
+                                 &boundary, &num_boundary);
+    if ((num_interior > 0) && (nz > 2))
+      kernel(context, chunk_data, xy_index, z_index, interior, num_interior, 2, nz-1);
+  }
+  colmesh_field_finish_exchange(field);
+
+  // Now the rest.
+  pos = 0;
+  while (colmesh_field_next_chunk(field, &pos, &xy_index, &z_index, &chunk_data))
+  {
+    int nz = chunk_data->chunk->num_z_cells;
+    int *interior, num_interior, *boundary, num_boundary;
+    colmesh_get_column_partition(field->mesh, xy_index, &interior, &num_interior,
+                                 &boundary, &num_boundary);
+    if (num_interior > 0)
+    {
+      kernel(context, chunk_data, xy_index, z_index, interior, num_interior, 1, 1);
+      if (nz > 1)
+        kernel(context, chunk_data, xy_index, z_index, interior, num_interior, nz, nz);
+    }
+    if (num_boundary > 0)
+      kernel(context, chunk_data, xy_index, z_index, boundary, num_boundary, 1, nz);
+  }
+  STOP_FUNCTION_TIMER();
+}
+
 void colmesh_field_set_exchanger(colmesh_field_t* field, exchanger_t* ex)
 {
   if (field->ex != NULL)
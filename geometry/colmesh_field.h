@@ -146,7 +146,9 @@ bool colmesh_field_next_chunk(colmesh_field_t* field, int* pos,
 /// field with that of adjoining chunks. For cell-centered data, this
 /// means filling ghost cells. For face-, node-, and edge-centered data, it
 /// means overwriting values on the boundary of each chunk with data from
-/// other chunks.
+/// other chunks. The mesh builds its exchanger for the field's centering
+/// the first time a field with that centering is exchanged, and reuses it
+/// afterward.
 /// \memberof colmesh_field
 void colmesh_field_exchange(colmesh_field_t* field);
 
@@ -165,6 +167,26 @@ void colmesh_field_finish_exchange(colmesh_field_t* field);
 /// \memberof colmesh_field
 bool colmesh_field_is_exchanging(colmesh_field_t* field);
 
+/// Exchanges the ghost values of this cell-centered field while computing
+/// with its interior values. For each locally-stored chunk, the given kernel
+/// is called on cells that don't neighbor ghost cells while the exchange is
+/// in flight, and on the remaining cells after it has finished. The kernel is
+/// given a set of columns and a range of z indices, and processes the cells
+/// in those columns with z indices in [z1, z2]. Interior columns are those
+/// given by \ref colmesh_get_column_partition.
+/// \param [in] kernel A function called with a context pointer, the chunk
+///                    data, the chunk's xy and z indices, an array of columns
+///                    and its length, and the range of z indices.
+/// \param [in] context A context pointer passed to the kernel.
+/// \memberof colmesh_field
+void colmesh_field_exchange_and_compute(colmesh_field_t* field,
+                                        void (*kernel)(void* context,
+                                                       colmesh_chunk_data_t* chunk_data,
+                                                       int xy_index, int z_index,
+                                                       int* columns, int num_columns,
+                                                       int z1, int z2),
+                                        void* context);
+
 /// Sets the exchanger used by the field for exchanges.
 /// Use this method instead of directly assigning a new exchanger to the field.
 /// \param [in] ex The exchanger to be used by this field.
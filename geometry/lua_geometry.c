@@ -1573,7 +1573,7 @@ static int um_repartition(lua_State* L)
     return 0;
 
   // Perform the repartitioning. FIXME: Add fields
-  repartition_unimesh(&mesh, NULL, imbalance_tol, NULL, 0);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, imbalance_tol, NULL, 0);
   return 0;
 }
 
@@ -1734,7 +1734,7 @@ static int bm_repartition(lua_State* L)
     return 0;
 
   // Perform the repartitioning. FIXME: Add fields
-  repartition_blockmesh(&mesh, NULL, imbalance_tol, NULL, 0);
+  repartition_blockmesh(&mesh, GRAPH_PARTITIONER, NULL, imbalance_tol, NULL, 0);
   return 0;
 }
 
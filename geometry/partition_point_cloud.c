@@ -5,6 +5,7 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include "core/hilbert.h"
 #include "core/partitioning.h"
 #include "core/unordered_set.h"
 #include "core/timer.h"
@@ -315,12 +316,14 @@ bool repartition_point_cloud(point_cloud_t** cloud,
 #endif
 }
 
-void redistribute_point_cloud(point_cloud_t** cloud,
-                              int64_t* local_partition,
-                              point_cloud_field_t** fields,
-                              size_t num_fields)
-{
 #if POLYMEC_HAVE_MPI
+// Redistributes the cloud and fields, returning the number of bytes sent
+// from this process.
+static size_t redistribute_point_cloud_(point_cloud_t** cloud,
+                                        int64_t* local_partition,
+                                        point_cloud_field_t** fields,
+                                        size_t num_fields)
+{
   START_FUNCTION_TIMER();
   point_cloud_t* c = *cloud;
 
@@ -413,8 +416,12 @@ void redistribute_point_cloud(point_cloud_t** cloud,
   // Clean up the send buffers and the serializer. We still need the
   // receive buffer.
   ser = NULL;
+  size_t num_bytes_sent = 0;
   for (size_t i = 0; i < num_sends; ++i)
+  {
+    num_bytes_sent += send_buffers[i]->size;
     byte_array_free(send_buffers[i]);
+  }
 
   // Construct a local subcloud and store it in subclouds[0]. This subcloud
   // consists of all points not sent to other processes.
@@ -463,6 +470,139 @@ void redistribute_point_cloud(point_cloud_t** cloud,
   redistribution_free(redist);
   point_cloud_free(c);
   STOP_FUNCTION_TIMER();
+  return num_bytes_sent;
+}
+#endif
+
+void redistribute_point_cloud(point_cloud_t** cloud,
+                              int64_t* local_partition,
+                              point_cloud_field_t** fields,
+                              size_t num_fields)
+{
+#if POLYMEC_HAVE_MPI
+  redistribute_point_cloud_(cloud, local_partition, fields, num_fields);
+#endif
+}
+
+void rebalance_point_cloud(point_cloud_t** cloud,
+                           int* weights,
+                           real_t imbalance_tol,
+                           point_cloud_field_t** fields,
+                           size_t num_fields,
+                           migration_t* migration)
+{
+  ASSERT(imbalance_tol > 0.0);
+  ASSERT(imbalance_tol <= 1.0);
+  migration_t m_data = {.predicted_bytes = 0, .actual_bytes = 0};
+#if POLYMEC_HAVE_MPI
+  START_FUNCTION_TIMER();
+  point_cloud_t* cl = *cloud;
+  int nprocs, rank;
+  MPI_Comm_size(cl->comm, &nprocs);
+  MPI_Comm_rank(cl->comm, &rank);
+  size_t n = cl->num_points;
+
+  // Are we balanced already?
+  real_t my_load = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    my_load += (weights != NULL) ? 1.0 * weights[i] : 1.0;
+  real_t total_load, max_load, min_load;
+  MPI_Allreduce(&my_load, &total_load, 1, MPI_REAL_T, MPI_SUM, cl->comm);
+  MPI_Allreduce(&my_load, &max_load, 1, MPI_REAL_T, MPI_MAX, cl->comm);
+  MPI_Allreduce(&my_load, &min_load, 1, MPI_REAL_T, MPI_MIN, cl->comm);
+  real_t ideal_load = total_load / nprocs;
+  if ((nprocs == 1) ||
+      (MAX(max_load - ideal_load, ideal_load - min_load) <= imbalance_tol * ideal_load))
+  {
+    STOP_FUNCTION_TIMER();
+    if (migration != NULL)
+      *migration = m_data;
+    return;
+  }
+
+  // Map the points to a Hilbert curve spanning the whole cloud.
+  bbox_t bbox;
+  bbox_make_empty_set(&bbox);
+  for (size_t i = 0; i < n; ++i)
+    bbox_grow(&bbox, &cl->points[i]);
+  real_t lower[3] = {bbox.x1, bbox.y1, bbox.z1}, upper[3] = {bbox.x2, bbox.y2, bbox.z2};
+  MPI_Allreduce(MPI_IN_PLACE, lower, 3, MPI_REAL_T, MPI_MIN, cl->comm);
+  MPI_Allreduce(MPI_IN_PLACE, upper, 3, MPI_REAL_T, MPI_MAX, cl->comm);
+  bbox.x1 = lower[0]; bbox.y1 = lower[1]; bbox.z1 = lower[2];
+  bbox.x2 = upper[0]; bbox.y2 = upper[1]; bbox.z2 = upper[2];
+  hilbert_t* curve = hilbert_new(&bbox);
+  index_t* indices = polymec_malloc(sizeof(index_t) * MAX(n, 1));
+  for (size_t i = 0; i < n; ++i)
+    indices[i] = hilbert_index(curve, &cl->points[i]);
+  release_ref(curve);
+
+  // Split the curve into pieces.
+  int64_t* P = partition_curve_indices(indices, n, cl->comm, weights);
+  polymec_free(indices);
+
+  // Figure out how much of each piece each process holds, and assign each
+  // piece to the process that holds most of it, greedily.
+  real_t my_overlaps[nprocs];
+  memset(my_overlaps, 0, sizeof(real_t) * nprocs);
+  for (size_t i = 0; i < n; ++i)
+    my_overlaps[P[i]] += (weights != NULL) ? 1.0 * weights[i] : 1.0;
+  real_t* overlaps = polymec_malloc(sizeof(real_t) * nprocs * nprocs);
+  MPI_Allgather(my_overlaps, nprocs, MPI_REAL_T, overlaps, nprocs, MPI_REAL_T, cl->comm);
+  int owners[nprocs];
+  bool assigned[nprocs];
+  for (int p = 0; p < nprocs; ++p)
+  {
+    owners[p] = -1;
+    assigned[p] = false;
+  }
+  for (int a = 0; a < nprocs; ++a)
+  {
+    int best_proc = -1, best_piece = -1;
+    real_t best_overlap = -1.0;
+    for (int p = 0; p < nprocs; ++p)
+    {
+      if (assigned[p]) continue;
+      for (int q = 0; q < nprocs; ++q)
+      {
+        if ((owners[q] == -1) && (overlaps[nprocs*p+q] > best_overlap))
+        {
+          best_proc = p;
+          best_piece = q;
+          best_overlap = overlaps[nprocs*p+q];
+        }
+      }
+    }
+    assigned[best_proc] = true;
+    owners[best_piece] = best_proc;
+  }
+  polymec_free(overlaps);
+  for (size_t i = 0; i < n; ++i)
+    P[i] = (int64_t)owners[P[i]];
+
+  // Predict the number of bytes we'll move.
+  size_t point_bytes = sizeof(point_t);
+  for (size_t i = 0; i < num_fields; ++i)
+    point_bytes += sizeof(real_t) * fields[i]->num_components;
+  size_t my_migration = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (P[i] != rank)
+      my_migration += point_bytes;
+  }
+  MPI_Allreduce(&my_migration, &m_data.predicted_bytes, 1, MPI_SIZE_T,
+                MPI_SUM, cl->comm);
+
+  // Move the points.
+  size_t num_bytes_sent = redistribute_point_cloud_(cloud, P, fields, num_fields);
+  MPI_Allreduce(&num_bytes_sent, &m_data.actual_bytes, 1, MPI_SIZE_T,
+                MPI_SUM, (*cloud)->comm);
+  log_detail("rebalance_point_cloud: Predicted %zu bytes of migration, moved %zu bytes.",
+             m_data.predicted_bytes, m_data.actual_bytes);
+  polymec_free(P);
+
+  STOP_FUNCTION_TIMER();
 #endif
+  if (migration != NULL)
+    *migration = m_data;
 }
 
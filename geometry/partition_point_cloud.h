@@ -8,6 +8,7 @@
 #ifndef POLYMEC_PARTITION_POINT_CLOUD_H
 #define POLYMEC_PARTITION_POINT_CLOUD_H
 
+#include "core/partitioning.h"
 #include "geometry/point_cloud_field.h"
 
 // These functions provide partitioning and load balancing capabilities. In
@@ -46,6 +47,25 @@ bool repartition_point_cloud(point_cloud_t** cloud,
                              point_cloud_field_t** fields,
                              size_t num_fields);
 
+/// This function rebalances the given point cloud with the given load weights,
+/// moving as few points as it can. The points are split into pieces of equal
+/// weight along a Hilbert curve spanning the whole cloud, in parallel, and
+/// each piece is assigned to the process that already holds most of it. When
+/// the load has shifted only a little since the last rebalancing, the pieces
+/// shift only a little too, so this can be called often. The cloud and any
+/// given fields are replaced with rebalanced equivalents.
+/// \param [out] migration If non-NULL, stores the predicted and actual numbers
+///                        of bytes moved between processes. These are also
+///                        logged.
+/// \relates point_cloud
+/// \collective Collective on the cloud's communicator.
+void rebalance_point_cloud(point_cloud_t** cloud,
+                           int* weights,
+                           real_t imbalance_tol,
+                           point_cloud_field_t** fields,
+                           size_t num_fields,
+                           migration_t* migration);
+
 //------------------------------------------------------------------------
 // While partition_point_cloud and repartition_point_cloud are all-in-one
 // point cloud partitioners, the following functions allow one to mix-n-match
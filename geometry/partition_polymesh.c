@@ -65,7 +65,9 @@ static polymesh_t* create_submesh(MPI_Comm comm, polymesh_t* mesh,
     int_unordered_set_insert(cell_set, indices[i]);
   }
 
-  // Count unique mesh elements (faces, nodes).
+  // Count unique mesh elements (faces, nodes). Each face that separates a
+  // submesh cell from an outside cell gets its own ghost cell, since that's
+  // how fuse_submeshes accounts for them.
   int num_cells = (int)num_indices, num_ghost_cells = 0;
   int_unordered_set_t* face_indices = int_unordered_set_new();
   int_unordered_set_t* node_indices = int_unordered_set_new();
@@ -76,10 +78,7 @@ static polymesh_t* create_submesh(MPI_Comm comm, polymesh_t* mesh,
     {
       int opp_cell = polymesh_face_opp_cell(mesh, face, cell);
       if ((opp_cell != -1) && !int_unordered_set_contains(cell_set, opp_cell))
-      {
-        int_unordered_set_insert(cell_set, opp_cell);
         ++num_ghost_cells;
-      }
 
       int_unordered_set_insert(face_indices, face);
       int npos = 0, node;
@@ -821,6 +820,13 @@ bool partition_polymesh(polymesh_t** mesh,
   if (global_partition != NULL)
     polymec_free(global_partition);
 
+  if (log_level() >= LOG_DETAIL)
+  {
+    halo_volume_t volume = polymesh_halo_volume(*mesh);
+    log_detail("partition_mesh: Halo volume: %zu cells within nodes, %zu between nodes.",
+               volume.intra_node, volume.inter_node);
+  }
+
   // Return the migrator.
   STOP_FUNCTION_TIMER();
   return true;
@@ -1052,8 +1058,10 @@ void distribute_polymesh(polymesh_t** mesh,
     int_array_append(indices, global_ghost_index);
   }
 
-  // Make sure everything lines up.
-  ASSERT(next_ghost_index - local_mesh->num_cells == local_mesh->num_ghost_cells);
+  // create_submesh allots a ghost cell to each parallel boundary face, but
+  // here we store each ghost cell only once, so we may have fewer of them.
+  ASSERT(next_ghost_index - local_mesh->num_cells <= local_mesh->num_ghost_cells);
+  local_mesh->num_ghost_cells = next_ghost_index - local_mesh->num_cells;
 
   exchanger_t* ex = polymesh_exchanger(local_mesh, POLYMESH_CELL);
   int pos = 0, proc;
@@ -1085,6 +1093,11 @@ void distribute_polymesh(polymesh_t** mesh,
     }
   }
 
+  // A ghost cell that shares faces with several local cells is received once
+  // per face, always with the same value, so any reducer will do.
+  if (exchanger_aggregates_data(ex))
+    exchanger_set_reducer(ex, EXCHANGER_MAX_RANK);
+
   // Clean up again.
   int_ptr_unordered_map_free(ghost_cell_indices);
   int_int_unordered_map_free(inverse_cell_map);
@@ -1158,11 +1171,13 @@ void distribute_polymesh(polymesh_t** mesh,
 //------------------------------------------------------------------------
 
 #if POLYMEC_HAVE_MPI
-static void redistribute_polymesh_with_graph(polymesh_t** mesh,
-                                             int64_t* local_partition,
-                                             adj_graph_t* local_graph,
-                                             polymesh_field_t** fields,
-                                             size_t num_fields)
+// Redistributes the mesh and fields, returning the number of bytes sent
+// from this process.
+static size_t redistribute_polymesh_with_graph(polymesh_t** mesh,
+                                               int64_t* local_partition,
+                                               adj_graph_t* local_graph,
+                                               polymesh_field_t** fields,
+                                               size_t num_fields)
 {
 #ifndef NDEBUG
   // Only cell-centered fields can be redistributed at the moment.
@@ -1244,12 +1259,12 @@ static void redistribute_polymesh_with_graph(polymesh_t** mesh,
     for (size_t i = 0; i < num_fields; ++i)
     {
       size_t num_comps = fields[i]->num_components;
-      byte_array_write_ints(send_buffers[p], 1, &submesh->num_cells, &offset);
+      byte_array_write_ints(bytes, 1, &submesh->num_cells, &offset);
       real_t field_data[num_comps*submesh->num_cells];
       for (int j = 0; j < submesh->num_cells; ++j)
         for (size_t c = 0; c < num_comps; ++c)
           field_data[num_comps*j+c] = fields[i]->data[num_comps*indices->data[j]+c];
-      byte_array_write_real_ts(send_buffers[p], num_comps*submesh->num_cells, field_data, &offset);
+      byte_array_write_real_ts(bytes, num_comps*submesh->num_cells, field_data, &offset);
     }
 
     // Send the buffer size.
@@ -1293,8 +1308,12 @@ static void redistribute_polymesh_with_graph(polymesh_t** mesh,
 
   // Clean up the send buffers and the serializer. We still need the
   // receive buffer.
+  size_t num_bytes_sent = 0;
   for (size_t i = 0; i < num_sends; ++i)
+  {
+    num_bytes_sent += send_buffers[i]->size;
     byte_array_free(send_buffers[i]);
+  }
 
   // Construct a local submesh and store it in submeshes[0]. This submesh
   // consists of all cells not sent to other processes.
@@ -1346,6 +1365,7 @@ static void redistribute_polymesh_with_graph(polymesh_t** mesh,
   polymesh_free(m);
 
   STOP_FUNCTION_TIMER();
+  return num_bytes_sent;
 }
 #endif
 
@@ -1399,6 +1419,13 @@ bool repartition_polymesh(polymesh_t** mesh,
   adj_graph_free(local_graph);
   polymec_free(local_partition);
 
+  if (log_level() >= LOG_DETAIL)
+  {
+    halo_volume_t volume = polymesh_halo_volume(*mesh);
+    log_detail("repartition_mesh: Halo volume: %zu cells within nodes, %zu between nodes.",
+               volume.intra_node, volume.inter_node);
+  }
+
   STOP_FUNCTION_TIMER();
   return true;
 #else
@@ -1406,6 +1433,81 @@ bool repartition_polymesh(polymesh_t** mesh,
 #endif
 }
 
+halo_volume_t polymesh_halo_volume(polymesh_t* mesh)
+{
+  return exchanger_halo_volume(polymesh_exchanger(mesh, POLYMESH_CELL));
+}
+
+void rebalance_polymesh(polymesh_t** mesh,
+                        int* weights,
+                        real_t imbalance_tol,
+                        polymesh_field_t** fields,
+                        size_t num_fields,
+                        migration_t* migration)
+{
+  ASSERT(imbalance_tol > 0.0);
+  ASSERT(imbalance_tol <= 1.0);
+  migration_t m_data = {.predicted_bytes = 0, .actual_bytes = 0};
+#if POLYMEC_HAVE_MPI
+  START_FUNCTION_TIMER();
+  polymesh_t* m = *mesh;
+  int nprocs, rank;
+  MPI_Comm_size(m->comm, &nprocs);
+  MPI_Comm_rank(m->comm, &rank);
+  if (nprocs > 1)
+  {
+    // Find the owners of our ghost cells.
+    int64_t owners[m->num_cells + m->num_ghost_cells];
+    for (int i = 0; i < m->num_cells; ++i)
+      owners[i] = (int64_t)rank;
+    exchanger_t* mesh_ex = polymesh_exchanger(m, POLYMESH_CELL);
+    exchanger_exchange(mesh_ex, owners, 1, 0, MPI_INT64_T);
+    int ghost_owners[MAX(m->num_ghost_cells, 1)];
+    for (int i = 0; i < m->num_ghost_cells; ++i)
+      ghost_owners[i] = (int)owners[m->num_cells + i];
+
+    // Estimate the number of bytes that move with each cell: its faces,
+    // their nodes, and its field data.
+    size_t field_bytes = 0;
+    for (size_t i = 0; i < num_fields; ++i)
+      field_bytes += sizeof(int) + sizeof(real_t) * fields[i]->num_components;
+    size_t* costs = polymec_malloc(sizeof(size_t) * MAX(m->num_cells, 1));
+    for (int i = 0; i < m->num_cells; ++i)
+    {
+      costs[i] = sizeof(int) + field_bytes;
+      for (int j = m->cell_face_offsets[i]; j < m->cell_face_offsets[i+1]; ++j)
+      {
+        int f = m->cell_faces[j];
+        if (f < 0) f = ~f;
+        int num_face_nodes = m->face_node_offsets[f+1] - m->face_node_offsets[f];
+        costs[i] += 3 * sizeof(int) + num_face_nodes * (sizeof(int) + sizeof(point_t));
+      }
+    }
+
+    // Rebalance the graph of cells and move the cells accordingly.
+    adj_graph_t* local_graph = graph_from_polymesh_cells(m);
+    int64_t* local_partition = rebalance_graph(local_graph, ghost_owners,
+                                               weights, costs, imbalance_tol,
+                                               &m_data.predicted_bytes);
+    size_t num_bytes_sent = redistribute_polymesh_with_graph(mesh, local_partition,
+                                                             local_graph, fields,
+                                                             num_fields);
+    MPI_Allreduce(&num_bytes_sent, &m_data.actual_bytes, 1, MPI_SIZE_T,
+                  MPI_SUM, (*mesh)->comm);
+    log_detail("rebalance_polymesh: Predicted %zu bytes of migration, moved %zu bytes.",
+               m_data.predicted_bytes, m_data.actual_bytes);
+
+    // Clean up.
+    adj_graph_free(local_graph);
+    polymec_free(local_partition);
+    polymec_free(costs);
+  }
+  STOP_FUNCTION_TIMER();
+#endif
+  if (migration != NULL)
+    *migration = m_data;
+}
+
 void redistribute_polymesh(polymesh_t** mesh,
                            int64_t* local_partition,
                            polymesh_field_t** fields,
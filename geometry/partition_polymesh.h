@@ -8,6 +8,7 @@
 #ifndef POLYMEC_PARTITION_MESH_H
 #define POLYMEC_PARTITION_MESH_H
 
+#include "core/partitioning.h"
 #include "geometry/polymesh_field.h"
 
 /// \addtogroup geometry geometry
@@ -42,6 +43,32 @@ bool repartition_polymesh(polymesh_t** mesh,
                           polymesh_field_t** fields,
                           size_t num_fields);
 
+/// Returns the numbers of ghost cell values exchanged between processes on
+/// the same (compute) node and on different nodes, summed over all processes
+/// (see \ref rank_nodes). Useful for judging how well a partition fits the
+/// machine's topology.
+/// \relates polymesh
+/// \collective Collective on the mesh's communicator.
+halo_volume_t polymesh_halo_volume(polymesh_t* mesh);
+
+/// This function incrementally rebalances the given mesh with the given load
+/// weights, moving cells only between neighboring processes, and as few as
+/// needed (see \ref rebalance_graph). This is much cheaper than
+/// \ref repartition_polymesh when the load has shifted only a little, so it
+/// can be called often. The mesh and any given fields are replaced with
+/// rebalanced equivalents.
+/// \param [out] migration If non-NULL, stores the predicted and actual numbers
+///                        of bytes moved between processes. These are also
+///                        logged.
+/// \relates polymesh
+/// \collective Collective on the mesh's communicator.
+void rebalance_polymesh(polymesh_t** mesh,
+                        int* weights,
+                        real_t imbalance_tol,
+                        polymesh_field_t** fields,
+                        size_t num_fields,
+                        migration_t* migration);
+
 // While partition_polymesh and repartition_polymesh are all-in-one mesh partitioners, the
 // following functions allow one to mix-n-match the pieces of the underlying algorithms.
 
@@ -8,10 +8,14 @@
 #include "core/array_utils.h"
 #include "core/hilbert.h"
 #include "core/kd_tree.h"
-#include "core/table.h"
+#include "core/timer.h"
 #include "core/unordered_set.h"
 #include "geometry/polymesh.h"
 
+#if POLYMEC_HAVE_OPENMP
+#include <omp.h>
+#endif
+
 // This function rounds the given number up to the nearest power of 2.
 static int round_to_pow2(int x)
 {
@@ -27,6 +31,26 @@ struct polymesh_storage_t
   int face_edge_capacity;
   int face_node_capacity;
   exchanger_t* exchangers[4];
+
+  // Face coloring (computed on demand), stored in compressed row format.
+  int num_face_colors;
+  int* face_color_offsets;
+  int* face_colors;
+
+  // Node->face connectivity (computed on demand), in compressed row format.
+  int* node_face_offsets;
+  int* node_faces;
+
+  // Flags (computed with the mesh's geometry) indicating which faces appear
+  // as their one's complements in the face lists of their first cells.
+  bool* face_flipped;
+
+  // Locally-owned cells and faces (computed on demand), with those that
+  // don't depend on ghost cells listed first.
+  int* cell_partition;
+  int num_interior_cells;
+  int* face_partition;
+  int num_interior_faces;
 };
 
 // Initializes a new storage mechanism for a polymesh.
@@ -38,6 +62,16 @@ static polymesh_storage_t* polymesh_storage_new(MPI_Comm comm)
   storage->face_node_capacity = 0;
   memset(storage->exchangers, 0, sizeof(exchanger_t*)*4);
   storage->exchangers[(int)POLYMESH_CELL] = exchanger_new(comm);
+  storage->num_face_colors = 0;
+  storage->face_color_offsets = NULL;
+  storage->face_colors = NULL;
+  storage->node_face_offsets = NULL;
+  storage->node_faces = NULL;
+  storage->face_flipped = NULL;
+  storage->cell_partition = NULL;
+  storage->num_interior_cells = 0;
+  storage->face_partition = NULL;
+  storage->num_interior_faces = 0;
   return storage;
 }
 
@@ -49,6 +83,23 @@ static void polymesh_storage_free(polymesh_storage_t* storage)
     if (storage->exchangers[cent] != NULL)
       release_ref(storage->exchangers[cent]);
   }
+  if (storage->face_color_offsets != NULL)
+  {
+    polymec_free(storage->face_color_offsets);
+    polymec_free(storage->face_colors);
+  }
+  if (storage->node_face_offsets != NULL)
+  {
+    polymec_free(storage->node_face_offsets);
+    polymec_free(storage->node_faces);
+  }
+  if (storage->face_flipped != NULL)
+    polymec_free(storage->face_flipped);
+  if (storage->cell_partition != NULL)
+  {
+    polymec_free(storage->cell_partition);
+    polymec_free(storage->face_partition);
+  }
   polymec_free(storage);
 }
 
@@ -349,181 +400,487 @@ bool polymesh_next_tag(tagger_t* tagger, int* pos, char** tag_name, int** tag_in
   return tagger_next_tag(tagger, pos, tag_name, tag_indices, tag_size);
 }
 
+// Records which faces appear as their one's complements in the face lists of
+// their first cells, in a single pass over the locally-owned cells.
+static void compute_face_orientations(polymesh_t* mesh)
+{
+  polymesh_storage_t* storage = mesh->storage;
+  if (storage->face_flipped == NULL)
+    storage->face_flipped = polymec_malloc(sizeof(bool) * MAX(mesh->num_faces, 1));
+  memset(storage->face_flipped, 0, sizeof(bool) * mesh->num_faces);
+  for (int cell = 0; cell < mesh->num_cells; ++cell)
+  {
+    for (int j = mesh->cell_face_offsets[cell]; j < mesh->cell_face_offsets[cell+1]; ++j)
+    {
+      int face = mesh->cell_faces[j];
+      if ((face < 0) && (mesh->face_cells[2*(~face)] == cell))
+        storage->face_flipped[~face] = true;
+    }
+  }
+}
+
+// Returns the given face as it appears in the face list of its first cell:
+// its index if its nodes are traversed in order, or its one's complement
+// otherwise.
+static inline int oriented_face(polymesh_t* mesh, int face)
+{
+  return (mesh->storage->face_flipped[face]) ? ~face : face;
+}
+
+static void compute_face_center(polymesh_t* mesh, int face)
+{
+  point_t xf = {.x = 0.0, .y = 0.0, .z = 0.0};
+  int npos = 0, node;
+  while (polymesh_face_next_node(mesh, face, &npos, &node))
+  {
+    ASSERT(node >= 0);
+    ASSERT(node < mesh->num_nodes);
+    point_t* xn = &mesh->nodes[node];
+    xf.x += xn->x;
+    xf.y += xn->y;
+    xf.z += xn->z;
+  }
+  int nn = polymesh_face_num_nodes(mesh, face);
+  xf.x /= nn;
+  xf.y /= nn;
+  xf.z /= nn;
+  mesh->face_centers[face] = xf;
+}
+
+static void compute_cell_center(polymesh_t* mesh, int cell)
+{
+  // Make sure each cell has at least 4 faces.
+  ASSERT((mesh->cell_face_offsets[cell+1] - mesh->cell_face_offsets[cell]) >= 4);
+
+  // The cell center is the average of the nodes of its faces, knowing that
+  // it's convex.
+  point_t xc = {.x = 0.0, .y = 0.0, .z = 0.0};
+  int num_cell_nodes = 0;
+  int pos = 0, face;
+  while (polymesh_cell_next_oriented_face(mesh, cell, &pos, &face))
+  {
+    int actual_face = (face >= 0) ? face : ~face;
+    ASSERT(actual_face < mesh->num_faces);
+    int npos = 0, node;
+    while (polymesh_face_next_node(mesh, face, &npos, &node))
+    {
+      point_t* xn = &mesh->nodes[node];
+      xc.x += xn->x;
+      xc.y += xn->y;
+      xc.z += xn->z;
+    }
+    num_cell_nodes += polymesh_face_num_nodes(mesh, actual_face);
+  }
+  xc.x /= num_cell_nodes;
+  xc.y /= num_cell_nodes;
+  xc.z /= num_cell_nodes;
+  mesh->cell_centers[cell] = xc;
+}
+
+static void compute_face_area_and_normal(polymesh_t* mesh, int face)
+{
+  // The face's area is the sum of the areas of the triangles formed by its
+  // center and its edges.
+  int cell = mesh->face_cells[2*face];
+  int oface = oriented_face(mesh, face);
+  point_t* xf = &(mesh->face_centers[face]);
+  real_t face_area = 0.0;
+  vector_t face_normal = {0.0, 0.0, 0.0};
+  int epos = 0, edge;
+  while (polymesh_face_next_edge(mesh, oface, &epos, &edge))
+  {
+    ASSERT(edge >= 0);
+    ASSERT(edge < mesh->num_edges);
+    vector_t v2, v3, v2xv3;
+    point_t xn1 = mesh->nodes[mesh->edge_nodes[2*edge]];
+    point_t xn2 = mesh->nodes[mesh->edge_nodes[2*edge+1]];
+    point_displacement(xf, &xn1, &v2);
+    point_displacement(xf, &xn2, &v3);
+    vector_cross(&v2, &v3, &v2xv3);
+    real_t tri_area = 0.5*vector_mag(&v2xv3);
+    face_area += tri_area;
+    face_normal = v2xv3;
+  }
+  mesh->face_areas[face] = face_area;
+  vector_normalize(&face_normal);
+
+  // Flip the normal vector if we need to.
+  // FIXME: We should revisit the above code so this isn't needed.
+  vector_t outward;
+  point_displacement(&(mesh->cell_centers[cell]), xf, &outward);
+  real_t n_o_cf = vector_dot(&face_normal, &outward);
+  if (n_o_cf < 0.0)
+  {
+    if (oface == face)
+      vector_scale(&face_normal, -1.0);
+  }
+  else if (n_o_cf > 0.0)
+  {
+    if (oface != face)
+      vector_scale(&face_normal, -1.0);
+  }
+  mesh->face_normals[face] = face_normal;
+}
+
+static void compute_cell_volume(polymesh_t* mesh, int cell)
+{
+  mesh->cell_volumes[cell] = 0.0;
+  int pos = 0, face;
+  while (polymesh_cell_next_oriented_face(mesh, cell, &pos, &face))
+  {
+    int actual_face = (face >= 0) ? face : ~face;
+    point_t* xf = &(mesh->face_centers[actual_face]);
+    vector_t v1;
+    point_displacement(xf, &(mesh->cell_centers[cell]), &v1);
+    int epos = 0, edge;
+    while (polymesh_face_next_edge(mesh, face, &epos, &edge))
+    {
+      // Construct a tetrahedron whose vertices are the cell center,
+      // the face center, and the two nodes of this edge. The volume
+      // of this tetrahedron contributes to the cell volume.
+      vector_t v2, v3, v2xv3;
+      point_t xn1 = mesh->nodes[mesh->edge_nodes[2*edge]];
+      point_t xn2 = mesh->nodes[mesh->edge_nodes[2*edge+1]];
+      point_displacement(xf, &xn1, &v2);
+      point_displacement(xf, &xn2, &v3);
+      vector_cross(&v2, &v3, &v2xv3);
+      real_t tet_volume = ABS(vector_dot(&v1, &v2xv3))/6.0;
+      mesh->cell_volumes[cell] += tet_volume;
+    }
+  }
+}
+
+// Returns true if the given face is attached to a locally-owned cell, and
+// therefore has geometry computed for it.
+static inline bool face_is_local(polymesh_t* mesh, int face)
+{
+  return (mesh->face_cells[2*face] < mesh->num_cells);
+}
+
 void polymesh_compute_geometry(polymesh_t* mesh)
 {
+  START_FUNCTION_TIMER();
+  compute_face_orientations(mesh);
+
+  // Each face's geometry is computed once, and faces and cells are processed
+  // independently of one another.
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int face = 0; face < mesh->num_faces; ++face)
+  {
+    if (face_is_local(mesh, face))
+      compute_face_center(mesh, face);
+  }
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
   for (int cell = 0; cell < mesh->num_cells; ++cell)
+    compute_cell_center(mesh, cell);
+
+  // Use the preceding geometry to compute face areas and normals and cell
+  // volumes.
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int face = 0; face < mesh->num_faces; ++face)
   {
-    // Make sure each cell has at least 4 faces.
-    ASSERT((mesh->cell_face_offsets[cell+1] - mesh->cell_face_offsets[cell]) >= 4);
-
-    // Compute cell centers and face centers for the cell,
-    // knowing that it's convex.
-    point_t xc = {.x = 0.0, .y = 0.0, .z = 0.0};
-    int num_cell_nodes = 0, num_cell_faces = 0;
-    int pos = 0, face;
-    while (polymesh_cell_next_oriented_face(mesh, cell, &pos, &face))
+    if (face_is_local(mesh, face))
+      compute_face_area_and_normal(mesh, face);
+  }
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int cell = 0; cell < mesh->num_cells; ++cell)
+    compute_cell_volume(mesh, cell);
+
+  STOP_FUNCTION_TIMER();
+}
+
+// Builds the (cached) mapping from nodes to their attached faces.
+static void compute_node_faces(polymesh_t* mesh)
+{
+  polymesh_storage_t* storage = mesh->storage;
+  storage->node_face_offsets = polymec_calloc(mesh->num_nodes+1, sizeof(int));
+  int* offsets = storage->node_face_offsets;
+  int num_face_nodes = mesh->face_node_offsets[mesh->num_faces];
+  for (int i = 0; i < num_face_nodes; ++i)
+    ++offsets[mesh->face_nodes[i]+1];
+  for (int n = 0; n < mesh->num_nodes; ++n)
+    offsets[n+1] += offsets[n];
+  storage->node_faces = polymec_malloc(sizeof(int) * MAX(num_face_nodes, 1));
+  int* counts = polymec_calloc(mesh->num_nodes, sizeof(int));
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    for (int i = mesh->face_node_offsets[f]; i < mesh->face_node_offsets[f+1]; ++i)
+    {
+      int n = mesh->face_nodes[i];
+      storage->node_faces[offsets[n] + counts[n]] = f;
+      ++counts[n];
+    }
+  }
+  polymec_free(counts);
+}
+
+void polymesh_update_geometry(polymesh_t* mesh,
+                              int* moved_nodes,
+                              size_t num_moved_nodes)
+{
+  START_FUNCTION_TIMER();
+  polymesh_storage_t* storage = mesh->storage;
+  if (storage->node_face_offsets == NULL)
+    compute_node_faces(mesh);
+  if (storage->face_flipped == NULL)
+    compute_face_orientations(mesh);
+
+  // Find the faces attached to the moved nodes, and the cells attached to
+  // those faces.
+  bool* face_moved = polymec_calloc(mesh->num_faces, sizeof(bool));
+  bool* cell_moved = polymec_calloc(mesh->num_cells, sizeof(bool));
+  int_array_t* faces = int_array_new();
+  int_array_t* cells = int_array_new();
+  for (size_t i = 0; i < num_moved_nodes; ++i)
+  {
+    int n = moved_nodes[i];
+    ASSERT((n >= 0) && (n < mesh->num_nodes));
+    for (int j = storage->node_face_offsets[n]; j < storage->node_face_offsets[n+1]; ++j)
     {
-      int actual_face = (face >= 0) ? face : ~face;
-      ASSERT(actual_face < mesh->num_faces);
-      point_t xf = {.x = 0.0, .y = 0.0, .z = 0.0};
-      int npos = 0, node;
-      while (polymesh_face_next_node(mesh, actual_face, &npos, &node))
+      int f = storage->node_faces[j];
+      if (face_moved[f] || !face_is_local(mesh, f)) continue;
+      face_moved[f] = true;
+      int_array_append(faces, f);
+      for (int k = 0; k < 2; ++k)
       {
-        ASSERT(node >= 0);
-        ASSERT(node < mesh->num_nodes);
-        point_t* xn = &mesh->nodes[node];
-        xc.x += xn->x;
-        xc.y += xn->y;
-        xc.z += xn->z;
-        // The first cell on this face computes its center.
-        if (cell == mesh->face_cells[2*actual_face])
+        int c = mesh->face_cells[2*f+k];
+        if ((c >= 0) && (c < mesh->num_cells) && !cell_moved[c])
         {
-          xf.x += xn->x;
-          xf.y += xn->y;
-          xf.z += xn->z;
+          cell_moved[c] = true;
+          int_array_append(cells, c);
         }
       }
-      if (cell == mesh->face_cells[2*actual_face])
-      {
-        int nn = polymesh_face_num_nodes(mesh, actual_face);
-        xf.x /= nn;
-        xf.y /= nn;
-        xf.z /= nn;
-        mesh->face_centers[actual_face] = xf;
-      }
-      num_cell_nodes += polymesh_face_num_nodes(mesh, actual_face);
-      ++num_cell_faces;
     }
-    xc.x /= num_cell_nodes;
-    xc.y /= num_cell_nodes;
-    xc.z /= num_cell_nodes;
-    mesh->cell_centers[cell] = xc;
   }
+  int num_moved_faces = (int)faces->size;
+  int num_cells = (int)cells->size;
 
-  // Use the preceding geometry to compute face areas and the
-  // cell's volume.
-  for (int cell = 0; cell < mesh->num_cells; ++cell)
+  // The normals of faces attached to a cell whose center has moved may
+  // need to be flipped, so we recompute them along with the moved faces.
+  for (int i = 0; i < num_cells; ++i)
   {
-    mesh->cell_volumes[cell] = 0.0;
-    int pos = 0, face;
-    while (polymesh_cell_next_oriented_face(mesh, cell, &pos, &face))
+    int c = cells->data[i], pos = 0, f;
+    while (polymesh_cell_next_face(mesh, c, &pos, &f))
     {
-      int actual_face = (face >= 0) ? face : ~face;
-      real_t face_area = 0.0;
-      vector_t face_normal = {0.0, 0.0, 0.0};
-      int epos = 0, edge;
-      while (polymesh_face_next_edge(mesh, face, &epos, &edge))
+      if (!face_moved[f] && face_is_local(mesh, f))
       {
-        ASSERT(edge >= 0);
-        ASSERT(edge < mesh->num_edges);
-        // Construct a tetrahedron whose vertices are the cell center,
-        // the face center, and the two nodes of this edge. The volume
-        // of this tetrahedron contributes to the cell volume.
-        vector_t v1, v2, v3, v2xv3;
-        point_t* xf = &(mesh->face_centers[actual_face]);
-        point_displacement(xf, &(mesh->cell_centers[cell]), &v1);
-        point_t xn1 = mesh->nodes[mesh->edge_nodes[2*edge]];
-        point_t xn2 = mesh->nodes[mesh->edge_nodes[2*edge+1]];
-        point_displacement(xf, &xn1, &v2);
-        point_displacement(xf, &xn2, &v3);
-        vector_cross(&v2, &v3, &v2xv3);
-        real_t tet_volume = ABS(vector_dot(&v1, &v2xv3))/6.0;
-        mesh->cell_volumes[cell] += tet_volume;
-
-        // Now take the face of the tet whose vertices are the face center
-        // and the two nodes. The area of this tet contributes to the
-        // face's area.
-        real_t tri_area = 0.5*vector_mag(&v2xv3);
-        face_area += tri_area;
-        face_normal = v2xv3;
+        face_moved[f] = true;
+        int_array_append(faces, f);
       }
+    }
+  }
+  int num_faces = (int)faces->size;
+  polymec_free(cell_moved);
+  polymec_free(face_moved);
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_moved_faces; ++i)
+    compute_face_center(mesh, faces->data[i]);
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_cells; ++i)
+    compute_cell_center(mesh, cells->data[i]);
 
-      // The cell that stores the face gets
-      // to take responsibility for the face normals/areas.
-      if (cell == mesh->face_cells[2*actual_face])
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_faces; ++i)
+    compute_face_area_and_normal(mesh, faces->data[i]);
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_cells; ++i)
+    compute_cell_volume(mesh, cells->data[i]);
+
+  int_array_free(cells);
+  int_array_free(faces);
+  STOP_FUNCTION_TIMER();
+}
+
+// A face edge, identified by its (sorted) nodes, and the slot in the
+// face->edge connectivity array that refers to it.
+typedef struct
+{
+  uint64_t key;
+  int slot;
+} face_edge_t;
+
+// Sorts the given face edges on the lowest num_bits bits of their keys
+// with a stable least-significant-digit radix sort, using work as scratch
+// space. Threads (if available) each histogram and scatter a contiguous
+// chunk of the array.
+static void radix_sort_face_edges(face_edge_t* edges,
+                                  face_edge_t* work,
+                                  size_t num_edges,
+                                  int num_bits)
+{
+#define RADIX_BITS 8
+#define RADIX (1 << RADIX_BITS)
+  face_edge_t* src = edges;
+  face_edge_t* dest = work;
+  for (int shift = 0; shift < num_bits; shift += RADIX_BITS)
+  {
+#if POLYMEC_HAVE_OPENMP
+    int num_threads = omp_get_max_threads();
+#else
+    int num_threads = 1;
+#endif
+    size_t* counts = polymec_calloc((size_t)(num_threads * RADIX), sizeof(size_t));
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif
+    {
+#if POLYMEC_HAVE_OPENMP
+      int tid = omp_get_thread_num();
+      int nt = omp_get_num_threads();
+#else
+      int tid = 0, nt = 1;
+#endif
+      size_t begin = num_edges * (size_t)tid / (size_t)nt;
+      size_t end = num_edges * (size_t)(tid+1) / (size_t)nt;
+      size_t* my_counts = &counts[tid * RADIX];
+      for (size_t i = begin; i < end; ++i)
+        ++my_counts[(src[i].key >> shift) & (RADIX-1)];
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
       {
-        mesh->face_areas[actual_face] = face_area;
-        vector_normalize(&face_normal);
-
-        // Flip the normal vector if we need to.
-        // FIXME: We should revisit the above code so this isn't needed.
-        vector_t outward;
-        point_t* xf = &(mesh->face_centers[actual_face]);
-        point_displacement(&(mesh->cell_centers[cell]), xf, &outward);
-        real_t n_o_cf = vector_dot(&face_normal, &outward);
-        if (n_o_cf < 0.0)
-        {
-          if (face == actual_face)
-            vector_scale(&face_normal, -1.0);
-        }
-        else if (n_o_cf > 0.0)
+        // Compute each thread's offset for each digit, preserving the
+        // order of the chunks so that the sort is stable.
+        size_t offset = 0;
+        for (int d = 0; d < RADIX; ++d)
         {
-          if (face != actual_face)
-            vector_scale(&face_normal, -1.0);
+          for (int t = 0; t < nt; ++t)
+          {
+            size_t count = counts[t * RADIX + d];
+            counts[t * RADIX + d] = offset;
+            offset += count;
+          }
         }
-        mesh->face_normals[actual_face] = face_normal;
+      }
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        size_t d = (src[i].key >> shift) & (RADIX-1);
+        dest[my_counts[d]] = src[i];
+        ++my_counts[d];
       }
     }
+    polymec_free(counts);
+
+    face_edge_t* tmp = src;
+    src = dest;
+    dest = tmp;
   }
+  if (src != edges)
+    memcpy(edges, src, sizeof(face_edge_t) * num_edges);
+#undef RADIX
+#undef RADIX_BITS
 }
 
 void polymesh_construct_edges(polymesh_t* mesh)
 {
   ASSERT(mesh->num_edges == 0);
   ASSERT(mesh->edge_nodes == NULL);
+  START_FUNCTION_TIMER();
 
-  // Allocate initial face->edge storage.
+  // Allocate face->edge storage.
+  int num_slots = mesh->face_node_offsets[mesh->num_faces];
   if (mesh->storage->face_edge_capacity != mesh->storage->face_node_capacity)
   {
     mesh->storage->face_edge_capacity = mesh->storage->face_node_capacity;
     mesh->face_edges = polymec_realloc(mesh->face_edges, sizeof(int) * mesh->storage->face_edge_capacity);
   }
-
-  // Construct edge information.
-  int_table_t* edge_for_nodes = int_table_new();
+  ASSERT(mesh->storage->face_edge_capacity >= num_slots);
   memcpy(mesh->face_edge_offsets, mesh->face_node_offsets, sizeof(int) * (mesh->num_faces + 1));
+  if (num_slots == 0)
   {
-    int num_edges = 0;
-    for (int f = 0; f < mesh->num_faces; ++f)
-    {
-      int offset = mesh->face_edge_offsets[f];
-      int num_face_edges = mesh->face_edge_offsets[f+1] - offset;
-      for (int e = 0; e < num_face_edges; ++e)
-      {
-        // Make room.
-        if (mesh->storage->face_edge_capacity <= offset+e)
-        {
-          while (mesh->storage->face_edge_capacity <= offset+e)
-            mesh->storage->face_edge_capacity *= 2;
-          mesh->face_edges = polymec_realloc(mesh->face_edges, sizeof(int) * mesh->storage->face_edge_capacity);
-        }
+    STOP_FUNCTION_TIMER();
+    return;
+  }
 
-        int n1 = (int)mesh->face_nodes[offset+e];
-        int n2 = (int)mesh->face_nodes[offset+(e+1)%num_face_edges];
-        if (!int_table_contains(edge_for_nodes, MIN(n1, n2), MAX(n1, n2)))
-        {
-          int_table_insert(edge_for_nodes, MIN(n1, n2), MAX(n1, n2), num_edges);
-          mesh->face_edges[offset+e] = num_edges;
-          ++num_edges;
-        }
-        else
-          mesh->face_edges[offset+e] = *int_table_get(edge_for_nodes, MIN(n1, n2), MAX(n1, n2));
-      }
-    }
-    if (num_edges > 0)
+  // Emit the edge of every face slot, keyed on its sorted pair of nodes.
+  int node_bits = 1;
+  while ((1 << node_bits) < mesh->num_nodes)
+    ++node_bits;
+  face_edge_t* edges = polymec_malloc(sizeof(face_edge_t) * num_slots);
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int offset = mesh->face_edge_offsets[f];
+    int num_face_edges = mesh->face_edge_offsets[f+1] - offset;
+    for (int e = 0; e < num_face_edges; ++e)
     {
-      mesh->num_edges = num_edges;
-      mesh->edge_nodes = polymec_malloc(2 * sizeof(int) * mesh->num_edges);
-      int_table_cell_pos_t pos = int_table_start(edge_for_nodes);
-      int n1, n2, e;
-      while (int_table_next_cell(edge_for_nodes, &pos, &n1, &n2, &e))
-      {
-        mesh->edge_nodes[2*e] = n1;
-        mesh->edge_nodes[2*e+1] = n2;
-      }
+      int n1 = mesh->face_nodes[offset+e];
+      int n2 = mesh->face_nodes[offset+(e+1)%num_face_edges];
+      edges[offset+e].key = ((uint64_t)MIN(n1, n2) << node_bits) | (uint64_t)MAX(n1, n2);
+      edges[offset+e].slot = offset+e;
     }
   }
-  int_table_free(edge_for_nodes);
+
+  // Sort the face edges so that the slots sharing an edge form a run.
+  // Since the sort is stable, each run begins with its lowest slot.
+  face_edge_t* work = polymec_malloc(sizeof(face_edge_t) * num_slots);
+  radix_sort_face_edges(edges, work, (size_t)num_slots, 2*node_bits);
+  polymec_free(work);
+
+  // Number the edges in the order in which faces first encounter them by
+  // marking the first slot of each run and scanning the marks in slot order.
+  int* edge_ids = polymec_calloc(num_slots, sizeof(int));
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_slots; ++i)
+  {
+    if ((i == 0) || (edges[i].key != edges[i-1].key))
+      edge_ids[edges[i].slot] = 1;
+  }
+  int num_edges = 0;
+  for (int i = 0; i < num_slots; ++i)
+  {
+    int is_first = edge_ids[i];
+    edge_ids[i] = num_edges;
+    num_edges += is_first;
+  }
+
+  // Assign each run's edge to its slots, and record the edge's nodes.
+  mesh->num_edges = num_edges;
+  mesh->edge_nodes = polymec_malloc(2 * sizeof(int) * mesh->num_edges);
+  uint64_t node_mask = ((uint64_t)1 << node_bits) - 1;
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_slots; ++i)
+  {
+    if ((i > 0) && (edges[i].key == edges[i-1].key)) continue;
+    int edge = edge_ids[edges[i].slot];
+    mesh->edge_nodes[2*edge] = (int)(edges[i].key >> node_bits);
+    mesh->edge_nodes[2*edge+1] = (int)(edges[i].key & node_mask);
+    for (int j = i; (j < num_slots) && (edges[j].key == edges[i].key); ++j)
+      mesh->face_edges[edges[j].slot] = edge;
+  }
+  polymec_free(edge_ids);
+  polymec_free(edges);
+  STOP_FUNCTION_TIMER();
 }
 
 void polymesh_reserve_connectivity_storage(polymesh_t* mesh)
@@ -1237,19 +1594,155 @@ adj_graph_t* graph_from_polymesh_cells(polymesh_t* mesh)
   return g;
 }
 
+// Discards the mesh's interior/boundary partitions.
+static void clear_partitions(polymesh_t* mesh)
+{
+  polymesh_storage_t* storage = mesh->storage;
+  if (storage->cell_partition != NULL)
+  {
+    polymec_free(storage->cell_partition);
+    polymec_free(storage->face_partition);
+    storage->cell_partition = NULL;
+    storage->face_partition = NULL;
+    storage->num_interior_cells = 0;
+    storage->num_interior_faces = 0;
+  }
+}
+
+// Partitions the locally-owned cells and faces of the mesh into those that
+// depend only on locally-owned cells (interior) and those that depend on
+// ghost cells filled by the cell exchanger (boundary).
+static void compute_partitions(polymesh_t* mesh)
+{
+  START_FUNCTION_TIMER();
+  polymesh_storage_t* storage = mesh->storage;
+  int num_all_cells = mesh->num_cells + mesh->num_ghost_cells;
+
+  // Mark the cells that receive data in an exchange.
+  bool* received = polymec_calloc(MAX(num_all_cells, 1), sizeof(bool));
+  exchanger_t* ex = polymesh_exchanger(mesh, POLYMESH_CELL);
+  int pos = 0, proc, *indices, num_indices;
+  while (exchanger_next_receive(ex, &pos, &proc, &indices, &num_indices))
+  {
+    for (int i = 0; i < num_indices; ++i)
+    {
+      ASSERT(indices[i] < num_all_cells);
+      received[indices[i]] = true;
+    }
+  }
+
+  // A face is on the boundary if it's attached to a received cell, and a
+  // cell is on the boundary if one of its faces is.
+  bool* boundary_face = polymec_calloc(MAX(mesh->num_faces, 1), sizeof(bool));
+  bool* boundary_cell = polymec_calloc(MAX(mesh->num_cells, 1), sizeof(bool));
+  int num_interior_faces = mesh->num_faces;
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int c1 = mesh->face_cells[2*f], c2 = mesh->face_cells[2*f+1];
+    if (received[c1] || ((c2 != -1) && received[c2]))
+    {
+      boundary_face[f] = true;
+      --num_interior_faces;
+      if (c1 < mesh->num_cells)
+        boundary_cell[c1] = true;
+      if ((c2 != -1) && (c2 < mesh->num_cells))
+        boundary_cell[c2] = true;
+    }
+  }
+  int num_interior_cells = mesh->num_cells;
+  for (int c = 0; c < mesh->num_cells; ++c)
+  {
+    if (boundary_cell[c])
+      --num_interior_cells;
+  }
+
+  // Interior elements come first, followed by boundary elements.
+  storage->face_partition = polymec_malloc(sizeof(int) * MAX(mesh->num_faces, 1));
+  int i = 0, b = num_interior_faces;
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    if (boundary_face[f])
+      storage->face_partition[b++] = f;
+    else
+      storage->face_partition[i++] = f;
+  }
+  storage->num_interior_faces = num_interior_faces;
+  storage->cell_partition = polymec_malloc(sizeof(int) * MAX(mesh->num_cells, 1));
+  i = 0;
+  b = num_interior_cells;
+  for (int c = 0; c < mesh->num_cells; ++c)
+  {
+    if (boundary_cell[c])
+      storage->cell_partition[b++] = c;
+    else
+      storage->cell_partition[i++] = c;
+  }
+  storage->num_interior_cells = num_interior_cells;
+
+  polymec_free(boundary_face);
+  polymec_free(boundary_cell);
+  polymec_free(received);
+  log_debug("polymesh: %d of %d cells and %d of %d faces are interior.",
+            num_interior_cells, mesh->num_cells, num_interior_faces, mesh->num_faces);
+  STOP_FUNCTION_TIMER();
+}
+
+void polymesh_get_cell_partition(polymesh_t* mesh,
+                                 int** interior_cells,
+                                 int* num_interior_cells,
+                                 int** boundary_cells,
+                                 int* num_boundary_cells)
+{
+  polymesh_storage_t* storage = mesh->storage;
+  if (storage->cell_partition == NULL)
+    compute_partitions(mesh);
+  *interior_cells = storage->cell_partition;
+  *num_interior_cells = storage->num_interior_cells;
+  *boundary_cells = &storage->cell_partition[storage->num_interior_cells];
+  *num_boundary_cells = mesh->num_cells - storage->num_interior_cells;
+}
+
+void polymesh_get_face_partition(polymesh_t* mesh,
+                                 int** interior_faces,
+                                 int* num_interior_faces,
+                                 int** boundary_faces,
+                                 int* num_boundary_faces)
+{
+  polymesh_storage_t* storage = mesh->storage;
+  if (storage->face_partition == NULL)
+    compute_partitions(mesh);
+  *interior_faces = storage->face_partition;
+  *num_interior_faces = storage->num_interior_faces;
+  *boundary_faces = &storage->face_partition[storage->num_interior_faces];
+  *num_boundary_faces = mesh->num_faces - storage->num_interior_faces;
+}
+
 exchanger_t* polymesh_exchanger(polymesh_t* mesh,
                                 polymesh_centering_t centering)
 {
-  if ((centering == POLYMESH_FACE) &&
-      (mesh->storage->exchangers[(int)centering] == NULL))
-    mesh->storage->exchangers[(int)centering] = create_face_exchanger(mesh);
-  else if ((centering == POLYMESH_EDGE) &&
-           (mesh->storage->exchangers[(int)centering] == NULL))
-    mesh->storage->exchangers[(int)centering] = create_edge_exchanger(mesh);
-  else if ((centering == POLYMESH_NODE) &&
-           (mesh->storage->exchangers[(int)centering] == NULL))
-    mesh->storage->exchangers[(int)centering] = create_node_exchanger(mesh);
-  return mesh->storage->exchangers[(int)centering];
+  // Face, edge, and node exchangers are built the first time they're needed.
+  exchanger_t** ex_p = &mesh->storage->exchangers[(int)centering];
+  if (*ex_p == NULL)
+  {
+    static const char* centering_names[] = {"node", "edge", "face", "cell"};
+    double t1 = MPI_Wtime();
+    if (centering == POLYMESH_FACE)
+      *ex_p = create_face_exchanger(mesh);
+    else if (centering == POLYMESH_EDGE)
+      *ex_p = create_edge_exchanger(mesh);
+    else
+    {
+      ASSERT(centering == POLYMESH_NODE);
+      *ex_p = create_node_exchanger(mesh);
+    }
+    if (log_level() == LOG_DEBUG)
+    {
+      size_t bytes = serializer_size(exchanger_serializer(), *ex_p);
+      log_debug("polymesh: Built %s exchanger in %g s (%zu bytes).",
+                centering_names[centering], MPI_Wtime() - t1, bytes);
+    }
+  }
+  return *ex_p;
 }
 
 void polymesh_set_exchanger(polymesh_t* mesh,
@@ -1262,5 +1755,188 @@ void polymesh_set_exchanger(polymesh_t* mesh,
   ASSERT(ex != NULL);
   release_ref(mesh->storage->exchangers[(int)centering]);
   mesh->storage->exchangers[(int)centering] = ex;
+  if (centering == POLYMESH_CELL)
+    clear_partitions(mesh);
+}
+
+void polymesh_permute_exchangers(polymesh_t* mesh,
+                                 int* cell_perm,
+                                 int* face_perm,
+                                 int* edge_perm,
+                                 int* node_perm)
+{
+  int* perms[4] = {node_perm, edge_perm, face_perm, cell_perm};
+  int sizes[4] = {mesh->num_nodes, mesh->num_edges, mesh->num_faces, mesh->num_cells};
+  for (int cent = 0; cent < 4; ++cent)
+  {
+    exchanger_t* ex = mesh->storage->exchangers[cent];
+    if ((ex == NULL) || (perms[cent] == NULL)) continue;
+
+    int pos = 0, proc, *indices, num_indices;
+    while (exchanger_next_send(ex, &pos, &proc, &indices, &num_indices))
+    {
+      for (int i = 0; i < num_indices; ++i)
+        if (indices[i] < sizes[cent])
+          indices[i] = perms[cent][indices[i]];
+    }
+    pos = 0;
+    while (exchanger_next_receive(ex, &pos, &proc, &indices, &num_indices))
+    {
+      for (int i = 0; i < num_indices; ++i)
+        if (indices[i] < sizes[cent])
+          indices[i] = perms[cent][indices[i]];
+    }
+  }
+}
+
+// Colors the faces of the given mesh so that no two faces of the same color
+// share a cell. This is a greedy (first-fit) coloring of the graph in which
+// two faces are adjacent if they share a (local or ghost) cell, visiting the
+// faces in order so that each color's faces are listed in ascending order.
+static void compute_face_coloring(polymesh_t* mesh)
+{
+  START_FUNCTION_TIMER();
+  int num_faces = mesh->num_faces;
+  int num_cells = mesh->num_cells + mesh->num_ghost_cells;
+
+  // Build cell->face connectivity for all cells, including ghosts.
+  int* cell_face_offsets = polymec_calloc(num_cells+1, sizeof(int));
+  for (int f = 0; f < num_faces; ++f)
+  {
+    ++cell_face_offsets[mesh->face_cells[2*f]+1];
+    if (mesh->face_cells[2*f+1] != -1)
+      ++cell_face_offsets[mesh->face_cells[2*f+1]+1];
+  }
+  int max_cell_faces = 0;
+  for (int c = 0; c < num_cells; ++c)
+  {
+    max_cell_faces = MAX(max_cell_faces, cell_face_offsets[c+1]);
+    cell_face_offsets[c+1] += cell_face_offsets[c];
+  }
+  int* cell_faces = polymec_malloc(sizeof(int) * MAX(cell_face_offsets[num_cells], 1));
+  int* cell_counts = polymec_calloc(num_cells, sizeof(int));
+  for (int f = 0; f < num_faces; ++f)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      int c = mesh->face_cells[2*f+i];
+      if (c != -1)
+      {
+        cell_faces[cell_face_offsets[c] + cell_counts[c]] = f;
+        ++cell_counts[c];
+      }
+    }
+  }
+  polymec_free(cell_counts);
+
+  // Give each face the smallest color not used by a face sharing one of its
+  // cells. A face has fewer than 2*max_cell_faces such faces, which bounds
+  // the number of colors.
+  int max_colors = MAX(2*max_cell_faces, 1);
+  int* colors = polymec_malloc(sizeof(int) * MAX(num_faces, 1));
+  int* forbidden = polymec_malloc(sizeof(int) * max_colors);
+  for (int color = 0; color < max_colors; ++color)
+    forbidden[color] = -1;
+  int num_colors = 0;
+  for (int f = 0; f < num_faces; ++f)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      int c = mesh->face_cells[2*f+i];
+      if (c == -1) continue;
+      for (int j = cell_face_offsets[c]; j < cell_face_offsets[c+1]; ++j)
+      {
+        int g = cell_faces[j];
+        if (g < f)
+          forbidden[colors[g]] = f;
+      }
+    }
+    int color = 0;
+    while (forbidden[color] == f) ++color;
+    ASSERT(color < max_colors);
+    colors[f] = color;
+    num_colors = MAX(num_colors, color+1);
+  }
+  polymec_free(forbidden);
+  polymec_free(cell_faces);
+  polymec_free(cell_face_offsets);
+
+  // Sort the faces by color, keeping them in ascending order within each.
+  polymesh_storage_t* storage = mesh->storage;
+  storage->num_face_colors = num_colors;
+  storage->face_color_offsets = polymec_calloc(num_colors+1, sizeof(int));
+  storage->face_colors = polymec_malloc(sizeof(int) * MAX(num_faces, 1));
+  for (int f = 0; f < num_faces; ++f)
+    ++storage->face_color_offsets[colors[f]+1];
+  for (int color = 0; color < num_colors; ++color)
+    storage->face_color_offsets[color+1] += storage->face_color_offsets[color];
+  int next[MAX(num_colors, 1)];
+  memcpy(next, storage->face_color_offsets, sizeof(int) * num_colors);
+  for (int f = 0; f < num_faces; ++f)
+    storage->face_colors[next[colors[f]]++] = f;
+  polymec_free(colors);
+
+  log_debug("polymesh: colored %d faces with %d colors.", num_faces,
+            storage->num_face_colors);
+  STOP_FUNCTION_TIMER();
+}
+
+int polymesh_num_face_colors(polymesh_t* mesh)
+{
+  if (mesh->storage->face_color_offsets == NULL)
+    compute_face_coloring(mesh);
+  return mesh->storage->num_face_colors;
+}
+
+int* polymesh_face_color(polymesh_t* mesh, int color, int* num_faces)
+{
+  ASSERT(color >= 0);
+  ASSERT(color < polymesh_num_face_colors(mesh));
+  polymesh_storage_t* storage = mesh->storage;
+  int offset = storage->face_color_offsets[color];
+  *num_faces = storage->face_color_offsets[color+1] - offset;
+  return &storage->face_colors[offset];
 }
 
+void polymesh_foreach_face_parallel(polymesh_t* mesh,
+                                    void (*func)(void* context, polymesh_t* mesh, int face),
+                                    void* context)
+{
+  int num_colors = polymesh_num_face_colors(mesh);
+  for (int color = 0; color < num_colors; ++color)
+  {
+    int num_faces;
+    int* faces = polymesh_face_color(mesh, color, &num_faces);
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < num_faces; ++i)
+      func(context, mesh, faces[i]);
+  }
+}
+
+void polymesh_clear_cached_connectivity(polymesh_t* mesh)
+{
+  polymesh_storage_t* storage = mesh->storage;
+  if (storage->face_color_offsets != NULL)
+  {
+    polymec_free(storage->face_color_offsets);
+    polymec_free(storage->face_colors);
+    storage->face_color_offsets = NULL;
+    storage->face_colors = NULL;
+    storage->num_face_colors = 0;
+  }
+  if (storage->node_face_offsets != NULL)
+  {
+    polymec_free(storage->node_face_offsets);
+    polymec_free(storage->node_faces);
+    storage->node_face_offsets = NULL;
+    storage->node_faces = NULL;
+  }
+  if (storage->face_flipped != NULL)
+  {
+    polymec_free(storage->face_flipped);
+    storage->face_flipped = NULL;
+  }
+  clear_partitions(mesh);
+}
@@ -133,12 +133,35 @@ polymesh_t* polymesh_clone(polymesh_t* mesh);
 
 /// Returns an exchanger object that can be used to perform parallel exchanges
 /// on polymesh fields with the given centering. In serial configurations,
-/// this exchanger holds no data, and exchanges have no effect.
+/// this exchanger holds no data, and exchanges have no effect. Face, edge,
+/// and node exchangers are built the first time they are requested and
+/// cached in the mesh, so meshes that only exchange cell data never pay for
+/// them. The time and memory spent building each one is logged at the
+/// debug level.
 /// \param [in] centering The centering of the data handled by this exchanger.
 /// \memberof polymesh
 exchanger_t* polymesh_exchanger(polymesh_t* mesh,
                                 polymesh_centering_t centering);
 
+/// Discards the mesh's cached face coloring, node->face connectivity, face
+/// orientations, and interior/boundary partitions, which are recomputed when
+/// next needed. Call
+/// this after changing the mesh's connectivity.
+/// \memberof polymesh
+void polymesh_clear_cached_connectivity(polymesh_t* mesh);
+
+/// Renumbers the indices in the mesh's cached exchangers according to the
+/// given permutations, which map old element indices to new ones, so that
+/// the exchangers stay valid after the mesh's elements are reordered (see
+/// \ref reorder_polymesh). Ghost cells (indices >= num_cells) are left
+/// alone, as are exchangers whose permutations are NULL.
+/// \memberof polymesh
+void polymesh_permute_exchangers(polymesh_t* mesh,
+                                 int* cell_perm,
+                                 int* face_perm,
+                                 int* edge_perm,
+                                 int* node_perm);
+
 /// Returns a newly-allocated list of indices that will define a tags for
 /// cells/faces/edges/nodes with the given descriptor. If the tag already
 /// exists, returns NULL.
@@ -167,10 +190,22 @@ void polymesh_delete_tag(tagger_t* tagger, const char* tag);
 bool polymesh_next_tag(tagger_t* tagger, int* pos, char** tag_name, int** tag_indices, size_t* tag_size);
 
 /// Computes face areas and cell volumes for the polymesh (for those that are
-/// bounded).
+/// bounded). The geometry of each face is computed once, and faces and cells
+/// are processed in parallel with OpenMP threads (when available).
 /// \memberof polymesh
 void polymesh_compute_geometry(polymesh_t* mesh);
 
+/// Recomputes the geometry of the faces and cells affected by the motion of
+/// the given nodes, leaving that of the rest of the mesh alone. This is
+/// cheaper than \ref polymesh_compute_geometry when only part of the mesh
+/// moves.
+/// \param [in] moved_nodes An array of indices of nodes that have moved.
+/// \param [in] num_moved_nodes The number of moved nodes.
+/// \memberof polymesh
+void polymesh_update_geometry(polymesh_t* mesh,
+                              int* moved_nodes,
+                              size_t num_moved_nodes);
+
 /// This helper method makes sure that sufficient storage is reserved for
 /// cell-face and face->node connectivity. This must be called after
 /// the mesh->cell_face_offsets and mesh->face_node_offsets arrays have been
@@ -436,6 +471,63 @@ static inline bool polymesh_face_is_external(polymesh_t* mesh, int face)
   return (mesh->face_cells[2*face+1] == -1);
 }
 
+/// Returns the number of colors in a coloring of the mesh's faces in which
+/// no two faces of the same color share a cell (locally-owned or ghost).
+/// Faces of a single color can be processed concurrently without conflicting
+/// writes to cell data. The coloring is computed the first time it's needed
+/// and cached within the mesh.
+/// \memberof polymesh
+int polymesh_num_face_colors(polymesh_t* mesh);
+
+/// Returns an internal array containing the (ascending) indices of the faces
+/// with the given color, storing the number of these faces in num_faces.
+/// \param [in] color A color within [0, \ref polymesh_num_face_colors(mesh)).
+/// \memberof polymesh
+int* polymesh_face_color(polymesh_t* mesh, int color, int* num_faces);
+
+/// Calls func(context, mesh, face) for every face in the mesh, traversing the
+/// face colors in order and processing the faces within each color in
+/// parallel with OpenMP threads (when available). func may thus scatter into
+/// the cells of its face without atomics or locks.
+/// \param [in] func A function called for each face.
+/// \param [in] context A context pointer passed to func.
+/// \memberof polymesh
+void polymesh_foreach_face_parallel(polymesh_t* mesh,
+                                    void (*func)(void* context, polymesh_t* mesh, int face),
+                                    void* context);
+
+/// Retrieves internal arrays that partition the locally-owned cells of the
+/// mesh into interior cells, none of whose neighbors receive data from the
+/// mesh's cell exchanger, and boundary cells, which neighbor at least one such
+/// (ghost) cell. Interior cells can be processed while an exchange of cell
+/// data is in flight. The partition is computed the first time it's needed
+/// and cached within the mesh.
+/// \param [out] interior_cells Stores an array of interior cells.
+/// \param [out] num_interior_cells Stores the number of interior cells.
+/// \param [out] boundary_cells Stores an array of boundary cells.
+/// \param [out] num_boundary_cells Stores the number of boundary cells.
+/// \memberof polymesh
+void polymesh_get_cell_partition(polymesh_t* mesh,
+                                 int** interior_cells,
+                                 int* num_interior_cells,
+                                 int** boundary_cells,
+                                 int* num_boundary_cells);
+
+/// Retrieves internal arrays that partition the faces of the mesh into
+/// interior faces, whose cells are all locally owned, and boundary faces,
+/// which are attached to a ghost cell filled by the mesh's cell exchanger.
+/// Like the cell partition, this is computed once and cached.
+/// \param [out] interior_faces Stores an array of interior faces.
+/// \param [out] num_interior_faces Stores the number of interior faces.
+/// \param [out] boundary_faces Stores an array of boundary faces.
+/// \param [out] num_boundary_faces Stores the number of boundary faces.
+/// \memberof polymesh
+void polymesh_get_face_partition(polymesh_t* mesh,
+                                 int** interior_faces,
+                                 int* num_interior_faces,
+                                 int** boundary_faces,
+                                 int* num_boundary_faces);
+
 /// Returns a serializer object that can read/write polymeshes from/to byte arrays.
 /// \memberof polymesh
 serializer_t* polymesh_serializer(void);
@@ -100,6 +100,30 @@ bool polymesh_field_is_exchanging(polymesh_field_t* field)
   return (field->ex_token != -1);
 }
 
+void polymesh_field_exchange_and_compute(polymesh_field_t* field,
+                                         polymesh_centering_t centering,
+                                         void (*kernel)(void* context, polymesh_t* mesh, int* elements, int num_elements),
+                                         void* context)
+{
+  ASSERT(field->centering == POLYMESH_CELL);
+  ASSERT((centering == POLYMESH_CELL) || (centering == POLYMESH_FACE));
+  START_FUNCTION_TIMER();
+
+  int *interior, num_interior, *boundary, num_boundary;
+  if (centering == POLYMESH_CELL)
+    polymesh_get_cell_partition(field->mesh, &interior, &num_interior, &boundary, &num_boundary);
+  else
+    polymesh_get_face_partition(field->mesh, &interior, &num_interior, &boundary, &num_boundary);
+
+  polymesh_field_start_exchange(field);
+  if (num_interior > 0)
+    kernel(context, field->mesh, interior, num_interior);
+  polymesh_field_finish_exchange(field);
+  if (num_boundary > 0)
+    kernel(context, field->mesh, boundary, num_boundary);
+  STOP_FUNCTION_TIMER();
+}
+
 void polymesh_field_set_exchanger(polymesh_field_t* field, exchanger_t* ex)
 {
   if (field->ex != NULL)
@@ -87,6 +87,22 @@ void polymesh_field_finish_exchange(polymesh_field_t* field);
 /// \memberof polymesh_field
 bool polymesh_field_is_exchanging(polymesh_field_t* field);
 
+/// Exchanges the ghost values of this cell-centered field while computing
+/// with its interior values. The given kernel is called on the mesh's interior
+/// cells or faces (see \ref polymesh_get_cell_partition and
+/// \ref polymesh_get_face_partition) while the exchange is in flight, and on
+/// the boundary cells or faces after it has finished.
+/// \param [in] centering The centering of the elements passed to the kernel
+///                       (\ref POLYMESH_CELL or \ref POLYMESH_FACE).
+/// \param [in] kernel A function called with a context pointer, the mesh, and
+///                    an array of elements and its length.
+/// \param [in] context A context pointer passed to the kernel.
+/// \memberof polymesh_field
+void polymesh_field_exchange_and_compute(polymesh_field_t* field,
+                                         polymesh_centering_t centering,
+                                         void (*kernel)(void* context, polymesh_t* mesh, int* elements, int num_elements),
+                                         void* context);
+
 /// Sets the exchanger used by the field for exchanges.
 /// Use this method instead of directly assigning a new exchanger to the field.
 /// \param [in] ex The exchanger to be used by this field.
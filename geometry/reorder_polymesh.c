@@ -0,0 +1,428 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "core/hilbert.h"
+#include "core/timer.h"
+#include "geometry/reorder_polymesh.h"
+
+void polymesh_permutation_free(polymesh_permutation_t* perm)
+{
+  if (perm->edges != NULL)
+    polymec_free(perm->edges);
+  polymec_free(perm->nodes);
+  polymec_free(perm->faces);
+  polymec_free(perm->cells);
+  polymec_free(perm);
+}
+
+// A sort key attached to a mesh element.
+typedef struct
+{
+  index_t key;
+  int index;
+} element_key_t;
+
+static int element_key_cmp(const void* l, const void* r)
+{
+  const element_key_t* lk = l;
+  const element_key_t* rk = r;
+  if (lk->key != rk->key)
+    return (lk->key < rk->key) ? -1 : 1;
+  else
+    return (lk->index < rk->index) ? -1 : (lk->index > rk->index) ? 1 : 0;
+}
+
+// Sorts the given keys and stores the resulting permutation (old -> new).
+static void sort_keys_to_perm(element_key_t* keys, int num_keys, int* perm)
+{
+  qsort(keys, (size_t)num_keys, sizeof(element_key_t), element_key_cmp);
+  for (int i = 0; i < num_keys; ++i)
+    perm[keys[i].index] = i;
+}
+
+// Returns the number of locally-owned neighbors of the given cell.
+static int cell_degree(polymesh_t* mesh, int cell)
+{
+  int degree = 0, pos = 0, neighbor;
+  while (polymesh_cell_next_neighbor(mesh, cell, &pos, &neighbor))
+  {
+    if ((neighbor >= 0) && (neighbor < mesh->num_cells))
+      ++degree;
+  }
+  return degree;
+}
+
+// Performs a breadth-first traversal of the cells connected to the given
+// root (among those not marked), marking them and appending them to queue
+// in the order of traversal, with neighbors visited in order of increasing
+// degree. Returns the number of cells traversed, and stores the number of
+// levels in the traversal and the position in the queue of the first cell
+// in the last level.
+static int traverse_cells(polymesh_t* mesh, int root, int* degrees,
+                          bool* marked, int* queue,
+                          int* num_levels, int* last_level)
+{
+  int head = 0, tail = 0, level_end = 1;
+  *num_levels = 1;
+  *last_level = 0;
+  queue[tail++] = root;
+  marked[root] = true;
+  while (head < tail)
+  {
+    int cell = queue[head++];
+    int first = tail, pos = 0, neighbor;
+    while (polymesh_cell_next_neighbor(mesh, cell, &pos, &neighbor))
+    {
+      if ((neighbor >= 0) && (neighbor < mesh->num_cells) && !marked[neighbor])
+      {
+        marked[neighbor] = true;
+
+        // Insert the neighbor in order of increasing degree.
+        int n = tail++;
+        while ((n > first) && (degrees[queue[n-1]] > degrees[neighbor]))
+        {
+          queue[n] = queue[n-1];
+          --n;
+        }
+        queue[n] = neighbor;
+      }
+    }
+    if ((head == level_end) && (head < tail))
+    {
+      ++(*num_levels);
+      *last_level = level_end;
+      level_end = tail;
+    }
+  }
+  return tail;
+}
+
+// Computes a reverse Cuthill-McKee ordering of the locally-owned cells.
+static void order_cells_by_rcm(polymesh_t* mesh, int* perm)
+{
+  int num_cells = mesh->num_cells;
+  int* degrees = polymec_malloc(sizeof(int) * num_cells);
+  for (int c = 0; c < num_cells; ++c)
+    degrees[c] = cell_degree(mesh, c);
+  bool* marked = polymec_calloc(num_cells, sizeof(bool));
+  bool* visited = polymec_calloc(num_cells, sizeof(bool));
+  int* order = polymec_malloc(sizeof(int) * num_cells);
+  int* queue = polymec_malloc(sizeof(int) * num_cells);
+
+  // Treat each connected component of the mesh separately.
+  int num_ordered = 0;
+  for (int c = 0; c < num_cells; ++c)
+  {
+    if (marked[c]) continue;
+
+    // Find a pseudo-peripheral root cell for this component: traverse from
+    // a lowest-degree cell in the last level of the previous traversal
+    // until the number of levels stops growing.
+    int root = c, max_levels = 0;
+    while (true)
+    {
+      int num_levels, last_level;
+      int n = traverse_cells(mesh, root, degrees, visited, queue,
+                             &num_levels, &last_level);
+      for (int i = 0; i < n; ++i)
+        visited[queue[i]] = false;
+      if (num_levels <= max_levels) break;
+      max_levels = num_levels;
+
+      int candidate = queue[last_level];
+      for (int i = last_level+1; i < n; ++i)
+      {
+        if (degrees[queue[i]] < degrees[candidate])
+          candidate = queue[i];
+      }
+      if (candidate == root) break;
+      root = candidate;
+    }
+
+    int num_levels, last_level;
+    int n = traverse_cells(mesh, root, degrees, marked, &order[num_ordered],
+                           &num_levels, &last_level);
+    num_ordered += n;
+  }
+  ASSERT(num_ordered == num_cells);
+
+  // Reverse the ordering.
+  for (int i = 0; i < num_cells; ++i)
+    perm[order[i]] = num_cells - 1 - i;
+
+  polymec_free(queue);
+  polymec_free(order);
+  polymec_free(visited);
+  polymec_free(marked);
+  polymec_free(degrees);
+}
+
+// Orders the locally-owned cells along a Hilbert curve through their centers.
+static void order_cells_by_hilbert_curve(polymesh_t* mesh, int* perm)
+{
+  int num_cells = mesh->num_cells;
+  if (num_cells == 0) return;
+
+  bbox_t bbox = {.x1 = REAL_MAX, .x2 = -REAL_MAX,
+                 .y1 = REAL_MAX, .y2 = -REAL_MAX,
+                 .z1 = REAL_MAX, .z2 = -REAL_MAX};
+  for (int c = 0; c < num_cells; ++c)
+    bbox_grow(&bbox, &mesh->cell_centers[c]);
+
+  // Make sure the bounding box has some extent in every direction.
+  real_t L = MAX(bbox.x2 - bbox.x1, MAX(bbox.y2 - bbox.y1, bbox.z2 - bbox.z1));
+  if (reals_equal(L, 0.0)) L = 1.0;
+  if (bbox.x2 - bbox.x1 < 1e-6*L) bbox.x2 = bbox.x1 + L;
+  if (bbox.y2 - bbox.y1 < 1e-6*L) bbox.y2 = bbox.y1 + L;
+  if (bbox.z2 - bbox.z1 < 1e-6*L) bbox.z2 = bbox.z1 + L;
+
+  hilbert_t* curve = hilbert_new(&bbox);
+  element_key_t* keys = polymec_malloc(sizeof(element_key_t) * num_cells);
+  for (int c = 0; c < num_cells; ++c)
+  {
+    keys[c].key = hilbert_index(curve, &mesh->cell_centers[c]);
+    keys[c].index = c;
+  }
+  sort_keys_to_perm(keys, num_cells, perm);
+  polymec_free(keys);
+  release_ref(curve);
+}
+
+// Orders faces by the (new) indices of the cells they connect.
+static void order_faces(polymesh_t* mesh, int* cell_perm, int* perm)
+{
+  index_t N = (index_t)mesh->num_cells + 1;
+  element_key_t* keys = polymec_malloc(sizeof(element_key_t) * mesh->num_faces);
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    // Ghost cells and missing cells sort after all local cells.
+    index_t cells[2];
+    for (int i = 0; i < 2; ++i)
+    {
+      int c = mesh->face_cells[2*f+i];
+      cells[i] = ((c >= 0) && (c < mesh->num_cells)) ? (index_t)cell_perm[c]
+                                                     : (index_t)mesh->num_cells;
+    }
+    keys[f].key = N * MIN(cells[0], cells[1]) + MAX(cells[0], cells[1]);
+    keys[f].index = f;
+  }
+  sort_keys_to_perm(keys, mesh->num_faces, perm);
+  polymec_free(keys);
+}
+
+// Numbers elements in the order in which they are first encountered in the
+// given face->element connectivity, traversing the faces in their new order.
+// Elements not attached to any face are numbered last.
+static void order_by_first_touch(int num_elements,
+                                 polymesh_t* mesh,
+                                 int* face_perm,
+                                 int* offsets,
+                                 int* connectivity,
+                                 int* perm)
+{
+  int* face_order = polymec_malloc(sizeof(int) * mesh->num_faces);
+  for (int f = 0; f < mesh->num_faces; ++f)
+    face_order[face_perm[f]] = f;
+
+  for (int i = 0; i < num_elements; ++i)
+    perm[i] = -1;
+  int next = 0;
+  for (int i = 0; i < mesh->num_faces; ++i)
+  {
+    int f = face_order[i];
+    for (int j = offsets[f]; j < offsets[f+1]; ++j)
+    {
+      int e = connectivity[j];
+      if (perm[e] == -1)
+        perm[e] = next++;
+    }
+  }
+  for (int i = 0; i < num_elements; ++i)
+  {
+    if (perm[i] == -1)
+      perm[i] = next++;
+  }
+  ASSERT(next == num_elements);
+  polymec_free(face_order);
+}
+
+polymesh_permutation_t* reorder_polymesh(polymesh_t* mesh,
+                                         polymesh_ordering_t ordering,
+                                         polymesh_field_t** fields,
+                                         size_t num_fields)
+{
+  START_FUNCTION_TIMER();
+  polymesh_permutation_t* perm = polymec_malloc(sizeof(polymesh_permutation_t));
+  perm->cells = polymec_malloc(sizeof(int) * mesh->num_cells);
+  perm->faces = polymec_malloc(sizeof(int) * mesh->num_faces);
+  perm->nodes = polymec_malloc(sizeof(int) * mesh->num_nodes);
+  perm->edges = NULL;
+
+  if (ordering == POLYMESH_RCM_ORDERING)
+    order_cells_by_rcm(mesh, perm->cells);
+  else
+    order_cells_by_hilbert_curve(mesh, perm->cells);
+  order_faces(mesh, perm->cells, perm->faces);
+  order_by_first_touch(mesh->num_nodes, mesh, perm->faces,
+                       mesh->face_node_offsets, mesh->face_nodes, perm->nodes);
+  if (mesh->num_edges > 0)
+  {
+    perm->edges = polymec_malloc(sizeof(int) * mesh->num_edges);
+    order_by_first_touch(mesh->num_edges, mesh, perm->faces,
+                         mesh->face_edge_offsets, mesh->face_edges, perm->edges);
+  }
+
+  permute_polymesh(mesh, perm, fields, num_fields);
+  STOP_FUNCTION_TIMER();
+  return perm;
+}
+
+// Renumbers a cell, leaving ghost cells and missing cells (-1) alone.
+static inline int permuted_cell(polymesh_t* mesh, int* cell_perm, int cell)
+{
+  return ((cell >= 0) && (cell < mesh->num_cells)) ? cell_perm[cell] : cell;
+}
+
+// Rearranges CRS connectivity (offsets and indices) for a new ordering of
+// its rows, renumbering the entries it contains. Negative entries are
+// one's complements of indices, and retain their sign.
+static void permute_crs(int num_rows,
+                        int* row_perm,
+                        int* entry_perm,
+                        int* offsets,
+                        int* entries)
+{
+  int* old_offsets = polymec_malloc(sizeof(int) * (num_rows+1));
+  memcpy(old_offsets, offsets, sizeof(int) * (num_rows+1));
+  int num_entries = offsets[num_rows];
+  int* old_entries = polymec_malloc(sizeof(int) * num_entries);
+  memcpy(old_entries, entries, sizeof(int) * num_entries);
+
+  int* row_order = polymec_malloc(sizeof(int) * num_rows);
+  for (int r = 0; r < num_rows; ++r)
+    row_order[row_perm[r]] = r;
+  offsets[0] = 0;
+  for (int r = 0; r < num_rows; ++r)
+  {
+    int old_r = row_order[r];
+    int n = old_offsets[old_r+1] - old_offsets[old_r];
+    offsets[r+1] = offsets[r] + n;
+    for (int j = 0; j < n; ++j)
+    {
+      int e = old_entries[old_offsets[old_r] + j];
+      entries[offsets[r] + j] = (e >= 0) ? entry_perm[e] : ~entry_perm[~e];
+    }
+  }
+
+  polymec_free(row_order);
+  polymec_free(old_entries);
+  polymec_free(old_offsets);
+}
+
+// Moves the given array of elements of the given size into the order
+// given by the permutation.
+static void permute_array(void* array, size_t elem_size, int num_elements, int* perm)
+{
+  if (num_elements == 0) return;
+  char* old_array = polymec_malloc(elem_size * num_elements);
+  memcpy(old_array, array, elem_size * num_elements);
+  for (int i = 0; i < num_elements; ++i)
+    memcpy(&((char*)array)[elem_size * perm[i]], &old_array[elem_size * i], elem_size);
+  polymec_free(old_array);
+}
+
+// Renumbers the indices in the tags of the given tagger. Indices outside
+// of [0, num_elements) are left alone.
+static void permute_tags(tagger_t* tagger, int num_elements, int* perm)
+{
+  int pos = 0;
+  char* tag_name;
+  int* tag_indices;
+  size_t tag_size;
+  while (tagger_next_tag(tagger, &pos, &tag_name, &tag_indices, &tag_size))
+  {
+    // The "properties" tag isn't a set of indices.
+    if (strcmp(tag_name, "properties") == 0) continue;
+    for (size_t i = 0; i < tag_size; ++i)
+    {
+      if ((tag_indices[i] >= 0) && (tag_indices[i] < num_elements))
+        tag_indices[i] = perm[tag_indices[i]];
+    }
+  }
+}
+
+void permute_polymesh(polymesh_t* mesh,
+                      polymesh_permutation_t* perm,
+                      polymesh_field_t** fields,
+                      size_t num_fields)
+{
+  START_FUNCTION_TIMER();
+  ASSERT((perm->edges != NULL) || (mesh->num_edges == 0));
+  ASSERT((fields != NULL) || (num_fields == 0));
+
+  // Cell -> face connectivity.
+  permute_crs(mesh->num_cells, perm->cells, perm->faces,
+              mesh->cell_face_offsets, mesh->cell_faces);
+
+  // Face -> node and face -> edge connectivity.
+  permute_crs(mesh->num_faces, perm->faces, perm->nodes,
+              mesh->face_node_offsets, mesh->face_nodes);
+  if (mesh->face_edges != NULL)
+  {
+    permute_crs(mesh->num_faces, perm->faces, perm->edges,
+                mesh->face_edge_offsets, mesh->face_edges);
+  }
+
+  // Face -> cell connectivity.
+  for (int f = 0; f < 2*mesh->num_faces; ++f)
+    mesh->face_cells[f] = permuted_cell(mesh, perm->cells, mesh->face_cells[f]);
+  permute_array(mesh->face_cells, 2*sizeof(int), mesh->num_faces, perm->faces);
+
+  // Edge -> node connectivity.
+  if (mesh->num_edges > 0)
+  {
+    for (int e = 0; e < 2*mesh->num_edges; ++e)
+      mesh->edge_nodes[e] = perm->nodes[mesh->edge_nodes[e]];
+    permute_array(mesh->edge_nodes, 2*sizeof(int), mesh->num_edges, perm->edges);
+  }
+
+  // Node positions and geometry.
+  permute_array(mesh->nodes, sizeof(point_t), mesh->num_nodes, perm->nodes);
+  permute_array(mesh->cell_volumes, sizeof(real_t), mesh->num_cells, perm->cells);
+  permute_array(mesh->cell_centers, sizeof(point_t), mesh->num_cells, perm->cells);
+  permute_array(mesh->face_centers, sizeof(point_t), mesh->num_faces, perm->faces);
+  permute_array(mesh->face_areas, sizeof(real_t), mesh->num_faces, perm->faces);
+  permute_array(mesh->face_normals, sizeof(vector_t), mesh->num_faces, perm->faces);
+
+  // Tags and exchangers.
+  permute_tags(mesh->cell_tags, mesh->num_cells, perm->cells);
+  permute_tags(mesh->face_tags, mesh->num_faces, perm->faces);
+  if (mesh->num_edges > 0)
+    permute_tags(mesh->edge_tags, mesh->num_edges, perm->edges);
+  permute_tags(mesh->node_tags, mesh->num_nodes, perm->nodes);
+  polymesh_permute_exchangers(mesh, perm->cells, perm->faces, perm->edges, perm->nodes);
+  polymesh_clear_cached_connectivity(mesh);
+
+  // Field data. Ghost values stay where they are.
+  for (size_t i = 0; i < num_fields; ++i)
+  {
+    polymesh_field_t* field = fields[i];
+    ASSERT(field->mesh == mesh);
+    int* field_perm = NULL;
+    switch (field->centering)
+    {
+      case POLYMESH_CELL: field_perm = perm->cells; break;
+      case POLYMESH_FACE: field_perm = perm->faces; break;
+      case POLYMESH_EDGE: field_perm = perm->edges; break;
+      case POLYMESH_NODE: field_perm = perm->nodes; break;
+    }
+    permute_array(field->data, sizeof(real_t) * field->num_components,
+                  (int)field->num_local_values, field_perm);
+  }
+  STOP_FUNCTION_TIMER();
+}
+
@@ -0,0 +1,78 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef POLYMEC_REORDER_POLYMESH_H
+#define POLYMEC_REORDER_POLYMESH_H
+
+#include "geometry/polymesh_field.h"
+
+/// \addtogroup geometry geometry
+///@{
+
+/// \enum polymesh_ordering_t
+/// Orderings for the locally-owned cells of a polymesh. Faces, edges, and
+/// nodes are ordered to follow the cells.
+typedef enum
+{
+  /// Reverse Cuthill-McKee ordering, which minimizes the bandwidth of the
+  /// cell adjacency graph.
+  POLYMESH_RCM_ORDERING,
+  /// Ordering along a Hilbert space-filling curve through the cell centers.
+  POLYMESH_HILBERT_ORDERING
+} polymesh_ordering_t;
+
+/// \class polymesh_permutation
+/// A permutation of the cells, faces, edges, and nodes of a polymesh. Each
+/// array maps the old index of an element to its new index. Ghost cells
+/// are never permuted.
+typedef struct
+{
+  /// cells[i] is the new index of the ith locally-owned cell.
+  int* cells;
+  /// faces[i] is the new index of the ith face.
+  int* faces;
+  /// edges[i] is the new index of the ith edge (NULL if the mesh has no edges).
+  int* edges;
+  /// nodes[i] is the new index of the ith node.
+  int* nodes;
+} polymesh_permutation_t;
+
+/// Destroys the given permutation.
+/// \memberof polymesh_permutation
+void polymesh_permutation_free(polymesh_permutation_t* perm);
+
+/// Renumbers the cells, faces, edges, and nodes of the given polymesh so that
+/// neighboring elements lie close together in memory, which speeds up loops
+/// that gather from face_cells or face_nodes on large meshes. Faces are
+/// sorted by the cells they connect, and nodes and edges are numbered in
+/// the order they are first encountered by the faces. The mesh's tags and
+/// exchangers are updated, as are the data in the given fields.
+/// \param [in] ordering The ordering used for the mesh's cells.
+/// \param [in,out] fields An array of fields defined on the mesh.
+/// \param [in] num_fields The number of fields in the array.
+/// \returns the permutation applied to the mesh, which should be freed with
+///          \ref polymesh_permutation_free.
+/// \relates polymesh
+polymesh_permutation_t* reorder_polymesh(polymesh_t* mesh,
+                                         polymesh_ordering_t ordering,
+                                         polymesh_field_t** fields,
+                                         size_t num_fields);
+
+/// Applies the given permutation to the given polymesh, its tags and
+/// exchangers, and the data in the given fields.
+/// \param [in] perm A permutation of the mesh's elements. If perm->edges is
+///                  NULL, the mesh must have no edges.
+/// \relates polymesh
+void permute_polymesh(polymesh_t* mesh,
+                      polymesh_permutation_t* perm,
+                      polymesh_field_t** fields,
+                      size_t num_fields);
+
+///@}
+
+#endif
+
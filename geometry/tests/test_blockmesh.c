@@ -62,7 +62,33 @@ static void test_repartition(void** state)
 {
   blockmesh_t* mesh = create_multiblock_mesh(MPI_COMM_SELF,
                                              2, 2, 10, 10, 0.9, 1.0);
-  repartition_blockmesh(&mesh, NULL, 0.05, NULL, 0);
+  repartition_blockmesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, NULL, 0);
+  blockmesh_free(mesh);
+}
+
+static void test_repartition_along_curve(void** state)
+{
+  blockmesh_t* mesh = create_multiblock_mesh(MPI_COMM_WORLD,
+                                             2, 2, 10, 10, 0.9, 1.0);
+  repartition_blockmesh(&mesh, HILBERT_CURVE_PARTITIONER, NULL, 0.05, NULL, 0);
+
+  // Make sure all patches are accounted for, and that each process has its
+  // share.
+  int num_patches = 0, num_all_patches = 0, pos = 0, b;
+  unimesh_t* block;
+  while (blockmesh_next_block(mesh, &pos, &b, &block))
+  {
+    int npx, npy, npz;
+    unimesh_get_extents(block, &npx, &npy, &npz);
+    num_patches += unimesh_num_patches(block);
+    num_all_patches += npx*npy*npz;
+  }
+  int nproc, total_num_patches, max_num_patches;
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+  MPI_Allreduce(&num_patches, &total_num_patches, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&num_patches, &max_num_patches, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  assert_int_equal(num_all_patches, total_num_patches);
+  assert_true(max_num_patches <= num_all_patches/nproc + 1);
   blockmesh_free(mesh);
 }
 
@@ -74,7 +100,8 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_serial_ctor),
     cmocka_unit_test(test_parallel_ctor),
     cmocka_unit_test(test_next_block),
-    cmocka_unit_test(test_repartition)
+    cmocka_unit_test(test_repartition),
+    cmocka_unit_test(test_repartition_along_curve)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -451,7 +451,7 @@ static void test_cell_field(void** state,
   blockmesh_field_t* f = blockmesh_field_new(mesh, UNIMESH_CELL, 2);
   initialize_field(sbr, coord_mappings, f);
 
-  repartition_blockmesh(&mesh, NULL, 0.05, &f, 1);
+  repartition_blockmesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, &f, 1);
 
   unmap_boundary_values(coord_mappings, f);
   blockmesh_field_update_boundaries(f, 0.0);
@@ -477,7 +477,7 @@ static void test_face_fields(void** state,
   initialize_field(sbr, coord_mappings, fz);
 
   blockmesh_field_t* fields[3] = {fx, fy, fz};
-  repartition_blockmesh(&mesh, NULL, 0.05, fields, 3);
+  repartition_blockmesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, fields, 3);
 
   unmap_boundary_values(coord_mappings, fx);
   blockmesh_field_start_updating_boundaries(fx, 0.0);
@@ -515,7 +515,7 @@ static void test_edge_fields(void** state,
   initialize_field(sbr, coord_mappings, fz);
 
   blockmesh_field_t* fields[3] = {fx, fy, fz};
-  repartition_blockmesh(&mesh, NULL, 0.05, fields, 3);
+  repartition_blockmesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, fields, 3);
 
   unmap_boundary_values(coord_mappings, fx);
   blockmesh_field_start_updating_boundaries(fx, 0.0);
@@ -548,7 +548,7 @@ static void test_node_field(void** state,
   blockmesh_field_t* f = blockmesh_field_new(mesh, UNIMESH_NODE, 2);
   initialize_field(sbr, coord_mappings, f);
 
-  repartition_blockmesh(&mesh, NULL, 0.05, &f, 1);
+  repartition_blockmesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, &f, 1);
 
   unmap_boundary_values(coord_mappings, f);
   blockmesh_field_update_boundaries(f, 0.0);
@@ -561,6 +561,231 @@ static void test_node_field(void** state,
     release_ref(coord_mappings[b]);
 }
 
+// The following tests transfer values between two blocks, each with 2x2x2
+// patches of 4x4x4 cells. Block 0 occupies [0, 8] x [0, 8] x [0, 8] in cell
+// widths, and block 1 occupies [8, 16] x [0, 8] x [0, 8], with its axes
+// turned about the x axis by some number of quarter turns. These turns are
+// counterclockwise as seen looking from block 0 into block 1 (in the +x
+// direction), which is how blockmesh counts rotations. The +x boundary of
+// each block is connected to the -x boundary of the other, so the pair is
+// periodic in x.
+static const int pair_block_n = 2, pair_patch_n = 4;
+
+// This table indicates whether values of each centering sit on nodes along
+// each axis.
+static const int on_nodes[8][3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+                                   {0, 1, 1}, {1, 0, 1}, {1, 1, 0}, {1, 1, 1}};
+
+// Maps a position within the given block (measured in half cell widths) to
+// its global position, wrapping periodically in x.
+static void pair_global_position(int block, int turns, int X[3], int Y[3])
+{
+  int L = 2 * pair_block_n * pair_patch_n;
+  Y[0] = (X[0] + block * L + 2 * L) % (2 * L);
+  Y[1] = X[1];
+  Y[2] = X[2];
+  if (block == 1)
+  {
+    for (int t = 0; t < turns; ++t)
+    {
+      int y = Y[1];
+      Y[1] = Y[2];
+      Y[2] = L - y;
+    }
+  }
+}
+
+// Returns the value that the given owning block stores at the given position
+// within the given block, which identifies the owner and the global position.
+static real_t pair_value(int owner, int block, int turns, int X[3])
+{
+  int Y[3];
+  pair_global_position(block, turns, X, Y);
+  return (real_t)(1000000 * (owner + 1) + Y[0] + 64 * Y[1] + 4096 * Y[2]);
+}
+
+static blockmesh_t* create_block_pair(MPI_Comm comm, int turns)
+{
+  int n = pair_block_n, L = n * pair_patch_n;
+  blockmesh_t* mesh = blockmesh_new(comm, pair_patch_n, pair_patch_n,
+                                    pair_patch_n);
+  blockmesh_add_block(mesh, n, n, n);
+  blockmesh_add_block(mesh, n, n, n);
+
+  // Identify the nodes on each block's +x boundary with those on the
+  // other's -x boundary by their global positions.
+  static const int corners[8][3] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+                                    {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
+  int east[4] = {2, 6, 5, 1}, west[4] = {0, 4, 7, 3};
+  for (int b1 = 0; b1 < 2; ++b1)
+  {
+    int b2 = 1 - b1, west_nodes[4];
+    for (int e = 0; e < 4; ++e)
+    {
+      int X1[3], Y1[3];
+      for (int d = 0; d < 3; ++d)
+        X1[d] = 2 * L * corners[east[e]][d];
+      pair_global_position(b1, turns, X1, Y1);
+      for (int w = 0; w < 4; ++w)
+      {
+        int X2[3], Y2[3];
+        for (int d = 0; d < 3; ++d)
+          X2[d] = 2 * L * corners[west[w]][d];
+        pair_global_position(b2, turns, X2, Y2);
+        if ((Y1[0] == Y2[0]) && (Y1[1] == Y2[1]) && (Y1[2] == Y2[2]))
+          west_nodes[e] = west[w];
+      }
+    }
+    assert_true(blockmesh_can_connect_blocks(mesh, b1, east, b2, west_nodes, NULL));
+    blockmesh_connect_blocks(mesh, b1, east, b2, west_nodes);
+  }
+  blockmesh_finalize(mesh);
+  return mesh;
+}
+
+// Returns the position (in half cell widths) within its block of the value
+// with the given indices in the patch (i, j, k).
+static void pair_position(unimesh_patch_t* patch, int i, int j, int k,
+                          int ii, int jj, int kk, int X[3])
+{
+  int c = (int)patch->centering;
+  int p[3] = {i, j, k}, l[3] = {ii, jj, kk};
+  for (int d = 0; d < 3; ++d)
+  {
+    if (patch->centering == UNIMESH_CELL)
+      X[d] = 2 * (p[d] * pair_patch_n + l[d] - 1) + 1;
+    else
+      X[d] = 2 * (p[d] * pair_patch_n + l[d]) + 1 - on_nodes[c][d];
+  }
+}
+
+// Returns a pointer to the values with the given indices in the patch.
+static real_t* pair_patch_values(unimesh_patch_t* patch, int ii, int jj, int kk)
+{
+  int c = (int)patch->centering, N[3];
+  N[0] = patch->nx; N[1] = patch->ny; N[2] = patch->nz;
+  for (int d = 0; d < 3; ++d)
+    N[d] += (patch->centering == UNIMESH_CELL) ? 2 : on_nodes[c][d];
+  return &(((real_t*)patch->data)[patch->nc * ((ii * N[1] + jj) * N[2] + kk)]);
+}
+
+// Fills a field on a pair of blocks with values identifying the block and
+// position of each value, updates its boundaries, and checks that the
+// ghost cells (or, for other centerings, the values on the boundaries)
+// between the blocks received the other block's values.
+static void test_pair_transfers(void** state,
+                                MPI_Comm comm,
+                                int turns,
+                                unimesh_centering_t centering,
+                                int nc)
+{
+  blockmesh_t* mesh = create_block_pair(comm, turns);
+  blockmesh_field_t* f = blockmesh_field_new(mesh, centering, nc);
+  int cent = (int)centering;
+  int first = (centering == UNIMESH_CELL) ? 1 : 0;
+
+  int pos = 0, block_index;
+  unimesh_field_t* bfield;
+  while (blockmesh_field_next_block(f, &pos, &block_index, &bfield))
+  {
+    static real_t zeros[2] = {0.0, 0.0};
+    unimesh_t* block = blockmesh_block(mesh, block_index);
+    unimesh_patch_bc_t* zero_bc = constant_unimesh_patch_bc_new(block, zeros, nc);
+    for (int b = 2; b < 6; ++b)
+      blockmesh_field_set_patch_bc(f, block_index, (unimesh_boundary_t)b, zero_bc);
+    release_ref(zero_bc);
+
+    int pos1 = 0, i, j, k;
+    unimesh_patch_t* patch;
+    while (unimesh_field_next_patch(bfield, &pos1, &i, &j, &k, &patch, NULL))
+    {
+      int N[3] = {patch->nx, patch->ny, patch->nz};
+      for (int d = 0; d < 3; ++d)
+        N[d] += (centering == UNIMESH_CELL) ? 1 : on_nodes[cent][d];
+      for (int ii = first; ii < N[0]; ++ii)
+      {
+        for (int jj = first; jj < N[1]; ++jj)
+        {
+          for (int kk = first; kk < N[2]; ++kk)
+          {
+            int X[3];
+            pair_position(patch, i, j, k, ii, jj, kk, X);
+            real_t* values = pair_patch_values(patch, ii, jj, kk);
+            real_t value = pair_value(block_index, block_index, turns, X);
+            for (int c = 0; c < nc; ++c)
+              values[c] = (c == 0) ? value : -value;
+          }
+        }
+      }
+    }
+  }
+
+  blockmesh_field_update_boundaries(f, 0.0);
+
+  // Cells receive values in the ghost layers outside the x boundaries, and
+  // other centerings receive them on the x boundaries (if they have values
+  // there).
+  if ((centering == UNIMESH_CELL) || on_nodes[cent][0])
+  {
+    pos = 0;
+    while (blockmesh_field_next_block(f, &pos, &block_index, &bfield))
+    {
+      for (int b = 0; b < 2; ++b)
+      {
+        unimesh_boundary_t boundary = (unimesh_boundary_t)b;
+        int pos1 = 0, i, j, k;
+        unimesh_patch_t* patch;
+        while (unimesh_field_next_boundary_patch(bfield, boundary, &pos1,
+                                                 &i, &j, &k, &patch, NULL))
+        {
+          // Values on the edges of a patch boundary are shared with other
+          // patch boundaries, and get whatever update is applied last, so
+          // we only check those within the boundary.
+          int ii = (b == 0) ? 0 : patch->nx + first;
+          int j1 = (centering == UNIMESH_CELL) ? 1 : on_nodes[cent][1];
+          int k1 = (centering == UNIMESH_CELL) ? 1 : on_nodes[cent][2];
+          for (int jj = j1; jj < patch->ny + first; ++jj)
+          {
+            for (int kk = k1; kk < patch->nz + first; ++kk)
+            {
+              int X[3];
+              pair_position(patch, i, j, k, ii, jj, kk, X);
+              real_t* values = pair_patch_values(patch, ii, jj, kk);
+              real_t value = pair_value(1 - block_index, block_index, turns, X);
+              assert_true(reals_equal(values[0], value));
+              if (nc > 1)
+                assert_true(reals_equal(values[1], -value));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  blockmesh_field_free(f);
+  blockmesh_free(mesh);
+}
+
+// Tests transfers of values of every centering that maps onto itself across
+// the connections between a pair of blocks, with all rotations. Quarter
+// turns exchange edges that lie within the block boundaries with edges of
+// another orientation, so we skip those.
+static void test_transfers(void** state, MPI_Comm comm)
+{
+  for (int turns = 0; turns < 4; ++turns)
+  {
+    for (int c = 0; c < 8; ++c)
+    {
+      unimesh_centering_t centering = (unimesh_centering_t)c;
+      if (((turns % 2) == 1) &&
+          ((centering == UNIMESH_YEDGE) || (centering == UNIMESH_ZEDGE)))
+        continue;
+      test_pair_transfers(state, comm, turns, centering, 1);
+      test_pair_transfers(state, comm, turns, centering, 2);
+    }
+  }
+}
+
 static void test_serial_cell_field(void** state)
 {
   blockmesh_t* mesh;
@@ -593,6 +818,11 @@ static void test_serial_node_field(void** state)
   test_node_field(state, mesh, coord_mappings);
 }
 
+static void test_serial_transfers(void** state)
+{
+  test_transfers(state, MPI_COMM_SELF);
+}
+
 static void test_parallel_cell_field(void** state)
 {
   blockmesh_t* mesh;
@@ -625,6 +855,11 @@ static void test_parallel_node_field(void** state)
   test_node_field(state, mesh, coord_mappings);
 }
 
+static void test_parallel_transfers(void** state)
+{
+  test_transfers(state, MPI_COMM_WORLD);
+}
+
 int main(int argc, char* argv[])
 {
   polymec_init(argc, argv);
@@ -634,10 +869,12 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_serial_face_fields),
     cmocka_unit_test(test_serial_edge_fields),
     cmocka_unit_test(test_serial_node_field),
+    cmocka_unit_test(test_serial_transfers),
     cmocka_unit_test(test_parallel_cell_field),
     cmocka_unit_test(test_parallel_face_fields),
     cmocka_unit_test(test_parallel_edge_fields),
-    cmocka_unit_test(test_parallel_node_field)
+    cmocka_unit_test(test_parallel_node_field),
+    cmocka_unit_test(test_parallel_transfers)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -72,6 +72,8 @@ static void test_cell_field(void** state, colmesh_t* mesh)
   real_t z1, z2;
   bool z_periodic;
   colmesh_get_z_info(mesh, &z1, &z2, &z_periodic);
+  int num_xy_chunks, num_z_chunks, nz_per_chunk;
+  colmesh_get_chunk_info(mesh, &num_xy_chunks, &num_z_chunks, &nz_per_chunk);
   colmesh_field_t* field = colmesh_field_new(mesh, COLMESH_CELL, 3);
 
   // Fill the interior cells in our field with cell centroids.
@@ -126,6 +128,21 @@ static void test_cell_field(void** state, colmesh_t* mesh)
           assert_true(reals_equal(point_distance(&xc, &yc), dx));
         }
       }
+
+      // Verify the ghost cells below and above the chunk, which hold data
+      // from vertically adjacent chunks.
+      if (Z > 0)
+      {
+        point_t xc;
+        get_cell_centroid(chunk, xy, 0, &xc);
+        assert_true(reals_nearly_equal(f[xy][0][2], xc.z, 1e-12));
+      }
+      if (Z < num_z_chunks-1)
+      {
+        point_t xc;
+        get_cell_centroid(chunk, xy, chunk->num_z_cells+1, &xc);
+        assert_true(reals_nearly_equal(f[xy][chunk->num_z_cells+1][2], xc.z, 1e-12));
+      }
     }
   }
 
@@ -137,6 +154,94 @@ static void test_cell_field(void** state, colmesh_t* mesh)
   colmesh_free(mesh);
 }
 
+// Sums the x coordinates stored in the neighbors of the given cells into a
+// second field.
+static void sum_neighbors(void* context,
+                          colmesh_chunk_data_t* chunk_data,
+                          int xy_index, int z_index,
+                          int* columns, int num_columns,
+                          int z1, int z2)
+{
+  colmesh_field_t* sums_field = context;
+  colmesh_chunk_data_t* sums_data = colmesh_field_chunk_data(sums_field, xy_index, z_index);
+  colmesh_chunk_t* chunk = chunk_data->chunk;
+  DECLARE_COLMESH_CELL_ARRAY(f, chunk_data);
+  DECLARE_COLMESH_CELL_ARRAY(sums, sums_data);
+  for (int i = 0; i < num_columns; ++i)
+  {
+    int xy = columns[i];
+    for (int z = z1; z <= z2; ++z)
+    {
+      sums[xy][z][0] += f[xy][z-1][0] + f[xy][z+1][0];
+      int pos = 0, n;
+      while (colmesh_chunk_column_next_neighbor(chunk, xy, &pos, &n))
+      {
+        if (n != -1)
+          sums[xy][z][0] += f[n][z][0];
+      }
+    }
+  }
+}
+
+static void test_cell_field_exchange_and_compute(void** state, colmesh_t* mesh)
+{
+  colmesh_field_t* field = colmesh_field_new(mesh, COLMESH_CELL, 3);
+  colmesh_field_t* sums1 = colmesh_field_new(mesh, COLMESH_CELL, 1);
+  colmesh_field_t* sums2 = colmesh_field_new(mesh, COLMESH_CELL, 1);
+
+  // Fill the interior cells in our field with cell centroids. Ghost values
+  // start out as zero.
+  int pos = 0, XY, Z;
+  colmesh_chunk_data_t* chunk_data;
+  while (colmesh_field_next_chunk(field, &pos, &XY, &Z, &chunk_data))
+  {
+    colmesh_chunk_t* chunk = chunk_data->chunk;
+    DECLARE_COLMESH_CELL_ARRAY(f, chunk_data);
+    for (int xy = 0; xy < chunk->num_columns; ++xy)
+    {
+      for (int z = 1; z <= chunk->num_z_cells; ++z)
+      {
+        point_t xc;
+        get_cell_centroid(chunk, xy, z, &xc);
+        f[xy][z][0] = 1.0 + xc.x;
+        f[xy][z][1] = xc.y;
+        f[xy][z][2] = xc.z;
+      }
+    }
+  }
+
+  // Sum neighboring values while exchanging, and then after exchanging.
+  colmesh_field_exchange_and_compute(field, sum_neighbors, sums1);
+  colmesh_field_exchange(field);
+  pos = 0;
+  while (colmesh_field_next_chunk(field, &pos, &XY, &Z, &chunk_data))
+  {
+    colmesh_chunk_t* chunk = chunk_data->chunk;
+    int columns[chunk->num_columns];
+    for (int xy = 0; xy < chunk->num_columns; ++xy)
+      columns[xy] = xy;
+    sum_neighbors(sums2, chunk_data, XY, Z, columns, chunk->num_columns, 1, chunk->num_z_cells);
+  }
+
+  // Each cell was visited once, with its ghost values in place.
+  pos = 0;
+  while (colmesh_field_next_chunk(sums1, &pos, &XY, &Z, &chunk_data))
+  {
+    colmesh_chunk_t* chunk = chunk_data->chunk;
+    DECLARE_COLMESH_CELL_ARRAY(s1, chunk_data);
+    colmesh_chunk_data_t* chunk_data2 = colmesh_field_chunk_data(sums2, XY, Z);
+    DECLARE_COLMESH_CELL_ARRAY(s2, chunk_data2);
+    for (int xy = 0; xy < chunk->num_columns; ++xy)
+      for (int z = 1; z <= chunk->num_z_cells; ++z)
+        assert_true(reals_equal(s1[xy][z][0], s2[xy][z][0]));
+  }
+
+  colmesh_field_free(sums2);
+  colmesh_field_free(sums1);
+  colmesh_field_free(field);
+  colmesh_free(mesh);
+}
+
 static void get_xy_face_centroid(colmesh_chunk_t* chunk, int xy, int z,
                                  point_t* centroid)
 {
@@ -513,6 +618,18 @@ static void test_serial_nonperiodic_node_field(void** state)
   test_node_field(state, mesh);
 }
 
+static void test_serial_cell_field_exchange_and_compute(void** state)
+{
+  colmesh_t* mesh = periodic_mesh(MPI_COMM_SELF);
+  test_cell_field_exchange_and_compute(state, mesh);
+}
+
+static void test_parallel_cell_field_exchange_and_compute(void** state)
+{
+  colmesh_t* mesh = periodic_mesh(MPI_COMM_WORLD);
+  test_cell_field_exchange_and_compute(state, mesh);
+}
+
 static void test_parallel_periodic_cell_field(void** state)
 {
   colmesh_t* mesh = periodic_mesh(MPI_COMM_WORLD);
@@ -583,7 +700,9 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_parallel_nonperiodic_cell_field),
     cmocka_unit_test(test_parallel_nonperiodic_face_fields),
     cmocka_unit_test(test_parallel_nonperiodic_edge_fields),
-    cmocka_unit_test(test_parallel_nonperiodic_node_field)
+    cmocka_unit_test(test_parallel_nonperiodic_node_field),
+    cmocka_unit_test(test_serial_cell_field_exchange_and_compute),
+    cmocka_unit_test(test_parallel_cell_field_exchange_and_compute)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
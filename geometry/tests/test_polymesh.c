@@ -47,6 +47,165 @@ static void test_single_cell_mesh_serialization(void** state)
   polymesh_free(mesh1);
 }
 
+static void test_construct_edges(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  polymesh_t* mesh = create_uniform_polymesh(MPI_COMM_SELF, 5, 6, 7, &bbox);
+  assert_int_equal(5*7*8 + 6*6*8 + 7*6*7, mesh->num_edges);
+
+  // Each face edge joins consecutive nodes of its face, and edges are
+  // numbered in the order the faces first encounter them.
+  int next_edge = 0;
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int num_nodes = polymesh_face_num_nodes(mesh, f);
+    assert_int_equal(num_nodes, polymesh_face_num_edges(mesh, f));
+    int nodes[num_nodes], edges[num_nodes];
+    polymesh_face_get_nodes(mesh, f, nodes);
+    polymesh_face_get_edges(mesh, f, edges);
+    for (int e = 0; e < num_nodes; ++e)
+    {
+      int n1 = nodes[e], n2 = nodes[(e+1)%num_nodes];
+      int edge = edges[e];
+      assert_true(edge <= next_edge);
+      if (edge == next_edge)
+        ++next_edge;
+      assert_int_equal(MIN(n1, n2), mesh->edge_nodes[2*edge]);
+      assert_int_equal(MAX(n1, n2), mesh->edge_nodes[2*edge+1]);
+    }
+  }
+  assert_int_equal(mesh->num_edges, next_edge);
+
+  polymesh_free(mesh);
+}
+
+static void test_face_coloring(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  polymesh_t* mesh = create_uniform_polymesh(MPI_COMM_SELF, 8, 8, 8, &bbox);
+
+  // Every face appears in exactly one color, and no two faces of a color
+  // share a cell. Each color's faces are listed in ascending order, and a
+  // hexahedral mesh needs at least 6 colors and (since each face shares a
+  // cell with at most 10 others) at most 11.
+  int num_colors = polymesh_num_face_colors(mesh);
+  assert_true(num_colors >= 6);
+  assert_true(num_colors <= 11);
+  int face_colors[mesh->num_faces];
+  for (int f = 0; f < mesh->num_faces; ++f)
+    face_colors[f] = -1;
+  int cell_colors[mesh->num_cells];
+  for (int color = 0; color < num_colors; ++color)
+  {
+    for (int c = 0; c < mesh->num_cells; ++c)
+      cell_colors[c] = -1;
+    int num_faces;
+    int* faces = polymesh_face_color(mesh, color, &num_faces);
+    assert_true(num_faces > 0);
+    for (int i = 0; i < num_faces; ++i)
+    {
+      int f = faces[i];
+      if (i > 0)
+        assert_true(faces[i-1] < f);
+      assert_int_equal(-1, face_colors[f]);
+      face_colors[f] = color;
+      int c1 = mesh->face_cells[2*f], c2 = mesh->face_cells[2*f+1];
+      assert_true(cell_colors[c1] != color);
+      cell_colors[c1] = color;
+      if (c2 != -1)
+      {
+        assert_true(cell_colors[c2] != color);
+        cell_colors[c2] = color;
+      }
+    }
+  }
+  for (int f = 0; f < mesh->num_faces; ++f)
+    assert_true(face_colors[f] >= 0);
+
+  polymesh_free(mesh);
+}
+
+typedef struct
+{
+  real_t* u;
+  real_t* rhs;
+} flux_context_t;
+
+static void accumulate_flux(void* context, polymesh_t* mesh, int face)
+{
+  flux_context_t* ctx = context;
+  int c1 = mesh->face_cells[2*face], c2 = mesh->face_cells[2*face+1];
+  if (c2 == -1) return;
+  real_t flux = mesh->face_areas[face] * (ctx->u[c2] - ctx->u[c1]);
+  ctx->rhs[c1] += flux;
+  ctx->rhs[c2] -= flux;
+}
+
+static void test_foreach_face_parallel(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  polymesh_t* mesh = create_uniform_polymesh(MPI_COMM_SELF, 10, 10, 10, &bbox);
+
+  int num_cells = mesh->num_cells;
+  real_t u[num_cells], rhs1[num_cells], rhs2[num_cells];
+  for (int c = 0; c < num_cells; ++c)
+  {
+    point_t* x = &mesh->cell_centers[c];
+    u[c] = x->x * x->x + x->y * x->z;
+    rhs1[c] = rhs2[c] = 0.0;
+  }
+
+  // Accumulate fluxes serially, and then by color.
+  flux_context_t ctx1 = {.u = u, .rhs = rhs1};
+  for (int f = 0; f < mesh->num_faces; ++f)
+    accumulate_flux(&ctx1, mesh, f);
+  flux_context_t ctx2 = {.u = u, .rhs = rhs2};
+  polymesh_foreach_face_parallel(mesh, accumulate_flux, &ctx2);
+  for (int c = 0; c < num_cells; ++c)
+    assert_true(reals_nearly_equal(rhs1[c], rhs2[c], 1e-12));
+
+  polymesh_free(mesh);
+}
+
+static void test_update_geometry(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  polymesh_t* mesh1 = create_uniform_polymesh(MPI_COMM_SELF, 6, 6, 6, &bbox);
+  polymesh_t* mesh2 = polymesh_clone(mesh1);
+
+  // Move a few nodes on both meshes, updating the geometry of one and
+  // recomputing that of the other.
+  int moved_nodes[3] = {57, 114, 171};
+  for (int i = 0; i < 3; ++i)
+  {
+    int n = moved_nodes[i];
+    mesh1->nodes[n].x += 0.02;
+    mesh1->nodes[n].y -= 0.01;
+    mesh1->nodes[n].z += 0.03;
+    mesh2->nodes[n] = mesh1->nodes[n];
+  }
+  polymesh_update_geometry(mesh1, moved_nodes, 3);
+  polymesh_compute_geometry(mesh2);
+
+  real_t V = 0.0;
+  for (int c = 0; c < mesh1->num_cells; ++c)
+  {
+    assert_true(point_distance(&mesh1->cell_centers[c], &mesh2->cell_centers[c]) < 1e-14);
+    assert_true(reals_nearly_equal(mesh1->cell_volumes[c], mesh2->cell_volumes[c], 1e-14));
+    V += mesh1->cell_volumes[c];
+  }
+  assert_true(reals_nearly_equal(V, 1.0, 1e-12));
+  for (int f = 0; f < mesh1->num_faces; ++f)
+  {
+    assert_true(point_distance(&mesh1->face_centers[f], &mesh2->face_centers[f]) < 1e-14);
+    assert_true(reals_nearly_equal(mesh1->face_areas[f], mesh2->face_areas[f], 1e-14));
+    assert_true(vector_dot(&mesh1->face_normals[f], &mesh2->face_normals[f]) > 1.0 - 1e-14);
+  }
+
+  polymesh_free(mesh2);
+  polymesh_free(mesh1);
+}
+
 int main(int argc, char* argv[]) 
 {
   polymec_init(argc, argv);
@@ -54,6 +213,10 @@ int main(int argc, char* argv[])
   {
     cmocka_unit_test(test_single_cell_mesh_no_topo),
     cmocka_unit_test(test_single_cell_mesh_serialization),
+    cmocka_unit_test(test_construct_edges),
+    cmocka_unit_test(test_face_coloring),
+    cmocka_unit_test(test_foreach_face_parallel),
+    cmocka_unit_test(test_update_geometry),
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -11,6 +11,7 @@
 #include <string.h>
 #include "cmocka.h"
 #include "geometry/polymesh.h"
+#include "geometry/polymesh_field.h"
 #include "geometry/partition_polymesh.h"
 #include "geometry/create_uniform_polymesh.h"
 
@@ -194,6 +195,76 @@ static void test_edge_exchanger_in_cube(void** state)
   MPI_Barrier(MPI_COMM_WORLD);
 }
 
+// Sums the values of each of the given cells' neighbors.
+static void sum_neighbors(void* context, polymesh_t* mesh, int* cells, int num_cells)
+{
+  real_t** data = context;
+  real_t* u = data[0];
+  real_t* sums = data[1];
+  for (int i = 0; i < num_cells; ++i)
+  {
+    int cell = cells[i], pos = 0, neighbor;
+    while (polymesh_cell_next_neighbor(mesh, cell, &pos, &neighbor))
+    {
+      if (neighbor != -1)
+        sums[cell] += u[neighbor];
+    }
+  }
+}
+
+static void test_cell_exchange_and_compute(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  polymesh_t* mesh = create_uniform_polymesh(MPI_COMM_SELF, 6, 6, 6, &bbox);
+  assert_true(partition_polymesh(&mesh, MPI_COMM_WORLD, NULL, 0.0, NULL, 0));
+
+  // Interior cells don't neighbor ghost cells, and boundary cells do.
+  int *interior, num_interior, *boundary, num_boundary;
+  polymesh_get_cell_partition(mesh, &interior, &num_interior, &boundary, &num_boundary);
+  assert_int_equal(mesh->num_cells, num_interior + num_boundary);
+  for (int i = 0; i < num_interior; ++i)
+  {
+    int pos = 0, neighbor;
+    while (polymesh_cell_next_neighbor(mesh, interior[i], &pos, &neighbor))
+      assert_true(neighbor < mesh->num_cells);
+  }
+  for (int i = 0; i < num_boundary; ++i)
+  {
+    bool has_ghost = false;
+    int pos = 0, neighbor;
+    while (polymesh_cell_next_neighbor(mesh, boundary[i], &pos, &neighbor))
+      has_ghost = has_ghost || (neighbor >= mesh->num_cells);
+    assert_true(has_ghost);
+  }
+  if (mesh->num_ghost_cells > 0)
+    assert_true(num_boundary > 0);
+
+  // Sum neighboring values while exchanging ghost values, and compare the
+  // sums with those computed after a synchronous exchange.
+  polymesh_field_t* field = polymesh_field_new(mesh, POLYMESH_CELL, 1);
+  for (int c = 0; c < mesh->num_cells; ++c)
+    field->data[c] = 1.0 + mesh->cell_centers[c].x;
+  real_t sums1[mesh->num_cells], sums2[mesh->num_cells];
+  memset(sums1, 0, sizeof(real_t) * mesh->num_cells);
+  memset(sums2, 0, sizeof(real_t) * mesh->num_cells);
+  real_t* context1[2] = {field->data, sums1};
+  polymesh_field_exchange_and_compute(field, POLYMESH_CELL, sum_neighbors, context1);
+
+  polymesh_field_exchange(field);
+  int all_cells[mesh->num_cells];
+  for (int c = 0; c < mesh->num_cells; ++c)
+    all_cells[c] = c;
+  real_t* context2[2] = {field->data, sums2};
+  sum_neighbors(context2, mesh, all_cells, mesh->num_cells);
+  for (int c = 0; c < mesh->num_cells; ++c)
+    assert_true(reals_equal(sums1[c], sums2[c]));
+
+  polymesh_field_free(field);
+  polymesh_free(mesh);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
 int main(int argc, char* argv[])
 {
   polymec_init(argc, argv);
@@ -204,7 +275,8 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_node_exchanger_in_cube),
     cmocka_unit_test(test_edge_exchanger_on_line),
     cmocka_unit_test(test_edge_exchanger_in_plane),
-    cmocka_unit_test(test_edge_exchanger_in_cube)
+    cmocka_unit_test(test_edge_exchanger_in_cube),
+    cmocka_unit_test(test_cell_exchange_and_compute)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
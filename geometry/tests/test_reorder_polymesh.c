@@ -0,0 +1,258 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "core/options.h"
+#include "core/rng.h"
+#include "geometry/create_uniform_polymesh.h"
+#include "geometry/partition_polymesh.h"
+#include "geometry/reorder_polymesh.h"
+
+static real_t linear_func(point_t* x)
+{
+  return 1.0 + x->x + 2.0*x->y + 3.0*x->z;
+}
+
+// Creates a polymesh distributed over all processes.
+static polymesh_t* create_mesh(int n)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  polymesh_t* mesh = create_uniform_polymesh(MPI_COMM_SELF, n, n, n, &bbox);
+  assert_true(partition_polymesh(&mesh, MPI_COMM_WORLD, NULL, 0.05, NULL, 0));
+  return mesh;
+}
+
+// Shuffles the elements of the given mesh randomly.
+static void shuffle(int* perm, int n, rng_t* rng)
+{
+  for (int i = 0; i < n; ++i)
+    perm[i] = i;
+  for (int i = n-1; i > 0; --i)
+  {
+    int j = (int)rng_uniform_int(rng, (uint32_t)(i+1));
+    int tmp = perm[i];
+    perm[i] = perm[j];
+    perm[j] = tmp;
+  }
+}
+
+static polymesh_permutation_t* random_permutation(polymesh_t* mesh)
+{
+  rng_t* rng = host_rng_new();
+  rng_set_seed(rng, 1234);
+  polymesh_permutation_t* perm = polymec_malloc(sizeof(polymesh_permutation_t));
+  perm->cells = polymec_malloc(sizeof(int) * mesh->num_cells);
+  shuffle(perm->cells, mesh->num_cells, rng);
+  perm->faces = polymec_malloc(sizeof(int) * mesh->num_faces);
+  shuffle(perm->faces, mesh->num_faces, rng);
+  perm->edges = polymec_malloc(sizeof(int) * mesh->num_edges);
+  shuffle(perm->edges, mesh->num_edges, rng);
+  perm->nodes = polymec_malloc(sizeof(int) * mesh->num_nodes);
+  shuffle(perm->nodes, mesh->num_nodes, rng);
+  return perm;
+}
+
+// Returns the largest difference in index between neighboring local cells.
+static int cell_bandwidth(polymesh_t* mesh)
+{
+  int bandwidth = 0;
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int c1 = mesh->face_cells[2*f], c2 = mesh->face_cells[2*f+1];
+    if ((c2 >= 0) && (c2 < mesh->num_cells))
+      bandwidth = MAX(bandwidth, ABS(c1 - c2));
+  }
+  return bandwidth;
+}
+
+// Sweeps over faces, accumulating fluxes into cells, and returns the time
+// taken.
+static double sweep_faces(polymesh_t* mesh, real_t* u, real_t* rhs, int num_sweeps)
+{
+  double t1 = MPI_Wtime();
+  for (int s = 0; s < num_sweeps; ++s)
+  {
+    for (int f = 0; f < mesh->num_faces; ++f)
+    {
+      int c1 = mesh->face_cells[2*f], c2 = mesh->face_cells[2*f+1];
+      if (c2 == -1) continue;
+      real_t flux = mesh->face_areas[f] * (u[c2] - u[c1]);
+      rhs[c1] += flux;
+      rhs[c2] -= flux;
+    }
+  }
+  return MPI_Wtime() - t1;
+}
+
+static void check_fields(polymesh_t* mesh, polymesh_field_t* cfield,
+                         polymesh_field_t* ffield, polymesh_field_t* nfield)
+{
+  for (int c = 0; c < mesh->num_cells; ++c)
+    assert_true(reals_nearly_equal(cfield->data[c], linear_func(&mesh->cell_centers[c]), 1e-12));
+  for (int f = 0; f < mesh->num_faces; ++f)
+    assert_true(reals_nearly_equal(ffield->data[f], linear_func(&mesh->face_centers[f]), 1e-12));
+  for (int n = 0; n < mesh->num_nodes; ++n)
+    assert_true(reals_nearly_equal(nfield->data[n], linear_func(&mesh->nodes[n]), 1e-12));
+}
+
+static void check_permutation(int* perm, int n)
+{
+  bool found[MAX(n, 1)];
+  memset(found, 0, sizeof(bool) * n);
+  for (int i = 0; i < n; ++i)
+  {
+    assert_true((perm[i] >= 0) && (perm[i] < n));
+    assert_false(found[perm[i]]);
+    found[perm[i]] = true;
+  }
+}
+
+static void test_reorder(void** state, polymesh_ordering_t ordering)
+{
+  polymesh_t* mesh = create_mesh(10);
+
+  // Set up some fields whose values we can check.
+  polymesh_field_t* cfield = polymesh_field_new(mesh, POLYMESH_CELL, 1);
+  for (int c = 0; c < mesh->num_cells; ++c)
+    cfield->data[c] = linear_func(&mesh->cell_centers[c]);
+  polymesh_field_t* ffield = polymesh_field_new(mesh, POLYMESH_FACE, 1);
+  for (int f = 0; f < mesh->num_faces; ++f)
+    ffield->data[f] = linear_func(&mesh->face_centers[f]);
+  polymesh_field_t* nfield = polymesh_field_new(mesh, POLYMESH_NODE, 1);
+  for (int n = 0; n < mesh->num_nodes; ++n)
+    nfield->data[n] = linear_func(&mesh->nodes[n]);
+
+  // Record the ghost values filled in by an exchange.
+  polymesh_field_exchange(cfield);
+  int num_ghosts = mesh->num_ghost_cells;
+  real_t ghost_values[MAX(num_ghosts, 1)];
+  memcpy(ghost_values, &cfield->data[mesh->num_cells], sizeof(real_t) * num_ghosts);
+
+  // Tag some faces.
+  size_t num_tagged_faces = (size_t)mesh->num_faces/7;
+  int* tagged_faces = polymesh_create_tag(mesh->face_tags, "tagged", num_tagged_faces);
+  point_t tagged_centers[MAX(num_tagged_faces, 1)];
+  for (size_t i = 0; i < num_tagged_faces; ++i)
+  {
+    tagged_faces[i] = (int)(7*i);
+    tagged_centers[i] = mesh->face_centers[tagged_faces[i]];
+  }
+
+  // Scramble the mesh, then reorder it.
+  polymesh_field_t* fields[3] = {cfield, ffield, nfield};
+  polymesh_permutation_t* shuffled = random_permutation(mesh);
+  permute_polymesh(mesh, shuffled, fields, 3);
+  polymesh_permutation_free(shuffled);
+  assert_true(polymesh_is_valid(mesh, NULL));
+  check_fields(mesh, cfield, ffield, nfield);
+  int shuffled_bandwidth = cell_bandwidth(mesh);
+
+  polymesh_permutation_t* perm = reorder_polymesh(mesh, ordering, fields, 3);
+  check_permutation(perm->cells, mesh->num_cells);
+  check_permutation(perm->faces, mesh->num_faces);
+  check_permutation(perm->edges, mesh->num_edges);
+  check_permutation(perm->nodes, mesh->num_nodes);
+  polymesh_permutation_free(perm);
+
+  // The mesh should be intact, with its neighbors closer together.
+  char* reason;
+  bool valid = polymesh_is_valid(mesh, &reason);
+  if (!valid)
+    log_urgent("%s", reason);
+  assert_true(valid);
+  check_fields(mesh, cfield, ffield, nfield);
+  assert_true(cell_bandwidth(mesh) < shuffled_bandwidth);
+
+  // Tags follow their faces.
+  tagged_faces = polymesh_tag(mesh->face_tags, "tagged", &num_tagged_faces);
+  for (size_t i = 0; i < num_tagged_faces; ++i)
+    assert_true(point_distance(&tagged_centers[i], &mesh->face_centers[tagged_faces[i]]) < 1e-12);
+
+  // The exchanger still fills ghost cells with the same values.
+  memset(&cfield->data[mesh->num_cells], 0, sizeof(real_t) * num_ghosts);
+  polymesh_field_exchange(cfield);
+  for (int g = 0; g < num_ghosts; ++g)
+    assert_true(reals_equal(ghost_values[g], cfield->data[mesh->num_cells+g]));
+
+  polymesh_field_free(nfield);
+  polymesh_field_free(ffield);
+  polymesh_field_free(cfield);
+  polymesh_free(mesh);
+}
+
+static void test_rcm_ordering(void** state)
+{
+  test_reorder(state, POLYMESH_RCM_ORDERING);
+}
+
+static void test_hilbert_ordering(void** state)
+{
+  test_reorder(state, POLYMESH_HILBERT_ORDERING);
+}
+
+// Compares the time taken by face-flux sweeps on a scrambled mesh with that
+// taken after reordering. The mesh is big enough that its cell data don't
+// fit in cache, so this only runs when the benchmark=true option is given,
+// and logs its timings at the info level.
+static void test_face_sweep_benchmark(void** state)
+{
+  polymesh_t* mesh = create_mesh(60);
+  polymesh_permutation_t* shuffled = random_permutation(mesh);
+  permute_polymesh(mesh, shuffled, NULL, 0);
+  polymesh_permutation_free(shuffled);
+
+  int num_cells = mesh->num_cells + mesh->num_ghost_cells;
+  real_t* u = polymec_malloc(sizeof(real_t) * num_cells);
+  real_t* rhs = polymec_calloc(num_cells, sizeof(real_t));
+  for (int c = 0; c < num_cells; ++c)
+    u[c] = 1.0 * c;
+  static const int num_sweeps = 20;
+  double t_shuffled = sweep_faces(mesh, u, rhs, num_sweeps);
+
+  polymesh_permutation_t* perm = reorder_polymesh(mesh, POLYMESH_RCM_ORDERING, NULL, 0);
+  polymesh_permutation_free(perm);
+  double t_rcm = sweep_faces(mesh, u, rhs, num_sweeps);
+
+  perm = reorder_polymesh(mesh, POLYMESH_HILBERT_ORDERING, NULL, 0);
+  polymesh_permutation_free(perm);
+  double t_hilbert = sweep_faces(mesh, u, rhs, num_sweeps);
+
+  log_info("Face sweeps (%d faces, %d sweeps): %g s scrambled, "
+           "%g s RCM (%.2fx), %g s Hilbert (%.2fx)",
+           mesh->num_faces, num_sweeps, t_shuffled, t_rcm, t_shuffled/t_rcm,
+           t_hilbert, t_shuffled/t_hilbert);
+
+  polymec_free(rhs);
+  polymec_free(u);
+  polymesh_free(mesh);
+}
+
+int main(int argc, char* argv[])
+{
+  polymec_init(argc, argv);
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test(test_rcm_ordering),
+    cmocka_unit_test(test_hilbert_ordering)
+  };
+  int status = cmocka_run_group_tests(tests, NULL, NULL);
+
+  char* benchmark = options_value(options_argv(), "benchmark");
+  if ((status == 0) && (benchmark != NULL) && string_as_boolean(benchmark))
+  {
+    const struct CMUnitTest benchmarks[] =
+    {
+      cmocka_unit_test(test_face_sweep_benchmark)
+    };
+    status = cmocka_run_group_tests(benchmarks, NULL, NULL);
+  }
+  return status;
+}
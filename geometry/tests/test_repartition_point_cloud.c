@@ -200,6 +200,61 @@ static void test_repartition_unbalanced_random_weighted_linear_cloud(void** stat
   test_repartition_linear_cloud(state, false, true, true);
 }
 
+static void test_rebalance_unbalanced_linear_cloud(void** state)
+{
+  MPI_Comm comm = MPI_COMM_WORLD;
+  int rank, nprocs;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nprocs);
+
+  real_t imbalance_tol = 0.05;
+
+  // Create a linear point cloud with twice as many points on even processes
+  // as on odd ones.
+  int Np = ((rank % 2) == 0) ? 100 : 50;
+  int N;
+  MPI_Allreduce(&Np, &N, 1, MPI_INT, MPI_SUM, comm);
+  int offset;
+  MPI_Scan(&Np, &offset, 1, MPI_INT, MPI_SUM, comm);
+  offset -= Np;
+  real_t dx = 1.0/N;
+  point_cloud_t* cloud = point_cloud_new(comm, Np);
+  point_cloud_field_t* f_index = point_cloud_field_new(cloud, 1);
+  for (int i = 0; i < Np; ++i)
+  {
+    cloud->points[i].x = (0.5+offset+i)*dx;
+    f_index->data[i] = 1.0*(offset+i);
+  }
+
+  // Rebalance it.
+  migration_t migration;
+  rebalance_point_cloud(&cloud, NULL, imbalance_tol, &f_index, 1, &migration);
+
+  // Check that all the points are still here, and that they're balanced.
+  int num_points = cloud->num_points, total_points;
+  MPI_Allreduce(&num_points, &total_points, 1, MPI_INT, MPI_SUM, comm);
+  assert_int_equal(N, total_points);
+  assert_true(ABS((1.0*nprocs*cloud->num_points - N)/N) < imbalance_tol);
+
+  // Check that the field followed its points.
+  assert_int_equal(cloud->num_points, f_index->num_local_values);
+  for (int i = 0; i < cloud->num_points; ++i)
+    assert_true(ABS(cloud->points[i].x - (0.5+f_index->data[i])*dx) < 1e-6);
+
+  // Make sure we moved something if we needed to, and nothing if we didn't.
+  if (nprocs == 1)
+    assert_true(migration.actual_bytes == 0);
+  else
+  {
+    assert_true(migration.predicted_bytes > 0);
+    assert_true(migration.actual_bytes >= migration.predicted_bytes);
+  }
+
+  // Clean up.
+  point_cloud_field_free(f_index);
+  point_cloud_free(cloud);
+}
+
 int main(int argc, char* argv[]) 
 {
   polymec_init(argc, argv);
@@ -212,7 +267,8 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_repartition_unbalanced_uniform_unweighted_linear_cloud),
     cmocka_unit_test(test_repartition_unbalanced_uniform_weighted_linear_cloud),
     cmocka_unit_test(test_repartition_unbalanced_random_unweighted_linear_cloud),
-    cmocka_unit_test(test_repartition_unbalanced_random_weighted_linear_cloud)
+    cmocka_unit_test(test_repartition_unbalanced_random_weighted_linear_cloud),
+    cmocka_unit_test(test_rebalance_unbalanced_linear_cloud)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -10,6 +10,7 @@
 #include <setjmp.h>
 #include <string.h>
 #include "cmocka.h"
+#include "core/array_utils.h"
 #include "geometry/partition_polymesh.h"
 #include "geometry/create_uniform_polymesh.h"
 
@@ -211,6 +212,58 @@ static void test_repartition_4x4x1_uniform_mesh(void** state)
   test_repartition_uniform_mesh_of_size(state, 4, 4, 1);
 }
 
+static void test_rebalance_4x4x1_uniform_mesh(void** state)
+{
+  int rank, nprocs;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Create a 4x4x1 uniform mesh.
+  int nx = 4, ny = 4, nz = 1;
+  real_t dx = 1.0/MAX(MAX(1.0/nx, 1.0/ny), 1.0/nz);
+  bbox_t bbox = {.x1 = 0.0, .x2 = nx*dx, .y1 = 0.0, .y2 = ny*dx, .z1 = 0.0, .z2 = nz*dx};
+  polymesh_t* mesh = create_uniform_polymesh(MPI_COMM_WORLD, nx, ny, nz, &bbox);
+  assert_true(polymesh_is_valid(mesh, NULL));
+
+  // Make the cells on the first process heavier than the rest.
+  int weights[mesh->num_cells];
+  int_fill(weights, mesh->num_cells, (rank == 0) ? 3 : 1);
+  int load = 3 * mesh->num_cells, old_max_load;
+  if (rank != 0)
+    load = mesh->num_cells;
+  MPI_Allreduce(&load, &old_max_load, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  // Rebalance it.
+  migration_t migration;
+  rebalance_polymesh(&mesh, weights, 0.05, NULL, 0, &migration);
+
+  // All the cells should still be there, and still be intact.
+  int num_cells = mesh->num_cells;
+  MPI_Allreduce(MPI_IN_PLACE, &num_cells, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  assert_int_equal(nx*ny*nz, num_cells);
+  for (int c = 0; c < mesh->num_cells; ++c)
+  {
+    assert_int_equal(6, polymesh_cell_num_faces(mesh, c));
+    real_t V = dx * dx * dx;
+    assert_true(ABS(mesh->cell_volumes[c] - V)/V < frac_tolerance);
+  }
+  assert_true(exchanger_is_valid(polymesh_exchanger(mesh, POLYMESH_CELL), NULL));
+
+  // If we had to move anything, we should have moved it off the first
+  // process.
+  if (nprocs == 1)
+    assert_true(migration.actual_bytes == 0);
+  else if (migration.actual_bytes > 0)
+  {
+    assert_true(migration.predicted_bytes > 0);
+    if (rank == 0)
+      assert_true(3 * mesh->num_cells < old_max_load);
+  }
+
+  // Clean up.
+  polymesh_free(mesh);
+}
+
 #if 0
 static void test_repartition_2x2x2_uniform_mesh(void** state)
 {
@@ -247,6 +300,7 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_repartition_4x1x1_uniform_mesh),
     cmocka_unit_test(test_repartition_2x2x1_uniform_mesh),
     cmocka_unit_test(test_repartition_4x4x1_uniform_mesh),
+    cmocka_unit_test(test_rebalance_4x4x1_uniform_mesh),
 //    cmocka_unit_test(test_repartition_2x2x2_uniform_mesh),
 //    cmocka_unit_test(test_repartition_4x4x4_uniform_mesh),
 //    cmocka_unit_test(test_repartition_128x1x1_uniform_mesh),
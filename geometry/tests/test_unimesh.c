@@ -12,6 +12,8 @@
 #include "cmocka.h"
 #include "core/tuple.h"
 #include "geometry/unimesh.h"
+#include "geometry/unimesh_field.h"
+#include "geometry/unimesh_patch.h"
 
 // Patch dimensions.
 static const int nx = 4;
@@ -133,12 +135,260 @@ static void test_repartition(void** state)
                                 false, false, false);
 
   // Repartition it!
-  repartition_unimesh(&mesh, NULL, 0.05, NULL, 0);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, NULL, 0);
 
   // Just a smoke test for now, folks.
   unimesh_free(mesh);
 }
 
+static void test_repartition_along_curve(void** state,
+                                         partitioner_t partitioner)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0,
+                 .y1 = 0.0, .y2 = 1.0,
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 4, 4, 4, nx, ny, nz,
+                                false, false, false);
+
+  // Give the patches uneven weights.
+  int weights[4*4*4], total_weight = 0;
+  for (int p = 0; p < 4*4*4; ++p)
+  {
+    weights[p] = 1 + p % 3;
+    total_weight += weights[p];
+  }
+
+  // Tag each patch in a field with its index.
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 1);
+  int pos = 0, pi, pj, pk;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          f[i][j][k][0] = 1.0 * (16*pi + 4*pj + pk);
+  }
+
+  // Repartition!
+  repartition_unimesh(&mesh, partitioner, weights, 0.05, &field, 1);
+
+  // Make sure all patches are accounted for, the loads are balanced to
+  // within a patch, and the field data followed the patches.
+  int num_patches = unimesh_num_patches(mesh), load = 0;
+  pos = 0;
+  while (unimesh_field_next_patch(field, &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    int p = 16*pi + 4*pj + pk;
+    load += weights[p];
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          assert_true(reals_equal(f[i][j][k][0], 1.0 * p));
+  }
+  int nproc, max_load;
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+  MPI_Allreduce(MPI_IN_PLACE, &num_patches, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&load, &max_load, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  assert_int_equal(4*4*4, num_patches);
+  assert_true(max_load <= total_weight/nproc + 3);
+
+  unimesh_field_free(field);
+  unimesh_free(mesh);
+}
+
+static void test_repartition_along_morton_curve(void** state)
+{
+  test_repartition_along_curve(state, MORTON_CURVE_PARTITIONER);
+}
+
+static void test_repartition_along_hilbert_curve(void** state)
+{
+  test_repartition_along_curve(state, HILBERT_CURVE_PARTITIONER);
+}
+
+static void test_rebalance(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0,
+                 .y1 = 0.0, .y2 = 1.0,
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 4, 4, 4, nx, ny, nz,
+                                false, false, false);
+
+  // Make the patches in the lower half of the mesh heavier than the rest.
+  int weights[4*4*4];
+  for (int p = 0; p < 4*4*4; ++p)
+    weights[p] = (p < 32) ? 3 : 1;
+
+  // Tag each patch in a field with its index, and tally our load.
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 1);
+  int pos = 0, pi, pj, pk, load = 0;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    load += weights[16*pi + 4*pj + pk];
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          f[i][j][k][0] = 1.0 * (16*pi + 4*pj + pk);
+  }
+  int old_max_load;
+  MPI_Allreduce(&load, &old_max_load, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  // Rebalance!
+  migration_t migration;
+  rebalance_unimesh(&mesh, weights, 0.05, &field, 1, &migration);
+
+  // We should have moved exactly the field data we predicted.
+  assert_true(migration.predicted_bytes == migration.actual_bytes);
+
+  // Make sure all patches are accounted for, the loads haven't gotten
+  // worse, and the field data followed the patches.
+  int num_patches = unimesh_num_patches(mesh);
+  load = 0;
+  pos = 0;
+  while (unimesh_field_next_patch(field, &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    int p = 16*pi + 4*pj + pk;
+    load += weights[p];
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          assert_true(reals_equal(f[i][j][k][0], 1.0 * p));
+  }
+  int nproc, max_load;
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+  MPI_Allreduce(MPI_IN_PLACE, &num_patches, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&load, &max_load, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  assert_int_equal(4*4*4, num_patches);
+  assert_true(max_load <= old_max_load);
+  if (nproc == 1)
+    assert_true(migration.actual_bytes == 0);
+  else if (old_max_load > 128/nproc + 3)
+    assert_true(max_load < old_max_load);
+
+  unimesh_field_free(field);
+  unimesh_free(mesh);
+}
+
+static void test_measure_patch_costs(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0,
+                 .y1 = 0.0, .y2 = 1.0,
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 4, 4, 4, nx, ny, nz,
+                                false, false, false);
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 1);
+  unimesh_measure_patch_costs(mesh, true);
+  assert_true(unimesh_measures_patch_costs(mesh));
+
+  // Spend 10 ms timing the first patch in a traversal, 10 ms without 
+  // timing the second, and add a cost by hand to the last one.
+  int pos = 0, pi, pj, pk, first = -1, second = -1, last = -1;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    if (first == -1)
+    {
+      first = 16*pi + 4*pj + pk;
+      unimesh_start_patch_timer(mesh, pi, pj, pk);
+      real_t t0 = MPI_Wtime();
+      while (MPI_Wtime() - t0 < 0.01);
+      unimesh_stop_patch_timer(mesh, pi, pj, pk);
+    }
+    else if (second == -1)
+    {
+      second = 16*pi + 4*pj + pk;
+      real_t t0 = MPI_Wtime();
+      while (MPI_Wtime() - t0 < 0.01);
+    }
+    last = 16*pi + 4*pj + pk;
+  }
+  if (last != -1)
+    unimesh_add_patch_cost(mesh, last/16, (last/4)%4, last%4, 1.0);
+
+  // Make sure the costs landed where we put them.
+  real_t costs[4*4*4];
+  unimesh_get_patch_costs(mesh, costs);
+  real_t total_cost = 0.0;
+  for (int p = 0; p < 4*4*4; ++p)
+    total_cost += costs[p];
+  int nproc;
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+  assert_true(total_cost >= nproc * 1.01);
+  if (first != -1)
+    assert_true(costs[first] >= 0.01);
+  if (last != -1)
+    assert_true(costs[last] >= 1.0);
+  if ((second != -1) && (second != last))
+    assert_true(reals_equal(costs[second], 0.0));
+
+  // Resetting the costs zeroes them.
+  unimesh_reset_patch_costs(mesh);
+  unimesh_get_patch_costs(mesh, costs);
+  for (int p = 0; p < 4*4*4; ++p)
+    assert_true(reals_equal(costs[p], 0.0));
+
+  unimesh_field_free(field);
+  unimesh_free(mesh);
+}
+
+static void test_halo_volume(void** state)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0,
+                 .y1 = 0.0, .y2 = 1.0,
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 4, 4, 4, nx, ny, nz,
+                                false, false, false);
+  int nproc;
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+
+  // Treat every process as its own node, so all halo traffic is inter-node.
+  override_rank_nodes(1);
+  int num_nodes;
+  int* nodes = rank_nodes(MPI_COMM_WORLD, &num_nodes);
+  assert_int_equal(nproc, num_nodes);
+  polymec_free(nodes);
+  halo_volume_t volume = unimesh_halo_volume(mesh);
+  assert_true(volume.intra_node == 0);
+  assert_true((nproc == 1) || (volume.inter_node > 0));
+  size_t total = volume.inter_node;
+
+  // Now put everything on one node.
+  override_rank_nodes(1024);
+  volume = unimesh_halo_volume(mesh);
+  assert_true(volume.inter_node == 0);
+  assert_true(volume.intra_node == total);
+
+  // Pair processes up on nodes and repartition. The new decomposition must
+  // still cover the whole mesh.
+  override_rank_nodes(2);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, NULL, 0);
+  volume = unimesh_halo_volume(mesh);
+  assert_true((nproc > 2) || (volume.inter_node == 0));
+  int num_patches = unimesh_num_patches(mesh);
+  MPI_Allreduce(MPI_IN_PLACE, &num_patches, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  assert_int_equal(4*4*4, num_patches);
+
+  // The detected layout is cached, so it's the same from one call to the 
+  // next.
+  override_rank_nodes(0);
+  int num_nodes1, num_nodes2;
+  int* nodes1 = rank_nodes(MPI_COMM_WORLD, &num_nodes1);
+  int* nodes2 = rank_nodes(MPI_COMM_WORLD, &num_nodes2);
+  assert_int_equal(num_nodes1, num_nodes2);
+  for (int p = 0; p < nproc; ++p)
+    assert_int_equal(nodes1[p], nodes2[p]);
+  polymec_free(nodes1);
+  polymec_free(nodes2);
+
+  unimesh_free(mesh);
+}
+
 int main(int argc, char* argv[])
 {
   polymec_init(argc, argv);
@@ -146,7 +396,12 @@ int main(int argc, char* argv[])
   {
     cmocka_unit_test(test_ctors),
     cmocka_unit_test(test_next_patch),
-    cmocka_unit_test(test_repartition)
+    cmocka_unit_test(test_repartition),
+    cmocka_unit_test(test_repartition_along_morton_curve),
+    cmocka_unit_test(test_repartition_along_hilbert_curve),
+    cmocka_unit_test(test_rebalance),
+    cmocka_unit_test(test_measure_patch_costs),
+    cmocka_unit_test(test_halo_volume)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
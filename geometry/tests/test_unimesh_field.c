@@ -171,7 +171,7 @@ static void test_cell_field(void** state, unimesh_t* mesh)
   }
 
   // Repartition!
-  repartition_unimesh(&mesh, NULL, 0.05, &field, 1);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, &field, 1);
 
   // Clean up.
   unimesh_field_free(field);
@@ -432,7 +432,7 @@ static void test_face_fields(void** state, unimesh_t* mesh)
 
   // Repartition!
   unimesh_field_t* fields[3] = {x_field, y_field, z_field};
-  repartition_unimesh(&mesh, NULL, 0.05, fields, 3);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, fields, 3);
 
   // Clean up.
   unimesh_field_free(fields[0]);
@@ -707,7 +707,7 @@ log_debug("(%d, %d, %d): %g != %g", i, patch->ny-1, k, fy[i][patch->ny-1][k][1],
 
   // Repartition!
   unimesh_field_t* fields[3] = {x_field, y_field, z_field};
-  repartition_unimesh(&mesh, NULL, 0.05, fields, 3);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, fields, 3);
 
   // Clean up.
   unimesh_field_free(fields[0]);
@@ -815,7 +815,7 @@ static void test_node_field(void** state, unimesh_t* mesh)
   }
 
   // Repartition!
-  repartition_unimesh(&mesh, NULL, 0.05, &field, 1);
+  repartition_unimesh(&mesh, GRAPH_PARTITIONER, NULL, 0.05, &field, 1);
 
   // Clean up.
   unimesh_field_free(field);
@@ -0,0 +1,347 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "geometry/sphere_sd_func.h"
+#include "geometry/unimesh_hierarchy.h"
+#include "geometry/unimesh_patch.h"
+#include "geometry/unimesh_patch_bc.h"
+
+static int _nproc = -1;
+
+// A linear function, which our interpolation reproduces exactly.
+static real_t linear_func(real_t x, real_t y, real_t z)
+{
+  return 1.0 + x + 2.0*y + 3.0*z;
+}
+
+// Fills ghost cells on the boundary of the base mesh with the linear function.
+static void linear_bc_update(void* context, unimesh_t* mesh,
+                             int i, int j, int k, real_t t,
+                             unimesh_boundary_t boundary,
+                             field_metadata_t* md,
+                             unimesh_patch_t* patch)
+{
+  real_t dx, dy, dz;
+  unimesh_get_spacings(mesh, &dx, &dy, &dz);
+  bbox_t* bbox = unimesh_bbox(mesh);
+  real_t x1 = bbox->x1 + i * patch->nx * dx,
+         y1 = bbox->y1 + j * patch->ny * dy,
+         z1 = bbox->z1 + k * patch->nz * dz;
+
+  int i1 = 1, i2 = patch->nx, j1 = 1, j2 = patch->ny, k1 = 1, k2 = patch->nz;
+  if (boundary == UNIMESH_X1_BOUNDARY)
+    i1 = i2 = 0;
+  else if (boundary == UNIMESH_X2_BOUNDARY)
+    i1 = i2 = patch->nx+1;
+  else if (boundary == UNIMESH_Y1_BOUNDARY)
+    j1 = j2 = 0;
+  else if (boundary == UNIMESH_Y2_BOUNDARY)
+    j1 = j2 = patch->ny+1;
+  else if (boundary == UNIMESH_Z1_BOUNDARY)
+    k1 = k2 = 0;
+  else
+    k1 = k2 = patch->nz+1;
+
+  DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+  for (int ii = i1; ii <= i2; ++ii)
+    for (int jj = j1; jj <= j2; ++jj)
+      for (int kk = k1; kk <= k2; ++kk)
+        f[ii][jj][kk][0] = linear_func(x1 + (ii-0.5)*dx, y1 + (jj-0.5)*dy, z1 + (kk-0.5)*dz);
+}
+
+static unimesh_hierarchy_t* create_hierarchy(int max_levels)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 4, 4, 4, 4, 4, 4,
+                                false, false, false);
+  return unimesh_hierarchy_new(mesh, max_levels);
+}
+
+static void destroy_hierarchy(unimesh_hierarchy_t* hierarchy)
+{
+  unimesh_t* mesh = unimesh_hierarchy_level(hierarchy, 0);
+  unimesh_hierarchy_free(hierarchy);
+  unimesh_free(mesh);
+}
+
+static unimesh_hierarchy_field_t* linear_field_new(unimesh_hierarchy_t* hierarchy)
+{
+  unimesh_hierarchy_field_t* field = unimesh_hierarchy_field_new(hierarchy, 1);
+  unimesh_field_t* base_field = unimesh_hierarchy_field_level(field, 0);
+  unimesh_t* mesh = unimesh_field_mesh(base_field);
+  unimesh_patch_bc_t* bc =
+    unimesh_patch_bc_new_easy("linear BC", NULL,
+                              (unimesh_patch_bc_easy_vtable){.start_update = linear_bc_update},
+                              mesh);
+  for (int b = 0; b < 6; ++b)
+    unimesh_field_set_boundary_bc(base_field, (unimesh_boundary_t)b, bc);
+  release_ref(bc);
+
+  real_t dx, dy, dz;
+  unimesh_get_spacings(mesh, &dx, &dy, &dz);
+  int pos = 0, i, j, k;
+  unimesh_patch_t* patch;
+  bbox_t bbox;
+  while (unimesh_field_next_patch(base_field, &pos, &i, &j, &k, &patch, &bbox))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int ii = 1; ii <= patch->nx; ++ii)
+      for (int jj = 1; jj <= patch->ny; ++jj)
+        for (int kk = 1; kk <= patch->nz; ++kk)
+          f[ii][jj][kk][0] = linear_func(bbox.x1 + (ii-0.5)*dx,
+                                         bbox.y1 + (jj-0.5)*dy,
+                                         bbox.z1 + (kk-0.5)*dz);
+  }
+  return field;
+}
+
+// Checks that every cell (and every ghost cell filled from a coarser level)
+// on the given level holds the linear function.
+static void check_linear_level(void** state,
+                               unimesh_hierarchy_field_t* field,
+                               int level)
+{
+  unimesh_field_t* level_field = unimesh_hierarchy_field_level(field, level);
+  unimesh_t* mesh = unimesh_field_mesh(level_field);
+  real_t dx, dy, dz;
+  unimesh_get_spacings(mesh, &dx, &dy, &dz);
+  int pos = 0, i, j, k;
+  unimesh_patch_t* patch;
+  bbox_t bbox;
+  while (unimesh_field_next_patch(level_field, &pos, &i, &j, &k, &patch, &bbox))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int ii = 0; ii <= patch->nx+1; ++ii)
+    {
+      for (int jj = 0; jj <= patch->ny+1; ++jj)
+      {
+        for (int kk = 0; kk <= patch->nz+1; ++kk)
+        {
+          int num_ghost_indices = ((ii == 0) || (ii == patch->nx+1)) +
+                                  ((jj == 0) || (jj == patch->ny+1)) +
+                                  ((kk == 0) || (kk == patch->nz+1));
+          if (num_ghost_indices > 1)
+            continue;
+          real_t f0 = linear_func(bbox.x1 + (ii-0.5)*dx,
+                                  bbox.y1 + (jj-0.5)*dy,
+                                  bbox.z1 + (kk-0.5)*dz);
+          assert_true(reals_nearly_equal(f[ii][jj][kk][0], f0, 1e-12));
+        }
+      }
+    }
+  }
+}
+
+static bool is_in_lower_octant(void* context, unimesh_t* mesh,
+                               int i, int j, int k, bbox_t* bbox)
+{
+  return ((bbox->x2 <= 0.5) && (bbox->y2 <= 0.5) && (bbox->z2 <= 0.5));
+}
+
+static void test_tagging(void** state)
+{
+  unimesh_hierarchy_t* hierarchy = create_hierarchy(3);
+  assert_int_equal(3, unimesh_hierarchy_max_levels(hierarchy));
+  assert_int_equal(1, unimesh_hierarchy_num_levels(hierarchy));
+
+  // Tag the patches in the lower octant of the domain.
+  unimesh_hierarchy_tag_patches(hierarchy, 0, is_in_lower_octant, NULL);
+  tagger_t* tagger = unimesh_hierarchy_tagger(hierarchy, 0);
+  unimesh_t* mesh = unimesh_hierarchy_level(hierarchy, 0);
+  int num_octant_patches = 0, pos = 0, i, j, k;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, NULL))
+  {
+    if ((i < 2) && (j < 2) && (k < 2))
+      ++num_octant_patches;
+  }
+  size_t num_tags;
+  int* tags = tagger_tag(tagger, "refine", &num_tags);
+  assert_int_equal(num_octant_patches, (int)num_tags);
+  for (size_t t = 0; t < num_tags; ++t)
+  {
+    int index = tags[t];
+    assert_true(index/16 < 2);
+    assert_true((index/4) % 4 < 2);
+    assert_true(index % 4 < 2);
+  }
+
+  // Tagging the same patches again doesn't change anything.
+  unimesh_hierarchy_tag_patches(hierarchy, 0, is_in_lower_octant, NULL);
+  tagger_tag(tagger, "refine", &num_tags);
+  assert_int_equal(num_octant_patches, (int)num_tags);
+
+  // Tagging with a sphere picks up patches near its surface, but not those
+  // near the corners of the domain.
+  point_t x0 = {.x = 0.5, .y = 0.5, .z = 0.5};
+  sd_func_t* sphere = sphere_sd_func_new(&x0, 0.25, INWARD_NORMAL);
+  unimesh_hierarchy_tag_sd_func(hierarchy, 0, sphere, 0.0);
+  tags = tagger_tag(tagger, "refine", &num_tags);
+  for (size_t t = 0; t < num_tags; ++t)
+    assert_true(tags[t] != 63);
+  release_ref(sphere);
+
+  destroy_hierarchy(hierarchy);
+}
+
+static void test_regrid(void** state)
+{
+  unimesh_hierarchy_t* hierarchy = create_hierarchy(3);
+  unimesh_hierarchy_field_t* field = linear_field_new(hierarchy);
+  unimesh_hierarchy_field_update_boundaries(field, 0.0);
+
+  // Refine around a sphere.
+  point_t x0 = {.x = 0.5, .y = 0.5, .z = 0.5};
+  sd_func_t* sphere = sphere_sd_func_new(&x0, 0.3, INWARD_NORMAL);
+  unimesh_hierarchy_tag_sd_func(hierarchy, 0, sphere, 0.0);
+  size_t num_tags;
+  tagger_tag(unimesh_hierarchy_tagger(hierarchy, 0), "refine", &num_tags);
+  unimesh_hierarchy_regrid(hierarchy, 0.0, &field, 1);
+  assert_false(tagger_has_tag(unimesh_hierarchy_tagger(hierarchy, 0), "refine"));
+
+  int num_levels = unimesh_hierarchy_num_levels(hierarchy);
+  if (num_tags > 0)
+  {
+    assert_int_equal(2, num_levels);
+    unimesh_t* fine_mesh = unimesh_hierarchy_level(hierarchy, 1);
+    assert_int_equal(8 * (int)num_tags, unimesh_num_patches(fine_mesh));
+    int npx, npy, npz;
+    unimesh_get_extents(fine_mesh, &npx, &npy, &npz);
+    assert_int_equal(8, npx);
+    assert_int_equal(8, npy);
+    assert_int_equal(8, npz);
+    int pos = 0, i, j, k;
+    while (unimesh_next_patch(fine_mesh, &pos, &i, &j, &k, NULL))
+      assert_true(unimesh_has_patch(unimesh_hierarchy_level(hierarchy, 0), i/2, j/2, k/2));
+
+    // New data is interpolated exactly.
+    unimesh_hierarchy_field_update_boundaries(field, 0.0);
+    check_linear_level(state, field, 1);
+  }
+  else
+    assert_int_equal(1, num_levels);
+
+  // Refine again, adding a third level.
+  for (int l = 0; l < num_levels; ++l)
+    unimesh_hierarchy_tag_sd_func(hierarchy, l, sphere, 0.0);
+  unimesh_hierarchy_regrid(hierarchy, 0.0, &field, 1);
+  num_levels = unimesh_hierarchy_num_levels(hierarchy);
+  unimesh_hierarchy_field_update_boundaries(field, 0.0);
+  for (int l = 0; l < num_levels; ++l)
+    check_linear_level(state, field, l);
+
+  // On a single process, the finest level is properly nested within the
+  // level below it.
+  if ((_nproc == 1) && (num_levels == 3))
+  {
+    unimesh_t* mesh = unimesh_hierarchy_level(hierarchy, 1);
+    unimesh_t* fine_mesh = unimesh_hierarchy_level(hierarchy, 2);
+    int pos = 0, i, j, k;
+    while (unimesh_next_patch(fine_mesh, &pos, &i, &j, &k, NULL))
+    {
+      for (int di = -1; di <= 1; ++di)
+      {
+        for (int dj = -1; dj <= 1; ++dj)
+        {
+          for (int dk = -1; dk <= 1; ++dk)
+          {
+            int I = i + di, J = j + dj, K = k + dk;
+            if ((I >= 0) && (I < 16) && (J >= 0) && (J < 16) && (K >= 0) && (K < 16))
+              assert_true(unimesh_has_patch(mesh, I/2, J/2, K/2));
+          }
+        }
+      }
+    }
+  }
+
+  // Regridding without tags removes the refined levels.
+  unimesh_hierarchy_regrid(hierarchy, 0.0, &field, 1);
+  assert_int_equal(1, unimesh_hierarchy_num_levels(hierarchy));
+  check_linear_level(state, field, 0);
+
+  release_ref(sphere);
+  unimesh_hierarchy_field_free(field);
+  destroy_hierarchy(hierarchy);
+}
+
+static void test_restriction(void** state)
+{
+  unimesh_hierarchy_t* hierarchy = create_hierarchy(3);
+  unimesh_hierarchy_field_t* field = linear_field_new(hierarchy);
+  unimesh_hierarchy_tag_patches(hierarchy, 0, is_in_lower_octant, NULL);
+  unimesh_hierarchy_regrid(hierarchy, 0.0, &field, 1);
+  unimesh_hierarchy_tag_patches(hierarchy, 0, is_in_lower_octant, NULL);
+  if (unimesh_hierarchy_num_levels(hierarchy) > 1)
+    unimesh_hierarchy_tag_patches(hierarchy, 1, is_in_lower_octant, NULL);
+  unimesh_hierarchy_regrid(hierarchy, 0.0, &field, 1);
+  int num_levels = unimesh_hierarchy_num_levels(hierarchy);
+
+  // Put a nonlinear function on the refined levels.
+  for (int l = 1; l < num_levels; ++l)
+  {
+    unimesh_field_t* level_field = unimesh_hierarchy_field_level(field, l);
+    int pos = 0, i, j, k;
+    unimesh_patch_t* patch;
+    while (unimesh_field_next_patch(level_field, &pos, &i, &j, &k, &patch, NULL))
+    {
+      DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+      for (int ii = 1; ii <= patch->nx; ++ii)
+        for (int jj = 1; jj <= patch->ny; ++jj)
+          for (int kk = 1; kk <= patch->nz; ++kk)
+            f[ii][jj][kk][0] = sin(1.0*(i*patch->nx+ii) + 2.0*(j*patch->ny+jj) + 3.0*(k*patch->nz+kk));
+    }
+  }
+
+  // After restriction, the integral of the data over each fine patch
+  // matches that over the coarse cells it covers.
+  unimesh_hierarchy_field_restrict(field);
+  for (int l = 1; l < num_levels; ++l)
+  {
+    unimesh_field_t* coarse_field = unimesh_hierarchy_field_level(field, l-1);
+    unimesh_field_t* fine_field = unimesh_hierarchy_field_level(field, l);
+    int pos = 0, i, j, k;
+    unimesh_patch_t* patch;
+    while (unimesh_field_next_patch(fine_field, &pos, &i, &j, &k, &patch, NULL))
+    {
+      unimesh_patch_t* coarse_patch = unimesh_field_patch(coarse_field, i/2, j/2, k/2);
+      assert_true(coarse_patch != NULL);
+      DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+      DECLARE_UNIMESH_CELL_ARRAY(C, coarse_patch);
+      real_t fine_sum = 0.0, coarse_sum = 0.0;
+      for (int ii = 1; ii <= patch->nx; ++ii)
+        for (int jj = 1; jj <= patch->ny; ++jj)
+          for (int kk = 1; kk <= patch->nz; ++kk)
+            fine_sum += f[ii][jj][kk][0];
+      int nx = patch->nx/2, ny = patch->ny/2, nz = patch->nz/2;
+      for (int ii = 1; ii <= nx; ++ii)
+        for (int jj = 1; jj <= ny; ++jj)
+          for (int kk = 1; kk <= nz; ++kk)
+            coarse_sum += C[(i%2)*nx+ii][(j%2)*ny+jj][(k%2)*nz+kk][0];
+      assert_true(reals_nearly_equal(fine_sum, 8.0 * coarse_sum, 1e-12));
+    }
+  }
+
+  unimesh_hierarchy_field_free(field);
+  destroy_hierarchy(hierarchy);
+}
+
+int main(int argc, char* argv[])
+{
+  polymec_init(argc, argv);
+  MPI_Comm_size(MPI_COMM_WORLD, &_nproc);
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test(test_tagging),
+    cmocka_unit_test(test_regrid),
+    cmocka_unit_test(test_restriction)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -74,6 +74,11 @@ struct unimesh_t
   // Observers.
   unimesh_observer_array_t* observers;
 
+  // Measured compute costs of patches (NULL unless enabled), and the times
+  // at which their timers were started (negative if not running).
+  real_t* patch_costs;
+  real_t* patch_timer_starts;
+
   // This flag is set by unimesh_finalize() after a mesh has been assembled.
   bool finalized;
 };
@@ -122,6 +127,8 @@ unimesh_t* create_empty_unimesh(MPI_Comm comm, bbox_t* bbox,
   MPI_Comm_size(comm, &mesh->nproc);
   mesh->owner_procs = int_int_unordered_map_new();
   mesh->observers = unimesh_observer_array_new();
+  mesh->patch_costs = NULL;
+  mesh->patch_timer_starts = NULL;
   mesh->finalized = false;
 
   // Set the mesh's unique ID on this communicator.
@@ -413,6 +420,11 @@ void unimesh_free(unimesh_t* mesh)
   int_unordered_set_free(mesh->patches);
   if (mesh->patch_indices != NULL)
     polymec_free(mesh->patch_indices);
+  if (mesh->patch_costs != NULL)
+  {
+    polymec_free(mesh->patch_costs);
+    polymec_free(mesh->patch_timer_starts);
+  }
   polymec_free(mesh);
 }
 
@@ -541,6 +553,119 @@ int unimesh_num_patches(unimesh_t* mesh)
   return (int)mesh->patches->size;
 }
 
+halo_volume_t unimesh_halo_volume(unimesh_t* mesh)
+{
+  START_FUNCTION_TIMER();
+  int num_nodes;
+  int* nodes = rank_nodes(mesh->comm, &num_nodes);
+
+  // Each local patch exchanges a layer of cells with each of its neighbors.
+  size_t boundary_sizes[6] = {(size_t)(mesh->ny * mesh->nz), (size_t)(mesh->ny * mesh->nz),
+                              (size_t)(mesh->nx * mesh->nz), (size_t)(mesh->nx * mesh->nz),
+                              (size_t)(mesh->nx * mesh->ny), (size_t)(mesh->nx * mesh->ny)};
+  size_t volumes[2] = {0, 0};
+  int pos = 0, i, j, k;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, NULL))
+  {
+    int index = patch_index(mesh, i, j, k);
+    for (int b = 0; b < 6; ++b)
+    {
+      int* proc_p = int_int_unordered_map_get(mesh->owner_procs, 6*index + b);
+      if ((proc_p != NULL) && (*proc_p >= 0) && (*proc_p != mesh->rank))
+      {
+        if (nodes[*proc_p] == nodes[mesh->rank])
+          volumes[0] += boundary_sizes[b];
+        else
+          volumes[1] += boundary_sizes[b];
+      }
+    }
+  }
+  polymec_free(nodes);
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, volumes, 2, MPI_SIZE_T, MPI_SUM, mesh->comm);
+#endif
+  halo_volume_t volume = {.intra_node = volumes[0], .inter_node = volumes[1]};
+  STOP_FUNCTION_TIMER();
+  return volume;
+}
+
+void unimesh_measure_patch_costs(unimesh_t* mesh, bool flag)
+{
+  if (flag && (mesh->patch_costs == NULL))
+  {
+    int num_patches = mesh->npx * mesh->npy * mesh->npz;
+    mesh->patch_costs = polymec_calloc(num_patches, sizeof(real_t));
+    mesh->patch_timer_starts = polymec_malloc(sizeof(real_t) * num_patches);
+    for (int p = 0; p < num_patches; ++p)
+      mesh->patch_timer_starts[p] = -1.0;
+  }
+  else if (!flag && (mesh->patch_costs != NULL))
+  {
+    polymec_free(mesh->patch_costs);
+    mesh->patch_costs = NULL;
+    polymec_free(mesh->patch_timer_starts);
+    mesh->patch_timer_starts = NULL;
+  }
+}
+
+bool unimesh_measures_patch_costs(unimesh_t* mesh)
+{
+  return (mesh->patch_costs != NULL);
+}
+
+void unimesh_add_patch_cost(unimesh_t* mesh, int i, int j, int k, real_t cost)
+{
+  ASSERT(unimesh_has_patch(mesh, i, j, k));
+  if (mesh->patch_costs != NULL)
+    mesh->patch_costs[patch_index(mesh, i, j, k)] += cost;
+}
+
+void unimesh_get_patch_costs(unimesh_t* mesh, real_t* costs)
+{
+  int num_patches = mesh->npx * mesh->npy * mesh->npz;
+  if (mesh->patch_costs != NULL)
+    memcpy(costs, mesh->patch_costs, sizeof(real_t) * num_patches);
+  else
+    memset(costs, 0, sizeof(real_t) * num_patches);
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, costs, num_patches, MPI_REAL_T, MPI_SUM, mesh->comm);
+#endif
+}
+
+void unimesh_reset_patch_costs(unimesh_t* mesh)
+{
+  if (mesh->patch_costs != NULL)
+  {
+    int num_patches = mesh->npx * mesh->npy * mesh->npz;
+    memset(mesh->patch_costs, 0, sizeof(real_t) * num_patches);
+    for (int p = 0; p < num_patches; ++p)
+      mesh->patch_timer_starts[p] = -1.0;
+  }
+}
+
+void unimesh_start_patch_timer(unimesh_t* mesh, int i, int j, int k)
+{
+  ASSERT(unimesh_has_patch(mesh, i, j, k));
+  if (mesh->patch_costs != NULL)
+  {
+    int p = patch_index(mesh, i, j, k);
+    ASSERT(mesh->patch_timer_starts[p] < 0.0);
+    mesh->patch_timer_starts[p] = MPI_Wtime();
+  }
+}
+
+void unimesh_stop_patch_timer(unimesh_t* mesh, int i, int j, int k)
+{
+  ASSERT(unimesh_has_patch(mesh, i, j, k));
+  if (mesh->patch_costs != NULL)
+  {
+    int p = patch_index(mesh, i, j, k);
+    ASSERT(mesh->patch_timer_starts[p] >= 0.0);
+    mesh->patch_costs[p] += MPI_Wtime() - mesh->patch_timer_starts[p];
+    mesh->patch_timer_starts[p] = -1.0;
+  }
+}
+
 void unimesh_get_periodicity(unimesh_t* mesh,
                              bool* periodic_in_x,
                              bool* periodic_in_y,
@@ -1003,9 +1128,12 @@ void unimesh_finish_updating_patch_boundaries(unimesh_t* mesh, int token)
     }
   }
 
-  // Go over the patches that correspond to this token.
-  boundary_update_array_t* updates = *((boundary_update_array_t**)int_ptr_unordered_map_get(mesh->boundary_updates, token));
-  for (size_t i = 0; i < updates->size; ++i)
+  // Go over the patches that correspond to this token. If this process has
+  // no patches in the mesh, there aren't any.
+  boundary_update_array_t** updates_p = (boundary_update_array_t**)int_ptr_unordered_map_get(mesh->boundary_updates, token);
+  boundary_update_array_t* updates = (updates_p != NULL) ? *updates_p : NULL;
+  size_t num_updates = (updates != NULL) ? updates->size : 0;
+  for (size_t i = 0; i < num_updates; ++i)
   {
     boundary_update_t* update = updates->data[i];
     int index = patch_index(mesh, update->i, update->j, update->k);
@@ -1048,7 +1176,7 @@ void unimesh_finish_updating_patch_boundaries(unimesh_t* mesh, int token)
   for (size_t i = 0; i < mesh->observers->size; ++i)
   {
     unimesh_observer_t* obs = mesh->observers->data[i];
-    if (obs->vtable.finished_boundary_update != NULL)
+    if (obs->vtable.finished_boundary_updates != NULL)
     {
       obs->vtable.finished_boundary_updates(obs->context, mesh, token,
                                             buffer->centering, buffer->nc);
@@ -1056,7 +1184,8 @@ void unimesh_finish_updating_patch_boundaries(unimesh_t* mesh, int token)
   }
 
   // Clear the updates array.
-  boundary_update_array_clear(updates);
+  if (updates != NULL)
+    boundary_update_array_clear(updates);
 
   // Release the boundary update corresponding to this token.
   boundary_buffer_pool_release(mesh->boundary_buffers, token);
@@ -1196,6 +1325,27 @@ int unimesh_owner_proc(unimesh_t* mesh,
     return *proc_p;
 }
 
+// This records the process that owns the patch attached to the given
+// boundary of the given local patch (i, j, k), for meshes whose patches are
+// inserted by something other than unimesh itself. It must be called before
+// the mesh is finalized.
+void unimesh_set_owner_proc(unimesh_t* mesh,
+                            int i, int j, int k,
+                            unimesh_boundary_t boundary,
+                            int proc);
+void unimesh_set_owner_proc(unimesh_t* mesh,
+                            int i, int j, int k,
+                            unimesh_boundary_t boundary,
+                            int proc)
+{
+  ASSERT(!mesh->finalized);
+  ASSERT(unimesh_has_patch(mesh, i, j, k));
+  ASSERT(proc != mesh->rank);
+  int index = patch_index(mesh, i, j, k);
+  int b = (int)boundary;
+  int_int_unordered_map_insert(mesh->owner_procs, 6*index + b, proc);
+}
+
 // This returns a unique identifier for the given mesh, which is the same
 // on all processes that belong to the mesh's communicator. If the local
 // process doesn't belong to the mesh's communicator, this function returns
@@ -1389,8 +1539,323 @@ static int64_t* source_vector(unimesh_t* mesh)
   return sources;
 }
 
+// A patch plan describes where the patches of a mesh go when it is 
+// redistributed. The new owner of any patch is given either by a global 
+// partition vector or, for a space-filling curve partition, by the first 
+// curve index in the segment owned by each process. Each process also knows
+// the current owners of the patches it will own.
+typedef struct
+{
+  // Global partition vector, or NULL for a curve partition.
+  int64_t* partition;
+
+  // For a curve partition: the curve, and the first index on the curve owned
+  // by each process (nondecreasing, since processes own consecutive 
+  // segments, with empty segments starting where the next one does).
+  partitioner_t curve;
+  index_t* segment_starts;
+
+  // Maps each patch this process will own to its current owner.
+  int_int_unordered_map_t* sources;
+} patch_plan_t;
+
+static void patch_plan_free(patch_plan_t* plan)
+{
+  if (plan->partition != NULL)
+    polymec_free(plan->partition);
+  if (plan->segment_starts != NULL)
+    polymec_free(plan->segment_starts);
+  int_int_unordered_map_free(plan->sources);
+  polymec_free(plan);
+}
+
+// Returns the process that will own the patch (i, j, k) in the given plan.
+static int patch_plan_owner(unimesh_t* mesh, patch_plan_t* plan, 
+                            int i, int j, int k)
+{
+  if (plan->partition != NULL)
+    return (int)plan->partition[patch_index(mesh, i, j, k)];
+
+  // Find the last segment starting at or before the patch's curve index.
+  index_t index = lattice_curve_index(plan->curve, i, j, k);
+  int lo = 0, hi = mesh->nproc;
+  while (hi - lo > 1)
+  {
+    int mid = (lo + hi) / 2;
+    if (plan->segment_starts[mid] <= index)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Creates a patch plan from a global partition vector (which the plan 
+// consumes) and a global vector holding the current owner of each patch.
+static patch_plan_t* global_patch_plan(unimesh_t* mesh,
+                                       int64_t* partition,
+                                       int64_t* sources)
+{
+  patch_plan_t* plan = polymec_malloc(sizeof(patch_plan_t));
+  plan->partition = partition;
+  plan->curve = GRAPH_PARTITIONER;
+  plan->segment_starts = NULL;
+  plan->sources = int_int_unordered_map_new();
+  int num_patches = mesh->npx * mesh->npy * mesh->npz;
+  for (int p = 0; p < num_patches; ++p)
+  {
+    if (partition[p] == mesh->rank)
+      int_int_unordered_map_insert(plan->sources, p, (int)sources[p]);
+  }
+  return plan;
+}
+
+// Partitions the mesh's patches along a space-filling curve, in parallel,
+// returning a patch plan. No global data is assembled: each process learns 
+// the starting index of every process's segment of the curve (O(nproc) 
+// data), and patches that move are sent directly to their new owners.
+static patch_plan_t* curve_patch_plan(unimesh_t* mesh,
+                                      partitioner_t partitioner,
+                                      int* weights,
+                                      real_t imbalance_tol)
+{
+  START_FUNCTION_TIMER();
+
+  // Map our local patches to the curve.
+  int num_local_patches = (int)mesh->patches->size;
+  int* local_patches = polymec_malloc(sizeof(int) * MAX(num_local_patches, 1));
+  index_t* indices = polymec_malloc(sizeof(index_t) * MAX(num_local_patches, 1));
+  int* local_weights = (weights != NULL) ? polymec_malloc(sizeof(int) * MAX(num_local_patches, 1))
+                                         : NULL;
+  int pos = 0, i, j, k, l = 0;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, NULL))
+  {
+    local_patches[l] = patch_index(mesh, i, j, k);
+    indices[l] = lattice_curve_index(partitioner, i, j, k);
+    if (weights != NULL)
+      local_weights[l] = weights[local_patches[l]];
+    ++l;
+  }
+  ASSERT(l == num_local_patches);
+
+  // Split the curve.
+  int64_t* local_partition = partition_curve_indices(indices, num_local_patches,
+                                                     mesh->comm, local_weights);
+
+  // Find where each process's segment starts, and how much each weighs.
+  int nproc = mesh->nproc;
+  patch_plan_t* plan = polymec_malloc(sizeof(patch_plan_t));
+  plan->partition = NULL;
+  plan->curve = partitioner;
+  plan->segment_starts = polymec_malloc(sizeof(index_t) * nproc);
+  uint64_t* loads = polymec_calloc(nproc, sizeof(uint64_t));
+  for (int p = 0; p < nproc; ++p)
+    plan->segment_starts[p] = UINT64_MAX;
+  for (l = 0; l < num_local_patches; ++l)
+  {
+    int r = (int)local_partition[l];
+    plan->segment_starts[r] = MIN(plan->segment_starts[r], indices[l]);
+    loads[r] += (weights != NULL) ? (uint64_t)local_weights[l] : 1;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, plan->segment_starts, nproc, MPI_INDEX_T, 
+                MPI_MIN, mesh->comm);
+  MPI_Allreduce(MPI_IN_PLACE, loads, nproc, MPI_UINT64_T, MPI_SUM, mesh->comm);
+  for (int p = nproc-2; p >= 0; --p)
+    plan->segment_starts[p] = MIN(plan->segment_starts[p], plan->segment_starts[p+1]);
+
+  // Contiguous segments can only balance the load to within the weight of 
+  // a patch, so we report it when we can't meet the tolerance.
+  uint64_t total_load = 0, max_load = 0;
+  for (int p = 0; p < nproc; ++p)
+  {
+    total_load += loads[p];
+    max_load = MAX(max_load, loads[p]);
+  }
+  real_t imbalance = (total_load > 0) ? (1.0 * max_load * nproc) / (1.0 * total_load) - 1.0 : 0.0;
+  if (imbalance > imbalance_tol)
+  {
+    log_info("repartition_unimesh: Curve partition has a load imbalance of "
+             "%g%% (tolerance: %g%%).", 100.0 * imbalance, 100.0 * imbalance_tol);
+  }
+  polymec_free(loads);
+
+  // Send the indices of the patches that move to their new owners.
+  int send_counts[nproc], recv_counts[nproc];
+  memset(send_counts, 0, sizeof(int) * nproc);
+  for (l = 0; l < num_local_patches; ++l)
+  {
+    if (local_partition[l] != mesh->rank)
+      ++send_counts[local_partition[l]];
+  }
+  MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, mesh->comm);
+  int send_offsets[nproc+1], recv_offsets[nproc+1];
+  send_offsets[0] = recv_offsets[0] = 0;
+  for (int p = 0; p < nproc; ++p)
+  {
+    send_offsets[p+1] = send_offsets[p] + send_counts[p];
+    recv_offsets[p+1] = recv_offsets[p] + recv_counts[p];
+  }
+  int* send_patches = polymec_malloc(sizeof(int) * MAX(send_offsets[nproc], 1));
+  int* recv_patches = polymec_malloc(sizeof(int) * MAX(recv_offsets[nproc], 1));
+  int next[nproc];
+  memcpy(next, send_offsets, sizeof(int) * nproc);
+  for (l = 0; l < num_local_patches; ++l)
+  {
+    int r = (int)local_partition[l];
+    if (r != mesh->rank)
+      send_patches[next[r]++] = local_patches[l];
+  }
+  MPI_Alltoallv(send_patches, send_counts, send_offsets, MPI_INT,
+                recv_patches, recv_counts, recv_offsets, MPI_INT, mesh->comm);
+
+  // Record the current owners of our new patches.
+  plan->sources = int_int_unordered_map_new();
+  for (l = 0; l < num_local_patches; ++l)
+  {
+    if (local_partition[l] == mesh->rank)
+      int_int_unordered_map_insert(plan->sources, local_patches[l], mesh->rank);
+  }
+  for (int p = 0; p < nproc; ++p)
+  {
+    for (int m = recv_offsets[p]; m < recv_offsets[p+1]; ++m)
+      int_int_unordered_map_insert(plan->sources, recv_patches[m], p);
+  }
+
+  // Clean up.
+  polymec_free(recv_patches);
+  polymec_free(send_patches);
+  polymec_free(local_partition);
+  if (local_weights != NULL)
+    polymec_free(local_weights);
+  polymec_free(indices);
+  polymec_free(local_patches);
+
+  STOP_FUNCTION_TIMER();
+  return plan;
+}
+
+// Assembles a global partition vector from the destination ranks of the
+// given local patches on each process.
+static int64_t* global_partition(unimesh_t* mesh,
+                                 int* local_patches,
+                                 int64_t* local_partition,
+                                 int num_local_patches)
+{
+  // Share the (patch, rank) pairs.
+  int64_t* local_pairs = polymec_malloc(sizeof(int64_t) * 2 * MAX(num_local_patches, 1));
+  for (int l = 0; l < num_local_patches; ++l)
+  {
+    local_pairs[2*l] = (int64_t)local_patches[l];
+    local_pairs[2*l+1] = local_partition[l];
+  }
+  int num_pair_values = 2 * num_local_patches;
+  int num_pair_values_for_proc[mesh->nproc];
+  MPI_Allgather(&num_pair_values, 1, MPI_INT,
+                num_pair_values_for_proc, 1, MPI_INT, mesh->comm);
+  int proc_offsets[mesh->nproc+1];
+  proc_offsets[0] = 0;
+  for (int p = 0; p < mesh->nproc; ++p)
+    proc_offsets[p+1] = proc_offsets[p] + num_pair_values_for_proc[p];
+  int num_patches = mesh->npx * mesh->npy * mesh->npz;
+  ASSERT(proc_offsets[mesh->nproc] == 2 * num_patches);
+  int64_t* all_pairs = polymec_malloc(sizeof(int64_t) * 2 * num_patches);
+  MPI_Allgatherv(local_pairs, num_pair_values, MPI_INT64_T,
+                 all_pairs, num_pair_values_for_proc, proc_offsets,
+                 MPI_INT64_T, mesh->comm);
+  int64_t* partition = polymec_malloc(sizeof(int64_t) * num_patches);
+  for (int p = 0; p < num_patches; ++p)
+    partition[all_pairs[2*p]] = all_pairs[2*p+1];
+
+  polymec_free(all_pairs);
+  polymec_free(local_pairs);
+  return partition;
+}
+
+// Rebalances the mesh's patches by diffusion, moving patches only between
+// neighboring processes, and returns a global partition vector. Here,
+// sources holds the current owner of each patch.
+static int64_t* diffusion_partition(unimesh_t* mesh,
+                                    int64_t* sources,
+                                    int* weights,
+                                    size_t* migration_costs,
+                                    real_t imbalance_tol,
+                                    size_t* predicted_migration)
+{
+  START_FUNCTION_TIMER();
+
+  // Number our local patches, and their neighbors on other processes as
+  // ghosts.
+  int num_local_patches = (int)mesh->patches->size;
+  int* local_patches = polymec_malloc(sizeof(int) * MAX(num_local_patches, 1));
+  int_int_unordered_map_t* local_indices = int_int_unordered_map_new();
+  int pos = 0, i, j, k, l = 0;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, NULL))
+  {
+    local_patches[l] = patch_index(mesh, i, j, k);
+    int_int_unordered_map_insert(local_indices, local_patches[l], l);
+    ++l;
+  }
+  adj_graph_t* graph = adj_graph_new(mesh->comm, num_local_patches);
+  int_array_t* ghost_owners = int_array_new();
+  int* local_weights = (weights != NULL) ? polymec_malloc(sizeof(int) * MAX(num_local_patches, 1))
+                                         : NULL;
+  for (l = 0; l < num_local_patches; ++l)
+  {
+    get_patch_indices(mesh, local_patches[l], &i, &j, &k);
+    if (weights != NULL)
+      local_weights[l] = weights[local_patches[l]];
+
+    // Find the patch's neighbors.
+    int neighbors[6], num_neighbors = 0;
+    int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                         {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+    for (int n = 0; n < 6; ++n)
+    {
+      int i1 = i + offsets[n][0], j1 = j + offsets[n][1], k1 = k + offsets[n][2];
+      if (mesh->periodic_in_x) i1 = (i1 + mesh->npx) % mesh->npx;
+      if (mesh->periodic_in_y) j1 = (j1 + mesh->npy) % mesh->npy;
+      if (mesh->periodic_in_z) k1 = (k1 + mesh->npz) % mesh->npz;
+      if ((i1 >= 0) && (i1 < mesh->npx) &&
+          (j1 >= 0) && (j1 < mesh->npy) &&
+          (k1 >= 0) && (k1 < mesh->npz))
+      {
+        int p1 = patch_index(mesh, i1, j1, k1);
+        int* l1 = int_int_unordered_map_get(local_indices, p1);
+        if (l1 != NULL)
+          neighbors[num_neighbors++] = *l1;
+        else
+        {
+          neighbors[num_neighbors++] = num_local_patches + (int)ghost_owners->size;
+          int_array_append(ghost_owners, (int)sources[p1]);
+        }
+      }
+    }
+    adj_graph_set_num_edges(graph, l, num_neighbors);
+    memcpy(adj_graph_edges(graph, l), neighbors, sizeof(int) * num_neighbors);
+  }
+
+  // Rebalance the graph.
+  int64_t* local_partition = rebalance_graph(graph, ghost_owners->data,
+                                             local_weights, migration_costs,
+                                             imbalance_tol, predicted_migration);
+  int64_t* partition = global_partition(mesh, local_patches, local_partition,
+                                        num_local_patches);
+
+  // Clean up.
+  polymec_free(local_partition);
+  if (local_weights != NULL)
+    polymec_free(local_weights);
+  int_array_free(ghost_owners);
+  adj_graph_free(graph);
+  int_int_unordered_map_free(local_indices);
+  polymec_free(local_patches);
+
+  STOP_FUNCTION_TIMER();
+  return partition;
+}
+
 static void redistribute_unimesh(unimesh_t** mesh,
-                                 int64_t* partition)
+                                 patch_plan_t* plan)
 {
   START_FUNCTION_TIMER();
 
@@ -1404,15 +1869,33 @@ static void redistribute_unimesh(unimesh_t** mesh,
                                              old_mesh->periodic_in_y,
                                              old_mesh->periodic_in_z);
 
-  // Insert the new patches as prescribed by the partition vector.
-  int num_patches = new_mesh->npx * new_mesh->npy * new_mesh->npz;
-  for (int p = 0; p < num_patches; ++p)
+  // Insert the new patches as prescribed by the plan.
+  int pos = 0, p, source;
+  while (int_int_unordered_map_next(plan->sources, &pos, &p, &source))
   {
-    if (partition[p] == new_mesh->rank)
+    int i, j, k;
+    get_patch_indices(new_mesh, p, &i, &j, &k);
+    unimesh_insert_patch(new_mesh, i, j, k);
+
+    // Track the processes that own neighboring patches.
+    int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                         {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+    for (int b = 0; b < 6; ++b)
     {
-      int i, j, k;
-      get_patch_indices(new_mesh, p, &i, &j, &k);
-      unimesh_insert_patch(new_mesh, i, j, k);
+      int i1 = i + offsets[b][0], j1 = j + offsets[b][1], k1 = k + offsets[b][2];
+      if (new_mesh->periodic_in_x)
+        i1 = (i1 + new_mesh->npx) % new_mesh->npx;
+      if (new_mesh->periodic_in_y)
+        j1 = (j1 + new_mesh->npy) % new_mesh->npy;
+      if (new_mesh->periodic_in_z)
+        k1 = (k1 + new_mesh->npz) % new_mesh->npz;
+      int owner = -1;
+      if ((i1 >= 0) && (i1 < new_mesh->npx) &&
+          (j1 >= 0) && (j1 < new_mesh->npy) &&
+          (k1 >= 0) && (k1 < new_mesh->npz))
+        owner = patch_plan_owner(new_mesh, plan, i1, j1, k1);
+      if (owner != new_mesh->rank)
+        int_int_unordered_map_insert(new_mesh->owner_procs, 6*p + b, owner);
     }
   }
 
@@ -1421,12 +1904,11 @@ static void redistribute_unimesh(unimesh_t** mesh,
   STOP_FUNCTION_TIMER();
 }
 
-// Redistributes the given unimesh using the given partition vector, but
-// does not finalize the mesh.
-static void redistribute_unimesh_field(unimesh_field_t** field,
-                                       int64_t* partition,
-                                       int64_t* sources,
-                                       unimesh_t* new_mesh)
+// Redistributes the given unimesh field using the given partition vector,
+// returning the number of bytes sent from this process.
+static size_t redistribute_unimesh_field(unimesh_field_t** field,
+                                         patch_plan_t* plan,
+                                         unimesh_t* new_mesh)
 {
   START_FUNCTION_TIMER();
 
@@ -1454,15 +1936,16 @@ static void redistribute_unimesh_field(unimesh_field_t** field,
   while (unimesh_field_next_patch(new_field, &pos, &i, &j, &k, &patch, NULL))
   {
     int p = patch_index(new_mesh, i, j, k);
-    if (partition[p] == new_mesh->rank)
+    int source = *int_int_unordered_map_get(plan->sources, p);
+    if (source != new_mesh->rank)
     {
       size_t data_size = unimesh_patch_data_size(patch->centering,
                                                  patch->nx, patch->ny, patch->nz,
                                                  patch->nc) / sizeof(real_t);
-      int err = MPI_Irecv(patch->data, (int)data_size, MPI_REAL_T, (int)sources[p],
+      int err = MPI_Irecv(patch->data, (int)data_size, MPI_REAL_T, source,
                           0, new_mesh->comm, &(recv_requests[num_recv_reqs]));
       if (err != MPI_SUCCESS)
-        polymec_error("Error receiving field data from rank %d", (int)sources[p]);
+        polymec_error("Error receiving field data from rank %d", source);
       ++num_recv_reqs;
     }
   }
@@ -1473,19 +1956,21 @@ static void redistribute_unimesh_field(unimesh_field_t** field,
   MPI_Request send_requests[num_old_local_patches];
   pos = 0;
   int num_send_reqs = 0;
+  size_t num_bytes_sent = 0;
   while (unimesh_field_next_patch(old_field, &pos, &i, &j, &k, &patch, NULL))
   {
-    int p = patch_index(new_mesh, i, j, k);
-    if (sources[p] == new_mesh->rank)
+    int owner = patch_plan_owner(new_mesh, plan, i, j, k);
+    if (owner != new_mesh->rank)
     {
       size_t data_size = unimesh_patch_data_size(patch->centering,
                                                  patch->nx, patch->ny, patch->nz,
                                                  patch->nc) / sizeof(real_t);
-      int err = MPI_Isend(patch->data, (int)data_size, MPI_REAL_T, (int)partition[p],
+      int err = MPI_Isend(patch->data, (int)data_size, MPI_REAL_T, owner,
                           0, new_mesh->comm, &(send_requests[num_send_reqs]));
       if (err != MPI_SUCCESS)
-        polymec_error("Error sending field data to rank %d", (int)partition[p]);
+        polymec_error("Error sending field data to rank %d", owner);
       ++num_send_reqs;
+      num_bytes_sent += sizeof(real_t) * data_size;
     }
   }
   ASSERT(num_send_reqs <= num_old_local_patches);
@@ -1497,10 +1982,12 @@ static void redistribute_unimesh_field(unimesh_field_t** field,
   // Replace the old field with the new one.
   *field = new_field;
   STOP_FUNCTION_TIMER();
+  return num_bytes_sent;
 }
 #endif
 
 void repartition_unimesh(unimesh_t** mesh,
+                         partitioner_t partitioner,
                          int* weights,
                          real_t imbalance_tol,
                          unimesh_field_t** fields,
@@ -1522,40 +2009,114 @@ void repartition_unimesh(unimesh_t** mesh,
     return;
   }
 
-  // Generate a global adjacency graph for the mesh.
-  adj_graph_t* graph = graph_from_unimesh_patches(old_mesh);
-
-  // Map the graph to the different domains, producing a partition vector.
-  // We need the partition vector on all processes, so we scatter it
-  // from rank 0.
+  // Produce a partition vector for the mesh. We need the partition vector
+  // on all processes.
   log_debug("repartition_unimesh: Repartitioning mesh on %d subdomains.", old_mesh->nproc);
-  int64_t* partition = partition_graph(graph, old_mesh->comm, weights, imbalance_tol, true);
+  patch_plan_t* plan;
+  if (partitioner == GRAPH_PARTITIONER)
+  {
+    // Generate a global adjacency graph for the mesh and map it to the
+    // different domains on rank 0, which scatters the result.
+    adj_graph_t* graph = graph_from_unimesh_patches(old_mesh);
+    int64_t* partition = partition_graph(graph, old_mesh->comm, weights, imbalance_tol, true);
+    adj_graph_free(graph);
+
+    // Build a sources vector whose ith component is the rank that used to 
+    // own the ith patch.
+    int64_t* sources = source_vector(old_mesh);
+    plan = global_patch_plan(old_mesh, partition, sources);
+    polymec_free(sources);
+  }
+  else
+    plan = curve_patch_plan(old_mesh, partitioner, weights, imbalance_tol);
 
   // Redistribute the mesh.
   log_debug("repartition_unimesh: Redistributing mesh.");
-  redistribute_unimesh(mesh, partition);
+  redistribute_unimesh(mesh, plan);
   unimesh_finalize(*mesh);
 
-  // Build a sources vector whose ith component is the rank that used to own
-  // the ith patch.
-  int64_t* sources = source_vector(old_mesh);
-
   // Redistribute the fields.
   if (num_fields > 0)
     log_debug("repartition_unimesh: Redistributing %d fields.", (int)num_fields);
   for (size_t f = 0; f < num_fields; ++f)
   {
     unimesh_field_t* old_field = fields[f];
-    redistribute_unimesh_field(&(fields[f]), partition, sources, *mesh);
+    redistribute_unimesh_field(&(fields[f]), plan, *mesh);
     unimesh_field_free(old_field);
   }
 
   // Clean up.
   unimesh_free(old_mesh);
-  adj_graph_free(graph);
-  polymec_free(sources);
-  polymec_free(partition);
+  patch_plan_free(plan);
+
+  if (log_level() >= LOG_DETAIL)
+  {
+    halo_volume_t volume = unimesh_halo_volume(*mesh);
+    log_detail("repartition_unimesh: Halo volume: %zu cells within nodes, %zu between nodes.",
+               volume.intra_node, volume.inter_node);
+  }
+
+  STOP_FUNCTION_TIMER();
+#endif
+}
+
+void rebalance_unimesh(unimesh_t** mesh,
+                       int* weights,
+                       real_t imbalance_tol,
+                       unimesh_field_t** fields,
+                       size_t num_fields,
+                       migration_t* migration)
+{
+  ASSERT(imbalance_tol > 0.0);
+  ASSERT(imbalance_tol <= 1.0);
+  ASSERT((fields != NULL) || (num_fields == 0));
+  migration_t m_data = {.predicted_bytes = 0, .actual_bytes = 0};
+#if POLYMEC_HAVE_MPI
+  START_FUNCTION_TIMER();
+  unimesh_t* old_mesh = *mesh;
+  if (old_mesh->nproc > 1)
+  {
+    // Find the owner of each patch.
+    int64_t* sources = source_vector(old_mesh);
 
+    // Each patch carries its field data with it.
+    size_t patch_bytes = 0;
+    for (size_t f = 0; f < num_fields; ++f)
+    {
+      patch_bytes += unimesh_patch_data_size(unimesh_field_centering(fields[f]),
+                                             old_mesh->nx, old_mesh->ny, old_mesh->nz,
+                                             unimesh_field_num_components(fields[f]));
+    }
+    int num_local_patches = (int)old_mesh->patches->size;
+    size_t costs[MAX(num_local_patches, 1)];
+    for (int l = 0; l < num_local_patches; ++l)
+      costs[l] = patch_bytes;
+
+    // Move patches between neighboring processes.
+    int64_t* partition = diffusion_partition(old_mesh, sources, weights, costs,
+                                             imbalance_tol, &m_data.predicted_bytes);
+    patch_plan_t* plan = global_patch_plan(old_mesh, partition, sources);
+    redistribute_unimesh(mesh, plan);
+    unimesh_finalize(*mesh);
+    size_t num_bytes_sent = 0;
+    for (size_t f = 0; f < num_fields; ++f)
+    {
+      unimesh_field_t* old_field = fields[f];
+      num_bytes_sent += redistribute_unimesh_field(&(fields[f]), plan, *mesh);
+      unimesh_field_free(old_field);
+    }
+    MPI_Allreduce(&num_bytes_sent, &m_data.actual_bytes, 1, MPI_SIZE_T,
+                  MPI_SUM, old_mesh->comm);
+    log_detail("rebalance_unimesh: Predicted %zu bytes of migration, moved %zu bytes.",
+               m_data.predicted_bytes, m_data.actual_bytes);
+
+    // Clean up.
+    unimesh_free(old_mesh);
+    polymec_free(sources);
+    patch_plan_free(plan);
+  }
   STOP_FUNCTION_TIMER();
 #endif
+  if (migration != NULL)
+    *migration = m_data;
 }
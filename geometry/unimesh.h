@@ -9,6 +9,7 @@
 #define POLYMEC_UNIMESH_H
 
 #include "core/point.h"
+#include "core/partitioning.h"
 
 /// \addtogroup geometry geometry
 ///@{
@@ -213,6 +214,58 @@ bool unimesh_has_patch(unimesh_t* mesh, int i, int j, int k);
 bool unimesh_has_patch_bc(unimesh_t* mesh, int i, int j, int k,
                           unimesh_boundary_t patch_boundary);
 
+/// Returns the numbers of cell values exchanged across patch boundaries
+/// between processes on the same (compute) node and on different nodes,
+/// summed over all processes (see \ref rank_nodes).
+/// \memberof unimesh
+/// \collective Collective on the mesh's communicator.
+halo_volume_t unimesh_halo_volume(unimesh_t* mesh);
+
+/// Enables or disables the measurement of the compute cost of each
+/// locally-stored patch. When enabled, the wall time spent in the compute
+/// regions marked by \ref unimesh_start_patch_timer and
+/// \ref unimesh_stop_patch_timer is charged to their patches, along with
+/// any costs given to \ref unimesh_add_patch_cost. Disabling measurement
+/// discards measured costs.
+/// \memberof unimesh
+void unimesh_measure_patch_costs(unimesh_t* mesh, bool flag);
+
+/// Returns true if the mesh is measuring patch costs, false if not.
+/// \memberof unimesh
+bool unimesh_measures_patch_costs(unimesh_t* mesh);
+
+/// Starts timing a compute region for the locally-stored patch (i, j, k).
+/// Has no effect if the mesh isn't measuring patch costs. Different patches
+/// may be timed at once (by different OpenMP threads, for example), but a
+/// patch's timer must be stopped before it is started again.
+/// \memberof unimesh
+void unimesh_start_patch_timer(unimesh_t* mesh, int i, int j, int k);
+
+/// Stops timing the compute region for the locally-stored patch (i, j, k)
+/// started by \ref unimesh_start_patch_timer, adding the elapsed wall time
+/// to the patch's measured cost. Has no effect if the mesh isn't measuring
+/// patch costs.
+/// \memberof unimesh
+void unimesh_stop_patch_timer(unimesh_t* mesh, int i, int j, int k);
+
+/// Adds the given cost to the measured cost of the locally-stored patch
+/// (i, j, k), for work not timed with patch timers. Has no effect if the
+/// mesh isn't measuring patch costs.
+/// \memberof unimesh
+void unimesh_add_patch_cost(unimesh_t* mesh, int i, int j, int k, real_t cost);
+
+/// Fills costs with the measured costs of all patches in the mesh (zero
+/// for patches that haven't been measured), indexed in the same way as the
+/// weights in \ref repartition_unimesh.
+/// \param [out] costs An array of length npx*npy*npz.
+/// \memberof unimesh
+/// \collective Collective on the mesh's communicator.
+void unimesh_get_patch_costs(unimesh_t* mesh, real_t* costs);
+
+/// Resets the measured costs of all locally-stored patches to zero.
+/// \memberof unimesh
+void unimesh_reset_patch_costs(unimesh_t* mesh);
+
 /// \class unimesh_observer
 /// Objects of this type are notified of changes to a unimesh's state.
 /// \refcounted
@@ -352,17 +405,53 @@ typedef struct unimesh_field_t unimesh_field_t;
 /// are created in their place. Weights can be provided for each patch, and
 /// the partitioning is performed so that the load imbalance does not exceed
 /// the given tolerance.
+/// \param [in] partitioner The algorithm used to partition the patches.
+///                         \ref GRAPH_PARTITIONER builds a graph of all
+///                         patches on one process, while the space-filling
+///                         curve partitioners work in parallel on each
+///                         process's own patches, and scale to large numbers
+///                         of patches and processes without assembling any
+///                         global partition data: only the patches that
+///                         change processes are communicated. The curve
+///                         partitioners balance the load as well as
+///                         contiguous pieces of the curve allow, and log a
+///                         message if the resulting imbalance exceeds
+///                         imbalance_tol.
+/// \param [in] weights If non-NULL, an array containing an integer weight for
+///                     each patch in the mesh, indexed by the patch's global
+///                     index (i*npy*npz + j*npz + k).
 /// \note In addition, each repartitioned field needs to have any boundary
 /// conditions reinstated, since these boundary conditions are not
 /// transmitted between processes.
 /// \relates unimesh
 /// \collective Collective on mesh's communicator.
 void repartition_unimesh(unimesh_t** mesh,
+                         partitioner_t partitioner,
                          int* weights,
                          real_t imbalance_tol,
                          unimesh_field_t** fields,
                          size_t num_fields);
 
+/// Incrementally rebalances the given unimesh with the given patch weights
+/// (indexed as in \ref repartition_unimesh), moving patches only between
+/// neighboring processes, and as few as needed (see \ref rebalance_graph).
+/// This is much cheaper than \ref repartition_unimesh when the load has
+/// shifted only a little, so it can be called often. The mesh and any given
+/// fields are replaced with rebalanced equivalents.
+/// \param [out] migration If non-NULL, stores the predicted and actual numbers
+///                        of bytes of field data moved between processes.
+///                        These are also logged.
+/// \note As with \ref repartition_unimesh, each field's boundary conditions
+/// must be reinstated afterward.
+/// \relates unimesh
+/// \collective Collective on mesh's communicator.
+void rebalance_unimesh(unimesh_t** mesh,
+                       int* weights,
+                       real_t imbalance_tol,
+                       unimesh_field_t** fields,
+                       size_t num_fields,
+                       migration_t* migration);
+
 ///@}
 
 #endif
@@ -38,6 +38,7 @@ struct unimesh_field_t
   void* buffer;
   size_t bytes;
   bool owns_buffer;
+  void* buffer_owner; // refcounted owner of an adopted buffer, or NULL
 
   // Boundary conditions.
   int token; // -1 if not updating, otherwise non-negative.
@@ -106,6 +107,7 @@ unimesh_field_t* unimesh_field_with_buffer(unimesh_t* mesh,
   field->patches = int_ptr_unordered_map_new();
   field->patch_offsets = polymec_malloc(sizeof(size_t) * (num_patches+1));
   field->buffer = NULL;
+  field->buffer_owner = NULL;
 
   // Now populate the patches (with NULL buffers).
   int px, py, pz;
@@ -143,6 +145,8 @@ void unimesh_field_free(unimesh_field_t* field)
   release_ref(field->md);
   if (field->owns_buffer)
     polymec_free(field->buffer);
+  if (field->buffer_owner != NULL)
+    release_ref(field->buffer_owner);
   polymec_free(field);
 }
 
@@ -233,6 +237,11 @@ void unimesh_field_set_buffer(unimesh_field_t* field,
   START_FUNCTION_TIMER();
   if ((field->buffer != NULL) && field->owns_buffer)
     polymec_free(field->buffer);
+  if (field->buffer_owner != NULL)
+  {
+    release_ref(field->buffer_owner);
+    field->buffer_owner = NULL;
+  }
   field->buffer = buffer;
   field->owns_buffer = assume_control;
 
@@ -248,6 +257,16 @@ void unimesh_field_set_buffer(unimesh_field_t* field,
   STOP_FUNCTION_TIMER();
 }
 
+void unimesh_field_adopt_buffer(unimesh_field_t* field,
+                                void* buffer,
+                                void* owner)
+{
+  ASSERT(owner != NULL);
+  retain_ref(owner);
+  unimesh_field_set_buffer(field, buffer, false);
+  field->buffer_owner = owner;
+}
+
 void unimesh_field_set_patch_bc(unimesh_field_t* field,
                                 int i, int j, int k,
                                 unimesh_boundary_t patch_boundary,
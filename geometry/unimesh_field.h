@@ -133,6 +133,14 @@ void unimesh_field_set_buffer(unimesh_field_t* field,
                               void* buffer,
                               bool assume_control);
 
+/// Resets the pointer to the underlying patch data buffer to one owned by the
+/// given refcounted object (a memory mapping, for example). The field retains
+/// a reference to the owner until its buffer is reset or it is destroyed.
+/// \memberof unimesh_field
+void unimesh_field_adopt_buffer(unimesh_field_t* field,
+                                void* buffer,
+                                void* owner);
+
 /// Assigns the given boundary condition to the patch (i, j, k) within this
 /// field. This boundary condition is used to update the patch boundary
 /// data for this field only.
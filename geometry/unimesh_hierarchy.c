@@ -0,0 +1,622 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "core/timer.h"
+#include "core/array.h"
+#include "geometry/unimesh_hierarchy.h"
+#include "geometry/unimesh_patch.h"
+#include "geometry/unimesh_patch_bc.h"
+
+// Patches tagged for refinement are stored under this tag.
+static const char* refine_tag = "refine";
+
+struct unimesh_hierarchy_t
+{
+  // Meshes for each level. Level 0 is the base mesh, which we don't own.
+  int max_levels, num_levels;
+  unimesh_t** levels;
+
+  // Refinement tags for each level.
+  tagger_t** tags;
+
+  // This counter is incremented whenever the hierarchy is regridded, so we
+  // can catch fields that have been left behind.
+  int generation;
+};
+
+struct unimesh_hierarchy_field_t
+{
+  unimesh_hierarchy_t* hierarchy;
+  int nc;
+
+  // Fields on each level.
+  int num_levels;
+  unimesh_field_t** levels;
+
+  // The generation of the hierarchy on which the field is defined.
+  int generation;
+};
+
+static inline int patch_index(unimesh_t* mesh, int i, int j, int k)
+{
+  int npx, npy, npz;
+  unimesh_get_extents(mesh, &npx, &npy, &npz);
+  return npy*npz*i + npz*j + k;
+}
+
+static inline void get_patch_indices(unimesh_t* mesh, int index,
+                                     int* i, int* j, int* k)
+{
+  int npx, npy, npz;
+  unimesh_get_extents(mesh, &npx, &npy, &npz);
+  *i = index/(npy*npz);
+  *j = (index - npy*npz*(*i))/npz;
+  *k = index - npy*npz*(*i) - npz*(*j);
+}
+
+unimesh_hierarchy_t* unimesh_hierarchy_new(unimesh_t* base_mesh,
+                                           int max_levels)
+{
+  ASSERT(unimesh_is_finalized(base_mesh));
+  ASSERT(max_levels >= 1);
+#ifndef NDEBUG
+  int nx, ny, nz;
+  unimesh_get_patch_size(base_mesh, &nx, &ny, &nz);
+  ASSERT((nx % 2) == 0);
+  ASSERT((ny % 2) == 0);
+  ASSERT((nz % 2) == 0);
+#endif
+
+  unimesh_hierarchy_t* hierarchy = polymec_malloc(sizeof(unimesh_hierarchy_t));
+  hierarchy->max_levels = max_levels;
+  hierarchy->num_levels = 1;
+  hierarchy->levels = polymec_calloc(max_levels, sizeof(unimesh_t*));
+  hierarchy->levels[0] = base_mesh;
+  hierarchy->tags = polymec_malloc(sizeof(tagger_t*) * max_levels);
+  for (int l = 0; l < max_levels; ++l)
+    hierarchy->tags[l] = tagger_new();
+  hierarchy->generation = 0;
+  return hierarchy;
+}
+
+void unimesh_hierarchy_free(unimesh_hierarchy_t* hierarchy)
+{
+  for (int l = 0; l < hierarchy->max_levels; ++l)
+    tagger_free(hierarchy->tags[l]);
+  polymec_free(hierarchy->tags);
+  for (int l = 1; l < hierarchy->num_levels; ++l)
+    unimesh_free(hierarchy->levels[l]);
+  polymec_free(hierarchy->levels);
+  polymec_free(hierarchy);
+}
+
+int unimesh_hierarchy_max_levels(unimesh_hierarchy_t* hierarchy)
+{
+  return hierarchy->max_levels;
+}
+
+int unimesh_hierarchy_num_levels(unimesh_hierarchy_t* hierarchy)
+{
+  return hierarchy->num_levels;
+}
+
+unimesh_t* unimesh_hierarchy_level(unimesh_hierarchy_t* hierarchy, int level)
+{
+  ASSERT(level >= 0);
+  ASSERT(level < hierarchy->num_levels);
+  return hierarchy->levels[level];
+}
+
+tagger_t* unimesh_hierarchy_tagger(unimesh_hierarchy_t* hierarchy, int level)
+{
+  ASSERT(level >= 0);
+  ASSERT(level < hierarchy->max_levels);
+  return hierarchy->tags[level];
+}
+
+// Adds the given patch indices to the refinement tag on the given tagger.
+static void add_tags(tagger_t* tagger, int_array_t* indices)
+{
+  static const char* new_tag = "refine_new";
+  int* tag = tagger_create_tag(tagger, new_tag, indices->size);
+  memcpy(tag, indices->data, sizeof(int) * indices->size);
+  if (tagger_has_tag(tagger, refine_tag))
+  {
+    tagger_unite_tag(tagger, refine_tag, new_tag);
+    tagger_delete_tag(tagger, new_tag);
+  }
+  else
+    tagger_rename_tag(tagger, new_tag, refine_tag);
+}
+
+void unimesh_hierarchy_tag_patches(unimesh_hierarchy_t* hierarchy,
+                                   int level,
+                                   bool (*needs_refinement)(void* context,
+                                                            unimesh_t* mesh,
+                                                            int i, int j, int k,
+                                                            bbox_t* bbox),
+                                   void* context)
+{
+  START_FUNCTION_TIMER();
+  unimesh_t* mesh = unimesh_hierarchy_level(hierarchy, level);
+  int_array_t* indices = int_array_new();
+  int pos = 0, i, j, k;
+  bbox_t bbox;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, &bbox))
+  {
+    if (needs_refinement(context, mesh, i, j, k, &bbox))
+      int_array_append(indices, patch_index(mesh, i, j, k));
+  }
+  add_tags(hierarchy->tags[level], indices);
+  int_array_free(indices);
+  STOP_FUNCTION_TIMER();
+}
+
+typedef struct
+{
+  sd_func_t* func;
+  real_t distance;
+} sd_func_tag_t;
+
+static bool patch_is_near_surface(void* context, unimesh_t* mesh,
+                                  int i, int j, int k, bbox_t* bbox)
+{
+  // Since a signed distance function changes no faster than the distance
+  // itself, the patch is within the given distance of the surface only if
+  // its center is within that distance plus half the patch's diagonal.
+  sd_func_tag_t* tag = context;
+  point_t xc = {.x = 0.5 * (bbox->x1 + bbox->x2),
+                .y = 0.5 * (bbox->y1 + bbox->y2),
+                .z = 0.5 * (bbox->z1 + bbox->z2)};
+  real_t Lx = bbox->x2 - bbox->x1,
+         Ly = bbox->y2 - bbox->y1,
+         Lz = bbox->z2 - bbox->z1;
+  real_t r = 0.5 * sqrt(Lx*Lx + Ly*Ly + Lz*Lz);
+  return (ABS(sd_func_value(tag->func, &xc)) <= (r + tag->distance));
+}
+
+void unimesh_hierarchy_tag_sd_func(unimesh_hierarchy_t* hierarchy,
+                                   int level,
+                                   sd_func_t* func,
+                                   real_t distance)
+{
+  ASSERT(distance >= 0.0);
+  sd_func_tag_t tag = {.func = func, .distance = distance};
+  unimesh_hierarchy_tag_patches(hierarchy, level, patch_is_near_surface, &tag);
+}
+
+// Tags the parents of the neighbors of each patch tagged on the given level,
+// so that refined patches are surrounded by patches on the same level.
+static void add_nesting_tags(unimesh_hierarchy_t* hierarchy, int level)
+{
+  size_t num_tags;
+  int* tags = tagger_tag(hierarchy->tags[level], refine_tag, &num_tags);
+  if (tags == NULL)
+    return;
+
+  unimesh_t* mesh = hierarchy->levels[level];
+  unimesh_t* coarse_mesh = hierarchy->levels[level-1];
+  int npx, npy, npz;
+  unimesh_get_extents(mesh, &npx, &npy, &npz);
+  bool periodic[3];
+  unimesh_get_periodicity(mesh, &periodic[0], &periodic[1], &periodic[2]);
+  int np[3] = {npx, npy, npz};
+
+  int_array_t* indices = int_array_new();
+  for (size_t t = 0; t < num_tags; ++t)
+  {
+    int ijk[3];
+    get_patch_indices(mesh, tags[t], &ijk[0], &ijk[1], &ijk[2]);
+    for (int di = -1; di <= 1; ++di)
+    {
+      for (int dj = -1; dj <= 1; ++dj)
+      {
+        for (int dk = -1; dk <= 1; ++dk)
+        {
+          int n[3] = {ijk[0] + di, ijk[1] + dj, ijk[2] + dk};
+          bool in_domain = true;
+          for (int d = 0; d < 3; ++d)
+          {
+            if (periodic[d])
+              n[d] = (n[d] + np[d]) % np[d];
+            else if ((n[d] < 0) || (n[d] >= np[d]))
+              in_domain = false;
+          }
+          if (!in_domain)
+            continue;
+
+          // Patches on the base level can only be refined where they're
+          // stored, so we can't guarantee nesting across process boundaries.
+          int I = n[0]/2, J = n[1]/2, K = n[2]/2;
+          if ((level > 1) || unimesh_has_patch(coarse_mesh, I, J, K))
+            int_array_append(indices, patch_index(coarse_mesh, I, J, K));
+        }
+      }
+    }
+  }
+  add_tags(hierarchy->tags[level-1], indices);
+  int_array_free(indices);
+}
+
+// Creates a mesh that refines the tagged patches in the given mesh, or
+// returns NULL if no locally-stored patches are tagged.
+static unimesh_t* refined_mesh(unimesh_t* coarse_mesh, tagger_t* tags)
+{
+  size_t num_tags;
+  int* tagged = tagger_tag(tags, refine_tag, &num_tags);
+  if (tagged == NULL)
+    return NULL;
+
+  int npx, npy, npz, nx, ny, nz;
+  unimesh_get_extents(coarse_mesh, &npx, &npy, &npz);
+  unimesh_get_patch_size(coarse_mesh, &nx, &ny, &nz);
+  bool periodic_in_x, periodic_in_y, periodic_in_z;
+  unimesh_get_periodicity(coarse_mesh, &periodic_in_x, &periodic_in_y, &periodic_in_z);
+
+  unimesh_t* fine_mesh = NULL;
+  for (size_t t = 0; t < num_tags; ++t)
+  {
+    int i, j, k;
+    get_patch_indices(coarse_mesh, tagged[t], &i, &j, &k);
+    if (!unimesh_has_patch(coarse_mesh, i, j, k))
+      continue;
+    if (fine_mesh == NULL)
+    {
+      fine_mesh = create_empty_unimesh(MPI_COMM_SELF, unimesh_bbox(coarse_mesh),
+                                       2*npx, 2*npy, 2*npz, nx, ny, nz,
+                                       periodic_in_x, periodic_in_y, periodic_in_z);
+    }
+    for (int a = 0; a < 2; ++a)
+      for (int b = 0; b < 2; ++b)
+        for (int c = 0; c < 2; ++c)
+          unimesh_insert_patch(fine_mesh, 2*i+a, 2*j+b, 2*k+c);
+  }
+  if (fine_mesh != NULL)
+    unimesh_finalize(fine_mesh);
+  return fine_mesh;
+}
+
+static inline real_t minmod(real_t a, real_t b)
+{
+  if (a*b <= 0.0)
+    return 0.0;
+  else
+    return (ABS(a) < ABS(b)) ? a : b;
+}
+
+// Returns true if the cell (i, j, k) in a patch holds valid data after its
+// ghost cells have been updated. Cells in more than one ghost layer ("edge"
+// and "corner" ghost cells) are not updated.
+static inline bool has_valid_data(unimesh_patch_t* patch, int i, int j, int k)
+{
+  if ((i < 0) || (i > patch->nx+1) ||
+      (j < 0) || (j > patch->ny+1) ||
+      (k < 0) || (k > patch->nz+1))
+    return false;
+  int num_ghost_indices = ((i == 0) || (i == patch->nx+1)) +
+                          ((j == 0) || (j == patch->ny+1)) +
+                          ((k == 0) || (k == patch->nz+1));
+  return (num_ghost_indices <= 1);
+}
+
+// Returns the limited slope of the given component of the coarse data at
+// (i, j, k) in the direction (di, dj, dk), falling back on a one-sided
+// difference where only one neighbor holds valid data.
+static real_t limited_slope(unimesh_patch_t* coarse_patch,
+                            int i, int j, int k, int di, int dj, int dk,
+                            int c)
+{
+  DECLARE_UNIMESH_CELL_ARRAY(C, coarse_patch);
+  bool has_minus = has_valid_data(coarse_patch, i-di, j-dj, k-dk),
+       has_plus  = has_valid_data(coarse_patch, i+di, j+dj, k+dk);
+  if (has_minus && has_plus)
+    return minmod(C[i+di][j+dj][k+dk][c] - C[i][j][k][c],
+                  C[i][j][k][c] - C[i-di][j-dj][k-dk][c]);
+  else if (has_plus)
+    return C[i+di][j+dj][k+dk][c] - C[i][j][k][c];
+  else if (has_minus)
+    return C[i][j][k][c] - C[i-di][j-dj][k-dk][c];
+  else
+    return 0.0;
+}
+
+// Interpolates coarse data to the cell (fi, fj, fk) (which may be a ghost
+// cell) in the fine patch occupying the octant (a, b, c) of the coarse
+// patch, storing the result in fine_patch.
+static void interpolate_cell(unimesh_patch_t* coarse_patch,
+                             int a, int b, int c,
+                             int fi, int fj, int fk,
+                             unimesh_patch_t* fine_patch)
+{
+  // Find the coarse cell containing the fine cell, and the offset of the
+  // fine cell's center from that of the coarse cell, in units of coarse
+  // cell spacings.
+  int nx = coarse_patch->nx, ny = coarse_patch->ny, nz = coarse_patch->nz;
+  int ci = a*nx/2 + (fi+1)/2,
+      cj = b*ny/2 + (fj+1)/2,
+      ck = c*nz/2 + (fk+1)/2;
+  real_t ox = ((fi+1) % 2) ? 0.25 : -0.25,
+         oy = ((fj+1) % 2) ? 0.25 : -0.25,
+         oz = ((fk+1) % 2) ? 0.25 : -0.25;
+  ASSERT(has_valid_data(coarse_patch, ci, cj, ck));
+
+  DECLARE_UNIMESH_CELL_ARRAY(C, coarse_patch);
+  DECLARE_UNIMESH_CELL_ARRAY(F, fine_patch);
+  for (int m = 0; m < coarse_patch->nc; ++m)
+  {
+    F[fi][fj][fk][m] = C[ci][cj][ck][m] +
+      ox * limited_slope(coarse_patch, ci, cj, ck, 1, 0, 0, m) +
+      oy * limited_slope(coarse_patch, ci, cj, ck, 0, 1, 0, m) +
+      oz * limited_slope(coarse_patch, ci, cj, ck, 0, 0, 1, m);
+  }
+}
+
+//------------------------------------------------------------------------
+//                    Coarse-fine boundary condition
+//------------------------------------------------------------------------
+// This patch BC fills the ghost cells of a fine patch by interpolating
+// data from the patch it refines on the next coarser level, whose ghost
+// cells must already be updated.
+//------------------------------------------------------------------------
+
+typedef struct
+{
+  unimesh_field_t* coarse_field;
+} coarse_fine_bc_t;
+
+static void coarse_fine_bc_update(void* context, unimesh_t* mesh,
+                                  int i, int j, int k, real_t t,
+                                  unimesh_boundary_t boundary,
+                                  field_metadata_t* md,
+                                  unimesh_patch_t* patch)
+{
+  ASSERT(patch->centering == UNIMESH_CELL);
+  coarse_fine_bc_t* bc = context;
+  unimesh_patch_t* coarse_patch = unimesh_field_patch(bc->coarse_field,
+                                                      i/2, j/2, k/2);
+  ASSERT(coarse_patch != NULL);
+  ASSERT(coarse_patch->nc == patch->nc);
+  int a = i % 2, b = j % 2, c = k % 2;
+
+  // Find the range of ghost cells to fill.
+  int i1 = 1, i2 = patch->nx, j1 = 1, j2 = patch->ny, k1 = 1, k2 = patch->nz;
+  if (boundary == UNIMESH_X1_BOUNDARY)
+    i1 = i2 = 0;
+  else if (boundary == UNIMESH_X2_BOUNDARY)
+    i1 = i2 = patch->nx+1;
+  else if (boundary == UNIMESH_Y1_BOUNDARY)
+    j1 = j2 = 0;
+  else if (boundary == UNIMESH_Y2_BOUNDARY)
+    j1 = j2 = patch->ny+1;
+  else if (boundary == UNIMESH_Z1_BOUNDARY)
+    k1 = k2 = 0;
+  else
+    k1 = k2 = patch->nz+1;
+
+  for (int fi = i1; fi <= i2; ++fi)
+    for (int fj = j1; fj <= j2; ++fj)
+      for (int fk = k1; fk <= k2; ++fk)
+        interpolate_cell(coarse_patch, a, b, c, fi, fj, fk, patch);
+}
+
+static unimesh_patch_bc_t* coarse_fine_bc_new(unimesh_t* fine_mesh,
+                                              unimesh_field_t* coarse_field)
+{
+  coarse_fine_bc_t* bc = polymec_malloc(sizeof(coarse_fine_bc_t));
+  bc->coarse_field = coarse_field;
+  unimesh_patch_bc_easy_vtable vtable = {.start_update = coarse_fine_bc_update,
+                                         .dtor = polymec_free};
+  return unimesh_patch_bc_new_easy("coarse-fine BC", bc, vtable, fine_mesh);
+}
+
+// Creates a field on the given refined mesh whose ghost cells are filled
+// from the given coarse field wherever the mesh doesn't fill them.
+static unimesh_field_t* refined_field_new(unimesh_t* fine_mesh,
+                                          unimesh_field_t* coarse_field)
+{
+  int nc = unimesh_field_num_components(coarse_field);
+  unimesh_field_t* field = unimesh_field_new(fine_mesh, UNIMESH_CELL, nc);
+  unimesh_patch_bc_t* bc = coarse_fine_bc_new(fine_mesh, coarse_field);
+  int pos = 0, i, j, k;
+  while (unimesh_next_patch(fine_mesh, &pos, &i, &j, &k, NULL))
+  {
+    for (int b = 0; b < 6; ++b)
+    {
+      unimesh_boundary_t boundary = (unimesh_boundary_t)b;
+      if (!unimesh_has_patch_bc(fine_mesh, i, j, k, boundary))
+        unimesh_field_set_patch_bc(field, i, j, k, boundary, bc);
+    }
+  }
+  release_ref(bc);
+  return field;
+}
+
+void unimesh_hierarchy_regrid(unimesh_hierarchy_t* hierarchy,
+                              real_t t,
+                              unimesh_hierarchy_field_t** fields,
+                              size_t num_fields)
+{
+  START_FUNCTION_TIMER();
+
+  // Make sure that refined patches will be properly nested.
+  for (int l = MIN(hierarchy->num_levels, hierarchy->max_levels-1) - 1; l > 0; --l)
+    add_nesting_tags(hierarchy, l);
+
+  // Build the new levels from the coarsest to the finest.
+  int max_levels = hierarchy->max_levels;
+  unimesh_t* levels[max_levels];
+  levels[0] = hierarchy->levels[0];
+  int num_levels = 1;
+  while (num_levels < max_levels)
+  {
+    unimesh_t* fine_mesh = refined_mesh(levels[num_levels-1],
+                                        hierarchy->tags[num_levels-1]);
+    if (fine_mesh == NULL)
+      break;
+    levels[num_levels] = fine_mesh;
+    ++num_levels;
+  }
+
+  // Transfer the fields to the new levels.
+  for (size_t f = 0; f < num_fields; ++f)
+  {
+    unimesh_hierarchy_field_t* field = fields[f];
+    ASSERT(field->hierarchy == hierarchy);
+    ASSERT(field->generation == hierarchy->generation);
+
+    // Update the ghost cells on the base level, which we interpolate on
+    // every process, since this is a collective operation.
+    unimesh_field_update_patch_boundaries(field->levels[0], t);
+
+    unimesh_field_t** new_levels = polymec_calloc(max_levels, sizeof(unimesh_field_t*));
+    new_levels[0] = field->levels[0];
+    for (int l = 1; l < num_levels; ++l)
+    {
+      unimesh_field_t* coarse_field = new_levels[l-1];
+      if (l > 1)
+        unimesh_field_update_patch_boundaries(coarse_field, t);
+      new_levels[l] = refined_field_new(levels[l], coarse_field);
+
+      // Copy data from patches that were already refined, and interpolate
+      // data for new ones.
+      unimesh_field_t* old_field = (l < field->num_levels) ? field->levels[l] : NULL;
+      int pos = 0, i, j, k;
+      unimesh_patch_t* patch;
+      while (unimesh_field_next_patch(new_levels[l], &pos, &i, &j, &k, &patch, NULL))
+      {
+        unimesh_patch_t* old_patch = (old_field != NULL) ? unimesh_field_patch(old_field, i, j, k)
+                                                         : NULL;
+        if (old_patch != NULL)
+          unimesh_patch_copy(old_patch, patch);
+        else
+        {
+          unimesh_patch_t* coarse_patch = unimesh_field_patch(coarse_field, i/2, j/2, k/2);
+          for (int fi = 1; fi <= patch->nx; ++fi)
+            for (int fj = 1; fj <= patch->ny; ++fj)
+              for (int fk = 1; fk <= patch->nz; ++fk)
+                interpolate_cell(coarse_patch, i%2, j%2, k%2, fi, fj, fk, patch);
+        }
+      }
+    }
+
+    // Replace the old fields.
+    for (int l = 1; l < field->num_levels; ++l)
+      unimesh_field_free(field->levels[l]);
+    polymec_free(field->levels);
+    field->levels = new_levels;
+    field->num_levels = num_levels;
+    field->generation = hierarchy->generation + 1;
+  }
+
+  // Replace the old levels and clear the tags.
+  for (int l = 1; l < hierarchy->num_levels; ++l)
+    unimesh_free(hierarchy->levels[l]);
+  for (int l = 1; l < num_levels; ++l)
+    hierarchy->levels[l] = levels[l];
+  for (int l = num_levels; l < max_levels; ++l)
+    hierarchy->levels[l] = NULL;
+  hierarchy->num_levels = num_levels;
+  for (int l = 0; l < max_levels; ++l)
+  {
+    if (tagger_has_tag(hierarchy->tags[l], refine_tag))
+      tagger_delete_tag(hierarchy->tags[l], refine_tag);
+  }
+  ++hierarchy->generation;
+
+  log_debug("unimesh_hierarchy: Regridded to %d levels.", num_levels);
+  STOP_FUNCTION_TIMER();
+}
+
+unimesh_hierarchy_field_t* unimesh_hierarchy_field_new(unimesh_hierarchy_t* hierarchy,
+                                                       int num_components)
+{
+  ASSERT(num_components > 0);
+  unimesh_hierarchy_field_t* field = polymec_malloc(sizeof(unimesh_hierarchy_field_t));
+  field->hierarchy = hierarchy;
+  field->nc = num_components;
+  field->num_levels = hierarchy->num_levels;
+  field->levels = polymec_calloc(hierarchy->max_levels, sizeof(unimesh_field_t*));
+  field->levels[0] = unimesh_field_new(hierarchy->levels[0], UNIMESH_CELL, num_components);
+  for (int l = 1; l < hierarchy->num_levels; ++l)
+    field->levels[l] = refined_field_new(hierarchy->levels[l], field->levels[l-1]);
+  field->generation = hierarchy->generation;
+  return field;
+}
+
+void unimesh_hierarchy_field_free(unimesh_hierarchy_field_t* field)
+{
+  for (int l = field->num_levels-1; l >= 0; --l)
+    unimesh_field_free(field->levels[l]);
+  polymec_free(field->levels);
+  polymec_free(field);
+}
+
+int unimesh_hierarchy_field_num_components(unimesh_hierarchy_field_t* field)
+{
+  return field->nc;
+}
+
+unimesh_field_t* unimesh_hierarchy_field_level(unimesh_hierarchy_field_t* field,
+                                               int level)
+{
+  ASSERT(field->generation == field->hierarchy->generation);
+  ASSERT(level >= 0);
+  ASSERT(level < field->num_levels);
+  return field->levels[level];
+}
+
+void unimesh_hierarchy_field_update_boundaries(unimesh_hierarchy_field_t* field,
+                                               real_t t)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(field->generation == field->hierarchy->generation);
+  for (int l = 0; l < field->num_levels; ++l)
+    unimesh_field_update_patch_boundaries(field->levels[l], t);
+  STOP_FUNCTION_TIMER();
+}
+
+void unimesh_hierarchy_field_restrict(unimesh_hierarchy_field_t* field)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(field->generation == field->hierarchy->generation);
+  for (int l = field->num_levels-1; l > 0; --l)
+  {
+    unimesh_field_t* coarse_field = field->levels[l-1];
+    int pos = 0, i, j, k;
+    unimesh_patch_t* patch;
+    while (unimesh_field_next_patch(field->levels[l], &pos, &i, &j, &k, &patch, NULL))
+    {
+      // Average the fine cells over each coarse cell in the octant
+      // (a, b, c) of the coarse patch.
+      unimesh_patch_t* coarse_patch = unimesh_field_patch(coarse_field, i/2, j/2, k/2);
+      ASSERT(coarse_patch != NULL);
+      int a = i % 2, b = j % 2, c = k % 2;
+      int nx = patch->nx/2, ny = patch->ny/2, nz = patch->nz/2;
+      DECLARE_UNIMESH_CELL_ARRAY(C, coarse_patch);
+      DECLARE_UNIMESH_CELL_ARRAY(F, patch);
+      for (int ci = 1; ci <= nx; ++ci)
+      {
+        for (int cj = 1; cj <= ny; ++cj)
+        {
+          for (int ck = 1; ck <= nz; ++ck)
+          {
+            int fi = 2*ci-1, fj = 2*cj-1, fk = 2*ck-1;
+            for (int m = 0; m < field->nc; ++m)
+            {
+              C[a*nx+ci][b*ny+cj][c*nz+ck][m] = 0.125 *
+                (F[fi][fj][fk][m]     + F[fi+1][fj][fk][m] +
+                 F[fi][fj+1][fk][m]   + F[fi+1][fj+1][fk][m] +
+                 F[fi][fj][fk+1][m]   + F[fi+1][fj][fk+1][m] +
+                 F[fi][fj+1][fk+1][m] + F[fi+1][fj+1][fk+1][m]);
+            }
+          }
+        }
+      }
+    }
+  }
+  STOP_FUNCTION_TIMER();
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef POLYMEC_UNIMESH_HIERARCHY_H
+#define POLYMEC_UNIMESH_HIERARCHY_H
+
+#include "geometry/sd_func.h"
+#include "geometry/tagger.h"
+#include "geometry/unimesh_field.h"
+
+/// \addtogroup geometry geometry
+///@{
+
+/// \class unimesh_hierarchy
+/// A unimesh hierarchy is a set of nested unimeshes ("levels") that refine
+/// a base unimesh adaptively, in the block-structured style of Berger and
+/// Colella. Level 0 is the base mesh. Level l+1 has twice the resolution of
+/// level l in each direction, and each of its patches covers one octant of
+/// a level-l patch, so refining a patch replaces it with 8 patches of the
+/// same size. Patches are refined when they are tagged, and the levels are
+/// rebuilt from these tags by regridding. Refined levels are stored on the
+/// process that stores the patches they refine.
+typedef struct unimesh_hierarchy_t unimesh_hierarchy_t;
+
+/// \class unimesh_hierarchy_field
+/// A unimesh hierarchy field stores cell-centered data on every level of a
+/// unimesh hierarchy. Ghost cells on a refined patch that don't border
+/// another patch on the same level are filled by interpolating data from
+/// the coarser level.
+typedef struct unimesh_hierarchy_field_t unimesh_hierarchy_field_t;
+
+/// Creates a hierarchy whose coarsest level is the given unimesh.
+/// \param [in] base_mesh The (finalized) base mesh for the hierarchy. Each
+///                       of its patches must have an even number of cells
+///                       in each direction. This mesh is not consumed, and
+///                       must outlive the hierarchy.
+/// \param [in] max_levels The maximum number of levels in the hierarchy,
+///                        including the base mesh.
+/// \memberof unimesh_hierarchy
+unimesh_hierarchy_t* unimesh_hierarchy_new(unimesh_t* base_mesh,
+                                           int max_levels);
+
+/// Destroys the given hierarchy. Any fields defined on the hierarchy must
+/// be destroyed first.
+/// \memberof unimesh_hierarchy
+void unimesh_hierarchy_free(unimesh_hierarchy_t* hierarchy);
+
+/// Returns the maximum number of levels in the hierarchy.
+/// \memberof unimesh_hierarchy
+int unimesh_hierarchy_max_levels(unimesh_hierarchy_t* hierarchy);
+
+/// Returns the number of levels currently in the hierarchy on this process.
+/// \memberof unimesh_hierarchy
+int unimesh_hierarchy_num_levels(unimesh_hierarchy_t* hierarchy);
+
+/// Returns the unimesh for the given level in the hierarchy. Level 0 is the
+/// base mesh. Refined levels are defined on MPI_COMM_SELF.
+/// \memberof unimesh_hierarchy
+unimesh_t* unimesh_hierarchy_level(unimesh_hierarchy_t* hierarchy, int level);
+
+/// Returns the tagger that stores the patches tagged for refinement on the
+/// given level. Tagged patches are stored under the "refine" tag, identified
+/// by their indices npy*npz*i + npz*j + k, where npy and npz are the extents
+/// of the level's mesh. Tags can be added directly, or with
+/// \ref unimesh_hierarchy_tag_patches and \ref unimesh_hierarchy_tag_sd_func.
+/// \memberof unimesh_hierarchy
+tagger_t* unimesh_hierarchy_tagger(unimesh_hierarchy_t* hierarchy, int level);
+
+/// Tags for refinement every locally-stored patch on the given level for
+/// which the given function returns true.
+/// \param [in] needs_refinement A function that returns true if the patch
+///                              (i, j, k) on the given mesh, occupying the
+///                              given bounding box, should be refined.
+/// \param [in] context A context pointer passed to needs_refinement.
+/// \memberof unimesh_hierarchy
+void unimesh_hierarchy_tag_patches(unimesh_hierarchy_t* hierarchy,
+                                   int level,
+                                   bool (*needs_refinement)(void* context,
+                                                            unimesh_t* mesh,
+                                                            int i, int j, int k,
+                                                            bbox_t* bbox),
+                                   void* context);
+
+/// Tags for refinement every locally-stored patch on the given level that
+/// lies within the given distance of the zero level set of the given signed
+/// distance function.
+/// \memberof unimesh_hierarchy
+void unimesh_hierarchy_tag_sd_func(unimesh_hierarchy_t* hierarchy,
+                                   int level,
+                                   sd_func_t* func,
+                                   real_t distance);
+
+/// Rebuilds the refined levels of the hierarchy from the patches tagged on
+/// each level, and transfers the data in the given fields to the new levels.
+/// Before rebuilding, tags are added on coarser levels so that every patch
+/// neighboring a refined patch exists (wherever the coarser patches are
+/// stored locally), which keeps the levels properly nested. Data on patches
+/// that exist before and after regridding is copied, and data on new patches
+/// is interpolated from the next coarser level with limited linear
+/// reconstructions that conserve the coarse data. All tags are cleared
+/// afterward. Fields that aren't passed to this function are invalidated.
+/// \param [in] t The time at which coarse ghost cells are updated for
+///               interpolation.
+/// \param [inout] fields An array of fields defined on the hierarchy.
+/// \param [in] num_fields The number of fields in the array.
+/// \memberof unimesh_hierarchy
+/// \collective Collective on the base mesh's communicator.
+void unimesh_hierarchy_regrid(unimesh_hierarchy_t* hierarchy,
+                              real_t t,
+                              unimesh_hierarchy_field_t** fields,
+                              size_t num_fields);
+
+/// Creates a cell-centered field with the given number of components on
+/// every level of the given hierarchy. Like \ref unimesh_field_new, this
+/// doesn't initialize the field's data.
+/// \memberof unimesh_hierarchy_field
+unimesh_hierarchy_field_t* unimesh_hierarchy_field_new(unimesh_hierarchy_t* hierarchy,
+                                                       int num_components);
+
+/// Destroys the given hierarchy field.
+/// \memberof unimesh_hierarchy_field
+void unimesh_hierarchy_field_free(unimesh_hierarchy_field_t* field);
+
+/// Returns the number of components in the given hierarchy field.
+/// \memberof unimesh_hierarchy_field
+int unimesh_hierarchy_field_num_components(unimesh_hierarchy_field_t* field);
+
+/// Returns the unimesh field storing data for the given level. Boundary
+/// conditions for the hierarchy's physical boundaries are set on the level 0
+/// field. The field for a refined level is replaced when the hierarchy is
+/// regridded.
+/// \memberof unimesh_hierarchy_field
+unimesh_field_t* unimesh_hierarchy_field_level(unimesh_hierarchy_field_t* field,
+                                               int level);
+
+/// Updates the ghost cells on every level of the given field at time t,
+/// from the coarsest level to the finest.
+/// \memberof unimesh_hierarchy_field
+/// \collective Collective on the base mesh's communicator.
+void unimesh_hierarchy_field_update_boundaries(unimesh_hierarchy_field_t* field,
+                                               real_t t);
+
+/// Replaces the data in each cell covered by a finer level with the average
+/// of the finer cells that cover it, from the finest level to the coarsest,
+/// so that the coarse data conserves the fine data.
+/// \memberof unimesh_hierarchy_field
+void unimesh_hierarchy_field_restrict(unimesh_hierarchy_field_t* field);
+
+///@}
+
+#endif
+
@@ -0,0 +1,483 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "core/timer.h"
+#include "core/array.h"
+#include "core/unordered_set.h"
+#include "geometry/unimesh_stage_executor.h"
+
+#if POLYMEC_HAVE_OPENMP
+#include <omp.h>
+#endif
+
+struct unimesh_stage_executor_t
+{
+  unimesh_t* mesh;
+  int nc, num_stages;
+  void* context;
+  unimesh_stage_kernel* kernels;
+
+  // Patch dimensions.
+  int nx, ny, nz;
+
+  // Temporally-blocked patches, stored as (i, j, k) triples, and storage
+  // for their updated values.
+  int num_blocked;
+  int* blocked;
+  unimesh_patch_t** results;
+
+  // Storage for the values of blocked patches after each stage but the
+  // last, used to update the ghost cells of neighboring unblocked patches.
+  // stage_values[(num_stages-1)*b + s] is NULL for blocked patches b with
+  // no unblocked neighbors.
+  unimesh_patch_t** stage_values;
+
+  // Patches updated one stage at a time, stored as (i, j, k) triples.
+  int num_unblocked;
+  int* unblocked;
+
+  // True if any process has unblocked patches, in which case ghost cells
+  // are updated between stages.
+  bool updates_ghosts;
+
+  // Working storage for each thread: two blocks for temporal blocking and
+  // one patch for stage-by-stage updates.
+  int num_threads;
+  unimesh_patch_t** blocks;
+  unimesh_patch_t** work;
+};
+
+// Finds the neighbor of patch (i, j, k) offset by (di, dj, dk), wrapping
+// around periodic boundaries. Returns false if the neighbor is outside the
+// mesh.
+static bool find_neighbor(unimesh_t* mesh, int i, int j, int k,
+                          int di, int dj, int dk,
+                          int* ni, int* nj, int* nk)
+{
+  int np[3], n[3] = {i + di, j + dj, k + dk};
+  unimesh_get_extents(mesh, &np[0], &np[1], &np[2]);
+  bool periodic[3];
+  unimesh_get_periodicity(mesh, &periodic[0], &periodic[1], &periodic[2]);
+  for (int d = 0; d < 3; ++d)
+  {
+    if (periodic[d])
+      n[d] = (n[d] + np[d]) % np[d];
+    else if ((n[d] < 0) || (n[d] >= np[d]))
+      return false;
+  }
+  *ni = n[0];
+  *nj = n[1];
+  *nk = n[2];
+  return true;
+}
+
+static bool has_local_neighbors(unimesh_t* mesh, int i, int j, int k)
+{
+  for (int di = -1; di <= 1; ++di)
+  {
+    for (int dj = -1; dj <= 1; ++dj)
+    {
+      for (int dk = -1; dk <= 1; ++dk)
+      {
+        int ni, nj, nk;
+        if (!find_neighbor(mesh, i, j, k, di, dj, dk, &ni, &nj, &nk) ||
+            !unimesh_has_patch(mesh, ni, nj, nk))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+static inline int patch_index(unimesh_t* mesh, int i, int j, int k)
+{
+  int npx, npy, npz;
+  unimesh_get_extents(mesh, &npx, &npy, &npz);
+  return npy*npz*i + npz*j + k;
+}
+
+// Returns true if the given (blocked) patch has a face neighbor that isn't
+// in the given set of blocked patches.
+static bool borders_unblocked_patch(unimesh_t* mesh, int i, int j, int k,
+                                    int_unordered_set_t* blocked)
+{
+  static const int offsets[6][3] = {{-1, 0, 0}, {1, 0, 0},
+                                    {0, -1, 0}, {0, 1, 0},
+                                    {0, 0, -1}, {0, 0, 1}};
+  for (int n = 0; n < 6; ++n)
+  {
+    int ni, nj, nk;
+    find_neighbor(mesh, i, j, k, offsets[n][0], offsets[n][1], offsets[n][2],
+                  &ni, &nj, &nk);
+    if (!int_unordered_set_contains(blocked, patch_index(mesh, ni, nj, nk)))
+      return true;
+  }
+  return false;
+}
+
+unimesh_stage_executor_t* unimesh_stage_executor_new(unimesh_t* mesh,
+                                                     int num_components,
+                                                     int num_stages,
+                                                     void* context,
+                                                     unimesh_stage_kernel* kernels)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(unimesh_is_finalized(mesh));
+  ASSERT(num_components > 0);
+  ASSERT(num_stages > 0);
+  ASSERT(kernels != NULL);
+
+  int nx, ny, nz;
+  unimesh_get_patch_size(mesh, &nx, &ny, &nz);
+  if ((nx < num_stages) || (ny < num_stages) || (nz < num_stages))
+  {
+    polymec_error("unimesh_stage_executor_new: patches (%d x %d x %d cells) "
+                  "must have at least as many cells in each direction as "
+                  "there are stages (%d).", nx, ny, nz, num_stages);
+  }
+
+  unimesh_stage_executor_t* executor = polymec_malloc(sizeof(unimesh_stage_executor_t));
+  executor->mesh = mesh;
+  executor->nc = num_components;
+  executor->num_stages = num_stages;
+  executor->context = context;
+  executor->kernels = polymec_malloc(sizeof(unimesh_stage_kernel) * num_stages);
+  memcpy(executor->kernels, kernels, sizeof(unimesh_stage_kernel) * num_stages);
+  executor->nx = nx;
+  executor->ny = ny;
+  executor->nz = nz;
+
+  // Sort the patches into those we can block and those we can't.
+  int_array_t* blocked = int_array_new();
+  int_array_t* unblocked = int_array_new();
+  int_unordered_set_t* blocked_set = int_unordered_set_new();
+  int pos = 0, i, j, k;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, NULL))
+  {
+    if (has_local_neighbors(mesh, i, j, k))
+    {
+      int_array_append(blocked, i);
+      int_array_append(blocked, j);
+      int_array_append(blocked, k);
+      int_unordered_set_insert(blocked_set, patch_index(mesh, i, j, k));
+    }
+    else
+    {
+      int_array_append(unblocked, i);
+      int_array_append(unblocked, j);
+      int_array_append(unblocked, k);
+    }
+  }
+  executor->num_blocked = (int)(blocked->size/3);
+  executor->blocked = blocked->data;
+  int_array_release_data_and_free(blocked);
+  executor->num_unblocked = (int)(unblocked->size/3);
+  executor->unblocked = unblocked->data;
+  int_array_release_data_and_free(unblocked);
+
+  executor->results = polymec_malloc(sizeof(unimesh_patch_t*) * executor->num_blocked);
+  for (int b = 0; b < executor->num_blocked; ++b)
+    executor->results[b] = unimesh_patch_new(UNIMESH_CELL, nx, ny, nz, num_components);
+
+  int num_unblocked = executor->num_unblocked;
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(&executor->num_unblocked, &num_unblocked, 1, MPI_INT,
+                MPI_SUM, unimesh_comm(mesh));
+#endif
+  executor->updates_ghosts = (num_unblocked > 0);
+  int num_saved_stages = num_stages - 1;
+  executor->stage_values = NULL;
+  if (executor->updates_ghosts && (num_saved_stages > 0))
+  {
+    executor->stage_values = polymec_calloc(num_saved_stages * executor->num_blocked,
+                                            sizeof(unimesh_patch_t*));
+    for (int b = 0; b < executor->num_blocked; ++b)
+    {
+      int* ijk = &executor->blocked[3*b];
+      if (borders_unblocked_patch(mesh, ijk[0], ijk[1], ijk[2], blocked_set))
+      {
+        for (int s = 0; s < num_saved_stages; ++s)
+        {
+          executor->stage_values[num_saved_stages*b + s] =
+            unimesh_patch_new(UNIMESH_CELL, nx, ny, nz, num_components);
+        }
+      }
+    }
+  }
+  int_unordered_set_free(blocked_set);
+
+  // Set up working storage. Each block holds a patch and as many layers of
+  // its neighbors' cells as there are stages.
+#if POLYMEC_HAVE_OPENMP
+  executor->num_threads = omp_get_max_threads();
+#else
+  executor->num_threads = 1;
+#endif
+  executor->blocks = polymec_malloc(sizeof(unimesh_patch_t*) * 2 * executor->num_threads);
+  executor->work = polymec_malloc(sizeof(unimesh_patch_t*) * executor->num_threads);
+  int h = num_stages - 1;
+  for (int t = 0; t < executor->num_threads; ++t)
+  {
+    for (int b = 0; b < 2; ++b)
+    {
+      executor->blocks[2*t+b] = unimesh_patch_new(UNIMESH_CELL, nx+2*h, ny+2*h,
+                                                  nz+2*h, num_components);
+    }
+    executor->work[t] = unimesh_patch_new(UNIMESH_CELL, nx, ny, nz, num_components);
+  }
+
+  log_debug("unimesh_stage_executor: %d of %d patches are temporally blocked "
+            "over %d stages.", executor->num_blocked,
+            executor->num_blocked + executor->num_unblocked, num_stages);
+  STOP_FUNCTION_TIMER();
+  return executor;
+}
+
+void unimesh_stage_executor_free(unimesh_stage_executor_t* executor)
+{
+  for (int t = 0; t < executor->num_threads; ++t)
+  {
+    unimesh_patch_free(executor->blocks[2*t]);
+    unimesh_patch_free(executor->blocks[2*t+1]);
+    unimesh_patch_free(executor->work[t]);
+  }
+  polymec_free(executor->work);
+  polymec_free(executor->blocks);
+  if (executor->stage_values != NULL)
+  {
+    int num_saved_stages = executor->num_stages - 1;
+    for (int p = 0; p < num_saved_stages * executor->num_blocked; ++p)
+    {
+      if (executor->stage_values[p] != NULL)
+        unimesh_patch_free(executor->stage_values[p]);
+    }
+    polymec_free(executor->stage_values);
+  }
+  for (int b = 0; b < executor->num_blocked; ++b)
+    unimesh_patch_free(executor->results[b]);
+  polymec_free(executor->results);
+  polymec_free(executor->unblocked);
+  polymec_free(executor->blocked);
+  polymec_free(executor->kernels);
+  polymec_free(executor);
+}
+
+int unimesh_stage_executor_num_blocked_patches(unimesh_stage_executor_t* executor)
+{
+  return executor->num_blocked;
+}
+
+// Sets the given box to the cells of a block that belong to its patch.
+static void get_patch_box_in_block(unimesh_stage_executor_t* executor,
+                                   unimesh_patch_box_t* box)
+{
+  int h = executor->num_stages;
+  box->i1 = h;
+  box->i2 = executor->nx + h;
+  box->j1 = h;
+  box->j2 = executor->ny + h;
+  box->k1 = h;
+  box->k2 = executor->nz + h;
+}
+
+// Copies the cells in the source box of one patch to the destination box
+// of another. Cells are copied a row at a time, since the boxes we copy are
+// too small for the general-purpose unimesh_patch_copy_box to be efficient.
+static void copy_box(unimesh_patch_t* src,
+                     unimesh_patch_box_t* src_box,
+                     unimesh_patch_box_t* dest_box,
+                     unimesh_patch_t* dest)
+{
+  DECLARE_UNIMESH_CELL_ARRAY(s, src);
+  DECLARE_UNIMESH_CELL_ARRAY(d, dest);
+  int ni = src_box->i2 - src_box->i1,
+      nj = src_box->j2 - src_box->j1;
+  size_t row_size = sizeof(real_t) * (src_box->k2 - src_box->k1) * src->nc;
+  for (int i = 0; i < ni; ++i)
+  {
+    for (int j = 0; j < nj; ++j)
+    {
+      memcpy(&d[dest_box->i1+i][dest_box->j1+j][dest_box->k1][0],
+             &s[src_box->i1+i][src_box->j1+j][src_box->k1][0], row_size);
+    }
+  }
+}
+
+// Copies the data for patch (i, j, k) and num_stages layers of its
+// neighbors' cells into the given block.
+static void gather_block(unimesh_stage_executor_t* executor,
+                         unimesh_field_t* field,
+                         int i, int j, int k,
+                         unimesh_patch_t* block)
+{
+  int h = executor->num_stages;
+  int n[3] = {executor->nx, executor->ny, executor->nz};
+  for (int di = -1; di <= 1; ++di)
+  {
+    for (int dj = -1; dj <= 1; ++dj)
+    {
+      for (int dk = -1; dk <= 1; ++dk)
+      {
+        int ni, nj, nk;
+        find_neighbor(executor->mesh, i, j, k, di, dj, dk, &ni, &nj, &nk);
+        unimesh_patch_t* patch = unimesh_field_patch(field, ni, nj, nk);
+        ASSERT(patch != NULL);
+
+        // Find the ranges of cells to copy in each direction.
+        int d[3] = {di, dj, dk}, src[3][2], dest[3][2];
+        for (int a = 0; a < 3; ++a)
+        {
+          if (d[a] == -1)
+          {
+            src[a][0] = n[a] + 1 - h;
+            src[a][1] = n[a] + 1;
+            dest[a][0] = 0;
+            dest[a][1] = h;
+          }
+          else if (d[a] == 0)
+          {
+            src[a][0] = 1;
+            src[a][1] = n[a] + 1;
+            dest[a][0] = h;
+            dest[a][1] = n[a] + h;
+          }
+          else
+          {
+            src[a][0] = 1;
+            src[a][1] = h + 1;
+            dest[a][0] = n[a] + h;
+            dest[a][1] = n[a] + 2*h;
+          }
+        }
+        unimesh_patch_box_t src_box = {.i1 = src[0][0], .i2 = src[0][1],
+                                       .j1 = src[1][0], .j2 = src[1][1],
+                                       .k1 = src[2][0], .k2 = src[2][1]};
+        unimesh_patch_box_t dest_box = {.i1 = dest[0][0], .i2 = dest[0][1],
+                                        .j1 = dest[1][0], .j2 = dest[1][1],
+                                        .k1 = dest[2][0], .k2 = dest[2][1]};
+        copy_box(patch, &src_box, &dest_box, block);
+      }
+    }
+  }
+}
+
+// Applies all stages to the given blocked patch, storing its updated values
+// (and those after each stage, if needed).
+static void apply_blocked(unimesh_stage_executor_t* executor,
+                          unimesh_field_t* field,
+                          real_t t,
+                          int b,
+                          unimesh_patch_t* in,
+                          unimesh_patch_t* out)
+{
+  int* ijk = &executor->blocked[3*b];
+  gather_block(executor, field, ijk[0], ijk[1], ijk[2], in);
+
+  unimesh_patch_box_t patch_box, interior_box;
+  get_patch_box_in_block(executor, &patch_box);
+  unimesh_patch_get_box(executor->results[b], &interior_box);
+  int num_saved_stages = executor->num_stages - 1;
+  for (int s = 0; s < executor->num_stages; ++s)
+  {
+    // Each stage computes values in one fewer layer than the last.
+    unimesh_patch_box_t box = {.i1 = 1 + s, .i2 = in->nx + 1 - s,
+                               .j1 = 1 + s, .j2 = in->ny + 1 - s,
+                               .k1 = 1 + s, .k2 = in->nz + 1 - s};
+    executor->kernels[s](executor->context, t, in, &box, out);
+    if ((executor->stage_values != NULL) && (s < num_saved_stages))
+    {
+      unimesh_patch_t* values = executor->stage_values[num_saved_stages*b + s];
+      if (values != NULL)
+        copy_box(out, &patch_box, &interior_box, values);
+    }
+    unimesh_patch_t* tmp = in;
+    in = out;
+    out = tmp;
+  }
+  copy_box(in, &patch_box, &interior_box, executor->results[b]);
+}
+
+void unimesh_stage_executor_apply(unimesh_stage_executor_t* executor,
+                                  unimesh_field_t* field,
+                                  real_t t)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(unimesh_field_mesh(field) == executor->mesh);
+  ASSERT(unimesh_field_centering(field) == UNIMESH_CELL);
+  ASSERT(unimesh_field_num_components(field) == executor->nc);
+
+  // Apply all stages to the blocked patches, reading the field's data
+  // before it's changed.
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(executor->num_threads)
+#endif
+  for (int b = 0; b < executor->num_blocked; ++b)
+  {
+#if POLYMEC_HAVE_OPENMP
+    int tid = omp_get_thread_num();
+#else
+    int tid = 0;
+#endif
+    apply_blocked(executor, field, t, b,
+                  executor->blocks[2*tid], executor->blocks[2*tid+1]);
+  }
+
+  // Apply the stages one at a time to the unblocked patches, updating
+  // their ghost cells (with values from blocked patches as needed) between
+  // stages.
+  if (executor->updates_ghosts)
+  {
+    int num_saved_stages = executor->num_stages - 1;
+    for (int s = 0; s < executor->num_stages; ++s)
+    {
+      if ((s > 0) && (executor->stage_values != NULL))
+      {
+        for (int b = 0; b < executor->num_blocked; ++b)
+        {
+          unimesh_patch_t* values = executor->stage_values[num_saved_stages*b + s-1];
+          if (values != NULL)
+          {
+            int* ijk = &executor->blocked[3*b];
+            unimesh_patch_copy(values, unimesh_field_patch(field, ijk[0], ijk[1], ijk[2]));
+          }
+        }
+      }
+      unimesh_field_update_patch_boundaries(field, t);
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(executor->num_threads)
+#endif
+      for (int u = 0; u < executor->num_unblocked; ++u)
+      {
+#if POLYMEC_HAVE_OPENMP
+        int tid = omp_get_thread_num();
+#else
+        int tid = 0;
+#endif
+        int* ijk = &executor->unblocked[3*u];
+        unimesh_patch_t* patch = unimesh_field_patch(field, ijk[0], ijk[1], ijk[2]);
+        unimesh_patch_t* work = executor->work[tid];
+        unimesh_patch_box_t box;
+        unimesh_patch_get_box(patch, &box);
+        executor->kernels[s](executor->context, t, patch, &box, work);
+        unimesh_patch_copy(work, patch);
+      }
+    }
+  }
+
+  // Copy the updated values into the blocked patches.
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for num_threads(executor->num_threads)
+#endif
+  for (int b = 0; b < executor->num_blocked; ++b)
+  {
+    int* ijk = &executor->blocked[3*b];
+    unimesh_patch_copy(executor->results[b],
+                       unimesh_field_patch(field, ijk[0], ijk[1], ijk[2]));
+  }
+  STOP_FUNCTION_TIMER();
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef POLYMEC_UNIMESH_STAGE_EXECUTOR_H
+#define POLYMEC_UNIMESH_STAGE_EXECUTOR_H
+
+#include "geometry/unimesh_field.h"
+#include "geometry/unimesh_patch.h"
+
+/// \addtogroup geometry geometry
+///@{
+
+/// This function type computes one stage of a multi-stage update on a patch
+/// of cell data. It stores values in the cells of the out patch within the
+/// given box, using values in those cells of the in patch and their face
+/// neighbors.
+/// \param [in] context A context pointer.
+/// \param [in] t The time at which the stages are applied.
+/// \param [in] in The patch holding values from the previous stage.
+/// \param [in] box The box (in the patches' index space) within which
+///                 values are computed.
+/// \param [out] out The patch storing the computed values.
+typedef void (*unimesh_stage_kernel)(void* context, real_t t,
+                                     unimesh_patch_t* in,
+                                     unimesh_patch_box_t* box,
+                                     unimesh_patch_t* out);
+
+/// \class unimesh_stage_executor
+/// A unimesh stage executor applies a sequence of stage kernels (such as
+/// the stages of an explicit Runge-Kutta method) to a cell-centered field,
+/// using temporal blocking where it can. A patch whose neighbors are all
+/// stored locally is copied, with as many layers of its neighbors' cells as
+/// there are stages, into a working block, and every stage is applied to
+/// that block while it sits in cache. Each stage shrinks the region of valid
+/// data by one layer, leaving the updated values for the patch after the
+/// last stage. Other patches (those on process boundaries, or next to
+/// non-periodic boundaries) are updated one stage at a time, with their
+/// ghost cells updated between stages. If no process has such patches, the
+/// stages are applied without any ghost cell updates at all.
+typedef struct unimesh_stage_executor_t unimesh_stage_executor_t;
+
+/// Creates a stage executor for fields on the given mesh.
+/// \param [in] mesh The mesh on which the executor operates. The patches in
+///                  this mesh must have at least as many cells as there are
+///                  stages in each direction. If they don't, this is an
+///                  error.
+/// \param [in] num_components The number of components in the fields.
+/// \param [in] num_stages The number of stages.
+/// \param [in] context A context pointer passed to the kernels. Not consumed.
+/// \param [in] kernels An array of num_stages stage kernels, applied in order.
+///                     These kernels may be called by several threads at
+///                     once, and must not modify the context.
+/// \memberof unimesh_stage_executor
+/// \collective Collective on the mesh's communicator.
+unimesh_stage_executor_t* unimesh_stage_executor_new(unimesh_t* mesh,
+                                                     int num_components,
+                                                     int num_stages,
+                                                     void* context,
+                                                     unimesh_stage_kernel* kernels);
+
+/// Destroys the given stage executor.
+/// \memberof unimesh_stage_executor
+void unimesh_stage_executor_free(unimesh_stage_executor_t* executor);
+
+/// Returns the number of locally-stored patches that the executor updates
+/// with temporal blocking.
+/// \memberof unimesh_stage_executor
+int unimesh_stage_executor_num_blocked_patches(unimesh_stage_executor_t* executor);
+
+/// Applies all stages to the given cell-centered field in place at time t.
+/// Ghost cells are updated between stages with the field's own boundary
+/// conditions on patches that aren't temporally blocked. The field's ghost
+/// cells are not updated after the last stage.
+/// \memberof unimesh_stage_executor
+/// \collective Collective on the mesh's communicator.
+void unimesh_stage_executor_apply(unimesh_stage_executor_t* executor,
+                                  unimesh_field_t* field,
+                                  real_t t);
+
+///@}
+
+#endif
+
@@ -6,7 +6,9 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
+#include <unistd.h>
 #include "core/polymec.h"
 
 #if POLYMEC_HAVE_MPI
@@ -22,6 +24,7 @@ static int SILO_FILE_MPI_TAG = 1111;
 #include "core/logging.h"
 #include "core/array.h"
 #include "core/array_utils.h"
+#include "core/kd_tree.h"
 #include "core/timer.h"
 #include "io/silo_file.h"
 
@@ -95,6 +98,133 @@ void silo_file_read_field_metadata(silo_file_t* file,
 bool silo_file_contains_field_metadata(silo_file_t* file,
                                        const char* md_name);
 
+// Returns true if the file is being read by a different number of processes
+// than wrote it. In this case, each process is assigned a contiguous block
+// of the writing processes' domains (possibly an empty one), and reads from
+// its "primary" domain unless told otherwise by silo_file_set_domain.
+bool silo_file_is_remapped(silo_file_t* file);
+
+// Retrieves the number of domains (writing processes) in the file, and the
+// block of domains assigned to this process.
+void silo_file_get_domains(silo_file_t* file,
+                           int* num_domains,
+                           int* first_local_domain,
+                           int* num_local_domains);
+
+// Sets the domain from which data is read in a remapped file, opening the
+// file that contains it if needed. This must be called outside of any
+// pushed domain directory.
+void silo_file_set_domain(silo_file_t* file, int domain);
+
+// Resets the domain from which data is read in a remapped file to this
+// process's primary domain.
+void silo_file_reset_domain(silo_file_t* file);
+
+// Retrieves the range [start, end) of the given number of items, ordered by
+// the domains that wrote them, that are read by this process from a remapped
+// file. Each process reads a contiguous slice of roughly equal size.
+void silo_file_get_remapped_range(silo_file_t* file,
+                                  int num_items,
+                                  int* start,
+                                  int* end);
+
+// Reads the integer array with the given name from each of the local domains
+// of a remapped file, interpreting it as a list of tuples of the given size.
+// Returns a newly-allocated list of all such tuples in all domains on every
+// process, each followed by the domain that wrote it, and ordered by domain.
+// \collective Collective on the file's communicator.
+int_array_t* silo_file_gather_domain_tuples(silo_file_t* file,
+                                            const char* array_name,
+                                            int tuple_size);
+
+// Returns true if uniform cartesian mesh fields written to the file are
+// aggregated, and sets write_patch_views to true if per-patch views of
+// these fields are also written.
+bool silo_file_aggregates_unimesh_fields(silo_file_t* file,
+                                         bool* write_patch_views);
+
+// Retrieves the compression method and error bound for the object with the
+// given name.
+void silo_file_get_compression(silo_file_t* file,
+                               const char* object_name,
+                               silo_compression_t* method,
+                               real_t* error_bound);
+
+// Writes the given array of reals to the variable with the given name in the
+// current directory of the given file, compressing it according to the
+// policy for the object with the given name.
+void silo_file_write_compressed_reals(silo_file_t* file,
+                                      const char* object_name,
+                                      const char* var_name,
+                                      real_t* data,
+                                      size_t size);
+
+// Returns true if the current directory of the given file contains a
+// variable with the given name written by silo_file_write_compressed_reals.
+bool silo_file_contains_compressed_reals(silo_file_t* file,
+                                         const char* var_name);
+
+// Reads the variable with the given name written by
+// silo_file_write_compressed_reals from the current directory of the given
+// file, returning a newly allocated array and storing its size in size.
+real_t* silo_file_read_compressed_reals(silo_file_t* file,
+                                        const char* var_name,
+                                        size_t* size);
+
+// Writes a real-valued array as silo_file_write_real_array does, but
+// compresses it according to the policy for the object with the given name.
+void silo_file_write_object_real_array(silo_file_t* file,
+                                       const char* object_name,
+                                       const char* array_name,
+                                       real_t* array_data,
+                                       size_t array_size);
+
+// Writes the given data (size values of the given Silo datatype) to the
+// variable with the given name in the current directory of the given file,
+// or stages it for the shared file if the file uses collective I/O.
+void silo_file_write_var(silo_file_t* file,
+                         const char* var_name,
+                         void* data,
+                         int size,
+                         int datatype);
+
+// Returns true if the current directory of the given file contains a
+// variable with the given name written by silo_file_write_var.
+bool silo_file_contains_var(silo_file_t* file, const char* var_name);
+
+// Returns the number of values in the variable with the given name written
+// by silo_file_write_var.
+int silo_file_var_length(silo_file_t* file, const char* var_name);
+
+// Reads the variable with the given name written by silo_file_write_var
+// from the current directory of the given file into data. Fails if the 
+// variable doesn't exist. This is not a collective operation: data in the 
+// shared file is read independently by each process.
+void silo_file_read_var(silo_file_t* file, const char* var_name, void* data);
+
+// Writes the given data (size values of the given Silo datatype) to the
+// variable with the given name in the current directory of the given file,
+// storing it uncompressed and aligned to a memory page in the shared file
+// (whether or not the file uses collective I/O) so that it can be mapped
+// into memory by silo_file_map_var.
+void silo_file_write_mappable_var(silo_file_t* file,
+                                  const char* var_name,
+                                  void* data,
+                                  size_t size,
+                                  int datatype);
+
+// Maps the variable with the given name written by
+// silo_file_write_mappable_var privately into memory, storing a pointer to
+// its data in data. The variable must hold size values of the given Silo 
+// datatype; a variable of a different type or length is an error. Returns a 
+// refcounted object that owns the mapping, or NULL if the variable can't be 
+// mapped.
+void* silo_file_map_var(silo_file_t* file,
+                        const char* var_name,
+                        int datatype,
+                        size_t size,
+                        void** data);
+
 //-------------------------------------------------------------------------
 // End unpublished functions
 //-------------------------------------------------------------------------
@@ -492,6 +622,36 @@ struct silo_file_t
   // Scratch space for storing named temporary data.
   string_ptr_unordered_map_t* scratch;
 
+  // Do we aggregate the patches of unimesh fields, and if so, do we also
+  // write per-patch views of them?
+  bool aggregate_unimesh_fields, write_unimesh_patch_views;
+
+  // Compression policies for specific objects, and for all other objects.
+  string_ptr_unordered_map_t* compression;
+  silo_compression_t default_compression;
+  real_t default_error_bound;
+
+  // Array data written with collective I/O goes to a single file shared by
+  // all processes. When writing, each process stages its data in a buffer
+  // that is written when the file is closed. When reading, each process
+  // reads its domains' segments of the shared file on demand.
+  bool collective_io;
+  int num_aggregators;
+  char shared_filename[FILENAME_MAX+1];
+  uint8_t* staged_data;
+  size_t staged_size, staged_capacity;
+  FILE* shared_file;
+  int num_segments;
+  int64_t* segment_offsets;
+
+  // Incremental writes: data that hasn't changed since an earlier step of
+  // the data set (according to its write history) is stored as a reference 
+  // to that step, either as a whole or block by block. When reading, we open
+  // the files for referenced steps as needed.
+  bool incremental, block_deltas;
+  silo_write_history_t* history;
+  string_ptr_unordered_map_t* referenced_files;
+
   MPI_Comm comm;
 #if POLYMEC_HAVE_MPI
   // Stuff for poor man's parallel I/O.
@@ -501,9 +661,32 @@ struct silo_file_t
   // Data appearing on more than one proc within a domain decomposition.
   ptr_array_t* subdomain_meshes;
   ptr_array_t* subdomain_fields;
+
+  // N-to-M reading: if the file was written by a different number of
+  // processes, this process reads the domains [first_domain,
+  // first_domain + num_local_domains) (and reads everything else from its
+  // primary domain). domain is the domain currently being read.
+  bool remapped;
+  int requested_step, first_domain, num_local_domains, primary_domain;
 #endif
+
+  // The domain whose data is being read (always 0 without MPI).
+  int domain;
 };
 
+// Generates the name of the Silo file for the given step (or -1 for none) of
+// the data set with the given prefix, within the given directory.
+static void get_silo_filename(const char* directory, 
+                              const char* prefix, 
+                              int step,
+                              char* filename)
+{
+  if (step == -1)
+    snprintf(filename, FILENAME_MAX, "%s/%s.silo", directory, prefix);
+  else
+    snprintf(filename, FILENAME_MAX, "%s/%s-%d.silo", directory, prefix, step);
+}
+
 // Expression struct.
 typedef struct
 {
@@ -645,10 +828,7 @@ static void write_master_file(silo_file_t* file)
   // FIXME: objects when we start to Get Real Parallel.
 
   char master_file_name[FILENAME_MAX+1];
-  if (file->step == -1)
-    snprintf(master_file_name, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-  else
-    snprintf(master_file_name, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, file->step);
+  get_silo_filename(file->directory, file->prefix, file->step, master_file_name);
   PMPIO_baton_t* baton = PMPIO_Init(1, PMPIO_WRITE, file->comm,
                                     file->mpi_tag+1, pmpio_create_file,
                                     pmpio_open_file, pmpio_close_file, NULL);
@@ -768,6 +948,15 @@ static void set_prefix(silo_file_t* file,
   strcpy(file->prefix, pre);
 }
 
+// Sets the name of the file shared by all processes for collective I/O.
+static void set_shared_filename(silo_file_t* file, int step)
+{
+  if (step == -1)
+    snprintf(file->shared_filename, FILENAME_MAX, "%s/%s.mpiio", file->directory, file->prefix);
+  else
+    snprintf(file->shared_filename, FILENAME_MAX, "%s/%s-%d.mpiio", file->directory, file->prefix, step);
+}
+
 silo_file_t* silo_file_new(MPI_Comm comm,
                            const char* file_prefix,
                            const char* directory,
@@ -783,6 +972,23 @@ silo_file_t* silo_file_new(MPI_Comm comm,
 
   silo_file_t* file = polymec_malloc(sizeof(silo_file_t));
   file->expressions = string_ptr_unordered_map_new();
+  file->aggregate_unimesh_fields = false;
+  file->write_unimesh_patch_views = false;
+  file->compression = string_ptr_unordered_map_new();
+  file->default_compression = SILO_COMPRESSION_NONE;
+  file->default_error_bound = 0.0;
+  file->collective_io = false;
+  file->num_aggregators = 0;
+  file->staged_data = NULL;
+  file->staged_size = file->staged_capacity = 0;
+  file->shared_file = NULL;
+  file->num_segments = 0;
+  file->segment_offsets = NULL;
+  file->incremental = false;
+  file->block_deltas = false;
+  file->history = NULL;
+  file->referenced_files = NULL;
+  file->domain = 0;
 
   set_prefix(file, file_prefix);
 
@@ -792,6 +998,10 @@ silo_file_t* silo_file_new(MPI_Comm comm,
   file->mpi_tag = SILO_FILE_MPI_TAG;
   MPI_Comm_size(file->comm, &file->nproc);
   MPI_Comm_rank(file->comm, &file->rank);
+  file->remapped = false;
+  file->requested_step = step;
+  file->first_domain = file->primary_domain = file->domain = file->rank;
+  file->num_local_domains = 1;
   if (num_files == -1)
     file->num_files = file->nproc;
   else
@@ -835,19 +1045,13 @@ silo_file_t* silo_file_new(MPI_Comm comm,
       if (file->rank_in_group == 0)
         create_directory(group_dir_name, S_IRWXU | S_IRWXG);
 
-      if (step == -1)
-        snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", group_dir_name, file->prefix);
-      else
-        snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", group_dir_name, file->prefix, step);
+      get_silo_filename(group_dir_name, file->prefix, step, file->filename);
     }
     else
     {
       ASSERT(file->group_rank == 0);
       ASSERT(file->rank_in_group == file->rank);
-      if (step == -1)
-        snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-      else
-        snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, step);
+      get_silo_filename(file->directory, file->prefix, step, file->filename);
     }
     char silo_dir_name[FILENAME_MAX+1];
     snprintf(silo_dir_name, FILENAME_MAX, "domain_%d", file->rank_in_group);
@@ -868,10 +1072,7 @@ silo_file_t* silo_file_new(MPI_Comm comm,
     else
       strncpy(file->directory, directory, FILENAME_MAX);
 
-    if (step == -1)
-      snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-    else
-      snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, step);
+    get_silo_filename(file->directory, file->prefix, step, file->filename);
 
     int driver = DB_HDF5;
     if (strcmp(file->directory, ".") != 0)
@@ -885,16 +1086,14 @@ silo_file_t* silo_file_new(MPI_Comm comm,
   else
     strncpy(file->directory, directory, FILENAME_MAX);
 
-  if (step == -1)
-    snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-  else
-    snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, step);
+  get_silo_filename(file->directory, file->prefix, step, file->filename);
 
   int driver = DB_HDF5;
   create_directory(file->directory, S_IRWXU | S_IRWXG);
   log_debug("silo_file_new: Opening %s for writing...", file->filename);
   file->dbfile = DBCreate(file->filename, DB_CLOBBER, DB_LOCAL, NULL, driver);
 #endif
+  set_shared_filename(file, step);
 
   silo_file_push_dir(file, "/");
   file->mode = DB_CLOBBER;
@@ -958,6 +1157,52 @@ static void show_provenance_on_debug_log(silo_file_t* file)
   }
 }
 
+#if POLYMEC_HAVE_MPI
+// Determines the group (file) containing the given domain within a data set,
+// and the domain's rank within that group. This mirrors the assignment of
+// processes to groups in PMPIO_Init.
+static void get_domain_group(silo_file_t* file,
+                             int domain,
+                             int* group_rank,
+                             int* rank_in_group)
+{
+  ASSERT((domain >= 0) && (domain < file->nproc));
+  int group_size = file->nproc / file->num_files;
+  int num_groups_with_extra_proc = file->nproc % file->num_files;
+  int split = num_groups_with_extra_proc * (group_size + 1);
+  if (domain < split)
+  {
+    *group_rank = domain / (group_size + 1);
+    *rank_in_group = domain % (group_size + 1);
+  }
+  else
+  {
+    *group_rank = num_groups_with_extra_proc + (domain - split) / group_size;
+    *rank_in_group = (domain - split) % group_size;
+  }
+}
+
+// Opens the file for the given group within a remapped data set, closing
+// any other open file.
+static bool open_group_file(silo_file_t* file, int group_rank)
+{
+  char group_dir_name[FILENAME_MAX+1];
+  if (file->num_files > 1)
+    snprintf(group_dir_name, FILENAME_MAX, "%s/%d", file->directory, group_rank);
+  else
+    strncpy(group_dir_name, file->directory, FILENAME_MAX);
+  get_silo_filename(group_dir_name, file->prefix, file->requested_step, 
+                    file->filename);
+
+  if (file->dbfile != NULL)
+    DBClose(file->dbfile);
+  log_debug("silo_file: Opening %s for reading...", file->filename);
+  file->dbfile = DBOpen(file->filename, DB_HDF5, DB_READ);
+  file->group_rank = group_rank;
+  return (file->dbfile != NULL);
+}
+#endif
+
 silo_file_t* silo_file_open(MPI_Comm comm,
                             const char* file_prefix,
                             const char* directory,
@@ -974,6 +1219,23 @@ silo_file_t* silo_file_open(MPI_Comm comm,
   file->step = -1;
   file->time = -REAL_MAX;
   file->expressions = NULL;
+  file->aggregate_unimesh_fields = false;
+  file->write_unimesh_patch_views = false;
+  file->compression = string_ptr_unordered_map_new();
+  file->default_compression = SILO_COMPRESSION_NONE;
+  file->default_error_bound = 0.0;
+  file->collective_io = false;
+  file->num_aggregators = 0;
+  file->staged_data = NULL;
+  file->staged_size = file->staged_capacity = 0;
+  file->shared_file = NULL;
+  file->num_segments = 0;
+  file->segment_offsets = NULL;
+  file->incremental = false;
+  file->block_deltas = false;
+  file->history = NULL;
+  file->referenced_files = NULL;
+  file->domain = 0;
 
   set_prefix(file, file_prefix);
 
@@ -1009,15 +1271,18 @@ silo_file_t* silo_file_open(MPI_Comm comm,
 
   log_debug("silo_file_open: Found file written by %d MPI processes.", num_mpi_procs);
 
-  // For now, we only support reading files that were written with the same
-  // number of processes.
+#if !POLYMEC_HAVE_MPI
+  // Without MPI, we can only read files written by a single process.
   if (nproc != num_mpi_procs)
   {
     log_urgent("silo_file_open: Cannot read file written by %d MPI processes "
-               "into communicator with %d processes.", nproc, num_mpi_procs);
+               "into communicator with %d processes.", num_mpi_procs, nproc);
+    int_slist_free(steps);
+    polymec_free(file);
     STOP_FUNCTION_TIMER();
     return NULL;
   }
+#endif
 
   // Check to see whether the requested step is available, or whether the
   // latest one is requested (with -1).
@@ -1054,7 +1319,47 @@ silo_file_t* silo_file_open(MPI_Comm comm,
   file->num_files = num_files; // number of files in the data set.
   file->nproc = num_mpi_procs; // number of MPI procs used to write the thing.
 
-  if (file->nproc > 1)
+  // If we're reading the file with a different number of processes than
+  // wrote it, we assign each process a contiguous block of the writers'
+  // domains. With more readers than writers, some processes get no domains,
+  // but every process has a primary domain from which it reads data that
+  // isn't distributed.
+  file->remapped = (nproc != num_mpi_procs);
+  file->requested_step = step;
+  file->first_domain = (int)(((long)file->rank * file->nproc) / nproc);
+  file->num_local_domains = (int)(((long)(file->rank+1) * file->nproc) / nproc) -
+                            file->first_domain;
+  file->primary_domain = file->domain = file->first_domain;
+  if (file->remapped)
+  {
+    log_debug("silo_file_open: Reading domains %d-%d of %d on this process.",
+              file->first_domain, file->first_domain + file->num_local_domains - 1,
+              file->nproc);
+  }
+
+  if (file->remapped && (file->nproc > 1))
+  {
+    // Look for the master directory.
+    if (strlen(directory) == 0)
+      snprintf(file->directory, FILENAME_MAX, "%s_%dprocs", file->prefix, file->nproc);
+    else
+      strncpy(file->directory, directory, FILENAME_MAX);
+
+    // Processes reading a remapped data set may need domains stored in
+    // several files, so they open these files themselves instead of
+    // passing batons.
+    int group_rank;
+    get_domain_group(file, file->primary_domain, &group_rank, &file->rank_in_group);
+    if (!open_group_file(file, group_rank))
+    {
+      log_urgent("silo_file_open: Could not open %s for file prefix %s.",
+                 file->filename, file->prefix);
+      polymec_free(file);
+      STOP_FUNCTION_TIMER();
+      return NULL;
+    }
+  }
+  else if (file->nproc > 1)
   {
     // Look for the master directory.
     if (strlen(directory) == 0)
@@ -1102,19 +1407,13 @@ silo_file_t* silo_file_open(MPI_Comm comm,
       }
 
       // Determine a file name and directory name.
-      if (step == -1)
-        snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", group_dir_name, file->prefix);
-      else
-        snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", group_dir_name, file->prefix, step);
+      get_silo_filename(group_dir_name, file->prefix, step, file->filename);
     }
     else
     {
       ASSERT(file->group_rank == 0);
       ASSERT(file->rank_in_group == file->rank);
-      if (step == -1)
-        snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-      else
-        snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, step);
+      get_silo_filename(file->directory, file->prefix, step, file->filename);
     }
 
     char silo_dir_name[FILENAME_MAX+1];
@@ -1130,10 +1429,7 @@ silo_file_t* silo_file_open(MPI_Comm comm,
     else
       strncpy(file->directory, directory, FILENAME_MAX);
 
-    if (step == -1)
-      snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-    else
-      snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, step);
+    get_silo_filename(file->directory, file->prefix, step, file->filename);
 
     int driver = DB_HDF5;
     log_debug("silo_file_open: Opening %s for reading...", file->filename);
@@ -1145,15 +1441,13 @@ silo_file_t* silo_file_open(MPI_Comm comm,
   else
     strncpy(file->directory, directory, FILENAME_MAX);
 
-  if (step == -1)
-    snprintf(file->filename, FILENAME_MAX, "%s/%s.silo", file->directory, file->prefix);
-  else
-    snprintf(file->filename, FILENAME_MAX, "%s/%s-%d.silo", file->directory, file->prefix, step);
+  get_silo_filename(file->directory, file->prefix, step, file->filename);
 
   int driver = DB_HDF5;
   log_debug("silo_file_open: Opening %s for reading...", file->filename);
   file->dbfile = DBOpen(file->filename, driver, file->mode);
 #endif
+  set_shared_filename(file, step);
 
   silo_file_push_dir(file, "/");
   show_provenance_on_debug_log(file);
@@ -1182,6 +1476,108 @@ silo_file_t* silo_file_open(MPI_Comm comm,
   return file;
 }
 
+// Alignment (in bytes) of the segments in the shared file, and of the
+// variables within them that can be mapped into memory.
+static const size_t SHARED_FILE_PAGE_SIZE = 4096;
+
+// Writes the array data staged on each process to the shared file (using
+// collective MPI-IO if we have MPI). The shared file begins with the number
+// of segments (one per process) and their offsets, followed by the segments
+// themselves, each aligned to a page.
+static void write_shared_file(silo_file_t* file)
+{
+  START_FUNCTION_TIMER();
+  int nproc = 1;
+#if POLYMEC_HAVE_MPI
+  int rank;
+  MPI_Comm_size(file->comm, &nproc);
+  MPI_Comm_rank(file->comm, &rank);
+#endif
+
+  // Figure out where each process's segment goes.
+  int64_t* header = polymec_malloc(sizeof(int64_t) * (nproc + 1));
+  int64_t segment_size = (int64_t)file->staged_size;
+#if POLYMEC_HAVE_MPI
+  MPI_Allgather(&segment_size, 1, MPI_INT64_T, &header[1], 1, MPI_INT64_T, file->comm);
+#else
+  header[1] = segment_size;
+#endif
+  header[0] = (int64_t)nproc;
+  int64_t page_size = (int64_t)SHARED_FILE_PAGE_SIZE;
+  int64_t offset = (int64_t)(sizeof(int64_t) * (nproc + 1));
+  for (int p = 0; p < nproc; ++p)
+  {
+    offset = page_size * ((offset + page_size - 1) / page_size);
+    int64_t size = header[p+1];
+    header[p+1] = offset;
+    offset += size;
+  }
+
+#if POLYMEC_HAVE_MPI
+  MPI_Offset segment_offset = (MPI_Offset)header[rank+1];
+
+  // Ask for two-phase (collective buffering) I/O, in which aggregator
+  // processes gather the segments and write them in large contiguous blocks.
+  MPI_Info info;
+  MPI_Info_create(&info);
+  MPI_Info_set(info, "romio_cb_write", "enable");
+  if (file->num_aggregators > 0)
+  {
+    char num_aggregators[16];
+    snprintf(num_aggregators, 16, "%d", file->num_aggregators);
+    MPI_Info_set(info, "cb_nodes", num_aggregators);
+  }
+
+  MPI_File shared_file;
+  int err = MPI_File_open(file->comm, file->shared_filename,
+                          MPI_MODE_CREATE | MPI_MODE_WRONLY, info, &shared_file);
+  if (err != MPI_SUCCESS)
+    polymec_error("silo_file_close: Could not open %s for writing.", file->shared_filename);
+  MPI_File_set_size(shared_file, (MPI_Offset)offset);
+  if (rank == 0)
+    MPI_File_write_at(shared_file, 0, header, nproc + 1, MPI_INT64_T, MPI_STATUS_IGNORE);
+
+  // Write the segments in pieces whose sizes fit into MPI's int counts.
+  static const size_t max_piece_size = 1 << 30;
+  int num_pieces = (int)((file->staged_size + max_piece_size - 1) / max_piece_size);
+  MPI_Allreduce(MPI_IN_PLACE, &num_pieces, 1, MPI_INT, MPI_MAX, file->comm);
+  for (int p = 0; p < num_pieces; ++p)
+  {
+    size_t start = MIN(p * max_piece_size, file->staged_size);
+    size_t end = MIN(start + max_piece_size, file->staged_size);
+    err = MPI_File_write_at_all(shared_file, segment_offset + (MPI_Offset)start,
+                                file->staged_data + start, (int)(end - start),
+                                MPI_BYTE, MPI_STATUS_IGNORE);
+    if (err != MPI_SUCCESS)
+      polymec_error("silo_file_close: Could not write to %s.", file->shared_filename);
+  }
+  MPI_File_close(&shared_file);
+  MPI_Info_free(&info);
+#else
+  FILE* shared_file = fopen(file->shared_filename, "wb");
+  if ((shared_file == NULL) ||
+      (fwrite(header, sizeof(int64_t), 2, shared_file) != 2) ||
+      (fseeko(shared_file, (off_t)header[1], SEEK_SET) != 0) ||
+      (fwrite(file->staged_data, sizeof(uint8_t), file->staged_size, shared_file) != file->staged_size))
+    polymec_error("silo_file_close: Could not write %s.", file->shared_filename);
+  fclose(shared_file);
+#endif
+  polymec_free(header);
+  log_debug("silo_file_close: Wrote %zu bytes to %s.", file->staged_size,
+            file->shared_filename);
+  STOP_FUNCTION_TIMER();
+}
+
+#if POLYMEC_HAVE_MPI
+// Returns true if any process has staged data for the shared file.
+static bool shared_file_is_staged(silo_file_t* file)
+{
+  int staged = (file->collective_io || (file->staged_data != NULL)) ? 1 : 0;
+  MPI_Allreduce(MPI_IN_PLACE, &staged, 1, MPI_INT, MPI_MAX, file->comm);
+  return (staged != 0);
+}
+#endif
+
 void silo_file_close(silo_file_t* file)
 {
   START_FUNCTION_TIMER();
@@ -1197,12 +1593,21 @@ void silo_file_close(silo_file_t* file)
       write_provenance_to_file(file);
     }
 
-    log_debug("silo_file_close: Handing off baton.");
-    PMPIO_HandOffBaton(file->baton, (void*)file->dbfile);
-    PMPIO_Finish(file->baton);
+    if (file->remapped)
+      DBClose(file->dbfile);
+    else
+    {
+      log_debug("silo_file_close: Handing off baton.");
+      PMPIO_HandOffBaton(file->baton, (void*)file->dbfile);
+      PMPIO_Finish(file->baton);
+    }
 
     if (file->mode == DB_CLOBBER)
     {
+      // Write any staged array data to the shared file.
+      if (shared_file_is_staged(file))
+        write_shared_file(file);
+
       // Write the uber-master file containing any multiobjects if need be.
       write_master_file(file);
     }
@@ -1222,6 +1627,8 @@ void silo_file_close(silo_file_t* file)
       write_provenance_to_file(file);
     }
     DBClose(file->dbfile);
+    if ((file->mode == DB_CLOBBER) && shared_file_is_staged(file))
+      write_shared_file(file);
   }
 #else
   // Write the file.
@@ -1231,6 +1638,8 @@ void silo_file_close(silo_file_t* file)
     write_provenance_to_file(file);
   }
   DBClose(file->dbfile);
+  if ((file->mode == DB_CLOBBER) && (file->staged_data != NULL))
+    write_shared_file(file);
 #endif
 
   log_debug("silo_file_close: Closed file.");
@@ -1242,6 +1651,15 @@ void silo_file_close(silo_file_t* file)
     string_ptr_unordered_map_free(file->scratch);
   if (file->expressions != NULL)
     string_ptr_unordered_map_free(file->expressions);
+  string_ptr_unordered_map_free(file->compression);
+  if (file->staged_data != NULL)
+    polymec_free(file->staged_data);
+  if (file->shared_file != NULL)
+    fclose(file->shared_file);
+  if (file->segment_offsets != NULL)
+    polymec_free(file->segment_offsets);
+  if (file->referenced_files != NULL)
+    string_ptr_unordered_map_free(file->referenced_files);
   polymec_free(file);
   STOP_FUNCTION_TIMER();
 }
@@ -1534,12 +1952,15 @@ void silo_file_write_polymesh(silo_file_t* file,
 extern void polymesh_set_exchanger(polymesh_t* mesh,
                                    polymesh_centering_t centering,
                                    exchanger_t* exchanger);
-polymesh_t* silo_file_read_polymesh(silo_file_t* file,
-                                    const char* mesh_name)
-{
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_READ);
 
+// Reads the cells, faces, and nodes of the polymesh with the given name from
+// the current domain of the given file into a new polymesh on the given
+// communicator. The polymesh has no edges or geometry. Returns NULL if the
+// mesh isn't found.
+static polymesh_t* read_polymesh_topology(silo_file_t* file,
+                                          const char* mesh_name,
+                                          MPI_Comm comm)
+{
   silo_file_push_domain_dir(file);
 
   DBucdmesh* ucd_mesh = DBGetUcdmesh(file->dbfile, mesh_name);
@@ -1547,7 +1968,6 @@ polymesh_t* silo_file_read_polymesh(silo_file_t* file,
   {
     log_urgent("No mesh named '%s' was found within the Silo file.", mesh_name);
     silo_file_pop_dir(file);
-    STOP_FUNCTION_TIMER();
     return NULL;
   }
   ASSERT(ucd_mesh->ndims == 3);
@@ -1559,8 +1979,8 @@ polymesh_t* silo_file_read_polymesh(silo_file_t* file,
   if (ph_zonelist == NULL)
   {
     log_urgent("Mesh '%s' is not a polymec polyhedral mesh.", mesh_name);
+    DBFreeUcdmesh(ucd_mesh);
     silo_file_pop_dir(file);
-    STOP_FUNCTION_TIMER();
     return NULL;
   }
 
@@ -1569,11 +1989,6 @@ polymesh_t* silo_file_read_polymesh(silo_file_t* file,
   int num_ghost_cells = ph_zonelist->nzones - num_cells;
   int num_faces = ph_zonelist->nfaces;
   int num_nodes = ucd_mesh->nnodes;
-#if POLYMEC_HAVE_MPI
-  MPI_Comm comm = file->comm;
-#else
-  MPI_Comm comm = MPI_COMM_WORLD;
-#endif
   polymesh_t* mesh = polymesh_new(comm, num_cells, num_ghost_cells,
                                   num_faces, num_nodes);
 
@@ -1612,154 +2027,743 @@ polymesh_t* silo_file_read_polymesh(silo_file_t* file,
   memcpy(mesh->cell_faces, ph_zonelist->facelist, sizeof(int) * mesh->cell_face_offsets[mesh->num_cells]);
   memcpy(mesh->face_nodes, ph_zonelist->nodelist, sizeof(int) * mesh->face_node_offsets[mesh->num_faces]);
 
-  // Finish constructing the mesh.
-  polymesh_construct_edges(mesh);
-  polymesh_compute_geometry(mesh);
-
-  // Read in tag information.
-  {
-    char tag_name[FILENAME_MAX+1];
-    snprintf(tag_name, FILENAME_MAX, "%s_node_tags", mesh_name);
-    silo_file_read_tags(file, tag_name, mesh->node_tags);
-    snprintf(tag_name, FILENAME_MAX, "%s_edge_tags", mesh_name);
-    silo_file_read_tags(file, tag_name, mesh->edge_tags);
-    snprintf(tag_name, FILENAME_MAX, "%s_face_tags", mesh_name);
-    silo_file_read_tags(file, tag_name, mesh->face_tags);
-    snprintf(tag_name, FILENAME_MAX, "%s_cell_tags", mesh_name);
-    silo_file_read_tags(file, tag_name, mesh->cell_tags);
-  }
-
-  // Read in exchanger information.
-  {
-    char ex_name[FILENAME_MAX+1];
-    snprintf(ex_name, FILENAME_MAX, "%s_cell_exchanger", mesh_name);
-    polymesh_set_exchanger(mesh, POLYMESH_CELL, silo_file_read_exchanger(file, ex_name, mesh->comm));
-  }
-
   // Clean up.
   DBFreeUcdmesh(ucd_mesh);
   DBFreePHZonelist(ph_zonelist);
 
   silo_file_pop_dir(file);
-
-  STOP_FUNCTION_TIMER();
   return mesh;
 }
 
-bool silo_file_contains_polymesh(silo_file_t* file, const char* mesh_name)
+#if POLYMEC_HAVE_MPI
+
+// Mappings from the cells, faces, and nodes of the local domains of a
+// polymesh in a remapped file to those of the polymesh assembled from them.
+// These are stashed in the file's scratch space so that fields can be read
+// onto the assembled polymesh.
+typedef struct
 {
-  bool result = false;
-  silo_file_push_domain_dir(file);
-  result = (DBInqVarExists(file->dbfile, mesh_name) &&
-            (DBInqVarType(file->dbfile, mesh_name) == DB_UCDMESH));
-  silo_file_pop_dir(file);
-  return result;
-}
+  int num_domains;
+  int* cell_offsets;
+  int** face_maps;
+  int** node_maps;
+} remapped_polymesh_t;
 
-static void silo_file_write_polymesh_field_comp(silo_file_t* file,
-                                                const char* field_name,
-                                                const char* mesh_name,
-                                                int component,
-                                                polymesh_centering_t centering,
-                                                real_t* field_data,
-                                                field_metadata_t* md)
+static void remapped_polymesh_free(remapped_polymesh_t* remap)
 {
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_CLOBBER);
+  for (int m = 0; m < remap->num_domains; ++m)
+  {
+    polymec_free(remap->face_maps[m]);
+    polymec_free(remap->node_maps[m]);
+  }
+  polymec_free(remap->face_maps);
+  polymec_free(remap->node_maps);
+  polymec_free(remap->cell_offsets);
+  polymec_free(remap);
+}
 
-  silo_file_push_domain_dir(file);
+// The parallel boundary of a domain of a polymesh, reconstructed from its
+// cell exchanger. The kth cell sent to a neighboring domain and the kth ghost
+// cell received from it share the kth face on the boundary with that
+// neighbor, and the neighbor numbers its faces on the boundary the same way.
+typedef struct
+{
+  int* neighbors;                  // neighboring domain of each face, or -1
+  int* positions;                  // position of each face on its boundary
+  int_ptr_unordered_map_t* faces;  // neighboring domain -> faces on boundary
+} domain_boundary_t;
+
+static domain_boundary_t* domain_boundary_new(polymesh_t* mesh,
+                                              int* ex_array,
+                                              size_t ex_size)
+{
+  domain_boundary_t* boundary = polymec_malloc(sizeof(domain_boundary_t));
+  boundary->neighbors = polymec_malloc(sizeof(int) * MAX(mesh->num_faces, 1));
+  boundary->positions = polymec_malloc(sizeof(int) * MAX(mesh->num_faces, 1));
+  int_fill(boundary->neighbors, mesh->num_faces, -1);
+  int_fill(boundary->positions, mesh->num_faces, -1);
+  boundary->faces = int_ptr_unordered_map_new();
+
+  // Find the faces attached to each ghost cell.
+  int num_cells = mesh->num_cells, num_ghosts = mesh->num_ghost_cells;
+  int* ghost_face_offsets = polymec_calloc(num_ghosts+1, sizeof(int));
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int g = mesh->face_cells[2*f+1] - num_cells;
+    if (g >= 0)
+      ++ghost_face_offsets[g+1];
+  }
+  for (int g = 0; g < num_ghosts; ++g)
+    ghost_face_offsets[g+1] += ghost_face_offsets[g];
+  int* ghost_faces = polymec_malloc(sizeof(int) * MAX(ghost_face_offsets[num_ghosts], 1));
+  int* ghost_face_counts = polymec_calloc(MAX(num_ghosts, 1), sizeof(int));
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int g = mesh->face_cells[2*f+1] - num_cells;
+    if (g >= 0)
+      ghost_faces[ghost_face_offsets[g] + ghost_face_counts[g]++] = f;
+  }
+  polymec_free(ghost_face_counts);
 
-  // How many elements does our mesh have?
-  char num_elems_var[FILENAME_MAX+1];
-  int cent;
-  switch(centering)
+  // Find the cells sent to each neighbor, preceded by their number.
+  int_ptr_unordered_map_t* sends = int_ptr_unordered_map_new();
+  int i = 0;
+  int num_sends = ex_array[i++];
+  for (int j = 0; j < num_sends; ++j)
   {
-    case POLYMESH_CELL: cent = DB_ZONECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name); break;
-    case POLYMESH_FACE: cent = DB_FACECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_faces", mesh_name); break;
-    case POLYMESH_EDGE: cent = DB_EDGECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_edges", mesh_name); break;
-    case POLYMESH_NODE: cent = DB_NODECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_nodes", mesh_name);
+    int proc = ex_array[i++];
+    int_ptr_unordered_map_insert(sends, proc, &ex_array[i]);
+    int num_indices = ex_array[i++];
+    i += num_indices;
   }
-  ASSERT(DBInqVarExists(file->dbfile, num_elems_var));
-  int num_elems;
-  DBReadVar(file->dbfile, num_elems_var, &num_elems);
 
-  // Create an optlist from our field metadata.
-  DBoptlist* optlist = optlist_from_metadata(md, component);
+  // Now match each ghost cell received from a neighbor with the face it
+  // shares with the corresponding sent cell.
+  int num_receives = ex_array[i++];
+  for (int j = 0; j < num_receives; ++j)
+  {
+    int proc = ex_array[i++];
+    int num_indices = ex_array[i++];
+    int* receive = &ex_array[i];
+    i += num_indices;
 
-  char var_name[FILENAME_MAX+1];
-  snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, mesh_name);
-  DBPutUcdvar1(file->dbfile, var_name, mesh_name, field_data, num_elems, NULL, 0, SILO_FLOAT_TYPE, cent, optlist);
+    int** send_p = (int**)int_ptr_unordered_map_get(sends, proc);
+    if ((send_p == NULL) || ((*send_p)[0] != num_indices))
+      polymec_error("silo_file_read_polymesh: Inconsistent parallel boundary with domain %d.", proc);
+    int* send = &((*send_p)[1]);
 
-#if POLYMEC_HAVE_MPI
-  // Add a subdomain entry for parallel environments.
-  if (file->nproc > 1)
-    silo_file_add_subdomain_field(file, mesh_name, field_name, DB_UCDVAR, optlist);
-#endif
+    int_array_t* faces = int_array_new();
+    int_array_resize(faces, num_indices);
+    for (int k = 0; k < num_indices; ++k)
+    {
+      int g = receive[k] - num_cells;
+      int face = -1;
+      for (int l = ghost_face_offsets[g]; l < ghost_face_offsets[g+1]; ++l)
+      {
+        if (mesh->face_cells[2*ghost_faces[l]] == send[k])
+        {
+          face = ghost_faces[l];
+          break;
+        }
+      }
+      if (face == -1)
+        polymec_error("silo_file_read_polymesh: Inconsistent parallel boundary with domain %d.", proc);
+      boundary->neighbors[face] = proc;
+      boundary->positions[face] = k;
+      faces->data[k] = face;
+    }
+    int_ptr_unordered_map_insert_with_v_dtor(boundary->faces, proc, faces, DTOR(int_array_free));
+  }
+  ASSERT(i == ex_size);
 
-  optlist_free(optlist);
-  silo_file_pop_dir(file);
+  // Clean up.
+  int_ptr_unordered_map_free(sends);
+  polymec_free(ghost_faces);
+  polymec_free(ghost_face_offsets);
 
-  STOP_FUNCTION_TIMER();
+  return boundary;
 }
 
-void silo_file_write_polymesh_field(silo_file_t* file,
-                                    const char* field_name,
-                                    const char* mesh_name,
-                                    polymesh_field_t* field)
+static void domain_boundary_free(domain_boundary_t* boundary)
 {
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_CLOBBER);
+  int_ptr_unordered_map_free(boundary->faces);
+  polymec_free(boundary->positions);
+  polymec_free(boundary->neighbors);
+  polymec_free(boundary);
+}
 
-  // How many elements does our mesh have?
-  silo_file_push_domain_dir(file);
-  char num_elems_var[FILENAME_MAX+1];
-  int cent;
-  switch(field->centering)
+// Appends the indices in the tags of the given tagger to the corresponding
+// arrays in the given map after mapping them through index_map, skipping
+// indices mapped to -1.
+static void append_mapped_tags(tagger_t* tagger,
+                               int* index_map,
+                               int index_offset,
+                               string_ptr_unordered_map_t* tag_indices)
+{
+  int pos = 0, *tag;
+  size_t tag_size;
+  char* tag_name;
+  while (tagger_next_tag(tagger, &pos, &tag_name, &tag, &tag_size))
   {
-    case POLYMESH_CELL: cent = DB_ZONECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name); break;
-    case POLYMESH_FACE: cent = DB_FACECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_faces", mesh_name); break;
-    case POLYMESH_EDGE: cent = DB_EDGECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_edges", mesh_name); break;
-    case POLYMESH_NODE: cent = DB_NODECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_nodes", mesh_name);
+    int_array_t** indices_p = (int_array_t**)string_ptr_unordered_map_get(tag_indices, tag_name);
+    int_array_t* indices;
+    if (indices_p != NULL)
+      indices = *indices_p;
+    else
+    {
+      indices = int_array_new();
+      string_ptr_unordered_map_insert_with_kv_dtors(tag_indices, string_dup(tag_name),
+                                                    indices, string_free, DTOR(int_array_free));
+    }
+    for (size_t i = 0; i < tag_size; ++i)
+    {
+      int index = (index_map != NULL) ? index_map[tag[i]] : index_offset + tag[i];
+      if (index != -1)
+        int_array_append(indices, index);
+    }
   }
-  ASSERT(DBInqVarExists(file->dbfile, num_elems_var));
-  int num_elems;
-  DBReadVar(file->dbfile, num_elems_var, &num_elems);
-  silo_file_pop_dir(file);
-
-  // Write the field metadata.
-  field_metadata_t* md = polymesh_field_metadata(field);
-  char md_name[FILENAME_MAX+1];
-  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
-  silo_file_write_field_metadata(file, md_name, md);
+}
 
-  DECLARE_POLYMESH_FIELD_ARRAY(field_data, field);
-  real_t* comp_data = polymec_malloc(sizeof(real_t) * num_elems);
-  for (int c = 0; c < field->num_components; ++c)
+// Creates tags in the given tagger from the arrays in the given map, removing
+// duplicate indices. Tags already in the tagger are left alone.
+static void create_mapped_tags(string_ptr_unordered_map_t* tag_indices,
+                               tagger_t* tagger)
+{
+  int pos = 0;
+  char* tag_name;
+  void* val;
+  while (string_ptr_unordered_map_next(tag_indices, &pos, &tag_name, &val))
   {
-    for (int i = 0; i < num_elems; ++i)
-      comp_data[i] = field_data[i][c];
-    silo_file_write_polymesh_field_comp(file, field_name, mesh_name, c,
-                                        field->centering, comp_data, md);
+    int_array_t* indices = val;
+    int_qsort(indices->data, indices->size);
+    size_t num_indices = 0;
+    for (size_t i = 0; i < indices->size; ++i)
+    {
+      if ((num_indices == 0) || (indices->data[i] != indices->data[num_indices-1]))
+        indices->data[num_indices++] = indices->data[i];
+    }
+    int* tag = tagger_create_tag(tagger, tag_name, num_indices);
+    if (tag != NULL)
+      memcpy(tag, indices->data, sizeof(int) * num_indices);
   }
-  polymec_free(comp_data);
-  STOP_FUNCTION_TIMER();
 }
 
-static bool silo_file_read_polymesh_field_comp(silo_file_t* file,
-                                               const char* field_name,
-                                               const char* mesh_name,
-                                               int component,
-                                               polymesh_centering_t centering,
-                                               real_t* field_data)
+// Orders ghost faces by the process that owns the neighboring cell, the
+// domains on either side, and the position of the face on the boundary
+// between those domains.
+static int ghost_face_cmp(const void* l, const void* r)
+{
+  const int* li = l;
+  const int* ri = r;
+  for (int i = 0; i < 4; ++i)
+  {
+    if (li[i] != ri[i])
+      return (li[i] < ri[i]) ? -1 : 1;
+  }
+  return 0;
+}
+
+// Returns the lowest-numbered node welded to the node n, given the
+// representatives of welded nodes.
+static int node_rep(int* reps, int n)
+{
+  while (reps[n] != n)
+  {
+    reps[n] = reps[reps[n]];
+    n = reps[n];
+  }
+  return n;
+}
+
+// Welds the nodes n1 and n2 (and the nodes welded to them) together.
+static void weld_nodes(int* reps, int n1, int n2)
+{
+  int r1 = node_rep(reps, n1), r2 = node_rep(reps, n2);
+  if (r1 < r2)
+    reps[r2] = r1;
+  else if (r2 < r1)
+    reps[r1] = r2;
+}
+
+// Reads a polymesh from a remapped file by stitching together the writing
+// processes' domains assigned to this process.
+static polymesh_t* read_remapped_polymesh(silo_file_t* file,
+                                          const char* mesh_name)
+{
+  int nprocs;
+  MPI_Comm_size(file->comm, &nprocs);
+  int first_domain = file->first_domain;
+  int num_domains = file->num_local_domains;
+
+  // Read the topology, parallel boundary, and tags of each of our domains.
+  polymesh_t* domains[MAX(num_domains, 1)];
+  domain_boundary_t* boundaries[MAX(num_domains, 1)];
+  tagger_t* cell_tags[MAX(num_domains, 1)];
+  tagger_t* face_tags[MAX(num_domains, 1)];
+  tagger_t* node_tags[MAX(num_domains, 1)];
+  int found = 1;
+  for (int m = 0; m < num_domains; ++m)
+  {
+    silo_file_set_domain(file, first_domain + m);
+    domains[m] = read_polymesh_topology(file, mesh_name, MPI_COMM_SELF);
+    if (domains[m] == NULL)
+    {
+      found = 0;
+      num_domains = m;
+      break;
+    }
+
+    char name[FILENAME_MAX+1];
+    snprintf(name, FILENAME_MAX, "%s_cell_exchanger", mesh_name);
+    size_t ex_size;
+    int* ex_array = silo_file_read_int_array(file, name, &ex_size);
+    boundaries[m] = domain_boundary_new(domains[m], ex_array, ex_size);
+    polymec_free(ex_array);
+
+    silo_file_push_domain_dir(file);
+    cell_tags[m] = tagger_new();
+    snprintf(name, FILENAME_MAX, "%s_cell_tags", mesh_name);
+    silo_file_read_tags(file, name, cell_tags[m]);
+    face_tags[m] = tagger_new();
+    snprintf(name, FILENAME_MAX, "%s_face_tags", mesh_name);
+    silo_file_read_tags(file, name, face_tags[m]);
+    node_tags[m] = tagger_new();
+    snprintf(name, FILENAME_MAX, "%s_node_tags", mesh_name);
+    silo_file_read_tags(file, name, node_tags[m]);
+    silo_file_pop_dir(file);
+  }
+  silo_file_reset_domain(file);
+  MPI_Allreduce(MPI_IN_PLACE, &found, 1, MPI_INT, MPI_MIN, file->comm);
+  if (found == 0)
+  {
+    for (int m = 0; m < num_domains; ++m)
+    {
+      polymesh_free(domains[m]);
+      domain_boundary_free(boundaries[m]);
+      tagger_free(cell_tags[m]);
+      tagger_free(face_tags[m]);
+      tagger_free(node_tags[m]);
+    }
+    return NULL;
+  }
+
+  remapped_polymesh_t* remap = polymec_malloc(sizeof(remapped_polymesh_t));
+  remap->num_domains = num_domains;
+  remap->cell_offsets = polymec_malloc(sizeof(int) * (num_domains+1));
+  remap->face_maps = polymec_malloc(sizeof(int*) * MAX(num_domains, 1));
+  remap->node_maps = polymec_malloc(sizeof(int*) * MAX(num_domains, 1));
+
+  // Cells are numbered consecutively by domain.
+  int node_offsets[num_domains+1];
+  remap->cell_offsets[0] = node_offsets[0] = 0;
+  for (int m = 0; m < num_domains; ++m)
+  {
+    remap->cell_offsets[m+1] = remap->cell_offsets[m] + domains[m]->num_cells;
+    node_offsets[m+1] = node_offsets[m] + domains[m]->num_nodes;
+  }
+  int num_cells = remap->cell_offsets[num_domains];
+
+  // Faces are numbered consecutively by domain, except that a face on the
+  // boundary between two of our domains is mapped to its twin in the
+  // lower-numbered one. Faces on the boundaries with other processes'
+  // domains border ghost cells.
+  int num_faces = 0, num_ghost_cells = 0;
+  for (int m = 0; m < num_domains; ++m)
+  {
+    int domain = first_domain + m;
+    polymesh_t* dmesh = domains[m];
+    domain_boundary_t* boundary = boundaries[m];
+    remap->face_maps[m] = polymec_malloc(sizeof(int) * MAX(dmesh->num_faces, 1));
+    for (int f = 0; f < dmesh->num_faces; ++f)
+    {
+      int neighbor = boundary->neighbors[f];
+      if ((neighbor >= first_domain) && (neighbor < domain))
+      {
+        int mn = neighbor - first_domain;
+        int_array_t** twins_p = (int_array_t**)int_ptr_unordered_map_get(boundaries[mn]->faces, domain);
+        if ((twins_p == NULL) || ((*twins_p)->size <= boundary->positions[f]))
+          polymec_error("silo_file_read_polymesh: Domains %d and %d have inconsistent boundaries.",
+                        neighbor, domain);
+        int twin = (*twins_p)->data[boundary->positions[f]];
+        remap->face_maps[m][f] = remap->face_maps[mn][twin];
+      }
+      else
+      {
+        remap->face_maps[m][f] = num_faces++;
+        if ((neighbor != -1) && ((neighbor < first_domain) ||
+                                 (neighbor >= first_domain + num_domains)))
+          ++num_ghost_cells;
+      }
+    }
+  }
+
+  // Nodes on the boundaries between our domains are welded together. Every
+  // set of welded nodes is represented by its lowest-numbered node.
+  int num_all_nodes = node_offsets[num_domains];
+  int* node_reps = polymec_malloc(sizeof(int) * MAX(num_all_nodes, 1));
+  for (int n = 0; n < num_all_nodes; ++n)
+    node_reps[n] = n;
+  if (num_domains > 1)
+  {
+    // A face shared by two of our domains was written by each of them, so
+    // we weld each node of a face to the node of its twin nearest to it.
+    // This depends only on the topology of the domains and not on any
+    // tolerance.
+    for (int m = 1; m < num_domains; ++m)
+    {
+      int domain = first_domain + m;
+      polymesh_t* dmesh = domains[m];
+      for (int f = 0; f < dmesh->num_faces; ++f)
+      {
+        int neighbor = boundaries[m]->neighbors[f];
+        if ((neighbor < first_domain) || (neighbor >= domain)) continue;
+        int mn = neighbor - first_domain;
+        polymesh_t* nmesh = domains[mn];
+        int_array_t** twins_p = (int_array_t**)int_ptr_unordered_map_get(boundaries[mn]->faces, domain);
+        int twin = (*twins_p)->data[boundaries[m]->positions[f]];
+        int begin = dmesh->face_node_offsets[f], end = dmesh->face_node_offsets[f+1];
+        int tbegin = nmesh->face_node_offsets[twin], tend = nmesh->face_node_offsets[twin+1];
+        if ((end - begin) != (tend - tbegin))
+          polymec_error("silo_file_read_polymesh: Domains %d and %d have inconsistent boundaries.",
+                        neighbor, domain);
+        for (int i = begin; i < end; ++i)
+        {
+          point_t* x = &dmesh->nodes[dmesh->face_nodes[i]];
+          int nearest = -1;
+          real_t d_min = REAL_MAX;
+          for (int j = tbegin; j < tend; ++j)
+          {
+            real_t d = point_distance(x, &nmesh->nodes[nmesh->face_nodes[j]]);
+            if (d < d_min)
+            {
+              d_min = d;
+              nearest = nmesh->face_nodes[j];
+            }
+          }
+          weld_nodes(node_reps, node_offsets[m] + dmesh->face_nodes[i],
+                     node_offsets[mn] + nearest);
+        }
+      }
+    }
+
+    // Domains that touch only along edges or at corners share no faces, so
+    // we weld nodes of such domains that lie within a tolerance of one
+    // another. The tolerance is 1e-3 of the shortest edge in our domains,
+    // which keeps it meaningful regardless of the mesh's units or
+    // resolution.
+    int_array_t* seam_nodes = int_array_new();
+    int_array_t* seam_domains = int_array_new();
+    bool* is_seam_node = polymec_calloc(MAX(num_all_nodes, 1), sizeof(bool));
+    real_t h_min = REAL_MAX;
+    for (int m = 0; m < num_domains; ++m)
+    {
+      polymesh_t* dmesh = domains[m];
+      for (int f = 0; f < dmesh->num_faces; ++f)
+      {
+        int begin = dmesh->face_node_offsets[f], end = dmesh->face_node_offsets[f+1];
+        for (int i = begin; i < end; ++i)
+        {
+          int j = (i+1 < end) ? i+1 : begin;
+          real_t h = point_distance(&dmesh->nodes[dmesh->face_nodes[i]],
+                                    &dmesh->nodes[dmesh->face_nodes[j]]);
+          if (h > 0.0)
+            h_min = MIN(h_min, h);
+        }
+
+        if (boundaries[m]->neighbors[f] == -1) continue;
+        for (int i = begin; i < end; ++i)
+        {
+          int n = node_offsets[m] + dmesh->face_nodes[i];
+          if (!is_seam_node[n])
+          {
+            is_seam_node[n] = true;
+            int_array_append(seam_nodes, n);
+            int_array_append(seam_domains, m);
+          }
+        }
+      }
+    }
+    polymec_free(is_seam_node);
+
+    point_t* xn = polymec_malloc(sizeof(point_t) * MAX(seam_nodes->size, 1));
+    for (size_t i = 0; i < seam_nodes->size; ++i)
+    {
+      int m = seam_domains->data[i];
+      xn[i] = domains[m]->nodes[seam_nodes->data[i] - node_offsets[m]];
+    }
+    kd_tree_t* node_tree = kd_tree_new(xn, seam_nodes->size);
+    real_t epsilon = 1e-3 * h_min;
+    for (size_t i = 0; i < seam_nodes->size; ++i)
+    {
+      int m = seam_domains->data[i];
+      int_array_t* near_nodes = kd_tree_within_radius(node_tree, &xn[i], epsilon);
+      for (size_t k = 0; k < near_nodes->size; ++k)
+      {
+        int mk = seam_domains->data[near_nodes->data[k]];
+        if ((mk != m) &&
+            !int_ptr_unordered_map_contains(boundaries[m]->faces, first_domain + mk))
+          weld_nodes(node_reps, seam_nodes->data[i], seam_nodes->data[near_nodes->data[k]]);
+      }
+      int_array_free(near_nodes);
+    }
+    kd_tree_free(node_tree);
+    polymec_free(xn);
+    int_array_free(seam_domains);
+    int_array_free(seam_nodes);
+  }
+  int num_nodes = 0;
+  int* node_indices = polymec_malloc(sizeof(int) * MAX(num_all_nodes, 1));
+  for (int n = 0; n < num_all_nodes; ++n)
+  {
+    int rep = node_rep(node_reps, n);
+    node_indices[n] = (rep == n) ? num_nodes++ : node_indices[rep];
+  }
+  polymec_free(node_reps);
+  for (int m = 0; m < num_domains; ++m)
+  {
+    remap->node_maps[m] = polymec_malloc(sizeof(int) * MAX(domains[m]->num_nodes, 1));
+    memcpy(remap->node_maps[m], &node_indices[node_offsets[m]],
+           sizeof(int) * domains[m]->num_nodes);
+  }
+  polymec_free(node_indices);
+
+  // Assemble the polymesh.
+  log_debug("silo_file_read_polymesh: Assembling polymesh (%d cells, %d faces, %d nodes) "
+            "from %d domains.", num_cells, num_faces, num_nodes, num_domains);
+  polymesh_t* mesh = polymesh_new(file->comm, num_cells, num_ghost_cells,
+                                  num_faces, num_nodes);
+  mesh->cell_face_offsets[0] = 0;
+  mesh->face_node_offsets[0] = 0;
+  for (int m = 0; m < num_domains; ++m)
+  {
+    polymesh_t* dmesh = domains[m];
+    for (int c = 0; c < dmesh->num_cells; ++c)
+    {
+      int cell = remap->cell_offsets[m] + c;
+      mesh->cell_face_offsets[cell+1] = mesh->cell_face_offsets[cell] +
+        dmesh->cell_face_offsets[c+1] - dmesh->cell_face_offsets[c];
+    }
+    for (int f = 0; f < dmesh->num_faces; ++f)
+    {
+      int neighbor = boundaries[m]->neighbors[f];
+      if ((neighbor < first_domain) || (neighbor >= first_domain + m))
+      {
+        int face = remap->face_maps[m][f];
+        mesh->face_node_offsets[face+1] = mesh->face_node_offsets[face] +
+          dmesh->face_node_offsets[f+1] - dmesh->face_node_offsets[f];
+      }
+    }
+  }
+  polymesh_reserve_connectivity_storage(mesh);
+
+  // Face cells, face nodes, and cell faces. The twin of a face is attached to
+  // the second cell of the face, for which the face is oriented opposite to
+  // its first cell.
+  bool* flipped = polymec_calloc(MAX(num_faces, 1), sizeof(bool));
+  int_array_t* ghost_faces = int_array_new();
+  for (int f = 0; f < num_faces; ++f)
+    mesh->face_cells[2*f] = mesh->face_cells[2*f+1] = -1;
+  for (int m = 0; m < num_domains; ++m)
+  {
+    int domain = first_domain + m;
+    polymesh_t* dmesh = domains[m];
+    int* face_map = remap->face_maps[m];
+    int cell_offset = remap->cell_offsets[m];
+    for (int f = 0; f < dmesh->num_faces; ++f)
+    {
+      int face = face_map[f];
+      int neighbor = boundaries[m]->neighbors[f];
+      bool is_twin = ((neighbor >= first_domain) && (neighbor < domain));
+      if (is_twin)
+        mesh->face_cells[2*face+1] = cell_offset + dmesh->face_cells[2*f];
+      else
+      {
+        mesh->face_cells[2*face] = cell_offset + dmesh->face_cells[2*f];
+        int c2 = dmesh->face_cells[2*f+1];
+        if ((c2 >= 0) && (c2 < dmesh->num_cells))
+          mesh->face_cells[2*face+1] = cell_offset + c2;
+        else if ((neighbor != -1) && ((neighbor < first_domain) ||
+                                      (neighbor >= first_domain + num_domains)))
+        {
+          // Record the face for assignment of ghost cells below.
+          int owner = (int)((((long)neighbor + 1) * nprocs - 1) / file->nproc);
+          int_array_append(ghost_faces, owner);
+          int_array_append(ghost_faces, MIN(domain, neighbor));
+          int_array_append(ghost_faces, MAX(domain, neighbor));
+          int_array_append(ghost_faces, boundaries[m]->positions[f]);
+          int_array_append(ghost_faces, face);
+        }
+        for (int i = 0; i < dmesh->face_node_offsets[f+1] - dmesh->face_node_offsets[f]; ++i)
+        {
+          int n = dmesh->face_nodes[dmesh->face_node_offsets[f] + i];
+          mesh->face_nodes[mesh->face_node_offsets[face] + i] = remap->node_maps[m][n];
+        }
+      }
+    }
+
+    for (int c = 0; c < dmesh->num_cells; ++c)
+    {
+      int cell = cell_offset + c;
+      for (int i = dmesh->cell_face_offsets[c]; i < dmesh->cell_face_offsets[c+1]; ++i)
+      {
+        int f = dmesh->cell_faces[i];
+        bool flip = (f < 0);
+        if (flip) f = ~f;
+        int face = face_map[f];
+        int neighbor = boundaries[m]->neighbors[f];
+        if ((neighbor >= first_domain) && (neighbor < domain))
+          flip = !flipped[face];
+        else if (dmesh->face_cells[2*f] == c)
+          flipped[face] = flip;
+        mesh->cell_faces[mesh->cell_face_offsets[cell] + i - dmesh->cell_face_offsets[c]] =
+          (flip) ? ~face : face;
+      }
+    }
+
+    for (int n = 0; n < dmesh->num_nodes; ++n)
+      mesh->nodes[remap->node_maps[m][n]] = dmesh->nodes[n];
+  }
+  polymec_free(flipped);
+
+  // Assign ghost cells to faces on boundaries with other processes, which
+  // order them the same way we do.
+  size_t num_ghost_faces = ghost_faces->size / 5;
+  ASSERT(num_ghost_faces == num_ghost_cells);
+  qsort(ghost_faces->data, num_ghost_faces, 5*sizeof(int), ghost_face_cmp);
+  exchanger_proc_map_t* send_map = exchanger_proc_map_new();
+  exchanger_proc_map_t* receive_map = exchanger_proc_map_new();
+  for (size_t i = 0; i < num_ghost_faces; ++i)
+  {
+    int proc = ghost_faces->data[5*i];
+    int face = ghost_faces->data[5*i+4];
+    int ghost = num_cells + (int)i;
+    mesh->face_cells[2*face+1] = ghost;
+    exchanger_proc_map_add_index(send_map, proc, mesh->face_cells[2*face]);
+    exchanger_proc_map_add_index(receive_map, proc, ghost);
+  }
+  int_array_free(ghost_faces);
+  exchanger_t* ex = polymesh_exchanger(mesh, POLYMESH_CELL);
+  exchanger_set_sends(ex, send_map);
+  exchanger_set_receives(ex, receive_map);
+
+  // Gather tags. Edges aren't assembled from domains, so edge tags are lost.
+  {
+    string_ptr_unordered_map_t* cell_tag_indices = string_ptr_unordered_map_new();
+    string_ptr_unordered_map_t* face_tag_indices = string_ptr_unordered_map_new();
+    string_ptr_unordered_map_t* node_tag_indices = string_ptr_unordered_map_new();
+    for (int m = 0; m < num_domains; ++m)
+    {
+      // Drop the twins of faces.
+      polymesh_t* dmesh = domains[m];
+      int* face_map = polymec_malloc(sizeof(int) * MAX(dmesh->num_faces, 1));
+      for (int f = 0; f < dmesh->num_faces; ++f)
+      {
+        int neighbor = boundaries[m]->neighbors[f];
+        bool is_twin = ((neighbor >= first_domain) && (neighbor < first_domain + m));
+        face_map[f] = (is_twin) ? -1 : remap->face_maps[m][f];
+      }
+      append_mapped_tags(cell_tags[m], NULL, remap->cell_offsets[m], cell_tag_indices);
+      append_mapped_tags(face_tags[m], face_map, 0, face_tag_indices);
+      append_mapped_tags(node_tags[m], remap->node_maps[m], 0, node_tag_indices);
+      polymec_free(face_map);
+    }
+    create_mapped_tags(cell_tag_indices, mesh->cell_tags);
+    create_mapped_tags(face_tag_indices, mesh->face_tags);
+    create_mapped_tags(node_tag_indices, mesh->node_tags);
+    string_ptr_unordered_map_free(cell_tag_indices);
+    string_ptr_unordered_map_free(face_tag_indices);
+    string_ptr_unordered_map_free(node_tag_indices);
+  }
+
+  // Finish constructing the mesh.
+  polymesh_construct_edges(mesh);
+  polymesh_compute_geometry(mesh);
+
+  // Stash the mappings for reading fields.
+  char remap_name[FILENAME_MAX+1];
+  snprintf(remap_name, FILENAME_MAX, "%s_remapped_polymesh", mesh_name);
+  string_ptr_unordered_map_insert_with_kv_dtors(file->scratch, string_dup(remap_name),
+                                                remap, string_free,
+                                                DTOR(remapped_polymesh_free));
+
+  // Clean up.
+  for (int m = 0; m < num_domains; ++m)
+  {
+    polymesh_free(domains[m]);
+    domain_boundary_free(boundaries[m]);
+    tagger_free(cell_tags[m]);
+    tagger_free(face_tags[m]);
+    tagger_free(node_tags[m]);
+  }
+
+  return mesh;
+}
+
+#endif
+
+polymesh_t* silo_file_read_polymesh(silo_file_t* file,
+                                    const char* mesh_name)
 {
   START_FUNCTION_TIMER();
   ASSERT(file->mode == DB_READ);
 
+#if POLYMEC_HAVE_MPI
+  if (file->remapped)
+  {
+    polymesh_t* mesh = read_remapped_polymesh(file, mesh_name);
+    STOP_FUNCTION_TIMER();
+    return mesh;
+  }
+  MPI_Comm comm = file->comm;
+#else
+  MPI_Comm comm = MPI_COMM_WORLD;
+#endif
+
+  polymesh_t* mesh = read_polymesh_topology(file, mesh_name, comm);
+  if (mesh == NULL)
+  {
+    STOP_FUNCTION_TIMER();
+    return NULL;
+  }
+
+  // Finish constructing the mesh.
+  polymesh_construct_edges(mesh);
+  polymesh_compute_geometry(mesh);
+
+  silo_file_push_domain_dir(file);
+
+  // Read in tag information.
+  {
+    char tag_name[FILENAME_MAX+1];
+    snprintf(tag_name, FILENAME_MAX, "%s_node_tags", mesh_name);
+    silo_file_read_tags(file, tag_name, mesh->node_tags);
+    snprintf(tag_name, FILENAME_MAX, "%s_edge_tags", mesh_name);
+    silo_file_read_tags(file, tag_name, mesh->edge_tags);
+    snprintf(tag_name, FILENAME_MAX, "%s_face_tags", mesh_name);
+    silo_file_read_tags(file, tag_name, mesh->face_tags);
+    snprintf(tag_name, FILENAME_MAX, "%s_cell_tags", mesh_name);
+    silo_file_read_tags(file, tag_name, mesh->cell_tags);
+  }
+
+  // Read in exchanger information.
+  {
+    char ex_name[FILENAME_MAX+1];
+    snprintf(ex_name, FILENAME_MAX, "%s_cell_exchanger", mesh_name);
+    polymesh_set_exchanger(mesh, POLYMESH_CELL, silo_file_read_exchanger(file, ex_name, mesh->comm));
+  }
+
+  silo_file_pop_dir(file);
+
+  STOP_FUNCTION_TIMER();
+  return mesh;
+}
+
+bool silo_file_contains_polymesh(silo_file_t* file, const char* mesh_name)
+{
+  bool result = false;
+  silo_file_push_domain_dir(file);
+  result = (DBInqVarExists(file->dbfile, mesh_name) &&
+            (DBInqVarType(file->dbfile, mesh_name) == DB_UCDMESH));
+  silo_file_pop_dir(file);
+  return result;
+}
+
+static void silo_file_write_polymesh_field_comp(silo_file_t* file,
+                                                const char* field_name,
+                                                const char* mesh_name,
+                                                int component,
+                                                polymesh_centering_t centering,
+                                                real_t* field_data,
+                                                field_metadata_t* md)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_CLOBBER);
+
   silo_file_push_domain_dir(file);
 
   // How many elements does our mesh have?
   char num_elems_var[FILENAME_MAX+1];
-  int cent = DB_ZONECENT;
+  int cent;
   switch(centering)
   {
     case POLYMESH_CELL: cent = DB_ZONECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name); break;
@@ -1771,44 +2775,37 @@ static bool silo_file_read_polymesh_field_comp(silo_file_t* file,
   int num_elems;
   DBReadVar(file->dbfile, num_elems_var, &num_elems);
 
+  // Create an optlist from our field metadata.
+  DBoptlist* optlist = optlist_from_metadata(md, component);
+
   char var_name[FILENAME_MAX+1];
   snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, mesh_name);
-  DBucdvar* var = DBGetUcdvar(file->dbfile, var_name);
-  if (var == NULL)
-  {
-    log_urgent("Component %d of field '%s' was not found in the Silo file.", component, field_name);
-    silo_file_pop_dir(file);
-    STOP_FUNCTION_TIMER();
-    return false;
-  }
-  if (var->centering != cent)
-  {
-    log_urgent("Field '%s' has the incorrect centering.", field_name);
-    silo_file_pop_dir(file);
-    STOP_FUNCTION_TIMER();
-    return false;
-  }
-  memcpy(field_data, var->vals[0], sizeof(real_t) * num_elems);
-  DBFreeUcdvar(var);
+  DBPutUcdvar1(file->dbfile, var_name, mesh_name, field_data, num_elems, NULL, 0, SILO_FLOAT_TYPE, cent, optlist);
+
+#if POLYMEC_HAVE_MPI
+  // Add a subdomain entry for parallel environments.
+  if (file->nproc > 1)
+    silo_file_add_subdomain_field(file, mesh_name, field_name, DB_UCDVAR, optlist);
+#endif
 
+  optlist_free(optlist);
   silo_file_pop_dir(file);
+
   STOP_FUNCTION_TIMER();
-  return true;
 }
 
-void silo_file_read_polymesh_field(silo_file_t* file,
-                                   const char* field_name,
-                                   const char* mesh_name,
-                                   polymesh_field_t* field)
+void silo_file_write_polymesh_field(silo_file_t* file,
+                                    const char* field_name,
+                                    const char* mesh_name,
+                                    polymesh_field_t* field)
 {
   START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_READ);
-
-  silo_file_push_domain_dir(file);
+  ASSERT(file->mode == DB_CLOBBER);
 
   // How many elements does our mesh have?
+  silo_file_push_domain_dir(file);
   char num_elems_var[FILENAME_MAX+1];
-  int cent = DB_ZONECENT;
+  int cent;
   switch(field->centering)
   {
     case POLYMESH_CELL: cent = DB_ZONECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name); break;
@@ -1819,24 +2816,198 @@ void silo_file_read_polymesh_field(silo_file_t* file,
   ASSERT(DBInqVarExists(file->dbfile, num_elems_var));
   int num_elems;
   DBReadVar(file->dbfile, num_elems_var, &num_elems);
-
   silo_file_pop_dir(file);
 
-  // Read the field metadata.
+  // Write the field metadata.
   field_metadata_t* md = polymesh_field_metadata(field);
   char md_name[FILENAME_MAX+1];
   snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
-  silo_file_read_field_metadata(file, md_name, md);
+  silo_file_write_field_metadata(file, md_name, md);
 
   DECLARE_POLYMESH_FIELD_ARRAY(field_data, field);
   real_t* comp_data = polymec_malloc(sizeof(real_t) * num_elems);
   for (int c = 0; c < field->num_components; ++c)
   {
-    silo_file_read_polymesh_field_comp(file, field_name, mesh_name, c, field->centering, comp_data);
     for (int i = 0; i < num_elems; ++i)
-      field_data[i][c] = comp_data[i];
-  }
-  polymec_free(comp_data);
+      comp_data[i] = field_data[i][c];
+    silo_file_write_polymesh_field_comp(file, field_name, mesh_name, c,
+                                        field->centering, comp_data, md);
+  }
+  polymec_free(comp_data);
+  STOP_FUNCTION_TIMER();
+}
+
+static bool silo_file_read_polymesh_field_comp(silo_file_t* file,
+                                               const char* field_name,
+                                               const char* mesh_name,
+                                               int component,
+                                               polymesh_centering_t centering,
+                                               real_t* field_data)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_READ);
+
+  silo_file_push_domain_dir(file);
+
+  // How many elements does our mesh have?
+  char num_elems_var[FILENAME_MAX+1];
+  int cent = DB_ZONECENT;
+  switch(centering)
+  {
+    case POLYMESH_CELL: cent = DB_ZONECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name); break;
+    case POLYMESH_FACE: cent = DB_FACECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_faces", mesh_name); break;
+    case POLYMESH_EDGE: cent = DB_EDGECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_edges", mesh_name); break;
+    case POLYMESH_NODE: cent = DB_NODECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_nodes", mesh_name);
+  }
+  ASSERT(DBInqVarExists(file->dbfile, num_elems_var));
+  int num_elems;
+  DBReadVar(file->dbfile, num_elems_var, &num_elems);
+
+  char var_name[FILENAME_MAX+1];
+  snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, mesh_name);
+  DBucdvar* var = DBGetUcdvar(file->dbfile, var_name);
+  if (var == NULL)
+  {
+    log_urgent("Component %d of field '%s' was not found in the Silo file.", component, field_name);
+    silo_file_pop_dir(file);
+    STOP_FUNCTION_TIMER();
+    return false;
+  }
+  if (var->centering != cent)
+  {
+    log_urgent("Field '%s' has the incorrect centering.", field_name);
+    silo_file_pop_dir(file);
+    STOP_FUNCTION_TIMER();
+    return false;
+  }
+  memcpy(field_data, var->vals[0], sizeof(real_t) * num_elems);
+  DBFreeUcdvar(var);
+
+  silo_file_pop_dir(file);
+  STOP_FUNCTION_TIMER();
+  return true;
+}
+
+#if POLYMEC_HAVE_MPI
+
+// Reads a field on a polymesh assembled from a remapped file.
+static void read_remapped_polymesh_field(silo_file_t* file,
+                                         const char* field_name,
+                                         const char* mesh_name,
+                                         polymesh_field_t* field)
+{
+  char remap_name[FILENAME_MAX+1];
+  snprintf(remap_name, FILENAME_MAX, "%s_remapped_polymesh", mesh_name);
+  remapped_polymesh_t** remap_p = (remapped_polymesh_t**)string_ptr_unordered_map_get(file->scratch, remap_name);
+  if (remap_p == NULL)
+  {
+    polymec_error("silo_file_read_polymesh_field: Polymesh '%s' must be read "
+                  "before its fields when the number of processes changes.", mesh_name);
+  }
+  if (field->centering == POLYMESH_EDGE)
+  {
+    polymec_error("silo_file_read_polymesh_field: Edge-centered fields can't be "
+                  "read when the number of processes changes.");
+  }
+  remapped_polymesh_t* remap = *remap_p;
+
+  // Read the field metadata.
+  field_metadata_t* md = polymesh_field_metadata(field);
+  char md_name[FILENAME_MAX+1];
+  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
+  silo_file_read_field_metadata(file, md_name, md);
+
+  // Read the field's data from each domain and map it into place.
+  DECLARE_POLYMESH_FIELD_ARRAY(field_data, field);
+  for (int m = 0; m < remap->num_domains; ++m)
+  {
+    silo_file_set_domain(file, file->first_domain + m);
+    silo_file_push_domain_dir(file);
+    char num_elems_var[FILENAME_MAX+1];
+    if (field->centering == POLYMESH_CELL)
+      snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name);
+    else if (field->centering == POLYMESH_FACE)
+      snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_faces", mesh_name);
+    else
+      snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_nodes", mesh_name);
+    ASSERT(DBInqVarExists(file->dbfile, num_elems_var));
+    int num_elems;
+    DBReadVar(file->dbfile, num_elems_var, &num_elems);
+    silo_file_pop_dir(file);
+
+    real_t* comp_data = polymec_malloc(sizeof(real_t) * MAX(num_elems, 1));
+    for (int c = 0; c < field->num_components; ++c)
+    {
+      silo_file_read_polymesh_field_comp(file, field_name, mesh_name, c, field->centering, comp_data);
+      for (int i = 0; i < num_elems; ++i)
+      {
+        int index;
+        if (field->centering == POLYMESH_CELL)
+          index = remap->cell_offsets[m] + i;
+        else if (field->centering == POLYMESH_FACE)
+          index = remap->face_maps[m][i];
+        else
+          index = remap->node_maps[m][i];
+        field_data[index][c] = comp_data[i];
+      }
+    }
+    polymec_free(comp_data);
+  }
+  silo_file_reset_domain(file);
+}
+
+#endif
+
+void silo_file_read_polymesh_field(silo_file_t* file,
+                                   const char* field_name,
+                                   const char* mesh_name,
+                                   polymesh_field_t* field)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_READ);
+
+#if POLYMEC_HAVE_MPI
+  if (file->remapped)
+  {
+    read_remapped_polymesh_field(file, field_name, mesh_name, field);
+    STOP_FUNCTION_TIMER();
+    return;
+  }
+#endif
+
+  silo_file_push_domain_dir(file);
+
+  // How many elements does our mesh have?
+  char num_elems_var[FILENAME_MAX+1];
+  int cent = DB_ZONECENT;
+  switch(field->centering)
+  {
+    case POLYMESH_CELL: cent = DB_ZONECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_cells", mesh_name); break;
+    case POLYMESH_FACE: cent = DB_FACECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_faces", mesh_name); break;
+    case POLYMESH_EDGE: cent = DB_EDGECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_edges", mesh_name); break;
+    case POLYMESH_NODE: cent = DB_NODECENT; snprintf(num_elems_var, FILENAME_MAX, "%s_mesh_num_nodes", mesh_name);
+  }
+  ASSERT(DBInqVarExists(file->dbfile, num_elems_var));
+  int num_elems;
+  DBReadVar(file->dbfile, num_elems_var, &num_elems);
+
+  silo_file_pop_dir(file);
+
+  // Read the field metadata.
+  field_metadata_t* md = polymesh_field_metadata(field);
+  char md_name[FILENAME_MAX+1];
+  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
+  silo_file_read_field_metadata(file, md_name, md);
+
+  DECLARE_POLYMESH_FIELD_ARRAY(field_data, field);
+  real_t* comp_data = polymec_malloc(sizeof(real_t) * num_elems);
+  for (int c = 0; c < field->num_components; ++c)
+  {
+    silo_file_read_polymesh_field_comp(file, field_name, mesh_name, c, field->centering, comp_data);
+    for (int i = 0; i < num_elems; ++i)
+      field_data[i][c] = comp_data[i];
+  }
+  polymec_free(comp_data);
   STOP_FUNCTION_TIMER();
 }
 
@@ -1914,12 +3085,126 @@ void silo_file_write_point_cloud(silo_file_t* file,
   STOP_FUNCTION_TIMER();
 }
 
+#if POLYMEC_HAVE_MPI
+
+// Returns the offsets of the points written by each domain within the
+// sequence of all points of the given point cloud in a remapped file,
+// computing and stashing them as needed.
+static int* remapped_point_cloud_offsets(silo_file_t* file,
+                                         const char* cloud_name)
+{
+  char offsets_name[FILENAME_MAX+1];
+  snprintf(offsets_name, FILENAME_MAX, "%s_remapped_offsets", cloud_name);
+  int** offsets_p = (int**)string_ptr_unordered_map_get(file->scratch, offsets_name);
+  if (offsets_p != NULL)
+    return *offsets_p;
+
+  // Read the number of points in each of our domains.
+  int num_points[MAX(file->num_local_domains, 1)];
+  char num_points_var[FILENAME_MAX+1];
+  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
+  for (int m = 0; m < file->num_local_domains; ++m)
+  {
+    silo_file_set_domain(file, file->first_domain + m);
+    silo_file_push_domain_dir(file);
+    ASSERT(DBInqVarExists(file->dbfile, num_points_var));
+    DBReadVar(file->dbfile, num_points_var, &num_points[m]);
+    silo_file_pop_dir(file);
+  }
+  silo_file_reset_domain(file);
+
+  // Share them with everyone.
+  int nprocs;
+  MPI_Comm_size(file->comm, &nprocs);
+  int num_proc_domains[nprocs], proc_domain_offsets[nprocs];
+  MPI_Allgather(&file->num_local_domains, 1, MPI_INT, num_proc_domains, 1, MPI_INT, file->comm);
+  MPI_Allgather(&file->first_domain, 1, MPI_INT, proc_domain_offsets, 1, MPI_INT, file->comm);
+  int* offsets = polymec_malloc(sizeof(int) * (file->nproc+1));
+  MPI_Allgatherv(num_points, file->num_local_domains, MPI_INT,
+                 &offsets[1], num_proc_domains, proc_domain_offsets,
+                 MPI_INT, file->comm);
+  offsets[0] = 0;
+  for (int d = 0; d < file->nproc; ++d)
+    offsets[d+1] += offsets[d];
+
+  string_ptr_unordered_map_insert_with_kv_dtors(file->scratch, string_dup(offsets_name),
+                                                offsets, string_free, polymec_free);
+  return offsets;
+}
+
+// Reads a point cloud from a remapped file, giving each process a
+// contiguous slice of all of its points.
+static point_cloud_t* read_remapped_point_cloud(silo_file_t* file,
+                                                const char* cloud_name)
+{
+  int* offsets = remapped_point_cloud_offsets(file, cloud_name);
+  int start, end;
+  silo_file_get_remapped_range(file, offsets[file->nproc], &start, &end);
+  point_cloud_t* cloud = point_cloud_new(file->comm, end - start);
+
+  // Read our points and tags from the domains that wrote them.
+  string_ptr_unordered_map_t* tag_indices = string_ptr_unordered_map_new();
+  for (int d = 0; d < file->nproc; ++d)
+  {
+    int p1 = MAX(start, offsets[d]), p2 = MIN(end, offsets[d+1]);
+    if (p1 >= p2) continue;
+
+    silo_file_set_domain(file, d);
+    silo_file_push_domain_dir(file);
+    DBpointmesh* pm = DBGetPointmesh(file->dbfile, (char*)cloud_name);
+    if (pm == NULL)
+    {
+      polymec_error("silo_file_read_point_cloud: Point mesh '%s' was not found "
+                    "in domain %d.", cloud_name, d);
+    }
+    for (int p = p1; p < p2; ++p)
+    {
+      cloud->points[p-start].x = ((real_t*)pm->coords[0])[p-offsets[d]];
+      cloud->points[p-start].y = ((real_t*)pm->coords[1])[p-offsets[d]];
+      cloud->points[p-start].z = ((real_t*)pm->coords[2])[p-offsets[d]];
+    }
+    DBFreePointmesh(pm);
+
+    tagger_t* tags = tagger_new();
+    char tag_name[FILENAME_MAX+1];
+    snprintf(tag_name, FILENAME_MAX, "%s_node_tags", cloud_name);
+    silo_file_read_tags(file, tag_name, tags);
+    int* point_map = polymec_malloc(sizeof(int) * MAX(offsets[d+1] - offsets[d], 1));
+    for (int p = offsets[d]; p < offsets[d+1]; ++p)
+      point_map[p-offsets[d]] = ((p >= p1) && (p < p2)) ? p - start : -1;
+    append_mapped_tags(tags, point_map, 0, tag_indices);
+    polymec_free(point_map);
+    tagger_free(tags);
+    silo_file_pop_dir(file);
+  }
+  silo_file_reset_domain(file);
+  create_mapped_tags(tag_indices, cloud->tags);
+  string_ptr_unordered_map_free(tag_indices);
+
+  return cloud;
+}
+
+#endif
+
 point_cloud_t* silo_file_read_point_cloud(silo_file_t* file,
                                           const char* cloud_name)
 {
   START_FUNCTION_TIMER();
   ASSERT(file->mode == DB_READ);
 
+#if POLYMEC_HAVE_MPI
+  if (file->remapped)
+  {
+    point_cloud_t* cloud = NULL;
+    if (silo_file_contains_point_cloud(file, cloud_name))
+      cloud = read_remapped_point_cloud(file, cloud_name);
+    else
+      log_urgent("Point mesh '%s' was not found in the Silo file.", cloud_name);
+    STOP_FUNCTION_TIMER();
+    return cloud;
+  }
+#endif
+
   silo_file_push_domain_dir(file);
 
   // How many points does our cloud have?
@@ -2205,455 +3490,1400 @@ bool silo_file_contains_planar_polymesh(silo_file_t* file,
   return result;
 }
 
-bool silo_file_contains_point_cloud(silo_file_t* file, const char* cloud_name)
+bool silo_file_contains_point_cloud(silo_file_t* file, const char* cloud_name)
+{
+  bool result = false;
+  silo_file_push_domain_dir(file);
+  result = (DBInqVarExists(file->dbfile, cloud_name) &&
+            (DBInqVarType(file->dbfile, cloud_name) == DB_POINTMESH));
+  silo_file_pop_dir(file);
+  return result;
+}
+
+static void silo_file_write_point_field_comp(silo_file_t* file,
+                                             const char* field_name,
+                                             const char* cloud_name,
+                                             int component,
+                                             real_t* field_data,
+                                             field_metadata_t* md)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_CLOBBER);
+
+  silo_file_push_domain_dir(file);
+
+  // How many points does our mesh have?
+  char num_points_var[FILENAME_MAX+1];
+  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
+  ASSERT(DBInqVarExists(file->dbfile, num_points_var));
+  int num_points;
+  DBReadVar(file->dbfile, num_points_var, &num_points);
+
+  DBoptlist* optlist = optlist_from_metadata(md, component);
+
+  // Write the field.
+  char var_name[FILENAME_MAX+1];
+  snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, cloud_name);
+  DBPutPointvar1(file->dbfile, var_name, cloud_name, field_data, num_points, SILO_FLOAT_TYPE, optlist);
+
+#if POLYMEC_HAVE_MPI
+  if (file->nproc > 1)
+    silo_file_add_subdomain_field(file, cloud_name, field_name, DB_POINTVAR, optlist);
+#endif
+  optlist_free(optlist);
+
+  silo_file_pop_dir(file);
+  STOP_FUNCTION_TIMER();
+}
+
+static bool silo_file_read_point_field_comp(silo_file_t* file,
+                                            const char* field_name,
+                                            const char* cloud_name,
+                                            int component,
+                                            real_t* field_data)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_READ);
+
+  silo_file_push_domain_dir(file);
+
+  char var_name[FILENAME_MAX+1];
+  snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, cloud_name);
+  DBmeshvar* var = DBGetPointvar(file->dbfile, var_name);
+  if (var == NULL)
+  {
+    log_urgent("Component %d of field '%s' was not found in the Silo file.",
+               component, field_name);
+    silo_file_pop_dir(file);
+    STOP_FUNCTION_TIMER();
+    return false;
+  }
+  memcpy(field_data, var->vals[0], sizeof(real_t) * var->nels);
+  DBFreePointvar(var);
+  silo_file_pop_dir(file);
+  STOP_FUNCTION_TIMER();
+  return true;
+}
+
+void silo_file_write_point_field(silo_file_t* file,
+                                 const char* field_name,
+                                 const char* cloud_name,
+                                 point_cloud_field_t* field)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_CLOBBER);
+
+  // How many points does our mesh have?
+  silo_file_push_domain_dir(file);
+
+  char num_points_var[FILENAME_MAX+1];
+  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
+  ASSERT(DBInqVarExists(file->dbfile, num_points_var));
+  int num_points;
+  DBReadVar(file->dbfile, num_points_var, &num_points);
+
+  silo_file_pop_dir(file);
+
+  // Write the field metadata.
+  field_metadata_t* md = point_cloud_field_metadata(field);
+  char md_name[FILENAME_MAX+1];
+  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
+  silo_file_write_field_metadata(file, md_name, md);
+
+  DECLARE_POINT_CLOUD_FIELD_ARRAY(field_data, field);
+  real_t* comp_data = polymec_malloc(sizeof(real_t) * MAX(num_points, 1));
+  for (int c = 0; c < field->num_components; ++c)
+  {
+    for (int i = 0; i < num_points; ++i)
+      comp_data[i] = field_data[i][c];
+    silo_file_write_point_field_comp(file, field_name, cloud_name, c,
+                                     comp_data, md);
+  }
+  polymec_free(comp_data);
+  STOP_FUNCTION_TIMER();
+}
+
+#if POLYMEC_HAVE_MPI
+
+// Reads a field on a point cloud read from a remapped file.
+static void read_remapped_point_field(silo_file_t* file,
+                                      const char* field_name,
+                                      const char* cloud_name,
+                                      point_cloud_field_t* field)
+{
+  // Read the field metadata.
+  field_metadata_t* md = point_cloud_field_metadata(field);
+  char md_name[FILENAME_MAX+1];
+  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
+  silo_file_read_field_metadata(file, md_name, md);
+
+  // Read our slice of the field from the domains that wrote it.
+  int* offsets = remapped_point_cloud_offsets(file, cloud_name);
+  int start, end;
+  silo_file_get_remapped_range(file, offsets[file->nproc], &start, &end);
+  ASSERT(field->num_local_values == (size_t)(end - start));
+  DECLARE_POINT_CLOUD_FIELD_ARRAY(field_data, field);
+  for (int d = 0; d < file->nproc; ++d)
+  {
+    int p1 = MAX(start, offsets[d]), p2 = MIN(end, offsets[d+1]);
+    if (p1 >= p2) continue;
+
+    silo_file_set_domain(file, d);
+    real_t* comp_data = polymec_malloc(sizeof(real_t) * (offsets[d+1] - offsets[d]));
+    for (int c = 0; c < field->num_components; ++c)
+    {
+      silo_file_read_point_field_comp(file, field_name, cloud_name, c, comp_data);
+      for (int p = p1; p < p2; ++p)
+        field_data[p-start][c] = comp_data[p-offsets[d]];
+    }
+    polymec_free(comp_data);
+  }
+  silo_file_reset_domain(file);
+}
+
+#endif
+
+void silo_file_read_point_field(silo_file_t* file,
+                                const char* field_name,
+                                const char* cloud_name,
+                                point_cloud_field_t* field)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(file->mode == DB_READ);
+
+#if POLYMEC_HAVE_MPI
+  if (file->remapped)
+  {
+    read_remapped_point_field(file, field_name, cloud_name, field);
+    STOP_FUNCTION_TIMER();
+    return;
+  }
+#endif
+
+  silo_file_push_domain_dir(file);
+
+  // How many points does our mesh have?
+  char num_points_var[FILENAME_MAX+1];
+  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
+  ASSERT(DBInqVarExists(file->dbfile, num_points_var));
+  int num_points;
+  DBReadVar(file->dbfile, num_points_var, &num_points);
+
+  // Read the field metadata.
+  field_metadata_t* md = point_cloud_field_metadata(field);
+  char md_name[FILENAME_MAX+1];
+  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
+  silo_file_read_field_metadata(file, md_name, md);
+
+  DECLARE_POINT_CLOUD_FIELD_ARRAY(field_data, field);
+  real_t* comp_data = polymec_malloc(sizeof(real_t) * MAX(num_points, 1));
+  for (int c = 0; c < field->num_components; ++c)
+  {
+    silo_file_read_point_field_comp(file, field_name, cloud_name, c, comp_data);
+    for (int i = 0; i < num_points; ++i)
+      field_data[i][c] = comp_data[i];
+  }
+  polymec_free(comp_data);
+
+  silo_file_pop_dir(file);
+
+  STOP_FUNCTION_TIMER();
+}
+
+bool silo_file_contains_point_field(silo_file_t* file,
+                                    const char* field_name,
+                                    const char* cloud_name)
+{
+  bool result = false;
+  if (silo_file_contains_point_cloud(file, cloud_name))  // point cloud exists...
+  {
+    // Look for the field's metadata array.
+    char md_name[FILENAME_MAX+1];
+    snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
+    result = silo_file_contains_field_metadata(file, md_name);
+  }
+  return result;
+}
+
+
+static void expression_dtor(char* key, void* val)
+{
+  string_free(key);
+  silo_expression_t* exp = val;
+  string_free(exp->definition);
+  polymec_free(exp);
+}
+
+void silo_file_write_scalar_expression(silo_file_t* file,
+                                       const char* expression_name,
+                                       const char* definition)
+
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  silo_expression_t* exp = polymec_malloc(sizeof(silo_expression_t));
+  exp->type = DB_VARTYPE_SCALAR;
+  exp->definition = string_dup(definition);
+  string_ptr_unordered_map_insert_with_kv_dtor(file->expressions,
+                                               string_dup(expression_name), exp,
+                                               expression_dtor);
+}
+
+void silo_file_write_vector_expression(silo_file_t* file,
+                                       const char* expression_name,
+                                       const char* definition)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  silo_expression_t* exp = polymec_malloc(sizeof(silo_expression_t));
+  exp->type = DB_VARTYPE_VECTOR;
+  exp->definition = string_dup(definition);
+  string_ptr_unordered_map_insert_with_kv_dtor(file->expressions,
+                                               string_dup(expression_name), exp,
+                                               expression_dtor);
+}
+
+void silo_file_write_tensor_expression(silo_file_t* file,
+                                       const char* expression_name,
+                                       const char* definition)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  silo_expression_t* exp = polymec_malloc(sizeof(silo_expression_t));
+  exp->type = DB_VARTYPE_TENSOR;
+  exp->definition = string_dup(definition);
+  string_ptr_unordered_map_insert_with_kv_dtor(file->expressions,
+                                               string_dup(expression_name), exp,
+                                               expression_dtor);
+}
+
+bool silo_file_contains_string(silo_file_t* file,
+                               const char* string_name)
+{
+  silo_file_push_domain_dir(file);
+  char name[FILENAME_MAX+1];
+  snprintf(name, FILENAME_MAX, "%s_string", string_name);
+  bool result = DBInqVarExists(file->dbfile, name);
+  silo_file_pop_dir(file);
+  return result;
+}
+
+void silo_file_write_string(silo_file_t* file,
+                            const char* string_name,
+                            char* string_data)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  ASSERT(string_data != NULL);
+
+  silo_file_push_domain_dir(file);
+
+  int string_size = (int)strlen(string_data);
+  if (string_size > 0)
+  {
+    char string_data_name[FILENAME_MAX+1];
+    snprintf(string_data_name, FILENAME_MAX, "%s_string", string_name);
+    int result = DBWrite(file->dbfile, string_data_name, string_data, &string_size, 1, DB_CHAR);
+    if (result != 0)
+      polymec_error("silo_file_write_string: write of string '%s' failed.", string_name);
+  }
+  silo_file_pop_dir(file);
+}
+
+char* silo_file_read_string(silo_file_t* file,
+                            const char* string_name)
+{
+  ASSERT(file->mode == DB_READ);
+
+  silo_file_push_domain_dir(file);
+
+  char string_data_name[FILENAME_MAX+1];
+  snprintf(string_data_name, FILENAME_MAX, "%s_string", string_name);
+  if (!DBInqVarExists(file->dbfile, string_data_name))
+  {
+    log_urgent("silo_file_read_string: Could not read string '%s'.", string_name);
+    silo_file_pop_dir(file);
+    return NULL;
+  }
+  int string_size = DBGetVarLength(file->dbfile, string_data_name);
+  char* string = polymec_malloc(sizeof(char) * (string_size + 1));
+  if (string_size > 0)
+    DBReadVar(file->dbfile, string_data_name, string);
+  string[string_size] = '\0';
+  silo_file_pop_dir(file);
+  return string;
+}
+
+void silo_file_write_real_array(silo_file_t* file,
+                                const char* array_name,
+                                real_t* array_data,
+                                size_t array_size)
+{
+  silo_file_write_object_real_array(file, array_name, array_name,
+                                    array_data, array_size);
+}
+
+void silo_file_write_object_real_array(silo_file_t* file,
+                                       const char* object_name,
+                                       const char* array_name,
+                                       real_t* array_data,
+                                       size_t array_size)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  ASSERT(array_data != NULL);
+
+  silo_file_push_domain_dir(file);
+
+  if (array_size > 0)
+  {
+    char real_array_name[FILENAME_MAX+1];
+    snprintf(real_array_name, FILENAME_MAX, "%s_real_array", array_name);
+    silo_file_write_compressed_reals(file, object_name, real_array_name,
+                                     array_data, array_size);
+  }
+  silo_file_pop_dir(file);
+}
+
+real_t* silo_file_read_real_array(silo_file_t* file,
+                                  const char* array_name,
+                                  size_t* array_size)
+{
+  ASSERT(file->mode == DB_READ);
+  ASSERT(array_size != NULL);
+
+  silo_file_push_domain_dir(file);
+
+  char real_array_name[FILENAME_MAX+1];
+  snprintf(real_array_name, FILENAME_MAX, "%s_real_array", array_name);
+  real_t* result = NULL;
+  if (!silo_file_contains_compressed_reals(file, real_array_name))
+  {
+    log_urgent("silo_file_read_real_array: Could not read array '%s'.", array_name);
+    silo_file_pop_dir(file);
+    return NULL;
+  }
+  result = silo_file_read_compressed_reals(file, real_array_name, array_size);
+  if (*array_size == 0)
+  {
+    polymec_free(result);
+    result = NULL;
+  }
+  silo_file_pop_dir(file);
+  return result;
+}
+
+void silo_file_write_int_array(silo_file_t* file,
+                               const char* array_name,
+                               int* array_data,
+                               size_t array_size)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  ASSERT(array_data != NULL);
+
+  silo_file_push_domain_dir(file);
+
+  if (array_size > 0)
+  {
+    char int_array_name[FILENAME_MAX+1];
+    snprintf(int_array_name, FILENAME_MAX, "%s_int_array", array_name);
+    silo_file_write_var(file, int_array_name, array_data, (int)array_size, DB_INT);
+  }
+  silo_file_pop_dir(file);
+}
+
+int* silo_file_read_int_array(silo_file_t* file,
+                              const char* array_name,
+                              size_t* array_size)
+{
+  ASSERT(file->mode == DB_READ);
+  ASSERT(array_size != NULL);
+
+  silo_file_push_domain_dir(file);
+
+  char int_array_name[FILENAME_MAX+1];
+  snprintf(int_array_name, FILENAME_MAX, "%s_int_array", array_name);
+  int* result = NULL;
+  if (!silo_file_contains_var(file, int_array_name))
+  {
+    log_urgent("silo_file_read_int_array: Could not read array '%s'.", array_name);
+    silo_file_pop_dir(file);
+    return NULL;
+  }
+  *array_size = (size_t)silo_file_var_length(file, int_array_name);
+  if (*array_size > 0)
+  {
+    int* array = polymec_malloc(sizeof(int) * *array_size);
+    silo_file_read_var(file, int_array_name, array);
+    result = array;
+  }
+  silo_file_pop_dir(file);
+  return result;
+}
+
+MPI_Comm silo_file_comm(silo_file_t* file)
+{
+  return file->comm;
+}
+
+DBfile* silo_file_dbfile(silo_file_t* file)
+{
+  return file->dbfile;
+}
+
+void silo_file_add_subdomain_mesh(silo_file_t* file,
+                                  const char* mesh_name,
+                                  int silo_mesh_type,
+                                  DBoptlist* optlist)
+{
+#if POLYMEC_HAVE_MPI
+  ASSERT(file->mode == DB_CLOBBER);
+
+  if (file->nproc > 1)
+  {
+    subdomain_mesh_t* mesh = subdomain_mesh_new(mesh_name, silo_mesh_type, optlist);
+    ptr_array_append_with_dtor(file->subdomain_meshes, mesh, DTOR(subdomain_mesh_free));
+  }
+#endif
+}
+
+void silo_file_add_subdomain_field(silo_file_t* file,
+                                   const char* mesh_name,
+                                   const char* field_name,
+                                   int silo_var_type,
+                                   DBoptlist* optlist)
+{
+#if POLYMEC_HAVE_MPI
+  ASSERT((file->mode == DB_CLOBBER) || (file->mode == DB_APPEND));
+
+  if (file->nproc > 1)
+  {
+    subdomain_field_t* field = subdomain_field_new(mesh_name, field_name, silo_var_type, optlist);
+    ptr_array_append_with_dtor(file->subdomain_fields, field, DTOR(subdomain_field_free));
+  }
+#endif
+}
+
+void silo_file_push_dir(silo_file_t* file, const char* dir)
 {
-  bool result = false;
-  silo_file_push_domain_dir(file);
-  result = (DBInqVarExists(file->dbfile, cloud_name) &&
-            (DBInqVarType(file->dbfile, cloud_name) == DB_POINTMESH));
-  silo_file_pop_dir(file);
-  return result;
+  if (file->dirs == NULL)
+    file->dirs = string_slist_new();
+
+  // Set the new directory and push it onto the stack.
+  DBSetDir(file->dbfile, dir);
+  string_slist_push_with_dtor(file->dirs, string_dup(dir), string_free);
 }
 
-static void silo_file_write_point_field_comp(silo_file_t* file,
-                                             const char* field_name,
-                                             const char* cloud_name,
-                                             int component,
-                                             real_t* field_data,
-                                             field_metadata_t* md)
+void silo_file_push_domain_dir(silo_file_t* file)
 {
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_CLOBBER);
-
-  silo_file_push_domain_dir(file);
-
-  // How many points does our mesh have?
-  char num_points_var[FILENAME_MAX+1];
-  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
-  ASSERT(DBInqVarExists(file->dbfile, num_points_var));
-  int num_points;
-  DBReadVar(file->dbfile, num_points_var, &num_points);
-
-  DBoptlist* optlist = optlist_from_metadata(md, component);
-
-  // Write the field.
-  char var_name[FILENAME_MAX+1];
-  snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, cloud_name);
-  DBPutPointvar1(file->dbfile, var_name, cloud_name, field_data, num_points, SILO_FLOAT_TYPE, optlist);
-
 #if POLYMEC_HAVE_MPI
+  // Determine the domain directory.
+  char domain_dir[FILENAME_MAX+1];
   if (file->nproc > 1)
-    silo_file_add_subdomain_field(file, cloud_name, field_name, DB_POINTVAR, optlist);
+  {
+    snprintf(domain_dir, FILENAME_MAX, "/domain_%d", file->rank_in_group);
+    DBSetDir(file->dbfile, domain_dir);
+  }
+  else
+    sprintf(domain_dir, "/");
+  silo_file_push_dir(file, domain_dir);
+#else
+  silo_file_push_dir(file, "/");
 #endif
-  optlist_free(optlist);
-
-  silo_file_pop_dir(file);
-  STOP_FUNCTION_TIMER();
 }
 
-static bool silo_file_read_point_field_comp(silo_file_t* file,
-                                            const char* field_name,
-                                            const char* cloud_name,
-                                            int component,
-                                            real_t* field_data)
+bool silo_file_is_remapped(silo_file_t* file)
 {
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_READ);
+#if POLYMEC_HAVE_MPI
+  return file->remapped;
+#else
+  return false;
+#endif
+}
 
-  silo_file_push_domain_dir(file);
+void silo_file_get_domains(silo_file_t* file,
+                           int* num_domains,
+                           int* first_local_domain,
+                           int* num_local_domains)
+{
+#if POLYMEC_HAVE_MPI
+  *num_domains = file->nproc;
+  *first_local_domain = file->first_domain;
+  *num_local_domains = file->num_local_domains;
+#else
+  *num_domains = 1;
+  *first_local_domain = 0;
+  *num_local_domains = 1;
+#endif
+}
 
-  char var_name[FILENAME_MAX+1];
-  snprintf(var_name, FILENAME_MAX, "%s_%d_%s", field_name, component, cloud_name);
-  DBmeshvar* var = DBGetPointvar(file->dbfile, var_name);
-  if (var == NULL)
+void silo_file_set_domain(silo_file_t* file, int domain)
+{
+#if POLYMEC_HAVE_MPI
+  ASSERT(file->remapped);
+  int group_rank, rank_in_group;
+  get_domain_group(file, domain, &group_rank, &rank_in_group);
+  if (group_rank != file->group_rank)
   {
-    log_urgent("Component %d of field '%s' was not found in the Silo file.",
-               component, field_name);
-    silo_file_pop_dir(file);
-    STOP_FUNCTION_TIMER();
-    return false;
+    if (!open_group_file(file, group_rank))
+      polymec_error("silo_file_set_domain: Could not open %s.", file->filename);
+    if (file->dirs != NULL)
+      DBSetDir(file->dbfile, file->dirs->front->value);
   }
-  memcpy(field_data, var->vals[0], sizeof(real_t) * var->nels);
-  DBFreePointvar(var);
-  silo_file_pop_dir(file);
-  STOP_FUNCTION_TIMER();
-  return true;
+  file->domain = domain;
+  file->rank_in_group = rank_in_group;
+#endif
 }
 
-void silo_file_write_point_field(silo_file_t* file,
-                                 const char* field_name,
-                                 const char* cloud_name,
-                                 point_cloud_field_t* field)
+void silo_file_reset_domain(silo_file_t* file)
 {
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_CLOBBER);
-
-  // How many points does our mesh have?
-  silo_file_push_domain_dir(file);
-
-  char num_points_var[FILENAME_MAX+1];
-  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
-  ASSERT(DBInqVarExists(file->dbfile, num_points_var));
-  int num_points;
-  DBReadVar(file->dbfile, num_points_var, &num_points);
+#if POLYMEC_HAVE_MPI
+  if (file->remapped && (file->domain != file->primary_domain))
+    silo_file_set_domain(file, file->primary_domain);
+#endif
+}
 
-  silo_file_pop_dir(file);
+void silo_file_get_remapped_range(silo_file_t* file,
+                                  int num_items,
+                                  int* start,
+                                  int* end)
+{
+#if POLYMEC_HAVE_MPI
+  int rank, nprocs;
+  MPI_Comm_rank(file->comm, &rank);
+  MPI_Comm_size(file->comm, &nprocs);
+  *start = (int)(((long)rank * num_items) / nprocs);
+  *end = (int)(((long)(rank+1) * num_items) / nprocs);
+#else
+  *start = 0;
+  *end = num_items;
+#endif
+}
 
-  // Write the field metadata.
-  field_metadata_t* md = point_cloud_field_metadata(field);
-  char md_name[FILENAME_MAX+1];
-  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
-  silo_file_write_field_metadata(file, md_name, md);
+int_array_t* silo_file_gather_domain_tuples(silo_file_t* file,
+                                            const char* array_name,
+                                            int tuple_size)
+{
+  START_FUNCTION_TIMER();
+  int num_domains, first_domain, num_local_domains;
+  silo_file_get_domains(file, &num_domains, &first_domain, &num_local_domains);
 
-  DECLARE_POINT_CLOUD_FIELD_ARRAY(field_data, field);
-  for (int c = 0; c < field->num_components; ++c)
+  // Read the tuples from our local domains, tagging each with its domain.
+  int_array_t* local_tuples = int_array_new();
+  for (int d = first_domain; d < first_domain + num_local_domains; ++d)
   {
-    silo_file_write_point_field_comp(file, field_name, cloud_name, c,
-                                     (real_t*)(field_data[c]), md);
+    if (silo_file_is_remapped(file))
+      silo_file_set_domain(file, d);
+    size_t size = 0;
+    int* array = silo_file_read_int_array(file, array_name, &size);
+    ASSERT((size % tuple_size) == 0);
+    for (size_t i = 0; i < size/tuple_size; ++i)
+    {
+      for (int j = 0; j < tuple_size; ++j)
+        int_array_append(local_tuples, array[tuple_size*i+j]);
+      int_array_append(local_tuples, d);
+    }
+    if (array != NULL)
+      polymec_free(array);
   }
+  silo_file_reset_domain(file);
+
+#if POLYMEC_HAVE_MPI
+  // Share them with everyone. Domains are assigned to processes in
+  // ascending order, so the gathered tuples are ordered by domain.
+  int nprocs;
+  MPI_Comm_size(file->comm, &nprocs);
+  int num_local_values = (int)local_tuples->size;
+  int num_values[nprocs], offsets[nprocs+1];
+  MPI_Allgather(&num_local_values, 1, MPI_INT, num_values, 1, MPI_INT, file->comm);
+  offsets[0] = 0;
+  for (int p = 0; p < nprocs; ++p)
+    offsets[p+1] = offsets[p] + num_values[p];
+  int_array_t* tuples = int_array_new();
+  int_array_resize(tuples, offsets[nprocs]);
+  MPI_Allgatherv(local_tuples->data, num_local_values, MPI_INT,
+                 tuples->data, num_values, offsets, MPI_INT, file->comm);
+  int_array_free(local_tuples);
+  STOP_FUNCTION_TIMER();
+  return tuples;
+#else
   STOP_FUNCTION_TIMER();
+  return local_tuples;
+#endif
 }
 
-void silo_file_read_point_field(silo_file_t* file,
-                                const char* field_name,
-                                const char* cloud_name,
-                                point_cloud_field_t* field)
+void silo_file_pop_dir(silo_file_t* file)
 {
-  START_FUNCTION_TIMER();
-  ASSERT(file->mode == DB_READ);
-
-  silo_file_push_domain_dir(file);
+  ASSERT(!string_slist_empty(file->dirs));
 
-  // How many points does our mesh have?
-  char num_points_var[FILENAME_MAX+1];
-  snprintf(num_points_var, FILENAME_MAX, "%s_num_points", cloud_name);
-  ASSERT(DBInqVarExists(file->dbfile, num_points_var));
-  int num_points;
-  DBReadVar(file->dbfile, num_points_var, &num_points);
+  // Pop the current directory off the stack and delete it.
+  char* dir = string_slist_pop(file->dirs, NULL);
+  string_free(dir);
 
-  // Read the field metadata.
-  field_metadata_t* md = point_cloud_field_metadata(field);
-  char md_name[FILENAME_MAX+1];
-  snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
-  silo_file_read_field_metadata(file, md_name, md);
+  // Set the directory to the front of the stack.
+  DBSetDir(file->dbfile, file->dirs->front->value);
+}
 
-  DECLARE_POINT_CLOUD_FIELD_ARRAY(field_data, field);
-  for (int c = 0; c < field->num_components; ++c)
-    silo_file_read_point_field_comp(file, field_name, cloud_name, c, (real_t*)(field_data[c]));
+string_ptr_unordered_map_t* silo_file_scratch(silo_file_t* file)
+{
+  return file->scratch;
+}
 
-  silo_file_pop_dir(file);
+void silo_file_aggregate_unimesh_fields(silo_file_t* file,
+                                        bool aggregate,
+                                        bool write_patch_views)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  file->aggregate_unimesh_fields = aggregate;
+  file->write_unimesh_patch_views = write_patch_views;
+}
 
-  STOP_FUNCTION_TIMER();
+bool silo_file_aggregates_unimesh_fields(silo_file_t* file,
+                                         bool* write_patch_views)
+{
+  *write_patch_views = file->write_unimesh_patch_views;
+  return file->aggregate_unimesh_fields;
 }
 
-bool silo_file_contains_point_field(silo_file_t* file,
-                                    const char* field_name,
-                                    const char* cloud_name)
+// Compression policy for an object.
+typedef struct
 {
-  bool result = false;
-  if (silo_file_contains_point_cloud(file, cloud_name))  // point cloud exists...
+  silo_compression_t method;
+  real_t error_bound;
+} compression_policy_t;
+
+void silo_file_set_compression(silo_file_t* file,
+                               const char* object_name,
+                               silo_compression_t method,
+                               real_t error_bound)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  ASSERT((method != SILO_COMPRESSION_LOSSY) || (error_bound > 0.0));
+  if (object_name == NULL)
   {
-    // Look for the field's metadata array.
-    char md_name[FILENAME_MAX+1];
-    snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, cloud_name);
-    result = silo_file_contains_field_metadata(file, md_name);
+    file->default_compression = method;
+    file->default_error_bound = error_bound;
+  }
+  else
+  {
+    compression_policy_t* policy = polymec_malloc(sizeof(compression_policy_t));
+    policy->method = method;
+    policy->error_bound = error_bound;
+    string_ptr_unordered_map_insert_with_kv_dtors(file->compression,
+                                                  string_dup(object_name),
+                                                  policy, string_free,
+                                                  polymec_free);
   }
-  return result;
 }
 
-
-static void expression_dtor(char* key, void* val)
+void silo_file_get_compression(silo_file_t* file,
+                               const char* object_name,
+                               silo_compression_t* method,
+                               real_t* error_bound)
 {
-  string_free(key);
-  silo_expression_t* exp = val;
-  string_free(exp->definition);
-  polymec_free(exp);
+  compression_policy_t** policy_p =
+    (compression_policy_t**)string_ptr_unordered_map_get(file->compression, (char*)object_name);
+  if (policy_p != NULL)
+  {
+    *method = (*policy_p)->method;
+    *error_bound = (*policy_p)->error_bound;
+  }
+  else
+  {
+    *method = file->default_compression;
+    *error_bound = file->default_error_bound;
+  }
 }
 
-void silo_file_write_scalar_expression(silo_file_t* file,
-                                       const char* expression_name,
-                                       const char* definition)
-
+void silo_file_enable_collective_io(silo_file_t* file,
+                                    int num_aggregators)
 {
   ASSERT(file->mode == DB_CLOBBER);
-  silo_expression_t* exp = polymec_malloc(sizeof(silo_expression_t));
-  exp->type = DB_VARTYPE_SCALAR;
-  exp->definition = string_dup(definition);
-  string_ptr_unordered_map_insert_with_kv_dtor(file->expressions,
-                                               string_dup(expression_name), exp,
-                                               expression_dtor);
+  ASSERT(num_aggregators >= 0);
+#if POLYMEC_HAVE_MPI
+  file->collective_io = true;
+  file->num_aggregators = num_aggregators;
+#else
+  log_debug("silo_file_enable_collective_io: Ignored without MPI.");
+#endif
 }
 
-void silo_file_write_vector_expression(silo_file_t* file,
-                                       const char* expression_name,
-                                       const char* definition)
+// Returns the number of bytes in a value of the given Silo datatype.
+static size_t silo_datatype_size(int datatype)
 {
-  ASSERT(file->mode == DB_CLOBBER);
-  silo_expression_t* exp = polymec_malloc(sizeof(silo_expression_t));
-  exp->type = DB_VARTYPE_VECTOR;
-  exp->definition = string_dup(definition);
-  string_ptr_unordered_map_insert_with_kv_dtor(file->expressions,
-                                               string_dup(expression_name), exp,
-                                               expression_dtor);
+  if (datatype == DB_CHAR)
+    return sizeof(char);
+  else if (datatype == DB_INT)
+    return sizeof(int);
+  else if (datatype == DB_LONG)
+    return sizeof(long);
+  else if (datatype == DB_LONG_LONG)
+    return sizeof(long long);
+  else if (datatype == DB_FLOAT)
+    return sizeof(float);
+  else
+  {
+    ASSERT(datatype == DB_DOUBLE);
+    return sizeof(double);
+  }
 }
 
-void silo_file_write_tensor_expression(silo_file_t* file,
-                                       const char* expression_name,
-                                       const char* definition)
+// Stages the given data for the shared file, aligning it to the given
+// number of bytes within this process's segment, and records its location
+// in an index entry in the current directory.
+static void stage_var(silo_file_t* file,
+                      const char* var_name,
+                      void* data,
+                      size_t size,
+                      int datatype,
+                      size_t alignment)
 {
-  ASSERT(file->mode == DB_CLOBBER);
-  silo_expression_t* exp = polymec_malloc(sizeof(silo_expression_t));
-  exp->type = DB_VARTYPE_TENSOR;
-  exp->definition = string_dup(definition);
-  string_ptr_unordered_map_insert_with_kv_dtor(file->expressions,
-                                               string_dup(expression_name), exp,
-                                               expression_dtor);
+  size_t num_bytes = silo_datatype_size(datatype) * size;
+  size_t offset = alignment * ((file->staged_size + alignment - 1) / alignment);
+  size_t padded_size = sizeof(int64_t) * ((num_bytes + sizeof(int64_t) - 1) / sizeof(int64_t));
+  if (offset + padded_size > file->staged_capacity)
+  {
+    file->staged_capacity = MAX(2 * file->staged_capacity, offset + padded_size);
+    file->staged_data = polymec_realloc(file->staged_data, file->staged_capacity);
+  }
+  memset(&file->staged_data[file->staged_size], 0, offset - file->staged_size);
+  memcpy(&file->staged_data[offset], data, num_bytes);
+  memset(&file->staged_data[offset + num_bytes], 0, padded_size - num_bytes);
+  file->staged_size = offset + padded_size;
+
+  // Record where the data lives within this process's segment.
+  long long index[3] = {(long long)offset, (long long)size, datatype};
+  char index_name[FILENAME_MAX+1];
+  snprintf(index_name, FILENAME_MAX, "%s_mpiio", var_name);
+  int three = 3;
+  if (DBWrite(file->dbfile, index_name, index, &three, 1, DB_LONG_LONG) != 0)
+    polymec_error("silo_file: write of '%s' failed.", var_name);
 }
 
-bool silo_file_contains_string(silo_file_t* file,
-                               const char* string_name)
+// Writes the given data to the variable with the given name as is.
+static void write_plain_var(silo_file_t* file,
+                            const char* var_name,
+                            void* data,
+                            int size,
+                            int datatype)
 {
-  silo_file_push_domain_dir(file);
-  char name[FILENAME_MAX+1];
-  snprintf(name, FILENAME_MAX, "%s_string", string_name);
-  bool result = DBInqVarExists(file->dbfile, name);
-  silo_file_pop_dir(file);
-  return result;
+  if (file->collective_io)
+    stage_var(file, var_name, data, (size_t)size, datatype, sizeof(int64_t));
+  else if (DBWrite(file->dbfile, var_name, data, &size, 1, datatype) != 0)
+    polymec_error("silo_file: write of '%s' failed.", var_name);
 }
 
-void silo_file_write_string(silo_file_t* file,
-                            const char* string_name,
-                            char* string_data)
+// A write history records, for each variable written incrementally to a 
+// data set on this process, a digest of each block of its data and the step
+// whose file stores that block.
+typedef struct
 {
-  ASSERT(file->mode == DB_CLOBBER);
-  ASSERT(string_data != NULL);
+  int datatype;
+  size_t size, block_size;
+  int num_blocks;
+  uint8_t* block_digests;
+  int* block_steps;
+} incremental_var_t;
+
+struct silo_write_history_t
+{
+  // The data set (directory/prefix) whose steps are recorded.
+  char data_set[2*FILENAME_MAX+2];
+
+  // Variables, keyed by their Silo directory and name.
+  string_ptr_unordered_map_t* vars;
+};
+
+silo_write_history_t* silo_write_history_new()
+{
+  silo_write_history_t* history = polymec_malloc(sizeof(silo_write_history_t));
+  history->data_set[0] = '\0';
+  history->vars = string_ptr_unordered_map_new();
+  return history;
+}
 
-  silo_file_push_domain_dir(file);
+void silo_write_history_free(silo_write_history_t* history)
+{
+  string_ptr_unordered_map_free(history->vars);
+  polymec_free(history);
+}
 
-  int string_size = (int)strlen(string_data);
-  if (string_size > 0)
+void silo_file_enable_incremental_writes(silo_file_t* file,
+                                         silo_write_history_t* history,
+                                         bool block_deltas)
+{
+  ASSERT(file->mode == DB_CLOBBER);
+  ASSERT(history != NULL);
+
+  // A history records the steps of exactly one data set.
+  char data_set[2*FILENAME_MAX+2];
+  snprintf(data_set, 2*FILENAME_MAX+1, "%s/%s", file->directory, file->prefix);
+  if (history->data_set[0] == '\0')
+    strcpy(history->data_set, data_set);
+  else if (strcmp(history->data_set, data_set) != 0)
   {
-    char string_data_name[FILENAME_MAX+1];
-    snprintf(string_data_name, FILENAME_MAX, "%s_string", string_name);
-    int result = DBWrite(file->dbfile, string_data_name, string_data, &string_size, 1, DB_CHAR);
-    if (result != 0)
-      polymec_error("silo_file_write_string: write of string '%s' failed.", string_name);
+    polymec_error("silo_file_enable_incremental_writes: history for %s can't "
+                  "be used with %s.", history->data_set, data_set);
   }
-  silo_file_pop_dir(file);
+
+  file->incremental = true;
+  file->block_deltas = block_deltas;
+  file->history = history;
 }
 
-char* silo_file_read_string(silo_file_t* file,
-                            const char* string_name)
+// Size (in bytes) of the blocks compared by incremental writes with block
+// deltas, and of the largest block compared without them.
+static const size_t INCREMENTAL_BLOCK_SIZE = 65536;
+static const size_t MAX_INCREMENTAL_BLOCK_SIZE = 1 << 30;
+
+static void incremental_var_free(void* context)
 {
-  ASSERT(file->mode == DB_READ);
+  incremental_var_t* var = context;
+  polymec_free(var->block_digests);
+  polymec_free(var->block_steps);
+  polymec_free(var);
+}
 
-  silo_file_push_domain_dir(file);
+// Blocks are compared by their SHA-256 digests, so that an unchanged block 
+// is never mistaken for a changed one (or vice versa) in practice, without 
+// keeping a copy of the data.
+#define DIGEST_SIZE 32
 
-  char string_data_name[FILENAME_MAX+1];
-  snprintf(string_data_name, FILENAME_MAX, "%s_string", string_name);
-  if (!DBInqVarExists(file->dbfile, string_data_name))
+static const uint32_t sha256_k[64] = 
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr32(uint32_t x, int n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+// Processes one 64-byte chunk of a SHA-256 message.
+static void sha256_chunk(uint32_t h[8], const uint8_t* chunk)
+{
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i)
   {
-    log_urgent("silo_file_read_string: Could not read string '%s'.", string_name);
-    silo_file_pop_dir(file);
-    return NULL;
+    w[i] = ((uint32_t)chunk[4*i] << 24) | ((uint32_t)chunk[4*i+1] << 16) | 
+           ((uint32_t)chunk[4*i+2] << 8) | (uint32_t)chunk[4*i+3];
   }
-  int string_size = DBGetVarLength(file->dbfile, string_data_name);
-  char* string = polymec_malloc(sizeof(char) * (string_size + 1));
-  if (string_size > 0)
-    DBReadVar(file->dbfile, string_data_name, string);
-  string[string_size] = '\0';
-  silo_file_pop_dir(file);
-  return string;
+  for (int i = 16; i < 64; ++i)
+  {
+    uint32_t s0 = rotr32(w[i-15], 7) ^ rotr32(w[i-15], 18) ^ (w[i-15] >> 3);
+    uint32_t s1 = rotr32(w[i-2], 17) ^ rotr32(w[i-2], 19) ^ (w[i-2] >> 10);
+    w[i] = w[i-16] + s0 + w[i-7] + s1;
+  }
+  uint32_t a = h[0], b = h[1], c = h[2], d = h[3], 
+           e = h[4], f = h[5], g = h[6], hh = h[7];
+  for (int i = 0; i < 64; ++i)
+  {
+    uint32_t S1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = hh + S1 + ch + sha256_k[i] + w[i];
+    uint32_t S0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = S0 + maj;
+    hh = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+  h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
 }
 
-void silo_file_write_real_array(silo_file_t* file,
-                                const char* array_name,
-                                real_t* array_data,
-                                size_t array_size)
+// Computes the SHA-256 digest of the given bytes.
+static void compute_digest(const uint8_t* bytes, size_t num_bytes,
+                           uint8_t digest[DIGEST_SIZE])
 {
-  ASSERT(file->mode == DB_CLOBBER);
-  ASSERT(array_data != NULL);
-
-  silo_file_push_domain_dir(file);
-
-  if (array_size > 0)
+  uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  size_t i = 0;
+  for (; i + 64 <= num_bytes; i += 64)
+    sha256_chunk(h, &bytes[i]);
+
+  // Pad the remaining bytes with a 1 bit, zeros, and the message length in
+  // bits.
+  uint8_t tail[128];
+  size_t rem = num_bytes - i;
+  memcpy(tail, &bytes[i], rem);
+  tail[rem] = 0x80;
+  size_t tail_size = (rem < 56) ? 64 : 128;
+  memset(&tail[rem+1], 0, tail_size - rem - 1);
+  uint64_t num_bits = (uint64_t)num_bytes * 8;
+  for (int j = 0; j < 8; ++j)
+    tail[tail_size-1-j] = (uint8_t)(num_bits >> (8*j));
+  for (size_t j = 0; j < tail_size; j += 64)
+    sha256_chunk(h, &tail[j]);
+
+  for (int j = 0; j < 8; ++j)
   {
-    char real_array_name[FILENAME_MAX+1];
-    snprintf(real_array_name, FILENAME_MAX, "%s_real_array", array_name);
-    int asize = (int)array_size;
-    int result = DBWrite(file->dbfile, real_array_name, array_data, &asize, 1, SILO_FLOAT_TYPE);
-    if (result != 0)
-      polymec_error("silo_file_write_real_array: write of array '%s' failed.", array_name);
+    digest[4*j]   = (uint8_t)(h[j] >> 24);
+    digest[4*j+1] = (uint8_t)(h[j] >> 16);
+    digest[4*j+2] = (uint8_t)(h[j] >> 8);
+    digest[4*j+3] = (uint8_t)h[j];
   }
-  silo_file_pop_dir(file);
 }
 
-real_t* silo_file_read_real_array(silo_file_t* file,
-                                  const char* array_name,
-                                  size_t* array_size)
+// Writes the given data to the variable with the given name, storing only
+// the blocks that have changed since earlier steps. If any blocks are
+// unchanged, we write a delta header (<var>_delta) containing the
+// variable's datatype, number of values, block size (in bytes), number of
+// blocks, and the step storing each block (-1 for this one), followed by
+// the changed blocks (<var>_dblocks).
+static void write_incremental_var(silo_file_t* file,
+                                  const char* var_name,
+                                  void* data,
+                                  int size,
+                                  int datatype)
 {
-  ASSERT(file->mode == DB_READ);
-  ASSERT(array_size != NULL);
+  START_FUNCTION_TIMER();
+  size_t num_bytes = silo_datatype_size(datatype) * size;
+  size_t block_size = file->block_deltas ? INCREMENTAL_BLOCK_SIZE
+                                         : MAX_INCREMENTAL_BLOCK_SIZE;
+  int num_blocks = (int)((num_bytes + block_size - 1) / block_size);
+
+  // Look up what we wrote for this variable before.
+  char dir[FILENAME_MAX+1], key[2*FILENAME_MAX+2];
+  DBGetDir(file->dbfile, dir);
+  snprintf(key, 2*FILENAME_MAX+1, "%s/%s", dir, var_name);
+  string_ptr_unordered_map_t* vars = file->history->vars;
+  incremental_var_t** var_p = (incremental_var_t**)string_ptr_unordered_map_get(vars, key);
+  incremental_var_t* var = (var_p != NULL) ? *var_p : NULL;
+  if ((var != NULL) && ((var->datatype != datatype) ||
+                        (var->size != (size_t)size) ||
+                        (var->block_size != block_size)))
+    var = NULL;
+
+  // Digest the blocks and figure out which ones have changed.
+  const uint8_t* bytes = data;
+  uint8_t* digests = polymec_malloc(sizeof(uint8_t) * DIGEST_SIZE * MAX(num_blocks, 1));
+  int* header = polymec_malloc(sizeof(int) * (4 + num_blocks));
+  int num_changed = 0;
+  for (int b = 0; b < num_blocks; ++b)
+  {
+    size_t start = b * block_size;
+    compute_digest(&bytes[start], MIN(block_size, num_bytes - start), 
+                   &digests[DIGEST_SIZE*b]);
+    if ((var != NULL) && 
+        (memcmp(&var->block_digests[DIGEST_SIZE*b], &digests[DIGEST_SIZE*b], DIGEST_SIZE) == 0))
+      header[4+b] = var->block_steps[b];
+    else
+    {
+      header[4+b] = -1;
+      ++num_changed;
+    }
+  }
 
-  silo_file_push_domain_dir(file);
+  if (num_changed == num_blocks)
+    write_plain_var(file, var_name, data, size, datatype);
+  else
+  {
+    header[0] = datatype;
+    header[1] = size;
+    header[2] = (int)block_size;
+    header[3] = num_blocks;
+    char name[FILENAME_MAX+1];
+    snprintf(name, FILENAME_MAX, "%s_delta", var_name);
+    write_plain_var(file, name, header, 4 + num_blocks, DB_INT);
+    if (num_changed > 0)
+    {
+      uint8_t* blocks = polymec_malloc(sizeof(uint8_t) * num_changed * block_size);
+      size_t blocks_size = 0;
+      for (int b = 0; b < num_blocks; ++b)
+      {
+        if (header[4+b] == -1)
+        {
+          size_t start = b * block_size, n = MIN(block_size, num_bytes - start);
+          memcpy(&blocks[blocks_size], &bytes[start], n);
+          blocks_size += n;
+        }
+      }
+      snprintf(name, FILENAME_MAX, "%s_dblocks", var_name);
+      write_plain_var(file, name, blocks, (int)blocks_size, DB_CHAR);
+      polymec_free(blocks);
+    }
+    log_debug("silo_file: Wrote %d of %d blocks of %s.", num_changed,
+              num_blocks, var_name);
+  }
 
-  char real_array_name[FILENAME_MAX+1];
-  snprintf(real_array_name, FILENAME_MAX, "%s_real_array", array_name);
-  real_t* result = NULL;
-  if (!DBInqVarExists(file->dbfile, real_array_name))
+  // Record where the blocks are stored.
+  if (var == NULL)
   {
-    log_urgent("silo_file_read_real_array: Could not read array '%s'.", array_name);
-    silo_file_pop_dir(file);
-    return NULL;
+    var = polymec_malloc(sizeof(incremental_var_t));
+    var->datatype = datatype;
+    var->size = (size_t)size;
+    var->block_size = block_size;
+    var->num_blocks = num_blocks;
+    var->block_digests = polymec_malloc(sizeof(uint8_t) * DIGEST_SIZE * MAX(num_blocks, 1));
+    var->block_steps = polymec_malloc(sizeof(int) * MAX(num_blocks, 1));
+    string_ptr_unordered_map_insert_with_kv_dtors(vars, string_dup(key), var,
+                                                  string_free,
+                                                  incremental_var_free);
   }
-  *array_size = (size_t)DBGetVarLength(file->dbfile, real_array_name);
-  if (*array_size > 0)
+  memcpy(var->block_digests, digests, sizeof(uint8_t) * DIGEST_SIZE * num_blocks);
+  for (int b = 0; b < num_blocks; ++b)
   {
-    real_t* array = polymec_malloc(sizeof(real_t) * *array_size);
-    DBReadVar(file->dbfile, real_array_name, array);
-    result = array;
+    if (header[4+b] == -1)
+      var->block_steps[b] = file->step;
   }
-  silo_file_pop_dir(file);
-  return result;
+
+  polymec_free(header);
+  polymec_free(digests);
+  STOP_FUNCTION_TIMER();
 }
 
-void silo_file_write_int_array(silo_file_t* file,
-                               const char* array_name,
-                               int* array_data,
-                               size_t array_size)
+void silo_file_write_var(silo_file_t* file,
+                         const char* var_name,
+                         void* data,
+                         int size,
+                         int datatype)
 {
   ASSERT(file->mode == DB_CLOBBER);
-  ASSERT(array_data != NULL);
-
-  silo_file_push_domain_dir(file);
-
-  if (array_size > 0)
-  {
-    char int_array_name[FILENAME_MAX+1];
-    snprintf(int_array_name, FILENAME_MAX, "%s_int_array", array_name);
-    int asize = (int)array_size;
-    int result = DBWrite(file->dbfile, int_array_name, array_data, &asize, 1, DB_INT);
-    if (result != 0)
-      polymec_error("silo_file_write_int_array: write of array '%s' failed.", array_name);
-  }
-  silo_file_pop_dir(file);
+  if (file->incremental && (file->step >= 0))
+    write_incremental_var(file, var_name, data, size, datatype);
+  else
+    write_plain_var(file, var_name, data, size, datatype);
 }
 
-int* silo_file_read_int_array(silo_file_t* file,
-                              const char* array_name,
-                              size_t* array_size)
+void silo_file_write_mappable_var(silo_file_t* file,
+                                  const char* var_name,
+                                  void* data,
+                                  size_t size,
+                                  int datatype)
 {
-  ASSERT(file->mode == DB_READ);
-  ASSERT(array_size != NULL);
+  ASSERT(file->mode == DB_CLOBBER);
+  stage_var(file, var_name, data, size, datatype, SHARED_FILE_PAGE_SIZE);
+}
 
-  silo_file_push_domain_dir(file);
+// Reads the index entry for the given variable in the shared file, returning
+// true if it exists and false if not.
+static bool read_shared_index(silo_file_t* file,
+                              const char* var_name,
+                              long long index[3])
+{
+  char index_name[FILENAME_MAX+1];
+  snprintf(index_name, FILENAME_MAX, "%s_mpiio", var_name);
+  if (!DBInqVarExists(file->dbfile, index_name))
+    return false;
+  DBReadVar(file->dbfile, index_name, index);
+  return true;
+}
 
-  char int_array_name[FILENAME_MAX+1];
-  snprintf(int_array_name, FILENAME_MAX, "%s_int_array", array_name);
-  int* result = NULL;
-  if (!DBInqVarExists(file->dbfile, int_array_name))
+// Retrieves the datatype and number of values of the given variable if
+// it's stored as is in the Silo file or the shared file, returning true if
+// so and false if not.
+static bool get_plain_var_info(silo_file_t* file,
+                               const char* var_name,
+                               int* datatype,
+                               size_t* size)
+{
+  long long index[3];
+  if (DBInqVarExists(file->dbfile, var_name))
   {
-    log_urgent("silo_file_read_int_array: Could not read array '%s'.", array_name);
-    silo_file_pop_dir(file);
-    return NULL;
+    *datatype = DBGetVarType(file->dbfile, var_name);
+    *size = (size_t)DBGetVarLength(file->dbfile, var_name);
+    return true;
   }
-  *array_size = (size_t)DBGetVarLength(file->dbfile, int_array_name);
-  if (*array_size > 0)
+  else if (read_shared_index(file, var_name, index))
   {
-    int* array = polymec_malloc(sizeof(int) * *array_size);
-    DBReadVar(file->dbfile, int_array_name, array);
-    result = array;
+    *datatype = (int)index[2];
+    *size = (size_t)index[1];
+    return true;
   }
-  silo_file_pop_dir(file);
-  return result;
+  else
+    return false;
 }
 
-MPI_Comm silo_file_comm(silo_file_t* file)
+static void read_var_bytes(silo_file_t* file,
+                           const char* var_name,
+                           size_t offset,
+                           size_t num_bytes,
+                           uint8_t* data);
+
+// Reads the delta header of the given variable if it was written
+// incrementally against earlier steps (see write_incremental_var), returning
+// NULL if it wasn't.
+static int* read_delta_header(silo_file_t* file, const char* var_name)
 {
-  return file->comm;
+  char name[FILENAME_MAX+1];
+  snprintf(name, FILENAME_MAX, "%s_delta", var_name);
+  int datatype;
+  size_t size;
+  if (!get_plain_var_info(file, name, &datatype, &size))
+    return NULL;
+  int* header = polymec_malloc(sizeof(int) * size);
+  read_var_bytes(file, name, 0, sizeof(int) * size, (uint8_t*)header);
+  return header;
 }
 
-DBfile* silo_file_dbfile(silo_file_t* file)
+bool silo_file_contains_var(silo_file_t* file, const char* var_name)
 {
-  return file->dbfile;
+  char name[FILENAME_MAX+1];
+  snprintf(name, FILENAME_MAX, "%s_delta", var_name);
+  int datatype;
+  size_t size;
+  return (get_plain_var_info(file, var_name, &datatype, &size) ||
+          get_plain_var_info(file, name, &datatype, &size));
 }
 
-void silo_file_add_subdomain_mesh(silo_file_t* file,
-                                  const char* mesh_name,
-                                  int silo_mesh_type,
-                                  DBoptlist* optlist)
+int silo_file_var_length(silo_file_t* file, const char* var_name)
 {
-#if POLYMEC_HAVE_MPI
-  ASSERT(file->mode == DB_CLOBBER);
-
-  if (file->nproc > 1)
+  int datatype;
+  size_t size;
+  if (get_plain_var_info(file, var_name, &datatype, &size))
+    return (int)size;
+  int* header = read_delta_header(file, var_name);
+  if (header != NULL)
   {
-    subdomain_mesh_t* mesh = subdomain_mesh_new(mesh_name, silo_mesh_type, optlist);
-    ptr_array_append_with_dtor(file->subdomain_meshes, mesh, DTOR(subdomain_mesh_free));
+    int length = header[1];
+    polymec_free(header);
+    return length;
   }
-#endif
+  else
+    return 0;
 }
 
-void silo_file_add_subdomain_field(silo_file_t* file,
-                                   const char* mesh_name,
-                                   const char* field_name,
-                                   int silo_var_type,
-                                   DBoptlist* optlist)
+// Opens the shared file for reading if it isn't already open, reading the
+// offsets of its segments.
+static void open_shared_file(silo_file_t* file)
 {
-#if POLYMEC_HAVE_MPI
-  ASSERT((file->mode == DB_CLOBBER) || (file->mode == DB_APPEND));
+  if (file->shared_file != NULL)
+    return;
 
-  if (file->nproc > 1)
-  {
-    subdomain_field_t* field = subdomain_field_new(mesh_name, field_name, silo_var_type, optlist);
-    ptr_array_append_with_dtor(file->subdomain_fields, field, DTOR(subdomain_field_free));
-  }
-#endif
+  log_debug("silo_file: Opening shared file %s.", file->shared_filename);
+  file->shared_file = fopen(file->shared_filename, "rb");
+  if (file->shared_file == NULL)
+    polymec_error("silo_file: Could not open shared file %s.", file->shared_filename);
+  int64_t num_segments;
+  if (fread(&num_segments, sizeof(int64_t), 1, file->shared_file) != 1)
+    polymec_error("silo_file: Could not read shared file %s.", file->shared_filename);
+  file->num_segments = (int)num_segments;
+  file->segment_offsets = polymec_malloc(sizeof(int64_t) * file->num_segments);
+  if (fread(file->segment_offsets, sizeof(int64_t), file->num_segments,
+            file->shared_file) != (size_t)file->num_segments)
+    polymec_error("silo_file: Could not read shared file %s.", file->shared_filename);
 }
 
-void silo_file_push_dir(silo_file_t* file, const char* dir)
+// Returns the offset within the shared file of the segment written by the
+// domain we're reading.
+static int64_t shared_segment_offset(silo_file_t* file)
 {
-  if (file->dirs == NULL)
-    file->dirs = string_slist_new();
+  open_shared_file(file);
+  ASSERT(file->domain < file->num_segments);
+  return file->segment_offsets[file->domain];
+}
 
-  // Set the new directory and push it onto the stack.
-  DBSetDir(file->dbfile, dir);
-  string_slist_push_with_dtor(file->dirs, string_dup(dir), string_free);
+static void close_referenced_file(void* context)
+{
+  silo_file_t* file = context;
+  DBClose(file->dbfile);
+  if (file->shared_file != NULL)
+    fclose(file->shared_file);
+  if (file->segment_offsets != NULL)
+    polymec_free(file->segment_offsets);
+  if (file->referenced_files != NULL)
+    string_ptr_unordered_map_free(file->referenced_files);
+  polymec_free(file);
 }
 
-void silo_file_push_domain_dir(silo_file_t* file)
+// Returns a file for reading the given earlier step of the given file's
+// data set, which stores data referenced by an incremental write. The file
+// is opened if needed, and is closed along with the given file.
+static silo_file_t* referenced_file(silo_file_t* file, int step)
 {
-#if POLYMEC_HAVE_MPI
-  // Determine the domain directory.
-  char domain_dir[FILENAME_MAX+1];
-  if (file->nproc > 1)
+  // The file for the step lives alongside the given one (in the same group
+  // directory, if any).
+  char dir[FILENAME_MAX+1], filename[FILENAME_MAX+1];
+  strncpy(dir, file->filename, FILENAME_MAX);
+  dir[FILENAME_MAX] = '\0';
+  char* slash = strrchr(dir, '/');
+  ASSERT(slash != NULL);
+  *slash = '\0';
+  get_silo_filename(dir, file->prefix, step, filename);
+
+  if (file->referenced_files == NULL)
+    file->referenced_files = string_ptr_unordered_map_new();
+  silo_file_t** ref_p =
+    (silo_file_t**)string_ptr_unordered_map_get(file->referenced_files, filename);
+  silo_file_t* ref;
+  if (ref_p != NULL)
+    ref = *ref_p;
+  else
   {
-    snprintf(domain_dir, FILENAME_MAX, "/domain_%d", file->rank_in_group);
-    DBSetDir(file->dbfile, domain_dir);
+    log_debug("silo_file: Opening %s for data referenced by %s.", filename,
+              file->filename);
+    ref = polymec_calloc(1, sizeof(silo_file_t));
+    ref->mode = DB_READ;
+    ref->comm = file->comm;
+    ref->step = step;
+    strncpy(ref->prefix, file->prefix, FILENAME_MAX);
+    strncpy(ref->directory, file->directory, FILENAME_MAX);
+    strncpy(ref->filename, filename, FILENAME_MAX);
+    set_shared_filename(ref, step);
+    ref->dbfile = DBOpen(ref->filename, DBGetDriverType(file->dbfile), DB_READ);
+    if (ref->dbfile == NULL)
+      polymec_error("silo_file: Could not open %s, which stores data for %s.",
+                    ref->filename, file->filename);
+    string_ptr_unordered_map_insert_with_kv_dtors(file->referenced_files,
+                                                  string_dup(filename), ref,
+                                                  string_free,
+                                                  close_referenced_file);
+  }
+  ref->domain = file->domain;
+  return ref;
+}
+
+// Reads the given range of bytes of the given variable, assembling it from
+// the files for earlier steps if it was written incrementally.
+static void read_var_bytes(silo_file_t* file,
+                           const char* var_name,
+                           size_t offset,
+                           size_t num_bytes,
+                           uint8_t* data)
+{
+  long long index[3];
+  if (DBInqVarExists(file->dbfile, var_name))
+  {
+    size_t width = silo_datatype_size(DBGetVarType(file->dbfile, var_name));
+    size_t size = (size_t)DBGetVarLength(file->dbfile, var_name);
+    if ((offset == 0) && (num_bytes == width * size))
+      DBReadVar(file->dbfile, var_name, data);
+    else
+    {
+      int start = (int)(offset / width), count = (int)(num_bytes / width), stride = 1;
+      DBReadVarSlice(file->dbfile, var_name, &start, &count, &stride, 1, data);
+    }
+  }
+  else if (read_shared_index(file, var_name, index))
+  {
+    int64_t segment_offset = shared_segment_offset(file);
+    if ((fseeko(file->shared_file, (off_t)(segment_offset + index[0] + (int64_t)offset), SEEK_SET) != 0) ||
+        (fread(data, sizeof(uint8_t), num_bytes, file->shared_file) != num_bytes))
+      polymec_error("silo_file: Could not read '%s' from %s.", var_name, file->shared_filename);
   }
   else
-    sprintf(domain_dir, "/");
-  silo_file_push_dir(file, domain_dir);
-#else
-  silo_file_push_dir(file, "/");
-#endif
+  {
+    int* header = read_delta_header(file, var_name);
+    if (header == NULL)
+    {
+      polymec_error("silo_file: '%s' was not found in %s (nor in its shared file).",
+                    var_name, file->filename);
+    }
+
+    // Read each block in the range from the file that stores it.
+    size_t total_bytes = silo_datatype_size(header[0]) * header[1];
+    size_t block_size = (size_t)header[2];
+    int num_blocks = header[3];
+    char dir[FILENAME_MAX+1], blocks_name[FILENAME_MAX+1];
+    DBGetDir(file->dbfile, dir);
+    snprintf(blocks_name, FILENAME_MAX, "%s_dblocks", var_name);
+    size_t blocks_offset = 0;
+    for (int b = 0; b < num_blocks; ++b)
+    {
+      size_t start = b * block_size, end = MIN(start + block_size, total_bytes);
+      size_t lo = MAX(start, offset), hi = MIN(end, offset + num_bytes);
+      if (lo < hi)
+      {
+        if (header[4+b] == -1)
+        {
+          read_var_bytes(file, blocks_name, blocks_offset + (lo - start),
+                         hi - lo, &data[lo - offset]);
+        }
+        else
+        {
+          silo_file_t* ref = referenced_file(file, header[4+b]);
+          DBSetDir(ref->dbfile, dir);
+          read_var_bytes(ref, var_name, lo, hi - lo, &data[lo - offset]);
+        }
+      }
+      if (header[4+b] == -1)
+        blocks_offset += end - start;
+    }
+    polymec_free(header);
+  }
 }
 
-void silo_file_pop_dir(silo_file_t* file)
+void silo_file_read_var(silo_file_t* file, const char* var_name, void* data)
 {
-  ASSERT(!string_slist_empty(file->dirs));
+  int datatype;
+  size_t size;
+  if (get_plain_var_info(file, var_name, &datatype, &size))
+    read_var_bytes(file, var_name, 0, silo_datatype_size(datatype) * size, data);
+  else
+  {
+    int* header = read_delta_header(file, var_name);
+    if (header == NULL)
+    {
+      polymec_error("silo_file_read_var: '%s' was not found in %s (nor in its shared file).",
+                    var_name, file->filename);
+    }
+    read_var_bytes(file, var_name, 0, silo_datatype_size(header[0]) * header[1], data);
+    polymec_free(header);
+  }
+}
 
-  // Pop the current directory off the stack and delete it.
-  char* dir = string_slist_pop(file->dirs, NULL);
-  string_free(dir);
+// A private memory mapping of part of the shared file.
+typedef struct
+{
+  void* addr;
+  size_t length;
+} shared_mapping_t;
 
-  // Set the directory to the front of the stack.
-  DBSetDir(file->dbfile, file->dirs->front->value);
+static void shared_mapping_free(void* context)
+{
+  shared_mapping_t* mapping = context;
+  munmap(mapping->addr, mapping->length);
 }
 
-string_ptr_unordered_map_t* silo_file_scratch(silo_file_t* file)
+void* silo_file_map_var(silo_file_t* file,
+                        const char* var_name,
+                        int datatype,
+                        size_t size,
+                        void** data)
 {
-  return file->scratch;
+  START_FUNCTION_TIMER();
+  long long index[3];
+  if (!read_shared_index(file, var_name, index) || (index[1] == 0))
+  {
+    STOP_FUNCTION_TIMER();
+    return NULL;
+  }
+  if ((int)index[2] != datatype)
+  {
+    polymec_error("silo_file_map_var: '%s' in %s has Silo datatype %d (expected %d).",
+                  var_name, file->shared_filename, (int)index[2], datatype);
+  }
+  if ((size_t)index[1] != size)
+  {
+    polymec_error("silo_file_map_var: '%s' in %s has %zu values (expected %zu).",
+                  var_name, file->shared_filename, (size_t)index[1], size);
+  }
+
+  // Map the pages containing the variable. They are copied on write, so
+  // changes to the data aren't written back to the file.
+  int64_t offset = shared_segment_offset(file) + index[0];
+  int64_t page_size = (int64_t)sysconf(_SC_PAGESIZE);
+  int64_t page_offset = page_size * (offset / page_size);
+  size_t length = silo_datatype_size((int)index[2]) * (size_t)index[1] +
+                  (size_t)(offset - page_offset);
+  void* addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fileno(file->shared_file), (off_t)page_offset);
+  if (addr == MAP_FAILED)
+  {
+    log_debug("silo_file: Could not map '%s' from %s.", var_name, file->shared_filename);
+    STOP_FUNCTION_TIMER();
+    return NULL;
+  }
+
+  shared_mapping_t* mapping = polymec_refcounted_malloc(sizeof(shared_mapping_t),
+                                                        shared_mapping_free);
+  mapping->addr = addr;
+  mapping->length = length;
+  *data = (uint8_t*)addr + (offset - page_offset);
+  STOP_FUNCTION_TIMER();
+  return mapping;
 }
 
 bool silo_file_contains_stencil(silo_file_t* file, const char* stencil_name)
@@ -2921,7 +5151,7 @@ bool silo_file_contains_field_metadata(silo_file_t* file,
   silo_file_push_domain_dir(file);
   char arr_name[FILENAME_MAX+1];
   snprintf(arr_name, FILENAME_MAX, "%s_int_array", md_name);
-  int result = DBInqVarExists(file->dbfile, arr_name);
+  bool result = silo_file_contains_var(file, arr_name);
   silo_file_pop_dir(file);
-  return (result != 0);
+  return result;
 }
@@ -81,6 +81,18 @@ silo_file_t* silo_file_new(MPI_Comm comm,
 ///   containing no step information will be loaded.
 /// * If time is not NULL, it will store the time found in the file (or 0.0 if
 ///   it does not exist in the file).
+/// * The file may be read by a different number of processes than wrote it,
+///   in which case the directory must be given explicitly. Unimeshes, colmeshes,
+///   and point clouds (and their fields) are then divided evenly among the
+///   reading processes. Each process reads a polymesh assembled from a
+///   contiguous block of the writing processes' subdomains. Nodes on faces
+///   shared by two of these subdomains are welded to the nodes of the twin
+///   faces. Nodes of subdomains that touch only along edges or at corners are
+///   welded if they lie within 1e-3 of the shortest edge of one another. A
+///   polymesh read by M processes from a file written by N < M processes
+///   gives one subdomain to each of N processes and no cells to the other
+///   M - N, and should be repartitioned with \ref repartition_polymesh. Edge tags and edge-centered fields on
+///   such polymeshes are not read.
 /// * If the file does not exist or fails to load, this function returns NULL.
 /// \memberof silo_file
 silo_file_t* silo_file_open(MPI_Comm comm,
@@ -93,6 +105,97 @@ silo_file_t* silo_file_open(MPI_Comm comm,
 /// \memberof silo_file
 void silo_file_close(silo_file_t* file);
 
+/// \enum silo_compression_t
+/// Methods for compressing the data that polymec stores in Silo files as
+/// raw arrays rather than as Silo meshes and variables: aggregated unimesh
+/// fields, colmesh fields, and real-valued arrays. This data is broken into
+/// chunks that are compressed in parallel (using OpenMP threads, if
+/// available) before being written. This is independent of the GZIP
+/// compression enabled by \ref silo_enable_compression.
+typedef enum
+{
+  SILO_COMPRESSION_NONE,     // data is written as is
+  SILO_COMPRESSION_LOSSLESS, // fast lossless compression (byte shuffling
+                             // followed by deflation at the fastest level)
+  SILO_COMPRESSION_LOSSY     // values are quantized to within a given
+                             // absolute error bound, then compressed
+                             // losslessly
+} silo_compression_t;
+
+/// Sets the method used to compress the data for the object (field or
+/// array) with the given name when it is written to the given file. If
+/// object_name is NULL, the method is used for all objects that don't have
+/// their own. By default, no data is compressed.
+/// \param [in] object_name The name of a field or array, or NULL.
+/// \param [in] method The compression method.
+/// \param [in] error_bound For lossy compression, the maximum absolute error
+///                         allowed in each value. Ignored otherwise. Lossy
+///                         compression is best suited to plot files.
+/// \memberof silo_file
+void silo_file_set_compression(silo_file_t* file,
+                               const char* object_name,
+                               silo_compression_t method,
+                               real_t error_bound);
+
+/// Directs the given file to write the data that polymec stores as raw
+/// arrays (see \ref silo_compression_t) to a single file shared by all
+/// processes, using collective MPI-IO, instead of passing it through the
+/// Silo files one group of processes at a time. Each process stages its data
+/// in memory until the file is closed, at which point the data is written
+/// using two-phase I/O, in which a set of aggregator processes gathers it
+/// and writes it in large contiguous blocks. Meshes and other Silo objects
+/// are written to the Silo files as usual. Data in the shared file is read
+/// transparently, but isn't visible to visualization tools. This has no
+/// effect if polymec isn't built with MPI.
+/// \note Only writing is collective. Processes read (or memory-map) their 
+///       own segments of the shared file independently, since they read 
+///       different numbers of objects (for instance, when a data set is 
+///       read on a different number of processes than wrote it), and 
+///       collective reads would require every process to take part in 
+///       every read.
+/// \param [in] num_aggregators The number of aggregator processes, or 0 to
+///                             let the MPI implementation decide.
+/// \memberof silo_file
+void silo_file_enable_collective_io(silo_file_t* file,
+                                    int num_aggregators);
+
+/// \class silo_write_history
+/// A record of the data written incrementally to the steps of a Silo data 
+/// set by this process: for each array, a digest of each of its blocks, and
+/// the step whose file stores that block. Incremental writes compare the 
+/// data they write against this history. A write history belongs to the 
+/// code that writes the data set, and is passed to each of its files.
+typedef struct silo_write_history_t silo_write_history_t;
+
+/// Creates an empty write history.
+/// \memberof silo_write_history
+silo_write_history_t* silo_write_history_new(void);
+
+/// Destroys the given write history.
+/// \memberof silo_write_history
+void silo_write_history_free(silo_write_history_t* history);
+
+/// Directs the given file to write data incrementally against the earlier
+/// steps of its data set recorded in the given write history: data that 
+/// polymec stores as raw arrays (see \ref silo_compression_t) that hasn't 
+/// changed since an earlier step is stored as a reference to the file for 
+/// that step instead of being written again. Meshes and other Silo objects 
+/// are written in full. Restarting from a step reassembles its data from the
+/// files it references, so those files must be kept. This has no effect on 
+/// files written without a step.
+/// \param [in,out] history The write history of the file's data set, which 
+///                         is updated with the data written to this file. 
+///                         It must outlive the file, and may only be used 
+///                         with files belonging to one data set.
+/// \param [in] block_deltas If true, arrays are compared in fixed-size blocks
+///                          using (SHA-256) digests, and only the blocks that
+///                          have changed are written. Otherwise, an array is
+///                          written in full if any of it has changed.
+/// \memberof silo_file
+void silo_file_enable_incremental_writes(silo_file_t* file,
+                                         silo_write_history_t* history,
+                                         bool block_deltas);
+
 /// Writes the given uniform cartesian mesh to the given Silo file. If mapping
 /// is non-NULL, the nodes of the cells are mapped accordingly.
 /// \memberof silo_file
@@ -112,6 +215,24 @@ unimesh_t* silo_file_read_unimesh(silo_file_t* file,
 bool silo_file_contains_unimesh(silo_file_t* file,
                                 const char* mesh_name);
 
+/// Sets whether uniform cartesian mesh fields written to the given Silo file
+/// are aggregated. By default, each patch of a field is written as its own
+/// Silo variable for each component, which incurs a lot of metadata when a
+/// process has many small patches. An aggregated field instead stores the
+/// data for all of a process's patches in a single contiguous array, with a
+/// compact index of the patches it contains. Aggregated fields are read
+/// transparently by \ref silo_file_read_unimesh_field, but can't be viewed
+/// by visualization tools such as VisIt unless per-patch views are also
+/// written, which stores the data twice.
+/// \param [in] aggregate If true, fields written to the file are aggregated.
+/// \param [in] write_patch_views If true (and aggregate is true), each
+///                              aggregated field is also written patch by
+///                              patch for visualization tools.
+/// \memberof silo_file
+void silo_file_aggregate_unimesh_fields(silo_file_t* file,
+                                        bool aggregate,
+                                        bool write_patch_views);
+
 /// Writes the given uniform cartesian mesh field to the given Silo file,
 /// associating it with the entry for the mesh with the given name. If a
 /// non-NULL mapping is given, the data will be mapped accordingly.
@@ -161,6 +282,38 @@ bool silo_file_contains_unimesh_field(silo_file_t* file,
                                       const char* mesh_name,
                                       unimesh_centering_t centering);
 
+/// Writes the data buffer of the given uniform cartesian mesh field
+/// (including ghost values) to the given Silo file in polymec's native
+/// checkpoint format, in which it is stored uncompressed and aligned to a
+/// memory page within the file shared by all processes (see
+/// \ref silo_file_enable_collective_io). On restart, such a field can be
+/// mapped into memory with \ref silo_file_map_unimesh_field instead of
+/// being read and copied. Fields written this way aren't visible to
+/// visualization tools.
+/// \memberof silo_file
+void silo_file_write_unimesh_field_buffer(silo_file_t* file,
+                                          const char* field_name,
+                                          const char* mesh_name,
+                                          unimesh_field_t* field);
+
+/// Maps the data buffer of the uniform cartesian mesh field with the given
+/// name, written by \ref silo_file_write_unimesh_field_buffer, into the given
+/// field, which adopts the mapped pages (and reads its metadata from the
+/// file). The pages are read lazily as the field's data is accessed and
+/// copied when it is modified, so changes aren't written to the file.
+/// \param [inout] field A field with the same centering and number of
+///                      components as the one written, on a mesh with the
+///                      same patches on this process.
+/// \returns true if the field's buffer was mapped, false if it wasn't found
+///          or couldn't be mapped (if the file is read by a different number
+///          of processes than wrote it, for example), in which case the field
+///          is unchanged.
+/// \memberof silo_file
+bool silo_file_map_unimesh_field(silo_file_t* file,
+                                 const char* field_name,
+                                 const char* mesh_name,
+                                 unimesh_field_t* field);
+
 /// Writes the given prism mesh (colmesh) to the given Silo file. If mapping
 /// is non-NULL, the nodes of the cells are mapped accordingly.
 /// \memberof silo_file
@@ -35,6 +35,12 @@ extern string_ptr_unordered_map_t* silo_file_scratch(silo_file_t* file);
 extern void silo_file_write_field_metadata(silo_file_t* file, const char* md_name, field_metadata_t* md);
 extern void silo_file_read_field_metadata(silo_file_t* file, const char* md_name, field_metadata_t* md);
 extern bool silo_file_contains_field_metadata(silo_file_t* file, const char* md_name);
+extern bool silo_file_is_remapped(silo_file_t* file);
+extern void silo_file_set_domain(silo_file_t* file, int domain);
+extern void silo_file_reset_domain(silo_file_t* file);
+extern void silo_file_get_remapped_range(silo_file_t* file, int num_items, int* start, int* end);
+extern int_array_t* silo_file_gather_domain_tuples(silo_file_t* file, const char* array_name, int tuple_size);
+extern void silo_file_write_object_real_array(silo_file_t* file, const char* object_name, const char* array_name, real_t* array_data, size_t array_size);
 
 extern exchanger_proc_map_t* colmesh_xy_data_send_map(colmesh_t* mesh, int xy_index);
 extern exchanger_proc_map_t* colmesh_xy_data_receive_map(colmesh_t* mesh, int xy_index);
@@ -153,6 +159,28 @@ void silo_file_write_colmesh(silo_file_t* file,
   STOP_FUNCTION_TIMER();
 }
 
+// Returns the indices (xy, z) of all chunks of the given colmesh in a
+// remapped file, each followed by the domain that wrote it. These are
+// gathered once and stashed in the file's scratch space.
+static int_array_t* remapped_colmesh_chunks(silo_file_t* file,
+                                            const char* mesh_name)
+{
+  string_ptr_unordered_map_t* scratch = silo_file_scratch(file);
+  char chunks_name[FILENAME_MAX+1];
+  snprintf(chunks_name, FILENAME_MAX, "%s_remapped_chunks", mesh_name);
+  int_array_t** chunks_p = (int_array_t**)string_ptr_unordered_map_get(scratch, chunks_name);
+  if (chunks_p != NULL)
+    return *chunks_p;
+
+  char array_name[FILENAME_MAX+1];
+  snprintf(array_name, FILENAME_MAX, "%s_chunk_indices", mesh_name);
+  int_array_t* chunks = silo_file_gather_domain_tuples(file, array_name, 2);
+  string_ptr_unordered_map_insert_with_kv_dtors(scratch, string_dup(chunks_name),
+                                                chunks, string_free,
+                                                DTOR(int_array_free));
+  return chunks;
+}
+
 colmesh_t* silo_file_read_colmesh(silo_file_t* file,
                                   const char* mesh_name)
 {
@@ -173,10 +201,52 @@ colmesh_t* silo_file_read_colmesh(silo_file_t* file,
     polymec_free(chunk_md);
   }
 
+  // Read z axis information for this mesh.
+  real_t z1, z2;
+  bool periodic;
+  {
+    char array_name[FILENAME_MAX+1];
+    snprintf(array_name, FILENAME_MAX, "%s_endpts", mesh_name);
+    size_t size;
+    real_t* endpts = silo_file_read_real_array(file, array_name, &size);
+    ASSERT(size == 2);
+    z1 = endpts[0];
+    z2 = endpts[1];
+    polymec_free(endpts);
+
+    snprintf(array_name, FILENAME_MAX, "%s_periodic", mesh_name);
+    int* per = silo_file_read_int_array(file, array_name, &size);
+    ASSERT(size == 1);
+    periodic = (bool)per[0];
+    polymec_free(per);
+  }
+
+  silo_file_pop_dir(file);
+
   // Read in the indices of the locally stored chunks:
   // (xy0, z0), (xy1, z1), ...
   size_t num_chunk_indices;
   int* chunk_indices;
+  int* chunk_domains = NULL;
+  if (silo_file_is_remapped(file))
+  {
+    // The file was written by a different number of processes, so we take
+    // a contiguous slice of all chunks, ordered by the processes that wrote
+    // them, and remember where they came from.
+    int_array_t* chunks = remapped_colmesh_chunks(file, mesh_name);
+    int start, end;
+    silo_file_get_remapped_range(file, (int)(chunks->size/3), &start, &end);
+    num_chunk_indices = 2*(end - start);
+    chunk_indices = polymec_malloc(sizeof(int) * MAX(num_chunk_indices, 1));
+    chunk_domains = polymec_malloc(sizeof(int) * MAX(end - start, 1));
+    for (int i = start; i < end; ++i)
+    {
+      chunk_indices[2*(i-start)]   = chunks->data[3*i];
+      chunk_indices[2*(i-start)+1] = chunks->data[3*i+1];
+      chunk_domains[i-start]       = chunks->data[3*i+2];
+    }
+  }
+  else
   {
     char array_name[FILENAME_MAX+1];
     snprintf(array_name, FILENAME_MAX, "%s_chunk_indices", mesh_name);
@@ -189,6 +259,13 @@ colmesh_t* silo_file_read_colmesh(silo_file_t* file,
   for (int f = 0; f < num_chunk_indices/2; ++f)
   {
     int xy = chunk_indices[2*f];
+    if (chunk_domains != NULL)
+    {
+      // Read each fragment once, from a domain that wrote it.
+      if (colmesh_fragment_map_contains(fragments, xy))
+        continue;
+      silo_file_set_domain(file, chunk_domains[f]);
+    }
     char fragment_name[FILENAME_MAX+1];
     snprintf(fragment_name, FILENAME_MAX, "%s_%d_pp", mesh_name, xy);
     planar_polymesh_t* frag_mesh = silo_file_read_planar_polymesh(file, fragment_name);
@@ -213,25 +290,10 @@ colmesh_t* silo_file_read_colmesh(silo_file_t* file,
     // Add our fragment to the map.
     colmesh_fragment_map_add(fragments, xy, frag_mesh, send_map, receive_map);
   }
-
-  // Read z axis information for this mesh.
-  real_t z1, z2;
-  bool periodic;
+  if (chunk_domains != NULL)
   {
-    char array_name[FILENAME_MAX+1];
-    snprintf(array_name, FILENAME_MAX, "%s_endpts", mesh_name);
-    size_t size;
-    real_t* endpts = silo_file_read_real_array(file, array_name, &size);
-    ASSERT(size == 2);
-    z1 = endpts[0];
-    z2 = endpts[1];
-    polymec_free(endpts);
-
-    snprintf(array_name, FILENAME_MAX, "%s_periodic", mesh_name);
-    int* per = silo_file_read_int_array(file, array_name, &size);
-    ASSERT(size == 1);
-    periodic = (bool)per[0];
-    polymec_free(per);
+    polymec_free(chunk_domains);
+    silo_file_reset_domain(file);
   }
 
   // Create the mesh.
@@ -256,7 +318,6 @@ colmesh_t* silo_file_read_colmesh(silo_file_t* file,
   // Finish constructing the colmesh.
   colmesh_finalize(mesh);
 
-  silo_file_pop_dir(file);
   STOP_FUNCTION_TIMER();
   return mesh;
 }
@@ -812,6 +873,7 @@ static void copy_out_other_centerings(silo_file_t* file,
 }
 
 static void write_colmesh_chunk_data(silo_file_t* file,
+                                     const char* field_name,
                                      const char** field_component_names,
                                      const char* chunk_grid_name,
                                      colmesh_chunk_data_t* chunk_data,
@@ -878,7 +940,7 @@ static void write_colmesh_chunk_data(silo_file_t* file,
     {
       char data_name[FILENAME_MAX+1];
       snprintf(data_name, FILENAME_MAX, "%s_%s", chunk_grid_name, field_component_names[c]);
-      silo_file_write_real_array(file, data_name, data, data_size);
+      silo_file_write_object_real_array(file, field_name, data_name, data, data_size);
     }
   }
 
@@ -917,8 +979,8 @@ void silo_file_write_colmesh_field(silo_file_t* file,
 
     char chunk_grid_name[FILENAME_MAX];
     snprintf(chunk_grid_name, FILENAME_MAX-1, "%s_%d_%d", mesh_name, xy, z);
-    write_colmesh_chunk_data(file, (const char**)field_names, chunk_grid_name,
-                             data, md, mapping);
+    write_colmesh_chunk_data(file, field_name, (const char**)field_names,
+                             chunk_grid_name, data, md, mapping);
     ++l;
 
     for (int c = 0; c < num_components; ++c)
@@ -1042,7 +1104,6 @@ void silo_file_read_colmesh_field(silo_file_t* file,
                                   colmesh_field_t* field)
 {
   START_FUNCTION_TIMER();
-  silo_file_push_domain_dir(file);
 
   size_t num_components = colmesh_field_num_components(field);
   char* field_names[num_components];
@@ -1051,10 +1112,34 @@ void silo_file_read_colmesh_field(silo_file_t* file,
   snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
   silo_file_read_field_metadata(file, md_name, md);
 
+  // If the file was written by a different number of processes, find the
+  // domain that wrote each chunk.
+  int_int_unordered_map_t* chunk_domains = NULL;
+  int num_xy_chunks, num_z_chunks, nz_per_chunk;
+  colmesh_get_chunk_info(colmesh_field_mesh(field), &num_xy_chunks,
+                         &num_z_chunks, &nz_per_chunk);
+  if (silo_file_is_remapped(file))
+  {
+    int_array_t* chunks = remapped_colmesh_chunks(file, mesh_name);
+    chunk_domains = int_int_unordered_map_new();
+    for (size_t i = 0; i < chunks->size/3; ++i)
+    {
+      int* chunk_p = &chunks->data[3*i];
+      int_int_unordered_map_insert(chunk_domains, num_z_chunks*chunk_p[0] + chunk_p[1], chunk_p[2]);
+    }
+  }
+
   colmesh_chunk_data_t* data;
   int pos = 0, xy, z;
   while (colmesh_field_next_chunk(field, &pos, &xy, &z, &data))
   {
+    if (chunk_domains != NULL)
+    {
+      int* domain_p = int_int_unordered_map_get(chunk_domains, num_z_chunks*xy + z);
+      ASSERT(domain_p != NULL);
+      silo_file_set_domain(file, *domain_p);
+    }
+    silo_file_push_domain_dir(file);
     for (int c = 0; c < num_components; ++c)
     {
       char field_comp_name[FILENAME_MAX];
@@ -1068,9 +1153,14 @@ void silo_file_read_colmesh_field(silo_file_t* file,
 
     for (int c = 0; c < num_components; ++c)
       string_free(field_names[c]);
+    silo_file_pop_dir(file);
+  }
+  if (chunk_domains != NULL)
+  {
+    int_int_unordered_map_free(chunk_domains);
+    silo_file_reset_domain(file);
   }
 
-  silo_file_pop_dir(file);
   STOP_FUNCTION_TIMER();
 }
 
@@ -0,0 +1,377 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdint.h>
+#include "zlib.h"
+#include "silo.h"
+#include "core/timer.h"
+#include "io/silo_file.h"
+
+#if POLYMEC_HAVE_OPENMP
+#include <omp.h>
+#endif
+
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+#define SILO_FLOAT_TYPE DB_DOUBLE
+#else
+#define SILO_FLOAT_TYPE DB_FLOAT
+#endif
+
+// Compression in Silo files proceeds by breaking arrays into chunks of
+// values that are compressed independently (and in parallel, if threads are
+// available) and then written as a single block of bytes. Chunks are
+// compressed either by shuffling the bytes of their values (grouping the
+// most significant bytes together, and so on) and deflating the result, or
+// (for lossy compression) by quantizing the values, shuffling the bytes of
+// the differences between successive quantized values, and deflating those.
+
+// Number of values in a chunk.
+static const size_t CHUNK_SIZE = 65536;
+
+// Chunk compression modes.
+enum
+{
+  CHUNK_SHUFFLED = 0,
+  CHUNK_QUANTIZED = 1
+};
+
+// Largest quantized value we allow. Integers up to 2^52 (and products of
+// them with the quantization step) are represented exactly enough in double
+// precision that dequantized values stay within the error bound. Chunks with
+// larger quanta are compressed losslessly.
+static const real_t MAX_QUANTUM = (real_t)4503599627370496.0; // 2^52
+
+// These unpublished functions are used by silo_file.c and friends.
+extern void silo_file_write_var(silo_file_t* file, const char* var_name,
+                                void* data, int size, int datatype);
+extern bool silo_file_contains_var(silo_file_t* file, const char* var_name);
+extern int silo_file_var_length(silo_file_t* file, const char* var_name);
+extern void silo_file_read_var(silo_file_t* file, const char* var_name,
+                               void* data);
+extern void silo_file_get_compression(silo_file_t* file,
+                                      const char* object_name,
+                                      silo_compression_t* method,
+                                      real_t* error_bound);
+void silo_file_write_compressed_reals(silo_file_t* file,
+                                      const char* object_name,
+                                      const char* var_name,
+                                      real_t* data,
+                                      size_t size);
+bool silo_file_contains_compressed_reals(silo_file_t* file,
+                                         const char* var_name);
+real_t* silo_file_read_compressed_reals(silo_file_t* file,
+                                        const char* var_name,
+                                        size_t* size);
+
+// Shuffles n values, each of the given width in bytes, so that the ith
+// bytes of all values are contiguous.
+static void shuffle(const uint8_t* in, size_t n, size_t width, uint8_t* out)
+{
+  for (size_t i = 0; i < n; ++i)
+    for (size_t b = 0; b < width; ++b)
+      out[b*n + i] = in[i*width + b];
+}
+
+// Undoes shuffle.
+static void unshuffle(const uint8_t* in, size_t n, size_t width, uint8_t* out)
+{
+  for (size_t i = 0; i < n; ++i)
+    for (size_t b = 0; b < width; ++b)
+      out[i*width + b] = in[b*n + i];
+}
+
+// Attempts to quantize the given n values to integer multiples of
+// 2 * error_bound, storing the zigzag-encoded differences between
+// successive quanta in deltas. Returns false if a value can't be quantized,
+// or if its dequantized value (computed exactly as dequantize does) isn't
+// within the error bound.
+static bool quantize(const real_t* values, size_t n, real_t error_bound,
+                     uint64_t* deltas)
+{
+  real_t step = 2 * error_bound;
+  int64_t prev = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    real_t q = values[i] / step;
+    if (!isfinite(q) || (ABS(q) > MAX_QUANTUM))
+      return false;
+    int64_t quantum = (int64_t)round(q);
+    if (ABS((real_t)quantum * step - values[i]) > error_bound)
+      return false;
+    int64_t d = quantum - prev;
+    deltas[i] = ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+    prev = quantum;
+  }
+  return true;
+}
+
+// Undoes quantize.
+static void dequantize(const uint64_t* deltas, size_t n, real_t error_bound,
+                       real_t* values)
+{
+  real_t step = 2 * error_bound;
+  int64_t quantum = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    int64_t d = (int64_t)(deltas[i] >> 1) ^ -(int64_t)(deltas[i] & 1);
+    quantum += d;
+    values[i] = (real_t)quantum * step;
+  }
+}
+
+// Compresses a chunk of n values into out (which has room for out_size
+// bytes), using scratch (which has room for 2*n 64-bit values). Returns the
+// zlib status of the compression, and stores the mode in which the chunk was 
+// compressed in mode and the number of compressed bytes in out_size. This 
+// is called within parallel regions, so errors are left to the caller.
+static int compress_chunk(const real_t* values, size_t n,
+                          silo_compression_t method, real_t error_bound,
+                          uint8_t* scratch, uint8_t* out, size_t* out_size,
+                          int* chunk_mode)
+{
+  int mode = CHUNK_SHUFFLED;
+  const uint8_t* bytes = (const uint8_t*)values;
+  size_t width = sizeof(real_t);
+  uint8_t* shuffled = &scratch[n * sizeof(uint64_t)];
+  if ((method == SILO_COMPRESSION_LOSSY) &&
+      quantize(values, n, error_bound, (uint64_t*)scratch))
+  {
+    mode = CHUNK_QUANTIZED;
+    bytes = scratch;
+    width = sizeof(uint64_t);
+  }
+  shuffle(bytes, n, width, shuffled);
+
+  uLongf num_bytes = (uLongf)(*out_size);
+  int status = compress2(out, &num_bytes, shuffled, (uLong)(n * width), Z_BEST_SPEED);
+  *out_size = (size_t)num_bytes;
+  *chunk_mode = mode;
+  return status;
+}
+
+// Decompresses a chunk of n values, compressed in the given mode, from the
+// given in_size bytes of in, using scratch (which has room for 2*n 64-bit
+// values). Returns the zlib status of the decompression (Z_DATA_ERROR if it 
+// produced the wrong number of bytes). Like compress_chunk, this leaves 
+// errors to the caller.
+static int decompress_chunk(const uint8_t* in, size_t in_size, int mode,
+                             real_t error_bound, size_t n,
+                             uint8_t* scratch, real_t* values)
+{
+  size_t width = (mode == CHUNK_QUANTIZED) ? sizeof(uint64_t) : sizeof(real_t);
+  uint8_t* shuffled = &scratch[n * sizeof(uint64_t)];
+  uLongf num_bytes = (uLongf)(n * width);
+  int status = uncompress(shuffled, &num_bytes, in, (uLong)in_size);
+  if (status != Z_OK)
+    return status;
+  if (num_bytes != (uLongf)(n * width))
+    return Z_DATA_ERROR;
+  if (mode == CHUNK_QUANTIZED)
+  {
+    unshuffle(shuffled, n, width, scratch);
+    dequantize((uint64_t*)scratch, n, error_bound, values);
+  }
+  else
+    unshuffle(shuffled, n, width, (uint8_t*)values);
+  return Z_OK;
+}
+
+void silo_file_write_compressed_reals(silo_file_t* file,
+                                      const char* object_name,
+                                      const char* var_name,
+                                      real_t* data,
+                                      size_t size)
+{
+  START_FUNCTION_TIMER();
+  silo_compression_t method;
+  real_t error_bound;
+  silo_file_get_compression(file, object_name, &method, &error_bound);
+  ASSERT(size > 0);
+  if (method == SILO_COMPRESSION_NONE)
+  {
+    // Write the data as is.
+    silo_file_write_var(file, var_name, data, (int)size, SILO_FLOAT_TYPE);
+    STOP_FUNCTION_TIMER();
+    return;
+  }
+
+  // Set up buffers for each chunk so that they can be compressed
+  // independently, and scratch space for each thread.
+  int num_chunks = (int)((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+  size_t max_chunk_bytes = (size_t)compressBound((uLong)(CHUNK_SIZE * sizeof(uint64_t)));
+  uint8_t* buffers = polymec_malloc(sizeof(uint8_t) * num_chunks * max_chunk_bytes);
+#if POLYMEC_HAVE_OPENMP
+  int num_threads = MIN(omp_get_max_threads(), num_chunks);
+#else
+  int num_threads = 1;
+#endif
+  size_t scratch_bytes = sizeof(uint64_t) * 2 * CHUNK_SIZE;
+  uint8_t* scratch = polymec_malloc(num_threads * scratch_bytes);
+  size_t chunk_bytes[num_chunks];
+  int chunk_modes[num_chunks], chunk_status[num_chunks];
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (int c = 0; c < num_chunks; ++c)
+  {
+#if POLYMEC_HAVE_OPENMP
+    int tid = omp_get_thread_num();
+#else
+    int tid = 0;
+#endif
+    size_t offset = c * CHUNK_SIZE;
+    size_t n = MIN(CHUNK_SIZE, size - offset);
+    chunk_bytes[c] = max_chunk_bytes;
+    chunk_status[c] = compress_chunk(&data[offset], n, method, error_bound,
+                                     &scratch[tid * scratch_bytes],
+                                     &buffers[c * max_chunk_bytes], &chunk_bytes[c],
+                                     &chunk_modes[c]);
+  }
+  for (int c = 0; c < num_chunks; ++c)
+  {
+    if (chunk_status[c] != Z_OK)
+      polymec_error("silo_file: compression of chunk %d of '%s' failed (zlib error %d).", 
+                    c, var_name, chunk_status[c]);
+  }
+
+  // Pack the compressed chunks together, and write them along with a header
+  // that describes them. The header holds 64-bit values so that it can
+  // describe arrays of any size.
+  int header_size = 4 + 2 * num_chunks;
+  int64_t* header = polymec_malloc(sizeof(int64_t) * header_size);
+  header[0] = (int64_t)method;
+  header[1] = (int64_t)size;
+  header[2] = (int64_t)CHUNK_SIZE;
+  header[3] = (int64_t)num_chunks;
+  size_t num_bytes = 0;
+  for (int c = 0; c < num_chunks; ++c)
+  {
+    memmove(&buffers[num_bytes], &buffers[c * max_chunk_bytes], chunk_bytes[c]);
+    num_bytes += chunk_bytes[c];
+    header[4+2*c]   = (int64_t)chunk_modes[c];
+    header[4+2*c+1] = (int64_t)chunk_bytes[c];
+  }
+  if (num_bytes > INT_MAX)
+    polymec_error("silo_file: compressed data for '%s' is too large.", var_name);
+
+  char name[FILENAME_MAX+1];
+  snprintf(name, FILENAME_MAX, "%s_zheader", var_name);
+  silo_file_write_var(file, name, header, header_size, DB_LONG_LONG);
+  if (method == SILO_COMPRESSION_LOSSY)
+  {
+    double bound = (double)error_bound;
+    snprintf(name, FILENAME_MAX, "%s_zbound", var_name);
+    silo_file_write_var(file, name, &bound, 1, DB_DOUBLE);
+  }
+  snprintf(name, FILENAME_MAX, "%s_zdata", var_name);
+  silo_file_write_var(file, name, buffers, (int)num_bytes, DB_CHAR);
+  log_debug("silo_file: Compressed %s from %zu to %zu bytes.", var_name,
+            size * sizeof(real_t), num_bytes);
+
+  polymec_free(header);
+  polymec_free(scratch);
+  polymec_free(buffers);
+  STOP_FUNCTION_TIMER();
+}
+
+bool silo_file_contains_compressed_reals(silo_file_t* file,
+                                         const char* var_name)
+{
+  char header_name[FILENAME_MAX+1];
+  snprintf(header_name, FILENAME_MAX, "%s_zheader", var_name);
+  return (silo_file_contains_var(file, var_name) ||
+          silo_file_contains_var(file, header_name));
+}
+
+real_t* silo_file_read_compressed_reals(silo_file_t* file,
+                                        const char* var_name,
+                                        size_t* size)
+{
+  START_FUNCTION_TIMER();
+  char name[FILENAME_MAX+1];
+  snprintf(name, FILENAME_MAX, "%s_zheader", var_name);
+  if (!silo_file_contains_var(file, name))
+  {
+    // The data was written as is.
+    real_t* data = NULL;
+    *size = 0;
+    if (silo_file_contains_var(file, var_name))
+    {
+      *size = (size_t)silo_file_var_length(file, var_name);
+      data = polymec_malloc(sizeof(real_t) * MAX(*size, 1));
+      silo_file_read_var(file, var_name, data);
+    }
+    STOP_FUNCTION_TIMER();
+    return data;
+  }
+
+  // Read the header and the compressed data.
+  int header_size = silo_file_var_length(file, name);
+  int64_t* header = polymec_malloc(sizeof(int64_t) * header_size);
+  silo_file_read_var(file, name, header);
+  silo_compression_t method = (silo_compression_t)header[0];
+  *size = (size_t)header[1];
+  size_t chunk_size = (size_t)header[2];
+  int num_chunks = (int)header[3];
+  ASSERT(header_size == 4 + 2 * num_chunks);
+  real_t error_bound = 0.0;
+  if (method == SILO_COMPRESSION_LOSSY)
+  {
+    double bound;
+    snprintf(name, FILENAME_MAX, "%s_zbound", var_name);
+    silo_file_read_var(file, name, &bound);
+    error_bound = (real_t)bound;
+  }
+  snprintf(name, FILENAME_MAX, "%s_zdata", var_name);
+  uint8_t* bytes = polymec_malloc(sizeof(uint8_t) * silo_file_var_length(file, name));
+  silo_file_read_var(file, name, bytes);
+
+  // Decompress the chunks.
+  size_t chunk_offsets[num_chunks];
+  chunk_offsets[0] = 0;
+  for (int c = 1; c < num_chunks; ++c)
+    chunk_offsets[c] = chunk_offsets[c-1] + (size_t)header[4+2*(c-1)+1];
+  real_t* data = polymec_malloc(sizeof(real_t) * *size);
+#if POLYMEC_HAVE_OPENMP
+  int num_threads = MIN(omp_get_max_threads(), num_chunks);
+#else
+  int num_threads = 1;
+#endif
+  size_t scratch_bytes = sizeof(uint64_t) * 2 * chunk_size;
+  uint8_t* scratch = polymec_malloc(num_threads * scratch_bytes);
+  int chunk_status[num_chunks];
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+  for (int c = 0; c < num_chunks; ++c)
+  {
+#if POLYMEC_HAVE_OPENMP
+    int tid = omp_get_thread_num();
+#else
+    int tid = 0;
+#endif
+    size_t offset = c * chunk_size;
+    size_t n = MIN(chunk_size, *size - offset);
+    chunk_status[c] = decompress_chunk(&bytes[chunk_offsets[c]], (size_t)header[4+2*c+1],
+                                       (int)header[4+2*c], error_bound, n,
+                                       &scratch[tid * scratch_bytes],
+                                       &data[offset]);
+  }
+  for (int c = 0; c < num_chunks; ++c)
+  {
+    if (chunk_status[c] != Z_OK)
+      polymec_error("silo_file: decompression of chunk %d of '%s' failed (zlib error %d).", 
+                    c, var_name, chunk_status[c]);
+  }
+
+  polymec_free(header);
+  polymec_free(scratch);
+  polymec_free(bytes);
+  STOP_FUNCTION_TIMER();
+  return data;
+}
@@ -37,6 +37,21 @@ extern string_ptr_unordered_map_t* silo_file_scratch(silo_file_t* file);
 extern void silo_file_write_field_metadata(silo_file_t* file, const char* md_name, field_metadata_t* md);
 extern void silo_file_read_field_metadata(silo_file_t* file, const char* md_name, field_metadata_t* md);
 extern bool silo_file_contains_field_metadata(silo_file_t* file, const char* md_name);
+extern bool silo_file_is_remapped(silo_file_t* file);
+extern void silo_file_set_domain(silo_file_t* file, int domain);
+extern void silo_file_reset_domain(silo_file_t* file);
+extern void silo_file_get_remapped_range(silo_file_t* file, int num_items, int* start, int* end);
+extern int_array_t* silo_file_gather_domain_tuples(silo_file_t* file, const char* array_name, int tuple_size);
+extern bool silo_file_aggregates_unimesh_fields(silo_file_t* file, bool* write_patch_views);
+extern void silo_file_write_compressed_reals(silo_file_t* file, const char* object_name, const char* var_name, real_t* data, size_t size);
+extern bool silo_file_contains_compressed_reals(silo_file_t* file, const char* var_name);
+extern void silo_file_write_var(silo_file_t* file, const char* var_name, void* data, int size, int datatype);
+extern bool silo_file_contains_var(silo_file_t* file, const char* var_name);
+extern int silo_file_var_length(silo_file_t* file, const char* var_name);
+extern void silo_file_read_var(silo_file_t* file, const char* var_name, void* data);
+extern void silo_file_write_mappable_var(silo_file_t* file, const char* var_name, void* data, size_t size, int datatype);
+extern void* silo_file_map_var(silo_file_t* file, const char* var_name, int datatype, size_t size, void** data);
+extern real_t* silo_file_read_compressed_reals(silo_file_t* file, const char* var_name, size_t* size);
 
 static void write_unimesh_patch_grid(silo_file_t* file,
                                      const char* patch_grid_name,
@@ -277,6 +292,28 @@ static void read_unimesh_patch_indices(silo_file_t* file,
   polymec_free(indices);
 }
 
+// Returns the indices (i, j, k) of all patches of the given unimesh in a
+// remapped file, each followed by the domain that wrote it. These are
+// gathered once and stashed in the file's scratch space.
+static int_array_t* remapped_unimesh_patches(silo_file_t* file,
+                                             const char* mesh_name)
+{
+  string_ptr_unordered_map_t* scratch = silo_file_scratch(file);
+  char patches_name[FILENAME_MAX+1];
+  snprintf(patches_name, FILENAME_MAX, "%s_remapped_patches", mesh_name);
+  int_array_t** patches_p = (int_array_t**)string_ptr_unordered_map_get(scratch, patches_name);
+  if (patches_p != NULL)
+    return *patches_p;
+
+  char array_name[FILENAME_MAX+1];
+  snprintf(array_name, FILENAME_MAX, "%s_patch_indices", mesh_name);
+  int_array_t* patches = silo_file_gather_domain_tuples(file, array_name, 3);
+  string_ptr_unordered_map_insert_with_kv_dtors(scratch, string_dup(patches_name),
+                                                patches, string_free,
+                                                DTOR(int_array_free));
+  return patches;
+}
+
 unimesh_t* silo_file_read_unimesh(silo_file_t* file,
                                   const char* mesh_name)
 {
@@ -312,21 +349,35 @@ unimesh_t* silo_file_read_unimesh(silo_file_t* file,
                                          nx, ny, nz,
                                          x_periodic, y_periodic, z_periodic);
 
+  silo_file_pop_dir(file);
+
   // Fill it with patches whose indices we read from the file.
-  int_array_t* i_array = int_array_new();
-  int_array_t* j_array = int_array_new();
-  int_array_t* k_array = int_array_new();
-  read_unimesh_patch_indices(file, mesh_name, i_array, j_array, k_array);
-  for (size_t p = 0; p < i_array->size; ++p)
-    unimesh_insert_patch(mesh, i_array->data[p], j_array->data[p], k_array->data[p]);
-  int_array_free(i_array);
-  int_array_free(j_array);
-  int_array_free(k_array);
+  if (silo_file_is_remapped(file))
+  {
+    // The file was written by a different number of processes, so we take
+    // a contiguous slice of all patches, ordered by the processes that
+    // wrote them.
+    int_array_t* patches = remapped_unimesh_patches(file, mesh_name);
+    int start, end;
+    silo_file_get_remapped_range(file, (int)(patches->size/4), &start, &end);
+    for (int p = start; p < end; ++p)
+      unimesh_insert_patch(mesh, patches->data[4*p], patches->data[4*p+1], patches->data[4*p+2]);
+  }
+  else
+  {
+    int_array_t* i_array = int_array_new();
+    int_array_t* j_array = int_array_new();
+    int_array_t* k_array = int_array_new();
+    read_unimesh_patch_indices(file, mesh_name, i_array, j_array, k_array);
+    for (size_t p = 0; p < i_array->size; ++p)
+      unimesh_insert_patch(mesh, i_array->data[p], j_array->data[p], k_array->data[p]);
+    int_array_free(i_array);
+    int_array_free(j_array);
+    int_array_free(k_array);
+  }
 
   unimesh_finalize(mesh);
 
-  silo_file_pop_dir(file);
-
   STOP_FUNCTION_TIMER();
   return mesh;
 }
@@ -349,7 +400,8 @@ bool silo_file_contains_unimesh(silo_file_t* file,
     {
       char data_name[FILENAME_MAX+1];
       snprintf(data_name, FILENAME_MAX, "%s_%s", mesh_name, data_fields[i]);
-      exists = DBInqVarExists(dbfile, data_name);
+      exists = (i == 0) ? silo_file_contains_compressed_reals(file, data_name)
+                        : silo_file_contains_var(file, data_name);
       if (!exists) break;
     }
   }
@@ -357,6 +409,38 @@ bool silo_file_contains_unimesh(silo_file_t* file,
   return exists;
 }
 
+// Returns the number of values in each component of the given patch's data,
+// excluding ghost cells.
+static size_t num_unimesh_patch_values(unimesh_patch_t* patch)
+{
+  int nx = patch->nx, ny = patch->ny, nz = patch->nz;
+  switch (patch->centering)
+  {
+    case UNIMESH_NODE: return (nx+1)*(ny+1)*(nz+1);
+    case UNIMESH_XEDGE: return nx*(ny+1)*(nz+1);
+    case UNIMESH_YEDGE: return (nx+1)*ny*(nz+1);
+    case UNIMESH_ZEDGE: return (nx+1)*(ny+1)*nz;
+    case UNIMESH_XFACE: return (nx+1)*ny*nz;
+    case UNIMESH_YFACE: return nx*(ny+1)*nz;
+    case UNIMESH_ZFACE: return nx*ny*(nz+1);
+    default: return nx*ny*nz;
+  }
+}
+
+// Returns the offset of the given patch's data within the Silo quadvar for
+// one of its components. Edge and face quadvars store x, y, and z data in
+// consecutive blocks, each the size of the patch's node data.
+static size_t unimesh_quadvar_offset(unimesh_patch_t* patch)
+{
+  size_t num_nodes = (patch->nx+1)*(patch->ny+1)*(patch->nz+1);
+  if ((patch->centering == UNIMESH_YEDGE) || (patch->centering == UNIMESH_YFACE))
+    return num_nodes;
+  else if ((patch->centering == UNIMESH_ZEDGE) || (patch->centering == UNIMESH_ZFACE))
+    return 2*num_nodes;
+  else
+    return 0;
+}
+
 static void query_unimesh_vector_comps(unimesh_patch_t* patch,
                                        field_metadata_t* md,
                                        coord_mapping_t* mapping,
@@ -1056,6 +1140,103 @@ static void copy_out_other_centerings(silo_file_t* file,
   }
 }
 
+// Copies component c of the given patch into the given quadvar data array.
+static void copy_out_unimesh_component(unimesh_patch_t* patch,
+                                       field_metadata_t* md,
+                                       int c,
+                                       bbox_t* bbox,
+                                       coord_mapping_t* mapping,
+                                       real_t* data)
+{
+  switch (patch->centering)
+  {
+    case UNIMESH_NODE:
+      copy_out_unimesh_node_component(patch, md, c, bbox, mapping, data);
+      break;
+    case UNIMESH_XEDGE:
+      copy_out_unimesh_xedge_component(patch, md, c, bbox, mapping, data);
+      break;
+    case UNIMESH_YEDGE:
+      copy_out_unimesh_yedge_component(patch, md, c, bbox, mapping, data);
+      break;
+    case UNIMESH_ZEDGE:
+      copy_out_unimesh_zedge_component(patch, md, c, bbox, mapping, data);
+      break;
+    case UNIMESH_XFACE:
+      copy_out_unimesh_xface_component(patch, md, c, bbox, mapping, data);
+      break;
+    case UNIMESH_YFACE:
+      copy_out_unimesh_yface_component(patch, md, c, bbox, mapping, data);
+      break;
+    case UNIMESH_ZFACE:
+      copy_out_unimesh_zface_component(patch, md, c, bbox, mapping, data);
+      break;
+    default:
+      copy_out_unimesh_cell_component(patch, md, c, bbox, mapping, data);
+  }
+}
+
+// Names of unimesh centerings, as used in the names of aggregated fields.
+static const char* unimesh_centering_names[] = {"cell", "xface", "yface",
+                                                "zface", "xedge", "yedge",
+                                                "zedge", "node"};
+
+// Writes the data for all patches of the given field on this process to
+// the (already pushed) domain directory of the given file. The data goes into
+// a single array ordered by component, then by patch, and the (i, j, k)
+// indices of the patches go into a second array.
+static void write_aggregated_unimesh_field(silo_file_t* file,
+                                           const char* field_name,
+                                           unimesh_field_t* field,
+                                           coord_mapping_t* mapping)
+{
+  int num_patches = unimesh_field_num_patches(field);
+  if (num_patches == 0) return;
+  int num_components = unimesh_field_num_components(field);
+  field_metadata_t* md = unimesh_field_metadata(field);
+
+  int* indices = polymec_malloc(sizeof(int) * 3 * num_patches);
+  real_t *patch_data = NULL, *data = NULL;
+  size_t size = 0, offset = 0;
+  unimesh_patch_t* patch;
+  int pos = 0, i, j, k, p = 0;
+  bbox_t bbox;
+  while (unimesh_field_next_patch(field, &pos, &i, &j, &k, &patch, &bbox))
+  {
+    // All patches in a field have the same size and centering.
+    if (data == NULL)
+    {
+      size = num_unimesh_patch_values(patch);
+      offset = unimesh_quadvar_offset(patch);
+      patch_data = polymec_malloc(sizeof(real_t) * (offset + size));
+      data = polymec_malloc(sizeof(real_t) * num_components * num_patches * size);
+    }
+    indices[3*p]   = i;
+    indices[3*p+1] = j;
+    indices[3*p+2] = k;
+    for (int c = 0; c < num_components; ++c)
+    {
+      copy_out_unimesh_component(patch, md, c, &bbox, mapping, patch_data);
+      memcpy(&data[(c*num_patches + p)*size], &patch_data[offset],
+             sizeof(real_t) * size);
+    }
+    ++p;
+  }
+  ASSERT(p == num_patches);
+
+  const char* centering = unimesh_centering_names[unimesh_field_centering(field)];
+  char array_name[FILENAME_MAX+1];
+  snprintf(array_name, FILENAME_MAX, "%s_%s_agg_patches", field_name, centering);
+  silo_file_write_var(file, array_name, indices, 3 * num_patches, DB_INT);
+  snprintf(array_name, FILENAME_MAX, "%s_%s_agg_data", field_name, centering);
+  silo_file_write_compressed_reals(file, field_name, array_name, data,
+                                   num_components * num_patches * size);
+
+  polymec_free(data);
+  polymec_free(patch_data);
+  polymec_free(indices);
+}
+
 static void write_unimesh_patch_data(silo_file_t* file,
                                      const char** field_component_names,
                                      const char* patch_grid_name,
@@ -1170,6 +1351,20 @@ void silo_file_write_unimesh_field(silo_file_t* file,
   snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
   silo_file_write_field_metadata(file, md_name, md);
 
+  // If we're aggregating fields, write all of our patches at once, and
+  // stop there unless we've been asked for per-patch views.
+  bool write_patch_views;
+  if (silo_file_aggregates_unimesh_fields(file, &write_patch_views))
+  {
+    write_aggregated_unimesh_field(file, field_name, field, mapping);
+    if (!write_patch_views)
+    {
+      silo_file_pop_dir(file);
+      STOP_FUNCTION_TIMER();
+      return;
+    }
+  }
+
   unimesh_patch_t* patch;
   int pos = 0, i, j, k, l = 0;
   bbox_t bbox;
@@ -1221,15 +1416,11 @@ void silo_file_write_unimesh_field(silo_file_t* file,
   STOP_FUNCTION_TIMER();
 }
 
-static void copy_in_unimesh_node_component(DBquadvar* var,
+static void copy_in_unimesh_node_component(real_t* data,
                                            int c,
                                            unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
   int l = 0;
-  real_t* data = (real_t*)var->vals[0];
   DECLARE_UNIMESH_NODE_ARRAY(a, patch);
   for (int i = 0; i <= patch->nx; ++i)
     for (int j = 0; j <= patch->ny; ++j)
@@ -1237,15 +1428,11 @@ static void copy_in_unimesh_node_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_xedge_component(DBquadvar* var,
+static void copy_in_unimesh_xedge_component(real_t* data,
                                             int c,
                                             unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
   int l = 0;
-  real_t* data = (real_t*)var->vals[0];
   DECLARE_UNIMESH_XEDGE_ARRAY(a, patch);
   for (int i = 0; i < patch->nx; ++i)
     for (int j = 0; j <= patch->ny; ++j)
@@ -1253,15 +1440,11 @@ static void copy_in_unimesh_xedge_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_yedge_component(DBquadvar* var,
+static void copy_in_unimesh_yedge_component(real_t* data,
                                             int c,
                                             unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
-  int l = var->dims[0]*var->dims[1]*var->dims[2];
-  real_t* data = (real_t*)var->vals[0];
+  int l = 0;
   DECLARE_UNIMESH_YEDGE_ARRAY(a, patch);
   for (int i = 0; i <= patch->nx; ++i)
     for (int j = 0; j < patch->ny; ++j)
@@ -1269,15 +1452,11 @@ static void copy_in_unimesh_yedge_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_zedge_component(DBquadvar* var,
+static void copy_in_unimesh_zedge_component(real_t* data,
                                             int c,
                                             unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
-  int l = 2*var->dims[0]*var->dims[1]*var->dims[2];
-  real_t* data = (real_t*)var->vals[0];
+  int l = 0;
   DECLARE_UNIMESH_ZEDGE_ARRAY(a, patch);
   for (int i = 0; i <= patch->nx; ++i)
     for (int j = 0; j <= patch->ny; ++j)
@@ -1285,15 +1464,11 @@ static void copy_in_unimesh_zedge_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_xface_component(DBquadvar* var,
+static void copy_in_unimesh_xface_component(real_t* data,
                                             int c,
                                             unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
   int l = 0;
-  real_t* data = (real_t*)var->vals[0];
   DECLARE_UNIMESH_XFACE_ARRAY(a, patch);
   for (int i = 0; i <= patch->nx; ++i)
     for (int j = 0; j < patch->ny; ++j)
@@ -1301,15 +1476,11 @@ static void copy_in_unimesh_xface_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_yface_component(DBquadvar* var,
+static void copy_in_unimesh_yface_component(real_t* data,
                                             int c,
                                             unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
-  int l = var->dims[0]*var->dims[1]*var->dims[2];
-  real_t* data = (real_t*)var->vals[0];
+  int l = 0;
   DECLARE_UNIMESH_YFACE_ARRAY(a, patch);
   for (int i = 0; i < patch->nx; ++i)
     for (int j = 0; j <= patch->ny; ++j)
@@ -1317,15 +1488,11 @@ static void copy_in_unimesh_yface_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_zface_component(DBquadvar* var,
+static void copy_in_unimesh_zface_component(real_t* data,
                                             int c,
                                             unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx + 1);
-  ASSERT(var->dims[1] == patch->ny + 1);
-  ASSERT(var->dims[2] == patch->nz + 1);
-  int l = 2*var->dims[0]*var->dims[1]*var->dims[2];
-  real_t* data = (real_t*)var->vals[0];
+  int l = 0;
   DECLARE_UNIMESH_ZFACE_ARRAY(a, patch);
   for (int i = 0; i < patch->nx; ++i)
     for (int j = 0; j < patch->ny; ++j)
@@ -1333,15 +1500,11 @@ static void copy_in_unimesh_zface_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
-static void copy_in_unimesh_cell_component(DBquadvar* var,
+static void copy_in_unimesh_cell_component(real_t* data,
                                            int c,
                                            unimesh_patch_t* patch)
 {
-  ASSERT(var->dims[0] == patch->nx);
-  ASSERT(var->dims[1] == patch->ny);
-  ASSERT(var->dims[2] == patch->nz);
   int l = 0;
-  real_t* data = (real_t*)var->vals[0];
   DECLARE_UNIMESH_CELL_ARRAY(a, patch);
   for (int i = 1; i <= patch->nx; ++i)
     for (int j = 1; j <= patch->ny; ++j)
@@ -1349,6 +1512,40 @@ static void copy_in_unimesh_cell_component(DBquadvar* var,
         a[i][j][k][c] = data[l];
 }
 
+// Copies the given data for component c of the given patch into the patch.
+// The data consists only of the values for the patch's centering.
+static void copy_in_unimesh_component(real_t* data,
+                                      int c,
+                                      unimesh_patch_t* patch)
+{
+  switch (patch->centering)
+  {
+    case UNIMESH_NODE:
+      copy_in_unimesh_node_component(data, c, patch);
+      break;
+    case UNIMESH_XEDGE:
+      copy_in_unimesh_xedge_component(data, c, patch);
+      break;
+    case UNIMESH_YEDGE:
+      copy_in_unimesh_yedge_component(data, c, patch);
+      break;
+    case UNIMESH_ZEDGE:
+      copy_in_unimesh_zedge_component(data, c, patch);
+      break;
+    case UNIMESH_XFACE:
+      copy_in_unimesh_xface_component(data, c, patch);
+      break;
+    case UNIMESH_YFACE:
+      copy_in_unimesh_yface_component(data, c, patch);
+      break;
+    case UNIMESH_ZFACE:
+      copy_in_unimesh_zface_component(data, c, patch);
+      break;
+    default:
+      copy_in_unimesh_cell_component(data, c, patch);
+  }
+}
+
 static void read_unimesh_patch_data(silo_file_t* file,
                                     const char** field_component_names,
                                     const char* patch_grid_name,
@@ -1365,33 +1562,13 @@ static void read_unimesh_patch_data(silo_file_t* file,
     ASSERT(var != NULL);
     ASSERT(var->datatype == SILO_FLOAT_TYPE);
     ASSERT(var->nvals == 1);
-    switch (patch->centering)
-    {
-      // Copy the data in the component into our array.
-      case UNIMESH_NODE:
-        copy_in_unimesh_node_component(var, c, patch);
-        break;
-      case UNIMESH_XEDGE:
-        copy_in_unimesh_xedge_component(var, c, patch);
-        break;
-      case UNIMESH_YEDGE:
-        copy_in_unimesh_yedge_component(var, c, patch);
-        break;
-      case UNIMESH_ZEDGE:
-        copy_in_unimesh_zedge_component(var, c, patch);
-        break;
-      case UNIMESH_XFACE:
-        copy_in_unimesh_xface_component(var, c, patch);
-        break;
-      case UNIMESH_YFACE:
-        copy_in_unimesh_yface_component(var, c, patch);
-        break;
-      case UNIMESH_ZFACE:
-        copy_in_unimesh_zface_component(var, c, patch);
-        break;
-      default:
-        copy_in_unimesh_cell_component(var, c, patch);
-    }
+    ASSERT(var->dims[0] == patch->nx + ((patch->centering == UNIMESH_CELL) ? 0 : 1));
+    ASSERT(var->dims[1] == patch->ny + ((patch->centering == UNIMESH_CELL) ? 0 : 1));
+    ASSERT(var->dims[2] == patch->nz + ((patch->centering == UNIMESH_CELL) ? 0 : 1));
+
+    // Copy the data in the component into our array.
+    real_t* data = (real_t*)var->vals[0];
+    copy_in_unimesh_component(&data[unimesh_quadvar_offset(patch)], c, patch);
 
     // Extract metadata.
     field_metadata_set_name(md, c, var->label);
@@ -1403,23 +1580,133 @@ static void read_unimesh_patch_data(silo_file_t* file,
   }
 }
 
+// This type holds the aggregated data for a field written by one domain.
+// If the field wasn't aggregated, data is NULL.
+typedef struct
+{
+  int num_patches;
+  int_int_unordered_map_t* patch_positions; // maps patch keys to positions
+  real_t* data;
+} aggregated_unimesh_data_t;
+
+static void aggregated_unimesh_data_free(aggregated_unimesh_data_t* agg)
+{
+  if (agg->patch_positions != NULL)
+    int_int_unordered_map_free(agg->patch_positions);
+  if (agg->data != NULL)
+    polymec_free(agg->data);
+  polymec_free(agg);
+}
+
+// Reads the aggregated data for the field with the given name and centering
+// from the (already pushed) domain directory of the given file. Patches are
+// keyed by npy*npz*i + npz*j + k.
+static aggregated_unimesh_data_t* read_aggregated_unimesh_data(silo_file_t* file,
+                                                               const char* field_name,
+                                                               unimesh_centering_t centering,
+                                                               int npy,
+                                                               int npz)
+{
+  aggregated_unimesh_data_t* agg = polymec_malloc(sizeof(aggregated_unimesh_data_t));
+  agg->num_patches = 0;
+  agg->patch_positions = NULL;
+  agg->data = NULL;
+
+  char indices_name[FILENAME_MAX+1], data_name[FILENAME_MAX+1];
+  snprintf(indices_name, FILENAME_MAX, "%s_%s_agg_patches", field_name,
+           unimesh_centering_names[centering]);
+  snprintf(data_name, FILENAME_MAX, "%s_%s_agg_data", field_name,
+           unimesh_centering_names[centering]);
+  if (silo_file_contains_var(file, indices_name) &&
+      silo_file_contains_compressed_reals(file, data_name))
+  {
+    agg->num_patches = silo_file_var_length(file, indices_name) / 3;
+    int* indices = polymec_malloc(sizeof(int) * 3 * agg->num_patches);
+    silo_file_read_var(file, indices_name, indices);
+    agg->patch_positions = int_int_unordered_map_new();
+    for (int p = 0; p < agg->num_patches; ++p)
+    {
+      int key = npy*npz*indices[3*p] + npz*indices[3*p+1] + indices[3*p+2];
+      int_int_unordered_map_insert(agg->patch_positions, key, p);
+    }
+    polymec_free(indices);
+
+    size_t data_size;
+    agg->data = silo_file_read_compressed_reals(file, data_name, &data_size);
+  }
+  return agg;
+}
+
 void silo_file_read_unimesh_field(silo_file_t* file,
                                   const char* field_name,
                                   const char* mesh_name,
                                   unimesh_field_t* field)
 {
   START_FUNCTION_TIMER();
-  silo_file_push_domain_dir(file);
 
   field_metadata_t* md = unimesh_field_metadata(field);
   char md_name[FILENAME_MAX+1];
   snprintf(md_name, FILENAME_MAX, "%s_%s_md", field_name, mesh_name);
   silo_file_read_field_metadata(file, md_name, md);
 
+  // If the file was written by a different number of processes, find the
+  // domain that wrote each patch.
+  int_int_unordered_map_t* patch_domains = NULL;
+  int npx, npy, npz;
+  unimesh_get_extents(unimesh_field_mesh(field), &npx, &npy, &npz);
+  if (silo_file_is_remapped(file))
+  {
+    int_array_t* patches = remapped_unimesh_patches(file, mesh_name);
+    patch_domains = int_int_unordered_map_new();
+    for (size_t p = 0; p < patches->size/4; ++p)
+    {
+      int* patch_p = &patches->data[4*p];
+      int index = npy*npz*patch_p[0] + npz*patch_p[1] + patch_p[2];
+      int_int_unordered_map_insert(patch_domains, index, patch_p[3]);
+    }
+  }
+
+  // Aggregated data, read as needed from each domain.
+  int_ptr_unordered_map_t* aggregates = int_ptr_unordered_map_new();
+
   unimesh_patch_t* patch;
   int pos = 0, i, j, k;
   while (unimesh_field_next_patch(field, &pos, &i, &j, &k, &patch, NULL))
   {
+    int key = npy*npz*i + npz*j + k, domain = 0;
+    if (patch_domains != NULL)
+    {
+      int* domain_p = int_int_unordered_map_get(patch_domains, key);
+      ASSERT(domain_p != NULL);
+      domain = *domain_p;
+      silo_file_set_domain(file, domain);
+    }
+    silo_file_push_domain_dir(file);
+
+    // If the field was aggregated, copy the patch's data out of the
+    // aggregate.
+    aggregated_unimesh_data_t** agg_p =
+      (aggregated_unimesh_data_t**)int_ptr_unordered_map_get(aggregates, domain);
+    aggregated_unimesh_data_t* agg;
+    if (agg_p != NULL)
+      agg = *agg_p;
+    else
+    {
+      agg = read_aggregated_unimesh_data(file, field_name, patch->centering, npy, npz);
+      int_ptr_unordered_map_insert_with_v_dtor(aggregates, domain, agg,
+                                               DTOR(aggregated_unimesh_data_free));
+    }
+    if (agg->data != NULL)
+    {
+      int* p_ptr = int_int_unordered_map_get(agg->patch_positions, key);
+      ASSERT(p_ptr != NULL);
+      size_t size = num_unimesh_patch_values(patch);
+      for (int c = 0; c < patch->nc; ++c)
+        copy_in_unimesh_component(&agg->data[(c*agg->num_patches + *p_ptr)*size], c, patch);
+      silo_file_pop_dir(file);
+      continue;
+    }
+
     char* field_names[patch->nc];
     for (int c = 0; c < patch->nc; ++c)
     {
@@ -1431,8 +1718,14 @@ void silo_file_read_unimesh_field(silo_file_t* file,
                             patch->nc, patch, md);
     for (int c = 0; c < patch->nc; ++c)
       string_free(field_names[c]);
+    silo_file_pop_dir(file);
+  }
+  int_ptr_unordered_map_free(aggregates);
+  if (patch_domains != NULL)
+  {
+    int_int_unordered_map_free(patch_domains);
+    silo_file_reset_domain(file);
   }
-  silo_file_pop_dir(file);
   STOP_FUNCTION_TIMER();
 }
 
@@ -1452,3 +1745,130 @@ bool silo_file_contains_unimesh_field(silo_file_t* file,
   return result;
 }
 
+void silo_file_write_unimesh_field_buffer(silo_file_t* file,
+                                          const char* field_name,
+                                          const char* mesh_name,
+                                          unimesh_field_t* field)
+{
+  START_FUNCTION_TIMER();
+  silo_file_push_domain_dir(file);
+
+  char md_name[FILENAME_MAX+1];
+  snprintf(md_name, FILENAME_MAX, "%s_%s_buffer_md", field_name, mesh_name);
+  silo_file_write_field_metadata(file, md_name, unimesh_field_metadata(field));
+
+  // Write the indices of our patches in the order they appear in the buffer
+  // so that we can make sure they match those of the field we map it into.
+  int num_patches = unimesh_field_num_patches(field);
+  int* indices = polymec_malloc(sizeof(int) * 3 * MAX(num_patches, 1));
+  int pos = 0, i, j, k, p = 0;
+  while (unimesh_next_patch(unimesh_field_mesh(field), &pos, &i, &j, &k, NULL))
+  {
+    indices[3*p]   = i;
+    indices[3*p+1] = j;
+    indices[3*p+2] = k;
+    ++p;
+  }
+  const char* centering = unimesh_centering_names[unimesh_field_centering(field)];
+  char var_name[FILENAME_MAX+1];
+  snprintf(var_name, FILENAME_MAX, "%s_%s_%s_buffer_patches", field_name,
+           mesh_name, centering);
+  silo_file_write_mappable_var(file, var_name, indices, 3 * num_patches, DB_INT);
+  polymec_free(indices);
+
+  // Write the buffer itself.
+  unimesh_t* mesh = unimesh_field_mesh(field);
+  int nx, ny, nz;
+  unimesh_get_patch_size(mesh, &nx, &ny, &nz);
+  size_t size = num_patches *
+    unimesh_patch_data_size(unimesh_field_centering(field), nx, ny, nz,
+                            unimesh_field_num_components(field)) / sizeof(real_t);
+  snprintf(var_name, FILENAME_MAX, "%s_%s_%s_buffer", field_name, mesh_name,
+           centering);
+  silo_file_write_mappable_var(file, var_name, unimesh_field_buffer(field),
+                               size, SILO_FLOAT_TYPE);
+
+  silo_file_pop_dir(file);
+  STOP_FUNCTION_TIMER();
+}
+
+bool silo_file_map_unimesh_field(silo_file_t* file,
+                                 const char* field_name,
+                                 const char* mesh_name,
+                                 unimesh_field_t* field)
+{
+  START_FUNCTION_TIMER();
+
+  // A remapped file's domains don't line up with our patches.
+  if (silo_file_is_remapped(file))
+  {
+    STOP_FUNCTION_TIMER();
+    return false;
+  }
+
+  silo_file_push_domain_dir(file);
+  bool mapped = false;
+
+  // Make sure the buffer holds the patches we expect.
+  const char* centering = unimesh_centering_names[unimesh_field_centering(field)];
+  char var_name[FILENAME_MAX+1];
+  snprintf(var_name, FILENAME_MAX, "%s_%s_%s_buffer_patches", field_name,
+           mesh_name, centering);
+  int num_patches = unimesh_field_num_patches(field);
+  bool patches_match = false;
+  if (silo_file_contains_var(file, var_name) &&
+      (silo_file_var_length(file, var_name) == 3 * num_patches))
+  {
+    int* indices = polymec_malloc(sizeof(int) * 3 * MAX(num_patches, 1));
+    silo_file_read_var(file, var_name, indices);
+    patches_match = true;
+    int pos = 0, i, j, k, p = 0;
+    while (unimesh_next_patch(unimesh_field_mesh(field), &pos, &i, &j, &k, NULL))
+    {
+      if ((indices[3*p] != i) || (indices[3*p+1] != j) || (indices[3*p+2] != k))
+      {
+        patches_match = false;
+        break;
+      }
+      ++p;
+    }
+    polymec_free(indices);
+  }
+
+  if (patches_match)
+  {
+    unimesh_t* mesh = unimesh_field_mesh(field);
+    int nx, ny, nz;
+    unimesh_get_patch_size(mesh, &nx, &ny, &nz);
+    size_t size = num_patches *
+      unimesh_patch_data_size(unimesh_field_centering(field), nx, ny, nz,
+                              unimesh_field_num_components(field)) / sizeof(real_t);
+    snprintf(var_name, FILENAME_MAX, "%s_%s_%s_buffer", field_name, mesh_name,
+             centering);
+    if (size == 0) // nothing to map
+      mapped = true;
+    else
+    {
+      void* buffer;
+      void* mapping = silo_file_map_var(file, var_name, SILO_FLOAT_TYPE, 
+                                        size, &buffer);
+      if (mapping != NULL)
+      {
+        unimesh_field_adopt_buffer(field, buffer, mapping);
+        mapped = true;
+        release_ref(mapping);
+      }
+    }
+  }
+
+  if (mapped)
+  {
+    char md_name[FILENAME_MAX+1];
+    snprintf(md_name, FILENAME_MAX, "%s_%s_buffer_md", field_name, mesh_name);
+    silo_file_read_field_metadata(file, md_name, unimesh_field_metadata(field));
+  }
+
+  silo_file_pop_dir(file);
+  STOP_FUNCTION_TIMER();
+  return mapped;
+}
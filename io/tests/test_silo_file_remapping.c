@@ -0,0 +1,392 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "geometry/create_uniform_polymesh.h"
+#include "geometry/create_rectilinear_polymesh.h"
+#include "geometry/create_point_lattice.h"
+#include "geometry/partition_polymesh.h"
+#include "geometry/partition_point_cloud.h"
+#include "io/silo_file.h"
+
+// These tests write data on one set of processes and read it back on
+// another: every process on its own, and all processes from data written by
+// a single process. With a single process, no remapping occurs.
+
+static int sum_over(MPI_Comm comm, int value)
+{
+  int sum;
+  MPI_Allreduce(&value, &sum, 1, MPI_INT, MPI_SUM, comm);
+  return sum;
+}
+
+static real_t unimesh_value(int I, int J, int K, int i, int j, int k, int l)
+{
+  return (real_t)(((((4*I + J)*4 + K)*8 + i)*8 + j)*8 + k) + 0.25*l;
+}
+
+static void check_unimesh(unimesh_t* mesh, unimesh_field_t* field,
+                          int num_patches)
+{
+  assert_int_equal(num_patches, sum_over(unimesh_comm(mesh), unimesh_num_patches(mesh)));
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 2; ++l)
+            assert_true(reals_equal(a[i][j][k][l], unimesh_value(I, J, K, i, j, k, l)));
+  }
+}
+
+static unimesh_t* read_unimesh(MPI_Comm comm, const char* prefix,
+                               const char* dir, unimesh_field_t** field)
+{
+  silo_file_t* silo = silo_file_open(comm, prefix, dir, 0, NULL);
+  assert_true(silo != NULL);
+  assert_true(silo_file_contains_unimesh(silo, "mesh"));
+  unimesh_t* mesh = silo_file_read_unimesh(silo, "mesh");
+  *field = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  silo_file_read_unimesh_field(silo, "f", "mesh", *field);
+  silo_file_close(silo);
+  return mesh;
+}
+
+static void write_unimesh(MPI_Comm comm, const char* prefix, const char* dir,
+                          bool aggregate)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(comm, &bbox, 4, 4, 4, 6, 6, 6,
+                                false, false, false);
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 2; ++l)
+            a[i][j][k][l] = unimesh_value(I, J, K, i, j, k, l);
+  }
+  silo_file_t* silo = silo_file_new(comm, prefix, dir, 1, 0, 0.0);
+  silo_file_write_unimesh(silo, "mesh", mesh, NULL);
+  silo_file_aggregate_unimesh_fields(silo, aggregate, false);
+  if (aggregate) // also exercise the shared file for collective I/O
+    silo_file_enable_collective_io(silo, 0);
+  silo_file_write_unimesh_field(silo, "f", "mesh", field, NULL);
+  silo_file_close(silo);
+  unimesh_field_free(field);
+  unimesh_free(mesh);
+}
+
+// Generates names for the directory written on all processes and read on
+// each one, and for the directory written on one process and read on all of
+// them. These names include the number of processes so that tests running
+// on different numbers of processes don't clobber each other's files.
+static void get_dirs(const char* prefix, char* n_to_1_dir, char* one_to_n_dir)
+{
+  int nprocs;
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  snprintf(n_to_1_dir, FILENAME_MAX, "%s_%d_to_1", prefix, nprocs);
+  snprintf(one_to_n_dir, FILENAME_MAX, "%s_1_to_%d", prefix, nprocs);
+}
+
+static void test_remapped_unimesh(void** state)
+{
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  char n_to_1_dir[FILENAME_MAX+1], one_to_n_dir[FILENAME_MAX+1];
+  get_dirs("remapped_unimesh", n_to_1_dir, one_to_n_dir);
+
+  // Write on all processes and read everything on each one.
+  write_unimesh(MPI_COMM_WORLD, "remapped_unimesh", n_to_1_dir, true);
+  unimesh_field_t* field;
+  unimesh_t* mesh = read_unimesh(MPI_COMM_SELF, "remapped_unimesh",
+                                 n_to_1_dir, &field);
+  check_unimesh(mesh, field, 64);
+  unimesh_field_free(field);
+  unimesh_free(mesh);
+
+  // Write on one process and read on all of them.
+  if (rank == 0)
+    write_unimesh(MPI_COMM_SELF, "remapped_unimesh", one_to_n_dir, false);
+  MPI_Barrier(MPI_COMM_WORLD);
+  mesh = read_unimesh(MPI_COMM_WORLD, "remapped_unimesh",
+                      one_to_n_dir, &field);
+  check_unimesh(mesh, field, 64);
+  unimesh_field_free(field);
+  unimesh_free(mesh);
+}
+
+static void write_point_cloud(MPI_Comm comm, const char* prefix, const char* dir)
+{
+  point_cloud_t* cloud = NULL;
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  if (rank == 0)
+  {
+    bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+    cloud = create_uniform_point_lattice(MPI_COMM_SELF, 10, 10, 10, &bbox);
+  }
+  assert_true(partition_point_cloud(&cloud, comm, NULL, 0.05, NULL, 0));
+
+  // Tag the points with x < 0.5, and store coordinates in a field.
+  int_array_t* left = int_array_new();
+  point_cloud_field_t* field = point_cloud_field_new(cloud, 2);
+  DECLARE_POINT_CLOUD_FIELD_ARRAY(x, field);
+  for (int i = 0; i < cloud->num_points; ++i)
+  {
+    x[i][0] = cloud->points[i].x;
+    x[i][1] = cloud->points[i].y;
+    if (cloud->points[i].x < 0.5)
+      int_array_append(left, i);
+  }
+  int* tag = point_cloud_create_tag(cloud, "left", left->size);
+  memcpy(tag, left->data, sizeof(int) * left->size);
+  int_array_free(left);
+
+  silo_file_t* silo = silo_file_new(comm, prefix, dir, 1, 0, 0.0);
+  silo_file_write_point_cloud(silo, "cloud", cloud);
+  silo_file_write_point_field(silo, "x", "cloud", field);
+  silo_file_close(silo);
+  point_cloud_field_free(field);
+  point_cloud_free(cloud);
+}
+
+static void check_point_cloud(MPI_Comm comm, const char* prefix, const char* dir)
+{
+  silo_file_t* silo = silo_file_open(comm, prefix, dir, 0, NULL);
+  assert_true(silo != NULL);
+  point_cloud_t* cloud = silo_file_read_point_cloud(silo, "cloud");
+  point_cloud_field_t* field = point_cloud_field_new(cloud, 2);
+  silo_file_read_point_field(silo, "x", "cloud", field);
+  silo_file_close(silo);
+
+  assert_int_equal(1000, sum_over(comm, (int)cloud->num_points));
+  DECLARE_POINT_CLOUD_FIELD_ARRAY(x, field);
+  for (int i = 0; i < cloud->num_points; ++i)
+  {
+    assert_true(reals_equal(x[i][0], cloud->points[i].x));
+    assert_true(reals_equal(x[i][1], cloud->points[i].y));
+  }
+  size_t num_left;
+  int* left = point_cloud_tag(cloud, "left", &num_left);
+  assert_true(left != NULL);
+  assert_int_equal(500, sum_over(comm, (int)num_left));
+  for (size_t i = 0; i < num_left; ++i)
+    assert_true(cloud->points[left[i]].x < 0.5);
+
+  point_cloud_field_free(field);
+  point_cloud_free(cloud);
+}
+
+static void test_remapped_point_cloud(void** state)
+{
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  char n_to_1_dir[FILENAME_MAX+1], one_to_n_dir[FILENAME_MAX+1];
+  get_dirs("remapped_cloud", n_to_1_dir, one_to_n_dir);
+
+  write_point_cloud(MPI_COMM_WORLD, "remapped_cloud", n_to_1_dir);
+  check_point_cloud(MPI_COMM_SELF, "remapped_cloud", n_to_1_dir);
+
+  if (rank == 0)
+    write_point_cloud(MPI_COMM_SELF, "remapped_cloud", one_to_n_dir);
+  MPI_Barrier(MPI_COMM_WORLD);
+  check_point_cloud(MPI_COMM_WORLD, "remapped_cloud", one_to_n_dir);
+}
+
+// Polymeshes are checked in units of their size L, and stored with 
+// x-coordinates (in those units) as a cell field.
+static void check_polymesh(MPI_Comm comm, const char* prefix, const char* dir,
+                           real_t L)
+{
+  silo_file_t* silo = silo_file_open(comm, prefix, dir, 0, NULL);
+  assert_true(silo != NULL);
+  polymesh_t* mesh = silo_file_read_polymesh(silo, "mesh");
+  assert_true(mesh != NULL);
+  polymesh_field_t* field = polymesh_field_new(mesh, POLYMESH_CELL, 1);
+  silo_file_read_polymesh_field(silo, "x", "mesh", field);
+  silo_file_close(silo);
+
+  // Check the cells and their volumes (and, implicitly, that nodes on the 
+  // boundaries between domains have been merged correctly).
+  assert_int_equal(6*6*6, sum_over(comm, mesh->num_cells));
+  if (comm == MPI_COMM_SELF)
+    assert_int_equal(7*7*7, mesh->num_nodes);
+  real_t volume = 0.0;
+  for (int c = 0; c < mesh->num_cells; ++c)
+    volume += mesh->cell_volumes[c] / (L*L*L);
+  real_t total_volume;
+  MPI_Allreduce(&volume, &total_volume, 1, MPI_REAL_T, MPI_SUM, comm);
+  assert_true(reals_nearly_equal(total_volume, 1.0, 1e-12));
+
+  // Check the field, and make sure each ghost cell gets the value of the
+  // cell across its face.
+  DECLARE_POLYMESH_FIELD_ARRAY(x, field);
+  for (int c = 0; c < mesh->num_cells; ++c)
+    assert_true(reals_nearly_equal(x[c][0], mesh->cell_centers[c].x / L, 1e-12));
+  polymesh_field_exchange(field);
+  for (int f = 0; f < mesh->num_faces; ++f)
+  {
+    int c1 = mesh->face_cells[2*f], c2 = mesh->face_cells[2*f+1];
+    if (c2 >= mesh->num_cells)
+    {
+      real_t x2 = (2.0 * mesh->face_centers[f].x - mesh->cell_centers[c1].x) / L;
+      assert_true(reals_nearly_equal(x[c2][0], x2, 1e-12));
+    }
+  }
+
+  // Check the boundary faces. (tag_rectilinear_polymesh_faces uses an 
+  // absolute tolerance, so tiny meshes aren't tagged.)
+  if (L < 1e-6)
+  {
+    polymesh_field_free(field);
+    polymesh_free(mesh);
+    return;
+  }
+  size_t num_x1_faces = 0;
+  int* x1_faces = polymesh_tag(mesh->face_tags, "x1", &num_x1_faces);
+  if (x1_faces == NULL)
+    num_x1_faces = 0;
+  assert_int_equal(6*6, sum_over(comm, (int)num_x1_faces));
+  for (size_t i = 0; i < num_x1_faces; ++i)
+    assert_true(reals_nearly_equal(mesh->face_centers[x1_faces[i]].x / L, 0.0, 1e-12));
+
+  polymesh_field_free(field);
+  polymesh_free(mesh);
+}
+
+static void write_polymesh(MPI_Comm comm, const char* prefix, const char* dir,
+                           real_t L)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = L, .y1 = 0.0, .y2 = L, .z1 = 0.0, .z2 = L};
+  polymesh_t* mesh = create_uniform_polymesh(comm, 6, 6, 6, &bbox);
+  if (L >= 1e-6)
+    tag_rectilinear_polymesh_faces(mesh, "x1", "x2", "y1", "y2", "z1", "z2");
+  polymesh_field_t* field = polymesh_field_new(mesh, POLYMESH_CELL, 1);
+  DECLARE_POLYMESH_FIELD_ARRAY(x, field);
+  for (int c = 0; c < mesh->num_cells; ++c)
+    x[c][0] = mesh->cell_centers[c].x / L;
+  silo_file_t* silo = silo_file_new(comm, prefix, dir, 1, 0, 0.0);
+  silo_file_write_polymesh(silo, "mesh", mesh);
+  silo_file_write_polymesh_field(silo, "x", "mesh", field);
+  silo_file_close(silo);
+  polymesh_field_free(field);
+  polymesh_free(mesh);
+}
+
+static void test_remapped_polymesh_of_size(const char* prefix, real_t L)
+{
+  int rank, nprocs;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  char n_to_1_dir[FILENAME_MAX+1], one_to_n_dir[FILENAME_MAX+1];
+  get_dirs(prefix, n_to_1_dir, one_to_n_dir);
+
+  write_polymesh(MPI_COMM_WORLD, prefix, n_to_1_dir, L);
+  check_polymesh(MPI_COMM_SELF, prefix, n_to_1_dir, L);
+
+  // Read the mesh on two halves of the processes, each on its own.
+  if (nprocs > 2)
+  {
+    MPI_Comm half;
+    MPI_Comm_split(MPI_COMM_WORLD, (rank < nprocs/2) ? 0 : 1, rank, &half);
+    check_polymesh(half, prefix, n_to_1_dir, L);
+    MPI_Comm_free(&half);
+  }
+
+  if (rank == 0)
+    write_polymesh(MPI_COMM_SELF, prefix, one_to_n_dir, L);
+  MPI_Barrier(MPI_COMM_WORLD);
+  check_polymesh(MPI_COMM_WORLD, prefix, one_to_n_dir, L);
+}
+
+static void test_remapped_polymesh(void** state)
+{
+  test_remapped_polymesh_of_size("remapped_polymesh", 1.0);
+}
+
+static void test_remapped_tiny_polymesh(void** state)
+{
+  // The cells of this mesh are much smaller than any fixed tolerance we 
+  // might use to merge nodes on the boundaries between domains.
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  test_remapped_polymesh_of_size("remapped_tiny_polymesh", 1e-14);
+#else
+  test_remapped_polymesh_of_size("remapped_tiny_polymesh", 1e-6);
+#endif
+}
+
+static void test_remapped_huge_polymesh(void** state)
+{
+  test_remapped_polymesh_of_size("remapped_huge_polymesh", 1e8);
+}
+
+static void test_remapped_polymesh_on_more_processes(void** state)
+{
+  // Write the mesh on about half of the processes.
+  int rank, nprocs;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  int num_writers = (nprocs + 1) / 2;
+  char dir[FILENAME_MAX+1];
+  snprintf(dir, FILENAME_MAX, "remapped_polymesh_%d_to_%d", num_writers, nprocs);
+  MPI_Comm writers;
+  MPI_Comm_split(MPI_COMM_WORLD, (rank < num_writers) ? 0 : 1, rank, &writers);
+  if (rank < num_writers)
+    write_polymesh(writers, "remapped_polymesh", dir, 1.0);
+  MPI_Comm_free(&writers);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Read it on all of them. Each writer's subdomain goes to one process, and
+  // the rest get no cells.
+  silo_file_t* silo = silo_file_open(MPI_COMM_WORLD, "remapped_polymesh", dir, 0, NULL);
+  assert_true(silo != NULL);
+  polymesh_t* mesh = silo_file_read_polymesh(silo, "mesh");
+  assert_true(mesh != NULL);
+  polymesh_field_t* field = polymesh_field_new(mesh, POLYMESH_CELL, 1);
+  silo_file_read_polymesh_field(silo, "x", "mesh", field);
+  silo_file_close(silo);
+  assert_int_equal(6*6*6, sum_over(MPI_COMM_WORLD, mesh->num_cells));
+  assert_int_equal(num_writers, sum_over(MPI_COMM_WORLD, (mesh->num_cells > 0) ? 1 : 0));
+
+  // Repartitioning gives every process cells.
+  assert_true(repartition_polymesh(&mesh, NULL, 0.05, &field, 1));
+  assert_true(mesh->num_cells > 0);
+  assert_int_equal(6*6*6, sum_over(MPI_COMM_WORLD, mesh->num_cells));
+  DECLARE_POLYMESH_FIELD_ARRAY(x, field);
+  for (int c = 0; c < mesh->num_cells; ++c)
+    assert_true(reals_nearly_equal(x[c][0], mesh->cell_centers[c].x, 1e-12));
+
+  polymesh_field_free(field);
+  polymesh_free(mesh);
+}
+
+int main(int argc, char* argv[])
+{
+  polymec_init(argc, argv);
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test(test_remapped_unimesh),
+    cmocka_unit_test(test_remapped_point_cloud),
+    cmocka_unit_test(test_remapped_polymesh),
+    cmocka_unit_test(test_remapped_tiny_polymesh),
+    cmocka_unit_test(test_remapped_huge_polymesh),
+    cmocka_unit_test(test_remapped_polymesh_on_more_processes)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
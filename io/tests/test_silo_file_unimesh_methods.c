@@ -9,6 +9,7 @@
 #include <stddef.h>
 #include <setjmp.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "cmocka.h"
 #include "io/silo_file.h"
 
@@ -406,6 +407,503 @@ static void test_write_unimesh_node_field(void** state)
   unimesh_free(mesh); 
 } 
 
+static void test_write_aggregated_unimesh_fields(void** state) 
+{ 
+  // Make a mesh with 4x4x4 patches, each with nx x ny x nz cells. 
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, 
+                 .y1 = 0.0, .y2 = 1.0, 
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 
+                                4, 4, 4, nx, ny, nz, 
+                                false, false, false); 
+
+  // Make a 4-component cell-centered field and a y-face field on this mesh.
+  unimesh_field_t* c_field = unimesh_field_new(mesh, UNIMESH_CELL, 4);
+  unimesh_field_t* y_field = unimesh_field_new(mesh, UNIMESH_YFACE, 4);
+  
+  // Fill them with goodness that differs from patch to patch.
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(c_field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 4; ++l)
+            a[i][j][k][l] = (real_t)(16*I + 4*J + K + ny*nz*4*i + nz*4*j + 4*k + l);
+  }
+
+  pos = 0;
+  while (unimesh_field_next_patch(y_field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_YFACE_ARRAY(a, patch);
+    for (int i = 0; i < patch->nx; ++i)
+      for (int j = 0; j <= patch->ny; ++j)
+        for (int k = 0; k < patch->nz; ++k)
+          for (int l = 0; l < 4; ++l)
+            a[i][j][k][l] = (real_t)(16*I + 4*J + K + ny*nz*4*i + nz*4*j + 4*k + l);
+  }
+
+  // Write a plot to a file, aggregating the cell field and writing the
+  // face field with patch views.
+  silo_file_t* silo = silo_file_new(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_aggregated_unimesh_fields", 1, 0, 0.0);
+  silo_file_write_unimesh(silo, "mesh", mesh, NULL);
+  silo_file_aggregate_unimesh_fields(silo, true, false);
+  silo_file_write_unimesh_field(silo, "c", "mesh", c_field, NULL);
+  silo_file_aggregate_unimesh_fields(silo, true, true);
+  silo_file_write_unimesh_field(silo, "f", "mesh", y_field, NULL);
+  silo_file_close(silo);
+  unimesh_field_free(c_field);
+  unimesh_field_free(y_field);
+  unimesh_free(mesh); 
+
+  // Read the fields in from the file and verify their goodness.
+  real_t time;
+  silo = silo_file_open(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_aggregated_unimesh_fields", 0, &time);
+  mesh = silo_file_read_unimesh(silo, "mesh");
+
+  assert_true(silo_file_contains_unimesh_field(silo, "c", "mesh", UNIMESH_CELL));
+  c_field = unimesh_field_new(mesh, UNIMESH_CELL, 4);
+  silo_file_read_unimesh_field(silo, "c", "mesh", c_field);
+  pos = 0;
+  while (unimesh_field_next_patch(c_field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 4; ++l)
+            assert_true(reals_equal(a[i][j][k][l], (real_t)(16*I + 4*J + K + ny*nz*4*i + nz*4*j + 4*k + l)));
+  }
+
+  assert_true(silo_file_contains_unimesh_field(silo, "f", "mesh", UNIMESH_YFACE));
+  y_field = unimesh_field_new(mesh, UNIMESH_YFACE, 4);
+  silo_file_read_unimesh_field(silo, "f", "mesh", y_field);
+  pos = 0;
+  while (unimesh_field_next_patch(y_field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_YFACE_ARRAY(a, patch);
+    for (int i = 0; i < patch->nx; ++i)
+      for (int j = 0; j <= patch->ny; ++j)
+        for (int k = 0; k < patch->nz; ++k)
+          for (int l = 0; l < 4; ++l)
+            assert_true(reals_equal(a[i][j][k][l], (real_t)(16*I + 4*J + K + ny*nz*4*i + nz*4*j + 4*k + l)));
+  }
+
+  silo_file_close(silo);
+  unimesh_field_free(c_field);
+  unimesh_field_free(y_field);
+  unimesh_free(mesh); 
+} 
+
+static void test_write_compressed_unimesh_fields(void** state) 
+{ 
+  // Make a mesh with 4x4x4 patches, each with nx x ny x nz cells. 
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, 
+                 .y1 = 0.0, .y2 = 1.0, 
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 
+                                4, 4, 4, nx, ny, nz, 
+                                false, false, false); 
+
+  // Make a smooth 2-component cell-centered field.
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  bbox_t patch_box;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, &patch_box))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+        {
+          real_t x = patch_box.x1 + (i - 0.5) * (patch_box.x2 - patch_box.x1) / patch->nx;
+          a[i][j][k][0] = sin(x);
+          a[i][j][k][1] = (real_t)(I + J + K);
+        }
+  }
+
+  // Make a big array that spans several compression chunks.
+  size_t array_size = 200000;
+  real_t* array = polymec_malloc(sizeof(real_t) * array_size);
+  for (size_t i = 0; i < array_size; ++i)
+    array[i] = (real_t)(i % 1000);
+
+  // Write the field twice--once losslessly and once with an error bound--and 
+  // the array with the default (lossless) compression.
+  real_t error_bound = 1e-4;
+  silo_file_t* silo = silo_file_new(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_compressed_unimesh_fields", 1, 0, 0.0);
+  silo_file_set_compression(silo, NULL, SILO_COMPRESSION_LOSSLESS, 0.0);
+  silo_file_set_compression(silo, "g", SILO_COMPRESSION_LOSSY, error_bound);
+  silo_file_write_unimesh(silo, "mesh", mesh, NULL);
+  silo_file_aggregate_unimesh_fields(silo, true, false);
+  silo_file_write_unimesh_field(silo, "f", "mesh", field, NULL);
+  silo_file_write_unimesh_field(silo, "g", "mesh", field, NULL);
+  silo_file_write_real_array(silo, "array", array, array_size);
+  silo_file_close(silo);
+
+  // Read everything back in and compare.
+  silo = silo_file_open(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_compressed_unimesh_fields", 0, NULL);
+  unimesh_field_t* f = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  silo_file_read_unimesh_field(silo, "f", "mesh", f);
+  unimesh_field_t* g = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  silo_file_read_unimesh_field(silo, "g", "mesh", g);
+  size_t size;
+  real_t* array1 = silo_file_read_real_array(silo, "array", &size);
+  silo_file_close(silo);
+
+  pos = 0;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    DECLARE_UNIMESH_CELL_ARRAY(fa, unimesh_field_patch(f, I, J, K));
+    DECLARE_UNIMESH_CELL_ARRAY(ga, unimesh_field_patch(g, I, J, K));
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 2; ++l)
+          {
+            assert_true(reals_equal(fa[i][j][k][l], a[i][j][k][l]));
+            assert_true(ABS(ga[i][j][k][l] - a[i][j][k][l]) <= 1.000001 * error_bound);
+          }
+  }
+  assert_int_equal(array_size, size);
+  for (size_t i = 0; i < array_size; ++i)
+    assert_true(reals_equal(array1[i], array[i]));
+
+  polymec_free(array1);
+  polymec_free(array);
+  unimesh_field_free(g);
+  unimesh_field_free(f);
+  unimesh_field_free(field);
+  unimesh_free(mesh); 
+} 
+
+// Writes the given array to a file in the given directory with the given
+// compression, returning the size of the file.
+static size_t write_compressed_array(const char* dir,
+                                     silo_compression_t method,
+                                     real_t error_bound,
+                                     real_t* array,
+                                     size_t size)
+{
+  silo_file_t* silo = silo_file_new(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", dir, 1, 0, 0.0);
+  silo_file_set_compression(silo, "array", method, error_bound);
+  silo_file_write_real_array(silo, "array", array, size);
+  silo_file_close(silo);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  char filename[FILENAME_MAX+1];
+  snprintf(filename, FILENAME_MAX, "%s/test_silo_file_unimesh_methods-0.silo", dir);
+  struct stat file_stat;
+  assert_int_equal(0, stat(filename, &file_stat));
+  return (size_t)file_stat.st_size;
+}
+
+static real_t* read_compressed_array(const char* dir, size_t* size)
+{
+  silo_file_t* silo = silo_file_open(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", dir, 0, NULL);
+  real_t* array = silo_file_read_real_array(silo, "array", size);
+  silo_file_close(silo);
+  return array;
+}
+
+static void test_compressed_array_sizes_and_bounds(void** state)
+{
+  // A smooth array shrinks a lot when it's compressed with an error bound.
+  size_t array_size = 200000;
+  real_t error_bound = 1e-4;
+  real_t* array = polymec_malloc(sizeof(real_t) * array_size);
+  for (size_t i = 0; i < array_size; ++i)
+    array[i] = sin(1e-3 * i);
+  size_t raw_size = write_compressed_array("test_uncompressed_array",
+                                           SILO_COMPRESSION_NONE, 0.0,
+                                           array, array_size);
+  size_t lossy_size = write_compressed_array("test_lossy_array",
+                                             SILO_COMPRESSION_LOSSY, error_bound,
+                                             array, array_size);
+  log_info("Smooth array: %zu bytes uncompressed, %zu bytes with an error "
+           "bound of %g.", raw_size, lossy_size, error_bound);
+  assert_true(4 * lossy_size < raw_size);
+  size_t size;
+  real_t* array1 = read_compressed_array("test_lossy_array", &size);
+  assert_int_equal(array_size, size);
+  for (size_t i = 0; i < array_size; ++i)
+    assert_true(ABS(array1[i] - array[i]) <= error_bound);
+  polymec_free(array1);
+
+  // Large values can't be quantized to within the error bound, so they're
+  // stored losslessly, and respect the bound too. The first chunk is large
+  // enough that its quanta can't be represented, and the rest are small
+  // enough to be represented but large enough for rounding to matter.
+  rng_t* rng = host_rng_new();
+  for (size_t i = 0; i < array_size; ++i)
+  {
+    real_t x = rng_uniform(rng);
+    array[i] = (i < 65536) ? 1e12 + x * (1e14 - 1e12) : 1e11 + x * 8e11;
+  }
+  write_compressed_array("test_large_lossy_array", SILO_COMPRESSION_LOSSY,
+                         error_bound, array, array_size);
+  array1 = read_compressed_array("test_large_lossy_array", &size);
+  assert_int_equal(array_size, size);
+  for (size_t i = 0; i < array_size; ++i)
+    assert_true(ABS(array1[i] - array[i]) <= error_bound);
+  polymec_free(array1);
+
+  polymec_free(array);
+}
+
+static void test_write_unimesh_fields_collectively(void** state) 
+{ 
+  // Make a mesh with 4x4x4 patches, each with nx x ny x nz cells. 
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, 
+                 .y1 = 0.0, .y2 = 1.0, 
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 
+                                4, 4, 4, nx, ny, nz, 
+                                false, false, false); 
+
+  // Make a 2-component cell-centered field.
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 2; ++l)
+            a[i][j][k][l] = (real_t)(I + J + K + i + j + k + l);
+  }
+
+  // Make some arrays whose contents depend on the process.
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  size_t array_size = 1000 + 10 * rank;
+  real_t reals[array_size];
+  int ints[array_size];
+  for (size_t i = 0; i < array_size; ++i)
+  {
+    reals[i] = (real_t)(rank + i);
+    ints[i] = (int)(rank * i);
+  }
+
+  // Write the field uncompressed and compressed, and the arrays, to a file
+  // shared by all processes.
+  silo_file_t* silo = silo_file_new(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_unimesh_fields_collectively", 1, 0, 0.0);
+  silo_file_enable_collective_io(silo, 1);
+  silo_file_set_compression(silo, "g", SILO_COMPRESSION_LOSSLESS, 0.0);
+  silo_file_write_unimesh(silo, "mesh", mesh, NULL);
+  silo_file_aggregate_unimesh_fields(silo, true, false);
+  silo_file_write_unimesh_field(silo, "f", "mesh", field, NULL);
+  silo_file_write_unimesh_field(silo, "g", "mesh", field, NULL);
+  silo_file_write_real_array(silo, "reals", reals, array_size);
+  silo_file_write_int_array(silo, "ints", ints, array_size);
+  silo_file_close(silo);
+
+  // Read everything back in and compare.
+  silo = silo_file_open(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_unimesh_fields_collectively", 0, NULL);
+  assert_true(silo_file_contains_unimesh(silo, "mesh"));
+  unimesh_field_t* f = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  silo_file_read_unimesh_field(silo, "f", "mesh", f);
+  unimesh_field_t* g = unimesh_field_new(mesh, UNIMESH_CELL, 2);
+  silo_file_read_unimesh_field(silo, "g", "mesh", g);
+  size_t real_size, int_size;
+  real_t* reals1 = silo_file_read_real_array(silo, "reals", &real_size);
+  int* ints1 = silo_file_read_int_array(silo, "ints", &int_size);
+  silo_file_close(silo);
+
+  pos = 0;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    DECLARE_UNIMESH_CELL_ARRAY(fa, unimesh_field_patch(f, I, J, K));
+    DECLARE_UNIMESH_CELL_ARRAY(ga, unimesh_field_patch(g, I, J, K));
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          for (int l = 0; l < 2; ++l)
+          {
+            assert_true(reals_equal(fa[i][j][k][l], a[i][j][k][l]));
+            assert_true(reals_equal(ga[i][j][k][l], a[i][j][k][l]));
+          }
+  }
+  assert_int_equal(array_size, real_size);
+  assert_int_equal(array_size, int_size);
+  for (size_t i = 0; i < array_size; ++i)
+  {
+    assert_true(reals_equal(reals1[i], reals[i]));
+    assert_int_equal(ints1[i], ints[i]);
+  }
+
+  polymec_free(ints1);
+  polymec_free(reals1);
+  unimesh_field_free(g);
+  unimesh_field_free(f);
+  unimesh_field_free(field);
+  unimesh_free(mesh); 
+} 
+
+static void test_map_unimesh_field_buffer(void** state) 
+{ 
+  // Make a mesh with 4x4x4 patches, each with nx x ny x nz cells. 
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, 
+                 .y1 = 0.0, .y2 = 1.0, 
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 
+                                4, 4, 4, nx, ny, nz, 
+                                false, false, false); 
+
+  // Make a 3-component cell-centered field, filling in its ghost cells too.
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 3);
+  field_metadata_set_name(unimesh_field_metadata(field), 0, "rho");
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 0; i <= patch->nx+1; ++i)
+      for (int j = 0; j <= patch->ny+1; ++j)
+        for (int k = 0; k <= patch->nz+1; ++k)
+          for (int l = 0; l < 3; ++l)
+            a[i][j][k][l] = (real_t)(I + J + K + i + j + k + l);
+  }
+
+  // Write the field's buffer in our native format.
+  silo_file_t* silo = silo_file_new(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_map_unimesh_field_buffer", 1, 0, 0.0);
+  silo_file_write_unimesh(silo, "mesh", mesh, NULL);
+  silo_file_write_unimesh_field_buffer(silo, "f", "mesh", field);
+  silo_file_close(silo);
+
+  // Map the buffer into two fields, and make sure that changing one doesn't 
+  // change the other.
+  silo = silo_file_open(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_map_unimesh_field_buffer", 0, NULL);
+  unimesh_field_t* f = unimesh_field_with_buffer(mesh, UNIMESH_CELL, 3, NULL);
+  assert_true(silo_file_map_unimesh_field(silo, "f", "mesh", f));
+  unimesh_field_t* g = unimesh_field_with_buffer(mesh, UNIMESH_CELL, 3, NULL);
+  assert_true(silo_file_map_unimesh_field(silo, "f", "mesh", g));
+  unimesh_field_t* h = unimesh_field_new(mesh, UNIMESH_XFACE, 3);
+  assert_false(silo_file_map_unimesh_field(silo, "f", "mesh", h));
+  silo_file_close(silo);
+  assert_int_equal(0, strcmp(field_metadata_name(unimesh_field_metadata(f), 0), "rho"));
+
+  pos = 0;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    DECLARE_UNIMESH_CELL_ARRAY(fa, unimesh_field_patch(f, I, J, K));
+    DECLARE_UNIMESH_CELL_ARRAY(ga, unimesh_field_patch(g, I, J, K));
+    for (int i = 0; i <= patch->nx+1; ++i)
+      for (int j = 0; j <= patch->ny+1; ++j)
+        for (int k = 0; k <= patch->nz+1; ++k)
+          for (int l = 0; l < 3; ++l)
+          {
+            assert_true(reals_equal(fa[i][j][k][l], a[i][j][k][l]));
+            fa[i][j][k][l] = -1.0;
+            assert_true(reals_equal(ga[i][j][k][l], a[i][j][k][l]));
+          }
+  }
+
+  unimesh_field_free(h);
+  unimesh_field_free(g);
+  unimesh_field_free(f);
+  unimesh_field_free(field);
+  unimesh_free(mesh); 
+} 
+
+static void test_write_unimesh_fields_incrementally(void** state) 
+{ 
+  // Make a mesh with 4x4x4 patches, each with nx x ny x nz cells. 
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, 
+                 .y1 = 0.0, .y2 = 1.0, 
+                 .z1 = 0.0, .z2 = 1.0};
+  unimesh_t* mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 
+                                4, 4, 4, nx, ny, nz, 
+                                false, false, false); 
+
+  // Make a cell-centered field that doesn't change between steps.
+  unimesh_field_t* field = unimesh_field_new(mesh, UNIMESH_CELL, 1);
+  int pos = 0, I, J, K;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+  {
+    DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          a[i][j][k][0] = (real_t)(I + J + K + i + j + k);
+  }
+
+  // Make a large array spanning several blocks, and a small one.
+  size_t array_size = 40000;
+  real_t* reals = polymec_malloc(sizeof(real_t) * array_size);
+  for (size_t i = 0; i < array_size; ++i)
+    reals[i] = (real_t)i;
+  int ints[100];
+  for (int i = 0; i < 100; ++i)
+    ints[i] = i;
+
+  // Write 3 steps, changing one value of the large array each time.
+  silo_write_history_t* history = silo_write_history_new();
+  for (int step = 0; step < 3; ++step)
+  {
+    reals[10000 * step] = -1.0 * step;
+    silo_file_t* silo = silo_file_new(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_unimesh_fields_incrementally", 1, step, 1.0 * step);
+    silo_file_enable_incremental_writes(silo, history, true);
+    silo_file_write_unimesh(silo, "mesh", mesh, NULL);
+    silo_file_aggregate_unimesh_fields(silo, true, false);
+    silo_file_write_unimesh_field(silo, "f", "mesh", field, NULL);
+    silo_file_write_real_array(silo, "reals", reals, array_size);
+    silo_file_write_int_array(silo, "ints", ints, 100);
+    silo_file_close(silo);
+  }
+  silo_write_history_free(history);
+
+  // Read each step back in and compare.
+  for (int step = 0; step < 3; ++step)
+  {
+    real_t t;
+    silo_file_t* silo = silo_file_open(MPI_COMM_WORLD, "test_silo_file_unimesh_methods", "test_write_unimesh_fields_incrementally", step, &t);
+    unimesh_field_t* f = unimesh_field_new(mesh, UNIMESH_CELL, 1);
+    silo_file_read_unimesh_field(silo, "f", "mesh", f);
+    size_t real_size, int_size;
+    real_t* reals1 = silo_file_read_real_array(silo, "reals", &real_size);
+    int* ints1 = silo_file_read_int_array(silo, "ints", &int_size);
+    silo_file_close(silo);
+
+    pos = 0;
+    while (unimesh_field_next_patch(field, &pos, &I, &J, &K, &patch, NULL))
+    {
+      DECLARE_UNIMESH_CELL_ARRAY(a, patch);
+      DECLARE_UNIMESH_CELL_ARRAY(fa, unimesh_field_patch(f, I, J, K));
+      for (int i = 1; i <= patch->nx; ++i)
+        for (int j = 1; j <= patch->ny; ++j)
+          for (int k = 1; k <= patch->nz; ++k)
+            assert_true(reals_equal(fa[i][j][k][0], a[i][j][k][0]));
+    }
+    assert_int_equal(array_size, real_size);
+    for (size_t i = 0; i < array_size; ++i)
+    {
+      real_t val = ((i % 10000 == 0) && ((int)(i / 10000) <= step)) ? -1.0 * (real_t)(i / 10000) : (real_t)i;
+      assert_true(reals_equal(reals1[i], val));
+    }
+    assert_int_equal(100, int_size);
+    for (int i = 0; i < 100; ++i)
+      assert_int_equal(ints1[i], ints[i]);
+
+    polymec_free(ints1);
+    polymec_free(reals1);
+    unimesh_field_free(f);
+  }
+
+  polymec_free(reals);
+  unimesh_field_free(field);
+  unimesh_free(mesh); 
+} 
+
 int main(int argc, char* argv[]) 
 {
   polymec_init(argc, argv);
@@ -415,7 +913,13 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_write_unimesh_cell_field),
     cmocka_unit_test(test_write_unimesh_face_field),
     cmocka_unit_test(test_write_unimesh_edge_field),
-    cmocka_unit_test(test_write_unimesh_node_field)
+    cmocka_unit_test(test_write_unimesh_node_field),
+    cmocka_unit_test(test_write_aggregated_unimesh_fields),
+    cmocka_unit_test(test_write_compressed_unimesh_fields),
+    cmocka_unit_test(test_compressed_array_sizes_and_bounds),
+    cmocka_unit_test(test_write_unimesh_fields_collectively),
+    cmocka_unit_test(test_map_unimesh_field_buffer),
+    cmocka_unit_test(test_write_unimesh_fields_incrementally)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
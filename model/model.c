@@ -48,6 +48,16 @@ static void handle_sigint_or_sigterm(int signal)
   _received_signal = signal;
 }
 
+// This type holds a mesh and fields whose load is balanced by a model.
+typedef struct
+{
+  unimesh_t** unimesh;
+  unimesh_field_t** unimesh_fields;
+  colmesh_t** colmesh;
+  colmesh_field_t** colmesh_fields;
+  size_t num_fields;
+} balanced_mesh_t;
+
 struct model_t
 {
   // Model metadata.
@@ -74,6 +84,11 @@ struct model_t
   // Intercept SIGINT and SIGTERM?
   bool handle_signals;
 
+  // Automatic load balancing.
+  real_t lb_tol;                 // Largest acceptable load imbalance.
+  int lb_every;                  // Imbalance check frequency (steps).
+  ptr_array_t* balanced_meshes;  // Meshes whose loads are balanced.
+
   // Data related to a given simulation.
   char* sim_prefix; // Simulation naming prefix.
   char* sim_dir;    // Simulation directory.
@@ -162,6 +177,9 @@ model_t* model_new(const char* name,
   model->max_dt = REAL_MAX;
   model->min_dt = 0.0;
   model->diag_mode = MODEL_DIAG_NEAREST_STEP;
+  model->lb_tol = 0.05;
+  model->lb_every = -1;
+  model->balanced_meshes = ptr_array_new();
 
   // By default, we make model steps uninterruptible by intercepting
   // SIGINT and SIGTERM.
@@ -221,6 +239,8 @@ void model_free(model_t* model)
   probe_map_free(model->probes);
   probe_data_map_free(model->probe_data);
 
+  ptr_array_free(model->balanced_meshes);
+
   polymec_free(model);
 }
 
@@ -282,6 +302,182 @@ static void model_do_periodic_work(model_t* model)
   model_acquire(model);
 }
 
+// This returns the fraction by which the largest load on any process in
+// comm exceeds the average load.
+static real_t load_imbalance(real_t load, MPI_Comm comm)
+{
+  real_t max_load = load, total_load = load;
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(&load, &max_load, 1, MPI_REAL_T, MPI_MAX, comm);
+  MPI_Allreduce(&load, &total_load, 1, MPI_REAL_T, MPI_SUM, comm);
+#endif
+  int nprocs;
+  MPI_Comm_size(comm, &nprocs);
+  real_t avg_load = total_load / nprocs;
+  return (avg_load > 0.0) ? (max_load - avg_load) / avg_load : 0.0;
+}
+
+// Returns true if any process on comm has received a signal. Processes
+// must agree on this before starting collective work like repartitioning,
+// since a signal may arrive on some processes and not others.
+static bool signal_received(MPI_Comm comm)
+{
+  int signal = _received_signal;
+#if POLYMEC_HAVE_MPI
+  MPI_Allreduce(MPI_IN_PLACE, &signal, 1, MPI_INT, MPI_MAX, comm);
+#endif
+  return (signal != 0);
+}
+
+// This converts measured costs into integer partitioning weights, resolving
+// each cost to a thousandth of the largest one.
+static int* weights_from_costs(real_t* costs, int num_costs)
+{
+  real_t max_cost = 0.0;
+  for (int i = 0; i < num_costs; ++i)
+    max_cost = MAX(max_cost, costs[i]);
+  int* weights = polymec_malloc(sizeof(int) * num_costs);
+  for (int i = 0; i < num_costs; ++i)
+    weights[i] = MAX(1, (int)lround(1000.0 * costs[i] / max_cost));
+  return weights;
+}
+
+static real_t unimesh_load(unimesh_t* mesh, real_t* costs)
+{
+  int npx, npy, npz;
+  unimesh_get_extents(mesh, &npx, &npy, &npz);
+  real_t load = 0.0;
+  int pos = 0, i, j, k;
+  while (unimesh_next_patch(mesh, &pos, &i, &j, &k, NULL))
+    load += costs[npy*npz*i + npz*j + k];
+  return load;
+}
+
+static real_t colmesh_load(colmesh_t* mesh, real_t* costs)
+{
+  int num_xy_chunks, num_z_chunks, nz_per_chunk;
+  colmesh_get_chunk_info(mesh, &num_xy_chunks, &num_z_chunks, &nz_per_chunk);
+  real_t load = 0.0;
+  int pos = 0, xy_index, z_index;
+  colmesh_chunk_t* chunk;
+  while (colmesh_next_chunk(mesh, &pos, &xy_index, &z_index, &chunk))
+    load += costs[num_z_chunks*xy_index + z_index];
+  return load;
+}
+
+// This repartitions the given unimesh if its measured load is imbalanced,
+// returning true if it was repartitioned, false if not.
+static bool balance_unimesh(model_t* model, balanced_mesh_t* bm)
+{
+  unimesh_t* mesh = *(bm->unimesh);
+  if (!unimesh_measures_patch_costs(mesh))
+  {
+    // This mesh was created after it was registered, so we start measuring.
+    unimesh_measure_patch_costs(mesh, true);
+    return false;
+  }
+
+  int npx, npy, npz;
+  unimesh_get_extents(mesh, &npx, &npy, &npz);
+  int num_patches = npx * npy * npz;
+  real_t* costs = polymec_malloc(sizeof(real_t) * num_patches);
+  unimesh_get_patch_costs(mesh, costs);
+  MPI_Comm comm = unimesh_comm(mesh);
+  real_t imbalance = load_imbalance(unimesh_load(mesh, costs), comm);
+  bool repartitioned = false;
+  if (imbalance > model->lb_tol)
+  {
+    log_detail("%s: Load imbalance on unimesh is %g%% (tolerance: %g%%). Repartitioning.",
+               model->name, 100.0 * imbalance, 100.0 * model->lb_tol);
+    int* weights = weights_from_costs(costs, num_patches);
+    repartition_unimesh(bm->unimesh, GRAPH_PARTITIONER, weights, model->lb_tol,
+                        bm->unimesh_fields, bm->num_fields);
+    polymec_free(weights);
+    mesh = *(bm->unimesh);
+    imbalance = load_imbalance(unimesh_load(mesh, costs), comm);
+    log_detail("%s: Load imbalance on unimesh after repartitioning is %g%% (estimated).",
+               model->name, 100.0 * imbalance);
+    unimesh_measure_patch_costs(mesh, true);
+    repartitioned = true;
+  }
+  else
+  {
+    log_debug("%s: Load imbalance on unimesh is %g%%.", model->name, 100.0 * imbalance);
+    unimesh_reset_patch_costs(mesh);
+  }
+  polymec_free(costs);
+  return repartitioned;
+}
+
+// This repartitions the given colmesh if its measured load is imbalanced,
+// returning true if it was repartitioned, false if not.
+static bool balance_colmesh(model_t* model, balanced_mesh_t* bm)
+{
+  colmesh_t* mesh = *(bm->colmesh);
+  if (!colmesh_measures_chunk_costs(mesh))
+  {
+    // This mesh was created after it was registered, so we start measuring.
+    colmesh_measure_chunk_costs(mesh, true);
+    return false;
+  }
+
+  int num_xy_chunks, num_z_chunks, nz_per_chunk;
+  colmesh_get_chunk_info(mesh, &num_xy_chunks, &num_z_chunks, &nz_per_chunk);
+  int num_chunks = num_xy_chunks * num_z_chunks;
+  real_t* costs = polymec_malloc(sizeof(real_t) * num_chunks);
+  colmesh_get_chunk_costs(mesh, costs);
+  MPI_Comm comm = colmesh_comm(mesh);
+  real_t imbalance = load_imbalance(colmesh_load(mesh, costs), comm);
+  bool repartitioned = false;
+  if (imbalance > model->lb_tol)
+  {
+    log_detail("%s: Load imbalance on colmesh is %g%% (tolerance: %g%%). Repartitioning.",
+               model->name, 100.0 * imbalance, 100.0 * model->lb_tol);
+    int* weights = weights_from_costs(costs, num_chunks);
+    repartition_colmesh(bm->colmesh, weights, model->lb_tol,
+                        bm->colmesh_fields, bm->num_fields);
+    polymec_free(weights);
+    mesh = *(bm->colmesh);
+    imbalance = load_imbalance(colmesh_load(mesh, costs), comm);
+    log_detail("%s: Load imbalance on colmesh after repartitioning is %g%% (estimated).",
+               model->name, 100.0 * imbalance);
+    colmesh_measure_chunk_costs(mesh, true);
+    repartitioned = true;
+  }
+  else
+  {
+    log_debug("%s: Load imbalance on colmesh is %g%%.", model->name, 100.0 * imbalance);
+    colmesh_reset_chunk_costs(mesh);
+  }
+  polymec_free(costs);
+  return repartitioned;
+}
+
+// This checks the load balance of each of the model's registered meshes,
+// repartitioning those that need it.
+static void model_balance_load(model_t* model)
+{
+  START_FUNCTION_TIMER();
+  bool repartitioned = false;
+  for (size_t i = 0; i < model->balanced_meshes->size; ++i)
+  {
+    balanced_mesh_t* bm = model->balanced_meshes->data[i];
+    if ((bm->unimesh != NULL) && (*(bm->unimesh) != NULL))
+    {
+      if (!signal_received(unimesh_comm(*(bm->unimesh))))
+        repartitioned = balance_unimesh(model, bm) || repartitioned;
+    }
+    else if ((bm->colmesh != NULL) && (*(bm->colmesh) != NULL))
+    {
+      if (!signal_received(colmesh_comm(*(bm->colmesh))))
+        repartitioned = balance_colmesh(model, bm) || repartitioned;
+    }
+  }
+  if (repartitioned && (model->vtable.load_balanced != NULL))
+    model->vtable.load_balanced(model->context);
+  STOP_FUNCTION_TIMER();
+}
+
 // Initialize the model at the given time.
 void model_init(model_t* model, real_t t)
 {
@@ -772,6 +968,12 @@ void model_run(model_t* model, real_t t1, real_t t2, int max_steps)
 
       log_detail("%s: Max time step max_dt = %g\n (Reason: %s)", model->name, max_dt, reason);
       model_advance(model, max_dt);
+
+      // Between steps, we can safely balance the load if it's time. Each
+      // mesh is balanced only if no process sharing it has received a
+      // signal.
+      if ((model->lb_every > 0) && ((model->step % model->lb_every) == 0))
+        model_balance_load(model);
     }
     if (_received_signal != 0)
       log_urgent("%s: Simulation interrupted at step %d.", model->name, model->step);
@@ -859,6 +1061,46 @@ void model_set_diagnostic_mode(model_t* model, model_diag_mode_t mode)
   model->diag_mode = mode;
 }
 
+void model_enable_load_balancing(model_t* model, real_t imbalance_tol, int check_every)
+{
+  ASSERT(imbalance_tol > 0.0);
+  ASSERT(check_every > 0);
+  model->lb_tol = imbalance_tol;
+  model->lb_every = check_every;
+}
+
+void model_balance_unimesh(model_t* model,
+                           unimesh_t** mesh,
+                           unimesh_field_t** fields,
+                           size_t num_fields)
+{
+  ASSERT(mesh != NULL);
+  ASSERT((fields != NULL) || (num_fields == 0));
+  balanced_mesh_t* bm = polymec_calloc(1, sizeof(balanced_mesh_t));
+  bm->unimesh = mesh;
+  bm->unimesh_fields = fields;
+  bm->num_fields = num_fields;
+  ptr_array_append_with_dtor(model->balanced_meshes, bm, polymec_free);
+  if (*mesh != NULL)
+    unimesh_measure_patch_costs(*mesh, true);
+}
+
+void model_balance_colmesh(model_t* model,
+                           colmesh_t** mesh,
+                           colmesh_field_t** fields,
+                           size_t num_fields)
+{
+  ASSERT(mesh != NULL);
+  ASSERT((fields != NULL) || (num_fields == 0));
+  balanced_mesh_t* bm = polymec_calloc(1, sizeof(balanced_mesh_t));
+  bm->colmesh = mesh;
+  bm->colmesh_fields = fields;
+  bm->num_fields = num_fields;
+  ptr_array_append_with_dtor(model->balanced_meshes, bm, polymec_free);
+  if (*mesh != NULL)
+    colmesh_measure_chunk_costs(*mesh, true);
+}
+
 model_vtable model_get_vtable(model_t* model)
 {
   return model->vtable;
@@ -11,6 +11,8 @@
 #include "core/polymec.h"
 #include "core/options.h"
 #include "core/st_func.h"
+#include "geometry/unimesh_field.h"
+#include "geometry/colmesh_field.h"
 #include "model/probe.h"
 
 /// \addtogroup model model
@@ -53,6 +55,12 @@ typedef struct
   /// A function for performing work when a probe is added.
   void (*add_probe)(void* context, void* probe_context);
 
+  /// A function for performing work after the model's meshes and fields
+  /// have been repartitioned to balance the load (see
+  /// \ref model_enable_load_balancing), such as reinstating boundary
+  /// conditions on fields.
+  void (*load_balanced)(void* context);
+
   /// A destructor function for the context object (if any).
   void (*dtor)(void* context);
 } model_vtable;
@@ -266,6 +274,44 @@ void model_load_from(model_t* model, int step);
 /// \memberof model
 void model_set_diagnostic_mode(model_t* model, model_diag_mode_t mode);
 
+/// Tells the model to balance the load of its meshes automatically during
+/// \ref model_run. Every check_every steps, the model gathers the compute
+/// costs measured for the patches (chunks) of each mesh registered with
+/// \ref model_balance_unimesh (\ref model_balance_colmesh) and, if the
+/// load imbalance across processes exceeds imbalance_tol, repartitions the
+/// mesh and its fields using the measured costs as weights. The imbalance
+/// before and after repartitioning is logged.
+/// \param [in] imbalance_tol The largest acceptable imbalance, expressed as
+///                           the fraction by which the largest load on a
+///                           process exceeds the average load.
+/// \param [in] check_every The number of steps between imbalance checks.
+/// \memberof model
+void model_enable_load_balancing(model_t* model, real_t imbalance_tol, int check_every);
+
+/// Registers a unimesh whose load is balanced by the model, and starts
+/// measuring the costs of its patches (see \ref unimesh_measure_patch_costs).
+/// \param [in] mesh A pointer to the model's own pointer to the mesh, which
+///                  is replaced whenever the mesh is repartitioned.
+/// \param [in] fields An array of the model's fields on the mesh, whose
+///                    elements are replaced whenever the mesh is repartitioned.
+///                    These pointers must stay valid for the lifetime of the
+///                    model.
+/// \param [in] num_fields The number of fields in the array.
+/// \memberof model
+void model_balance_unimesh(model_t* model,
+                           unimesh_t** mesh,
+                           unimesh_field_t** fields,
+                           size_t num_fields);
+
+/// Registers a colmesh whose load is balanced by the model, and starts
+/// measuring the costs of its chunks (see \ref colmesh_measure_chunk_costs).
+/// The arguments are interpreted as in \ref model_balance_unimesh.
+/// \memberof model
+void model_balance_colmesh(model_t* model,
+                           colmesh_t** mesh,
+                           colmesh_field_t** fields,
+                           size_t num_fields);
+
 /// Retrieves (a copy of) the virtual table for the given model.
 /// \memberof model
 model_vtable model_get_vtable(model_t* model);
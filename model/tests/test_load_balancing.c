@@ -0,0 +1,146 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "geometry/unimesh_patch.h"
+#include "model/model.h"
+
+// This model does work on the patches of a unimesh, with the patches
+// initially owned by the first process costing ten times as much as the
+// others.
+typedef struct
+{
+  unimesh_t* mesh;
+  unimesh_field_t* fields[1];
+  int rank;
+  int* heavy_patches;
+  int num_rebalances;
+} lb_model_t;
+
+static void lb_init(void* context, real_t t)
+{
+  lb_model_t* lb = context;
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0,
+                 .y1 = 0.0, .y2 = 1.0,
+                 .z1 = 0.0, .z2 = 1.0};
+  lb->mesh = unimesh_new(MPI_COMM_WORLD, &bbox, 4, 4, 4, 4, 4, 4,
+                         false, false, false);
+  lb->fields[0] = unimesh_field_new(lb->mesh, UNIMESH_CELL, 1);
+
+  // Tag each patch with its index, and figure out which ones are heavy.
+  lb->heavy_patches = polymec_calloc(4*4*4, sizeof(int));
+  int pos = 0, pi, pj, pk;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(lb->fields[0], &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    int p = 16*pi + 4*pj + pk;
+    lb->heavy_patches[p] = (lb->rank == 0) ? 1 : 0;
+    DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+    for (int i = 1; i <= patch->nx; ++i)
+      for (int j = 1; j <= patch->ny; ++j)
+        for (int k = 1; k <= patch->nz; ++k)
+          f[i][j][k][0] = 1.0 * p;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, lb->heavy_patches, 4*4*4, MPI_INT, MPI_MAX,
+                MPI_COMM_WORLD);
+}
+
+static real_t lb_advance(void* context, real_t max_dt, real_t t)
+{
+  lb_model_t* lb = context;
+  int pos = 0, pi, pj, pk;
+  unimesh_patch_t* patch;
+  while (unimesh_field_next_patch(lb->fields[0], &pos, &pi, &pj, &pk, &patch, NULL))
+  {
+    int p = 16*pi + 4*pj + pk;
+    unimesh_add_patch_cost(lb->mesh, pi, pj, pk, lb->heavy_patches[p] ? 10.0 : 1.0);
+  }
+  return max_dt;
+}
+
+static void lb_load_balanced(void* context)
+{
+  lb_model_t* lb = context;
+  ++(lb->num_rebalances);
+}
+
+static void lb_dtor(void* context)
+{
+  lb_model_t* lb = context;
+  if (lb->mesh != NULL)
+  {
+    unimesh_field_free(lb->fields[0]);
+    unimesh_free(lb->mesh);
+    polymec_free(lb->heavy_patches);
+  }
+  polymec_free(lb);
+}
+
+static void test_balance_unimesh(void** state)
+{
+  int rank, nproc;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+
+  lb_model_t* lb = polymec_calloc(1, sizeof(lb_model_t));
+  lb->rank = rank;
+  model_vtable vtable = {.init = lb_init,
+                         .advance = lb_advance,
+                         .load_balanced = lb_load_balanced,
+                         .dtor = lb_dtor};
+  model_t* model = model_new("load_balancing", lb, vtable, MODEL_MPI);
+  model_enable_load_balancing(model, 0.1, 2);
+
+  // We register the mesh before it's created, so the model starts measuring
+  // its costs at the first check, and rebalances it at the second.
+  model_balance_unimesh(model, &lb->mesh, lb->fields, 1);
+  model_set_max_dt(model, 1.0);
+  model_run(model, 0.0, 4.0, 4);
+
+  if (nproc == 1)
+    assert_int_equal(0, lb->num_rebalances);
+  else
+  {
+    assert_int_equal(1, lb->num_rebalances);
+
+    // Make sure the patches and their data survived, and that the heavy
+    // patches are spread around.
+    int num_patches = unimesh_num_patches(lb->mesh);
+    real_t load = 0.0, max_load, total_load;
+    int pos = 0, pi, pj, pk;
+    unimesh_patch_t* patch;
+    while (unimesh_field_next_patch(lb->fields[0], &pos, &pi, &pj, &pk, &patch, NULL))
+    {
+      int p = 16*pi + 4*pj + pk;
+      load += lb->heavy_patches[p] ? 10.0 : 1.0;
+      DECLARE_UNIMESH_CELL_ARRAY(f, patch);
+      assert_true(reals_equal(f[1][1][1][0], 1.0 * p));
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &num_patches, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&load, &max_load, 1, MPI_REAL_T, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&load, &total_load, 1, MPI_REAL_T, MPI_SUM, MPI_COMM_WORLD);
+    assert_int_equal(4*4*4, num_patches);
+    assert_true(max_load < 10.0 * 64 / nproc);
+    assert_true(max_load <= 1.1 * total_load / nproc + 10.0);
+  }
+
+  model_free(model);
+}
+
+int main(int argc, char* argv[])
+{
+  polymec_init(argc, argv);
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test(test_balance_unimesh)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
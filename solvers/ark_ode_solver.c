@@ -56,6 +56,7 @@ typedef struct
   // JFNK stuff.
   int max_krylov_dim;
   newton_pc_t* precond;
+  long int num_pc_conv_failures; // nonlinear convergence failures at last PC setup
   int (*Jy)(void* context, real_t t, real_t* U, real_t* U_dot, real_t* y, real_t* temp, real_t* Jy);
   SUNLinearSolver ls;
   SUNNonlinearSolver nls;
@@ -328,10 +329,20 @@ static int set_up_preconditioner(real_t t, N_Vector U, N_Vector F,
   ark_ode_t* integ = context;
   if (!jacobian_is_current)
   {
+    // If the nonlinear solver has failed to converge since the preconditioner
+    // was last set up, we report a stalled convergence rate so that it isn't 
+    // reused.
+    long int num_conv_failures;
+    ARKStepGetNumNonlinSolvConvFails(integ->arkode, &num_conv_failures);
+    if (num_conv_failures > integ->num_pc_conv_failures)
+      newton_pc_report_convergence_rate(integ->precond, 1.0);
+    integ->num_pc_conv_failures = num_conv_failures;
+
     // Compute the approximate Jacobian using a solution vector with ghosts.
     memcpy(integ->U_with_ghosts, NV_DATA(U), sizeof(real_t) * integ->num_local_values);
-    newton_pc_setup(integ->precond, 1.0, -gamma, 0.0, t, integ->U_with_ghosts, NULL);
-    *jacobian_was_updated = 1;
+    bool computed = newton_pc_setup(integ->precond, 1.0, -gamma, 0.0, t, 
+                                    integ->U_with_ghosts, NULL);
+    *jacobian_was_updated = (computed) ? 1 : 0;
   }
   else
     *jacobian_was_updated = 0;
@@ -451,6 +462,7 @@ ode_solver_t* functional_ark_ode_solver_new(int order,
   integ->observers = ptr_array_new();
   integ->error_weights = NULL;
   integ->precond = NULL;
+  integ->num_pc_conv_failures = 0;
 
   integ->reset_func = NULL;
   integ->setup_func = NULL;
@@ -608,6 +620,7 @@ ode_solver_t* jfnk_ark_ode_solver_new(int order,
   if (Jy_func != NULL)
     ARKStepSetJacTimes(integ->arkode, set_up_Jy, eval_Jy);
   integ->precond = precond;
+  integ->num_pc_conv_failures = 0;
   ARKStepSetPreconditioner(integ->arkode, set_up_preconditioner,
                             solve_preconditioner_system);
 
@@ -764,6 +777,7 @@ ode_solver_t* ark_ode_solver_new(const char* name,
   integ->stable_dt = (fe_func != NULL) ? stable_dt_func : NULL;
   integ->Jy = NULL;
   integ->precond = NULL;
+  integ->num_pc_conv_failures = 0;
   integ->t = 0.0;
   integ->observers = ptr_array_new();
   integ->error_weights = NULL;
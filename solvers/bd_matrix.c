@@ -14,8 +14,339 @@ struct bd_matrix_t
   int *D_offsets, *B_offsets; // For variable block sizes.
   real_t* D;
   int block_size; // -1 if variable, set to constant size if applicable.
+
+  // LU factorization of the blocks (allocated on first factorization), 
+  // stored in either LU or LU_f depending on the factor precision.
+  bd_matrix_factor_precision_t factor_precision;
+  real_t* LU;
+  float* LU_f;
+  int* pivots;
 };
 
+//------------------------------------------------------------------------
+//                Batched kernels for small fixed block sizes
+//------------------------------------------------------------------------
+
+// Matrices with a constant block size of at most BD_MAX_BATCHED_BLOCK_SIZE
+// are factored and solved in batches of BD_BATCH_SIZE blocks using kernels 
+// specialized for each block size. Within a batch, the blocks are stored in 
+// an interleaved ("batch-of-blocks") layout: the (r, c) entries of all blocks 
+// in the batch are contiguous, so each kernel operates on the entire batch 
+// with unit-stride inner loops that the compiler can vectorize. Element (r, c)
+// of the lth block in a batch lives at index (c*bs + r)*BD_BATCH_SIZE + l.
+#define BD_BATCH_SIZE 8
+#define BD_MAX_BATCHED_BLOCK_SIZE 8
+
+// Computes LU factorizations (with partial pivoting) of B interleaved n x n 
+// matrices in place, storing their (interleaved) pivot indices in piv and 
+// recording which of them are nonsingular. Zero pivots are replaced with 1 
+// so that solves with the factors of singular matrices are harmless. The 
+// batched kernels below inline this with constant n and B, and 
+// interleaved_lu_factor exposes it for arbitrary n and B. 
+//
+// Every phase of the factorization loops over the matrices innermost, 
+// with pivots selected and rows swapped by comparing and selecting instead 
+// of branching, so that the compiler can vectorize across the batch. 
+// Pivot magnitudes and reciprocals are kept for BD_BATCH_SIZE matrices at 
+// a time.
+static inline void lu_factor_interleaved(int n, int B, real_t* A, int* piv, 
+                                         bool* nonsingular)
+{
+  for (int l = 0; l < B; ++l)
+    nonsingular[l] = true;
+  for (int k = 0; k < n; ++k)
+  {
+    int* piv_k = &piv[k*B];
+    for (int l0 = 0; l0 < B; l0 += BD_BATCH_SIZE)
+    {
+      int l1 = MIN(l0 + BD_BATCH_SIZE, B);
+      real_t p_max[BD_BATCH_SIZE], pivot_inv[BD_BATCH_SIZE];
+
+      // Find the pivot row for each matrix.
+      for (int l = l0; l < l1; ++l)
+      {
+        piv_k[l] = k;
+        p_max[l-l0] = ABS(A[(k*n+k)*B+l]);
+      }
+      for (int r = k+1; r < n; ++r)
+      {
+        for (int l = l0; l < l1; ++l)
+        {
+          real_t a = ABS(A[(k*n+r)*B+l]);
+          bool larger = (a > p_max[l-l0]);
+          piv_k[l] = larger ? r : piv_k[l];
+          p_max[l-l0] = larger ? a : p_max[l-l0];
+        }
+      }
+
+      // Swap the pivot rows into place.
+      for (int c = 0; c < n; ++c)
+      {
+        for (int r = k+1; r < n; ++r)
+        {
+          for (int l = l0; l < l1; ++l)
+          {
+            bool swap = (piv_k[l] == r);
+            real_t a_k = A[(c*n+k)*B+l], a_r = A[(c*n+r)*B+l];
+            A[(c*n+k)*B+l] = swap ? a_r : a_k;
+            A[(c*n+r)*B+l] = swap ? a_k : a_r;
+          }
+        }
+      }
+
+      // Replace zero pivots, and compute the multipliers.
+      for (int l = l0; l < l1; ++l)
+      {
+        bool singular = !(p_max[l-l0] > 0.0);
+        nonsingular[l] = nonsingular[l] && !singular;
+        A[(k*n+k)*B+l] = singular ? 1.0 : A[(k*n+k)*B+l];
+        pivot_inv[l-l0] = 1.0 / A[(k*n+k)*B+l];
+      }
+      for (int r = k+1; r < n; ++r)
+      {
+        for (int l = l0; l < l1; ++l)
+          A[(k*n+r)*B+l] *= pivot_inv[l-l0];
+      }
+    }
+
+    // Update the trailing submatrices.
+    for (int c = k+1; c < n; ++c)
+    {
+      for (int r = k+1; r < n; ++r)
+      {
+        for (int l = 0; l < B; ++l)
+          A[(c*n+r)*B+l] -= A[(k*n+r)*B+l] * A[(c*n+k)*B+l];
+      }
+    }
+  }
+}
+
+// Defines a function that solves B interleaved factored n x n systems, 
+// overwriting the interleaved right hand side x (whose rth component for 
+// system l lives at x[r*B+l]) with the solution. The factors are stored 
+// with the given type (real_t or float), and the solution is always 
+// computed in real_t.
+#define DEFINE_LU_SOLVE_INTERLEAVED(func_name, factor_type) \
+static inline void func_name(int n, int B, factor_type* LU, int* piv, real_t* x) \
+{ \
+  /* Apply row interchanges. */ \
+  for (int k = 0; k < n; ++k) \
+  { \
+    for (int l = 0; l < B; ++l) \
+    { \
+      real_t tmp = x[k*B+l]; \
+      x[k*B+l] = x[piv[k*B+l]*B+l]; \
+      x[piv[k*B+l]*B+l] = tmp; \
+    } \
+  } \
+\
+  /* Forward substitution (L has a unit diagonal). */ \
+  for (int k = 0; k < n; ++k) \
+  { \
+    for (int r = k+1; r < n; ++r) \
+    { \
+      for (int l = 0; l < B; ++l) \
+        x[r*B+l] -= (real_t)LU[(k*n+r)*B+l] * x[k*B+l]; \
+    } \
+  } \
+\
+  /* Backward substitution. */ \
+  for (int k = n-1; k >= 0; --k) \
+  { \
+    for (int l = 0; l < B; ++l) \
+      x[k*B+l] /= (real_t)LU[(k*n+k)*B+l]; \
+    for (int r = 0; r < k; ++r) \
+    { \
+      for (int l = 0; l < B; ++l) \
+        x[r*B+l] -= (real_t)LU[(k*n+r)*B+l] * x[k*B+l]; \
+    } \
+  } \
+}
+
+DEFINE_LU_SOLVE_INTERLEAVED(lu_solve_interleaved, real_t)
+DEFINE_LU_SOLVE_INTERLEAVED(lu_solve_interleaved_f, float)
+
+// Defines an LU factorization kernel for a batch of bs x bs blocks. Returns
+// false if any block in the batch is singular.
+#define DEFINE_BATCHED_LU_FACTOR(bs) \
+static bool batched_lu_factor_##bs(real_t* A, int* piv) \
+{ \
+  bool nonsingular[BD_BATCH_SIZE]; \
+  lu_factor_interleaved(bs, BD_BATCH_SIZE, A, piv, nonsingular); \
+  bool all_nonsingular = true; \
+  for (int l = 0; l < BD_BATCH_SIZE; ++l) \
+    all_nonsingular = all_nonsingular && nonsingular[l]; \
+  return all_nonsingular; \
+}
+
+// Defines a kernel that solves the factored systems for a batch of bs x bs 
+// blocks using the given interleaved solve.
+#define DEFINE_BATCHED_LU_SOLVE(bs, func_name, solve, factor_type) \
+static void func_name##_##bs(factor_type* LU, int* piv, real_t* x) \
+{ \
+  solve(bs, BD_BATCH_SIZE, LU, piv, x); \
+}
+
+// Defines a kernel that computes the product of num_blocks consecutive 
+// (column-major) bs x bs blocks in D with the corresponding segments of x, 
+// storing the results in y.
+#define DEFINE_BLOCK_MATVEC(bs) \
+static void block_matvec_##bs(size_t num_blocks, real_t* D, real_t* x, real_t* y) \
+{ \
+  for (size_t b = 0; b < num_blocks; ++b) \
+  { \
+    real_t* A = &D[b*bs*bs]; \
+    real_t* xb = &x[b*bs]; \
+    real_t* yb = &y[b*bs]; \
+    for (int r = 0; r < bs; ++r) \
+      yb[r] = 0.0; \
+    for (int c = 0; c < bs; ++c) \
+    { \
+      for (int r = 0; r < bs; ++r) \
+        yb[r] += A[c*bs+r] * xb[c]; \
+    } \
+  } \
+}
+
+#define DEFINE_BD_KERNELS(bs) \
+  DEFINE_BATCHED_LU_FACTOR(bs) \
+  DEFINE_BATCHED_LU_SOLVE(bs, batched_lu_solve, lu_solve_interleaved, real_t) \
+  DEFINE_BATCHED_LU_SOLVE(bs, batched_lu_solve_f, lu_solve_interleaved_f, float) \
+  DEFINE_BLOCK_MATVEC(bs)
+
+DEFINE_BD_KERNELS(1)
+DEFINE_BD_KERNELS(2)
+DEFINE_BD_KERNELS(3)
+DEFINE_BD_KERNELS(4)
+DEFINE_BD_KERNELS(5)
+DEFINE_BD_KERNELS(6)
+DEFINE_BD_KERNELS(7)
+DEFINE_BD_KERNELS(8)
+
+// Dispatch tables for the above kernels, indexed by block size.
+typedef bool (*batched_lu_factor_func)(real_t* A, int* piv);
+typedef void (*batched_lu_solve_func)(real_t* LU, int* piv, real_t* x);
+typedef void (*batched_lu_solve_f_func)(float* LU, int* piv, real_t* x);
+typedef void (*block_matvec_func)(size_t num_blocks, real_t* D, real_t* x, real_t* y);
+
+static batched_lu_factor_func batched_lu_factor[BD_MAX_BATCHED_BLOCK_SIZE+1] = 
+  {NULL, batched_lu_factor_1, batched_lu_factor_2, batched_lu_factor_3, 
+   batched_lu_factor_4, batched_lu_factor_5, batched_lu_factor_6, 
+   batched_lu_factor_7, batched_lu_factor_8};
+
+static batched_lu_solve_func batched_lu_solve[BD_MAX_BATCHED_BLOCK_SIZE+1] = 
+  {NULL, batched_lu_solve_1, batched_lu_solve_2, batched_lu_solve_3, 
+   batched_lu_solve_4, batched_lu_solve_5, batched_lu_solve_6, 
+   batched_lu_solve_7, batched_lu_solve_8};
+
+static batched_lu_solve_f_func batched_lu_solve_f[BD_MAX_BATCHED_BLOCK_SIZE+1] = 
+  {NULL, batched_lu_solve_f_1, batched_lu_solve_f_2, batched_lu_solve_f_3, 
+   batched_lu_solve_f_4, batched_lu_solve_f_5, batched_lu_solve_f_6, 
+   batched_lu_solve_f_7, batched_lu_solve_f_8};
+
+static block_matvec_func block_matvec[BD_MAX_BATCHED_BLOCK_SIZE+1] = 
+  {NULL, block_matvec_1, block_matvec_2, block_matvec_3, block_matvec_4,
+   block_matvec_5, block_matvec_6, block_matvec_7, block_matvec_8};
+
+// Returns true if the given matrix can use the batched kernels.
+static inline bool is_batchable(bd_matrix_t* A)
+{
+  return ((A->block_size > 0) && (A->block_size <= BD_MAX_BATCHED_BLOCK_SIZE));
+}
+
+// Returns the number of batches needed to store the blocks of A.
+static inline size_t num_batches(bd_matrix_t* A)
+{
+  return (A->num_block_rows + BD_BATCH_SIZE - 1) / BD_BATCH_SIZE;
+}
+
+// Copies the blocks of the given batch in A into the interleaved array 
+// A_batch, padding any unused slots with identity blocks. Zeros on the 
+// diagonal are replaced with a small number as in solve_bd_system.
+static void gather_batch(bd_matrix_t* A, size_t batch, real_t* A_batch)
+{
+  const int B = BD_BATCH_SIZE;
+  int bs = A->block_size;
+  for (int l = 0; l < B; ++l)
+  {
+    size_t i = batch*B + l;
+    if (i < A->num_block_rows)
+    {
+      real_t* Ai = &A->D[A->D_offsets[i]];
+      for (int j = 0; j < bs*bs; ++j)
+        A_batch[j*B+l] = Ai[j];
+    }
+    else
+    {
+      for (int j = 0; j < bs*bs; ++j)
+        A_batch[j*B+l] = ((j % (bs+1)) == 0) ? 1.0 : 0.0;
+    }
+  }
+  static const real_t epsilon = 1e-25;
+  for (int j = 0; j < bs; ++j)
+  {
+    for (int l = 0; l < B; ++l)
+    {
+      if (reals_equal(A_batch[(bs*j+j)*B+l], 0.0))
+        A_batch[(bs*j+j)*B+l] = epsilon;
+    }
+  }
+}
+
+// Copies the segments of the vector v corresponding to the given batch of 
+// blocks into the interleaved array v_batch (padding with zeros).
+static void gather_batch_vector(bd_matrix_t* A, size_t batch, 
+                                real_t* v, real_t* v_batch)
+{
+  const int B = BD_BATCH_SIZE;
+  int bs = A->block_size;
+  for (int l = 0; l < B; ++l)
+  {
+    size_t i = batch*B + l;
+    for (int r = 0; r < bs; ++r)
+      v_batch[r*B+l] = (i < A->num_block_rows) ? v[bs*i+r] : 0.0;
+  }
+}
+
+// Copies the interleaved array v_batch back into the corresponding segments 
+// of the vector v.
+static void scatter_batch_vector(bd_matrix_t* A, size_t batch, 
+                                 real_t* v_batch, real_t* v)
+{
+  const int B = BD_BATCH_SIZE;
+  int bs = A->block_size;
+  for (int l = 0; l < B; ++l)
+  {
+    size_t i = batch*B + l;
+    if (i < A->num_block_rows)
+    {
+      for (int r = 0; r < bs; ++r)
+        v[bs*i+r] = v_batch[r*B+l];
+    }
+  }
+}
+
+// Solves A*X = B for a matrix A that can use the batched kernels.
+static bool batched_solve_bd_system(bd_matrix_t* A, real_t* B, real_t* X)
+{
+  int bs = A->block_size;
+  real_t A_batch[bs*bs*BD_BATCH_SIZE], x_batch[bs*BD_BATCH_SIZE];
+  int piv[bs*BD_BATCH_SIZE];
+  for (size_t b = 0; b < num_batches(A); ++b)
+  {
+    gather_batch(A, b, A_batch);
+    if (!batched_lu_factor[bs](A_batch, piv))
+    {
+      log_debug("bd_matrix_solve: batch %d contains a singular block.", (int)b);
+      return false;
+    }
+    gather_batch_vector(A, b, B, x_batch);
+    batched_lu_solve[bs](A_batch, piv, x_batch);
+    scatter_batch_vector(A, b, x_batch, X);
+  }
+  return true;
+}
+
 bd_matrix_t* bd_matrix_new(size_t num_block_rows,
                            size_t block_size)
 {
@@ -56,6 +387,10 @@ bd_matrix_t* var_bd_matrix_new(size_t num_block_rows,
     A->block_size = -1;
   int N = A->D_offsets[A->num_block_rows];
   A->D = polymec_calloc(N, sizeof(real_t));
+  A->factor_precision = BD_MATRIX_FACTOR_REAL;
+  A->LU = NULL;
+  A->LU_f = NULL;
+  A->pivots = NULL;
   return A;
 }
 
@@ -71,11 +406,30 @@ bd_matrix_t* bd_matrix_clone(bd_matrix_t* matrix)
   clone->D = polymec_malloc(sizeof(real_t) * N);
   memcpy(clone->D, matrix->D, sizeof(real_t) * N);
   clone->block_size = matrix->block_size;
+  clone->factor_precision = matrix->factor_precision;
+  clone->LU = NULL;
+  clone->LU_f = NULL;
+  clone->pivots = NULL;
   return clone;
 }
 
+// Frees any storage associated with the factorization of the matrix.
+static void free_factorization(bd_matrix_t* matrix)
+{
+  if (matrix->LU != NULL)
+    polymec_free(matrix->LU);
+  if (matrix->LU_f != NULL)
+    polymec_free(matrix->LU_f);
+  if (matrix->pivots != NULL)
+    polymec_free(matrix->pivots);
+  matrix->LU = NULL;
+  matrix->LU_f = NULL;
+  matrix->pivots = NULL;
+}
+
 void bd_matrix_free(bd_matrix_t* matrix)
 {
+  free_factorization(matrix);
   polymec_free(matrix->D);
   polymec_free(matrix->D_offsets);
   polymec_free(matrix->B_offsets);
@@ -131,6 +485,13 @@ void bd_matrix_add_block(bd_matrix_t* matrix, int block_row, real_t* block)
 
 void bd_matrix_matvec(bd_matrix_t* matrix, real_t* vector, real_t* product)
 {
+  if (is_batchable(matrix))
+  {
+    block_matvec[matrix->block_size](matrix->num_block_rows, matrix->D, 
+                                     vector, product);
+    return;
+  }
+
   for (int i = 0; i < (int)matrix->num_block_rows; ++i)
   {
     int bs = matrix->B_offsets[i+1] - matrix->B_offsets[i];
@@ -172,6 +533,9 @@ real_t* bd_matrix_block(bd_matrix_t* matrix, int block_row)
 
 bool solve_bd_system(bd_matrix_t* A, real_t* B, real_t* x)
 {
+  if (is_batchable(A))
+    return batched_solve_bd_system(A, B, x);
+
   real_t* D = A->D;
 
   bool success = false;
@@ -214,3 +578,207 @@ bool solve_bd_system(bd_matrix_t* A, real_t* B, real_t* x)
   return success;
 }
 
+
+void bd_matrix_set_factor_precision(bd_matrix_t* matrix,
+                                    bd_matrix_factor_precision_t precision)
+{
+  if (precision != matrix->factor_precision)
+  {
+    free_factorization(matrix);
+    matrix->factor_precision = precision;
+  }
+}
+
+bd_matrix_factor_precision_t bd_matrix_factor_precision(bd_matrix_t* matrix)
+{
+  return matrix->factor_precision;
+}
+
+bool bd_matrix_factor(bd_matrix_t* matrix)
+{
+  bool use_floats = (matrix->factor_precision == BD_MATRIX_FACTOR_FLOAT);
+
+  // Allocate storage for the factorization if we haven't already. This 
+  // storage is reused by subsequent factorizations. Batchable matrices store 
+  // their factors in interleaved batches.
+  if (matrix->pivots == NULL)
+  {
+    size_t LU_size, piv_size;
+    if (is_batchable(matrix))
+    {
+      size_t bs = (size_t)matrix->block_size;
+      LU_size = num_batches(matrix) * BD_BATCH_SIZE * bs * bs;
+      piv_size = num_batches(matrix) * BD_BATCH_SIZE * bs;
+    }
+    else
+    {
+      LU_size = matrix->D_offsets[matrix->num_block_rows];
+      piv_size = matrix->B_offsets[matrix->num_block_rows];
+    }
+    if (use_floats)
+      matrix->LU_f = polymec_malloc(sizeof(float) * LU_size);
+    else
+      matrix->LU = polymec_malloc(sizeof(real_t) * LU_size);
+    matrix->pivots = polymec_malloc(sizeof(int) * piv_size);
+  }
+
+  bool success = true;
+  if (is_batchable(matrix))
+  {
+    int bs = matrix->block_size;
+    size_t batch_size = BD_BATCH_SIZE * bs * bs;
+    real_t work[(use_floats) ? batch_size : 1];
+    for (size_t b = 0; b < num_batches(matrix); ++b)
+    {
+      // Single precision factors are computed in full precision and then 
+      // truncated.
+      real_t* LU_b = (use_floats) ? work : &matrix->LU[b * batch_size];
+      int* piv_b = &matrix->pivots[b * BD_BATCH_SIZE * bs];
+      gather_batch(matrix, b, LU_b);
+      if (!batched_lu_factor[bs](LU_b, piv_b))
+      {
+        log_debug("bd_matrix_factor: batch %d contains a singular block.", (int)b);
+        success = false;
+        break;
+      }
+      if (use_floats)
+      {
+        float* LU_f_b = &matrix->LU_f[b * batch_size];
+        for (size_t j = 0; j < batch_size; ++j)
+          LU_f_b[j] = (float)LU_b[j];
+      }
+    }
+  }
+  else
+  {
+    for (int i = 0; i < matrix->num_block_rows; ++i)
+    {
+      int bs = matrix->B_offsets[i+1] - matrix->B_offsets[i];
+      real_t work[(use_floats) ? bs*bs : 1];
+      real_t* LUi = (use_floats) ? work : &matrix->LU[matrix->D_offsets[i]];
+      memcpy(LUi, &matrix->D[matrix->D_offsets[i]], sizeof(real_t) * bs * bs);
+      int* pivi = &matrix->pivots[matrix->B_offsets[i]];
+
+      // Replace each zero on the diagonal with a small number, as in 
+      // solve_bd_system.
+      static const real_t epsilon = 1e-25;
+      for (int j = 0; j < bs; ++j)
+      {
+        if (reals_equal(LUi[bs*j+j], 0.0))
+          LUi[bs*j+j] = epsilon;
+      }
+
+      int info;
+      rgetrf(&bs, &bs, LUi, &bs, pivi, &info);
+      if (info != 0)
+      {
+        ASSERT(info > 0);
+        log_debug("bd_matrix_factor: call to rgetrf failed for block row %d.", i);
+        log_debug("bd_matrix_factor: (U is singular.)");
+        success = false;
+        break;
+      }
+      if (use_floats)
+      {
+        float* LU_fi = &matrix->LU_f[matrix->D_offsets[i]];
+        for (int j = 0; j < bs*bs; ++j)
+          LU_fi[j] = (float)LUi[j];
+      }
+    }
+  }
+
+  // Don't leave a partial factorization lying around.
+  if (!success)
+    free_factorization(matrix);
+
+  return success;
+}
+
+bool bd_matrix_is_factored(bd_matrix_t* matrix)
+{
+  return (matrix->pivots != NULL);
+}
+
+// Solves the system for a single (column-major) bs x bs block factored by 
+// LAPACK's getrf and stored in single precision, overwriting x with the 
+// solution.
+static void lu_solve_f(int bs, float* LU, int* piv, real_t* x)
+{
+  // Apply row interchanges (LAPACK's pivot indices are 1-based).
+  for (int k = 0; k < bs; ++k)
+  {
+    int p = piv[k] - 1;
+    real_t tmp = x[k];
+    x[k] = x[p];
+    x[p] = tmp;
+  }
+  for (int k = 0; k < bs; ++k)
+  {
+    for (int r = k+1; r < bs; ++r)
+      x[r] -= (real_t)LU[k*bs+r] * x[k];
+  }
+  for (int k = bs-1; k >= 0; --k)
+  {
+    x[k] /= (real_t)LU[k*bs+k];
+    for (int r = 0; r < k; ++r)
+      x[r] -= (real_t)LU[k*bs+r] * x[k];
+  }
+}
+
+void solve_factored_bd_system(bd_matrix_t* A, real_t* B, real_t* X)
+{
+  ASSERT(bd_matrix_is_factored(A));
+  bool use_floats = (A->factor_precision == BD_MATRIX_FACTOR_FLOAT);
+  if (is_batchable(A))
+  {
+    int bs = A->block_size;
+    real_t x_batch[bs*BD_BATCH_SIZE];
+    for (size_t b = 0; b < num_batches(A); ++b)
+    {
+      int* piv_b = &A->pivots[b * BD_BATCH_SIZE * bs];
+      gather_batch_vector(A, b, B, x_batch);
+      if (use_floats)
+        batched_lu_solve_f[bs](&A->LU_f[b * BD_BATCH_SIZE * bs * bs], piv_b, x_batch);
+      else
+        batched_lu_solve[bs](&A->LU[b * BD_BATCH_SIZE * bs * bs], piv_b, x_batch);
+      scatter_batch_vector(A, b, x_batch, X);
+    }
+  }
+  else
+  {
+    if (X != B)
+      memcpy(X, B, sizeof(real_t) * A->B_offsets[A->num_block_rows]);
+    for (int i = 0; i < A->num_block_rows; ++i)
+    {
+      int bs = A->B_offsets[i+1] - A->B_offsets[i];
+      int* pivi = &A->pivots[A->B_offsets[i]];
+      real_t* Xi = &X[A->B_offsets[i]];
+      if (use_floats)
+        lu_solve_f(bs, &A->LU_f[A->D_offsets[i]], pivi, Xi);
+      else
+      {
+        char no_trans = 'N';
+        int one = 1, info;
+        rgetrs(&no_trans, &bs, &one, &A->LU[A->D_offsets[i]], &bs, pivi, 
+               Xi, &bs, &info);
+        ASSERT(info == 0);
+      }
+    }
+  }
+}
+
+void interleaved_lu_factor(int n, int batch_size, real_t* A, int* pivots,
+                           bool* nonsingular)
+{
+  ASSERT(n > 0);
+  ASSERT(batch_size > 0);
+  lu_factor_interleaved(n, batch_size, A, pivots, nonsingular);
+}
+
+void interleaved_lu_solve(int n, int batch_size, real_t* LU, int* pivots, 
+                          real_t* x)
+{
+  ASSERT(n > 0);
+  ASSERT(batch_size > 0);
+  lu_solve_interleaved(n, batch_size, LU, pivots, x);
+}
@@ -82,6 +82,70 @@ void bd_matrix_fprintf(bd_matrix_t* matrix, FILE* stream);
 /// \memberof bd_matrix
 bool solve_bd_system(bd_matrix_t* A, real_t* B, real_t* X);
 
+/// \enum bd_matrix_factor_precision_t
+/// Precisions in which the LU factors of a block diagonal matrix can be 
+/// stored.
+typedef enum
+{
+  BD_MATRIX_FACTOR_REAL, // Factors are stored as real_t (the default).
+  BD_MATRIX_FACTOR_FLOAT // Factors are stored as float, halving the memory 
+                         // traffic in solves at the expense of accuracy.
+} bd_matrix_factor_precision_t;
+
+/// Sets the precision in which the matrix stores its LU factors. Factors 
+/// are always computed in full precision, and solves are always carried 
+/// out in full precision. Changing the precision discards any existing 
+/// factorization.
+/// \memberof bd_matrix
+void bd_matrix_set_factor_precision(bd_matrix_t* matrix,
+                                    bd_matrix_factor_precision_t precision);
+
+/// Returns the precision in which the matrix stores its LU factors.
+/// \memberof bd_matrix
+bd_matrix_factor_precision_t bd_matrix_factor_precision(bd_matrix_t* matrix);
+
+/// Computes and stores an LU factorization of each of the blocks in the 
+/// matrix, so that systems involving the matrix can be solved repeatedly by 
+/// solve_factored_bd_system without refactoring. The storage for the 
+/// factorization is allocated once and reused by later factorizations. 
+/// Changes to the matrix's entries are not reflected in the factorization 
+/// until this function is called again.
+/// \returns true if all blocks were factored, false if any was singular 
+///          (in which case the matrix holds no factorization).
+/// \memberof bd_matrix
+bool bd_matrix_factor(bd_matrix_t* matrix);
+
+/// Returns true if the matrix holds an LU factorization computed by 
+/// bd_matrix_factor, false if not.
+/// \memberof bd_matrix
+bool bd_matrix_is_factored(bd_matrix_t* matrix);
+
+/// Solves the linear system A*X = B using the factorization of A computed by
+/// the most recent call to bd_matrix_factor. X and B may point to the same 
+/// storage.
+/// \memberof bd_matrix
+void solve_factored_bd_system(bd_matrix_t* A, real_t* B, real_t* X);
+
+/// Computes LU factorizations (with partial pivoting) of a batch of 
+/// batch_size dense n x n matrices in place. The matrices are interleaved: 
+/// the (r, c) entry of the lth matrix lives at A[(c*n + r)*batch_size + l].
+/// This is the kernel bd_matrix uses to factor its blocks.
+/// \param [in,out] A The interleaved matrices, overwritten by their factors.
+/// \param [out] pivots Stores the (interleaved, 0-based) pivot rows, with 
+///                     the kth pivot of the lth matrix at 
+///                     pivots[k*batch_size + l]. Must hold n*batch_size ints.
+/// \param [out] nonsingular Stores whether each matrix is nonsingular. Zero 
+///                          pivots of singular matrices are replaced with 1,
+///                          so solves with their factors are harmless.
+void interleaved_lu_factor(int n, int batch_size, real_t* A, int* pivots,
+                           bool* nonsingular);
+
+/// Solves a batch of factored systems computed by interleaved_lu_factor in 
+/// place. The rth component of the lth right hand side lives at 
+/// x[r*batch_size + l], and is overwritten by the solution.
+void interleaved_lu_solve(int n, int batch_size, real_t* LU, int* pivots, 
+                          real_t* x);
+
 ///@}
 
 #endif
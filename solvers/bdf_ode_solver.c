@@ -288,11 +288,17 @@ static int set_up_preconditioner(real_t t, N_Vector U, N_Vector F,
   bdf_ode_t* solver = context;
   if (!jacobian_is_current)
   {
+    // Let the preconditioner know how well the Newton iteration has been 
+    // converging with it, so it can decide whether it can be reused.
+    CVodeMem cv_mem = solver->cvode;
+    newton_pc_report_convergence_rate(solver->precond, cv_mem->cv_crate);
+
     // Compute the approximate Jacobian using a solution vector with ghosts.
     log_debug("jfnk_bdf_ode_solver: Calculating P = I - %g * J.", gamma);
     memcpy(solver->U_with_ghosts, NV_DATA(U), sizeof(real_t) * solver->num_local_values);
-    newton_pc_setup(solver->precond, 1.0, -gamma, 0.0, t, solver->U_with_ghosts, NULL);
-    *jacobian_was_updated = 1;
+    bool computed = newton_pc_setup(solver->precond, 1.0, -gamma, 0.0, t, 
+                                    solver->U_with_ghosts, NULL);
+    *jacobian_was_updated = (computed) ? 1 : 0;
   }
   else
     *jacobian_was_updated = 0;
@@ -580,6 +586,14 @@ newton_pc_t* bdf_ode_solver_preconditioner(ode_solver_t* solver)
   return bdf->precond;
 }
 
+void bdf_ode_solver_set_pc_reuse_policy(ode_solver_t* solver,
+                                        newton_pc_reuse_policy_t policy)
+{
+  bdf_ode_t* bdf = ode_solver_context(solver);
+  ASSERT(bdf->precond != NULL);
+  newton_pc_set_reuse_policy(bdf->precond, policy);
+}
+
 void bdf_ode_solver_get_diagnostics(ode_solver_t* solver, 
                                     bdf_ode_solver_diagnostics_t* diagnostics)
 {
@@ -601,6 +615,11 @@ void bdf_ode_solver_get_diagnostics(ode_solver_t* solver,
     CVodeGetNumPrecEvals(bdf->cvode, &diagnostics->num_preconditioner_evaluations);
     CVodeGetNumPrecSolves(bdf->cvode, &diagnostics->num_preconditioner_solves);
     CVodeGetNumLinConvFails(bdf->cvode, &diagnostics->num_linear_solve_convergence_failures);
+    newton_pc_diagnostics_t pc_diags;
+    newton_pc_get_diagnostics(bdf->precond, &pc_diags);
+    diagnostics->num_preconditioner_reuses = pc_diags.num_reuses;
+    diagnostics->preconditioner_setup_time = pc_diags.computation_time;
+    diagnostics->preconditioner_setup_time_saved = pc_diags.time_saved;
   }
   else
   {
@@ -608,6 +627,9 @@ void bdf_ode_solver_get_diagnostics(ode_solver_t* solver,
     diagnostics->num_linear_solve_convergence_failures = (long int)bdf->num_linear_conv_failures;
     diagnostics->num_preconditioner_solves = -1;
     diagnostics->num_preconditioner_evaluations = -1;
+    diagnostics->num_preconditioner_reuses = -1;
+    diagnostics->preconditioner_setup_time = 0.0;
+    diagnostics->preconditioner_setup_time_saved = 0.0;
   }
 }
 
@@ -634,6 +656,9 @@ void bdf_ode_solver_diagnostics_fprintf(bdf_ode_solver_diagnostics_t* diagnostic
   {
     fprintf(stream, "  Num preconditioner evaluations: %d\n", (int)diagnostics->num_preconditioner_evaluations);
     fprintf(stream, "  Num preconditioner solves: %d\n", (int)diagnostics->num_preconditioner_solves);
+    fprintf(stream, "  Num preconditioner reuses: %d\n", (int)diagnostics->num_preconditioner_reuses);
+    fprintf(stream, "  Preconditioner setup time: %g s\n", diagnostics->preconditioner_setup_time);
+    fprintf(stream, "  Preconditioner setup time saved by reuse: %g s\n", diagnostics->preconditioner_setup_time_saved);
   }
 }
 
@@ -261,6 +261,14 @@ void bdf_ode_solver_eval_rhs(ode_solver_t* integ, real_t t, real_t* U, real_t* U
 /// \relates ode_solver
 newton_pc_t* bdf_ode_solver_preconditioner(ode_solver_t* solver);
 
+/// Sets the policy that governs how the preconditioner of a JFNK BDF solver
+/// is reused (lagged) across Newton iterations and time steps. This is 
+/// shorthand for calling newton_pc_set_reuse_policy on the solver's 
+/// preconditioner.
+/// \relates ode_solver
+void bdf_ode_solver_set_pc_reuse_policy(ode_solver_t* solver,
+                                        newton_pc_reuse_policy_t policy);
+
 /// \class bdf_ode_solver_diagnostics
 /// Diagnostics for the time solver.
 typedef struct
@@ -278,6 +286,9 @@ typedef struct
   long int num_nonlinear_solve_convergence_failures;
   long int num_preconditioner_evaluations;
   long int num_preconditioner_solves;
+  long int num_preconditioner_reuses;
+  real_t preconditioner_setup_time;       // wall time spent computing P.
+  real_t preconditioner_setup_time_saved; // estimated wall time saved by reusing P.
 } bdf_ode_solver_diagnostics_t;
 
 /// Retrieve diagnostics for the time solver.
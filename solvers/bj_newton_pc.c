@@ -9,6 +9,53 @@
 #include "solvers/bd_matrix.h"
 #include "solvers/bj_newton_pc.h"
 
+// Solves P*z = r using the factorization of P, applying up to 
+// max_refinements steps of iterative refinement until the L2 norm of the 
+// residual r - P*z falls below the given tolerance. Residuals are computed 
+// with P itself (in full precision), so refinement converges to the 
+// solution of the system with P even if its factors are stored in single 
+// precision. res is work space for the residual, with room for all of P's 
+// rows. Returns true if the tolerance is met, false otherwise.
+static bool solve_bd_with_refinement(bd_matrix_t* P, 
+                                     int max_refinements,
+                                     real_t tolerance,
+                                     real_t* r, 
+                                     real_t* z, 
+                                     real_t* res,
+                                     real_t* error_L2_norm)
+{
+  if (!bd_matrix_is_factored(P))
+    return false;
+
+  solve_factored_bd_system(P, r, z);
+  size_t N = bd_matrix_num_rows(P);
+  int num_refinements = 0;
+  while (true)
+  {
+    // Compute the residual and measure its L2 norm against tolerance.
+    bd_matrix_matvec(P, z, res);
+    *error_L2_norm = 0.0;
+    polymec_suspend_fpe();
+    for (int i = 0; i < N; ++i)
+    {
+      res[i] = r[i] - res[i];
+      *error_L2_norm += res[i]*res[i];
+    }
+    *error_L2_norm = sqrt(*error_L2_norm);
+    polymec_restore_fpe();
+    if (*error_L2_norm < tolerance)
+      return true;
+    if (num_refinements == max_refinements)
+      return false;
+
+    // Correct z using the (possibly reduced-precision) factors.
+    solve_factored_bd_system(P, res, res);
+    for (int i = 0; i < N; ++i)
+      z[i] += res[i];
+    ++num_refinements;
+  }
+}
+
 typedef struct 
 {
   void* context;
@@ -18,6 +65,8 @@ typedef struct
   void (*dtor)(void* context);
   size_t num_block_rows;
   bd_matrix_t* D;
+  int max_refinements;
+  real_t* res; // refinement residual
 } bj_pc_t;
 
 static void bj_compute_p(void* context, 
@@ -30,6 +79,10 @@ static void bj_compute_p(void* context,
     real_t* J = bd_matrix_block(pc->D, i);
     pc->compute_diag_block(pc->context, i, alpha, beta, gamma, t, x, x_dot, J);
   }
+
+  // Factor the blocks now so that solves (which may happen many times 
+  // before the next setup) don't have to.
+  bd_matrix_factor(pc->D);
 }
 
 static bool bj_solve(void* context, 
@@ -37,26 +90,21 @@ static bool bj_solve(void* context,
                      real_t* r, real_t* z, real_t* error_L2_norm)
 {
   bj_pc_t* pc = context;
-  bool solved = solve_bd_system(pc->D, r, z);
-  if (solved)
-  {
-    // Compute the L2 norm and measure against tolerance.
-    size_t N = bd_matrix_num_rows(pc->D);
-    real_t Pz[N];
-    bd_matrix_matvec(pc->D, z, Pz);
-    *error_L2_norm = 0.0;
-    for (int i = 0; i < N; ++i)
-      *error_L2_norm += (Pz[i]-r[i])*(Pz[i]-r[i]);
-    *error_L2_norm = sqrt(*error_L2_norm);
-    if (*error_L2_norm >= tolerance)
-      solved = false;
-  }
-  return solved;
+  return solve_bd_with_refinement(pc->D, pc->max_refinements, tolerance, 
+                                  r, z, pc->res, error_L2_norm);
+}
+
+static void bj_use_mixed_precision(void* context, int max_refinements)
+{
+  bj_pc_t* pc = context;
+  pc->max_refinements = max_refinements;
+  bd_matrix_set_factor_precision(pc->D, BD_MATRIX_FACTOR_FLOAT);
 }
 
 static void bj_free(void* context)
 {
   bj_pc_t* pc = context;
+  polymec_free(pc->res);
   bd_matrix_free(pc->D);
   polymec_free(pc);
 }
@@ -78,9 +126,12 @@ newton_pc_t* bj_newton_pc_new(void* context,
   pc->dtor = dtor;
   pc->num_block_rows = num_block_rows;
   pc->D = bd_matrix_new(num_block_rows, block_size);
+  pc->max_refinements = 0;
+  pc->res = polymec_malloc(sizeof(real_t) * bd_matrix_num_rows(pc->D));
 
   newton_pc_vtable vtable = {.compute_p = bj_compute_p,
                              .solve = bj_solve,
+                             .use_mixed_precision = bj_use_mixed_precision,
                              .dtor = bj_free};
   return newton_pc_new("Block Jacobi preconditioner", pc, vtable, side);
 
@@ -102,9 +153,12 @@ newton_pc_t* var_bj_newton_pc_new(void* context,
   pc->dtor = dtor;
   pc->num_block_rows = num_block_rows;
   pc->D = var_bd_matrix_new(num_block_rows, block_sizes);
+  pc->max_refinements = 0;
+  pc->res = polymec_malloc(sizeof(real_t) * bd_matrix_num_rows(pc->D));
 
   newton_pc_vtable vtable = {.compute_p = bj_compute_p,
                              .solve = bj_solve,
+                             .use_mixed_precision = bj_use_mixed_precision,
                              .dtor = bj_free};
   return newton_pc_new("Variable Block Jacobi preconditioner", pc, vtable, side);
 }
@@ -445,6 +499,8 @@ typedef struct
 {
   cpr_differencer_t* diff;
   bd_matrix_t* P;
+  int max_refinements;
+  real_t* res; // refinement residual
 } cpr_newton_pc_t;
 
 static void cpr_newton_pc_compute_p(void* context, 
@@ -453,6 +509,7 @@ static void cpr_newton_pc_compute_p(void* context,
 {
   cpr_newton_pc_t* pc = context;
   cpr_differencer_compute(pc->diff, alpha, beta, gamma, t, x, xdot, pc->P);
+  bd_matrix_factor(pc->P);
 }
 
 static bool cpr_newton_pc_solve(void* context, 
@@ -460,29 +517,23 @@ static bool cpr_newton_pc_solve(void* context,
                                 real_t* r, real_t* z, real_t* error_L2_norm)
 {
   cpr_newton_pc_t* pc = context;
-  bool solved = solve_bd_system(pc->P, r, z);
-  if (solved)
-  {
-    // Compute the L2 norm and measure against tolerance.
-    size_t N = bd_matrix_num_rows(pc->P);
-    real_t Pz[N];
-    bd_matrix_matvec(pc->P, z, Pz);
-    *error_L2_norm = 0.0;
-    polymec_suspend_fpe();
-    for (int i = 0; i < N; ++i)
-      *error_L2_norm += (Pz[i]-r[i])*(Pz[i]-r[i]);
-    *error_L2_norm = sqrt(*error_L2_norm);
-    polymec_restore_fpe();
-    if (*error_L2_norm >= tolerance)
-      solved = false;
-  }
-  return solved;
+  return solve_bd_with_refinement(pc->P, pc->max_refinements, tolerance, 
+                                  r, z, pc->res, error_L2_norm);
+}
+
+static void cpr_newton_pc_use_mixed_precision(void* context, 
+                                              int max_refinements)
+{
+  cpr_newton_pc_t* pc = context;
+  pc->max_refinements = max_refinements;
+  bd_matrix_set_factor_precision(pc->P, BD_MATRIX_FACTOR_FLOAT);
 }
 
 static void cpr_newton_pc_dtor(void* context)
 {
   cpr_newton_pc_t* pc = context;
   cpr_differencer_free(pc->diff);
+  polymec_free(pc->res);
   bd_matrix_free(pc->P);
   polymec_free(pc);
 }
@@ -510,8 +561,11 @@ static newton_pc_t* cpr_bj_newton_pc_from_function(MPI_Comm comm,
                                  num_remote_rows);
   adj_graph_free(my_sparsity);
   pc->P = P;
+  pc->max_refinements = 0;
+  pc->res = polymec_malloc(sizeof(real_t) * bd_matrix_num_rows(P));
   newton_pc_vtable vtable = {.compute_p = cpr_newton_pc_compute_p,
                              .solve = cpr_newton_pc_solve,
+                             .use_mixed_precision = cpr_newton_pc_use_mixed_precision,
                              .dtor = cpr_newton_pc_dtor};
   return newton_pc_new("Curtis-Powell-Reed block-Jacobi preconditioner", pc, vtable, side);
 }
@@ -606,3 +660,9 @@ newton_pc_t* var_dae_cpr_bj_newton_pc_new(MPI_Comm comm,
                                         num_remote_rows, P);
 }
                                         
+
+void bj_newton_pc_use_mixed_precision(newton_pc_t* bj_pc, 
+                                      int max_refinements)
+{
+  newton_pc_use_mixed_precision(bj_pc, max_refinements);
+}
@@ -96,6 +96,22 @@ newton_pc_t* var_dae_cpr_bj_newton_pc_new(MPI_Comm comm,
                                           size_t num_remote_block_rows,
                                           size_t* block_sizes);
 
+/// Instructs the given block Jacobi preconditioner (created by any of the 
+/// constructors above) to store the LU factors of its diagonal blocks in 
+/// single precision. An application with no refinement then reads half as 
+/// much matrix data as one in full precision. Each application performs up 
+/// to max_refinements steps of iterative refinement to recover the requested
+/// tolerance. Refinement computes residuals with the full precision blocks, 
+/// so it converges to the solution of the full precision system, but each 
+/// step reads those blocks as well as the factors, so traffic is only 
+/// reduced if solves seldom need refinement. The preconditioner matrix is 
+/// recomputed at the next setup. This is shorthand for 
+/// newton_pc_use_mixed_precision, and calling it on any other 
+/// preconditioner is an error.
+/// \relates newton_pc
+void bj_newton_pc_use_mixed_precision(newton_pc_t* bj_pc, 
+                                      int max_refinements);
+
 ///@}
 
 #endif
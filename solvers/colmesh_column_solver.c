@@ -0,0 +1,616 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "core/array_utils.h"
+#include "core/timer.h"
+#include "solvers/colmesh_column_solver.h"
+
+// Columns within a chunk are solved in batches of COLUMN_BATCH_SIZE. Within
+// a batch, the data for row r of the lth column lives at index
+// r*COLUMN_BATCH_SIZE + l, so the Thomas algorithm proceeds row by row with
+// unit-stride inner loops over the columns in the batch. Unused slots in the
+// last batch of a chunk are padded with trivial (identity) rows.
+#define COLUMN_BATCH_SIZE 8
+
+// Solver data for a single locally-stored chunk. Each chunk solves its
+// "local" rows (all rows except the top one, for every chunk but the
+// topmost), expressing the solution in each column as
+//
+//   x = y + p * v_below + q * v
+//
+// where v is the solution in the chunk's top row and v_below is that in the
+// top row of the chunk below. The top rows of the chunks along a column
+// form a reduced tridiagonal system that is solved across chunks.
+typedef struct
+{
+  int xy_index, z_index;
+  int num_columns, num_batches;
+
+  // Number of local rows, and batched local solutions (each of length
+  // num_batches * num_local_rows * COLUMN_BATCH_SIZE).
+  int num_local_rows;
+  real_t *y, *p, *q;
+
+  // Per-column coefficients of the reduced system, along with the
+  // coefficients of its forward elimination and its solution.
+  real_t *alpha, *beta, *gamma, *delta;
+  real_t *c_prime, *d_prime;
+  real_t *v, *v_below;
+
+  // Offset of the chunk's interface values within the solver's z_data.
+  int z_offset;
+} chunk_solver_t;
+
+// Each chunk's interface values are stored in four blocks of 3 values per
+// column: those it sends up, receives from below, sends down, and receives
+// from above.
+enum
+{
+  SEND_UP = 0,
+  FROM_BELOW = 1,
+  SEND_DOWN = 2,
+  FROM_ABOVE = 3
+};
+
+struct colmesh_column_solver_t
+{
+  colmesh_t* mesh;
+  int num_z_chunks, nz;
+
+  // Solver data for locally-stored chunks, in chunk traversal order.
+  int num_chunks;
+  chunk_solver_t* chunks;
+
+  // Interface values exchanged between vertically adjacent chunks. up[s]
+  // sends values from the chunks at z index s to the chunks above them, and
+  // down[s] sends values from the chunks at z index s+1 to the chunks below
+  // them, so each step of the pipelined solve communicates only across one
+  // interface.
+  real_t* z_data;
+  exchanger_t** up;
+  exchanger_t** down;
+};
+
+// Returns the 3 interface values in the given block for the given column of
+// a chunk.
+static inline real_t* z_values(colmesh_column_solver_t* solver,
+                               chunk_solver_t* c,
+                               int block, int column)
+{
+  return &solver->z_data[3 * (c->z_offset + block * c->num_columns + column)];
+}
+
+// Returns a newly-allocated array holding the rank of the process that owns
+// each chunk (xy_index, z_index), at index xy_index * num_z_chunks + z_index.
+static int64_t* chunk_owners(colmesh_t* mesh, int num_xy_chunks, int num_z_chunks)
+{
+  int num_all_chunks = num_xy_chunks * num_z_chunks;
+  int64_t* owners = polymec_calloc(MAX(num_all_chunks, 1), sizeof(int64_t));
+#if POLYMEC_HAVE_MPI
+  MPI_Comm comm = colmesh_comm(mesh);
+  int nproc;
+  MPI_Comm_size(comm, &nproc);
+  int num_my_chunks = colmesh_num_chunks(mesh);
+  int* my_chunks = polymec_malloc(sizeof(int) * MAX(num_my_chunks, 1));
+  int pos = 0, xy_index, z_index, i = 0;
+  colmesh_chunk_t* chunk;
+  while (colmesh_next_chunk(mesh, &pos, &xy_index, &z_index, &chunk))
+    my_chunks[i++] = xy_index * num_z_chunks + z_index;
+
+  int num_chunks_for_proc[nproc], proc_offsets[nproc+1];
+  MPI_Allgather(&num_my_chunks, 1, MPI_INT, num_chunks_for_proc, 1, MPI_INT, comm);
+  proc_offsets[0] = 0;
+  for (int p = 0; p < nproc; ++p)
+    proc_offsets[p+1] = proc_offsets[p] + num_chunks_for_proc[p];
+  ASSERT(proc_offsets[nproc] == num_all_chunks);
+  int* all_chunks = polymec_malloc(sizeof(int) * MAX(num_all_chunks, 1));
+  MPI_Allgatherv(my_chunks, num_my_chunks, MPI_INT, all_chunks,
+                 num_chunks_for_proc, proc_offsets, MPI_INT, comm);
+  for (int p = 0; p < nproc; ++p)
+    for (int j = proc_offsets[p]; j < proc_offsets[p+1]; ++j)
+      owners[all_chunks[j]] = (int64_t)p;
+  polymec_free(all_chunks);
+  polymec_free(my_chunks);
+#endif
+  return owners;
+}
+
+// Creates the exchangers that move interface values between vertically
+// adjacent chunks.
+static void create_z_exchangers(colmesh_column_solver_t* solver, int num_xy_chunks)
+{
+  int K = solver->num_z_chunks;
+  MPI_Comm comm = colmesh_comm(solver->mesh);
+  int64_t* owners = chunk_owners(solver->mesh, num_xy_chunks, K);
+
+  // Visit our chunks in order of increasing xy index, so that processes
+  // list the values they exchange with one another in the same order.
+  int* order = polymec_malloc(sizeof(int) * 2 * MAX(solver->num_chunks, 1));
+  for (int i = 0; i < solver->num_chunks; ++i)
+  {
+    order[2*i] = solver->chunks[i].xy_index;
+    order[2*i+1] = i;
+  }
+  int_pair_qsort(order, (size_t)solver->num_chunks);
+
+  solver->up = polymec_malloc(sizeof(exchanger_t*) * MAX(K-1, 1));
+  solver->down = polymec_malloc(sizeof(exchanger_t*) * MAX(K-1, 1));
+  for (int s = 0; s < K-1; ++s)
+  {
+    exchanger_proc_map_t* up_sends = exchanger_proc_map_new();
+    exchanger_proc_map_t* up_receives = exchanger_proc_map_new();
+    exchanger_proc_map_t* down_sends = exchanger_proc_map_new();
+    exchanger_proc_map_t* down_receives = exchanger_proc_map_new();
+    for (int j = 0; j < solver->num_chunks; ++j)
+    {
+      chunk_solver_t* c = &solver->chunks[order[2*j+1]];
+      if (c->z_index == s)
+      {
+        int p = (int)owners[c->xy_index * K + s + 1];
+        for (int col = 0; col < c->num_columns; ++col)
+        {
+          exchanger_proc_map_add_index(up_sends, p, c->z_offset + SEND_UP * c->num_columns + col);
+          exchanger_proc_map_add_index(down_receives, p, c->z_offset + FROM_ABOVE * c->num_columns + col);
+        }
+      }
+      else if (c->z_index == s + 1)
+      {
+        int p = (int)owners[c->xy_index * K + s];
+        for (int col = 0; col < c->num_columns; ++col)
+        {
+          exchanger_proc_map_add_index(up_receives, p, c->z_offset + FROM_BELOW * c->num_columns + col);
+          exchanger_proc_map_add_index(down_sends, p, c->z_offset + SEND_DOWN * c->num_columns + col);
+        }
+      }
+    }
+    solver->up[s] = exchanger_new(comm);
+    exchanger_set_sends(solver->up[s], up_sends);
+    exchanger_set_receives(solver->up[s], up_receives);
+    solver->down[s] = exchanger_new(comm);
+    exchanger_set_sends(solver->down[s], down_sends);
+    exchanger_set_receives(solver->down[s], down_receives);
+  }
+
+  polymec_free(order);
+  polymec_free(owners);
+}
+
+// Exchanges interface values across all interfaces at once with the given
+// exchangers.
+static void exchange_all_z(colmesh_column_solver_t* solver, exchanger_t** exchangers)
+{
+  int num_interfaces = solver->num_z_chunks - 1;
+  int tokens[MAX(num_interfaces, 1)];
+  for (int s = 0; s < num_interfaces; ++s)
+    tokens[s] = exchanger_start_exchange(exchangers[s], solver->z_data, 3, s, MPI_REAL_T);
+  for (int s = 0; s < num_interfaces; ++s)
+    exchanger_finish_exchange(exchangers[s], tokens[s]);
+}
+
+colmesh_column_solver_t* colmesh_column_solver_new(colmesh_t* mesh)
+{
+  colmesh_column_solver_t* solver = polymec_malloc(sizeof(colmesh_column_solver_t));
+  solver->mesh = mesh;
+  int num_xy_chunks;
+  colmesh_get_chunk_info(mesh, &num_xy_chunks, &solver->num_z_chunks, &solver->nz);
+
+  // Count our chunks.
+  solver->num_chunks = 0;
+  int pos = 0, xy_index, z_index;
+  colmesh_chunk_t* chunk;
+  while (colmesh_next_chunk(mesh, &pos, &xy_index, &z_index, &chunk))
+    ++solver->num_chunks;
+
+  // Allocate storage for each of them.
+  solver->chunks = polymec_malloc(sizeof(chunk_solver_t) * MAX(solver->num_chunks, 1));
+  pos = 0;
+  int i = 0, z_offset = 0;
+  while (colmesh_next_chunk(mesh, &pos, &xy_index, &z_index, &chunk))
+  {
+    chunk_solver_t* c = &solver->chunks[i];
+    c->xy_index = xy_index;
+    c->z_index = z_index;
+    c->num_columns = chunk->num_columns;
+    c->num_batches = (chunk->num_columns + COLUMN_BATCH_SIZE - 1) / COLUMN_BATCH_SIZE;
+    bool top = (z_index == solver->num_z_chunks-1);
+    c->num_local_rows = (top) ? solver->nz : solver->nz - 1;
+    size_t local_size = (size_t)(c->num_batches * c->num_local_rows * COLUMN_BATCH_SIZE);
+    c->y = polymec_malloc(sizeof(real_t) * MAX(local_size, 1));
+    c->p = polymec_malloc(sizeof(real_t) * MAX(local_size, 1));
+    c->q = polymec_malloc(sizeof(real_t) * MAX(local_size, 1));
+    size_t col_size = (size_t)MAX(c->num_columns, 1);
+    c->alpha = polymec_malloc(sizeof(real_t) * col_size);
+    c->beta = polymec_malloc(sizeof(real_t) * col_size);
+    c->gamma = polymec_malloc(sizeof(real_t) * col_size);
+    c->delta = polymec_malloc(sizeof(real_t) * col_size);
+    c->c_prime = polymec_malloc(sizeof(real_t) * col_size);
+    c->d_prime = polymec_malloc(sizeof(real_t) * col_size);
+    c->v = polymec_calloc(col_size, sizeof(real_t));
+    c->v_below = polymec_calloc(col_size, sizeof(real_t));
+    c->z_offset = z_offset;
+    z_offset += 4 * c->num_columns;
+    ++i;
+  }
+
+  // Set up the exchange of interface values.
+  solver->z_data = polymec_calloc(3 * MAX(z_offset, 1), sizeof(real_t));
+  create_z_exchangers(solver, num_xy_chunks);
+
+  return solver;
+}
+
+void colmesh_column_solver_free(colmesh_column_solver_t* solver)
+{
+  for (int i = 0; i < solver->num_chunks; ++i)
+  {
+    chunk_solver_t* c = &solver->chunks[i];
+    polymec_free(c->y);
+    polymec_free(c->p);
+    polymec_free(c->q);
+    polymec_free(c->alpha);
+    polymec_free(c->beta);
+    polymec_free(c->gamma);
+    polymec_free(c->delta);
+    polymec_free(c->c_prime);
+    polymec_free(c->d_prime);
+    polymec_free(c->v);
+    polymec_free(c->v_below);
+  }
+  polymec_free(solver->chunks);
+  for (int s = 0; s < solver->num_z_chunks-1; ++s)
+  {
+    release_ref(solver->up[s]);
+    release_ref(solver->down[s]);
+  }
+  polymec_free(solver->up);
+  polymec_free(solver->down);
+  polymec_free(solver->z_data);
+  polymec_free(solver);
+}
+
+// Solves the local rows of a batch of columns with the Thomas algorithm,
+// applying a single elimination to three right hand sides: d (giving y),
+// -a[0] * e_0 (giving p), and -c[m-1] * e_{m-1} (giving q). The coefficients
+// a[0] and c[m-1] couple the local rows to the interface values below and
+// above, and do not enter the local matrix. The array a is overwritten.
+static void batched_thomas_solve(int m, real_t* a, real_t* b, real_t* c,
+                                 real_t* d, real_t* y, real_t* p, real_t* q)
+{
+  const int B = COLUMN_BATCH_SIZE;
+  real_t* c_prime = a; // a is only needed once per row, so we reuse it.
+
+  // Forward elimination.
+  for (int l = 0; l < B; ++l)
+  {
+    real_t inv = 1.0 / b[l];
+    real_t a0 = a[l];
+    c_prime[l] = c[l] * inv;
+    y[l] = d[l] * inv;
+    p[l] = -a0 * inv;
+    q[l] = (m == 1) ? -c[l] * inv : 0.0;
+  }
+  for (int r = 1; r < m; ++r)
+  {
+    real_t q_rhs = (r == m-1) ? 1.0 : 0.0;
+    for (int l = 0; l < B; ++l)
+    {
+      int i = r*B+l, i1 = (r-1)*B+l;
+      real_t ar = a[i];
+      real_t inv = 1.0 / (b[i] - ar * c_prime[i1]);
+      c_prime[i] = c[i] * inv;
+      y[i] = (d[i] - ar * y[i1]) * inv;
+      p[i] = -ar * p[i1] * inv;
+      q[i] = (-q_rhs * c[i] - ar * q[i1]) * inv;
+    }
+  }
+
+  // Back substitution.
+  for (int r = m-2; r >= 0; --r)
+  {
+    for (int l = 0; l < B; ++l)
+    {
+      int i = r*B+l, i1 = (r+1)*B+l;
+      y[i] -= c_prime[i] * y[i1];
+      p[i] -= c_prime[i] * p[i1];
+      q[i] -= c_prime[i] * q[i1];
+    }
+  }
+}
+
+// Solves the local rows of all columns in the given chunk.
+static void solve_local_rows(colmesh_column_solver_t* solver,
+                             chunk_solver_t* c,
+                             colmesh_chunk_data_t* lower_data,
+                             colmesh_chunk_data_t* diag_data,
+                             colmesh_chunk_data_t* upper_data,
+                             colmesh_chunk_data_t* rhs_data)
+{
+  int m = c->num_local_rows;
+  if (m == 0) return;
+
+  DECLARE_COLMESH_CELL_ARRAY(lower, lower_data);
+  DECLARE_COLMESH_CELL_ARRAY(diag, diag_data);
+  DECLARE_COLMESH_CELL_ARRAY(upper, upper_data);
+  DECLARE_COLMESH_CELL_ARRAY(rhs, rhs_data);
+  bool bottom = (c->z_index == 0);
+  bool top = (c->z_index == solver->num_z_chunks-1);
+  const int B = COLUMN_BATCH_SIZE;
+
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (int batch = 0; batch < c->num_batches; ++batch)
+  {
+    // Gather the coefficients for this batch into interleaved storage.
+    real_t* work = polymec_malloc(sizeof(real_t) * 4 * m * B);
+    real_t *a = work, *b = &work[m*B], *cc = &work[2*m*B], *d = &work[3*m*B];
+    int col1 = batch * B;
+    int nb = MIN(B, c->num_columns - col1);
+    for (int r = 0; r < m; ++r)
+    {
+      int z = r+1;
+      for (int l = 0; l < nb; ++l)
+      {
+        int col = col1 + l;
+        a[r*B+l] = lower[col][z][0];
+        b[r*B+l] = diag[col][z][0];
+        cc[r*B+l] = upper[col][z][0];
+        d[r*B+l] = rhs[col][z][0];
+      }
+      for (int l = nb; l < B; ++l)
+      {
+        a[r*B+l] = 0.0;
+        b[r*B+l] = 1.0;
+        cc[r*B+l] = 0.0;
+        d[r*B+l] = 0.0;
+      }
+    }
+
+    // The ends of each column are decoupled from their (nonexistent)
+    // neighbors.
+    if (bottom)
+    {
+      for (int l = 0; l < B; ++l)
+        a[l] = 0.0;
+    }
+    if (top)
+    {
+      for (int l = 0; l < B; ++l)
+        cc[(m-1)*B+l] = 0.0;
+    }
+
+    size_t offset = (size_t)(batch * m * B);
+    batched_thomas_solve(m, a, b, cc, d, &c->y[offset], &c->p[offset], &c->q[offset]);
+    polymec_free(work);
+  }
+}
+
+// Retrieves the coefficients (y, p, q) expressing the solution in the given
+// (1-based) row of a column in the given chunk in terms of the interface
+// values below and above. Rows that are themselves interface rows are
+// handled consistently with this representation.
+static inline void get_row_coeffs(colmesh_column_solver_t* solver,
+                                  chunk_solver_t* c,
+                                  int column, int z,
+                                  real_t* y, real_t* p, real_t* q)
+{
+  if (z == solver->nz + 1) // the chunk's top row
+  {
+    *y = 0.0; *p = 0.0; *q = 1.0;
+  }
+  else if (z == 0) // the top row of the chunk below
+  {
+    *y = 0.0; *p = 1.0; *q = 0.0;
+  }
+  else
+  {
+    int batch = column / COLUMN_BATCH_SIZE, l = column % COLUMN_BATCH_SIZE;
+    size_t i = (size_t)((batch * c->num_local_rows + z-1) * COLUMN_BATCH_SIZE + l);
+    *y = c->y[i]; *p = c->p[i]; *q = c->q[i];
+  }
+}
+
+// Maps a 1-based row index within the given chunk to the argument used by
+// get_row_coeffs: the top row of a non-top chunk is an interface row, as is
+// row 0.
+static inline int local_row(colmesh_column_solver_t* solver,
+                            chunk_solver_t* c, int z)
+{
+  bool top = (c->z_index == solver->num_z_chunks-1);
+  return (!top && (z == solver->nz)) ? solver->nz + 1 : z;
+}
+
+void colmesh_column_solver_solve(colmesh_column_solver_t* solver,
+                                 colmesh_field_t* lower,
+                                 colmesh_field_t* diag,
+                                 colmesh_field_t* upper,
+                                 colmesh_field_t* rhs,
+                                 colmesh_field_t* solution)
+{
+  START_FUNCTION_TIMER();
+  ASSERT(colmesh_field_mesh(lower) == solver->mesh);
+  ASSERT(colmesh_field_mesh(diag) == solver->mesh);
+  ASSERT(colmesh_field_mesh(upper) == solver->mesh);
+  ASSERT(colmesh_field_mesh(rhs) == solver->mesh);
+  ASSERT(colmesh_field_mesh(solution) == solver->mesh);
+  ASSERT(colmesh_field_centering(lower) == COLMESH_CELL);
+  ASSERT(colmesh_field_centering(diag) == COLMESH_CELL);
+  ASSERT(colmesh_field_centering(upper) == COLMESH_CELL);
+  ASSERT(colmesh_field_centering(rhs) == COLMESH_CELL);
+  ASSERT(colmesh_field_centering(solution) == COLMESH_CELL);
+  ASSERT(colmesh_field_num_components(lower) == 1);
+  ASSERT(colmesh_field_num_components(diag) == 1);
+  ASSERT(colmesh_field_num_components(upper) == 1);
+  ASSERT(colmesh_field_num_components(rhs) == 1);
+  ASSERT(colmesh_field_num_components(solution) == 1);
+
+  int K = solver->num_z_chunks, nz = solver->nz;
+
+  // Solve the local rows within each chunk.
+  for (int i = 0; i < solver->num_chunks; ++i)
+  {
+    chunk_solver_t* c = &solver->chunks[i];
+    solve_local_rows(solver, c,
+                     colmesh_field_chunk_data(lower, c->xy_index, c->z_index),
+                     colmesh_field_chunk_data(diag, c->xy_index, c->z_index),
+                     colmesh_field_chunk_data(upper, c->xy_index, c->z_index),
+                     colmesh_field_chunk_data(rhs, c->xy_index, c->z_index));
+  }
+
+  if (K > 1)
+  {
+    // Send the coefficients of each chunk's first row to the chunk below
+    // and assemble the reduced system.
+    for (int i = 0; i < solver->num_chunks; ++i)
+    {
+      chunk_solver_t* c = &solver->chunks[i];
+      if (c->z_index == 0) continue;
+      int z = local_row(solver, c, 1);
+      for (int col = 0; col < c->num_columns; ++col)
+      {
+        real_t* w = z_values(solver, c, SEND_DOWN, col);
+        get_row_coeffs(solver, c, col, z, &w[0], &w[1], &w[2]);
+      }
+    }
+    exchange_all_z(solver, solver->down);
+    for (int i = 0; i < solver->num_chunks; ++i)
+    {
+      chunk_solver_t* c = &solver->chunks[i];
+      if (c->z_index == K-1) continue;
+      colmesh_chunk_data_t* a_data = colmesh_field_chunk_data(lower, c->xy_index, c->z_index);
+      colmesh_chunk_data_t* b_data = colmesh_field_chunk_data(diag, c->xy_index, c->z_index);
+      colmesh_chunk_data_t* c_data = colmesh_field_chunk_data(upper, c->xy_index, c->z_index);
+      colmesh_chunk_data_t* d_data = colmesh_field_chunk_data(rhs, c->xy_index, c->z_index);
+      DECLARE_COLMESH_CELL_ARRAY(a, a_data);
+      DECLARE_COLMESH_CELL_ARRAY(b, b_data);
+      DECLARE_COLMESH_CELL_ARRAY(cc, c_data);
+      DECLARE_COLMESH_CELL_ARRAY(d, d_data);
+      int z = local_row(solver, c, nz-1);
+      bool decoupled_below = ((c->z_index == 0) && (nz == 1));
+      for (int col = 0; col < c->num_columns; ++col)
+      {
+        real_t y, p, q;
+        get_row_coeffs(solver, c, col, z, &y, &p, &q);
+        real_t an = (decoupled_below) ? 0.0 : a[col][nz][0];
+        real_t bn = b[col][nz][0], cn = cc[col][nz][0], dn = d[col][nz][0];
+        real_t* w = z_values(solver, c, FROM_ABOVE, col);
+        real_t y1 = w[0], p1 = w[1], q1 = w[2];
+        c->alpha[col] = an * p;
+        c->beta[col] = bn + an * q + cn * p1;
+        c->gamma[col] = cn * q1;
+        c->delta[col] = dn - an * y - cn * y1;
+      }
+    }
+
+    // Forward elimination of the reduced system, pipelined upward through
+    // the chunks.
+    for (int i = 0; i < solver->num_chunks; ++i)
+    {
+      chunk_solver_t* c = &solver->chunks[i];
+      if (c->z_index != 0) continue;
+      for (int col = 0; col < c->num_columns; ++col)
+      {
+        c->c_prime[col] = c->gamma[col] / c->beta[col];
+        c->d_prime[col] = c->delta[col] / c->beta[col];
+      }
+    }
+    for (int s = 1; s < K-1; ++s)
+    {
+      for (int i = 0; i < solver->num_chunks; ++i)
+      {
+        chunk_solver_t* c = &solver->chunks[i];
+        if (c->z_index != s-1) continue;
+        for (int col = 0; col < c->num_columns; ++col)
+        {
+          real_t* w = z_values(solver, c, SEND_UP, col);
+          w[0] = c->c_prime[col];
+          w[1] = c->d_prime[col];
+        }
+      }
+      exchanger_exchange(solver->up[s-1], solver->z_data, 3, 0, MPI_REAL_T);
+      for (int i = 0; i < solver->num_chunks; ++i)
+      {
+        chunk_solver_t* c = &solver->chunks[i];
+        if (c->z_index != s) continue;
+        for (int col = 0; col < c->num_columns; ++col)
+        {
+          real_t* w = z_values(solver, c, FROM_BELOW, col);
+          real_t cp_below = w[0], dp_below = w[1];
+          real_t inv = 1.0 / (c->beta[col] - c->alpha[col] * cp_below);
+          c->c_prime[col] = c->gamma[col] * inv;
+          c->d_prime[col] = (c->delta[col] - c->alpha[col] * dp_below) * inv;
+        }
+      }
+    }
+
+    // Back substitution, pipelined downward.
+    for (int i = 0; i < solver->num_chunks; ++i)
+    {
+      chunk_solver_t* c = &solver->chunks[i];
+      if (c->z_index != K-2) continue;
+      for (int col = 0; col < c->num_columns; ++col)
+        c->v[col] = c->d_prime[col];
+    }
+    for (int s = K-3; s >= 0; --s)
+    {
+      for (int i = 0; i < solver->num_chunks; ++i)
+      {
+        chunk_solver_t* c = &solver->chunks[i];
+        if (c->z_index != s+1) continue;
+        for (int col = 0; col < c->num_columns; ++col)
+          z_values(solver, c, SEND_DOWN, col)[0] = c->v[col];
+      }
+      exchanger_exchange(solver->down[s], solver->z_data, 3, 0, MPI_REAL_T);
+      for (int i = 0; i < solver->num_chunks; ++i)
+      {
+        chunk_solver_t* c = &solver->chunks[i];
+        if (c->z_index != s) continue;
+        for (int col = 0; col < c->num_columns; ++col)
+          c->v[col] = c->d_prime[col] - c->c_prime[col] * z_values(solver, c, FROM_ABOVE, col)[0];
+      }
+    }
+
+    // Send each chunk's interface values to the chunk above.
+    for (int i = 0; i < solver->num_chunks; ++i)
+    {
+      chunk_solver_t* c = &solver->chunks[i];
+      if (c->z_index == K-1) continue;
+      for (int col = 0; col < c->num_columns; ++col)
+        z_values(solver, c, SEND_UP, col)[0] = c->v[col];
+    }
+    exchange_all_z(solver, solver->up);
+    for (int i = 0; i < solver->num_chunks; ++i)
+    {
+      chunk_solver_t* c = &solver->chunks[i];
+      if (c->z_index == 0) continue;
+      for (int col = 0; col < c->num_columns; ++col)
+        c->v_below[col] = z_values(solver, c, FROM_BELOW, col)[0];
+    }
+  }
+
+  // Assemble the solution from the local solutions and interface values.
+  for (int i = 0; i < solver->num_chunks; ++i)
+  {
+    chunk_solver_t* c = &solver->chunks[i];
+    colmesh_chunk_data_t* x_data = colmesh_field_chunk_data(solution, c->xy_index, c->z_index);
+    DECLARE_COLMESH_CELL_ARRAY(x, x_data);
+#if POLYMEC_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (int col = 0; col < c->num_columns; ++col)
+    {
+      for (int z = 1; z <= nz; ++z)
+      {
+        real_t y, p, q;
+        get_row_coeffs(solver, c, col, local_row(solver, c, z), &y, &p, &q);
+        x[col][z][0] = y + p * c->v_below[col] + q * c->v[col];
+      }
+    }
+  }
+  STOP_FUNCTION_TIMER();
+}
+
@@ -0,0 +1,68 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef POLYMEC_COLMESH_COLUMN_SOLVER_H
+#define POLYMEC_COLMESH_COLUMN_SOLVER_H
+
+#include "geometry/colmesh_field.h"
+
+/// \addtogroup solvers solvers
+///@{
+
+/// \class colmesh_column_solver
+/// This type solves independent tridiagonal linear systems along the columns
+/// of a colmesh, such as those that arise from implicit treatments of
+/// vertical diffusion. Each system couples the cells of a column (which may
+/// span several chunks, and several processes) with their vertical neighbors.
+/// The columns of each chunk are solved together in batches whose data are
+/// interleaved so that the Thomas algorithm vectorizes across columns, and
+/// batches are distributed across OpenMP threads (when available).
+typedef struct colmesh_column_solver_t colmesh_column_solver_t;
+
+/// Creates a column solver for the given colmesh.
+/// \param [in] mesh The colmesh whose columns are solved. This mesh must
+///                  outlive the solver.
+/// \memberof colmesh_column_solver
+colmesh_column_solver_t* colmesh_column_solver_new(colmesh_t* mesh);
+
+/// Destroys the given column solver.
+/// \memberof colmesh_column_solver
+void colmesh_column_solver_free(colmesh_column_solver_t* solver);
+
+/// Solves the tridiagonal system
+///
+/// `lower[z] * x[z-1] + diag[z] * x[z] + upper[z] * x[z+1] = rhs[z]`
+///
+/// in every column of the solver's mesh, storing x in the given solution
+/// field. Here, z runs over all cells in a column, from the bottom of the
+/// mesh to its top. The lower coefficient of a column's bottom cell and the
+/// upper coefficient of its top cell are ignored, so columns are not
+/// periodic even if the mesh is. No pivoting is performed, so the systems
+/// should be diagonally dominant. Across chunks, the systems are solved by
+/// substructuring: each chunk solves its own part of each column, and the
+/// values at the chunk's top cells are found from a reduced system that is
+/// solved by exchanging only interface values between vertically adjacent
+/// chunks.
+/// \param [in] lower A single-component cell field holding lower diagonals.
+/// \param [in] diag A single-component cell field holding main diagonals.
+/// \param [in] upper A single-component cell field holding upper diagonals.
+/// \param [in] rhs A single-component cell field holding right hand sides.
+/// \param [out] solution A single-component cell field that stores the
+///                       solution. This can be the same field as rhs.
+/// \memberof colmesh_column_solver
+/// \collective Collective on the mesh's communicator.
+void colmesh_column_solver_solve(colmesh_column_solver_t* solver,
+                                 colmesh_field_t* lower,
+                                 colmesh_field_t* diag,
+                                 colmesh_field_t* upper,
+                                 colmesh_field_t* rhs,
+                                 colmesh_field_t* solution);
+
+///@}
+
+#endif
+
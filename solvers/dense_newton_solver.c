@@ -7,6 +7,7 @@
 
 #include "core/linear_algebra.h"
 #include "core/norms.h"
+#include "solvers/bd_matrix.h"
 #include "solvers/dense_newton_solver.h"
 #include "nvector/nvector_serial.h"
 #include "sunmatrix/sunmatrix_dense.h"
@@ -180,6 +181,283 @@ bool dense_newton_solver_solve_scaled(dense_newton_solver_t* solver, real_t* X,
   return false;
 }
 
+//------------------------------------------------------------------------
+//                      Batched dense Newton solver
+//------------------------------------------------------------------------
+
+// The batched solver doesn't use KINSOL: it performs plain Newton 
+// iterations on all of its systems at once so that every operation 
+// (function evaluations, Jacobians, LU factorizations and solves) runs 
+// across systems with unit stride.
+struct batched_dense_newton_solver_t 
+{
+  int dim, num_systems;
+  void* context;
+  batched_dense_newton_system_func sys_func;
+  batched_dense_newton_jacobian_func sys_jac;
+  void (*dtor)(void*);
+
+  real_t norm_tol, step_tol;
+  int max_iters;
+
+  // Work space (SoA).
+  real_t *F, *J, *dX, *X_pert, *F_pert, *work;
+  int* pivots;
+  bool *conv, *nonsingular;
+
+  // Indices of the systems that have not yet converged. Jacobians, 
+  // factorizations and solves are computed only for these systems.
+  int num_active;
+  int* active;
+};
+
+batched_dense_newton_solver_t* batched_dense_newton_solver_new(int dimension,
+                                                               int num_systems,
+                                                               void* context,
+                                                               batched_dense_newton_system_func system_func,
+                                                               batched_dense_newton_jacobian_func jacobian_func,
+                                                               void (*context_dtor)(void*))
+{
+  ASSERT(dimension > 0);
+  ASSERT(num_systems > 0);
+  ASSERT(system_func != NULL);
+
+  batched_dense_newton_solver_t* solver = polymec_malloc(sizeof(batched_dense_newton_solver_t));
+  solver->dim = dimension;
+  solver->num_systems = num_systems;
+  solver->context = context;
+  solver->sys_func = system_func;
+  solver->sys_jac = jacobian_func;
+  solver->dtor = context_dtor;
+  solver->norm_tol = 1e-8;
+  solver->step_tol = 1e-10;
+  solver->max_iters = 200;
+
+  size_t n = (size_t)dimension, B = (size_t)num_systems;
+  solver->F = polymec_malloc(sizeof(real_t) * n * B);
+  solver->J = polymec_malloc(sizeof(real_t) * n * n * B);
+  solver->dX = polymec_malloc(sizeof(real_t) * n * B);
+  if (jacobian_func == NULL)
+  {
+    solver->X_pert = polymec_malloc(sizeof(real_t) * n * B);
+    solver->F_pert = polymec_malloc(sizeof(real_t) * n * B);
+  }
+  else
+  {
+    solver->X_pert = NULL;
+    solver->F_pert = NULL;
+  }
+  solver->work = polymec_malloc(sizeof(real_t) * B);
+  solver->pivots = polymec_malloc(sizeof(int) * n * B);
+  solver->conv = polymec_malloc(sizeof(bool) * B);
+  solver->nonsingular = polymec_malloc(sizeof(bool) * B);
+  solver->num_active = 0;
+  solver->active = polymec_malloc(sizeof(int) * B);
+  return solver;
+}
+
+void batched_dense_newton_solver_free(batched_dense_newton_solver_t* solver)
+{
+  if ((solver->context != NULL) && (solver->dtor != NULL))
+    solver->dtor(solver->context);
+  polymec_free(solver->active);
+  polymec_free(solver->nonsingular);
+  polymec_free(solver->conv);
+  polymec_free(solver->pivots);
+  polymec_free(solver->work);
+  if (solver->F_pert != NULL)
+  {
+    polymec_free(solver->F_pert);
+    polymec_free(solver->X_pert);
+  }
+  polymec_free(solver->dX);
+  polymec_free(solver->J);
+  polymec_free(solver->F);
+  polymec_free(solver);
+}
+
+int batched_dense_newton_solver_dimension(batched_dense_newton_solver_t* solver)
+{
+  return solver->dim;
+}
+
+int batched_dense_newton_solver_num_systems(batched_dense_newton_solver_t* solver)
+{
+  return solver->num_systems;
+}
+
+void batched_dense_newton_solver_set_tolerances(batched_dense_newton_solver_t* solver, 
+                                                real_t norm_tolerance, 
+                                                real_t step_tolerance)
+{
+  ASSERT(norm_tolerance > 0.0);
+  ASSERT(step_tolerance > 0.0);
+  solver->norm_tol = norm_tolerance;
+  solver->step_tol = step_tolerance;
+}
+
+void batched_dense_newton_solver_set_max_iterations(batched_dense_newton_solver_t* solver, 
+                                                    int max_iterations)
+{
+  ASSERT(max_iterations > 0);
+  solver->max_iters = max_iterations;
+}
+
+// Approximates the Jacobians of the active (unconverged) systems at X by 
+// finite differences, perturbing one component of every active system at a 
+// time. The Jacobians are packed: the (r, c) entry for the ath active system
+// lives at J[(c*n+r)*num_active + a]. The system function evaluates all 
+// systems, so converged systems are still evaluated (unperturbed), but they 
+// are not differenced, factored, or solved.
+static int batched_fd_jacobian(batched_dense_newton_solver_t* solver, real_t* X)
+{
+  int n = solver->dim, B = solver->num_systems, nA = solver->num_active;
+  int* active = solver->active;
+  real_t* eps = solver->work;
+  memcpy(solver->X_pert, X, sizeof(real_t) * n * B);
+  for (int c = 0; c < n; ++c)
+  {
+    real_t* Xc = &solver->X_pert[c*B];
+    for (int a = 0; a < nA; ++a)
+    {
+      int s = active[a];
+      eps[a] = sqrt(REAL_EPSILON) * MAX(1.0, ABS(Xc[s]));
+      Xc[s] += eps[a];
+    }
+    int status = solver->sys_func(solver->context, B, solver->X_pert, solver->F_pert);
+    if (status != 0) 
+      return status;
+    for (int r = 0; r < n; ++r)
+    {
+      real_t* Jrc = &solver->J[(c*n+r)*nA];
+      real_t* Fr = &solver->F[r*B];
+      real_t* Fr_pert = &solver->F_pert[r*B];
+      for (int a = 0; a < nA; ++a)
+        Jrc[a] = (Fr_pert[active[a]] - Fr[active[a]]) / eps[a];
+    }
+    for (int a = 0; a < nA; ++a)
+      Xc[active[a]] = X[c*B+active[a]];
+  }
+  return 0;
+}
+
+// Packs the Jacobians of the active systems (computed for all systems by a 
+// user-supplied Jacobian function) in place, so that they have the same 
+// layout as those computed by batched_fd_jacobian. Each entry moves to a 
+// position no later than its own, so this is safe to do in place.
+static void pack_active_jacobians(batched_dense_newton_solver_t* solver)
+{
+  int n = solver->dim, B = solver->num_systems, nA = solver->num_active;
+  if (nA == B) return;
+  int* active = solver->active;
+  real_t* J = solver->J;
+  for (int i = 0; i < n*n; ++i)
+  {
+    for (int a = 0; a < nA; ++a)
+      J[i*nA+a] = J[i*B+active[a]];
+  }
+}
+
+bool batched_dense_newton_solver_solve(batched_dense_newton_solver_t* solver, 
+                                       real_t* X, 
+                                       bool* converged,
+                                       int* num_iterations)
+{
+  int n = solver->dim, B = solver->num_systems;
+  bool* conv = solver->conv;
+  for (int s = 0; s < B; ++s)
+    conv[s] = false;
+
+  // Suspend the currently active floating point exceptions for now.
+  polymec_suspend_fpe();
+
+  bool failed = false;
+  int iter = 0;
+  while (true)
+  {
+    // Evaluate the systems and check their norms.
+    if (solver->sys_func(solver->context, B, X, solver->F) != 0)
+    {
+      failed = true;
+      break;
+    }
+    int* active = solver->active;
+    int nA = 0;
+    for (int s = 0; s < B; ++s)
+    {
+      if (!conv[s])
+      {
+        real_t F_norm = 0.0;
+        for (int i = 0; i < n; ++i)
+          F_norm = MAX(F_norm, ABS(solver->F[i*B+s]));
+        if (F_norm < solver->norm_tol)
+          conv[s] = true;
+        else
+          active[nA++] = s;
+      }
+    }
+    solver->num_active = nA;
+    if ((nA == 0) || (iter == solver->max_iters))
+      break;
+
+    // Compute and factor the Jacobians of the unconverged systems.
+    int status;
+    if (solver->sys_jac != NULL)
+    {
+      status = solver->sys_jac(solver->context, B, X, solver->F, solver->J);
+      if (status == 0)
+        pack_active_jacobians(solver);
+    }
+    else
+      status = batched_fd_jacobian(solver, X);
+    if (status != 0)
+    {
+      failed = true;
+      break;
+    }
+    interleaved_lu_factor(n, nA, solver->J, solver->pivots, solver->nonsingular);
+
+    // Solve J * dX = -F and update the unconverged systems.
+    for (int i = 0; i < n; ++i)
+    {
+      for (int a = 0; a < nA; ++a)
+        solver->dX[i*nA+a] = -solver->F[i*B+active[a]];
+    }
+    interleaved_lu_solve(n, nA, solver->J, solver->pivots, solver->dX);
+    for (int a = 0; a < nA; ++a)
+    {
+      if (solver->nonsingular[a])
+      {
+        int s = active[a];
+        real_t step_norm = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+          X[i*B+s] += solver->dX[i*nA+a];
+          step_norm = MAX(step_norm, ABS(solver->dX[i*nA+a]) / (1.0 + ABS(X[i*B+s])));
+        }
+        if (step_norm < solver->step_tol)
+          conv[s] = true;
+      }
+    }
+    ++iter;
+  }
+
+  // Reinstate the floating point exceptions.
+  polymec_restore_fpe();
+
+  *num_iterations = iter;
+  bool all_converged = !failed;
+  for (int s = 0; s < B; ++s)
+  {
+    if (failed) 
+      conv[s] = false;
+    all_converged = (all_converged && conv[s]);
+  }
+  if (converged != NULL)
+    memcpy(converged, conv, sizeof(bool) * B);
+  return all_converged;
+}
+
 static bool in_range(real_t x, real_t a, real_t b)
 {
   return ((MIN(a, b) <= x) && (x <= MAX(a, b)));
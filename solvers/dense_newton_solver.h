@@ -95,6 +95,78 @@ bool dense_newton_solver_solve(dense_newton_solver_t* solver, real_t* X, int* nu
 /// \memberof dense_newton_solver
 bool dense_newton_solver_solve_scaled(dense_newton_solver_t* solver, real_t* X, real_t* x_scale, real_t* F_scale, int* num_iterations);
 
+/// \class batched_dense_newton_solver
+/// This class solves many independent (dense) systems of nonlinear equations 
+/// of the same dimension simultaneously using Newton's method. The systems 
+/// are stored in structure-of-arrays (SoA) form: the ith component of the 
+/// sth system lives at X[i*num_systems + s], so that operations on the 
+/// systems vectorize across systems. Each system converges independently.
+typedef struct batched_dense_newton_solver_t batched_dense_newton_solver_t;
+
+/// This function evaluates F(X) for all num_systems systems, which are 
+/// stored in SoA form. It should return 0 on success and nonzero on failure.
+/// \relates batched_dense_newton_solver
+typedef int (*batched_dense_newton_system_func)(void* context, int num_systems, 
+                                                real_t* X, real_t* F);
+
+/// This function evaluates the Jacobians of all num_systems systems at X 
+/// (where the functions take on the values F). The (r, c) entry of the 
+/// Jacobian of the sth system (that is, dF[r]/dX[c]) lives at 
+/// J[(c*N + r)*num_systems + s], where N is the dimension of the systems.
+/// It should return 0 on success and nonzero on failure.
+/// \relates batched_dense_newton_solver
+typedef int (*batched_dense_newton_jacobian_func)(void* context, int num_systems, 
+                                                  real_t* X, real_t* F, real_t* J);
+
+/// Creates a new batched dense Newton solver for num_systems systems of 
+/// the given dimension, represented by the batched function F(X) = 0. If 
+/// jacobian_func is NULL, the Jacobians are approximated by finite 
+/// differences, using dimension additional evaluations of system_func.
+/// \memberof batched_dense_newton_solver
+batched_dense_newton_solver_t* batched_dense_newton_solver_new(int dimension,
+                                                               int num_systems,
+                                                               void* context,
+                                                               batched_dense_newton_system_func system_func,
+                                                               batched_dense_newton_jacobian_func jacobian_func,
+                                                               void (*context_dtor)(void*));
+
+/// Destroys the given batched dense Newton solver.
+/// \memberof batched_dense_newton_solver
+void batched_dense_newton_solver_free(batched_dense_newton_solver_t* solver);
+
+/// Returns the dimension of each system solved by the batched Newton solver.
+/// \memberof batched_dense_newton_solver
+int batched_dense_newton_solver_dimension(batched_dense_newton_solver_t* solver);
+
+/// Returns the number of systems solved by the batched Newton solver.
+/// \memberof batched_dense_newton_solver
+int batched_dense_newton_solver_num_systems(batched_dense_newton_solver_t* solver);
+
+/// Sets the tolerances for the (max) norm of each system function 
+/// (norm_tolerance) and for each Newton step (step_tolerance), measured 
+/// relative to 1 + |X|. A system has converged when either is met.
+/// \memberof batched_dense_newton_solver
+void batched_dense_newton_solver_set_tolerances(batched_dense_newton_solver_t* solver, 
+                                                real_t norm_tolerance, 
+                                                real_t step_tolerance);
+
+/// Sets the maximum number of Newton iterations for the solver.
+/// \memberof batched_dense_newton_solver
+void batched_dense_newton_solver_set_max_iterations(batched_dense_newton_solver_t* solver, 
+                                                    int max_iterations);
+
+/// Given initial guesses X (in SoA form), solves all the systems, stopping 
+/// when all have converged or the maximum number of iterations is reached.
+/// Systems that have converged are not updated further. If converged is 
+/// non-NULL, converged[s] stores whether the sth system converged. 
+/// num_iterations stores the number of Newton iterations taken. Returns 
+/// true if all systems converged, false if not.
+/// \memberof batched_dense_newton_solver
+bool batched_dense_newton_solver_solve(batched_dense_newton_solver_t* solver, 
+                                       real_t* X, 
+                                       bool* converged,
+                                       int* num_iterations);
+
 ///@}
 
 #endif
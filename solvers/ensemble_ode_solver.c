@@ -0,0 +1,347 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "core/timer.h"
+#include "solvers/dense_newton_solver.h"
+#include "solvers/ensemble_ode_solver.h"
+
+// We use Alexander's two-stage, L-stable, stiffly-accurate SDIRK method:
+//   Y1 = U + h*gamma*f(t + gamma*h, Y1)
+//   Y2 = U + h*(1-gamma)*f(t + gamma*h, Y1) + h*gamma*f(t + h, Y2)
+//   U(t + h) = Y2
+// with gamma = 1 - 1/sqrt(2). The embedded first-order solution
+// U + h*f(t + gamma*h, Y1) gives the error estimate h*gamma*(k2 - k1).
+static const real_t sdirk_gamma = 0.29289321881345247560;
+
+struct ensemble_ode_solver_t
+{
+  int n, num_systems;
+  void* context;
+  ensemble_ode_rhs_func rhs;
+  ensemble_ode_jacobian_func jac;
+  void (*dtor)(void* context);
+
+  real_t rel_tol, abs_tol, max_dt;
+
+  // Batched Newton solver for the stage equations.
+  batched_dense_newton_solver_t* newton;
+
+  // Per-system times, step sizes, and stage data.
+  real_t* t;
+  real_t* h;
+  real_t* h_step;
+  real_t* h_gamma;
+  real_t* t_stage;
+  bool* active;
+  bool* stage1_conv;
+  bool* stage2_conv;
+
+  // SoA work vectors.
+  real_t *C, *Y1, *Y2, *K1, *K2;
+
+  // Diagnostics.
+  ensemble_ode_solver_diagnostics_t diags;
+};
+
+// Stage equations: G(Y) = Y - C - h*gamma*f(t_stage, Y) = 0.
+static int stage_func(void* context, int num_systems, real_t* Y, real_t* G)
+{
+  ensemble_ode_solver_t* solver = context;
+  int status = solver->rhs(solver->context, num_systems, solver->t_stage, Y, G);
+  ++solver->diags.num_rhs_evaluations;
+  if (status != 0)
+    return status;
+  for (int i = 0; i < solver->n; ++i)
+  {
+    real_t* Yi = &Y[i*num_systems];
+    real_t* Gi = &G[i*num_systems];
+    real_t* Ci = &solver->C[i*num_systems];
+    for (int s = 0; s < num_systems; ++s)
+      Gi[s] = Yi[s] - Ci[s] - solver->h_gamma[s] * Gi[s];
+  }
+  return 0;
+}
+
+// Stage Jacobians: dG/dY = I - h*gamma*df/dY.
+static int stage_jac(void* context, int num_systems, real_t* Y, real_t* G, real_t* J)
+{
+  ensemble_ode_solver_t* solver = context;
+  int n = solver->n;
+  int status = solver->jac(solver->context, num_systems, solver->t_stage, Y, J);
+  if (status != 0)
+    return status;
+  for (int c = 0; c < n; ++c)
+  {
+    for (int r = 0; r < n; ++r)
+    {
+      real_t* Jrc = &J[(c*n+r)*num_systems];
+      real_t delta = (r == c) ? 1.0 : 0.0;
+      for (int s = 0; s < num_systems; ++s)
+        Jrc[s] = delta - solver->h_gamma[s] * Jrc[s];
+    }
+  }
+  return 0;
+}
+
+ensemble_ode_solver_t* ensemble_ode_solver_new(int system_size,
+                                               int num_systems,
+                                               void* context,
+                                               ensemble_ode_rhs_func rhs,
+                                               ensemble_ode_jacobian_func jacobian,
+                                               void (*dtor)(void* context))
+{
+  ASSERT(system_size > 0);
+  ASSERT(num_systems > 0);
+  ASSERT(rhs != NULL);
+
+  ensemble_ode_solver_t* solver = polymec_malloc(sizeof(ensemble_ode_solver_t));
+  solver->n = system_size;
+  solver->num_systems = num_systems;
+  solver->context = context;
+  solver->rhs = rhs;
+  solver->jac = jacobian;
+  solver->dtor = dtor;
+  solver->rel_tol = 1e-4;
+  solver->abs_tol = 1e-8;
+  solver->max_dt = REAL_MAX;
+
+  // The Newton solver works on our stage equations, so we pass ourselves as
+  // its context (and don't give it a destructor).
+  solver->newton = batched_dense_newton_solver_new(system_size, num_systems,
+                                                   solver, stage_func,
+                                                   (jacobian != NULL) ? stage_jac : NULL,
+                                                   NULL);
+  batched_dense_newton_solver_set_max_iterations(solver->newton, 10);
+
+  size_t B = (size_t)num_systems, N = (size_t)system_size * B;
+  solver->t = polymec_malloc(sizeof(real_t) * B);
+  solver->h = polymec_malloc(sizeof(real_t) * B);
+  solver->h_step = polymec_malloc(sizeof(real_t) * B);
+  solver->h_gamma = polymec_malloc(sizeof(real_t) * B);
+  solver->t_stage = polymec_malloc(sizeof(real_t) * B);
+  solver->active = polymec_malloc(sizeof(bool) * B);
+  solver->stage1_conv = polymec_malloc(sizeof(bool) * B);
+  solver->stage2_conv = polymec_malloc(sizeof(bool) * B);
+  for (size_t s = 0; s < B; ++s)
+    solver->h[s] = 0.0;
+  solver->C = polymec_malloc(sizeof(real_t) * N);
+  solver->Y1 = polymec_malloc(sizeof(real_t) * N);
+  solver->Y2 = polymec_malloc(sizeof(real_t) * N);
+  solver->K1 = polymec_malloc(sizeof(real_t) * N);
+  solver->K2 = polymec_malloc(sizeof(real_t) * N);
+
+  memset(&solver->diags, 0, sizeof(ensemble_ode_solver_diagnostics_t));
+  ensemble_ode_solver_set_tolerances(solver, solver->rel_tol, solver->abs_tol);
+  return solver;
+}
+
+void ensemble_ode_solver_free(ensemble_ode_solver_t* solver)
+{
+  if ((solver->context != NULL) && (solver->dtor != NULL))
+    solver->dtor(solver->context);
+  batched_dense_newton_solver_free(solver->newton);
+  polymec_free(solver->K2);
+  polymec_free(solver->K1);
+  polymec_free(solver->Y2);
+  polymec_free(solver->Y1);
+  polymec_free(solver->C);
+  polymec_free(solver->stage2_conv);
+  polymec_free(solver->stage1_conv);
+  polymec_free(solver->active);
+  polymec_free(solver->t_stage);
+  polymec_free(solver->h_gamma);
+  polymec_free(solver->h_step);
+  polymec_free(solver->h);
+  polymec_free(solver->t);
+  polymec_free(solver);
+}
+
+int ensemble_ode_solver_system_size(ensemble_ode_solver_t* solver)
+{
+  return solver->n;
+}
+
+int ensemble_ode_solver_num_systems(ensemble_ode_solver_t* solver)
+{
+  return solver->num_systems;
+}
+
+void ensemble_ode_solver_set_tolerances(ensemble_ode_solver_t* solver,
+                                        real_t relative_tol,
+                                        real_t absolute_tol)
+{
+  ASSERT(relative_tol > 0.0);
+  ASSERT(absolute_tol > 0.0);
+  solver->rel_tol = relative_tol;
+  solver->abs_tol = absolute_tol;
+
+  // The stage equations need only be solved a bit more accurately than
+  // the local error we're willing to accept.
+  batched_dense_newton_solver_set_tolerances(solver->newton,
+                                             0.01 * absolute_tol,
+                                             0.01 * relative_tol);
+}
+
+void ensemble_ode_solver_set_max_dt(ensemble_ode_solver_t* solver,
+                                    real_t max_dt)
+{
+  ASSERT(max_dt > 0.0);
+  solver->max_dt = max_dt;
+}
+
+// Solves the stage equations for all systems, starting from the initial
+// guess in Y, and records which systems converged.
+static void solve_stage(ensemble_ode_solver_t* solver, real_t* Y, bool* converged)
+{
+  int num_iters;
+  batched_dense_newton_solver_solve(solver->newton, Y, converged, &num_iters);
+  solver->diags.num_newton_iterations += num_iters;
+}
+
+bool ensemble_ode_solver_advance(ensemble_ode_solver_t* solver,
+                                 real_t t1, real_t t2, real_t* U)
+{
+  ASSERT(t2 > t1);
+  START_FUNCTION_TIMER();
+  int n = solver->n, B = solver->num_systems;
+  real_t gamma = sdirk_gamma;
+
+  // Systems with no step size history start with a small fraction of the
+  // interval.
+  real_t min_dt = 1e-12 * (t2 - t1);
+  for (int s = 0; s < B; ++s)
+  {
+    solver->t[s] = t1;
+    solver->active[s] = true;
+    if (solver->h[s] <= 0.0)
+      solver->h[s] = 1e-3 * (t2 - t1);
+  }
+
+  int num_active = B, num_failed = 0;
+  bool rhs_failed = false;
+  while ((num_active > 0) && !rhs_failed)
+  {
+    ++solver->diags.num_sweeps;
+
+    // Choose step sizes. Inactive systems take zero-length steps, whose
+    // stage equations are satisfied by their initial guesses.
+    real_t* h = solver->h_step;
+    for (int s = 0; s < B; ++s)
+    {
+      if (solver->active[s])
+        h[s] = MIN(solver->h[s], MIN(solver->max_dt, t2 - solver->t[s]));
+      else
+        h[s] = 0.0;
+    }
+
+    // Stage 1: Y1 = U + h*gamma*f(t + gamma*h, Y1).
+    for (int s = 0; s < B; ++s)
+    {
+      solver->h_gamma[s] = gamma * h[s];
+      solver->t_stage[s] = solver->t[s] + gamma * h[s];
+    }
+    memcpy(solver->C, U, sizeof(real_t) * n * B);
+    memcpy(solver->Y1, U, sizeof(real_t) * n * B);
+    solve_stage(solver, solver->Y1, solver->stage1_conv);
+    rhs_failed = (solver->rhs(solver->context, B, solver->t_stage, solver->Y1, solver->K1) != 0);
+    ++solver->diags.num_rhs_evaluations;
+    if (rhs_failed) break;
+
+    // Stage 2: Y2 = U + h*(1-gamma)*k1 + h*gamma*f(t + h, Y2).
+    for (int s = 0; s < B; ++s)
+      solver->t_stage[s] = solver->t[s] + h[s];
+    for (int i = 0; i < n; ++i)
+    {
+      for (int s = 0; s < B; ++s)
+        solver->C[i*B+s] = U[i*B+s] + (1.0 - gamma) * h[s] * solver->K1[i*B+s];
+    }
+    memcpy(solver->Y2, solver->Y1, sizeof(real_t) * n * B);
+    solve_stage(solver, solver->Y2, solver->stage2_conv);
+    rhs_failed = (solver->rhs(solver->context, B, solver->t_stage, solver->Y2, solver->K2) != 0);
+    ++solver->diags.num_rhs_evaluations;
+    if (rhs_failed) break;
+
+    // Accept or reject each system's step and pick its next step size.
+    for (int s = 0; s < B; ++s)
+    {
+      if (!solver->active[s]) continue;
+      if (!solver->stage1_conv[s] || !solver->stage2_conv[s])
+      {
+        ++solver->diags.num_newton_failures;
+        ++solver->diags.num_rejected_steps;
+        solver->h[s] = 0.25 * h[s];
+      }
+      else
+      {
+        // Weighted RMS norm of the local error estimate.
+        real_t err2 = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+          real_t e = gamma * h[s] * (solver->K2[i*B+s] - solver->K1[i*B+s]);
+          real_t w = solver->abs_tol + solver->rel_tol * MAX(ABS(U[i*B+s]), ABS(solver->Y2[i*B+s]));
+          err2 += (e/w) * (e/w);
+        }
+        real_t err = sqrt(err2 / n);
+        if (err <= 1.0)
+        {
+          for (int i = 0; i < n; ++i)
+            U[i*B+s] = solver->Y2[i*B+s];
+          solver->t[s] += h[s];
+          ++solver->diags.num_steps;
+          if ((t2 - solver->t[s]) <= min_dt)
+          {
+            solver->active[s] = false;
+            --num_active;
+          }
+        }
+        else
+          ++solver->diags.num_rejected_steps;
+        real_t factor = 0.9 / sqrt(MAX(err, 1e-10));
+        solver->h[s] = h[s] * MIN(5.0, MAX(0.2, factor));
+      }
+
+      // Give up on systems whose steps have collapsed.
+      if (solver->active[s] && (solver->h[s] < min_dt))
+      {
+        log_debug("ensemble_ode_solver: system %d failed at t = %g.", s, solver->t[s]);
+        solver->active[s] = false;
+        --num_active;
+        ++num_failed;
+      }
+    }
+  }
+
+  if (rhs_failed)
+  {
+    log_debug("ensemble_ode_solver: right hand side evaluation failed.");
+    num_failed = num_active;
+  }
+  solver->diags.num_failed_systems = num_failed;
+  STOP_FUNCTION_TIMER();
+  return (num_failed == 0);
+}
+
+void ensemble_ode_solver_get_diagnostics(ensemble_ode_solver_t* solver,
+                                         ensemble_ode_solver_diagnostics_t* diagnostics)
+{
+  *diagnostics = solver->diags;
+}
+
+void ensemble_ode_solver_diagnostics_fprintf(ensemble_ode_solver_diagnostics_t* diagnostics,
+                                             FILE* stream)
+{
+  if (stream == NULL) return;
+  fprintf(stream, "Ensemble ODE solver diagnostics:\n");
+  fprintf(stream, "  Num sweeps: %d\n", (int)diagnostics->num_sweeps);
+  fprintf(stream, "  Num steps: %d\n", (int)diagnostics->num_steps);
+  fprintf(stream, "  Num rejected steps: %d\n", (int)diagnostics->num_rejected_steps);
+  fprintf(stream, "  Num (batched) RHS evaluations: %d\n", (int)diagnostics->num_rhs_evaluations);
+  fprintf(stream, "  Num (batched) Newton iterations: %d\n", (int)diagnostics->num_newton_iterations);
+  fprintf(stream, "  Num Newton failures: %d\n", (int)diagnostics->num_newton_failures);
+  fprintf(stream, "  Num failed systems: %d\n", diagnostics->num_failed_systems);
+}
+
@@ -0,0 +1,121 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef POLYMEC_ENSEMBLE_ODE_SOLVER_H
+#define POLYMEC_ENSEMBLE_ODE_SOLVER_H
+
+#include "core/polymec.h"
+
+/// \addtogroup solvers solvers
+///@{
+
+/// \class ensemble_ode_solver
+/// This class integrates an ensemble of many independent, identical small
+/// systems of (possibly stiff) ordinary differential equations, such as
+/// the chemical kinetics in each cell of a mesh. All systems are advanced
+/// together in lockstep sweeps, but each system takes its own adaptive
+/// steps. Each sweep attempts one step for every unfinished system using
+/// an L-stable, stiffly-accurate two-stage SDIRK method with an embedded
+/// error estimate, whose stages are solved with a batched dense Newton
+/// solver.
+///
+/// The state of the ensemble is stored in structure-of-arrays (SoA) form:
+/// the ith component of the sth system lives at U[i*num_systems + s].
+typedef struct ensemble_ode_solver_t ensemble_ode_solver_t;
+
+/// This function computes the right hand sides U_dot = f(t, U) for all
+/// num_systems systems at once, with the state U and U_dot stored in SoA
+/// form. Since systems take their own steps, each system s is evaluated
+/// at its own time t[s]. It should return 0 on success and nonzero on
+/// failure.
+/// \relates ensemble_ode_solver
+typedef int (*ensemble_ode_rhs_func)(void* context, int num_systems,
+                                     real_t* t, real_t* U, real_t* U_dot);
+
+/// This function computes the Jacobians J = df/dU of the right hand sides
+/// for all num_systems systems at once. The (r, c) entry of the Jacobian of
+/// the sth system lives at J[(c*N + r)*num_systems + s], where N is the
+/// size of each system. It should return 0 on success and nonzero on
+/// failure.
+/// \relates ensemble_ode_solver
+typedef int (*ensemble_ode_jacobian_func)(void* context, int num_systems,
+                                          real_t* t, real_t* U, real_t* J);
+
+/// Creates a solver for an ensemble of num_systems systems of size
+/// system_size, with the given batched right hand side function and
+/// (optional) batched Jacobian function. If the Jacobian function is NULL,
+/// Jacobians are approximated by finite differences.
+/// \memberof ensemble_ode_solver
+ensemble_ode_solver_t* ensemble_ode_solver_new(int system_size,
+                                               int num_systems,
+                                               void* context,
+                                               ensemble_ode_rhs_func rhs,
+                                               ensemble_ode_jacobian_func jacobian,
+                                               void (*dtor)(void* context));
+
+/// Frees an ensemble ODE solver.
+/// \memberof ensemble_ode_solver
+void ensemble_ode_solver_free(ensemble_ode_solver_t* solver);
+
+/// Returns the size of each system in the ensemble.
+/// \memberof ensemble_ode_solver
+int ensemble_ode_solver_system_size(ensemble_ode_solver_t* solver);
+
+/// Returns the number of systems in the ensemble.
+/// \memberof ensemble_ode_solver
+int ensemble_ode_solver_num_systems(ensemble_ode_solver_t* solver);
+
+/// Sets the relative and absolute tolerances for the local error in each
+/// step. The defaults are 1e-4 and 1e-8.
+/// \memberof ensemble_ode_solver
+void ensemble_ode_solver_set_tolerances(ensemble_ode_solver_t* solver,
+                                        real_t relative_tol,
+                                        real_t absolute_tol);
+
+/// Sets the maximum step size any system may take.
+/// \memberof ensemble_ode_solver
+void ensemble_ode_solver_set_max_dt(ensemble_ode_solver_t* solver,
+                                    real_t max_dt);
+
+/// Integrates all systems in U (stored in SoA form) in place from time t1
+/// to t2. Returns true if every system reached t2, false otherwise, in
+/// which case the systems that failed retain their last successfully
+/// computed states. Each system's step size carries over to subsequent
+/// integrations.
+/// \memberof ensemble_ode_solver
+bool ensemble_ode_solver_advance(ensemble_ode_solver_t* solver,
+                                 real_t t1, real_t t2, real_t* U);
+
+/// \class ensemble_ode_solver_diagnostics
+/// Diagnostics for the ensemble ODE solver, accumulated over all
+/// integrations.
+typedef struct
+{
+  long int num_sweeps;              // number of lockstep sweeps
+  long int num_steps;               // accepted steps, summed over systems
+  long int num_rejected_steps;      // rejected steps, summed over systems
+  long int num_rhs_evaluations;     // batched RHS evaluations
+  long int num_newton_iterations;   // batched Newton iterations
+  long int num_newton_failures;     // stage solve failures, summed over systems
+  int num_failed_systems;           // systems that failed to reach the end
+                                    // of the last integration
+} ensemble_ode_solver_diagnostics_t;
+
+/// Retrieves diagnostics for the ensemble ODE solver.
+/// \memberof ensemble_ode_solver
+void ensemble_ode_solver_get_diagnostics(ensemble_ode_solver_t* solver,
+                                         ensemble_ode_solver_diagnostics_t* diagnostics);
+
+/// Writes ensemble ODE solver diagnostics to the given file.
+/// \memberof ensemble_ode_solver_diagnostics
+void ensemble_ode_solver_diagnostics_fprintf(ensemble_ode_solver_diagnostics_t* diagnostics,
+                                             FILE* stream);
+
+///@}
+
+#endif
+
@@ -23,6 +23,17 @@ struct newton_pc_t
   // Fixed coefficients.
   bool coeffs_fixed;
   real_t alpha0, beta0, gamma0;
+
+  // Reuse policy and state.
+  newton_pc_reuse_policy_t policy;
+  bool have_p;
+  real_t p_alpha, p_beta, p_gamma; // coefficients for which P was computed
+  int num_lagged_setups;
+  real_t max_rate; // largest convergence rate reported since P was computed
+
+  // Diagnostics.
+  long int num_setups, num_computations, num_reuses;
+  real_t computation_time;
 };
 
 newton_pc_t* newton_pc_new(const char* name,
@@ -40,6 +51,16 @@ newton_pc_t* newton_pc_new(const char* name,
   pc->coeffs_fixed = false;
   pc->alpha0 = pc->beta0 = pc->gamma0 = 0.0;
   pc->tolerance = REAL_MAX;
+
+  pc->policy.max_lagged_setups = 0;
+  pc->policy.max_coeff_change = 0.0;
+  pc->policy.max_convergence_rate = 1.0;
+  pc->have_p = false;
+  pc->p_alpha = pc->p_beta = pc->p_gamma = 0.0;
+  pc->num_lagged_setups = 0;
+  pc->max_rate = 0.0;
+  pc->num_setups = pc->num_computations = pc->num_reuses = 0;
+  pc->computation_time = 0.0;
   
   return pc;
 }
@@ -69,6 +90,7 @@ newton_pc_side_t newton_pc_side(newton_pc_t* precond)
 
 void newton_pc_reset(newton_pc_t* precond, real_t t)
 {
+  newton_pc_invalidate(precond);
   if (precond->vtable.reset != NULL)
   {
     START_FUNCTION_TIMER();
@@ -83,29 +105,93 @@ void newton_pc_set_tolerance(newton_pc_t* precond, real_t tolerance)
   precond->tolerance = tolerance;
 }
 
-void newton_pc_setup(newton_pc_t* precond, 
+// Returns true if the coefficient c differs from c0 by more than the given 
+// relative amount.
+static bool coeff_changed(real_t c, real_t c0, real_t max_change)
+{
+  if (reals_equal(c0, 0.0))
+    return !reals_equal(c, 0.0);
+  else
+    return (ABS(c/c0 - 1.0) > max_change);
+}
+
+// Returns true if the given preconditioner can reuse its existing matrix 
+// for the given coefficients.
+static bool can_reuse_p(newton_pc_t* precond, 
+                        real_t alpha, real_t beta, real_t gamma)
+{
+  newton_pc_reuse_policy_t* policy = &precond->policy;
+  if (!precond->have_p || (policy->max_lagged_setups <= 0))
+    return false;
+  if (precond->num_lagged_setups >= policy->max_lagged_setups)
+  {
+    log_debug("newton_pc: recomputing (%d setups lagged).", precond->num_lagged_setups);
+    return false;
+  }
+  if (coeff_changed(alpha, precond->p_alpha, policy->max_coeff_change) ||
+      coeff_changed(beta, precond->p_beta, policy->max_coeff_change) ||
+      coeff_changed(gamma, precond->p_gamma, policy->max_coeff_change))
+  {
+    log_debug("newton_pc: recomputing (coefficients changed).");
+    return false;
+  }
+  if (precond->max_rate > policy->max_convergence_rate)
+  {
+    log_debug("newton_pc: recomputing (convergence rate %g > %g).", 
+              precond->max_rate, policy->max_convergence_rate);
+    return false;
+  }
+  return true;
+}
+
+bool newton_pc_setup(newton_pc_t* precond, 
                      real_t alpha, real_t beta, real_t gamma,
                      real_t t, real_t* x, real_t* xdot)
 {
-  if (precond->vtable.compute_p != NULL)
+  if (precond->vtable.compute_p == NULL)
+    return false;
+
+  START_FUNCTION_TIMER();
+  ++(precond->num_setups);
+  if (precond->coeffs_fixed)
+  {
+    alpha = precond->alpha0;
+    beta = precond->beta0;
+    gamma = precond->gamma0;
+  }
+  else
+  {
+    // Only certain combinations of alpha, beta, and gamma are allowed.
+    ASSERT((reals_equal(alpha, 1.0) && !reals_equal(beta, 0.0) && reals_equal(gamma, 0.0)) || 
+        (reals_equal(alpha, 0.0) && reals_equal(beta, 1.0)));
+  }
+
+  bool computed;
+  if (can_reuse_p(precond, alpha, beta, gamma))
+  {
+    log_debug("newton_pc: reusing preconditioner (%d setups lagged).", 
+              precond->num_lagged_setups + 1);
+    ++(precond->num_lagged_setups);
+    ++(precond->num_reuses);
+    computed = false;
+  }
+  else
   {
-    START_FUNCTION_TIMER();
     log_debug("newton_pc: setting up preconditioner...");
-    if (!precond->coeffs_fixed)
-    {
-      // Only certain combinations of alpha, beta, and gamma are allowed.
-      ASSERT((reals_equal(alpha, 1.0) && !reals_equal(beta, 0.0) && reals_equal(gamma, 0.0)) || 
-          (reals_equal(alpha, 0.0) && reals_equal(beta, 1.0)));
-
-      precond->vtable.compute_p(precond->context, alpha, beta, gamma, t, x, xdot);
-    }
-    else
-    {
-      precond->vtable.compute_p(precond->context, precond->alpha0, 
-                                precond->beta0, precond->gamma0, t, x, xdot);
-    }
-    STOP_FUNCTION_TIMER();
+    real_t t1 = (real_t)MPI_Wtime();
+    precond->vtable.compute_p(precond->context, alpha, beta, gamma, t, x, xdot);
+    precond->computation_time += (real_t)MPI_Wtime() - t1;
+    ++(precond->num_computations);
+    precond->have_p = true;
+    precond->p_alpha = alpha;
+    precond->p_beta = beta;
+    precond->p_gamma = gamma;
+    precond->num_lagged_setups = 0;
+    precond->max_rate = 0.0;
+    computed = true;
   }
+  STOP_FUNCTION_TIMER();
+  return computed;
 }
 
 bool newton_pc_solve(newton_pc_t* precond, 
@@ -123,6 +209,10 @@ bool newton_pc_solve(newton_pc_t* precond,
     else
       log_debug("  newton_pc: failed (error L2 norm = %g)", L2_norm);
   }
+
+  // A failed solve means we shouldn't trust this preconditioner anymore.
+  if (!status)
+    newton_pc_invalidate(precond);
   STOP_FUNCTION_TIMER();
   return status;
 }
@@ -145,3 +235,80 @@ bool newton_pc_coefficients_fixed(newton_pc_t* precond)
   return precond->coeffs_fixed;
 }
 
+
+void newton_pc_set_reuse_policy(newton_pc_t* precond, 
+                                newton_pc_reuse_policy_t policy)
+{
+  ASSERT(policy.max_lagged_setups >= 0);
+  ASSERT(policy.max_coeff_change >= 0.0);
+  ASSERT(policy.max_convergence_rate >= 0.0);
+  precond->policy = policy;
+}
+
+newton_pc_reuse_policy_t newton_pc_reuse_policy(newton_pc_t* precond)
+{
+  return precond->policy;
+}
+
+void newton_pc_report_convergence_rate(newton_pc_t* precond, real_t rate)
+{
+  precond->max_rate = MAX(precond->max_rate, rate);
+}
+
+void newton_pc_invalidate(newton_pc_t* precond)
+{
+  precond->have_p = false;
+}
+
+void newton_pc_use_mixed_precision(newton_pc_t* precond, int max_refinements)
+{
+  if (precond->vtable.use_mixed_precision == NULL)
+  {
+    polymec_error("newton_pc_use_mixed_precision: %s does not support mixed "
+                  "precision.", precond->name);
+  }
+  if (max_refinements < 0)
+  {
+    polymec_error("newton_pc_use_mixed_precision: max_refinements must be "
+                  "non-negative (got %d).", max_refinements);
+  }
+  precond->vtable.use_mixed_precision(precond->context, max_refinements);
+
+  // The existing preconditioner (if any) was computed in full precision.
+  newton_pc_invalidate(precond);
+}
+
+bool newton_pc_supports_mixed_precision(newton_pc_t* precond)
+{
+  return (precond->vtable.use_mixed_precision != NULL);
+}
+
+void newton_pc_get_diagnostics(newton_pc_t* precond,
+                               newton_pc_diagnostics_t* diagnostics)
+{
+  diagnostics->num_setups = precond->num_setups;
+  diagnostics->num_computations = precond->num_computations;
+  diagnostics->num_reuses = precond->num_reuses;
+  diagnostics->computation_time = precond->computation_time;
+
+  // We estimate the time saved using the average time for computing P.
+  if (precond->num_computations > 0)
+  {
+    real_t avg_time = precond->computation_time / precond->num_computations;
+    diagnostics->time_saved = avg_time * precond->num_reuses;
+  }
+  else
+    diagnostics->time_saved = 0.0;
+}
+
+void newton_pc_diagnostics_fprintf(newton_pc_diagnostics_t* diagnostics, 
+                                   FILE* stream)
+{
+  if (stream == NULL) return;
+  fprintf(stream, "Preconditioner diagnostics:\n");
+  fprintf(stream, "  Num setups: %d\n", (int)diagnostics->num_setups);
+  fprintf(stream, "  Num computations: %d\n", (int)diagnostics->num_computations);
+  fprintf(stream, "  Num reuses: %d\n", (int)diagnostics->num_reuses);
+  fprintf(stream, "  Computation time: %g s\n", diagnostics->computation_time);
+  fprintf(stream, "  Estimated time saved by reuse: %g s\n", diagnostics->time_saved);
+}
@@ -44,6 +44,12 @@ typedef struct
                 real_t t, real_t* x, real_t* xdot, real_t tolerance,
                 real_t* r, real_t* z, real_t* error_L2_norm);
 
+  /// Method to store the preconditioner operator in single precision, 
+  /// refining each solve in full precision at most max_refinements times
+  /// (optional). Preconditioners that don't implement this method can't
+  /// be used with newton_pc_use_mixed_precision.
+  void (*use_mixed_precision)(void* context, int max_refinements);
+
   /// Destructor.
   void (*dtor)(void* context);
 } newton_pc_vtable;
@@ -100,9 +106,12 @@ void newton_pc_set_tolerance(newton_pc_t* precond, real_t tolerance);
 /// point (t, x, xdot) in solution space, computing 
 /// alpha * I + beta * dF/dx + gamma * dF/d(xdot) 
 /// for the given alpha, beta, and gamma. Note that xdot should be NULL if F
-/// is only a function of x.
+/// is only a function of x. If the preconditioner's reuse policy allows it, 
+/// a previously computed preconditioner is reused instead.
+/// \returns true if the preconditioner matrix was (re)computed, false if a 
+///          previously computed matrix was reused.
 /// \memberof newton_pc
-void newton_pc_setup(newton_pc_t* precond, 
+bool newton_pc_setup(newton_pc_t* precond, 
                      real_t alpha, real_t beta, real_t gamma,
                      real_t t, real_t* x, real_t* xdot);
 
@@ -135,6 +144,85 @@ void newton_pc_unfix_coefficients(newton_pc_t* precond);
 /// \memberof newton_pc
 bool newton_pc_coefficients_fixed(newton_pc_t* precond);
 
+/// \struct newton_pc_reuse_policy
+/// This type describes the conditions under which a preconditioner computed 
+/// in one call to newton_pc_setup may be reused in subsequent calls instead 
+/// of being recomputed. A preconditioner is recomputed whenever any of these
+/// conditions is violated, and whenever a solve with it fails.
+typedef struct
+{
+  /// The maximum number of consecutive setups that may reuse a previously 
+  /// computed preconditioner. 0 disables reuse (the default).
+  int max_lagged_setups;
+
+  /// The maximum relative change in each of the coefficients alpha, beta, 
+  /// gamma since the preconditioner was last computed for which it may 
+  /// still be reused. Time integrators express changes in their time step
+  /// through these coefficients.
+  real_t max_coeff_change;
+
+  /// The maximum nonlinear convergence rate (as given to 
+  /// newton_pc_report_convergence_rate) for which the preconditioner may be 
+  /// reused. Rates near 1 indicate stalled convergence.
+  real_t max_convergence_rate;
+} newton_pc_reuse_policy_t;
+
+/// Sets the policy that governs the reuse of the preconditioner between 
+/// setups.
+/// \memberof newton_pc
+void newton_pc_set_reuse_policy(newton_pc_t* precond, 
+                                newton_pc_reuse_policy_t policy);
+
+/// Returns the policy that governs the reuse of the preconditioner between 
+/// setups.
+/// \memberof newton_pc
+newton_pc_reuse_policy_t newton_pc_reuse_policy(newton_pc_t* precond);
+
+/// Informs the preconditioner of the most recent convergence rate estimate 
+/// for the nonlinear iteration it serves, so that its reuse policy can 
+/// account for it at the next setup.
+/// \memberof newton_pc
+void newton_pc_report_convergence_rate(newton_pc_t* precond, real_t rate);
+
+/// Marks the preconditioner as stale, forcing it to be recomputed at the next
+/// setup regardless of the reuse policy.
+/// \memberof newton_pc
+void newton_pc_invalidate(newton_pc_t* precond);
+
+/// Instructs the preconditioner to store its operator in single precision, 
+/// applying at most max_refinements steps of iterative refinement in full 
+/// precision to each solve. The preconditioner is recomputed at its next 
+/// setup. It is an error to call this on a preconditioner whose vtable has 
+/// no use_mixed_precision method.
+/// \memberof newton_pc
+void newton_pc_use_mixed_precision(newton_pc_t* precond, int max_refinements);
+
+/// Returns true if the preconditioner supports newton_pc_use_mixed_precision,
+/// false if not.
+/// \memberof newton_pc
+bool newton_pc_supports_mixed_precision(newton_pc_t* precond);
+
+/// \class newton_pc_diagnostics
+/// Diagnostics describing the setup (and reuse) history of a preconditioner.
+typedef struct
+{
+  long int num_setups;       // number of calls to newton_pc_setup.
+  long int num_computations; // number of times P was actually computed.
+  long int num_reuses;       // number of setups that reused an existing P.
+  real_t computation_time;   // total wall time spent computing P.
+  real_t time_saved;         // estimated wall time saved by reusing P.
+} newton_pc_diagnostics_t;
+
+/// Retrieves diagnostics for the given preconditioner.
+/// \memberof newton_pc
+void newton_pc_get_diagnostics(newton_pc_t* precond,
+                               newton_pc_diagnostics_t* diagnostics);
+
+/// Writes preconditioner diagnostics to the given file.
+/// \memberof newton_pc_diagnostics
+void newton_pc_diagnostics_fprintf(newton_pc_diagnostics_t* diagnostics, 
+                                   FILE* stream);
+
 ///@}
 
 #endif
@@ -33,6 +33,7 @@ struct newton_solver_t
   int (*Jv_func)(void* context, bool new_U, real_t t, real_t* U, real_t* v, real_t* Jv);
   jfnk_newton_t solver_type;
   newton_pc_t* precond;
+  real_t pc_F_norm; // scaled norm of F at the last preconditioner setup
   int max_krylov_dim, max_restarts;
 
   // Generized adaptor stuff.
@@ -92,6 +93,16 @@ static int set_up_preconditioner(N_Vector U, N_Vector U_scale,
 {
   newton_solver_t* solver = context;
   real_t t = solver->t;
+
+  // Estimate the convergence rate of the Newton iteration since the last 
+  // setup using the reduction in the scaled norm of F, so the preconditioner 
+  // can decide whether it can be reused.
+  real_t F_norm;
+  KINGetFuncNorm(solver->kinsol, &F_norm);
+  if (solver->pc_F_norm > 0.0)
+    newton_pc_report_convergence_rate(solver->precond, F_norm / solver->pc_F_norm);
+  solver->pc_F_norm = F_norm;
+
   newton_pc_setup(solver->precond, 0.0, 1.0, 0.0, t, NV_DATA(U), NULL);
 
   return 0;
@@ -213,6 +224,7 @@ static newton_solver_t* create_newton_solver(MPI_Comm comm,
   solver->solve_func = NULL;
   solver->dtor = dtor;
   solver->precond = NULL;
+  solver->pc_F_norm = 0.0;
   solver->num_local_values = num_local_values;
   solver->num_remote_values = num_remote_values;
   solver->max_krylov_dim = -1;
@@ -706,6 +718,7 @@ void newton_solver_reset(newton_solver_t* solver, real_t t)
   // Reset the preconditioner if it exists.
   if (solver->precond != NULL)
     newton_pc_reset(solver->precond, t);
+  solver->pc_F_norm = 0.0;
 }
 
 void newton_solver_get_diagnostics(newton_solver_t* solver, 
@@ -0,0 +1,366 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "core/timer.h"
+#include "solvers/parareal_ode_solver.h"
+
+typedef struct
+{
+  MPI_Comm comm;
+  int rank, nprocs;
+
+  ode_solver_t* coarse;
+  ode_solver_t* fine;
+  int N; // solution vector size
+
+  int num_slices, num_local_slices, first_slice;
+  parareal_relaxation_t relaxation;
+  int max_iters;
+  real_t tolerance;
+
+  // Solutions at the starts of our local slices (plus the end of the last
+  // one), and the fine and coarse solutions at the ends of our local slices.
+  real_t* U;
+  real_t* F;
+  real_t* G;
+  real_t* G_new;
+
+  // Diagnostics for the last integration.
+  int num_iters;
+  real_t rel_change, wall_time, serial_time;
+} parareal_t;
+
+static inline real_t* slice_vector(parareal_t* pr, real_t* vecs, int s)
+{
+  return &vecs[s * pr->N];
+}
+
+// Integrates U_in from t1 to t2 using the given solver, storing the result
+// in U_out.
+static bool propagate(parareal_t* pr, ode_solver_t* solver,
+                      real_t t1, real_t t2, real_t* U_in, real_t* U_out)
+{
+  memcpy(U_out, U_in, sizeof(real_t) * pr->N);
+  ode_solver_reset(solver, t1, U_out);
+  return ode_solver_advance(solver, t1, t2, U_out);
+}
+
+// Returns true on all processes if all processes have succeeded, false
+// otherwise.
+static bool all_succeeded(parareal_t* pr, bool success)
+{
+  int local_success = (success) ? 1 : 0, global_success;
+  MPI_Allreduce(&local_success, &global_success, 1, MPI_INT, MPI_LAND, pr->comm);
+  return (global_success != 0);
+}
+
+// Applies the fine solver to all of our local slices, accumulating the
+// time it takes.
+static bool fine_sweep(parareal_t* pr, real_t t1, real_t dT, real_t* fine_time)
+{
+  START_FUNCTION_TIMER();
+  real_t t0 = MPI_Wtime();
+  int first_slice = pr->first_slice;
+  bool success = true;
+  for (int s = 0; s < pr->num_local_slices; ++s)
+  {
+    real_t ts = t1 + (first_slice + s) * dT;
+    success = propagate(pr, pr->fine, ts, ts + dT,
+                        slice_vector(pr, pr->U, s),
+                        slice_vector(pr, pr->F, s));
+    if (!success) break;
+  }
+  *fine_time += MPI_Wtime() - t0;
+  STOP_FUNCTION_TIMER();
+  return all_succeeded(pr, success);
+}
+
+// Replaces the solution at the start of each slice with the fine solution
+// from the end of the preceding slice (C-relaxation). The initial value at
+// the start of the first slice is left alone.
+static void c_relax(parareal_t* pr)
+{
+  int m = pr->num_local_slices;
+  for (int s = m-1; s > 0; --s)
+    memcpy(slice_vector(pr, pr->U, s), slice_vector(pr, pr->F, s-1), sizeof(real_t) * pr->N);
+
+  MPI_Request requests[2];
+  int num_requests = 0;
+  if (pr->rank > 0)
+    MPI_Irecv(slice_vector(pr, pr->U, 0), pr->N, MPI_REAL_T, pr->rank-1, 0, pr->comm, &requests[num_requests++]);
+  if (pr->rank < (pr->nprocs-1))
+    MPI_Isend(slice_vector(pr, pr->F, m-1), pr->N, MPI_REAL_T, pr->rank+1, 0, pr->comm, &requests[num_requests++]);
+  MPI_Status statuses[2];
+  MPI_Waitall(num_requests, requests, statuses);
+}
+
+// Applies the coarse solver to all of our local slices independently, so
+// that the coarse correction after C-relaxation is computed relative to
+// the relaxed solutions.
+static bool coarse_relax(parareal_t* pr, real_t t1, real_t dT)
+{
+  int first_slice = pr->first_slice;
+  bool success = true;
+  for (int s = 0; s < pr->num_local_slices; ++s)
+  {
+    real_t ts = t1 + (first_slice + s) * dT;
+    success = propagate(pr, pr->coarse, ts, ts + dT,
+                        slice_vector(pr, pr->U, s),
+                        slice_vector(pr, pr->G, s));
+    if (!success) break;
+  }
+  return all_succeeded(pr, success);
+}
+
+// Propagates the solution serially through all slices with the coarse
+// solver, applying the Parareal correction U(s+1) = G_new(s) + F(s) - G(s)
+// unless this is the initial sweep (in which U(s+1) = G_new(s)). The
+// maximum relative change in the solution at the end of any slice is
+// stored in rel_change.
+static bool coarse_sweep(parareal_t* pr, real_t t1, real_t dT, bool initial,
+                         real_t* rel_change)
+{
+  START_FUNCTION_TIMER();
+  int N = pr->N, m = pr->num_local_slices;
+  int first_slice = pr->first_slice;
+
+  // Get the starting solution from the preceding process.
+  if (pr->rank > 0)
+    MPI_Recv(slice_vector(pr, pr->U, 0), N, MPI_REAL_T, pr->rank-1, 0, pr->comm, MPI_STATUS_IGNORE);
+
+  // Even if we fail, we pass data along so that the pipeline doesn't stall.
+  bool success = true;
+  real_t max_change = 0.0;
+  for (int s = 0; s < m; ++s)
+  {
+    real_t ts = t1 + (first_slice + s) * dT;
+    real_t* Us = slice_vector(pr, pr->U, s);
+    real_t* Us1 = slice_vector(pr, pr->U, s+1);
+    real_t* Fs = slice_vector(pr, pr->F, s);
+    real_t* Gs = slice_vector(pr, pr->G, s);
+    if (success)
+      success = propagate(pr, pr->coarse, ts, ts + dT, Us, pr->G_new);
+    if (success)
+    {
+      if (initial)
+        memcpy(Us1, pr->G_new, sizeof(real_t) * N);
+      else
+      {
+        real_t diff2 = 0.0, norm2 = 0.0;
+        for (int i = 0; i < N; ++i)
+        {
+          real_t Ui = pr->G_new[i] + Fs[i] - Gs[i];
+          diff2 += (Ui - Us1[i]) * (Ui - Us1[i]);
+          norm2 += Ui * Ui;
+          Us1[i] = Ui;
+        }
+        real_t change = (norm2 > 0.0) ? sqrt(diff2 / norm2) : sqrt(diff2);
+        max_change = MAX(max_change, change);
+      }
+      memcpy(Gs, pr->G_new, sizeof(real_t) * N);
+    }
+  }
+
+  // Pass our final solution to the next process.
+  if (pr->rank < (pr->nprocs-1))
+    MPI_Send(slice_vector(pr, pr->U, m), N, MPI_REAL_T, pr->rank+1, 0, pr->comm);
+
+  MPI_Allreduce(&max_change, rel_change, 1, MPI_REAL_T, MPI_MAX, pr->comm);
+  STOP_FUNCTION_TIMER();
+  return all_succeeded(pr, success);
+}
+
+static bool parareal_advance(void* context, real_t t1, real_t t2, real_t* U)
+{
+  START_FUNCTION_TIMER();
+  parareal_t* pr = context;
+  real_t wall_t0 = MPI_Wtime();
+  real_t dT = (t2 - t1) / pr->num_slices;
+  int m = pr->num_local_slices;
+
+  // Everyone starts from the given initial value, though only the first
+  // process actually uses it.
+  memcpy(slice_vector(pr, pr->U, 0), U, sizeof(real_t) * pr->N);
+
+  // Initial coarse propagation.
+  real_t fine_time = 0.0;
+  pr->num_iters = 0;
+  pr->rel_change = REAL_MAX;
+  bool success = coarse_sweep(pr, t1, dT, true, &pr->rel_change);
+
+  while (success && (pr->num_iters < pr->max_iters))
+  {
+    // Relaxation.
+    success = fine_sweep(pr, t1, dT, &fine_time);
+    if (success && (pr->relaxation == PARAREAL_FCF_RELAXATION))
+    {
+      c_relax(pr);
+      success = fine_sweep(pr, t1, dT, &fine_time);
+      if (success)
+        success = coarse_relax(pr, t1, dT);
+    }
+    if (!success) break;
+
+    // The serial cost of the fine solver is that of a single sweep.
+    if (pr->num_iters == 0)
+    {
+      MPI_Allreduce(&fine_time, &pr->serial_time, 1, MPI_REAL_T, MPI_SUM, pr->comm);
+      if (pr->relaxation == PARAREAL_FCF_RELAXATION)
+        pr->serial_time *= 0.5;
+    }
+
+    // Coarse correction.
+    success = coarse_sweep(pr, t1, dT, false, &pr->rel_change);
+    ++pr->num_iters;
+    log_debug("parareal_ode_solver: iteration %d: relative change = %g",
+              pr->num_iters, pr->rel_change);
+
+    // After k iterations, the first k slices are exact, so we're finished
+    // after num_slices iterations no matter what.
+    if ((pr->rel_change < pr->tolerance) || (pr->num_iters >= pr->num_slices))
+      break;
+  }
+
+  // Broadcast the solution at t2 from the last process.
+  if (success)
+  {
+    real_t* U2 = slice_vector(pr, pr->U, m);
+    MPI_Bcast(U2, pr->N, MPI_REAL_T, pr->nprocs-1, pr->comm);
+    memcpy(U, U2, sizeof(real_t) * pr->N);
+  }
+  else
+    log_debug("parareal_ode_solver: integration failed.");
+
+  real_t wall_time = MPI_Wtime() - wall_t0;
+  MPI_Allreduce(&wall_time, &pr->wall_time, 1, MPI_REAL_T, MPI_MAX, pr->comm);
+  STOP_FUNCTION_TIMER();
+  return success;
+}
+
+static bool parareal_step(void* context, real_t max_dt, real_t* t, real_t* U)
+{
+  bool success = parareal_advance(context, *t, *t + max_dt, U);
+  if (success)
+    *t += max_dt;
+  return success;
+}
+
+static void parareal_dtor(void* context)
+{
+  parareal_t* pr = context;
+  polymec_free(pr->G_new);
+  polymec_free(pr->G);
+  polymec_free(pr->F);
+  polymec_free(pr->U);
+  ode_solver_free(pr->fine);
+  ode_solver_free(pr->coarse);
+  polymec_free(pr);
+}
+
+ode_solver_t* parareal_ode_solver_new(MPI_Comm time_comm,
+                                      ode_solver_t* coarse_solver,
+                                      ode_solver_t* fine_solver,
+                                      int num_time_slices)
+{
+  ASSERT(coarse_solver != NULL);
+  ASSERT(fine_solver != NULL);
+  ASSERT(ode_solver_solution_vector_size(coarse_solver) ==
+         ode_solver_solution_vector_size(fine_solver));
+  ASSERT(num_time_slices > 0);
+
+  parareal_t* pr = polymec_malloc(sizeof(parareal_t));
+  pr->comm = time_comm;
+  MPI_Comm_rank(time_comm, &pr->rank);
+  MPI_Comm_size(time_comm, &pr->nprocs);
+  if (num_time_slices < pr->nprocs)
+  {
+    polymec_error("parareal_ode_solver_new: num_time_slices (%d) must be at "
+                  "least the number of processes in time_comm (%d).",
+                  num_time_slices, pr->nprocs);
+  }
+
+  pr->coarse = coarse_solver;
+  pr->fine = fine_solver;
+  pr->N = ode_solver_solution_vector_size(fine_solver);
+  pr->num_slices = num_time_slices;
+
+  // Slices are distributed as evenly as possible, with the first 
+  // num_time_slices % nprocs processes getting one extra.
+  int q = num_time_slices / pr->nprocs, rem = num_time_slices % pr->nprocs;
+  pr->num_local_slices = (pr->rank < rem) ? q + 1 : q;
+  pr->first_slice = pr->rank * q + MIN(pr->rank, rem);
+  pr->relaxation = PARAREAL_F_RELAXATION;
+  pr->max_iters = num_time_slices;
+  pr->tolerance = 1e-6;
+
+  int m = pr->num_local_slices;
+  pr->U = polymec_malloc(sizeof(real_t) * (m+1) * pr->N);
+  pr->F = polymec_malloc(sizeof(real_t) * m * pr->N);
+  pr->G = polymec_malloc(sizeof(real_t) * m * pr->N);
+  pr->G_new = polymec_malloc(sizeof(real_t) * pr->N);
+
+  pr->num_iters = 0;
+  pr->rel_change = 0.0;
+  pr->wall_time = 0.0;
+  pr->serial_time = 0.0;
+
+  char name[1024];
+  snprintf(name, 1023, "Parareal (%s)", ode_solver_name(fine_solver));
+  ode_solver_vtable vtable = {.step = parareal_step,
+                              .advance = parareal_advance,
+                              .dtor = parareal_dtor};
+  return ode_solver_new(name, pr, vtable, ode_solver_order(fine_solver), pr->N);
+}
+
+void parareal_ode_solver_set_relaxation(ode_solver_t* solver,
+                                        parareal_relaxation_t relaxation)
+{
+  parareal_t* pr = ode_solver_context(solver);
+  pr->relaxation = relaxation;
+}
+
+void parareal_ode_solver_set_max_iterations(ode_solver_t* solver,
+                                            int max_iters)
+{
+  ASSERT(max_iters > 0);
+  parareal_t* pr = ode_solver_context(solver);
+  pr->max_iters = max_iters;
+}
+
+void parareal_ode_solver_set_tolerance(ode_solver_t* solver,
+                                       real_t tolerance)
+{
+  ASSERT(tolerance >= 0.0);
+  parareal_t* pr = ode_solver_context(solver);
+  pr->tolerance = tolerance;
+}
+
+void parareal_ode_solver_get_diagnostics(ode_solver_t* solver,
+                                         parareal_ode_solver_diagnostics_t* diagnostics)
+{
+  parareal_t* pr = ode_solver_context(solver);
+  diagnostics->num_time_slices = pr->num_slices;
+  diagnostics->num_iterations = pr->num_iters;
+  diagnostics->relative_change = pr->rel_change;
+  diagnostics->wall_time = pr->wall_time;
+  diagnostics->serial_time_estimate = pr->serial_time;
+  diagnostics->speedup = (pr->wall_time > 0.0) ? pr->serial_time / pr->wall_time : 0.0;
+}
+
+void parareal_ode_solver_diagnostics_fprintf(parareal_ode_solver_diagnostics_t* diagnostics,
+                                             FILE* stream)
+{
+  if (stream == NULL) return;
+  fprintf(stream, "Parareal ODE solver diagnostics:\n");
+  fprintf(stream, "  Num time slices: %d\n", diagnostics->num_time_slices);
+  fprintf(stream, "  Num iterations: %d\n", diagnostics->num_iterations);
+  fprintf(stream, "  Relative change over last iteration: %g\n", diagnostics->relative_change);
+  fprintf(stream, "  Wall time: %g s\n", diagnostics->wall_time);
+  fprintf(stream, "  Estimated serial (fine) time: %g s\n", diagnostics->serial_time_estimate);
+  fprintf(stream, "  Speedup over serial time stepping: %g\n", diagnostics->speedup);
+}
+
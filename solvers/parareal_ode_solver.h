@@ -0,0 +1,105 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef POLYMEC_PARAREAL_ODE_SOLVER_H
+#define POLYMEC_PARAREAL_ODE_SOLVER_H
+
+#include "solvers/ode_solver.h"
+
+// The Parareal ODE solver integrates a system of ODEs in parallel in time
+// by dividing each integration interval into time slices that are
+// distributed over the processes of a "time" communicator. A cheap coarse
+// solver propagates corrections serially across the slices, while an
+// accurate fine solver integrates all slices concurrently. The iteration
+// converges to the solution computed by the fine solver alone.
+
+/// \addtogroup solvers solvers
+///@{
+
+/// \enum parareal_relaxation_t
+/// The relaxation applied to the fine solution within each Parareal
+/// iteration.
+typedef enum
+{
+  /// F-relaxation: the fine solver is applied once per iteration to every
+  /// slice. This is classic Parareal, which is equivalent to two-level
+  /// MGRIT with F-relaxation.
+  PARAREAL_F_RELAXATION,
+  /// FCF-relaxation: two-level MGRIT with FCF-relaxation, in which each
+  /// slice's fine solution is propagated to the start of the next slice
+  /// (C-relaxation) and the fine solver is applied again before the coarse
+  /// correction. This doubles the fine work per iteration, but typically
+  /// reduces the number of iterations substantially.
+  PARAREAL_FCF_RELAXATION
+} parareal_relaxation_t;
+
+/// Creates an ODE solver that integrates in parallel in time using the
+/// Parareal algorithm with the given coarse and fine solvers, which must
+/// have the same solution vector size. Each call to ode_solver_advance
+/// (or ode_solver_step) divides its time interval into num_time_slices
+/// slices of equal length, distributed as evenly as possible over the 
+/// processes in time_comm. num_time_slices must be at least the number of 
+/// these processes. Every process in time_comm holds the entire solution vector,
+/// so the coarse and fine solvers should be defined on a (spatial)
+/// communicator that is disjoint from time_comm, such as MPI_COMM_SELF. The
+/// Parareal solver assumes control of the coarse and fine solvers.
+/// \relates ode_solver
+ode_solver_t* parareal_ode_solver_new(MPI_Comm time_comm,
+                                      ode_solver_t* coarse_solver,
+                                      ode_solver_t* fine_solver,
+                                      int num_time_slices);
+
+/// Sets the relaxation used by the Parareal solver. By default,
+/// PARAREAL_F_RELAXATION is used.
+/// \relates ode_solver
+void parareal_ode_solver_set_relaxation(ode_solver_t* solver,
+                                        parareal_relaxation_t relaxation);
+
+/// Sets the maximum number of Parareal iterations for each call to
+/// ode_solver_advance. Parareal converges to the fine solution in at most
+/// num_time_slices iterations, which is the default.
+/// \relates ode_solver
+void parareal_ode_solver_set_max_iterations(ode_solver_t* solver,
+                                            int max_iters);
+
+/// Sets the tolerance for the relative L2 norm of the change in the
+/// solution at the ends of the time slices over a single Parareal
+/// iteration, below which the iteration is considered converged. The
+/// default is 1e-6.
+/// \relates ode_solver
+void parareal_ode_solver_set_tolerance(ode_solver_t* solver,
+                                       real_t tolerance);
+
+/// \class parareal_ode_solver_diagnostics
+/// Diagnostics for the most recent integration of the Parareal solver.
+typedef struct
+{
+  int num_time_slices;
+  int num_iterations;
+  real_t relative_change;      // relative change over the last iteration.
+  real_t wall_time;            // wall time spent integrating.
+  real_t serial_time_estimate; // estimated wall time for the fine solver alone.
+  real_t speedup;              // serial_time_estimate / wall_time
+} parareal_ode_solver_diagnostics_t;
+
+/// Retrieves diagnostics for the most recent integration of the Parareal
+/// solver. The serial time estimate is the total time spent by the fine
+/// solver on all slices during the first iteration, which is the time a
+/// serial integration with the fine solver would take.
+/// \relates ode_solver
+void parareal_ode_solver_get_diagnostics(ode_solver_t* solver,
+                                         parareal_ode_solver_diagnostics_t* diagnostics);
+
+/// Writes Parareal solver diagnostics to the given file.
+/// \memberof parareal_ode_solver_diagnostics
+void parareal_ode_solver_diagnostics_fprintf(parareal_ode_solver_diagnostics_t* diagnostics,
+                                             FILE* stream);
+
+///@}
+
+#endif
+
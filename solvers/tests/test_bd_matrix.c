@@ -0,0 +1,208 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "core/rng.h"
+#include "solvers/bd_matrix.h"
+
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+static const real_t tolerance = 1e-10;
+#else
+static const real_t tolerance = 1e-4;
+#endif
+
+// Creates a diagonally-dominant-ish block diagonal matrix with random blocks.
+// Half of the blocks have a zero in their (0, 0) entry to exercise pivoting.
+static bd_matrix_t* random_bd_matrix(rng_t* rng, size_t num_block_rows, size_t block_size)
+{
+  bd_matrix_t* A = bd_matrix_new(num_block_rows, block_size);
+  for (int i = 0; i < (int)num_block_rows; ++i)
+  {
+    real_t* Ai = bd_matrix_block(A, i);
+    for (size_t j = 0; j < block_size*block_size; ++j)
+      Ai[j] = rng_uniform(rng) - 0.5;
+    for (size_t j = 0; j < block_size; ++j)
+      Ai[block_size*j+j] += 1.0 * block_size;
+    if (((i % 2) == 1) && (block_size > 1))
+      Ai[0] = 0.0;
+  }
+  return A;
+}
+
+static void check_solves(rng_t* rng, size_t num_block_rows, size_t block_size)
+{
+  bd_matrix_t* A = random_bd_matrix(rng, num_block_rows, block_size);
+  size_t N = bd_matrix_num_rows(A);
+  real_t B[N], X[N], AX[N];
+  for (size_t i = 0; i < N; ++i)
+    B[i] = rng_uniform(rng);
+
+  // Solve without a stored factorization.
+  assert_true(solve_bd_system(A, B, X));
+  bd_matrix_matvec(A, X, AX);
+  for (size_t i = 0; i < N; ++i)
+    assert_true(reals_nearly_equal(AX[i], B[i], tolerance));
+
+  // Solve with a stored factorization (twice, to make sure it's reusable).
+  assert_true(bd_matrix_factor(A));
+  assert_true(bd_matrix_is_factored(A));
+  for (int k = 0; k < 2; ++k)
+  {
+    memset(X, 0, sizeof(real_t) * N);
+    solve_factored_bd_system(A, B, X);
+    bd_matrix_matvec(A, X, AX);
+    for (size_t i = 0; i < N; ++i)
+      assert_true(reals_nearly_equal(AX[i], B[i], tolerance));
+  }
+
+  // Solve in place.
+  memcpy(X, B, sizeof(real_t) * N);
+  solve_factored_bd_system(A, X, X);
+  bd_matrix_matvec(A, X, AX);
+  for (size_t i = 0; i < N; ++i)
+    assert_true(reals_nearly_equal(AX[i], B[i], tolerance));
+
+  bd_matrix_free(A);
+}
+
+static void test_bd_matrix_solves(void** state)
+{
+  rng_t* rng = host_rng_new();
+
+  // These block sizes cover both the batched kernels (1-8) and the general 
+  // path, and the block counts include partially-filled batches.
+  for (size_t bs = 1; bs <= 10; ++bs)
+  {
+    check_solves(rng, 1, bs);
+    check_solves(rng, 8, bs);
+    check_solves(rng, 29, bs);
+  }
+}
+
+static void test_var_bd_matrix_solves(void** state)
+{
+  rng_t* rng = host_rng_new();
+  size_t block_sizes[] = {1, 3, 2, 5, 4};
+  bd_matrix_t* A = var_bd_matrix_new(5, block_sizes);
+  for (int i = 0; i < 5; ++i)
+  {
+    size_t bs = block_sizes[i];
+    real_t* Ai = bd_matrix_block(A, i);
+    for (size_t j = 0; j < bs*bs; ++j)
+      Ai[j] = rng_uniform(rng) - 0.5;
+    for (size_t j = 0; j < bs; ++j)
+      Ai[bs*j+j] += 1.0 * bs;
+  }
+  size_t N = bd_matrix_num_rows(A);
+  assert_int_equal(15, N);
+  real_t B[N], X[N], AX[N];
+  for (size_t i = 0; i < N; ++i)
+    B[i] = rng_uniform(rng);
+  assert_true(bd_matrix_factor(A));
+  solve_factored_bd_system(A, B, X);
+  bd_matrix_matvec(A, X, AX);
+  for (size_t i = 0; i < N; ++i)
+    assert_true(reals_nearly_equal(AX[i], B[i], tolerance));
+  bd_matrix_free(A);
+}
+
+// Measures the max norm of the residual B - A*X.
+static real_t residual_norm(bd_matrix_t* A, real_t* B, real_t* X)
+{
+  size_t N = bd_matrix_num_rows(A);
+  real_t AX[N];
+  bd_matrix_matvec(A, X, AX);
+  real_t norm = 0.0;
+  for (size_t i = 0; i < N; ++i)
+    norm = MAX(norm, ABS(B[i] - AX[i]));
+  return norm;
+}
+
+static void check_float_factored_solves(rng_t* rng, bd_matrix_t* A)
+{
+  size_t N = bd_matrix_num_rows(A);
+  real_t B[N], X[N], R[N], AX[N];
+  for (size_t i = 0; i < N; ++i)
+    B[i] = rng_uniform(rng);
+
+  // Single precision factors give single precision solutions.
+  bd_matrix_set_factor_precision(A, BD_MATRIX_FACTOR_FLOAT);
+  assert_true(bd_matrix_factor_precision(A) == BD_MATRIX_FACTOR_FLOAT);
+  assert_true(bd_matrix_factor(A));
+  solve_factored_bd_system(A, B, X);
+  real_t norm0 = residual_norm(A, B, X);
+  assert_true(norm0 < 1e-3);
+
+  // A few steps of iterative refinement recover full precision.
+  for (int k = 0; k < 5; ++k)
+  {
+    bd_matrix_matvec(A, X, AX);
+    for (size_t i = 0; i < N; ++i)
+      R[i] = B[i] - AX[i];
+    solve_factored_bd_system(A, R, R);
+    for (size_t i = 0; i < N; ++i)
+      X[i] += R[i];
+  }
+  assert_true(residual_norm(A, B, X) < tolerance);
+
+  // Switching back discards the factorization.
+  bd_matrix_set_factor_precision(A, BD_MATRIX_FACTOR_REAL);
+  assert_false(bd_matrix_is_factored(A));
+}
+
+static void test_float_factored_bd_matrix_solves(void** state)
+{
+  rng_t* rng = host_rng_new();
+  for (size_t bs = 1; bs <= 10; ++bs)
+  {
+    bd_matrix_t* A = random_bd_matrix(rng, 29, bs);
+    check_float_factored_solves(rng, A);
+    bd_matrix_free(A);
+  }
+
+  size_t block_sizes[] = {1, 3, 2, 5, 4};
+  bd_matrix_t* A = var_bd_matrix_new(5, block_sizes);
+  for (int i = 0; i < 5; ++i)
+  {
+    size_t bs = block_sizes[i];
+    real_t* Ai = bd_matrix_block(A, i);
+    for (size_t j = 0; j < bs*bs; ++j)
+      Ai[j] = rng_uniform(rng) - 0.5;
+    for (size_t j = 0; j < bs; ++j)
+      Ai[bs*j+j] += 1.0 * bs;
+  }
+  check_float_factored_solves(rng, A);
+  bd_matrix_free(A);
+}
+
+static void test_singular_bd_matrix(void** state)
+{
+  bd_matrix_t* A = bd_matrix_new(3, 2);
+  bd_matrix_add_identity(A, 1.0);
+  real_t* A1 = bd_matrix_block(A, 1);
+  A1[0] = A1[1] = A1[2] = A1[3] = 1.0; // rank 1
+  assert_false(bd_matrix_factor(A));
+  assert_false(bd_matrix_is_factored(A));
+  bd_matrix_free(A);
+}
+
+int main(int argc, char* argv[]) 
+{
+  polymec_init(argc, argv);
+  const struct CMUnitTest tests[] = 
+  {
+    cmocka_unit_test(test_bd_matrix_solves),
+    cmocka_unit_test(test_var_bd_matrix_solves),
+    cmocka_unit_test(test_float_factored_bd_matrix_solves),
+    cmocka_unit_test(test_singular_bd_matrix)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
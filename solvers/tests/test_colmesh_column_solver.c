@@ -0,0 +1,182 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "geometry/create_quad_planar_polymesh.h"
+#include "solvers/colmesh_column_solver.h"
+
+static int _nproc = -1;
+static int _rank = -1;
+
+// Creates a colmesh with the given numbers of chunks, distributed over the
+// processes in comm.
+static colmesh_t* create_mesh(MPI_Comm comm,
+                              int num_z_chunks,
+                              int nz_per_chunk,
+                              bool periodic_in_z)
+{
+  bbox_t bbox = {.x1 = 0.0, .x2 = 1.0, .y1 = 0.0, .y2 = 1.0, .z1 = 0.0, .z2 = 1.0};
+  planar_polymesh_t* columns = create_quad_planar_polymesh(10, 10, &bbox, false, false);
+  int nproc;
+  MPI_Comm_size(comm, &nproc);
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  colmesh_t* mesh = create_empty_colmesh(comm, columns, bbox.z1, bbox.z2,
+                                         2, num_z_chunks, nz_per_chunk,
+                                         periodic_in_z);
+  for (int XY = 0; XY < 2; ++XY)
+    for (int Z = 0; Z < num_z_chunks; ++Z)
+      if (((num_z_chunks * XY + Z) % nproc) == rank)
+        colmesh_insert_chunk(mesh, XY, Z);
+  colmesh_finalize(mesh);
+  planar_polymesh_free(columns);
+  return mesh;
+}
+
+// Coefficients and solution for the cell in the given column (identified by
+// its xy chunk index and its index within the chunk) at the (1-based) global
+// z index zg.
+static real_t lower_coeff(int XY, int xy, int zg)
+{
+  return -1.0 - 0.01 * xy;
+}
+
+static real_t upper_coeff(int XY, int xy, int zg)
+{
+  return -1.0 - 0.1 * XY - 0.02 * (xy % 7);
+}
+
+static real_t diag_coeff(int XY, int xy, int zg)
+{
+  return 4.0 + 0.01 * zg;
+}
+
+static real_t exact_solution(int XY, int xy, int zg)
+{
+  return 1.0 + XY + 0.01 * xy + sin(0.3 * zg);
+}
+
+static void test_column_solve(void** state, MPI_Comm comm,
+                              int num_z_chunks, int nz_per_chunk,
+                              bool periodic_in_z)
+{
+  colmesh_t* mesh = create_mesh(comm, num_z_chunks, nz_per_chunk, periodic_in_z);
+  int Nz = num_z_chunks * nz_per_chunk;
+
+  colmesh_field_t* lower = colmesh_field_new(mesh, COLMESH_CELL, 1);
+  colmesh_field_t* diag = colmesh_field_new(mesh, COLMESH_CELL, 1);
+  colmesh_field_t* upper = colmesh_field_new(mesh, COLMESH_CELL, 1);
+  colmesh_field_t* rhs = colmesh_field_new(mesh, COLMESH_CELL, 1);
+  colmesh_field_t* x = colmesh_field_new(mesh, COLMESH_CELL, 1);
+
+  // Set up the systems so that we know their solutions. The lower and
+  // upper coefficients at the ends of each column are nonzero, and should
+  // be ignored.
+  int pos = 0, XY, Z;
+  colmesh_chunk_t* chunk;
+  while (colmesh_next_chunk(mesh, &pos, &XY, &Z, &chunk))
+  {
+    colmesh_chunk_data_t* a_data = colmesh_field_chunk_data(lower, XY, Z);
+    colmesh_chunk_data_t* b_data = colmesh_field_chunk_data(diag, XY, Z);
+    colmesh_chunk_data_t* c_data = colmesh_field_chunk_data(upper, XY, Z);
+    colmesh_chunk_data_t* d_data = colmesh_field_chunk_data(rhs, XY, Z);
+    DECLARE_COLMESH_CELL_ARRAY(a, a_data);
+    DECLARE_COLMESH_CELL_ARRAY(b, b_data);
+    DECLARE_COLMESH_CELL_ARRAY(c, c_data);
+    DECLARE_COLMESH_CELL_ARRAY(d, d_data);
+    for (int xy = 0; xy < chunk->num_columns; ++xy)
+    {
+      for (int z = 1; z <= chunk->num_z_cells; ++z)
+      {
+        int zg = Z * nz_per_chunk + z;
+        a[xy][z][0] = lower_coeff(XY, xy, zg);
+        b[xy][z][0] = diag_coeff(XY, xy, zg);
+        c[xy][z][0] = upper_coeff(XY, xy, zg);
+        d[xy][z][0] = b[xy][z][0] * exact_solution(XY, xy, zg);
+        if (zg > 1)
+          d[xy][z][0] += a[xy][z][0] * exact_solution(XY, xy, zg-1);
+        if (zg < Nz)
+          d[xy][z][0] += c[xy][z][0] * exact_solution(XY, xy, zg+1);
+      }
+    }
+  }
+
+  // Solve the systems and check the solution.
+  colmesh_column_solver_t* solver = colmesh_column_solver_new(mesh);
+  colmesh_column_solver_solve(solver, lower, diag, upper, rhs, x);
+  pos = 0;
+  while (colmesh_next_chunk(mesh, &pos, &XY, &Z, &chunk))
+  {
+    colmesh_chunk_data_t* x_data = colmesh_field_chunk_data(x, XY, Z);
+    DECLARE_COLMESH_CELL_ARRAY(X, x_data);
+    for (int xy = 0; xy < chunk->num_columns; ++xy)
+    {
+      for (int z = 1; z <= chunk->num_z_cells; ++z)
+      {
+        int zg = Z * nz_per_chunk + z;
+        assert_true(reals_nearly_equal(X[xy][z][0], exact_solution(XY, xy, zg), 1e-12));
+      }
+    }
+  }
+
+  // Solving in place gives the same answer.
+  colmesh_column_solver_solve(solver, lower, diag, upper, rhs, rhs);
+  pos = 0;
+  while (colmesh_next_chunk(mesh, &pos, &XY, &Z, &chunk))
+  {
+    colmesh_chunk_data_t* x_data = colmesh_field_chunk_data(x, XY, Z);
+    colmesh_chunk_data_t* d_data = colmesh_field_chunk_data(rhs, XY, Z);
+    DECLARE_COLMESH_CELL_ARRAY(X, x_data);
+    DECLARE_COLMESH_CELL_ARRAY(d, d_data);
+    for (int xy = 0; xy < chunk->num_columns; ++xy)
+      for (int z = 1; z <= chunk->num_z_cells; ++z)
+        assert_true(reals_equal(X[xy][z][0], d[xy][z][0]));
+  }
+
+  colmesh_column_solver_free(solver);
+  colmesh_field_free(x);
+  colmesh_field_free(rhs);
+  colmesh_field_free(upper);
+  colmesh_field_free(diag);
+  colmesh_field_free(lower);
+  colmesh_free(mesh);
+}
+
+static void test_serial_column_solve(void** state)
+{
+  if (_rank == 0)
+  {
+    test_column_solve(state, MPI_COMM_SELF, 1, 20, false);
+    test_column_solve(state, MPI_COMM_SELF, 4, 5, false);
+    test_column_solve(state, MPI_COMM_SELF, 3, 1, false);
+    test_column_solve(state, MPI_COMM_SELF, 4, 5, true);
+  }
+}
+
+static void test_parallel_column_solve(void** state)
+{
+  test_column_solve(state, MPI_COMM_WORLD, 4, 5, false);
+  test_column_solve(state, MPI_COMM_WORLD, 2, 1, false);
+  test_column_solve(state, MPI_COMM_WORLD, 4, 5, true);
+}
+
+int main(int argc, char* argv[])
+{
+  polymec_init(argc, argv);
+  MPI_Comm_size(MPI_COMM_WORLD, &_nproc);
+  MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test(test_serial_column_solve),
+    cmocka_unit_test(test_parallel_column_solve)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -161,6 +161,119 @@ static void test_newton_solve_system_3_with_jacobian(void** state)
   assert_true((x[0]-1.0)*(x[0]-1.0) + (x[1]-1.0)*(x[1]-1.0) + (x[2]-1.0)*(x[2]-1.0) < 1e-3);
 }
 
+// A batch of circle_2 systems with different centers: system s is zero at 
+// (1 + s, 1 + s).
+static int batched_circle_2(void* context, int num_systems, real_t* x, real_t* F)
+{
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t X = x[s], Y = x[num_systems+s], c = 1.0 + s;
+    F[s] = (X - c)*(X - c) + (Y - c)*(Y - c);
+    F[num_systems+s] = X - Y;
+  }
+  return 0;
+}
+
+static int batched_circle_2_jac(void* context, int num_systems, real_t* x, 
+                                real_t* F, real_t* J)
+{
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t X = x[s], Y = x[num_systems+s], c = 1.0 + s;
+    J[s] = 2.0*(X-c);              // Jxx
+    J[num_systems+s] = 1.0;        // Jyx
+    J[2*num_systems+s] = 2.0*(Y-c); // Jxy
+    J[3*num_systems+s] = -1.0;     // Jyy
+  }
+  return 0;
+}
+
+static void test_batched_newton_solve(bool with_jacobian)
+{
+  int num_systems = 37;
+  batched_dense_newton_solver_t* solver = 
+    batched_dense_newton_solver_new(2, num_systems, NULL, batched_circle_2, 
+                                    (with_jacobian) ? batched_circle_2_jac : NULL,
+                                    NULL);
+  assert_int_equal(2, batched_dense_newton_solver_dimension(solver));
+  assert_int_equal(num_systems, batched_dense_newton_solver_num_systems(solver));
+  batched_dense_newton_solver_set_tolerances(solver, 1e-6, 1e-4);
+  real_t x[2*num_systems];
+  for (int s = 0; s < num_systems; ++s)
+  {
+    x[s] = 3.0 + s;
+    x[num_systems+s] = -2.0 + s;
+  }
+  bool converged[num_systems];
+  int num_iters;
+  assert_true(batched_dense_newton_solver_solve(solver, x, converged, &num_iters));
+  batched_dense_newton_solver_free(solver);
+
+  for (int s = 0; s < num_systems; ++s)
+  {
+    assert_true(converged[s]);
+    real_t c = 1.0 + s;
+    assert_true((x[s]-c)*(x[s]-c) + (x[num_systems+s]-c)*(x[num_systems+s]-c) < 1e-3);
+  }
+}
+
+static void test_batched_newton_solve_system_2(void** state)
+{
+  test_batched_newton_solve(false);
+}
+
+static void test_batched_newton_solve_system_2_with_jacobian(void** state)
+{
+  test_batched_newton_solve(true);
+}
+
+static void test_batched_newton_solve_partly_converged(bool with_jacobian)
+{
+  // Every third system starts at its solution, and the others start at 
+  // different distances from theirs, so systems drop out of the batch at 
+  // different iterations. Systems that have converged are left untouched.
+  int num_systems = 37;
+  batched_dense_newton_solver_t* solver = 
+    batched_dense_newton_solver_new(2, num_systems, NULL, batched_circle_2, 
+                                    (with_jacobian) ? batched_circle_2_jac : NULL,
+                                    NULL);
+  batched_dense_newton_solver_set_tolerances(solver, 1e-6, 1e-4);
+  real_t x[2*num_systems];
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t c = 1.0 + s;
+    x[s] = c + 0.5 * (s % 3) * (s % 5);
+    x[num_systems+s] = c - 0.25 * (s % 3);
+  }
+  bool converged[num_systems];
+  int num_iters;
+  assert_true(batched_dense_newton_solver_solve(solver, x, converged, &num_iters));
+  batched_dense_newton_solver_free(solver);
+
+  for (int s = 0; s < num_systems; ++s)
+  {
+    assert_true(converged[s]);
+    real_t c = 1.0 + s;
+    if ((s % 3) == 0)
+    {
+      assert_true(reals_equal(x[s], c));
+      assert_true(reals_equal(x[num_systems+s], c));
+    }
+    else
+      assert_true((x[s]-c)*(x[s]-c) + (x[num_systems+s]-c)*(x[num_systems+s]-c) < 1e-3);
+  }
+}
+
+static void test_batched_newton_solve_partly_converged_system_2(void** state)
+{
+  test_batched_newton_solve_partly_converged(false);
+}
+
+static void test_batched_newton_solve_partly_converged_system_2_with_jacobian(void** state)
+{
+  test_batched_newton_solve_partly_converged(true);
+}
+
 int main(int argc, char* argv[]) 
 {
   polymec_init(argc, argv);
@@ -172,7 +285,11 @@ int main(int argc, char* argv[])
     cmocka_unit_test(test_newton_solve_system_2),
     cmocka_unit_test(test_newton_solve_system_2_with_jacobian),
     cmocka_unit_test(test_newton_solve_system_3),
-    cmocka_unit_test(test_newton_solve_system_3_with_jacobian)
+    cmocka_unit_test(test_newton_solve_system_3_with_jacobian),
+    cmocka_unit_test(test_batched_newton_solve_system_2),
+    cmocka_unit_test(test_batched_newton_solve_system_2_with_jacobian),
+    cmocka_unit_test(test_batched_newton_solve_partly_converged_system_2),
+    cmocka_unit_test(test_batched_newton_solve_partly_converged_system_2_with_jacobian)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -0,0 +1,148 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "solvers/ensemble_ode_solver.h"
+
+// Our first ensemble consists of linear decay chains 
+//   y0' = -k*y0, y1' = k*y0 - y1
+// with a different rate k for each system, many of which are stiff. With 
+// y0(0) = 1 and y1(0) = 0, the solution is y0 = exp(-k*t), 
+// y1 = k/(1-k) * (exp(-k*t) - exp(-t)).
+static real_t decay_rate(int s)
+{
+  return 0.1 * pow(1.3, s) + 0.05;
+}
+
+static int decay_rhs(void* context, int num_systems, real_t* t, real_t* U, real_t* U_dot)
+{
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t k = decay_rate(s);
+    U_dot[s] = -k * U[s];
+    U_dot[num_systems+s] = k * U[s] - U[num_systems+s];
+  }
+  return 0;
+}
+
+static int decay_jac(void* context, int num_systems, real_t* t, real_t* U, real_t* J)
+{
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t k = decay_rate(s);
+    J[s] = -k;                // J00
+    J[num_systems+s] = k;     // J10
+    J[2*num_systems+s] = 0.0; // J01
+    J[3*num_systems+s] = -1.0;// J11
+  }
+  return 0;
+}
+
+static void test_decay_ensemble(bool with_jacobian)
+{
+  int num_systems = 40;
+  ensemble_ode_solver_t* solver = 
+    ensemble_ode_solver_new(2, num_systems, NULL, decay_rhs, 
+                            (with_jacobian) ? decay_jac : NULL, NULL);
+  assert_int_equal(2, ensemble_ode_solver_system_size(solver));
+  assert_int_equal(num_systems, ensemble_ode_solver_num_systems(solver));
+  ensemble_ode_solver_set_tolerances(solver, 1e-5, 1e-8);
+
+  real_t U[2*num_systems];
+  for (int s = 0; s < num_systems; ++s)
+  {
+    U[s] = 1.0;
+    U[num_systems+s] = 0.0;
+  }
+
+  // Integrate in two pieces to exercise step size carryover.
+  assert_true(ensemble_ode_solver_advance(solver, 0.0, 0.5, U));
+  assert_true(ensemble_ode_solver_advance(solver, 0.5, 2.0, U));
+
+  ensemble_ode_solver_diagnostics_t diags;
+  ensemble_ode_solver_get_diagnostics(solver, &diags);
+  ensemble_ode_solver_diagnostics_fprintf(&diags, stdout);
+  assert_int_equal(0, diags.num_failed_systems);
+  assert_true(diags.num_steps > 0);
+
+  real_t t = 2.0;
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t k = decay_rate(s);
+    real_t y0 = exp(-k*t);
+    real_t y1 = k/(1.0-k) * (exp(-k*t) - exp(-t));
+    assert_true(ABS(U[s] - y0) < 1e-4);
+    assert_true(ABS(U[num_systems+s] - y1) < 1e-4);
+  }
+  ensemble_ode_solver_free(solver);
+}
+
+static void test_decay_ensemble_with_fd_jacobian(void** state)
+{
+  test_decay_ensemble(false);
+}
+
+static void test_decay_ensemble_with_jacobian(void** state)
+{
+  test_decay_ensemble(true);
+}
+
+// Our second ensemble is Robertson's stiff chemical kinetics problem, with 
+// a range of rate constants for the fast reaction. Total mass is conserved.
+static int robertson_rhs(void* context, int num_systems, real_t* t, real_t* U, real_t* U_dot)
+{
+  int B = num_systems;
+  for (int s = 0; s < B; ++s)
+  {
+    real_t k3 = 3e7 * (1.0 + 0.1 * s);
+    real_t y1 = U[s], y2 = U[B+s], y3 = U[2*B+s];
+    U_dot[s] = -0.04*y1 + 1e4*y2*y3;
+    U_dot[B+s] = 0.04*y1 - 1e4*y2*y3 - k3*y2*y2;
+    U_dot[2*B+s] = k3*y2*y2;
+  }
+  return 0;
+}
+
+static void test_robertson_ensemble(void** state)
+{
+  int num_systems = 16;
+  ensemble_ode_solver_t* solver = 
+    ensemble_ode_solver_new(3, num_systems, NULL, robertson_rhs, NULL, NULL);
+  ensemble_ode_solver_set_tolerances(solver, 1e-4, 1e-10);
+  real_t U[3*num_systems];
+  for (int s = 0; s < num_systems; ++s)
+  {
+    U[s] = 1.0;
+    U[num_systems+s] = 0.0;
+    U[2*num_systems+s] = 0.0;
+  }
+  assert_true(ensemble_ode_solver_advance(solver, 0.0, 40.0, U));
+  for (int s = 0; s < num_systems; ++s)
+  {
+    real_t mass = U[s] + U[num_systems+s] + U[2*num_systems+s];
+    assert_true(ABS(mass - 1.0) < 1e-6);
+    // At t = 40, y1 is about 0.7158 for the standard problem.
+    assert_true((U[s] > 0.6) && (U[s] < 0.8));
+  }
+  ensemble_ode_solver_free(solver);
+}
+
+int main(int argc, char* argv[]) 
+{
+  polymec_init(argc, argv);
+  const struct CMUnitTest tests[] = 
+  {
+    cmocka_unit_test(test_decay_ensemble_with_fd_jacobian),
+    cmocka_unit_test(test_decay_ensemble_with_jacobian),
+    cmocka_unit_test(test_robertson_ensemble)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
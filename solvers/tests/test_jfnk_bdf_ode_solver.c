@@ -13,6 +13,7 @@
 #include "cmocka.h"
 #include "core/polymec.h"
 #include "solvers/bdf_ode_solver.h"
+#include "solvers/bj_newton_pc.h"
 
 extern ode_solver_t* bj_jfnk_bdf_diurnal_solver_new(newton_pc_side_t side);
 extern real_t* diurnal_initial_conditions(ode_solver_t* integ);
@@ -50,6 +51,128 @@ static void test_bj_jfnk_bdf_diurnal_step_right(void** state)
   test_diurnal_step(state, integ, max_steps);
 }
 
+// Integrates the diurnal problem to t = 86400 s with the given solver and
+// retrieves the diagnostics for its preconditioner.
+static void integrate_diurnal(ode_solver_t* integ, int max_steps,
+                              newton_pc_diagnostics_t* pc_diags)
+{
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  bdf_ode_solver_set_tolerances(integ, 1e-5, 1e-3);
+#else
+  bdf_ode_solver_set_tolerances(integ, 1e-4, 1e-2);
+#endif
+  real_t* U = diurnal_initial_conditions(integ);
+  real_t t = 0.0;
+  int step = 0;
+  while ((t < 86400.0) && (step < max_steps))
+  {
+    assert_true(ode_solver_step(integ, 7200.0, &t, U));
+    ++step;
+  }
+  assert_true(step < max_steps);
+  newton_pc_get_diagnostics(bdf_ode_solver_preconditioner(integ), pc_diags);
+  polymec_free(U);
+}
+
+static void test_bj_jfnk_bdf_diurnal_step_with_pc_reuse(void** state)
+{
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  int max_steps = 700;
+#else
+  int max_steps = 500;
+#endif
+
+  // Without a reuse policy, every setup computes the preconditioner.
+  ode_solver_t* integ = bj_jfnk_bdf_diurnal_solver_new(NEWTON_PC_LEFT);
+  newton_pc_diagnostics_t no_reuse;
+  integrate_diurnal(integ, max_steps, &no_reuse);
+  assert_int_equal(0, no_reuse.num_reuses);
+  assert_int_equal(no_reuse.num_setups, no_reuse.num_computations);
+  ode_solver_free(integ);
+
+  // With one, some setups reuse it, and we compute it less often.
+  integ = bj_jfnk_bdf_diurnal_solver_new(NEWTON_PC_LEFT);
+  newton_pc_reuse_policy_t policy = {.max_lagged_setups = 5,
+                                     .max_coeff_change = 0.5,
+                                     .max_convergence_rate = 0.9};
+  bdf_ode_solver_set_pc_reuse_policy(integ, policy);
+  newton_pc_diagnostics_t reuse;
+  integrate_diurnal(integ, max_steps, &reuse);
+  assert_true(reuse.num_reuses > 0);
+  assert_int_equal(reuse.num_setups, reuse.num_computations + reuse.num_reuses);
+  assert_true(reuse.num_computations < no_reuse.num_computations);
+
+  bdf_ode_solver_diagnostics_t diags;
+  bdf_ode_solver_get_diagnostics(integ, &diags);
+  assert_int_equal(reuse.num_reuses, diags.num_preconditioner_reuses);
+  ode_solver_free(integ);
+}
+
+// Diagonally dominant 3x3 blocks for a block Jacobi preconditioner.
+static void mp_diag_block(void* context, int i, 
+                          real_t alpha, real_t beta, real_t gamma,
+                          real_t t, real_t* x, real_t* x_dot, real_t* block)
+{
+  for (int c = 0; c < 3; ++c)
+    for (int r = 0; r < 3; ++r)
+      block[3*c+r] = (r == c) ? 4.0 + 0.1*i : 1.0 / (1.0 + r + 2*c + i);
+}
+
+static void test_bj_newton_pc_mixed_precision(void** state)
+{
+  int N = 3 * 20;
+  newton_pc_t* pc = bj_newton_pc_new(NULL, mp_diag_block, NULL, 
+                                     NEWTON_PC_LEFT, 20, 3);
+  assert_true(newton_pc_supports_mixed_precision(pc));
+  real_t r[N], z[N], z0[N], x[N];
+  for (int i = 0; i < N; ++i)
+  {
+    r[i] = 1.0 + 0.01*i;
+    x[i] = 0.0;
+  }
+
+  // Full precision solution.
+  newton_pc_set_tolerance(pc, 1e-12);
+  newton_pc_setup(pc, 0.0, 1.0, 0.0, 0.0, x, NULL);
+  assert_true(newton_pc_solve(pc, 0.0, x, NULL, r, z0));
+
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  // Without refinement, single precision factors can't meet a tight 
+  // tolerance, which shows that they're actually used.
+  newton_pc_use_mixed_precision(pc, 0);
+  newton_pc_setup(pc, 0.0, 1.0, 0.0, 0.0, x, NULL);
+  assert_false(newton_pc_solve(pc, 0.0, x, NULL, r, z));
+#endif
+
+  // A few refinement steps meet it. Residuals are computed with the full 
+  // precision matrix, so the solution agrees with the full precision one 
+  // to nearly full precision.
+  newton_pc_use_mixed_precision(pc, 4);
+  newton_pc_setup(pc, 0.0, 1.0, 0.0, 0.0, x, NULL);
+  assert_true(newton_pc_solve(pc, 0.0, x, NULL, r, z));
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  for (int i = 0; i < N; ++i)
+    assert_true(ABS(z[i] - z0[i]) < 1e-12 * ABS(z0[i]));
+#else
+  for (int i = 0; i < N; ++i)
+    assert_true(ABS(z[i] - z0[i]) < 1e-5 * ABS(z0[i]));
+#endif
+
+  newton_pc_free(pc);
+}
+
+static void test_bj_jfnk_bdf_diurnal_step_mixed_precision(void** state)
+{
+  ode_solver_t* integ = bj_jfnk_bdf_diurnal_solver_new(NEWTON_PC_LEFT);
+  bj_newton_pc_use_mixed_precision(bdf_ode_solver_preconditioner(integ), 2);
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  int max_steps = 700;
+#else
+  int max_steps = 500;
+#endif
+  test_diurnal_step(state, integ, max_steps);
+}
+
 int main(int argc, char* argv[]) 
 {
   polymec_init(argc, argv);
@@ -57,7 +180,10 @@ int main(int argc, char* argv[])
   {
     cmocka_unit_test(test_bj_jfnk_bdf_diurnal_ctor),
     cmocka_unit_test(test_bj_jfnk_bdf_diurnal_step_left),
-    cmocka_unit_test(test_bj_jfnk_bdf_diurnal_step_right)
+    cmocka_unit_test(test_bj_jfnk_bdf_diurnal_step_right),
+    cmocka_unit_test(test_bj_jfnk_bdf_diurnal_step_with_pc_reuse),
+    cmocka_unit_test(test_bj_newton_pc_mixed_precision),
+    cmocka_unit_test(test_bj_jfnk_bdf_diurnal_step_mixed_precision)
   };
   return cmocka_run_group_tests(tests, NULL, NULL);
 }
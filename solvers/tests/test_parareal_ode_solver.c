@@ -0,0 +1,166 @@
+// Copyright (c) 2012-2019, Jeffrey N. Johnson
+// All rights reserved.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include "cmocka.h"
+#include "core/polymec.h"
+#include "solvers/parareal_ode_solver.h"
+
+// We test the Parareal solver on a damped harmonic oscillator, using
+// fixed-step forward Euler as a coarse solver and fixed-step RK4 as a fine
+// one.
+typedef struct
+{
+  bool rk4;
+  int steps_per_unit_time;
+} fixed_step_t;
+
+static void oscillator_rhs(real_t t, real_t* X, real_t* Xdot)
+{
+  Xdot[0] = X[1];
+  Xdot[1] = -X[0] - 0.25 * X[1];
+}
+
+static bool fixed_step(void* context, real_t max_dt, real_t* t, real_t* X)
+{
+  fixed_step_t* fs = context;
+  real_t dt = MIN(max_dt, 1.0 / fs->steps_per_unit_time);
+  real_t k1[2], k2[2], k3[2], k4[2], Y[2];
+  oscillator_rhs(*t, X, k1);
+  if (fs->rk4)
+  {
+    for (int i = 0; i < 2; ++i) Y[i] = X[i] + 0.5 * dt * k1[i];
+    oscillator_rhs(*t + 0.5 * dt, Y, k2);
+    for (int i = 0; i < 2; ++i) Y[i] = X[i] + 0.5 * dt * k2[i];
+    oscillator_rhs(*t + 0.5 * dt, Y, k3);
+    for (int i = 0; i < 2; ++i) Y[i] = X[i] + dt * k3[i];
+    oscillator_rhs(*t + dt, Y, k4);
+    for (int i = 0; i < 2; ++i)
+      X[i] += dt * (k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i]) / 6.0;
+  }
+  else
+  {
+    for (int i = 0; i < 2; ++i)
+      X[i] += dt * k1[i];
+  }
+  *t += dt;
+  return true;
+}
+
+static bool fixed_advance(void* context, real_t t1, real_t t2, real_t* X)
+{
+  real_t t = t1;
+  while (t2 - t > 1e-12)
+    fixed_step(context, t2 - t, &t, X);
+  return true;
+}
+
+static ode_solver_t* fixed_step_solver_new(bool rk4, int steps_per_unit_time)
+{
+  fixed_step_t* fs = polymec_malloc(sizeof(fixed_step_t));
+  fs->rk4 = rk4;
+  fs->steps_per_unit_time = steps_per_unit_time;
+  ode_solver_vtable vtable = {.step = fixed_step,
+                              .advance = fixed_advance,
+                              .dtor = polymec_free};
+  return ode_solver_new((rk4) ? "RK4" : "Forward Euler", fs, vtable,
+                        (rk4) ? 4 : 1, 2);
+}
+
+static const int num_slices = 16;
+static const real_t t_final = 8.0;
+
+static void fine_solution(real_t* X)
+{
+  ode_solver_t* fine = fixed_step_solver_new(true, 100);
+  X[0] = 1.0; X[1] = 0.0;
+  ode_solver_advance(fine, 0.0, t_final, X);
+  ode_solver_free(fine);
+}
+
+static ode_solver_t* parareal_solver_new(parareal_relaxation_t relaxation)
+{
+  ode_solver_t* coarse = fixed_step_solver_new(false, 4);
+  ode_solver_t* fine = fixed_step_solver_new(true, 100);
+  ode_solver_t* solver = parareal_ode_solver_new(MPI_COMM_WORLD, coarse, fine,
+                                                 num_slices);
+  parareal_ode_solver_set_relaxation(solver, relaxation);
+  return solver;
+}
+
+static int run_parareal(ode_solver_t* solver, real_t tolerance)
+{
+  real_t X_fine[2];
+  fine_solution(X_fine);
+
+  real_t X[2] = {1.0, 0.0};
+  assert_true(ode_solver_advance(solver, 0.0, t_final, X));
+  parareal_ode_solver_diagnostics_t diags;
+  parareal_ode_solver_get_diagnostics(solver, &diags);
+  assert_int_equal(num_slices, diags.num_time_slices);
+  assert_true(diags.num_iterations <= num_slices);
+
+  // Unless Parareal ran out of iterations, it stopped because it converged.
+  if (diags.num_iterations < num_slices)
+    assert_true(diags.relative_change < 1e-6);
+
+  // The converged solution matches the serial fine solution.
+  real_t err = sqrt((X[0]-X_fine[0])*(X[0]-X_fine[0]) +
+                    (X[1]-X_fine[1])*(X[1]-X_fine[1]));
+  assert_true(err < tolerance);
+  return diags.num_iterations;
+}
+
+static void test_parareal_f_relaxation(void** state)
+{
+  ode_solver_t* solver = parareal_solver_new(PARAREAL_F_RELAXATION);
+  int num_iters = run_parareal(solver, 1e-5);
+  assert_true(num_iters < num_slices);
+  ode_solver_free(solver);
+}
+
+static void test_parareal_fcf_relaxation(void** state)
+{
+  ode_solver_t* solver = parareal_solver_new(PARAREAL_F_RELAXATION);
+  int num_f_iters = run_parareal(solver, 1e-5);
+  ode_solver_free(solver);
+
+  solver = parareal_solver_new(PARAREAL_FCF_RELAXATION);
+  int num_fcf_iters = run_parareal(solver, 1e-5);
+  assert_true(num_fcf_iters <= num_f_iters);
+  ode_solver_free(solver);
+}
+
+static void test_parareal_exactness(void** state)
+{
+  // With a vanishing tolerance, Parareal takes num_slices iterations and
+  // reproduces the fine solution.
+  ode_solver_t* solver = parareal_solver_new(PARAREAL_F_RELAXATION);
+  parareal_ode_solver_set_tolerance(solver, 0.0);
+#if POLYMEC_HAVE_DOUBLE_PRECISION
+  int num_iters = run_parareal(solver, 1e-12);
+#else
+  int num_iters = run_parareal(solver, 1e-5);
+#endif
+  assert_int_equal(num_slices, num_iters);
+  ode_solver_free(solver);
+}
+
+int main(int argc, char* argv[])
+{
+  polymec_init(argc, argv);
+  const struct CMUnitTest tests[] =
+  {
+    cmocka_unit_test(test_parareal_f_relaxation),
+    cmocka_unit_test(test_parareal_fcf_relaxation),
+    cmocka_unit_test(test_parareal_exactness)
+  };
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}